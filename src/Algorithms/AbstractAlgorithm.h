@@ -26,6 +26,7 @@
 #include "CaretAssert.h"
 #include "OperationParameters.h"
 #include "AbstractOperation.h"
+#include "CaretProfiler.h"
 
 namespace caret {
 
@@ -34,13 +35,17 @@ namespace caret {
     {
         ProgressObject* m_progObj;//so that the destructor can make sure the bar finishes
         bool m_finish;
+        CaretProfiler::Scope m_profileScope;//member rather than in the constructor body, so it lasts until the derived object is destroyed
         AbstractAlgorithm();//prevent default construction
+        void initialize(ProgressObject* myProgressObject);
     protected:
         ///override this with the weights of the algorithms this algorithm will call
         static float getSubAlgorithmWeight();//protected so that people don't try to use them to set algorithm weights in progress objects
         ///override this with the amount of work the algorithm does internally, outside of calls to other algorithms
         static float getAlgorithmInternalWeight();
         AbstractAlgorithm(ProgressObject* myProgressObject);
+        ///profileName is what wb_command -profile reports this algorithm as, normally getCommandSwitch()
+        AbstractAlgorithm(ProgressObject* myProgressObject, const AString& profileName);
         virtual ~AbstractAlgorithm();
     public:
         ///use this to set the weight parameter of a ProgressObject
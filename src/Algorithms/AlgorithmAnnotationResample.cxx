@@ -143,7 +143,7 @@ AlgorithmAnnotationResample::AlgorithmAnnotationResample(ProgressObject* myProgO
                                                          const AString& annotationFileName,
                                                          const std::vector<const SurfaceFile*>& sourceSurfaces,
                                                          const std::vector<const SurfaceFile*>& targetSurfaces)
-   : AbstractAlgorithm(myProgObj)
+   : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     /*
      * Sets the algorithm up to use the progress object, and will 
@@ -0,0 +1,227 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AlgorithmCiftiAverageDenseCorrelation.h"
+#include "AlgorithmException.h"
+
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "CaretOMP.h"
+#include "CiftiFile.h"
+#include "SeedCorrelationEngine.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int64_t B_BLOCK = 1024;//rows of each subject read and normalized at a time, also the width of a tile
+    const float DEFAULT_MEM_LIMIT_GB = 4.0f;//without -mem-limit, accumulating a whole dense connectome at once would need twice the size of the output file
+    const float BYTES_PER_GB = 1024.0f * 1024.0f * 1024.0f;
+}
+
+AString AlgorithmCiftiAverageDenseCorrelation::getCommandSwitch()
+{
+    return "-cifti-average-dense-correlation";
+}
+
+AString AlgorithmCiftiAverageDenseCorrelation::getShortDescription()
+{
+    return "AVERAGE CORRELATION OF ALL ROWS ACROSS SUBJECTS";
+}
+
+OperationParameters* AlgorithmCiftiAverageDenseCorrelation::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    ret->addCiftiOutputParameter(1, "cifti-out", "output cifti file", true);//rows are written once each, in order, so don't keep the whole dconn in memory
+    
+    ret->createOptionalParameter(2, "-fisher-z", "output the average of the fisher small z transform (ie, artanh), instead of converting it back to correlation");
+    
+    OptionalParameter* memLimitOpt = ret->createOptionalParameter(3, "-mem-limit", "restrict memory usage");
+    memLimitOpt->addDoubleParameter(1, "limit-GB", "memory limit in gigabytes");
+    
+    ParameterComponent* ciftiOpt = ret->createRepeatableParameter(4, "-cifti", "specify an input cifti file");
+    ciftiOpt->addCiftiParameter(1, "cifti-in", "a cifti file to average across");
+    
+    ret->setHelpText(
+        AString("For each input file, correlates every row with every other row, applies the fisher small z transform, and averages the results across all files, ") +
+        "without making a correlation file for each input.  " +
+        "Unless -fisher-z is specified, the average is then converted back to correlation with tanh.  " +
+        "The input files must have the same mapping along columns, but may have different numbers of timepoints.\n\n" +
+        "The output is computed in chunks of rows, and every input file is read once per chunk, output rows are written to the output file as they are computed.  " +
+        "Without -mem-limit, the chunks are sized to use about " + AString::number(DEFAULT_MEM_LIMIT_GB) + " GB of memory, " +
+        "a larger limit means fewer chunks, and therefore fewer passes through the input files.  " +
+        "If the output file has the same name as an input file, the output is kept in memory until the end, and is counted against the memory limit.  " +
+        "Memory limit does not need to be an integer, you may also specify 0 to calculate a single output row at a time (this will be very slow)."
+    );
+    return ret;
+}
+
+void AlgorithmCiftiAverageDenseCorrelation::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    CiftiFile* ciftiOut = myParams->getOutputCifti(1);
+    bool fisherZ = myParams->getOptionalParameter(2)->m_present;
+    float memLimitGB = -1.0f;
+    OptionalParameter* memLimitOpt = myParams->getOptionalParameter(3);
+    if (memLimitOpt->m_present)
+    {
+        memLimitGB = (float)memLimitOpt->getDouble(1);
+        if (memLimitGB < 0.0f)
+        {
+            throw AlgorithmException("memory limit cannot be negative");
+        }
+    }
+    const vector<ParameterComponent*>& ciftiInputs = myParams->getRepeatableParameterInstances(4);
+    vector<const CiftiFile*> ciftiList;
+    for (int i = 0; i < (int)ciftiInputs.size(); ++i)
+    {
+        ciftiList.push_back(ciftiInputs[i]->getCifti(1));
+    }
+    AlgorithmCiftiAverageDenseCorrelation(myProgObj, ciftiList, ciftiOut, fisherZ, memLimitGB);
+}
+
+AlgorithmCiftiAverageDenseCorrelation::AlgorithmCiftiAverageDenseCorrelation(ProgressObject* myProgObj, const vector<const CiftiFile*>& ciftiList, CiftiFile* ciftiOut,
+                                                                             const bool& fisherZ, const float& memLimitGB) : AbstractAlgorithm(myProgObj, getCommandSwitch())
+{
+    CaretAssert(ciftiOut != NULL);
+    LevelProgress myProgress(myProgObj);
+    const int numCifti = (int)ciftiList.size();
+    if (numCifti < 1) throw AlgorithmException("no cifti files specified to average");
+    const CiftiXML& baseXML = ciftiList[0]->getCiftiXML();
+    if (baseXML.getNumberOfDimensions() != 2) throw AlgorithmException("only 2D cifti files are supported");
+    const int64_t numRows = ciftiList[0]->getNumberOfRows();
+    int64_t maxRowLength = 0;
+    for (int i = 0; i < numCifti; ++i)
+    {
+        const CiftiXML& thisXML = ciftiList[i]->getCiftiXML();
+        if (thisXML.getNumberOfDimensions() != 2) throw AlgorithmException("cifti #" + AString::number(i + 1) + " is not 2D");
+        if (!thisXML.getMap(CiftiXML::ALONG_COLUMN)->approximateMatch(*(baseXML.getMap(CiftiXML::ALONG_COLUMN))))
+        {
+            throw AlgorithmException("cifti space does not match between cifti #1 and #" + AString::number(i + 1));
+        }
+        maxRowLength = max(maxRowLength, ciftiList[i]->getNumberOfColumns());
+    }
+    CiftiXML newXML = baseXML;
+    newXML.setMap(CiftiXML::ALONG_ROW, *(baseXML.getMap(CiftiXML::ALONG_COLUMN)));
+    ciftiOut->setCiftiXML(newXML);
+    const bool outputInMemory = ciftiOut->isInMemory();
+    float useMemLimitGB = memLimitGB;
+    if (useMemLimitGB < 0.0f)
+    {
+        useMemLimitGB = DEFAULT_MEM_LIMIT_GB;
+        if (outputInMemory)
+        {//an in-memory output can't be avoided, so don't let it shrink the default to one row per chunk
+            useMemLimitGB += sizeof(float) * numRows * numRows / BYTES_PER_GB;
+        }
+    }
+    const int64_t chunkSize = numRowsForMem(useMemLimitGB, numRows, maxRowLength, outputInMemory);
+    CaretLogInfo("computing " + AString::number(chunkSize) + " rows at a time");
+    const int64_t numChunks = (numRows - 1) / chunkSize + 1;
+    vector<double> accum(chunkSize * numRows);//the only thing that scales with the output size
+    vector<float> chunkA(chunkSize * maxRowLength), blockB(min(B_BLOCK, numRows) * maxRowLength), tile(chunkSize * min(B_BLOCK, numRows)), outRow(numRows);
+    for (int64_t chunkStart = 0, whichChunk = 0; chunkStart < numRows; chunkStart += chunkSize, ++whichChunk)
+    {
+        const int64_t chunkCount = min(chunkSize, numRows - chunkStart);
+        fill(accum.begin(), accum.end(), 0.0);
+        for (int whichCifti = 0; whichCifti < numCifti; ++whichCifti)
+        {
+            const CiftiFile* thisCifti = ciftiList[whichCifti];
+            const int64_t rowLength = thisCifti->getNumberOfColumns();
+            for (int64_t i = 0; i < chunkCount; ++i)
+            {
+                thisCifti->getRow(chunkA.data() + i * rowLength, chunkStart + i);
+            }
+#pragma omp CARET_PARFOR schedule(dynamic)
+            for (int64_t i = 0; i < chunkCount; ++i)
+            {
+                SeedCorrelationEngine::normalize(chunkA.data() + i * rowLength, rowLength);
+            }
+            for (int64_t blockStart = 0; blockStart < numRows; blockStart += B_BLOCK)
+            {
+                const int64_t blockCount = min(B_BLOCK, numRows - blockStart);
+                for (int64_t i = 0; i < blockCount; ++i)
+                {
+                    thisCifti->getRow(blockB.data() + i * rowLength, blockStart + i);//read in order, never more than one row at a time
+                }
+#pragma omp CARET_PARFOR schedule(dynamic)
+                for (int64_t i = 0; i < blockCount; ++i)
+                {
+                    SeedCorrelationEngine::normalize(blockB.data() + i * rowLength, rowLength);
+                }
+                SeedCorrelationEngine(blockB.data(), blockCount, rowLength).correlateRows(chunkA.data(), chunkCount, rowLength, tile.data(), blockCount, true);//average in fisher z space
+#pragma omp CARET_PARFOR schedule(dynamic)
+                for (int64_t i = 0; i < chunkCount; ++i)
+                {
+                    double* accumRow = accum.data() + i * numRows + blockStart;
+                    const float* tileRow = tile.data() + i * blockCount;
+                    for (int64_t j = 0; j < blockCount; ++j)
+                    {
+                        accumRow[j] += tileRow[j];
+                    }
+                }
+            }
+            myProgress.reportProgress(((float)(whichChunk * numCifti + whichCifti + 1)) / (numChunks * numCifti));//every subject is read once per chunk
+        }
+        for (int64_t i = 0; i < chunkCount; ++i)
+        {
+            const double* accumRow = accum.data() + i * numRows;
+            for (int64_t j = 0; j < numRows; ++j)
+            {
+                double z = accumRow[j] / numCifti;
+                outRow[j] = (fisherZ ? z : tanh(z));
+            }
+            ciftiOut->setRow(outRow.data(), chunkStart + i);//each output row is written exactly once
+        }
+    }
+}
+
+int64_t AlgorithmCiftiAverageDenseCorrelation::numRowsForMem(const float& memLimitGB, const int64_t& numRows, const int64_t& maxRowLength, const bool& outputInMemory)
+{
+    int64_t targetBytes = (int64_t)(memLimitGB * BYTES_PER_GB);
+    if (outputInMemory) targetBytes -= sizeof(float) * numRows * numRows;//count in-memory output against the total too
+    targetBytes -= sizeof(float) * (min(B_BLOCK, numRows) * maxRowLength + numRows);//block of input rows, and the output row
+    const int64_t bytesPerChunkRow = sizeof(double) * numRows + sizeof(float) * (maxRowLength + min(B_BLOCK, numRows));//accumulator, input row, and tile
+    int64_t ret = 1;
+    if (targetBytes > 0)
+    {
+        int64_t numRowsMax = max(int64_t(1), targetBytes / bytesPerChunkRow);
+        int64_t numPasses = (numRows - 1) / numRowsMax + 1;
+        ret = (numRows - 1) / numPasses + 1;//most even distribution for that number of passes
+    }
+    if (ret == 1 && numRows > 1)
+    {
+        CaretLogWarning("requested memory usage is too low, using only 1 row at a time - this will be extremely slow");
+    }
+    return ret;
+}
+
+float AlgorithmCiftiAverageDenseCorrelation::getAlgorithmInternalWeight()
+{
+    return 1.0f;//override this if needed, if the progress bar isn't smooth
+}
+
+float AlgorithmCiftiAverageDenseCorrelation::getSubAlgorithmWeight()
+{
+    //return AlgorithmInsertNameHere::getAlgorithmWeight();//if you use a subalgorithm
+    return 0.0f;
+}
@@ -25,11 +25,14 @@
 #include "CiftiFile.h"
 #include "FileInformation.h"
 #include "MetricFile.h"
+#include "SeedCorrelationEngine.h"
 #include "SurfaceFile.h"
 #include "VolumeFile.h"
 
+#include <algorithm>
 #include <cmath>
 #include <fstream>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -53,7 +56,7 @@ OperationParameters* AlgorithmCiftiAverageROICorrelation::getParameters()
     
     OptionalParameter* ciftiRoiOpt = ret->createOptionalParameter(2, "-cifti-roi", "cifti file containing combined weights");
     ciftiRoiOpt->addCiftiParameter(1, "roi-cifti", "the roi cifti file");
-    ciftiRoiOpt->createOptionalParameter(2, "-in-memory", "cache the roi in memory so that it isn't re-read for each input cifti");
+    ciftiRoiOpt->createOptionalParameter(2, "-in-memory", "cache the roi in memory (the roi is now read only once, so this rarely matters)");
     
     OptionalParameter* leftRoiOpt = ret->createOptionalParameter(3, "-left-roi", "weights to use for left hempsphere");
     leftRoiOpt->addMetricParameter(1, "roi-metric", "the left roi as a metric file");
@@ -162,7 +165,7 @@ void AlgorithmCiftiAverageROICorrelation::useParameters(OperationParameters* myP
 
 AlgorithmCiftiAverageROICorrelation::AlgorithmCiftiAverageROICorrelation(ProgressObject* myProgObj, const vector<const CiftiFile*>& ciftiList, CiftiFile* ciftiOut,
                                                              const MetricFile* leftROI, const MetricFile* rightROI, const MetricFile* cerebROI, const VolumeFile* volROI,
-                                                             const SurfaceFile* leftAreaSurf, const SurfaceFile* rightAreaSurf, const SurfaceFile* cerebAreaSurf) : AbstractAlgorithm(myProgObj)
+                                                             const SurfaceFile* leftAreaSurf, const SurfaceFile* rightAreaSurf, const SurfaceFile* cerebAreaSurf) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     CaretAssert(ciftiOut != NULL);
     LevelProgress myProgress(myProgObj);
@@ -170,7 +173,6 @@ AlgorithmCiftiAverageROICorrelation::AlgorithmCiftiAverageROICorrelation(Progres
     if (numCifti < 1) throw AlgorithmException("no cifti files specified to average");
     const CiftiXMLOld& baseXML = ciftiList[0]->getCiftiXMLOld();
     int rowSize = baseXML.getNumberOfColumns();
-    int colSize = baseXML.getNumberOfRows();
     bool first = true;
     const CaretMappableDataFile* nameFile = NULL;
     int numMaps = -1;
@@ -256,7 +258,6 @@ AlgorithmCiftiAverageROICorrelation::AlgorithmCiftiAverageROICorrelation(Progres
             verifyVolumeComponent(i, ciftiList[i], volROI);
         }
     }
-    vector<vector<float> > tempresult(colSize, vector<float>(numMaps));
     CiftiXMLOld newXml = baseXML;
     newXml.resetRowsToScalars(numMaps);
     for (int i = 0; i < numMaps; ++i)
@@ -264,39 +265,18 @@ AlgorithmCiftiAverageROICorrelation::AlgorithmCiftiAverageROICorrelation(Progres
         newXml.setMapNameForIndex(CiftiXMLOld::ALONG_ROW, i, nameFile->getMapName(i));
     }
     ciftiOut->setCiftiXML(newXml);
-    if (numCifti > 1)//skip averaging in single subject case
-    {
-        vector<vector<double> > accum(colSize, vector<double>(numMaps, 0.0));
-        for (int i = 0; i < numCifti; ++i)
-        {
-            processCifti(ciftiList[i], tempresult, leftROI, rightROI, cerebROI, volROI, numMaps, leftAreaPointer, rightAreaPointer, cerebAreaPointer);
-            for (int j = 0; j < colSize; ++j)
-            {
-                for (int myMap = 0; myMap < numMaps; ++myMap)
-                {
-                    accum[j][myMap] += tempresult[j][myMap];
-                }
-            }
-        }
-        for (int i = 0; i < colSize; ++i)
-        {
-            for (int myMap = 0; myMap < numMaps; ++myMap)
-            {
-                tempresult[i][myMap] = accum[i][myMap] / numCifti;
-            }
-            ciftiOut->setRow(tempresult[i].data(), i);
-        }
-    } else {
-        processCifti(ciftiList[0], tempresult, leftROI, rightROI, cerebROI, volROI, numMaps, leftAreaPointer, rightAreaPointer, cerebAreaPointer);
-        for (int i = 0; i < colSize; ++i)
-        {
-            ciftiOut->setRow(tempresult[i].data(), i);
-        }
-    }
+    const CiftiBrainModelsMap& myModels = ciftiList[0]->getCiftiXML().getBrainModelsMap(CiftiXML::ALONG_COLUMN);
+    map<int64_t, vector<float> > weights;
+    addSurfaceWeights(myModels, StructureEnum::CORTEX_LEFT, leftROI, numMaps, leftAreaPointer, weights);
+    addSurfaceWeights(myModels, StructureEnum::CORTEX_RIGHT, rightROI, numMaps, rightAreaPointer, weights);
+    addSurfaceWeights(myModels, StructureEnum::CEREBELLUM, cerebROI, numMaps, cerebAreaPointer, weights);
+    addVolumeWeights(myModels, volROI, numMaps, weights);
+    setSeedWeights(weights, numMaps);
+    computeAverage(ciftiList, ciftiOut, numMaps);
 }
 
 AlgorithmCiftiAverageROICorrelation::AlgorithmCiftiAverageROICorrelation(ProgressObject* myProgObj, const vector<const CiftiFile*>& ciftiList, CiftiFile* ciftiOut, const CiftiFile* ciftiROI,
-                                                                         const SurfaceFile* leftAreaSurf, const SurfaceFile* rightAreaSurf, const SurfaceFile* cerebAreaSurf): AbstractAlgorithm(myProgObj)
+                                                                         const SurfaceFile* leftAreaSurf, const SurfaceFile* rightAreaSurf, const SurfaceFile* cerebAreaSurf): AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     CaretAssert(ciftiOut != NULL);
     LevelProgress myProgress(myProgObj);
@@ -304,7 +284,6 @@ AlgorithmCiftiAverageROICorrelation::AlgorithmCiftiAverageROICorrelation(Progres
     if (numCifti < 1) throw AlgorithmException("no cifti files specified to average");
     const CiftiXMLOld baseXML = ciftiList[0]->getCiftiXMLOld(), roiXML = ciftiROI->getCiftiXMLOld();
     int rowSize = baseXML.getNumberOfColumns();
-    int colSize = baseXML.getNumberOfRows();
     int numMaps = ciftiROI->getNumberOfColumns();
     if (!baseXML.mappingMatches(CiftiXMLOld::ALONG_COLUMN, roiXML, CiftiXMLOld::ALONG_COLUMN)) throw AlgorithmException("cifti roi doesn't match cifti space of data");
     for (int i = 1; i < numCifti; ++i)
@@ -341,7 +320,6 @@ AlgorithmCiftiAverageROICorrelation::AlgorithmCiftiAverageROICorrelation(Progres
         cerebAreaSurf->computeNodeAreas(cerebAreaData);
         cerebAreaPointer = cerebAreaData.data();
     }
-    vector<vector<float> > tempresult(colSize, vector<float>(numMaps));
     CiftiXMLOld newXml = baseXML;
     newXml.resetRowsToScalars(numMaps);
     for (int i = 0; i < numMaps; ++i)
@@ -349,35 +327,10 @@ AlgorithmCiftiAverageROICorrelation::AlgorithmCiftiAverageROICorrelation(Progres
         newXml.setMapNameForIndex(CiftiXMLOld::ALONG_ROW, i, roiXML.getMapNameForRowIndex(i));
     }
     ciftiOut->setCiftiXML(newXml);
-    if (numCifti > 1)//skip averaging in single subject case
-    {
-        vector<vector<double> > accum(colSize, vector<double>(numMaps, 0.0));
-        for (int i = 0; i < numCifti; ++i)
-        {
-            processCifti(ciftiList[i], tempresult, ciftiROI, numMaps, leftAreaPointer, rightAreaPointer, cerebAreaPointer);
-            for (int j = 0; j < colSize; ++j)
-            {
-                for (int myMap = 0; myMap < numMaps; ++myMap)
-                {
-                    accum[j][myMap] += tempresult[j][myMap];
-                }
-            }
-        }
-        for (int i = 0; i < colSize; ++i)
-        {
-            for (int myMap = 0; myMap < numMaps; ++myMap)
-            {
-                tempresult[i][myMap] = accum[i][myMap] / numCifti;
-            }
-            ciftiOut->setRow(tempresult[i].data(), i);
-        }
-    } else {
-        processCifti(ciftiList[0], tempresult, ciftiROI, numMaps, leftAreaPointer, rightAreaPointer, cerebAreaPointer);
-        for (int i = 0; i < colSize; ++i)
-        {
-            ciftiOut->setRow(tempresult[i].data(), i);
-        }
-    }
+    map<int64_t, vector<float> > weights;
+    addCiftiWeights(ciftiROI, numMaps, leftAreaPointer, rightAreaPointer, cerebAreaPointer, weights);
+    setSeedWeights(weights, numMaps);
+    computeAverage(ciftiList, ciftiOut, numMaps);
 }
 
 void AlgorithmCiftiAverageROICorrelation::verifySurfaceComponent(const int& index, const CiftiFile* myCifti, const StructureEnum::Enum& myStruct, const MetricFile* myRoi)
@@ -407,277 +360,173 @@ void AlgorithmCiftiAverageROICorrelation::verifyVolumeComponent(const int& index
     }
 }
 
-void AlgorithmCiftiAverageROICorrelation::processCifti(const CiftiFile* myCifti, vector<vector<float> >& output,
-                                                       const MetricFile* leftROI, const MetricFile* rightROI,const MetricFile* cerebROI, const VolumeFile* volROI,
-                                                       const int& numMaps, const float* leftAreas, const float* rightAreas, const float* cerebAreas)
+void AlgorithmCiftiAverageROICorrelation::addSurfaceWeights(const CiftiBrainModelsMap& myModels, const StructureEnum::Enum& myStruct, const MetricFile* myRoi, const int& numMaps,
+                                                            const float* myAreas, map<int64_t, vector<float> >& weightsOut)
 {
-    int rowSize = myCifti->getNumberOfColumns();
-    int colSize = myCifti->getNumberOfRows();
-    vector<vector<float> > average(numMaps, vector<float>(rowSize));
-    vector<float> rrs(numMaps);
-    for (int myMap = 0; myMap < numMaps; ++myMap)
+    if (myRoi == NULL || !myModels.hasSurfaceData(myStruct)) return;//missing structures were already warned about
+    vector<CiftiBrainModelsMap::SurfaceMap> surfaceMap = myModels.getSurfaceMap(myStruct);
+    int mapSize = (int)surfaceMap.size();
+    for (int i = 0; i < mapSize; ++i)
     {
-        vector<double> accumarray(rowSize, 0.0);
-        addSurface(myCifti, StructureEnum::CORTEX_LEFT, accumarray, leftROI, myMap, leftAreas);//we don't need to keep track of the kernel sums because we are correlating
-        addSurface(myCifti, StructureEnum::CORTEX_RIGHT, accumarray, rightROI, myMap, rightAreas);
-        addSurface(myCifti, StructureEnum::CEREBELLUM, accumarray, cerebROI, myMap, cerebAreas);
-        addVolume(myCifti, accumarray, volROI, myMap);
-        double accum = 0.0;
-        for (int i = 0; i < rowSize; ++i)
-        {
-            accum += accumarray[i];
-        }
-        double mean = accum / rowSize;
-        accum = 0.0;
-        for (int i = 0; i < rowSize; ++i)
+        for (int myMap = 0; myMap < numMaps; ++myMap)
         {
-            average[myMap][i] = accumarray[i] - mean;//remove the mean from the average timeseries to optimize the correlation, and change back to float for possible speed improvement
-            accum += average[myMap][i] * average[myMap][i];
+            float value = myRoi->getValue(surfaceMap[i].m_surfaceNode, myMap);
+            if (value != 0.0f)
+            {
+                vector<float>& rowWeights = weightsOut[surfaceMap[i].m_ciftiIndex];
+                if (rowWeights.empty()) rowWeights.resize(numMaps, 0.0f);
+                rowWeights[myMap] = (myAreas != NULL ? value * myAreas[surfaceMap[i].m_surfaceNode] : value);
+            }
         }
-        rrs[myMap] = sqrt(accum);//compute this only once
     }
-    int curRow = 0;
-#pragma omp CARET_PAR
+}
+
+void AlgorithmCiftiAverageROICorrelation::addVolumeWeights(const CiftiBrainModelsMap& myModels, const VolumeFile* myRoi, const int& numMaps, map<int64_t, vector<float> >& weightsOut)
+{
+    if (myRoi == NULL) return;
+    vector<CiftiBrainModelsMap::VolumeMap> volMap = myModels.getFullVolumeMap();
+    int mapSize = (int)volMap.size();
+    for (int i = 0; i < mapSize; ++i)
     {
-        vector<float> rowscratch(rowSize);
-#pragma omp CARET_FOR schedule(dynamic)
-        for (int i = 0; i < colSize; ++i)
+        for (int myMap = 0; myMap < numMaps; ++myMap)
         {
-            int myRow;
-#pragma omp critical
-            {
-                myRow = curRow;//force sequential reading
-                ++curRow;
-                myCifti->getRow(rowscratch.data(), myRow);//and never read multiple rows at once from the same file
-            }
-            double tempaccum = 0.0;//compute mean of new row
-            for (int j = 0; j < rowSize; ++j)
-            {
-                tempaccum += rowscratch[j];
-            }
-            float thismean = tempaccum / rowSize;
-            tempaccum = 0.0;
-            for (int j = 0; j < rowSize; ++j)
-            {
-                rowscratch[j] -= thismean;//demean
-                tempaccum += rowscratch[j] * rowscratch[j];//precompute rrs
-            }
-            float thisrrs = sqrt(tempaccum);
-            for (int myMap = 0; myMap < numMaps; ++myMap)
+            if (myRoi->getValue(volMap[i].m_ijk, myMap) > 0.0f)//volume roi is a mask, not weights
             {
-                double corraccum = 0.0;//correlate
-                for (int j = 0; j < rowSize; ++j)
-                {
-                    corraccum += rowscratch[j] * average[myMap][j];//gather the correlation
-                }
-                corraccum /= rrs[myMap] * thisrrs;
-                if (corraccum > 0.999999) corraccum = 0.999999;
-                if (corraccum < -0.999999) corraccum = -0.999999;
-                output[myRow][myMap] = 0.5 * log((1 + corraccum) / (1 - corraccum));//fisher z transform, needed for averaging
+                vector<float>& rowWeights = weightsOut[volMap[i].m_ciftiIndex];
+                if (rowWeights.empty()) rowWeights.resize(numMaps, 0.0f);
+                rowWeights[myMap] = 1.0f;
             }
         }
     }
 }
 
-void AlgorithmCiftiAverageROICorrelation::processCifti(const CiftiFile* myCifti, vector<vector<float> >& output, const CiftiFile* ciftiROI, const int& numMaps,
-                                                       const float* leftAreas, const float* rightAreas, const float* cerebAreas)
+void AlgorithmCiftiAverageROICorrelation::addCiftiWeights(const CiftiFile* ciftiROI, const int& numMaps, const float* leftAreas, const float* rightAreas, const float* cerebAreas,
+                                                          map<int64_t, vector<float> >& weightsOut)
 {
-    int rowSize = myCifti->getNumberOfColumns();
-    int colSize = myCifti->getNumberOfRows();
-    vector<vector<float> > average(numMaps, vector<float>(rowSize));
-    vector<float> rrs(numMaps);
-    const CiftiXMLOld& roiXML = ciftiROI->getCiftiXMLOld();
-    vector<StructureEnum::Enum> surfStructures, ignored;
-    roiXML.getStructureLists(CiftiXMLOld::ALONG_COLUMN, surfStructures, ignored);
-    vector<float> roiScratch(numMaps), dataScratch(rowSize);
+    const CiftiBrainModelsMap& roiModels = ciftiROI->getCiftiXML().getBrainModelsMap(CiftiXML::ALONG_COLUMN);
+    const int64_t numRows = ciftiROI->getNumberOfRows();
+    vector<float> rowScale(numRows, 1.0f);//vertex areas, where a surface was given
+    vector<StructureEnum::Enum> surfStructures = roiModels.getSurfaceStructureList();
+    for (int whichStruct = 0; whichStruct < (int)surfStructures.size(); ++whichStruct)
     {
-        vector<vector<double> > accumarray(numMaps, vector<double>(rowSize, 0.0));
-        for (int whichStruct = 0; whichStruct < (int)surfStructures.size(); ++whichStruct)
+        const float* areaPtr = NULL;
+        switch (surfStructures[whichStruct])
         {
-            const float* areaPtr = NULL;
-            switch (surfStructures[whichStruct])
-            {
-                case StructureEnum::CORTEX_LEFT:
-                    areaPtr = leftAreas;
-                    break;
-                case StructureEnum::CORTEX_RIGHT:
-                    areaPtr = rightAreas;
-                    break;
-                case StructureEnum::CEREBELLUM:
-                    areaPtr = cerebAreas;
-                    break;
-                default:
-                    break;
-            }
-            vector<CiftiSurfaceMap> myMap;
-            roiXML.getSurfaceMap(CiftiXMLOld::ALONG_COLUMN, myMap, surfStructures[whichStruct]);
-            for (int i = 0; i < (int)myMap.size(); ++i)
-            {
-                bool dataLoaded = false;
-                ciftiROI->getRow(roiScratch.data(), myMap[i].m_ciftiIndex);
-                for (int j = 0; j < numMaps; ++j)
-                {
-                    if (roiScratch[j] != 0.0f)
-                    {
-                        if (!dataLoaded)
-                        {
-                            myCifti->getRow(dataScratch.data(), myMap[i].m_ciftiIndex);
-                            dataLoaded = true;
-                        }
-                        if (areaPtr != NULL)
-                        {
-                            for (int k = 0; k < rowSize; ++k)
-                            {
-                                accumarray[j][k] += dataScratch[k] * roiScratch[j] * areaPtr[myMap[i].m_surfaceNode];
-                            }
-                        } else {
-                            for (int k = 0; k < rowSize; ++k)
-                            {
-                                accumarray[j][k] += dataScratch[k] * roiScratch[j];
-                            }
-                        }
-                    }
-                }
-            }
+            case StructureEnum::CORTEX_LEFT:
+                areaPtr = leftAreas;
+                break;
+            case StructureEnum::CORTEX_RIGHT:
+                areaPtr = rightAreas;
+                break;
+            case StructureEnum::CEREBELLUM:
+                areaPtr = cerebAreas;
+                break;
+            default:
+                break;
         }
-        vector<CiftiVolumeMap> myMap;
-        roiXML.getVolumeMap(CiftiXMLOld::ALONG_COLUMN, myMap);
+        if (areaPtr == NULL) continue;
+        vector<CiftiBrainModelsMap::SurfaceMap> myMap = roiModels.getSurfaceMap(surfStructures[whichStruct]);
         for (int i = 0; i < (int)myMap.size(); ++i)
         {
-            bool dataLoaded = false;
-            ciftiROI->getRow(roiScratch.data(), myMap[i].m_ciftiIndex);
-            for (int j = 0; j < numMaps; ++j)
-            {
-                if (roiScratch[j] != 0.0f)
-                {
-                    if (!dataLoaded)
-                    {
-                        myCifti->getRow(dataScratch.data(), myMap[i].m_ciftiIndex);
-                        dataLoaded = true;
-                    }
-                    for (int k = 0; k < rowSize; ++k)
-                    {
-                        accumarray[j][k] += dataScratch[k] * roiScratch[j];
-                    }
-                }
-            }
-        }
-        for (int i = 0; i < numMaps; ++i)
-        {
-            double accum = 0.0;
-            for (int j = 0; j < rowSize; ++j)
-            {
-                accum += accumarray[i][j];
-            }
-            float mean = accum / rowSize;
-            accum = 0.0;
-            for (int j = 0; j < rowSize; ++j)
-            {
-                average[i][j] = accumarray[i][j] - mean;
-                accum += average[i][j] * average[i][j];
-            }
-            vector<double>().swap(accumarray[i]);//hack to free memory before it goes out of scope
-            rrs[i] = sqrt(accum);
+            rowScale[myMap[i].m_ciftiIndex] = areaPtr[myMap[i].m_surfaceNode];
         }
     }
-    int curRow = 0;
-#pragma omp CARET_PAR
+    vector<float> roiScratch(numMaps);
+    for (int64_t i = 0; i < numRows; ++i)
     {
-        vector<float> rowscratch(rowSize);
-#pragma omp CARET_FOR schedule(dynamic)
-        for (int i = 0; i < colSize; ++i)
+        ciftiROI->getRow(roiScratch.data(), i);
+        for (int j = 0; j < numMaps; ++j)
         {
-            int myRow;
-#pragma omp critical
-            {
-                myRow = curRow;//force sequential reading
-                ++curRow;
-                myCifti->getRow(rowscratch.data(), myRow);//and never read multiple rows at once from the same file
-            }
-            double tempaccum = 0.0;//compute mean of new row
-            for (int j = 0; j < rowSize; ++j)
-            {
-                tempaccum += rowscratch[j];
-            }
-            float thismean = tempaccum / rowSize;
-            tempaccum = 0.0;
-            for (int j = 0; j < rowSize; ++j)
+            if (roiScratch[j] != 0.0f)
             {
-                rowscratch[j] -= thismean;//demean
-                tempaccum += rowscratch[j] * rowscratch[j];//precompute rrs
-            }
-            float thisrrs = sqrt(tempaccum);
-            for (int myMap = 0; myMap < numMaps; ++myMap)
-            {
-                double corraccum = 0.0;//correlate
-                for (int j = 0; j < rowSize; ++j)
-                {
-                    corraccum += rowscratch[j] * average[myMap][j];//gather the correlation
-                }
-                corraccum /= rrs[myMap] * thisrrs;
-                if (corraccum > 0.999999) corraccum = 0.999999;
-                if (corraccum < -0.999999) corraccum = -0.999999;
-                output[myRow][myMap] = 0.5 * log((1 + corraccum) / (1 - corraccum));//fisher z transform, needed for averaging
+                vector<float>& rowWeights = weightsOut[i];
+                if (rowWeights.empty()) rowWeights.resize(numMaps, 0.0f);
+                rowWeights[j] = roiScratch[j] * rowScale[i];
             }
         }
     }
 }
 
-void AlgorithmCiftiAverageROICorrelation::addSurface(const CiftiFile* myCifti, StructureEnum::Enum myStruct, vector<double>& accum, const MetricFile* myRoi, const int& myMap, const float* myAreas)
+void AlgorithmCiftiAverageROICorrelation::setSeedWeights(const map<int64_t, vector<float> >& weights, const int& numMaps)
 {
-    if (myRoi == NULL) return;
-    vector<CiftiBrainModelsMap::SurfaceMap> surfaceMap = myCifti->getCiftiXML().getBrainModelsMap(CiftiXML::ALONG_COLUMN).getSurfaceMap(myStruct);
-    int mapSize = (int)surfaceMap.size();
-    int rowSize = myCifti->getNumberOfColumns();
-    vector<float> rowscratch(rowSize);
-    if (myAreas != NULL)
-    {
-        for (int i = 0; i < mapSize; ++i)
+    m_seedRows.clear();
+    m_seedWeights.clear();
+    m_seedRows.reserve(weights.size());
+    m_seedWeights.reserve(weights.size() * numMaps);
+    for (map<int64_t, vector<float> >::const_iterator iter = weights.begin(); iter != weights.end(); ++iter)
+    {//map is sorted, so the rows get read in file order
+        m_seedRows.push_back(iter->first);
+        m_seedWeights.insert(m_seedWeights.end(), iter->second.begin(), iter->second.end());
+    }
+}
+
+void AlgorithmCiftiAverageROICorrelation::processCifti(const CiftiFile* myCifti, vector<float>& output, const int& numMaps)
+{
+    const int64_t rowSize = myCifti->getNumberOfColumns();
+    const int64_t numSeedRows = (int64_t)m_seedRows.size();
+    const int64_t READ_BLOCK = 256;
+    vector<double> accumarray(numMaps * rowSize, 0.0);//we don't need to keep track of the kernel sums because we are correlating
+    vector<float> block(min(READ_BLOCK, numSeedRows) * rowSize);
+    for (int64_t blockStart = 0; blockStart < numSeedRows; blockStart += READ_BLOCK)
+    {//every map's seed is accumulated from the same rows, so each row is read only once
+        const int64_t blockCount = min(READ_BLOCK, numSeedRows - blockStart);
+        for (int64_t i = 0; i < blockCount; ++i)
         {
-            float value = myRoi->getValue(surfaceMap[i].m_surfaceNode, myMap);
-            if (value != 0.0f)
-            {
-                float thisArea = myAreas[surfaceMap[i].m_surfaceNode];
-                myCifti->getRow(rowscratch.data(), surfaceMap[i].m_ciftiIndex);
-                for (int j = 0; j < rowSize; ++j)
-                {
-                    accum[j] += rowscratch[j] * value * thisArea;
-                }
-            }
+            myCifti->getRow(block.data() + i * rowSize, m_seedRows[blockStart + i]);
         }
-    } else {
-        for (int i = 0; i < mapSize; ++i)
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int myMap = 0; myMap < numMaps; ++myMap)
         {
-            float value = myRoi->getValue(surfaceMap[i].m_surfaceNode, myMap);
-            if (value != 0.0f)
+            double* seedAccum = accumarray.data() + myMap * rowSize;
+            for (int64_t i = 0; i < blockCount; ++i)
             {
-                myCifti->getRow(rowscratch.data(), surfaceMap[i].m_ciftiIndex);
-                for (int j = 0; j < rowSize; ++j)
+                const float weight = m_seedWeights[(blockStart + i) * numMaps + myMap];
+                if (weight == 0.0f) continue;
+                const float* row = block.data() + i * rowSize;
+                for (int64_t k = 0; k < rowSize; ++k)
                 {
-                    accum[j] += rowscratch[j] * value;
+                    seedAccum[k] += row[k] * weight;
                 }
             }
         }
     }
+    vector<float>().swap(block);
+    vector<float> seeds(accumarray.begin(), accumarray.end());
+    vector<double>().swap(accumarray);
+    for (int myMap = 0; myMap < numMaps; ++myMap)
+    {
+        SeedCorrelationEngine::normalize(seeds.data() + myMap * rowSize, rowSize);
+    }
+    output.resize(myCifti->getNumberOfRows() * numMaps);
+    SeedCorrelationEngine(seeds.data(), numMaps, rowSize).correlateCifti(myCifti, output.data(), true);//fisher z transform, needed for averaging
 }
 
-void AlgorithmCiftiAverageROICorrelation::addVolume(const CiftiFile* myCifti, vector<double>& accum, const VolumeFile* myRoi, const int& myMap)
+void AlgorithmCiftiAverageROICorrelation::computeAverage(const vector<const CiftiFile*>& ciftiList, CiftiFile* ciftiOut, const int& numMaps)
 {
-    if (myRoi == NULL) return;
-    vector<CiftiBrainModelsMap::VolumeMap> volMap = myCifti->getCiftiXML().getBrainModelsMap(CiftiXML::ALONG_COLUMN).getFullVolumeMap();
-    int mapSize = (int)volMap.size();
-    int rowSize = myCifti->getNumberOfColumns();
-    vector<float> rowscratch(rowSize);
-    for (int i = 0; i < mapSize; ++i)
+    const int numCifti = (int)ciftiList.size();
+    const int64_t colSize = ciftiList[0]->getNumberOfRows();
+    vector<float> tempresult;
+    if (numCifti > 1)//skip averaging in single subject case
     {
-        if (myRoi->getValue(volMap[i].m_ijk, myMap) > 0.0f)
+        vector<double> accum(colSize * numMaps, 0.0);
+        for (int i = 0; i < numCifti; ++i)
         {
-            myCifti->getRow(rowscratch.data(), volMap[i].m_ciftiIndex);
-            for (int j = 0; j < rowSize; ++j)
+            processCifti(ciftiList[i], tempresult, numMaps);
+            for (int64_t j = 0; j < colSize * numMaps; ++j)
             {
-                accum[j] += rowscratch[j];
+                accum[j] += tempresult[j];
             }
         }
+        for (int64_t j = 0; j < colSize * numMaps; ++j)
+        {
+            tempresult[j] = accum[j] / numCifti;
+        }
+    } else {
+        processCifti(ciftiList[0], tempresult, numMaps);
+    }
+    for (int64_t i = 0; i < colSize; ++i)
+    {
+        ciftiOut->setRow(tempresult.data() + i * numMaps, i);
     }
 }
 
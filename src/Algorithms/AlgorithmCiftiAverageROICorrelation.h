@@ -23,21 +23,29 @@
 
 #include "AbstractAlgorithm.h"
 #include "StructureEnum.h"
+
+#include <map>
 #include <vector>
 
 namespace caret {
     
+    class CiftiBrainModelsMap;
+    
     class AlgorithmCiftiAverageROICorrelation : public AbstractAlgorithm
     {
         AlgorithmCiftiAverageROICorrelation();
+        std::vector<int64_t> m_seedRows;//input rows that have a nonzero weight in any roi map
+        std::vector<float> m_seedWeights;//m_seedRows.size() x number of maps, all seeds are built in one pass over these rows
         void verifySurfaceComponent(const int& index, const CiftiFile* myCifti, const StructureEnum::Enum& myStruct, const MetricFile* myRoi);
         void verifyVolumeComponent(const int& index, const CiftiFile* myCifti, const VolumeFile* volROI);
-        void processCifti(const CiftiFile* myCifti, std::vector<std::vector<float> >& output, const MetricFile* leftROI, const MetricFile* rightROI, const MetricFile* cerebROI, const VolumeFile* volROI,
-                          const int& numMaps, const float* leftAreas, const float* rightAreas, const float* cerebAreas);
-        void processCifti(const CiftiFile* myCifti, std::vector<std::vector<float> >& output, const CiftiFile* ciftiROI,
-                          const int& numMaps, const float* leftAreas, const float* rightAreas, const float* cerebAreas);
-        void addSurface(const CiftiFile* myCifti, StructureEnum::Enum myStruct, std::vector<double>& accum, const MetricFile* myRoi, const int& myMap, const float* myAreas);
-        void addVolume(const CiftiFile* myCifti, std::vector<double>& accum, const VolumeFile* myRoi, const int& myMap);
+        void addSurfaceWeights(const CiftiBrainModelsMap& myModels, const StructureEnum::Enum& myStruct, const MetricFile* myRoi, const int& numMaps, const float* myAreas,
+                               std::map<int64_t, std::vector<float> >& weightsOut);
+        void addVolumeWeights(const CiftiBrainModelsMap& myModels, const VolumeFile* myRoi, const int& numMaps, std::map<int64_t, std::vector<float> >& weightsOut);
+        void addCiftiWeights(const CiftiFile* ciftiROI, const int& numMaps, const float* leftAreas, const float* rightAreas, const float* cerebAreas,
+                             std::map<int64_t, std::vector<float> >& weightsOut);
+        void setSeedWeights(const std::map<int64_t, std::vector<float> >& weights, const int& numMaps);
+        void processCifti(const CiftiFile* myCifti, std::vector<float>& output, const int& numMaps);
+        void computeAverage(const std::vector<const CiftiFile*>& ciftiList, CiftiFile* ciftiOut, const int& numMaps);
     protected:
         static float getSubAlgorithmWeight();
         static float getAlgorithmInternalWeight();
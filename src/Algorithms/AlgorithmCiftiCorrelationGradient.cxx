@@ -26,8 +26,10 @@
 #include "CaretLogger.h"
 #include "CaretOMP.h"
 #include "CiftiFile.h"
+#include "DotProductTile.h"
 #include "GeodesicHelper.h"
 #include "MetricFile.h"
+#include "MetricGradientObject.h"
 #include "SurfaceFile.h"
 #include "Vector3D.h"
 #include "VolumeFile.h"
@@ -214,7 +216,7 @@ AlgorithmCiftiCorrelationGradient::AlgorithmCiftiCorrelationGradient(ProgressObj
                                                                      const float& surfaceExclude, const float& volumeExclude,
                                                                      const bool& covariance,
                                                                      const float& memLimitGB,
-                                                                     const bool doubleCorr, const bool firstFisher, const bool firstNoDemean, const bool firstCovar) : AbstractAlgorithm(myProgObj)
+                                                                     const bool doubleCorr, const bool firstFisher, const bool firstNoDemean, const bool firstCovar) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     init(myCifti, memLimitGB, undoFisherInput, applyFisher, covariance, doubleCorr, firstFisher, firstNoDemean, firstCovar);
@@ -289,6 +291,8 @@ AlgorithmCiftiCorrelationGradient::AlgorithmCiftiCorrelationGradient(ProgressObj
         if (surfaceExclude > 0.0f)
         {
             processSurfaceComponent(surfaceList[whichStruct], surfKern, surfaceExclude, memLimitGB, mySurf, myAreas);
+        } else if (canFuse((int64_t)spaceMap.getSurfaceMap(surfaceList[whichStruct]).size())) {
+            processSurfaceComponentFused(surfaceList[whichStruct], surfKern, mySurf, myAreas);
         } else {
             processSurfaceComponent(surfaceList[whichStruct], surfKern, memLimitGB, mySurf, myAreas);
         }
@@ -308,6 +312,23 @@ AlgorithmCiftiCorrelationGradient::AlgorithmCiftiCorrelationGradient(ProgressObj
 namespace
 {
     
+    float finishCorrelation(double r, const bool covariance, const bool fisherz)
+    {
+        if (!covariance)
+        {
+            if (fisherz)
+            {
+                if (r > 0.999999) r = 0.999999;//prevent inf
+                if (r < -0.999999) r = -0.999999;//prevent -inf
+                r = 0.5 * log((1 + r) / (1 - r));
+            } else {
+                if (r > 1.0) r = 1.0;//don't output anything silly
+                if (r < -1.0) r = -1.0;
+            }
+        }
+        return r;
+    }
+    
     //expects rows to already be demeaned, if demeaning is to be done
     float correlate(const float* row1, const float& rrs1, const float* row2, const float& rrs2, const int64_t length, const bool covariance, const bool fisherz)
     {
@@ -324,19 +345,7 @@ namespace
                 r = accum / (rrs1 * rrs2);
             }
         }
-        if (!covariance)
-        {
-            if (fisherz)
-            {
-                if (r > 0.999999) r = 0.999999;//prevent inf
-                if (r < -0.999999) r = -0.999999;//prevent -inf
-                r = 0.5 * log((1 + r) / (1 - r));
-            } else {
-                if (r > 1.0) r = 1.0;//don't output anything silly
-                if (r < -1.0) r = -1.0;
-            }
-        }
-        return r;
+        return finishCorrelation(r, covariance, fisherz);
     }
     
     void adjustRow(float* rowOut, int64_t length, AlgorithmCiftiCorrelationGradient::RowInfo& rowInfo, const bool undoFisher, const bool covariance, const bool noDemean)
@@ -453,6 +462,30 @@ namespace
         //unlike ordinary correlation, the memory for storing the in-progress output has already been dictated to us, so there is no advantage to chunking any smaller than the input cache
         return ret;
     }
+    
+    const int64_t FUSED_SEED_TILE = 64;//seeds whose correlation maps are computed together
+    const int64_t FUSED_TARGET_BLOCK = 256;//target rows per dot product task, keeps a chunk of both sets of rows in cache
+    const int64_t GRAM_ROW_BLOCK = 256;//input rows per rank update of the gram matrix
+    const int64_t GRAM_TILE = 64;
+    
+    //out is numA x numB, B is split into blocks that are done in parallel
+    void parallelDotProducts(const float* A, const int64_t aStride, const int64_t numA, const float* B, const int64_t bStride, const int64_t numB, const int64_t length, double* out)
+    {
+#pragma omp CARET_PAR
+        {
+            vector<double> scratch(numA * FUSED_TARGET_BLOCK);
+#pragma omp CARET_FOR schedule(dynamic)
+            for (int64_t blockStart = 0; blockStart < numB; blockStart += FUSED_TARGET_BLOCK)
+            {
+                int64_t blockCount = min(FUSED_TARGET_BLOCK, numB - blockStart);
+                dotProductTile(A, aStride, numA, B + blockStart * bStride, bStride, blockCount, length, scratch.data());
+                for (int64_t i = 0; i < numA; ++i)
+                {
+                    copy(scratch.begin() + i * blockCount, scratch.begin() + (i + 1) * blockCount, out + i * numB + blockStart);
+                }
+            }
+        }
+    }
 }
 
 void AlgorithmCiftiCorrelationGradient::processSurfaceComponent(StructureEnum::Enum& myStructure, const float& surfKern, const float& memLimitGB, SurfaceFile* mySurf, const MetricFile* myAreas)
@@ -1108,6 +1141,293 @@ void AlgorithmCiftiCorrelationGradient::processVolumeComponent(StructureEnum::En
     }
 }
 
+bool AlgorithmCiftiCorrelationGradient::canFuse(const int64_t& numRows) const
+{
+    if (m_doubleCorr && (m_firstFisher || m_undoFisherInput)) return false;//the gram identity needs the first correlation to be linear in the input
+    if (m_memLimitGB < 0.0f) return true;
+    int64_t dim = m_numCols, extraBytes = 0;
+    if (m_doubleCorr)
+    {
+        dim = m_rowLengthFirst + 1;
+        extraBytes = m_rowLengthFirst * m_rowLengthFirst * (sizeof(float) + sizeof(double)) + FUSED_SEED_TILE * dim * sizeof(float);//gram is accumulated in double, kept in float
+    }
+    int64_t numThreads = 1;
+#ifdef CARET_OMP
+    numThreads = omp_get_max_threads();
+#endif
+    //prepared rows, one tile of dot products, and per-thread map scratch (approximated by structure size, the ROI covers most of the surface)
+    int64_t neededBytes = numRows * dim * sizeof(float) + FUSED_SEED_TILE * numRows * sizeof(double) + numThreads * numRows * (3 * sizeof(float) + sizeof(double)) + extraBytes;
+    if (m_inputCifti->isInMemory())
+    {
+        neededBytes += sizeof(float) * m_inputCifti->getNumberOfColumns() * m_inputCifti->getNumberOfRows();
+    }
+    return neededBytes <= (int64_t)(m_memLimitGB * 1024 * 1024 * 1024);
+}
+
+void AlgorithmCiftiCorrelationGradient::computeGram()
+{//for double correlation without fisher on the first step, the first correlation is R1[a, k] = u_a . u_k, so the second step only needs sum_k u_k u_k' and sum_k u_k
+    if (!m_gram.empty()) return;
+    const int64_t length = m_rowLengthFirst, numRows = m_numCols;
+    vector<double> gram(length * length, 0.0);
+    m_gramRowSum.assign(length, 0.0);
+    vector<float> block(GRAM_ROW_BLOCK * length), blockTransposed(length * GRAM_ROW_BLOCK);
+    vector<pair<int64_t, int64_t> > tilePairs;
+    for (int64_t i = 0; i < length; i += GRAM_TILE)
+    {
+        for (int64_t j = i; j < length; j += GRAM_TILE)//symmetric, do the upper triangle
+        {
+            tilePairs.push_back(make_pair(i, j));
+        }
+    }
+    for (int64_t blockStart = 0; blockStart < numRows; blockStart += GRAM_ROW_BLOCK)
+    {
+        int64_t blockCount = min(GRAM_ROW_BLOCK, numRows - blockStart);
+        for (int64_t r = 0; r < blockCount; ++r)
+        {
+            m_inputCifti->getRow(block.data() + r * length, blockStart + r);
+        }
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t r = 0; r < blockCount; ++r)
+        {
+            float* row = block.data() + r * length;
+            RowInfo& myInfo = m_firstCorrInfo[blockStart + r];
+            adjustRow(row, length, myInfo, false, m_firstCovar, m_firstNoDemean);
+            float scale = (m_firstCovar ? 1.0f / sqrt((float)length) : 1.0f / myInfo.m_rootResidSqr);
+            for (int64_t t = 0; t < length; ++t)
+            {
+                row[t] *= scale;
+                blockTransposed[t * blockCount + r] = row[t];
+            }
+        }
+#pragma omp CARET_PARFOR
+        for (int64_t t = 0; t < length; ++t)
+        {
+            double accum = 0.0;
+            for (int64_t r = 0; r < blockCount; ++r)
+            {
+                accum += blockTransposed[t * blockCount + r];
+            }
+            m_gramRowSum[t] += accum;
+        }
+#pragma omp CARET_PAR
+        {
+            vector<double> scratch(GRAM_TILE * GRAM_TILE);
+#pragma omp CARET_FOR schedule(dynamic)
+            for (int64_t p = 0; p < (int64_t)tilePairs.size(); ++p)
+            {
+                int64_t iStart = tilePairs[p].first, jStart = tilePairs[p].second;
+                int64_t iCount = min(GRAM_TILE, length - iStart), jCount = min(GRAM_TILE, length - jStart);
+                dotProductTile(blockTransposed.data() + iStart * blockCount, blockCount, iCount,
+                               blockTransposed.data() + jStart * blockCount, blockCount, jCount, blockCount, scratch.data());
+                for (int64_t i = 0; i < iCount; ++i)
+                {
+                    for (int64_t j = 0; j < jCount; ++j)
+                    {
+                        gram[(iStart + i) * length + jStart + j] += scratch[i * jCount + j];
+                    }
+                }
+            }
+        }
+    }
+    m_gram.resize(length * length);
+    for (int64_t i = 0; i < length; ++i)
+    {
+        for (int64_t j = i; j < length; ++j)
+        {
+            m_gram[i * length + j] = gram[i * length + j];
+            m_gram[j * length + i] = gram[i * length + j];
+        }
+    }
+}
+
+void AlgorithmCiftiCorrelationGradient::prepareFusedRows(const vector<int64_t>& ciftiIndices, vector<float>& rowsOut, int64_t& dimOut,
+                                                         vector<float>& seedScalesOut, vector<float>& targetScalesOut)
+{//correlation of seed a with target b is finishCorrelation(dot(seed row a, prepared row b) * seedScale[a] * targetScale[b])
+    int64_t numIndices = (int64_t)ciftiIndices.size();
+    seedScalesOut.resize(numIndices);
+    targetScalesOut.resize(numIndices);
+    if (!m_doubleCorr)
+    {
+        dimOut = m_numCols;
+        rowsOut.resize(numIndices * dimOut);
+        int64_t curIndex = 0;
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t i = 0; i < numIndices; ++i)
+        {
+            float* myPtr = NULL;
+            int64_t myIndex = -1;
+#pragma omp critical
+            {//manually in-order reading
+                myIndex = curIndex;
+                ++curIndex;
+                myPtr = rowsOut.data() + myIndex * dimOut;
+                m_inputCifti->getRow(myPtr, ciftiIndices[myIndex]);
+            }
+            RowInfo& myInfo = m_rowInfo[ciftiIndices[myIndex]];
+            adjustRow(myPtr, m_numCols, myInfo, m_undoFisherInput, m_covariance, false);
+            if (m_covariance)
+            {
+                seedScalesOut[myIndex] = 1.0f / m_numCols;
+                targetScalesOut[myIndex] = 1.0f;
+            } else {
+                seedScalesOut[myIndex] = 1.0f / myInfo.m_rootResidSqr;
+                targetScalesOut[myIndex] = seedScalesOut[myIndex];
+            }
+        }
+        return;
+    }
+    computeGram();
+    const int64_t length = m_rowLengthFirst, numRows = m_numCols;
+    dimOut = length + 1;//first correlation normalized row, then the mean of its correlation row
+    rowsOut.resize(numIndices * dimOut);
+    int64_t curIndex = 0;
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int64_t i = 0; i < numIndices; ++i)
+    {
+        float* myPtr = NULL;
+        int64_t myIndex = -1;
+#pragma omp critical
+        {
+            myIndex = curIndex;
+            ++curIndex;
+            myPtr = rowsOut.data() + myIndex * dimOut;
+            m_inputCifti->getRow(myPtr, ciftiIndices[myIndex]);
+        }
+        RowInfo& myInfo = m_firstCorrInfo[ciftiIndices[myIndex]];
+        adjustRow(myPtr, length, myInfo, false, m_firstCovar, m_firstNoDemean);
+        float scale = (m_firstCovar ? 1.0f / sqrt((float)length) : 1.0f / myInfo.m_rootResidSqr);
+        double meanAccum = 0.0;
+        for (int64_t t = 0; t < length; ++t)
+        {
+            myPtr[t] *= scale;
+            meanAccum += myPtr[t] * m_gramRowSum[t];
+        }
+        myPtr[length] = meanAccum / numRows;
+    }
+    //the second correlation's residual sum of squares is dot(seed row, prepared row) of the row with itself
+    vector<float> seedRows;
+    for (int64_t start = 0; start < numIndices; start += FUSED_SEED_TILE)
+    {
+        int64_t count = min(FUSED_SEED_TILE, numIndices - start);
+        getFusedSeedRows(rowsOut, dimOut, start, count, seedRows);
+        for (int64_t i = 0; i < count; ++i)
+        {
+            double accum = 0.0;
+            const float* seedRow = seedRows.data() + i * dimOut, *targetRow = rowsOut.data() + (start + i) * dimOut;
+            for (int64_t t = 0; t < dimOut; ++t)
+            {
+                accum += seedRow[t] * targetRow[t];
+            }
+            if (m_covariance)
+            {
+                seedScalesOut[start + i] = 1.0f / numRows;
+                targetScalesOut[start + i] = 1.0f;
+            } else {
+                float rrs = sqrt(max(accum, 0.0));
+                seedScalesOut[start + i] = 1.0f / rrs;
+                targetScalesOut[start + i] = seedScalesOut[start + i];
+            }
+        }
+    }
+}
+
+const float* AlgorithmCiftiCorrelationGradient::getFusedSeedRows(const vector<float>& preparedRows, const int64_t& dim, const int64_t& start, const int64_t& count, vector<float>& storage) const
+{
+    if (!m_doubleCorr) return preparedRows.data() + start * dim;//plain correlation is symmetric in the prepared rows
+    const int64_t length = m_rowLengthFirst, numRows = m_numCols;
+    vector<double> gramProducts(count * length);
+    parallelDotProducts(preparedRows.data() + start * dim, dim, count, m_gram.data(), length, length, length, gramProducts.data());//gram is symmetric, so its rows work as columns
+    storage.resize(count * dim);
+    for (int64_t i = 0; i < count; ++i)
+    {
+        for (int64_t t = 0; t < length; ++t)
+        {
+            storage[i * dim + t] = gramProducts[i * length + t];
+        }
+        storage[i * dim + length] = -numRows * preparedRows[(start + i) * dim + length];//removes the correlation row means: u_a' G u_b - n * mean_a * mean_b
+    }
+    return storage.data();
+}
+
+void AlgorithmCiftiCorrelationGradient::processSurfaceComponentFused(StructureEnum::Enum& myStructure, const float& surfKern, SurfaceFile* mySurf, const MetricFile* myAreas)
+{
+    const CiftiXMLOld& myXML = m_inputCifti->getCiftiXMLOld();
+    vector<CiftiSurfaceMap> myMap;
+    myXML.getSurfaceMapForColumns(myMap, myStructure);
+    int64_t mapSize = (int64_t)myMap.size();
+    int32_t numNodes = mySurf->getNumberOfNodes();
+    const float* areaData = NULL;
+    if (myAreas != NULL)
+    {
+        areaData = myAreas->getValuePointerForColumn(0);
+    }
+    vector<float> roiValues(numNodes, 0.0f);
+    vector<int64_t> rowIndices(mapSize);
+    for (int64_t i = 0; i < mapSize; ++i)
+    {
+        roiValues[myMap[i].m_surfaceNode] = 1.0f;
+        rowIndices[i] = myMap[i].m_ciftiIndex;
+    }
+    CaretPointer<MetricSmoothingObject> mySmooth;
+    if (surfKern > 0.0f)
+    {
+        MetricFile myRoi;
+        myRoi.setNumberOfNodesAndColumns(numNodes, 1);
+        myRoi.setValuesForColumn(0, roiValues.data());
+        mySmooth.grabNew(new MetricSmoothingObject(mySurf, surfKern, &myRoi, MetricSmoothingObject::GEO_GAUSS_AREA, areaData));
+    }
+    MetricGradientObject myGradient(mySurf, roiValues.data(), areaData);
+    vector<float> preparedRows, seedScales, targetScales, seedStorage;
+    int64_t dim = 0;
+    prepareFusedRows(rowIndices, preparedRows, dim, seedScales, targetScales);
+    vector<double> accum(mapSize, 0.0), tileDots;
+    for (int64_t tileStart = 0; tileStart < mapSize; tileStart += FUSED_SEED_TILE)
+    {
+        int64_t tileCount = min(FUSED_SEED_TILE, mapSize - tileStart);
+        const float* seedRows = getFusedSeedRows(preparedRows, dim, tileStart, tileCount, seedStorage);
+        tileDots.resize(tileCount * mapSize);
+        parallelDotProducts(seedRows, dim, tileCount, preparedRows.data(), dim, mapSize, dim, tileDots.data());
+#pragma omp CARET_PAR
+        {
+            vector<float> corrMap(numNodes, 0.0f), smoothMap, gradMap(numNodes);
+            if (mySmooth != NULL) smoothMap.resize(numNodes);
+            vector<double> localAccum(mapSize, 0.0);
+#pragma omp CARET_FOR schedule(dynamic)
+            for (int64_t seed = 0; seed < tileCount; ++seed)
+            {
+                const double* dotRow = tileDots.data() + seed * mapSize;
+                double seedScale = seedScales[tileStart + seed];
+                for (int64_t j = 0; j < mapSize; ++j)
+                {
+                    corrMap[myMap[j].m_surfaceNode] = finishCorrelation(dotRow[j] * seedScale * targetScales[j], m_covariance, m_applyFisher);
+                }
+                const float* gradInput = corrMap.data();
+                if (mySmooth != NULL)
+                {
+                    mySmooth->smoothValues(corrMap.data(), smoothMap.data());
+                    gradInput = smoothMap.data();
+                }
+                myGradient.gradientMagnitude(gradInput, gradMap.data());
+                for (int64_t j = 0; j < mapSize; ++j)
+                {
+                    localAccum[j] += gradMap[myMap[j].m_surfaceNode];
+                }
+            }
+#pragma omp critical
+            {
+                for (int64_t j = 0; j < mapSize; ++j)
+                {
+                    accum[j] += localAccum[j];
+                }
+            }
+        }
+    }
+    for (int64_t i = 0; i < mapSize; ++i)
+    {
+        m_outColumn[myMap[i].m_ciftiIndex] = accum[i] / mapSize;
+    }
+}
+
 void AlgorithmCiftiCorrelationGradient::init(CiftiFile* input, const float& memLimitGB, const bool& undoFisherInput, const bool& applyFisher,
                                              const bool& covariance, const bool doubleCorr, const bool firstFisher, const bool firstNoDemean, const bool firstCovar)
 {
@@ -61,6 +61,8 @@ namespace caret {
         int64_t m_rowLengthFirst;//for -double-correlation
         bool m_doubleCorr, m_firstCovar, m_firstNoDemean, m_firstFisher;
         float m_memLimitGB;
+        std::vector<float> m_gram;//for fused -double-correlation: sum over all rows of the outer product of first-correlation-normalized rows
+        std::vector<double> m_gramRowSum;
         void cacheRows(const std::vector<int64_t>& ciftiIndices, const int64_t mapSize);//grabs the rows and does whatever it needs to, using as much IO bandwidth and CPU resources as available/needed
         void clearCache();
         const float* getRow(const int& ciftiIndex, float& rootResidSqr, float* scratchStorage);
@@ -72,6 +74,13 @@ namespace caret {
         void processSurfaceComponent(StructureEnum::Enum& myStructure, const float& surfKern, const float& surfExclude, const float& memLimitGB, SurfaceFile* mySurf, const MetricFile* myAreas);
         //void processVolumeComponentLocal(StructureEnum::Enum& myStructure, const float& volKern, const float& memLimitGB);
         void processVolumeComponent(StructureEnum::Enum& myStructure, const float& volKern, const float& memLimitGB);
+        //fused surface path: correlation tiles go straight into the smoothing and gradient stencils, nothing per-structure is materialized but the prepared rows
+        bool canFuse(const int64_t& numRows) const;
+        void computeGram();
+        void prepareFusedRows(const std::vector<int64_t>& ciftiIndices, std::vector<float>& rowsOut, int64_t& dimOut,
+                              std::vector<float>& seedScalesOut, std::vector<float>& targetScalesOut);
+        const float* getFusedSeedRows(const std::vector<float>& preparedRows, const int64_t& dim, const int64_t& start, const int64_t& count, std::vector<float>& storage) const;
+        void processSurfaceComponentFused(StructureEnum::Enum& myStructure, const float& surfKern, SurfaceFile* mySurf, const MetricFile* myAreas);
         void processVolumeComponent(StructureEnum::Enum& myStructure, const float& volKern, const float& volExclude, const float& memLimitGB);
     protected:
         static float getSubAlgorithmWeight();
@@ -158,7 +158,7 @@ AlgorithmCiftiCreateDenseScalar::AlgorithmCiftiCreateDenseScalar(ProgressObject*
                                                                  const MetricFile* leftData, const MetricFile* leftRoi,
                                                                  const MetricFile* rightData, const MetricFile* rightRoi,
                                                                  const MetricFile* cerebData, const MetricFile* cerebRoi,
-                                                                 const vector<AString>* namePtr) : AbstractAlgorithm(myProgObj)
+                                                                 const vector<AString>* namePtr) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     CaretAssert(myCiftiOut != NULL);
     LevelProgress myProgress(myProgObj);
@@ -172,7 +172,7 @@ AlgorithmCiftiCreateDenseTimeseries::AlgorithmCiftiCreateDenseTimeseries(Progres
                                                                          const MetricFile* leftData, const MetricFile* leftRoi,
                                                                          const MetricFile* rightData, const MetricFile* rightRoi,
                                                                          const MetricFile* cerebData, const MetricFile* cerebRoi,
-                                                                         const float& timestep, const float& timestart, const CiftiSeriesMap::Unit& myUnit) : AbstractAlgorithm(myProgObj)
+                                                                         const float& timestep, const float& timestart, const CiftiSeriesMap::Unit& myUnit) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     CaretAssert(myCiftiOut != NULL);
     LevelProgress myProgress(myProgObj);
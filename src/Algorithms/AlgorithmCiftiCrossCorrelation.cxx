@@ -25,15 +25,21 @@
 #include "CaretLogger.h"
 #include "CaretOMP.h"
 #include "CiftiFile.h"
-#include "dot_wrapper.h"
 #include "FileInformation.h"
+#include "SeedCorrelationEngine.h"
 
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    const int64_t B_BLOCK = 1024;//rows of B read and normalized at a time
+}
+
 AString AlgorithmCiftiCrossCorrelation::getCommandSwitch()
 {
     return "-cifti-cross-correlation";
@@ -116,7 +122,7 @@ void AlgorithmCiftiCrossCorrelation::useParameters(OperationParameters* myParams
 }
 
 AlgorithmCiftiCrossCorrelation::AlgorithmCiftiCrossCorrelation(ProgressObject* myProgObj, const CiftiFile* myCiftiA, const CiftiFile* myCiftiB, CiftiFile* myCiftiOut,
-                                                               const vector<float>* weights, const bool& fisherZ, const float& memLimitGB) : AbstractAlgorithm(myProgObj)
+                                                               const vector<float>* weights, const bool& fisherZ, const float& memLimitGB) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     init(myCiftiA, myCiftiB, myCiftiOut, weights);
@@ -128,35 +134,32 @@ AlgorithmCiftiCrossCorrelation::AlgorithmCiftiCrossCorrelation(ProgressObject* m
     {
         chunkSize = numRowsForMem(memLimitGB);
     }
-    vector<vector<float> > outscratch(chunkSize, vector<float>(m_numRowsB));//allocate output rows
+    const int64_t corrLength = getCorrelationLength();
+    vector<float> outscratch(chunkSize * m_numRowsB);//allocate output rows
+    vector<float> blockB(min(B_BLOCK, m_numRowsB) * m_numCols);
     for (int64_t chunkStart = 0; chunkStart < m_numRowsA; chunkStart += chunkSize)
     {
         int64_t chunkEnd = chunkStart + chunkSize;
         if (chunkEnd > m_numRowsA) chunkEnd = m_numRowsA;
         cacheRowsA(chunkStart, chunkEnd);
-        int64_t counter = 0;
-#pragma omp CARET_PARFOR schedule(dynamic)
-        for (int64_t i = 0; i < m_numRowsB; ++i)
+        for (int64_t blockStart = 0; blockStart < m_numRowsB; blockStart += B_BLOCK)
         {
-            float rrsB;
-            int64_t indB;
-            const float* rowB;
-#pragma omp critical
+            const int64_t blockCount = min(B_BLOCK, m_numRowsB - blockStart);
+            for (int64_t i = 0; i < blockCount; ++i)
             {
-                indB = counter;//manually in-order rows because we need to read them from disk, and can't request more than one at a time
-                ++counter;
-                rowB = getRowB(indB, rrsB);
+                m_ciftiB->getRow(blockB.data() + i * m_numCols, blockStart + i);//read in order, never more than one row at a time
             }
-            for (int indA = chunkStart; indA < chunkEnd; ++indA)
+#pragma omp CARET_PARFOR schedule(dynamic)
+            for (int64_t i = 0; i < blockCount; ++i)
             {
-                float rrsA;
-                const float* rowA = getCachedRowA(indA, rrsA);
-                outscratch[indA - chunkStart][indB] = correlate(rowA, rrsA, rowB, rrsB, fisherZ);
+                normalizeRow(blockB.data() + i * m_numCols, m_rowInfoB[blockStart + i]);
             }
+            SeedCorrelationEngine myEngine(blockB.data(), blockCount, corrLength, m_numCols);//rows of B are the seeds, so the output comes out as rows of A
+            myEngine.correlateRows(m_cacheA.data(), chunkEnd - chunkStart, m_numCols, outscratch.data() + blockStart, m_numRowsB, fisherZ);
         }
         for (int64_t indA = chunkStart; indA < chunkEnd; ++indA)
         {
-            myCiftiOut->setRow(outscratch[indA - chunkStart].data(), indA);
+            myCiftiOut->setRow(outscratch.data() + (indA - chunkStart) * m_numRowsB, indA);
         }
     }
 }
@@ -170,7 +173,7 @@ void AlgorithmCiftiCrossCorrelation::init(const CiftiFile* myCiftiA, const Cifti
     m_ciftiA = myCiftiA;
     m_ciftiB = myCiftiB;
     m_ciftiOut = myCiftiOut;
-    m_rowInfoA.resize(m_numRowsA);//calls default constructors, setting m_haveCalculated and m_cacheIndex
+    m_rowInfoA.resize(m_numRowsA);//calls default constructors, setting m_haveCalculated
     m_rowInfoB.resize(m_numRowsB);
     if (weights != NULL)
     {
@@ -212,11 +215,7 @@ int64_t AlgorithmCiftiCrossCorrelation::numRowsForMem(const float& memLimitGB)
     if (m_ciftiOut->isInMemory()) targetBytes -= sizeof(float) * m_numRowsA * m_numRowsB;//count only in-memory output against total, the only time inputs might be in memory is in the GUI
     int64_t bytesPerInputRow = sizeof(float) * m_numCols;//this means we expect the user to give "current free memory" as the limit
     int64_t bytesPerOutputRow = sizeof(float) * m_numRowsB;
-#ifdef CARET_OMP
-    targetBytes -= bytesPerInputRow * omp_get_max_threads();//subtract the temporary row memory
-#else
-    targetBytes -= bytesPerInputRow;
-#endif
+    targetBytes -= bytesPerInputRow * min(B_BLOCK, m_numRowsB);//subtract the block of B rows
     int64_t ret = 1;
     if (targetBytes < 1)
     {
@@ -242,70 +241,13 @@ int64_t AlgorithmCiftiCrossCorrelation::numRowsForMem(const float& memLimitGB)
     return ret;
 }
 
-float AlgorithmCiftiCrossCorrelation::correlate(const float* row1, const float& rrs1, const float* row2, const float& rrs2, const bool& fisherZ)
+int64_t AlgorithmCiftiCrossCorrelation::getCorrelationLength()
 {
-    double r;
     if (m_weightedMode)
     {
-        int numWeights = (int)m_weightIndexes.size();//because we compacted the data in the row to not include any zero weights
-        double accum = dsdot(row1, row2, numWeights);//these have already had the weighted row means subtracted out, and weights applied
-        r = accum / (rrs1 * rrs2);//as do these
-    } else {
-        double accum = dsdot(row1, row2, m_numCols);//these have already had the row means subtracted out
-        r = accum / (rrs1 * rrs2);
-    }
-    if (fisherZ)
-    {
-        if (r > 0.999999) r = 0.999999;//prevent inf
-        if (r < -0.999999) r = -0.999999;//prevent -inf
-        return 0.5 * log((1 + r) / (1 - r));
-    } else {
-        if (r > 1.0) r = 1.0;//don't output anything silly
-        if (r < -1.0) r = -1.0;
-        return r;
+        return (int64_t)m_weightIndexes.size();//because we compacted the data in the row to not include any zero weights
     }
-}
-
-const float* AlgorithmCiftiCrossCorrelation::getCachedRowA(const int64_t& ciftiIndex, float& rootResidSqr)
-{
-    CaretAssertVectorIndex(m_rowInfoA, ciftiIndex);
-    CaretAssert(m_rowInfoA[ciftiIndex].m_cacheIndex != -1);
-    rootResidSqr = m_rowInfoA[ciftiIndex].m_rootResidSqr;
-    return m_rowCacheA[m_rowInfoA[ciftiIndex].m_cacheIndex].m_row.data();
-}
-
-const float* AlgorithmCiftiCrossCorrelation::getRowB(const int64_t& ciftiIndex, float& rootResidSqr)
-{
-    CaretAssertVectorIndex(m_rowInfoB, ciftiIndex);
-    float* ret = getTempRowB();//purely allocation, one array per thread
-    m_ciftiB->getRow(ret, ciftiIndex);
-    adjustRow(ret, m_rowInfoB[ciftiIndex]);
-    rootResidSqr = m_rowInfoB[ciftiIndex].m_rootResidSqr;//NOTE: must do this AFTER adjustRow, because it is not computed before it on the first chunk
-    return ret;
-}
-
-float* AlgorithmCiftiCrossCorrelation::getTempRowB()
-{
-#ifdef CARET_OMP
-    int oldsize = (int)m_tempRowsB.size();
-    int threadNum = omp_get_thread_num();
-    if (threadNum >= oldsize)
-    {
-        m_tempRowsB.resize(threadNum + 1);
-        for (int i = oldsize; i <= threadNum; ++i)
-        {
-            m_tempRowsB[i] = CaretArray<float>(m_numCols);
-        }
-    }
-    return m_tempRowsB[threadNum].getArray();
-#else
-    if (m_tempRowsB.size() == 0)
-    {
-        m_tempRowsB.resize(1);
-        m_tempRowsB[0] = CaretArray<float>(m_numCols);
-    }
-    return m_tempRowsB[0].getArray();
-#endif
+    return m_numCols;
 }
 
 void AlgorithmCiftiCrossCorrelation::cacheRowsA(const int64_t& begin, const int64_t& end)
@@ -313,28 +255,26 @@ void AlgorithmCiftiCrossCorrelation::cacheRowsA(const int64_t& begin, const int6
     CaretAssert(begin > -1);
     CaretAssert(end <= m_numRowsA);
     CaretAssert(begin < end);//takes care of end <= 0 and being >= numrows
-    int64_t cacheSize = (int64_t)m_rowCacheA.size();//clear the existing cache references
-    for (int64_t i = 0; i < cacheSize; ++i)
+    m_cacheA.resize((end - begin) * m_numCols);
+    for (int64_t i = begin; i < end; ++i)
     {
-        m_rowInfoA[m_rowCacheA[i].m_ciftiIndex].m_cacheIndex = -1;
+        m_ciftiA->getRow(m_cacheA.data() + (i - begin) * m_numCols, i);//in order, one at a time
     }
-    m_rowCacheA.resize(end - begin);//set to exactly the size needed
-    int64_t counter = begin;//force in-order row reading via critical and counter
 #pragma omp CARET_PARFOR schedule(dynamic)
     for (int64_t i = begin; i < end; ++i)
     {
-        int64_t myindex;
-#pragma omp critical
-        {
-            myindex = counter;
-            ++counter;
-            m_rowCacheA[myindex - begin].m_row.resize(m_numCols);
-            m_ciftiA->getRow(m_rowCacheA[myindex - begin].m_row.data(), myindex);
-        }
-        CacheRow& myRow = m_rowCacheA[myindex - begin];
-        myRow.m_ciftiIndex = myindex;
-        m_rowInfoA[myindex].m_cacheIndex = myindex - begin;
-        adjustRow(myRow.m_row.data(), m_rowInfoA[myindex]);
+        normalizeRow(m_cacheA.data() + (i - begin) * m_numCols, m_rowInfoA[i]);
+    }
+}
+
+void AlgorithmCiftiCrossCorrelation::normalizeRow(float* row, RowInfo& info)
+{
+    adjustRow(row, info);//these have the (weighted) row means subtracted out, and weights applied
+    const int64_t length = getCorrelationLength();
+    const float scale = 1.0f / info.m_rootResidSqr;//NOTE: must do this AFTER adjustRow, because it is not computed before it on the first chunk
+    for (int64_t i = 0; i < length; ++i)
+    {
+        row[i] *= scale;//constant rows become NaN, same as dividing by zero rrs
     }
 }
 
@@ -23,35 +23,25 @@
 
 #include "AbstractAlgorithm.h"
 
-#include "CaretPointer.h"
-
 #include <vector>
 
 namespace caret {
     
     class AlgorithmCiftiCrossCorrelation : public AbstractAlgorithm
     {
-        struct CacheRow
-        {
-            int m_ciftiIndex;
-            std::vector<float> m_row;
-        };
         struct RowInfo
         {
             bool m_haveCalculated;
             float m_mean, m_rootResidSqr;
-            int m_cacheIndex;
             RowInfo()
             {
                 m_haveCalculated = false;
-                m_cacheIndex = -1;
             }
         };
         int64_t m_numCols, m_numRowsA, m_numRowsB;
         const CiftiFile* m_ciftiA, *m_ciftiB, *m_ciftiOut;//output is really only to check if it is in-memory for numRowsForMem
-        std::vector<CacheRow> m_rowCacheA;//we only cache from cifti A
+        std::vector<float> m_cacheA;//current chunk of A, normalized, m_numCols apart
         std::vector<RowInfo> m_rowInfoA, m_rowInfoB;
-        std::vector<CaretArray<float> > m_tempRowsB;//reuse return values in getRowB instead of reallocating
         std::vector<float> m_weights;
         std::vector<int> m_weightIndexes;
         bool m_binaryWeights, m_weightedMode;
@@ -59,12 +49,10 @@ namespace caret {
         AlgorithmCiftiCrossCorrelation();
         void init(const CiftiFile* myCiftiA, const CiftiFile* myCiftiB, const CiftiFile* myCiftiOut, const std::vector<float>* weights);
         int64_t numRowsForMem(const float& memLimitGB);//call after init()
-        float* getTempRowB();//only used for getRowB, A rows are pulled from cache
-        const float* getCachedRowA(const int64_t& ciftiIndex, float& rootResidSqr);//retrieve already cached rows
-        const float* getRowB(const int64_t& ciftiIndex, float& rootResidSqr);
+        int64_t getCorrelationLength();//compacted length in weighted mode
+        void normalizeRow(float* row, RowInfo& info);//adjustRow, then scale to unit length so that dot products are correlations
         void adjustRow(float* row, RowInfo& info);
-        float correlate(const float* row1, const float& rrs1, const float* row2, const float& rrs2, const bool& fisherZ);
-        void cacheRowsA(const int64_t& begin, const int64_t& end);//grabs the rows and does whatever it needs to, using as much IO bandwidth and CPU resources as available/needed
+        void cacheRowsA(const int64_t& begin, const int64_t& end);//reads the rows in order, then normalizes them in parallel
     protected:
         static float getSubAlgorithmWeight();
         static float getAlgorithmInternalWeight();
@@ -95,7 +95,7 @@ void AlgorithmCiftiLabelModifyKeys::useParameters(OperationParameters* myParams,
     AlgorithmCiftiLabelModifyKeys(myProgObj, ciftiIn, remap, ciftiOut, column);
 }
 
-AlgorithmCiftiLabelModifyKeys::AlgorithmCiftiLabelModifyKeys(ProgressObject* myProgObj, const CiftiFile* ciftiIn, const map<int32_t, int32_t> remap, CiftiFile* ciftiOut, const int column) : AbstractAlgorithm(myProgObj)
+AlgorithmCiftiLabelModifyKeys::AlgorithmCiftiLabelModifyKeys(ProgressObject* myProgObj, const CiftiFile* ciftiIn, const map<int32_t, int32_t> remap, CiftiFile* ciftiOut, const int column) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     const CiftiXML& xmlIn = ciftiIn->getCiftiXML();
@@ -65,7 +65,7 @@ void AlgorithmCiftiLabelProbability::useParameters(OperationParameters* myParams
     AlgorithmCiftiLabelProbability(myProgObj, inputLabel, outputCifti, excludeUnlabeled);
 }
 
-AlgorithmCiftiLabelProbability::AlgorithmCiftiLabelProbability(ProgressObject* myProgObj, const CiftiFile* inputLabel, CiftiFile* outputCifti, const bool& excludeUnlabeled) : AbstractAlgorithm(myProgObj)
+AlgorithmCiftiLabelProbability::AlgorithmCiftiLabelProbability(ProgressObject* myProgObj, const CiftiFile* inputLabel, CiftiFile* outputCifti, const bool& excludeUnlabeled) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     const CiftiXML& inputXML = inputLabel->getCiftiXML();
@@ -100,7 +100,7 @@ void AlgorithmCiftiMergeDense::useParameters(OperationParameters* myParams, Prog
 }
 
 AlgorithmCiftiMergeDense::AlgorithmCiftiMergeDense(ProgressObject* myProgObj, const int& myDir, const vector<const CiftiFile*>& ciftiList, CiftiFile* myCiftiOut,
-                                                   const LabelConflictLogic conflictLogic) : AbstractAlgorithm(myProgObj)
+                                                   const LabelConflictLogic conflictLogic) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     if (ciftiList.size() == 0) throw AlgorithmException("no input files specified");
@@ -22,6 +22,7 @@
 #include "AlgorithmException.h"
 #include "CaretLogger.h"
 #include "CiftiFile.h"
+#include "CiftiParcellationMatrix.h"
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
 #include "MetricFile.h"
@@ -31,6 +32,7 @@
 
 #include <cmath>
 #include <map>
+#include <utility>
 
 using namespace caret;
 using namespace std;
@@ -90,6 +92,10 @@ OperationParameters* AlgorithmCiftiParcellate::getParameters()
     ret->createOptionalParameter(13, "-legacy-mode", "use the old behavior, parcels are defined by the intersection between labels and valid data, and empty parcels are discarded");
     
     ret->createOptionalParameter(10, "-include-empty", "deprecated: now the default behavior");
+    
+    ParameterComponent* additionalOpt = ret->createRepeatableParameter(14, "-additional-parcellation", "also parcellate by another label file, while reading the input only once");
+    additionalOpt->addCiftiParameter(1, "cifti-label", "a cifti label file to use for the additional parcellation");
+    additionalOpt->addCiftiOutputParameter(2, "cifti-out", "output cifti file for the additional parcellation");
 
     ret->setHelpText(
         AString("Each label (other than the unlabeled key) in the cifti label file will be treated as a parcel, and all rows or columns of data within the parcel ") +
@@ -99,7 +105,9 @@ OperationParameters* AlgorithmCiftiParcellate::getParameters()
         "For dtseries or dscalar, use COLUMN.  " +
         "If you are parcellating a dconn in both directions, parcellating by ROW first will use much less memory.\n\n" +
         "The parameter to the -method option must be one of the following:\n\n" + ReductionOperation::getHelpInfo() +
-        "\nThe -*-weights options are mutually exclusive and may only be used with MEAN (default), SUM, STDEV, SAMPSTDEV, VARIANCE, MEDIAN, or MODE (default for label data)."
+        "\nThe -*-weights options are mutually exclusive and may only be used with MEAN (default), SUM, STDEV, SAMPSTDEV, VARIANCE, MEDIAN, or MODE (default for label data).\n\n" +
+        "-additional-parcellation may be repeated, and each instance produces an output as if this command had been run again with its label file.  " +
+        "It may only be used with MEAN or SUM on non-label 2D cifti files, and not with -cifti-weights, -exclude-outliers, -only-numeric, or -nonempty-mask-out."
     );
     return ret;
 }
@@ -161,6 +169,21 @@ void AlgorithmCiftiParcellate::useParameters(OperationParameters* myParams, Prog
     {
         throw AlgorithmException("only one of -spatial-weights and -cifti-weights may be specified");
     }
+    vector<const CiftiFile*> ciftiLabels(1, myCiftiLabel);
+    vector<CiftiFile*> ciftiOuts(1, myCiftiOut);
+    const vector<ParameterComponent*>& additionalInstances = myParams->getRepeatableParameterInstances(14);
+    for (int i = 0; i < (int)additionalInstances.size(); ++i)
+    {
+        ciftiLabels.push_back(additionalInstances[i]->getCifti(1));
+        ciftiOuts.push_back(additionalInstances[i]->getOutputCifti(2));
+    }
+    bool multipleParcellations = (ciftiLabels.size() > 1);
+    if (multipleParcellations)
+    {
+        if (ciftiWeightOpt->m_present) throw AlgorithmException("-cifti-weights may not be used with -additional-parcellation");
+        if (excludeOpt->m_present || onlyNumeric) throw AlgorithmException("-exclude-outliers and -only-numeric may not be used with -additional-parcellation");
+        if (emptyMaskOut != NULL) throw AlgorithmException("-nonempty-mask-out may not be used with -additional-parcellation");
+    }
     if (spatialWeightOpt->m_present)
     {
         if (direction >= myXML.getNumberOfDimensions()) throw AlgorithmException("input cifti file does not have the specified dimension");
@@ -218,6 +241,13 @@ void AlgorithmCiftiParcellate::useParameters(OperationParameters* myParams, Prog
                 *thisWeights = thisStore;
             }
         }
+        if (multipleParcellations)
+        {
+            AlgorithmCiftiParcellate(myProgObj, myCiftiIn, ciftiLabels, direction, ciftiOuts,
+                                     getSpatialWeights(myXML.getBrainModelsMap(direction), leftWeights, rightWeights, cerebWeights),
+                                     method, legacyMode, emptyFillValue);
+            return;
+        }
         AlgorithmCiftiParcellate(myProgObj, myCiftiIn, myCiftiLabel, direction, myCiftiOut,
                                  leftWeights, rightWeights, cerebWeights,
                                  method, excludeLow, excludeHigh, onlyNumeric,
@@ -232,6 +262,12 @@ void AlgorithmCiftiParcellate::useParameters(OperationParameters* myParams, Prog
                                  legacyMode, emptyFillValue, emptyMaskOut);
         return;
     }
+    if (multipleParcellations)
+    {
+        AlgorithmCiftiParcellate(myProgObj, myCiftiIn, ciftiLabels, direction, ciftiOuts, vector<float>(),
+                                 method, legacyMode, emptyFillValue);
+        return;
+    }
     AlgorithmCiftiParcellate(myProgObj, myCiftiIn, myCiftiLabel, direction, myCiftiOut,
                              method, excludeLow, excludeHigh, onlyNumeric,
                              legacyMode, emptyFillValue, emptyMaskOut);
@@ -239,7 +275,7 @@ void AlgorithmCiftiParcellate::useParameters(OperationParameters* myParams, Prog
 
 AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, const CiftiFile* myCiftiIn, const CiftiFile* myCiftiLabel, const int& direction, CiftiFile* myCiftiOut,
                                                    const ReductionEnum::Enum& method, const float& excludeLow, const float& excludeHigh, const bool& onlyNumeric,
-                                                   const bool& legacyMode, const float& emptyFillVal, CiftiFile* emptyMaskOut) : AbstractAlgorithm(myProgObj)
+                                                   const bool& legacyMode, const float& emptyFillVal, CiftiFile* emptyMaskOut) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     CaretAssert(direction >= 0);
@@ -323,6 +359,12 @@ AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, co
     {
         CaretLogWarning(ReductionEnum::toName(method) + " reduction requested while parcellating label data");
     }
+    if (dims.size() == 2 && !isLabel && CiftiParcellationMatrix::isMethodSupported(method) && !onlyNumeric && !(excludeLow > 0.0f && excludeHigh > 0.0f))
+    {//linear reductions give the same result as ReductionOperation with a sparse matrix, applied to blocks of rows in parallel
+        CiftiParcellationMatrix myMatrix(indexToParcel, numParcels);
+        CiftiParcellationMatrix::parcellate(myCiftiIn, direction, vector<const CiftiParcellationMatrix*>(1, &myMatrix), vector<CiftiFile*>(1, myCiftiOut), method, emptyFillVal);
+        return;
+    }
     if (direction == CiftiXML::ALONG_ROW)
     {
         vector<float> scratchOutRow(numParcels);
@@ -520,6 +562,24 @@ namespace
             }
             emptyMaskOut->setColumn(emptyMaskData.data(), 0);
         }
+        if (dims.size() == 2 && !isLabel && CiftiParcellationMatrix::isMethodSupported(method) && !onlyNumeric && !(excludeLow > 0.0f && excludeHigh > 0.0f))
+        {//parcelWeights are in order of increasing index, so put them back in dense order for the matrix
+            vector<float> denseWeights(indexToParcel.size(), 0.0f);
+            vector<int64_t> nextMember(numParcels, 0);
+            for (int64_t j = 0; j < (int64_t)indexToParcel.size(); ++j)
+            {
+                int parcel = indexToParcel[j];
+                if (parcel != -1)
+                {
+                    CaretAssert(nextMember[parcel] < (int64_t)parcelWeights[parcel].size());
+                    denseWeights[j] = parcelWeights[parcel][nextMember[parcel]];
+                    ++nextMember[parcel];
+                }
+            }
+            CiftiParcellationMatrix myMatrix(indexToParcel, numParcels, denseWeights);
+            CiftiParcellationMatrix::parcellate(myCiftiIn, direction, vector<const CiftiParcellationMatrix*>(1, &myMatrix), vector<CiftiFile*>(1, myCiftiOut), method, emptyFillVal);
+            return;
+        }
         int64_t numCols = myInputXML.getDimensionLength(CiftiXML::ALONG_ROW);
         vector<float> scratchRow(numCols);
         if (direction == CiftiXML::ALONG_ROW)
@@ -677,7 +737,7 @@ namespace
 AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, const CiftiFile* myCiftiIn, const CiftiFile* myCiftiLabel, const int& direction, CiftiFile* myCiftiOut,
                                                    const MetricFile* leftWeights, const MetricFile* rightWeights, const MetricFile* cerebWeights, const ReductionEnum::Enum& method,
                                                    const float& excludeLow, const float& excludeHigh, const bool& onlyNumeric,
-                                                   const bool& legacyMode, const float& emptyFillVal, CiftiFile* emptyMaskOut): AbstractAlgorithm(myProgObj)
+                                                   const bool& legacyMode, const float& emptyFillVal, CiftiFile* emptyMaskOut): AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     CaretAssert(direction >= 0);
@@ -697,42 +757,14 @@ AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, co
     }
     const CiftiBrainModelsMap& inputDense = myInputXML.getBrainModelsMap(direction);
     const CiftiBrainModelsMap& labelDense = myLabelXML.getBrainModelsMap(CiftiXML::ALONG_COLUMN);
-    float voxelVolume = 1.0f;
     if (inputDense.hasVolumeData())
     {//don't check volume space if direction doesn't have volume data
         if (labelDense.hasVolumeData() && !inputDense.getVolumeSpace().matches(labelDense.getVolumeSpace()))
         {
             throw AlgorithmException("input cifti files must have the same volume space");
         }
-        Vector3D ivec, jvec, kvec, origin;//compute the volume of a voxel in case a parcel spans both surface and volume
-        inputDense.getVolumeSpace().getSpacingVectors(ivec, jvec, kvec, origin);
-        voxelVolume = abs(ivec.dot(jvec.cross(kvec)));
-    }
-    vector<StructureEnum::Enum> surfStructs = inputDense.getSurfaceStructureList();
-    for (int i = 0; i < (int)surfStructs.size(); ++i)
-    {
-        const MetricFile* toCheck = NULL;
-        switch (surfStructs[i])
-        {
-            case StructureEnum::CORTEX_LEFT:
-                toCheck = leftWeights;
-                break;
-            case StructureEnum::CORTEX_RIGHT:
-                toCheck = rightWeights;
-                break;
-            case StructureEnum::CEREBELLUM:
-                toCheck = cerebWeights;
-                break;
-            default:
-                throw AlgorithmException("unsupported surface structure: " + StructureEnum::toName(surfStructs[i]));
-        }
-        if (toCheck == NULL) throw AlgorithmException("weight metric required but not provided for structure " + StructureEnum::toName(surfStructs[i]));
-        if (toCheck->getNumberOfNodes() != inputDense.getSurfaceNumberOfNodes(surfStructs[i]))
-        {
-            throw AlgorithmException("weight metric has incorrect number of vertices for structure " + StructureEnum::toName(surfStructs[i]));
-        }
-        checkStructureMatch(toCheck, surfStructs[i], "weight metric", "it is provided as the argument for");
     }
+    vector<float> denseWeights = getSpatialWeights(inputDense, leftWeights, rightWeights, cerebWeights);
     vector<int> indexToParcel;
     CiftiXML myOutXML = myInputXML;
     CiftiParcelsMap outParcelMap = parcellateMapping(myCiftiLabel, inputDense, indexToParcel, legacyMode);
@@ -749,28 +781,7 @@ AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, co
         int parcel = indexToParcel[j];
         if (parcel != -1)
         {
-            const CiftiBrainModelsMap::IndexInfo myDenseInfo = inputDense.getInfoForIndex(j);
-            if (myDenseInfo.m_type == CiftiBrainModelsMap::VOXELS)
-            {
-                parcelWeights[parcel].push_back(voxelVolume);
-            } else {
-                const MetricFile* toUse = NULL;
-                switch (myDenseInfo.m_structure)
-                {
-                    case StructureEnum::CORTEX_LEFT:
-                        toUse = leftWeights;
-                        break;
-                    case StructureEnum::CORTEX_RIGHT:
-                        toUse = rightWeights;
-                        break;
-                    case StructureEnum::CEREBELLUM:
-                        toUse = cerebWeights;
-                        break;
-                    default:
-                        CaretAssert(0);
-                }
-                parcelWeights[parcel].push_back(toUse->getValue(myDenseInfo.m_surfaceNode, 0));
-            }
+            parcelWeights[parcel].push_back(denseWeights[j]);
         }
     }
     doWeightedParcellation(myCiftiIn, direction, myCiftiOut, indexToParcel, parcelWeights, method, excludeLow, excludeHigh, onlyNumeric, emptyFillVal, emptyMaskOut);
@@ -778,7 +789,7 @@ AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, co
 
 AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, const CiftiFile* myCiftiIn, const CiftiFile* myCiftiLabel, const int& direction, CiftiFile* myCiftiOut,
                                                    const CiftiFile* ciftiWeights, const ReductionEnum::Enum& method, const float& excludeLow, const float& excludeHigh, const bool& onlyNumeric,
-                                                   const bool& legacyMode, const float& emptyFillVal, CiftiFile* emptyMaskOut): AbstractAlgorithm(myProgObj)
+                                                   const bool& legacyMode, const float& emptyFillVal, CiftiFile* emptyMaskOut): AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     CaretAssert(direction >= 0);
@@ -865,6 +876,125 @@ AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, co
     doWeightedParcellation(myCiftiIn, direction, myCiftiOut, indexToParcel, parcelWeights, method, excludeLow, excludeHigh, onlyNumeric, emptyFillVal, emptyMaskOut);
 }
 
+AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, const CiftiFile* myCiftiIn, const vector<const CiftiFile*>& ciftiLabels, const int& direction,
+                                                   const vector<CiftiFile*>& ciftiOuts, const vector<float>& denseWeights, const ReductionEnum::Enum& method,
+                                                   const bool& legacyMode, const float& emptyFillVal): AbstractAlgorithm(myProgObj, getCommandSwitch())
+{
+    LevelProgress myProgress(myProgObj);
+    CaretAssert(direction >= 0);
+    if (ciftiLabels.size() != ciftiOuts.size()) throw AlgorithmException("number of label files and output files must match");
+    if (ciftiLabels.empty()) throw AlgorithmException("no label files specified");
+    const CiftiXML& myInputXML = myCiftiIn->getCiftiXML();
+    vector<int64_t> dims = myInputXML.getDimensions();
+    if (direction >= (int)dims.size()) throw AlgorithmException("specified direction doesn't exist in input file");
+    if (dims.size() != 2) throw AlgorithmException("multiple parcellations in one pass require a 2D input cifti file");
+    if (myInputXML.getMappingType(direction) != CiftiMappingType::BRAIN_MODELS)
+    {
+        throw AlgorithmException("input cifti file does not have brain models mapping type in specified direction");
+    }
+    for (int i = 0; i < (int)dims.size(); ++i)
+    {
+        if (myInputXML.getMappingType(i) == CiftiMappingType::LABELS)
+        {
+            throw AlgorithmException("multiple parcellations in one pass do not support label data");
+        }
+    }
+    if (!CiftiParcellationMatrix::isMethodSupported(method))
+    {
+        throw AlgorithmException(ReductionEnum::toName(method) + " reduction is not supported with multiple parcellations in one pass, use MEAN or SUM");
+    }
+    const CiftiBrainModelsMap& inputDense = myInputXML.getBrainModelsMap(direction);
+    if (!denseWeights.empty() && (int64_t)denseWeights.size() != inputDense.getLength())
+    {
+        throw AlgorithmException("weights have the wrong number of elements for the input cifti file");
+    }
+    vector<CiftiParcellationMatrix> matrices;//compile all parcellations first, so that errors happen before reading any data
+    matrices.reserve(ciftiLabels.size());
+    for (int i = 0; i < (int)ciftiLabels.size(); ++i)
+    {
+        vector<int> indexToParcel;
+        CiftiParcelsMap outParcelMap = parcellateMapping(ciftiLabels[i], inputDense, indexToParcel, legacyMode);//checks label file mappings and volume space
+        int numParcels = outParcelMap.getLength();
+        if (numParcels < 1)
+        {
+            throw AlgorithmException("no parcels found in label file " + AString::number(i + 1) + ", output file would be empty, aborting");
+        }
+        CiftiXML myOutXML = myInputXML;
+        myOutXML.setMap(direction, outParcelMap);
+        ciftiOuts[i]->setCiftiXML(myOutXML);
+        matrices.push_back(CiftiParcellationMatrix(indexToParcel, numParcels, denseWeights));
+    }
+    vector<const CiftiParcellationMatrix*> matrixPointers;
+    for (int i = 0; i < (int)matrices.size(); ++i)
+    {
+        matrixPointers.push_back(&(matrices[i]));
+    }
+    CiftiParcellationMatrix::parcellate(myCiftiIn, direction, matrixPointers, ciftiOuts, method, emptyFillVal);
+}
+
+vector<float> AlgorithmCiftiParcellate::getSpatialWeights(const CiftiBrainModelsMap& toParcellate, const MetricFile* leftWeights, const MetricFile* rightWeights, const MetricFile* cerebWeights)
+{
+    float voxelVolume = 1.0f;
+    if (toParcellate.hasVolumeData())
+    {
+        Vector3D ivec, jvec, kvec, origin;//compute the volume of a voxel in case a parcel spans both surface and volume
+        toParcellate.getVolumeSpace().getSpacingVectors(ivec, jvec, kvec, origin);
+        voxelVolume = abs(ivec.dot(jvec.cross(kvec)));
+    }
+    vector<StructureEnum::Enum> surfStructs = toParcellate.getSurfaceStructureList();
+    for (int i = 0; i < (int)surfStructs.size(); ++i)
+    {
+        const MetricFile* toCheck = NULL;
+        switch (surfStructs[i])
+        {
+            case StructureEnum::CORTEX_LEFT:
+                toCheck = leftWeights;
+                break;
+            case StructureEnum::CORTEX_RIGHT:
+                toCheck = rightWeights;
+                break;
+            case StructureEnum::CEREBELLUM:
+                toCheck = cerebWeights;
+                break;
+            default:
+                throw AlgorithmException("unsupported surface structure: " + StructureEnum::toName(surfStructs[i]));
+        }
+        if (toCheck == NULL) throw AlgorithmException("weight metric required but not provided for structure " + StructureEnum::toName(surfStructs[i]));
+        if (toCheck->getNumberOfNodes() != toParcellate.getSurfaceNumberOfNodes(surfStructs[i]))
+        {
+            throw AlgorithmException("weight metric has incorrect number of vertices for structure " + StructureEnum::toName(surfStructs[i]));
+        }
+        checkStructureMatch(toCheck, surfStructs[i], "weight metric", "it is provided as the argument for");
+    }
+    vector<float> ret(toParcellate.getLength());
+    for (int64_t j = 0; j < (int64_t)ret.size(); ++j)
+    {
+        const CiftiBrainModelsMap::IndexInfo myDenseInfo = toParcellate.getInfoForIndex(j);
+        if (myDenseInfo.m_type == CiftiBrainModelsMap::VOXELS)
+        {
+            ret[j] = voxelVolume;
+        } else {
+            const MetricFile* toUse = NULL;
+            switch (myDenseInfo.m_structure)
+            {
+                case StructureEnum::CORTEX_LEFT:
+                    toUse = leftWeights;
+                    break;
+                case StructureEnum::CORTEX_RIGHT:
+                    toUse = rightWeights;
+                    break;
+                case StructureEnum::CEREBELLUM:
+                    toUse = cerebWeights;
+                    break;
+                default:
+                    CaretAssert(0);
+            }
+            ret[j] = toUse->getValue(myDenseInfo.m_surfaceNode, 0);
+        }
+    }
+    return ret;
+}
+
 CiftiParcelsMap AlgorithmCiftiParcellate::parcellateMapping(const CiftiFile* myCiftiLabel, const CiftiBrainModelsMap& toParcellate, vector<int>& indexToParcelOut, const bool& legacyMode)
 {
     const CiftiXML& myLabelXML = myCiftiLabel->getCiftiXML();
@@ -939,6 +1069,7 @@ CiftiParcelsMap AlgorithmCiftiParcellate::parcellateMapping(const CiftiFile* myC
             }
         }
         const vector<CiftiBrainModelsMap::VolumeMap> labelVolMap = labelDenseMap.getFullVolumeMap();
+        vector<vector<VoxelIJK> > parcelVoxels(parcelList.size());//voxels from different structures interleave, so collect them and sort once
         for (int64_t i = 0; i < (int64_t)labelVolMap.size(); ++i)
         {
             int labelKey = (int)floor(labelData[labelVolMap[i].m_ciftiIndex] + 0.5f);
@@ -946,7 +1077,7 @@ CiftiParcelsMap AlgorithmCiftiParcellate::parcellateMapping(const CiftiFile* myC
             if (found != keyToParcel.end())
             {
                 int32_t whichParcel = found->second;
-                parcelList[whichParcel].m_voxelIndices.insert(labelVolMap[i].m_ijk);
+                parcelVoxels[whichParcel].push_back(VoxelIJK(labelVolMap[i].m_ijk));
                 int64_t dataIndex = toParcellate.getIndexForVoxel(labelVolMap[i].m_ijk);
                 if (dataIndex < 0)
                 {
@@ -958,6 +1089,7 @@ CiftiParcelsMap AlgorithmCiftiParcellate::parcellateMapping(const CiftiFile* myC
         }
         for (int i = 0; i < (int)parcelList.size(); ++i)
         {
+            parcelList[i].m_voxelIndices.assign(std::move(parcelVoxels[i]));
             ret.addParcel(parcelList[i]);
         }
     } else {//legacy mode: parcels are defined by overlap between labels and the data ROI, any parcels that don't overlap any data are discarded
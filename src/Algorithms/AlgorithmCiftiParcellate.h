@@ -49,6 +49,11 @@ namespace caret {
                                  const CiftiFile* ciftiWeights, const ReductionEnum::Enum& method = ReductionEnum::MEAN,
                                  const float& excludeLow = -1.0f, const float& excludeHigh = -1.0f, const bool& onlyNumeric = false,
                                  const bool& legacyMode = false, const float& emptyFillVal = 0.0f, CiftiFile* emptyMaskOut = NULL);
+        ///parcellate by several label files while reading the input only once, MEAN or SUM only, denseWeights may be empty for unweighted
+        AlgorithmCiftiParcellate(ProgressObject* myProgObj, const CiftiFile* myCiftiIn, const std::vector<const CiftiFile*>& ciftiLabels, const int& direction,
+                                 const std::vector<CiftiFile*>& ciftiOuts, const std::vector<float>& denseWeights = std::vector<float>(),
+                                 const ReductionEnum::Enum& method = ReductionEnum::MEAN, const bool& legacyMode = false, const float& emptyFillVal = 0.0f);
+        static std::vector<float> getSpatialWeights(const CiftiBrainModelsMap& toParcellate, const MetricFile* leftWeights, const MetricFile* rightWeights, const MetricFile* cerebWeights);
         static CiftiParcelsMap parcellateMapping(const CiftiFile* myCiftiLabel, const CiftiBrainModelsMap& toParcellate, std::vector<int>& indexToParcelOut, const bool& legacyMode = false);
         static OperationParameters* getParameters();
         static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
@@ -23,6 +23,7 @@
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "CiftiFile.h"
+#include "CiftiRowPipeline.h"
 #include "MultiDimIterator.h"
 #include "ReductionOperation.h"
 
@@ -93,7 +94,7 @@ void AlgorithmCiftiReduce::useParameters(OperationParameters* myParams, Progress
 }
 
 AlgorithmCiftiReduce::AlgorithmCiftiReduce(ProgressObject* myProgObj, const CiftiFile* ciftiIn, const ReductionEnum::Enum& myReduce, CiftiFile* ciftiOut,
-                                           const bool& onlyNumeric, const int& direction) : AbstractAlgorithm(myProgObj)
+                                           const bool& onlyNumeric, const int& direction) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     CaretAssert(direction >= 0);
@@ -112,19 +113,20 @@ AlgorithmCiftiReduce::AlgorithmCiftiReduce(ProgressObject* myProgObj, const Cift
         {
             CaretLogWarning("-cifti-reduce is being used for a length=1 reduction on file '" + ciftiIn->getFileName() + "'");
         }
-        vector<float> scratchInRow(inDims[0]);
-        for (MultiDimIterator<int64_t> iter(vector<int64_t>(inDims.begin() + 1, inDims.end())); !iter.atEnd(); ++iter)
-        {// + 1 to exclude row dimension, because getRow/setRow
-            ciftiIn->getRow(scratchInRow.data(), *iter);
-            float result = -1;
-            if (onlyNumeric)
+        CiftiRowPipeline myPipeline(vector<const CiftiFile*>(1, ciftiIn), ciftiOut);
+        myPipeline.run([&](const CiftiRowBlock& block)
+        {
+            for (int64_t r = 0; r < block.getNumberOfRows(); ++r)
             {
-                result = ReductionOperation::reduceOnlyNumeric(scratchInRow.data(), inDims[0], myReduce);
-            } else {
-                result = ReductionOperation::reduce(scratchInRow.data(), inDims[0], myReduce);
+                float* result = block.getOutputRow(r);//if reducing along row, length of output row is 1
+                if (onlyNumeric)
+                {
+                    *result = ReductionOperation::reduceOnlyNumeric(block.getInputRow(0, r), inDims[0], myReduce);
+                } else {
+                    *result = ReductionOperation::reduce(block.getInputRow(0, r), inDims[0], myReduce);
+                }
             }
-            ciftiOut->setRow(&result, *iter);//if reducing along row, length of output row is 1
-        }
+        });
     } else {
         if (inDims[direction] == 1)
         {
@@ -164,7 +166,7 @@ AlgorithmCiftiReduce::AlgorithmCiftiReduce(ProgressObject* myProgObj, const Cift
 }
 
 AlgorithmCiftiReduce::AlgorithmCiftiReduce(ProgressObject* myProgObj, const CiftiFile* ciftiIn, const ReductionEnum::Enum& myReduce, CiftiFile* ciftiOut,
-                                           const float& sigmaBelow, const float& sigmaAbove, const int& direction) : AbstractAlgorithm(myProgObj)
+                                           const float& sigmaBelow, const float& sigmaAbove, const int& direction) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     CaretAssert(direction >= 0);
@@ -179,13 +181,14 @@ AlgorithmCiftiReduce::AlgorithmCiftiReduce(ProgressObject* myProgObj, const Cift
     vector<int64_t> inDims = inputXML.getDimensions();
     if (direction == CiftiXML::ALONG_ROW)
     {
-        vector<float> scratchInRow(inDims[0]);
-        for (MultiDimIterator<int64_t> iter(vector<int64_t>(inDims.begin() + 1, inDims.end())); !iter.atEnd(); ++iter)
-        {// + 1 to exclude row dimension, because getRow/setRow
-            ciftiIn->getRow(scratchInRow.data(), *iter);
-            float result = ReductionOperation::reduceExcludeDev(scratchInRow.data(), inDims[0], myReduce, sigmaBelow, sigmaAbove);
-            ciftiOut->setRow(&result, *iter);//if reducing along row, length of output row is 1
-        }
+        CiftiRowPipeline myPipeline(vector<const CiftiFile*>(1, ciftiIn), ciftiOut);
+        myPipeline.run([&](const CiftiRowBlock& block)
+        {
+            for (int64_t r = 0; r < block.getNumberOfRows(); ++r)
+            {//if reducing along row, length of output row is 1
+                *(block.getOutputRow(r)) = ReductionOperation::reduceExcludeDev(block.getInputRow(0, r), inDims[0], myReduce, sigmaBelow, sigmaAbove);
+            }
+        });
     } else {
         vector<vector<float> > scratchInRows(inDims[direction], vector<float>(inDims[0]));
         vector<float> outRow(inDims[0]), reduceScratch(inDims[direction]);//reduction isn't along row, so out rows will be same length as in rows
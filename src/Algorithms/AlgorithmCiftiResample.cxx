@@ -32,6 +32,7 @@
 #include "CiftiFile.h"
 #include "LabelFile.h"
 #include "MetricFile.h"
+#include "ResamplePlan.h"
 #include "SurfaceFile.h"
 #include "SurfaceResamplingHelper.h"
 #include "VolumeFile.h"
@@ -132,6 +133,9 @@ OperationParameters* AlgorithmCiftiResample::getParameters()
             cerebAreaMetricsOpt->addMetricParameter(1, "current-area", "a metric file with vertex areas for the current mesh");
             cerebAreaMetricsOpt->addMetricParameter(2, "new-area", "a metric file with vertex areas for the new mesh");
     
+    OptionalParameter* planOpt = ret->createOptionalParameter(16, "-surface-plan", "use precomputed surface resampling weights");
+        planOpt->addStringParameter(1, "plan-file", "a plan from -resample-plan-create, made with -cifti-rois from a file with the same brainordinates as <cifti-in>");
+    
     AString myHelpText =
         AString("Resample cifti data to a different brainordinate space.  Use COLUMN for the direction to resample dscalar, dlabel, or dtseries.  ") +
         "Resampling both dimensions of a dconn requires running this command twice, once with COLUMN and once with ROW.  " +
@@ -140,7 +144,9 @@ OperationParameters* AlgorithmCiftiResample::getParameters()
         "If spheres are not specified for a surface structure which exists in the cifti files, its data is copied without resampling or dilation.  " +
         "Dilation is done with the 'nearest' method, and is done on <new-sphere> for surface data.  " +
         "Volume components are padded before dilation so that dilation doesn't run into the edge of the component bounding box.  " +
-        "If neither -affine nor -warpfield are specified, the identity transform is assumed for the volume data.\n\n" +
+        "If neither -affine nor -warpfield are specified, the identity transform is assumed for the volume data.  " +
+        "The -surface-plan option skips computing the surface resampling weights, the plan must have weights for every resampled surface structure, " +
+        "made from the same spheres, method, and areas, and with the cifti vertices as the current roi.\n\n" +
         "The recommended resampling methods are ADAP_BARY_AREA and CUBIC (cubic spline), except for label data which should use ADAP_BARY_AREA and ENCLOSING_VOXEL.  " +
         "Using ADAP_BARY_AREA requires specifying an area option to each used -*-spheres option.\n\n" +
         "The <volume-method> argument must be one of the following:\n\n" +
@@ -407,19 +413,27 @@ void AlgorithmCiftiResample::useParameters(OperationParameters* myParams, Progre
             newCerebAreas = cerebAreaMetricsOpt->getMetric(2);
         }
     }
+    ResamplePlan myPlan;
+    ResamplePlan* planPtr = NULL;
+    OptionalParameter* planOpt = myParams->getOptionalParameter(16);
+    if (planOpt->m_present)
+    {
+        myPlan.readFile(planOpt->getString(1));
+        planPtr = &myPlan;
+    }
     if (warpfieldOpt->m_present)
     {
         AlgorithmCiftiResample(myProgObj, myCiftiIn, direction, myTemplate, templateDir, mySurfMethod, myVolMethod, myCiftiOut, surfLargest, voldilatemm, surfdilatemm, myWarpfield.getWarpfield(),
                                curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
                                curRightSphere, newRightSphere, curRightAreas, newRightAreas,
                                curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas,
-                               volDilateMethod, volDilateExponent, surfDilateMethod, surfDilateExponent, volLegacyCutoff, surfLegacyCutoff);
+                               volDilateMethod, volDilateExponent, surfDilateMethod, surfDilateExponent, volLegacyCutoff, surfLegacyCutoff, planPtr);
     } else {//rely on AffineFile() being the identity transform for if neither option is specified
         AlgorithmCiftiResample(myProgObj, myCiftiIn, direction, myTemplate, templateDir, mySurfMethod, myVolMethod, myCiftiOut, surfLargest, voldilatemm, surfdilatemm, myAffine.getMatrix(),
                                curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
                                curRightSphere, newRightSphere, curRightAreas, newRightAreas,
                                curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas,
-                               volDilateMethod, volDilateExponent, surfDilateMethod, surfDilateExponent, volLegacyCutoff, surfLegacyCutoff);
+                               volDilateMethod, volDilateExponent, surfDilateMethod, surfDilateExponent, volLegacyCutoff, surfLegacyCutoff, planPtr);
     }
 }
 
@@ -525,7 +539,8 @@ namespace
                             const SurfaceResamplingMethodEnum::Enum& mySurfMethod, const float& voldilatemm, const FloatMatrix* affine, const VolumeFile* warpfield,
                             const SurfaceFile* curLeftSphere, const SurfaceFile* newLeftSphere, const MetricFile* curLeftAreas, const MetricFile* newLeftAreas,
                             const SurfaceFile* curRightSphere, const SurfaceFile* newRightSphere, const MetricFile* curRightAreas, const MetricFile* newRightAreas,
-                            const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas)
+                            const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas,
+                            const ResamplePlan* plan)
     {
         const CiftiXML& myInputXML = myCiftiIn->getCiftiXML(), &myOutXML = myCiftiOut->getCiftiXML();
         bool labelMode = (myInputXML.getMappingType(CiftiXML::ALONG_COLUMN) == CiftiMappingType::LABELS);
@@ -583,7 +598,14 @@ namespace
             {
                 tempRoi[myCache.inSurfMap[j].m_surfaceNode] = 1.0f;
             }
-            myCache.surfResamp = SurfaceResamplingHelper(mySurfMethod, curSphere, newSphere, curAreasPtr, newAreasPtr, tempRoi.data());//resampling is already a helper, so use it as such
+            if (plan != NULL)
+            {
+                const SurfaceResamplingHelper* planWeights = plan->getSurfaceWeights(ResamplePlan::surfaceKey(mySurfMethod, curSphere, newSphere, curAreasPtr, newAreasPtr, tempRoi.data()));
+                if (planWeights == NULL) throw AlgorithmException("resample plan has no weights for " + StructureEnum::toGuiName(surfList[i]) + " with these spheres, method, areas, and cifti vertices");
+                myCache.surfResamp = *planWeights;
+            } else {
+                myCache.surfResamp = SurfaceResamplingHelper(mySurfMethod, curSphere, newSphere, curAreasPtr, newAreasPtr, tempRoi.data());//resampling is already a helper, so use it as such
+            }
             tempRoi.resize(newSphere->getNumberOfNodes());
             myCache.surfResamp.getResampleValidROI(tempRoi.data());
             myCache.surfDilateRoi.setNumberOfNodesAndColumns(newSphere->getNumberOfNodes(), 1);
@@ -880,7 +902,7 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
                                                const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas,
                                                const AlgorithmVolumeDilate::Method& volDilateMethod, const float& volDilateExponent,
                                                const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent,
-                                               const bool volLegacyCutoff, const bool surfLegacyCutoff) : AbstractAlgorithm(myProgObj)
+                                               const bool volLegacyCutoff, const bool surfLegacyCutoff, const ResamplePlan* plan) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     pair<bool, AString> myError = checkForErrors(myCiftiIn, direction, myTemplate, templateDir, mySurfMethod,
@@ -924,7 +946,7 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
                     throw AlgorithmException("unsupported surface structure: " + StructureEnum::toGuiName(surfList[i]));
                     break;
             }
-            processSurfaceComponent(myCiftiIn, direction, surfList[i], mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent, surfLegacyCutoff);
+            processSurfaceComponent(myCiftiIn, direction, surfList[i], mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent, surfLegacyCutoff, plan);
         }
         for (int i = 0; i < (int)volList.size(); ++i)
         {
@@ -948,7 +970,7 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
         setupRowResampling(surfCache, volCache, myCiftiIn, myCiftiOut, mySurfMethod, voldilatemm, NULL, warpfield,
                            curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
                            curRightSphere, newRightSphere, curRightAreas, newRightAreas,
-                           curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas);
+                           curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas, plan);
         int64_t numRows = myInputXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
         vector<float> inRow(myInputXML.getDimensionLength(CiftiXML::ALONG_ROW)), outRow(myOutXML.getDimensionLength(CiftiXML::ALONG_ROW));
         for (int64_t row = 0; row < numRows; ++row)
@@ -980,7 +1002,7 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
                                                const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas,
                                                const AlgorithmVolumeDilate::Method& volDilateMethod, const float& volDilateExponent,
                                                const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent,
-                                               const bool volLegacyCutoff, const bool surfLegacyCutoff) : AbstractAlgorithm(myProgObj)
+                                               const bool volLegacyCutoff, const bool surfLegacyCutoff, const ResamplePlan* plan) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     pair<bool, AString> myError = checkForErrors(myCiftiIn, direction, myTemplate, templateDir, mySurfMethod,
@@ -1024,7 +1046,7 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
                     throw AlgorithmException("unsupported surface structure: " + StructureEnum::toGuiName(surfList[i]));
                     break;
             }
-            processSurfaceComponent(myCiftiIn, direction, surfList[i], mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent, surfLegacyCutoff);
+            processSurfaceComponent(myCiftiIn, direction, surfList[i], mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent, surfLegacyCutoff, plan);
         }
         for (int i = 0; i < (int)volList.size(); ++i)
         {
@@ -1048,7 +1070,7 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
         setupRowResampling(surfCache, volCache, myCiftiIn, myCiftiOut, mySurfMethod, voldilatemm, &affine, NULL,
                            curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
                            curRightSphere, newRightSphere, curRightAreas, newRightAreas,
-                           curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas);
+                           curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas, plan);
         int64_t numRows = myInputXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
         vector<float> inRow(myInputXML.getDimensionLength(CiftiXML::ALONG_ROW)), outRow(myOutXML.getDimensionLength(CiftiXML::ALONG_ROW));
         for (int64_t row = 0; row < numRows; ++row)
@@ -1074,7 +1096,8 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
 void AlgorithmCiftiResample::processSurfaceComponent(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const SurfaceResamplingMethodEnum::Enum& mySurfMethod,
                                                      CiftiFile* myCiftiOut, const bool& surfLargest, const float& surfdilatemm, const SurfaceFile* curSphere, const SurfaceFile* newSphere,
                                                      const MetricFile* curAreas, const MetricFile* newAreas,
-                                                     const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent, const bool surfLegacyCutoff)
+                                                     const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent, const bool surfLegacyCutoff,
+                                                     const ResamplePlan* plan)
 {
     const CiftiXML& myInputXML = myCiftiIn->getCiftiXML();
     if (myInputXML.getMappingType(1 - direction) == CiftiMappingType::LABELS)
@@ -1085,7 +1108,7 @@ void AlgorithmCiftiResample::processSurfaceComponent(const CiftiFile* myCiftiIn,
         LabelFile newLabel, newDilate, *newUse = &newLabel;
         if (curSphere != NULL)
         {
-            AlgorithmLabelResample(NULL, &origLabel, curSphere, newSphere, mySurfMethod, &newLabel, curAreas, newAreas, &origRoi, &resampleROI, surfLargest);
+            AlgorithmLabelResample(NULL, &origLabel, curSphere, newSphere, mySurfMethod, &newLabel, curAreas, newAreas, &origRoi, &resampleROI, surfLargest, plan);
             origLabel.clear();//delete the data we no longer need to keep memory use down
             if (surfdilatemm > 0.0f)
             {
@@ -1110,7 +1133,7 @@ void AlgorithmCiftiResample::processSurfaceComponent(const CiftiFile* myCiftiIn,
         MetricFile newMetric, newDilate, resampleROI, *newUse = &newMetric;
         if (curSphere != NULL)
         {
-            AlgorithmMetricResample(NULL, &origMetric, curSphere, newSphere, mySurfMethod, &newMetric, curAreas, newAreas, &origROI, &resampleROI, surfLargest);
+            AlgorithmMetricResample(NULL, &origMetric, curSphere, newSphere, mySurfMethod, &newMetric, curAreas, newAreas, &origROI, &resampleROI, surfLargest, plan);
             origMetric.clear();//ditto
             if (surfdilatemm > 0.0f)
             {
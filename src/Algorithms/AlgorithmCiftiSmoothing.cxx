@@ -20,20 +20,26 @@
 
 #include "AlgorithmCiftiSmoothing.h"
 #include "AlgorithmException.h"
-#include "AlgorithmMetricSmoothing.h"
 #include "AlgorithmVolumeSmoothing.h"
+#include "CaretPointer.h"
 #include "CiftiFile.h"
+#include "CiftiStructureView.h"
 #include "MetricFile.h"
+#include "MetricSmoothingObject.h"
 #include "VolumeFile.h"
 #include "SurfaceFile.h"
-#include "AlgorithmCiftiSeparate.h"
-#include "AlgorithmCiftiReplaceStructure.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    const int64_t VOLUME_BLOCK_BYTES = 128 * 1024 * 1024;//per cropped volume block given to the volume kernel
+}
+
 AString AlgorithmCiftiSmoothing::getCommandSwitch()
 {
     return "-cifti-smoothing";
@@ -164,7 +170,7 @@ void AlgorithmCiftiSmoothing::useParameters(OperationParameters* myParams, Progr
 AlgorithmCiftiSmoothing::AlgorithmCiftiSmoothing(ProgressObject* myProgObj, const CiftiFile* myCifti, const float& surfKern, const float& volKern, const int& myDir, CiftiFile* myCiftiOut,
                                                  const SurfaceFile* myLeftSurf, const SurfaceFile* myRightSurf, const SurfaceFile* myCerebSurf,
                                                  const CiftiFile* roiCifti, bool fixZerosVol, bool fixZerosSurf,
-                                                 const MetricFile* myLeftAreas, const MetricFile* myRightAreas, const MetricFile* myCerebAreas, const bool& mergedVolume) : AbstractAlgorithm(myProgObj)
+                                                 const MetricFile* myLeftAreas, const MetricFile* myRightAreas, const MetricFile* myCerebAreas, const bool& mergedVolume) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     if (!(surfKern > 0.0f) && !(volKern > 0.0f)) throw AlgorithmException("zero smoothing kernels requested for both volume and surface");
@@ -235,6 +241,18 @@ AlgorithmCiftiSmoothing::AlgorithmCiftiSmoothing(ProgressObject* myProgObj, cons
         }
     }
     myCiftiOut->setCiftiXML(myXML);
+    const CiftiBrainModelsMap& myBrainMap = myCifti->getCiftiXML().getBrainModelsMap(myDir);
+    vector<float> roiMap;
+    if (roiCifti != NULL)
+    {//due to above testing, we know the structure mask is the same, so the views of the input also apply to the roi
+        roiMap.resize(roiCifti->getNumberOfRows());
+        roiCifti->getColumn(roiMap.data(), 0);
+    }
+    //structure views read and write the cifti maps directly, rather than separating each structure into a metric or volume and replacing it back
+    vector<CaretPointer<CiftiStructureView> > surfViews(surfaceList.size());
+    vector<CaretPointer<MetricSmoothingObject> > surfSmoothers(surfaceList.size());
+    vector<vector<float> > surfRois(surfaceList.size());
+    int64_t maxNodes = 0;
     for (int whichStruct = 0; whichStruct < (int)surfaceList.size(); ++whichStruct)
     {
         const SurfaceFile* mySurf = NULL;
@@ -256,54 +274,134 @@ AlgorithmCiftiSmoothing::AlgorithmCiftiSmoothing(ProgressObject* myProgObj, cons
             default:
                 break;
         }
-        MetricFile myMetric, myRoi, myMetricOut;
-        AlgorithmCiftiSeparate(NULL, myCifti, myDir, surfaceList[whichStruct], &myMetric, &myRoi);
+        surfViews[whichStruct].grabNew(new CiftiStructureView(myBrainMap, surfaceList[whichStruct]));
+        const CiftiStructureView& myView = *(surfViews[whichStruct]);
+        int64_t numNodes = myView.getNumberOfElements();
+        maxNodes = max(maxNodes, numNodes);
         if (surfKern > 0.0f)
         {
+            vector<float>& myRoi = surfRois[whichStruct];
+            myRoi.resize(numNodes);
             if (roiCifti != NULL)
-            {//due to above testing, we know the structure mask is the same, so just overwrite the ROI from the mask
-                AlgorithmCiftiSeparate(NULL, roiCifti, CiftiXMLOld::ALONG_COLUMN, surfaceList[whichStruct], &myRoi);
+            {
+                myView.gather(roiMap.data(), 1, myRoi.data());
+            } else {
+                myView.getRoi(myRoi.data());
             }
-            AlgorithmMetricSmoothing(NULL, mySurf, &myMetric, surfKern, &myMetricOut, &myRoi, false, fixZerosSurf, -1, myAreas);
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, surfaceList[whichStruct], &myMetricOut);
-        } else {
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, surfaceList[whichStruct], &myMetric);
+            MetricFile roiMetric;
+            roiMetric.setNumberOfNodesAndColumns(numNodes, 1);
+            roiMetric.setValuesForColumn(0, myRoi.data());
+            const float* areaData = NULL;
+            if (myAreas != NULL) areaData = myAreas->getValuePointerForColumn(0);
+            surfSmoothers[whichStruct].grabNew(new MetricSmoothingObject(mySurf, surfKern, &roiMetric, MetricSmoothingObject::GEO_GAUSS_AREA, areaData));
         }
     }
+    vector<CaretPointer<CiftiStructureView> > volViews;
     if (mergedVolume)
     {
-        VolumeFile myVol, myRoi, myVolOut;
-        int64_t offset[3];
-        AlgorithmCiftiSeparate(NULL, myCifti, myDir, &myVol, offset, &myRoi, true);
+        if (myBrainMap.hasVolumeData())
+        {
+            volViews.push_back(CaretPointer<CiftiStructureView>(new CiftiStructureView(myBrainMap)));
+        }
+    } else {
+        for (int whichStruct = 0; whichStruct < (int)volumeList.size(); ++whichStruct)
+        {
+            volViews.push_back(CaretPointer<CiftiStructureView>(new CiftiStructureView(myBrainMap, volumeList[whichStruct], true)));
+        }
+    }
+    vector<CaretPointer<VolumeFile> > volRois(volViews.size());
+    int64_t maxVoxels = 0;
+    for (int whichStruct = 0; whichStruct < (int)volViews.size(); ++whichStruct)
+    {
+        const CiftiStructureView& myView = *(volViews[whichStruct]);
+        maxVoxels = max(maxVoxels, myView.getNumberOfElements());
         if (volKern > 0.0f)
         {
+            vector<float> roiFrame(myView.getNumberOfElements());
             if (roiCifti != NULL)
-            {//due to above testing, we know the structure mask is the same, so just overwrite the ROI from the mask
-                AlgorithmCiftiSeparate(NULL, roiCifti, CiftiXMLOld::ALONG_COLUMN, &myRoi, offset, NULL, true);
+            {
+                myView.gather(roiMap.data(), 1, roiFrame.data());
+            } else {
+                myView.getRoi(roiFrame.data());
             }
-            AlgorithmVolumeSmoothing(NULL, &myVol, volKern, &myVolOut, &myRoi, fixZerosVol);
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, &myVolOut, true);
-        } else {
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, &myVol, true);
+            vector<int64_t> roiDims(myView.getVolumeDimensions(), myView.getVolumeDimensions() + 3);
+            volRois[whichStruct].grabNew(new VolumeFile());
+            volRois[whichStruct]->reinitialize(roiDims, myView.getVolumeSform());
+            volRois[whichStruct]->setFrame(roiFrame.data());
         }
-    } else {
-        for (int whichStruct = 0; whichStruct < (int)volumeList.size(); ++whichStruct)
+    }
+    CiftiMapBlockReader myReader(myCifti, myDir);
+    int64_t numMaps = myReader.getNumberOfMaps();
+    int64_t blockMaps = myReader.getBlockMaps();
+    int64_t volBlockMaps = blockMaps;
+    if (volKern > 0.0f && maxVoxels > 0)
+    {//the volume kernel still works on a VolumeFile, so bound the size of the cropped volumes, separately from the file blocks so they don't cause extra reads
+        volBlockMaps = max((int64_t)1, min(blockMaps, VOLUME_BLOCK_BYTES / (maxVoxels * (int64_t)sizeof(float))));
+    }
+    CiftiMapBlockWriter myWriter(myCiftiOut, myDir, blockMaps);
+    vector<float> scratchIn(max(maxNodes, maxVoxels)), scratchOut(maxNodes);
+    for (int64_t blockStart = 0; blockStart < numMaps; blockStart += blockMaps)
+    {
+        int64_t blockCount = min(blockMaps, numMaps - blockStart);
+        int64_t blockEnd = blockStart + blockCount;
+        myReader.loadBlock(blockStart, blockCount);
+        myWriter.startBlock(blockStart, blockCount);
+        for (int whichStruct = 0; whichStruct < (int)surfViews.size(); ++whichStruct)
         {
-            VolumeFile myVol, myRoi, myVolOut;
-            int64_t offset[3];
-            AlgorithmCiftiSeparate(NULL, myCifti, myDir, volumeList[whichStruct], &myVol, offset, &myRoi, true);
+            const CiftiStructureView& myView = *(surfViews[whichStruct]);
+            for (int64_t map = blockStart; map < blockEnd; ++map)
+            {
+                int64_t inStride, outStride;
+                const float* inMap = myReader.getMap(map, inStride);
+                float* outMap = myWriter.getMap(map, outStride);
+                myView.gather(inMap, inStride, scratchIn.data());
+                if (surfSmoothers[whichStruct] != NULL)
+                {
+                    surfSmoothers[whichStruct]->smoothValues(scratchIn.data(), scratchOut.data(), surfRois[whichStruct].data(), fixZerosSurf);
+                    myView.scatter(scratchOut.data(), outMap, outStride);
+                } else {
+                    myView.scatter(scratchIn.data(), outMap, outStride);
+                }
+            }
+        }
+        for (int whichStruct = 0; whichStruct < (int)volViews.size(); ++whichStruct)
+        {
+            const CiftiStructureView& myView = *(volViews[whichStruct]);
             if (volKern > 0.0f)
             {
-                if (roiCifti != NULL)
-                {//due to above testing, we know the structure mask is the same, so just overwrite the ROI from the mask
-                    AlgorithmCiftiSeparate(NULL, roiCifti, CiftiXMLOld::ALONG_COLUMN, volumeList[whichStruct], &myRoi, offset, NULL, true);
+                for (int64_t volStart = blockStart; volStart < blockEnd; volStart += volBlockMaps)
+                {
+                    int64_t volCount = min(volBlockMaps, blockEnd - volStart);
+                    vector<int64_t> volDims(myView.getVolumeDimensions(), myView.getVolumeDimensions() + 3);
+                    volDims.push_back(volCount);
+                    VolumeFile blockVol, blockVolOut;
+                    blockVol.reinitialize(volDims, myView.getVolumeSform());
+                    for (int64_t map = volStart; map < volStart + volCount; ++map)
+                    {
+                        int64_t inStride;
+                        myView.gather(myReader.getMap(map, inStride), inStride, scratchIn.data());
+                        blockVol.setFrame(scratchIn.data(), map - volStart);
+                    }
+                    AlgorithmVolumeSmoothing(NULL, &blockVol, volKern, &blockVolOut, volRois[whichStruct], fixZerosVol);
+                    for (int64_t map = volStart; map < volStart + volCount; ++map)
+                    {
+                        int64_t outStride;
+                        float* outMap = myWriter.getMap(map, outStride);
+                        myView.scatter(blockVolOut.getFrame(map - volStart), outMap, outStride);
+                    }
                 }
-                AlgorithmVolumeSmoothing(NULL, &myVol, volKern, &myVolOut, &myRoi, fixZerosVol);
-                AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, volumeList[whichStruct], &myVolOut, true);
             } else {
-                AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, volumeList[whichStruct], &myVol, true);
+                for (int64_t map = blockStart; map < blockEnd; ++map)
+                {
+                    int64_t inStride, outStride;
+                    const float* inMap = myReader.getMap(map, inStride);
+                    float* outMap = myWriter.getMap(map, outStride);
+                    myView.gather(inMap, inStride, scratchIn.data());
+                    myView.scatter(scratchIn.data(), outMap, outStride);
+                }
             }
         }
+        myWriter.flushBlock();
     }
 }
 
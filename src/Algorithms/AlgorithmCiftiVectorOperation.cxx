@@ -22,6 +22,7 @@
 #include "AlgorithmException.h"
 
 #include "CiftiFile.h"
+#include "CiftiRowPipeline.h"
 
 using namespace caret;
 using namespace std;
@@ -88,7 +89,7 @@ void AlgorithmCiftiVectorOperation::useParameters(OperationParameters* myParams,
 
 AlgorithmCiftiVectorOperation::AlgorithmCiftiVectorOperation(ProgressObject* myProgObj, const CiftiFile* ciftiA, const CiftiFile* ciftiB,
                                                              const VectorOperation::Operation& myOper, CiftiFile* myCiftiOut,
-                                                             const bool& normA, const bool& normB, const bool& normOut, const bool& magOut) : AbstractAlgorithm(myProgObj)
+                                                             const bool& normA, const bool& normB, const bool& normOut, const bool& magOut) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     const CiftiXML& xmlA = ciftiA->getCiftiXML(), &xmlB = ciftiB->getCiftiXML();
@@ -128,44 +129,48 @@ AlgorithmCiftiVectorOperation::AlgorithmCiftiVectorOperation(ProgressObject* myP
         outXML.setMap(CiftiXML::ALONG_ROW, outRowMap);
     }
     myCiftiOut->setCiftiXML(outXML);
-    vector<float> outRow(numColsOut), multiRow(numOutVecs * 3);
-    int64_t numRows = xmlA.getDimensionLength(CiftiXML::ALONG_COLUMN);
-    for (int64_t row = 0; row < numRows; ++row)
+    vector<const CiftiFile*> pipelineInputs;
+    pipelineInputs.push_back(multiVec);
+    pipelineInputs.push_back(singleVec);
+    CiftiRowPipeline myPipeline(pipelineInputs, myCiftiOut);
+    myPipeline.run([&](const CiftiRowBlock& block)
     {
-        multiVec->getRow(multiRow.data(), row);
-        Vector3D vecSingle;
-        singleVec->getRow(vecSingle, row);
-        for (int64_t v = 0; v < numOutVecs; ++v)
+        for (int64_t r = 0; r < block.getNumberOfRows(); ++r)
         {
-            Vector3D vecA, vecB;
-            if (swapped)
+            const float* multiRow = block.getInputRow(0, r);
+            Vector3D vecSingle = block.getInputRow(1, r);
+            float* outRow = block.getOutputRow(r);
+            for (int64_t v = 0; v < numOutVecs; ++v)
             {
-                vecA = multiRow.data() + v * 3;
-                vecB = vecSingle;
-            } else {
-                vecA = vecSingle;
-                vecB = multiRow.data() + v * 3;
-            }
-            if (normA) vecA = vecA.normal();
-            if (normB) vecB = vecB.normal();
-            if (opScalarResult)
-            {
-                outRow[v] = VectorOperation::doScalarOperation(vecA, vecB, myOper);
-            } else {
-                Vector3D tempVec = VectorOperation::doVectorOperation(vecA, vecB, myOper);
-                if (normOut) tempVec = tempVec.normal();
-                if (magOut)
+                Vector3D vecA, vecB;
+                if (swapped)
+                {
+                    vecA = multiRow + v * 3;
+                    vecB = vecSingle;
+                } else {
+                    vecA = vecSingle;
+                    vecB = multiRow + v * 3;
+                }
+                if (normA) vecA = vecA.normal();
+                if (normB) vecB = vecB.normal();
+                if (opScalarResult)
                 {
-                    outRow[v] = tempVec.length();
+                    outRow[v] = VectorOperation::doScalarOperation(vecA, vecB, myOper);
                 } else {
-                    outRow[v * 3] = tempVec[0];
-                    outRow[v * 3 + 1] = tempVec[1];
-                    outRow[v * 3 + 2] = tempVec[2];
+                    Vector3D tempVec = VectorOperation::doVectorOperation(vecA, vecB, myOper);
+                    if (normOut) tempVec = tempVec.normal();
+                    if (magOut)
+                    {
+                        outRow[v] = tempVec.length();
+                    } else {
+                        outRow[v * 3] = tempVec[0];
+                        outRow[v * 3 + 1] = tempVec[1];
+                        outRow[v * 3 + 2] = tempVec[2];
+                    }
                 }
             }
         }
-        myCiftiOut->setRow(outRow.data(), row);
-    }
+    });
 }
 
 float AlgorithmCiftiVectorOperation::getAlgorithmInternalWeight()
@@ -32,12 +32,102 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <set>
 #include <vector>
 
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    ///upwind solution of |grad u| = 1 from the smaller neighbor value along each axis, modifies its arguments
+    float eikonalUpdate(float a[3], float h[3])
+    {
+        for (int i = 0; i < 2; ++i)//sort by neighbor value, keeping the matching spacing
+        {
+            for (int j = 0; j < 2 - i; ++j)
+            {
+                if (a[j] > a[j + 1])
+                {
+                    swap(a[j], a[j + 1]);
+                    swap(h[j], h[j + 1]);
+                }
+            }
+        }
+        float ret = a[0] + h[0];
+        if (ret <= a[1]) return ret;//one dimensional update, also covers infinite neighbors
+        double sumW = 0.0, sumWA = 0.0, sumWA2 = 0.0;
+        for (int n = 0; n < 3; ++n)
+        {
+            double w = 1.0 / ((double)h[n] * h[n]);
+            sumW += w;
+            sumWA += w * a[n];
+            sumWA2 += w * a[n] * a[n];
+            if (n == 0) continue;
+            double disc = sumWA * sumWA - sumW * (sumWA2 - 1.0);
+            ret = (float)((sumWA + sqrt(max(disc, 0.0))) / sumW);
+            if (n == 2 || ret <= a[n + 1]) return ret;
+        }
+        return ret;
+    }
+    
+    ///parallel fast sweeping for unsigned distance: sweeps in all 8 diagonal orders, updating each diagonal plane (i + j + k constant) in parallel
+    ///fixed voxels are never changed, and only voxels in [boxMin, boxMax) are updated
+    void fastSweep(vector<float>& dist, const vector<char>& fixed, const vector<int64_t>& dims, const float spacing[3], const int64_t boxMin[3], const int64_t boxMax[3])
+    {
+        const float INF = numeric_limits<float>::infinity();
+        const int64_t boxSize[3] = { boxMax[0] - boxMin[0], boxMax[1] - boxMin[1], boxMax[2] - boxMin[2] };
+        if (boxSize[0] < 1 || boxSize[1] < 1 || boxSize[2] < 1) return;
+        const int64_t numLevels = boxSize[0] + boxSize[1] + boxSize[2] - 2;
+        const float changeTolerance = 1e-4f * min(min(spacing[0], spacing[1]), spacing[2]);
+        const int MAX_ROUNDS = 8;//one round is enough for straight characteristics, bending around the surface needs more
+        for (int round = 0; round < MAX_ROUNDS; ++round)
+        {
+            bool changed = false;
+            for (int direction = 0; direction < 8; ++direction)
+            {
+                const bool flip[3] = { (direction & 1) != 0, (direction & 2) != 0, (direction & 4) != 0 };
+                for (int64_t level = 0; level < numLevels; ++level)
+                {//voxels in a plane only depend on the planes before and after it, so they can be updated in any order
+                    const int64_t iStart = max((int64_t)0, level - (boxSize[1] - 1) - (boxSize[2] - 1)), iEnd = min(boxSize[0] - 1, level);
+#pragma omp CARET_PARFOR schedule(dynamic, 8) reduction(||:changed)
+                    for (int64_t ii = iStart; ii <= iEnd; ++ii)
+                    {
+                        const int64_t jStart = max((int64_t)0, level - ii - (boxSize[2] - 1)), jEnd = min(boxSize[1] - 1, level - ii);
+                        for (int64_t jj = jStart; jj <= jEnd; ++jj)
+                        {
+                            const int64_t kk = level - ii - jj;
+                            const int64_t i = boxMin[0] + (flip[0] ? boxSize[0] - 1 - ii : ii);
+                            const int64_t j = boxMin[1] + (flip[1] ? boxSize[1] - 1 - jj : jj);
+                            const int64_t k = boxMin[2] + (flip[2] ? boxSize[2] - 1 - kk : kk);
+                            const int64_t index = i + dims[0] * (j + dims[1] * k);
+                            if (fixed[index]) continue;
+                            const int64_t strides[3] = { 1, dims[0], dims[0] * dims[1] };
+                            const int64_t ijk[3] = { i, j, k };
+                            float a[3], h[3];
+                            for (int axis = 0; axis < 3; ++axis)
+                            {
+                                float lower = (ijk[axis] > 0 ? dist[index - strides[axis]] : INF);
+                                float upper = (ijk[axis] < dims[axis] - 1 ? dist[index + strides[axis]] : INF);
+                                a[axis] = min(lower, upper);
+                                h[axis] = spacing[axis];
+                            }
+                            float newVal = eikonalUpdate(a, h);
+                            if (newVal < dist[index])
+                            {
+                                if (dist[index] - newVal > changeTolerance) changed = true;
+                                dist[index] = newVal;
+                            }
+                        }
+                    }
+                }
+            }
+            if (!changed) break;
+        }
+    }
+}
+
 AString AlgorithmCreateSignedDistanceVolume::getCommandSwitch()
 {
     return "-create-signed-distance-volume";
@@ -75,13 +165,19 @@ OperationParameters* AlgorithmCreateSignedDistanceVolume::getParameters()
     OptionalParameter* windingMethodOpt = ret->createOptionalParameter(8, "-winding", "winding method for point inside surface test");
     windingMethodOpt->addStringParameter(1, "method", "name of the method (default EVEN_ODD)");
     
+    OptionalParameter* approxMethodOpt = ret->createOptionalParameter(10, "-approx-method", "method for approximate distance calculation");
+    approxMethodOpt->addStringParameter(1, "method", "name of the method (default DIJKSTRA)");
+    
     ret->setHelpText(
         AString("Computes the signed distance function of the surface.  Exact distance is calculated by finding the closest point on any surface triangle ") +
         "to the center of the voxel.  Approximate distance is calculated starting with these distances, using dijkstra's method with a neighborhood of voxels.  " +
         "Specifying too small of an exact distance may produce unexpected results.  Valid specifiers for winding methods are as follows:\n\n" +
         "EVEN_ODD (default)\nNEGATIVE\nNONZERO\nNORMALS\n\nThe NORMALS method uses the normals of triangles and edges, or the closest triangle hit by a ray from the point.  " +
         "This method may be slightly faster, but is only reliable for a closed surface that does not cross through itself.  All other methods count entry (positive) and " +
-        "exit (negative) crossings of a vertical ray from the point, then counts as inside if the total is odd, negative, or nonzero, respectively."
+        "exit (negative) crossings of a vertical ray from the point, then counts as inside if the total is odd, negative, or nonzero, respectively.\n\n" +
+        "Valid specifiers for approximate methods are DIJKSTRA (default), which uses the voxel neighborhood from -approx-neighborhood, and FAST_SWEEP, " +
+        "which solves the eikonal equation on the voxel grid with multithreaded fast sweeping.  FAST_SWEEP ignores -approx-neighborhood, is much faster for large " +
+        "approximate limits on high resolution volumes, and its accuracy is similar to DIJKSTRA with a neighborhood of 1.  It assumes the volume axes are orthogonal."
     );
     return ret;
 }
@@ -150,11 +246,26 @@ void AlgorithmCreateSignedDistanceVolume::useParameters(OperationParameters* myP
     {
         myRoiOut = roiOutOpt->getOutputVolume(1);
     }
-    AlgorithmCreateSignedDistanceVolume(myProgObj, mySurf, myVolOut, myRoiOut, fillValue, exactLim, approxLim, approxNeighborhood, myWinding);
+    ApproxMethod approxMethod = DIJKSTRA;
+    OptionalParameter* approxMethodOpt = myParams->getOptionalParameter(10);
+    if (approxMethodOpt->m_present)
+    {
+        AString methodName = approxMethodOpt->getString(1);
+        if (methodName == "DIJKSTRA")
+        {
+            approxMethod = DIJKSTRA;
+        } else if (methodName == "FAST_SWEEP") {
+            approxMethod = FAST_SWEEP;
+        } else {
+            throw AlgorithmException("unrecognized approximate method");
+        }
+    }
+    AlgorithmCreateSignedDistanceVolume(myProgObj, mySurf, myVolOut, myRoiOut, fillValue, exactLim, approxLim, approxNeighborhood, myWinding, approxMethod);
 }
 
 AlgorithmCreateSignedDistanceVolume::AlgorithmCreateSignedDistanceVolume(ProgressObject* myProgObj, const SurfaceFile* mySurf, VolumeFile* myVolOut, VolumeFile* myRoiOut, const float& fillValue,
-                                                                         const float& exactLim, const float& approxLim, const int& approxNeighborhood, const SignedDistanceHelper::WindingLogic& myWinding) : AbstractAlgorithm(myProgObj)
+                                                                         const float& exactLim, const float& approxLim, const int& approxNeighborhood, const SignedDistanceHelper::WindingLogic& myWinding,
+                                                                         const ApproxMethod& approxMethod) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     if (exactLim <= 0.0f)
     {
@@ -415,8 +526,58 @@ AlgorithmCreateSignedDistanceVolume::AlgorithmCreateSignedDistanceVolume(Progres
         }
     }
     myProgress.reportProgress(markweight + exactweight);
-    if (approxLim > exactLim)
+    if (approxLim > exactLim && approxMethod == FAST_SWEEP)
     {
+        myProgress.setTask("approximating distances in extended region");
+        //sweep the two sides separately, exact voxels are fixed, and the opposite side's exact voxels block propagation through the surface
+        const float INF = numeric_limits<float>::infinity();
+        vector<float> posDist(frameSize, INF), negDist(frameSize, INF);
+        vector<char> fixed(frameSize, 0);
+        int64_t boxMin[3] = { myDims[0], myDims[1], myDims[2] }, boxMax[3] = { 0, 0, 0 };
+        bool haveSeeds = false;
+        int64_t numExact = (int64_t)exactVoxelList.size();
+        for (int64_t i = 0; i < numExact; i += 3)
+        {
+            const int64_t* thisVoxel = exactVoxelList.data() + i;
+            int64_t thisindex = myVolOut->getIndex(thisVoxel);
+            if ((volMarked[thisindex] & 2) == 0) continue;//using fixup method, some voxels in the list don't have a value
+            fixed[thisindex] = 1;
+            float tempf = scratchFrame[thisindex];
+            if (tempf >= 0.0f) posDist[thisindex] = tempf;
+            if (tempf <= 0.0f) negDist[thisindex] = -tempf;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                boxMin[axis] = min(boxMin[axis], thisVoxel[axis]);
+                boxMax[axis] = max(boxMax[axis], thisVoxel[axis] + 1);
+            }
+            haveSeeds = true;
+        }
+        if (haveSeeds)
+        {
+            float spacing[3] = { ivec.length(), jvec.length(), kvec.length() };
+            for (int axis = 0; axis < 3; ++axis)
+            {//only sweep where a value within the limit is possible
+                int64_t margin = (int64_t)ceil(approxLim / spacing[axis]) + 1;
+                boxMin[axis] = max((int64_t)0, boxMin[axis] - margin);
+                boxMax[axis] = min(myDims[axis], boxMax[axis] + margin);
+            }
+            fastSweep(posDist, fixed, myDims, spacing, boxMin, boxMax);
+            myProgress.reportProgress(markweight + exactweight + approxweight * 0.5f);
+            fastSweep(negDist, fixed, myDims, spacing, boxMin, boxMax);
+            for (int64_t index = 0; index < frameSize; ++index)
+            {
+                if (fixed[index]) continue;
+                if (posDist[index] <= approxLim && posDist[index] <= negDist[index])
+                {
+                    scratchFrame[index] = posDist[index];
+                    volMarked[index] |= 6;//valid positive value, frozen
+                } else if (negDist[index] <= approxLim) {
+                    scratchFrame[index] = -negDist[index];
+                    volMarked[index] |= 20;//valid negative value, frozen
+                }
+            }
+        }
+    } else if (approxLim > exactLim) {
         myProgress.setTask("approximating distances in extended region");
         vector<DistVoxOffset> neighborhood;//this will contain ONLY the shortest voxel offsets with unique 3d slopes within the neighborhood
         DistVoxOffset tempOffset;
@@ -69,7 +69,7 @@ void AlgorithmGiftiAllLabelsToROIs::useParameters(OperationParameters* myParams,
     AlgorithmGiftiAllLabelsToROIs(myProgObj, myLabel, whichMap, myMetricOut);
 }
 
-AlgorithmGiftiAllLabelsToROIs::AlgorithmGiftiAllLabelsToROIs(ProgressObject* myProgObj, const LabelFile* myLabel, const int& whichMap, MetricFile* myMetricOut) : AbstractAlgorithm(myProgObj)
+AlgorithmGiftiAllLabelsToROIs::AlgorithmGiftiAllLabelsToROIs(ProgressObject* myProgObj, const LabelFile* myLabel, const int& whichMap, MetricFile* myMetricOut) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     if (whichMap < 0 || whichMap >= myLabel->getNumberOfMaps())
@@ -59,7 +59,7 @@ void AlgorithmGiftiLabelAddPrefix::useParameters(OperationParameters* myParams,
     AlgorithmGiftiLabelAddPrefix(myProgObj, labelIn, prefix, labelOut);
 }
 
-AlgorithmGiftiLabelAddPrefix::AlgorithmGiftiLabelAddPrefix(ProgressObject* myProgObj, const LabelFile* labelIn, const AString& prefix, LabelFile* labelOut) : AbstractAlgorithm(myProgObj)
+AlgorithmGiftiLabelAddPrefix::AlgorithmGiftiLabelAddPrefix(ProgressObject* myProgObj, const LabelFile* labelIn, const AString& prefix, LabelFile* labelOut) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     int numColumns = labelIn->getNumberOfColumns();
@@ -66,7 +66,7 @@ void AlgorithmLabelProbability::useParameters(OperationParameters* myParams, Pro
     AlgorithmLabelProbability(myProgObj, inputLabel, outputMetric, excludeUnlabeled);
 }
 
-AlgorithmLabelProbability::AlgorithmLabelProbability(ProgressObject* myProgObj, const LabelFile* inputLabel, MetricFile* outputMetric, const bool& excludeUnlabeled) : AbstractAlgorithm(myProgObj)
+AlgorithmLabelProbability::AlgorithmLabelProbability(ProgressObject* myProgObj, const LabelFile* inputLabel, MetricFile* outputMetric, const bool& excludeUnlabeled) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     int numNodes = inputLabel->getNumberOfNodes();
@@ -25,6 +25,7 @@
 #include "GiftiLabelTable.h"
 #include "LabelFile.h"
 #include "MetricFile.h"
+#include "ResamplePlan.h"
 #include "SurfaceFile.h"
 #include "SurfaceResamplingHelper.h"
 
@@ -70,6 +71,9 @@ OperationParameters* AlgorithmLabelResample::getParameters()
     
     ret->createOptionalParameter(10, "-largest", "use only the label of the vertex with the largest weight");
     
+    OptionalParameter* planOpt = ret->createOptionalParameter(11, "-plan", "use precomputed weights from a resample plan");
+    planOpt->addStringParameter(1, "plan-file", "a plan from -resample-plan-create, made with the same spheres, method, areas, and roi");
+    
     AString myHelpText =
         AString("Resamples a label file, given two spherical surfaces that are in register.  ") +
         "If ADAP_BARY_AREA is used, exactly one of -area-surfs or -area-metrics must be specified.\n\n" +
@@ -77,6 +81,7 @@ OperationParameters* AlgorithmLabelResample::getParameters()
         "Midthickness surfaces are recommended for the vertex areas for most data.\n\n" +
         "The -largest option results in nearest vertex behavior when used with BARYCENTRIC, as it uses the value of the source vertex that has the largest weight.\n\n" +
         "When -largest is not specified, the vertex weights are summed according to which label they correspond to, and the label with the largest sum is used.\n\n" +
+        "The -plan option skips computing the resampling weights, the plan must contain weights for exactly the same inputs that affect them, or this command will fail.\n\n" +
         "The <method> argument must be one of the following:\n\n";
     
     vector<SurfaceResamplingMethodEnum::Enum> allEnums;
@@ -157,12 +162,21 @@ void AlgorithmLabelResample::useParameters(OperationParameters* myParams, Progre
         validRoiOut = validRoiOutOpt->getOutputMetric(1);
     }
     bool largest = myParams->getOptionalParameter(10)->m_present;
-    AlgorithmLabelResample(myProgObj, labelIn, curSphere, newSphere, myMethod, labelOut, curAreas, newAreas, currentRoi, validRoiOut, largest);
+    ResamplePlan myPlan;
+    ResamplePlan* planPtr = NULL;
+    OptionalParameter* planOpt = myParams->getOptionalParameter(11);
+    if (planOpt->m_present)
+    {
+        myPlan.readFile(planOpt->getString(1));
+        planPtr = &myPlan;
+    }
+    AlgorithmLabelResample(myProgObj, labelIn, curSphere, newSphere, myMethod, labelOut, curAreas, newAreas, currentRoi, validRoiOut, largest, planPtr);
 }
 
 AlgorithmLabelResample::AlgorithmLabelResample(ProgressObject* myProgObj, const LabelFile* labelIn, const SurfaceFile* curSphere, const SurfaceFile* newSphere,
                                                const SurfaceResamplingMethodEnum::Enum& myMethod, LabelFile* labelOut, const MetricFile* curAreas,
-                                               const MetricFile* newAreas, const MetricFile* currentRoi, MetricFile* validRoiOut, const bool& largest) : AbstractAlgorithm(myProgObj)
+                                               const MetricFile* newAreas, const MetricFile* currentRoi, MetricFile* validRoiOut, const bool& largest,
+                                               const ResamplePlan* plan) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     if (labelIn->getNumberOfNodes() != curSphere->getNumberOfNodes()) throw AlgorithmException("input label file has different number of nodes than input sphere");
@@ -186,13 +200,22 @@ AlgorithmLabelResample::AlgorithmLabelResample(ProgressObject* myProgObj, const
     vector<int32_t> colScratch(numNewNodes, unusedLabel);
     const float* roiCol = NULL;
     if (currentRoi != NULL) roiCol = currentRoi->getValuePointerForColumn(0);
-    SurfaceResamplingHelper myHelp(myMethod, curSphere, newSphere, curAreaData, newAreaData, roiCol);
+    SurfaceResamplingHelper computedHelp;
+    const SurfaceResamplingHelper* myHelp = NULL;
+    if (plan != NULL)
+    {
+        myHelp = plan->getSurfaceWeights(ResamplePlan::surfaceKey(myMethod, curSphere, newSphere, curAreaData, newAreaData, roiCol));
+        if (myHelp == NULL) throw AlgorithmException("resample plan has no weights for these spheres, method, areas, and roi");
+    } else {
+        computedHelp = SurfaceResamplingHelper(myMethod, curSphere, newSphere, curAreaData, newAreaData, roiCol);
+        myHelp = &computedHelp;
+    }
     if (validRoiOut != NULL)
     {
         validRoiOut->setNumberOfNodesAndColumns(numNewNodes, 1);
         validRoiOut->setStructure(labelIn->getStructure());
         vector<float> scratch(numNewNodes);
-        myHelp.getResampleValidROI(scratch.data());
+        myHelp->getResampleValidROI(scratch.data());
         validRoiOut->setValuesForColumn(0, scratch.data());
     }
     for (int i = 0; i < numColumns; ++i)
@@ -200,9 +223,9 @@ AlgorithmLabelResample::AlgorithmLabelResample(ProgressObject* myProgObj, const
         labelOut->setColumnName(i, labelIn->getColumnName(i));
         if (largest)
         {
-            myHelp.resampleLargest(labelIn->getLabelKeyPointerForColumn(i), colScratch.data(), unusedLabel);
+            myHelp->resampleLargest(labelIn->getLabelKeyPointerForColumn(i), colScratch.data(), unusedLabel);
         } else {
-            myHelp.resamplePopular(labelIn->getLabelKeyPointerForColumn(i), colScratch.data(), unusedLabel);
+            myHelp->resamplePopular(labelIn->getLabelKeyPointerForColumn(i), colScratch.data(), unusedLabel);
         }
         labelOut->setLabelKeysForColumn(i, colScratch.data());
     }
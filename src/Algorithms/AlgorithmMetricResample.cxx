@@ -24,9 +24,12 @@
 #include "CaretLogger.h"
 #include "MetricFile.h"
 #include "PaletteColorMapping.h"
+#include "ResamplePlan.h"
 #include "SurfaceFile.h"
 #include "SurfaceResamplingHelper.h"
 
+#include <algorithm>
+
 using namespace caret;
 using namespace std;
 
@@ -69,6 +72,9 @@ OperationParameters* AlgorithmMetricResample::getParameters()
     
     ret->createOptionalParameter(10, "-largest", "use only the value of the vertex with the largest weight");
     
+    OptionalParameter* planOpt = ret->createOptionalParameter(11, "-plan", "use precomputed weights from a resample plan");
+    planOpt->addStringParameter(1, "plan-file", "a plan from -resample-plan-create, made with the same spheres, method, areas, and roi");
+    
     AString myHelpText =
         AString("Resamples a metric file, given two spherical surfaces that are in register.  ") +
         "If ADAP_BARY_AREA is used, exactly one of -area-surfs or -area-metrics must be specified.\n\n" +
@@ -78,6 +84,7 @@ OperationParameters* AlgorithmMetricResample::getParameters()
         "when using -current-roi.\n\n" +
         "The -largest option results in nearest vertex behavior when used with BARYCENTRIC.  " +
         "When resampling a binary metric, consider thresholding at 0.5 after resampling rather than using -largest.\n\n" +
+        "The -plan option skips computing the resampling weights, the plan must contain weights for exactly the same inputs that affect them, or this command will fail.\n\n" +
         "The <method> argument must be one of the following:\n\n";
     
     vector<SurfaceResamplingMethodEnum::Enum> allEnums;
@@ -159,12 +166,20 @@ void AlgorithmMetricResample::useParameters(OperationParameters* myParams, Progr
         validRoiOut = validRoiOutOpt->getOutputMetric(1);
     }
     bool largest = myParams->getOptionalParameter(10)->m_present;
-    AlgorithmMetricResample(myProgObj, metricIn, curSphere, newSphere, myMethod, metricOut, curAreas, newAreas, currentRoi, validRoiOut, largest);
+    ResamplePlan myPlan;
+    ResamplePlan* planPtr = NULL;
+    OptionalParameter* planOpt = myParams->getOptionalParameter(11);
+    if (planOpt->m_present)
+    {
+        myPlan.readFile(planOpt->getString(1));
+        planPtr = &myPlan;
+    }
+    AlgorithmMetricResample(myProgObj, metricIn, curSphere, newSphere, myMethod, metricOut, curAreas, newAreas, currentRoi, validRoiOut, largest, planPtr);
 }
 
 AlgorithmMetricResample::AlgorithmMetricResample(ProgressObject* myProgObj, const MetricFile* metricIn, const SurfaceFile* curSphere, const SurfaceFile* newSphere,
                                                  const SurfaceResamplingMethodEnum::Enum& myMethod, MetricFile* metricOut, const MetricFile* curAreas, const MetricFile* newAreas,
-                                                 const MetricFile* currentRoi, MetricFile* validRoiOut, const bool& largest) : AbstractAlgorithm(myProgObj)
+                                                 const MetricFile* currentRoi, MetricFile* validRoiOut, const bool& largest, const ResamplePlan* plan) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     if (metricIn->getNumberOfNodes() != curSphere->getNumberOfNodes()) throw AlgorithmException("input metric has different number of nodes than input sphere");
@@ -187,13 +202,22 @@ AlgorithmMetricResample::AlgorithmMetricResample(ProgressObject* myProgObj, cons
     vector<float> colScratch(numNewNodes, 0.0f);
     const float* roiCol = NULL;
     if (currentRoi != NULL) roiCol = currentRoi->getValuePointerForColumn(0);
-    SurfaceResamplingHelper myHelp(myMethod, curSphere, newSphere, curAreaData, newAreaData, roiCol);
+    SurfaceResamplingHelper computedHelp;
+    const SurfaceResamplingHelper* myHelp = NULL;
+    if (plan != NULL)
+    {
+        myHelp = plan->getSurfaceWeights(ResamplePlan::surfaceKey(myMethod, curSphere, newSphere, curAreaData, newAreaData, roiCol));
+        if (myHelp == NULL) throw AlgorithmException("resample plan has no weights for these spheres, method, areas, and roi");
+    } else {
+        computedHelp = SurfaceResamplingHelper(myMethod, curSphere, newSphere, curAreaData, newAreaData, roiCol);
+        myHelp = &computedHelp;
+    }
     if (validRoiOut != NULL)
     {
         validRoiOut->setNumberOfNodesAndColumns(numNewNodes, 1);
         validRoiOut->setStructure(metricIn->getStructure());
         vector<float> scratch(numNewNodes);
-        myHelp.getResampleValidROI(scratch.data());
+        myHelp->getResampleValidROI(scratch.data());
         validRoiOut->setValuesForColumn(0, scratch.data());
     }
     for (int i = 0; i < numColumns; ++i)
@@ -202,11 +226,30 @@ AlgorithmMetricResample::AlgorithmMetricResample(ProgressObject* myProgObj, cons
         *metricOut->getPaletteColorMapping(i) = *metricIn->getPaletteColorMapping(i);
         if (largest)
         {
-            myHelp.resampleLargest(metricIn->getValuePointerForColumn(i), colScratch.data());
-        } else {
-            myHelp.resampleNormal(metricIn->getValuePointerForColumn(i), colScratch.data());
+            myHelp->resampleLargest(metricIn->getValuePointerForColumn(i), colScratch.data());
+            metricOut->setValuesForColumn(i, colScratch.data());
+        }
+    }
+    if (!largest)
+    {//several columns at once, so the weights are read once per block of columns instead of once per column
+        const int COLUMN_BLOCK = 16;
+        vector<vector<float> > blockScratch(min(COLUMN_BLOCK, numColumns), vector<float>(numNewNodes));
+        for (int blockStart = 0; blockStart < numColumns; blockStart += COLUMN_BLOCK)
+        {
+            int blockSize = min(COLUMN_BLOCK, numColumns - blockStart);
+            vector<const float*> inputs(blockSize);
+            vector<float*> outputs(blockSize);
+            for (int i = 0; i < blockSize; ++i)
+            {
+                inputs[i] = metricIn->getValuePointerForColumn(blockStart + i);
+                outputs[i] = blockScratch[i].data();
+            }
+            myHelp->resampleNormal(inputs, outputs);
+            for (int i = 0; i < blockSize; ++i)
+            {
+                metricOut->setValuesForColumn(blockStart + i, blockScratch[i].data());
+            }
         }
-        metricOut->setValuesForColumn(i, colScratch.data());
     }
 }
 
@@ -227,7 +227,7 @@ AlgorithmNodesInsideBorder::AlgorithmNodesInsideBorder(ProgressObject* myProgObj
                                                        const float assignMetricValue,
                                                        MetricFile* metricFileInOut,
                                                        const bool& includeBorder)
-: AbstractAlgorithm(myProgObj)
+: AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     CaretAssert(surfaceFile);
     CaretAssert(border);
@@ -273,7 +273,7 @@ AlgorithmNodesInsideBorder::AlgorithmNodesInsideBorder(ProgressObject* myProgObj
                                                        const int32_t assignLabelKey,
                                                        LabelFile* labelFileInOut,
                                                        const bool& includeBorder)
-: AbstractAlgorithm(myProgObj)
+: AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     CaretAssert(surfaceFile);
     CaretAssert(border);
@@ -319,7 +319,7 @@ AlgorithmNodesInsideBorder::AlgorithmNodesInsideBorder(ProgressObject* myProgObj
                            const float assignScalarValue,
                            CiftiBrainordinateScalarFile* ciftiScalarFileInOut,
                            const bool& includeBorder)
-: AbstractAlgorithm(myProgObj)
+: AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     CaretAssert(surfaceFile);
     CaretAssert(border);
@@ -368,7 +368,7 @@ AlgorithmNodesInsideBorder::AlgorithmNodesInsideBorder(ProgressObject* myProgObj
                                                        const int32_t assignLabelKey,
                                                        CiftiBrainordinateLabelFile* ciftiLabelFileInOut,
                                                        const bool& includeBorder)
-: AbstractAlgorithm(myProgObj)
+: AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     CaretAssert(surfaceFile);
     CaretAssert(border);
@@ -417,7 +417,7 @@ AlgorithmNodesInsideBorder::AlgorithmNodesInsideBorder(ProgressObject* myProgObj
                                                        const bool isInverseSelection,
                                                        std::vector<int32_t>& nodesInsideBorderOut,
                                                        const bool& includeBorder)
-: AbstractAlgorithm(myProgObj)
+: AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     CaretAssert(surfaceFile);
     CaretAssert(border);
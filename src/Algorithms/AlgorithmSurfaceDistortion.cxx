@@ -115,7 +115,7 @@ void AlgorithmSurfaceDistortion::useParameters(OperationParameters* myParams, Pr
 
 AlgorithmSurfaceDistortion::AlgorithmSurfaceDistortion(ProgressObject* myProgObj, const SurfaceFile* referenceSurf, const SurfaceFile* distortedSurf,
                                                        MetricFile* myMetricOut, const float& smooth, const bool& caret5method, const bool& edgeMethod,
-                                                       const bool& strainMethod, const bool& strainLog2) : AbstractAlgorithm(myProgObj)
+                                                       const bool& strainMethod, const bool& strainLog2) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     int methodCount = 0;
     if (caret5method) ++methodCount;
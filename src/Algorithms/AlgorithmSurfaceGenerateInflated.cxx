@@ -136,7 +136,7 @@ AlgorithmSurfaceGenerateInflated::AlgorithmSurfaceGenerateInflated(ProgressObjec
                                                                    SurfaceFile* inflatedSurfaceFileOut,
                                                                    SurfaceFile* veryInflatedSurfaceFileOut,
                                                                    const float iterationsScaleIn)
-   : AbstractAlgorithm(myProgObj)
+   : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     ProgressObject* lowProgress = NULL, *inflatedProgress = NULL, *veryInfProgress = NULL;
     if (myProgObj != NULL) {
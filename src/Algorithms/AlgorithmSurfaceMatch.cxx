@@ -137,7 +137,7 @@ AlgorithmSurfaceMatch::useParameters(OperationParameters* myParams,
 AlgorithmSurfaceMatch::AlgorithmSurfaceMatch(ProgressObject* myProgObj,
                                              const SurfaceFile* matchSurfaceFile,
                                              SurfaceFile* surfaceFile)
-   : AbstractAlgorithm(myProgObj)
+   : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     /*
      * Uncomment these if you use another algorithm inside here
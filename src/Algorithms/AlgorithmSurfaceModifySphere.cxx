@@ -69,7 +69,7 @@ void AlgorithmSurfaceModifySphere::useParameters(OperationParameters* myParams,
     AlgorithmSurfaceModifySphere(myProgObj, mySphere, newRadius, outSphere, recenter);
 }
 
-AlgorithmSurfaceModifySphere::AlgorithmSurfaceModifySphere(ProgressObject* myProgObj, const SurfaceFile* mySphere, const float& newRadius, SurfaceFile* outSphere, const bool& recenter) : AbstractAlgorithm(myProgObj)
+AlgorithmSurfaceModifySphere::AlgorithmSurfaceModifySphere(ProgressObject* myProgObj, const SurfaceFile* mySphere, const float& newRadius, SurfaceFile* outSphere, const bool& recenter) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     bool originVertexWarned = false, nanWarned = false;
@@ -70,7 +70,7 @@ void AlgorithmVolumeAllLabelsToROIs::useParameters(OperationParameters* myParams
     AlgorithmVolumeAllLabelsToROIs(myProgObj, myLabel, whichMap, myVolOut);
 }
 
-AlgorithmVolumeAllLabelsToROIs::AlgorithmVolumeAllLabelsToROIs(ProgressObject* myProgObj, const VolumeFile* myLabel, const int& whichMap, VolumeFile* myVolOut) : AbstractAlgorithm(myProgObj)
+AlgorithmVolumeAllLabelsToROIs::AlgorithmVolumeAllLabelsToROIs(ProgressObject* myProgObj, const VolumeFile* myLabel, const int& whichMap, VolumeFile* myVolOut) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     if (myLabel->getType() != SubvolumeAttributes::LABEL)
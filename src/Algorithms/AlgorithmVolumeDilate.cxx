@@ -462,7 +462,7 @@ namespace
 
 AlgorithmVolumeDilate::AlgorithmVolumeDilate(ProgressObject* myProgObj, const VolumeFile* volIn, const float& distance, const Method& myMethod, VolumeFile* volOut,
                                              const VolumeFile* badRoi, const VolumeFile* dataRoi, const int& subvol, const float& exponent, const bool legacyCutoff,
-                                             const bool extrapolate, const float extrapPresmooth) : AbstractAlgorithm(myProgObj)
+                                             const bool extrapolate, const float extrapPresmooth) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     vector<int64_t> myDims;
@@ -87,7 +87,7 @@ void AlgorithmVolumeDistortion::useParameters(OperationParameters* myParams, Pro
     AlgorithmVolumeDistortion(myProgObj, myWarp, distortionOut, myMethod, dolog2);
 }
 
-AlgorithmVolumeDistortion::AlgorithmVolumeDistortion(ProgressObject* myProgObj, const WarpfieldFile& myWarp, VolumeFile* distortionOut, const Method myMethod, const bool dolog2) : AbstractAlgorithm(myProgObj)
+AlgorithmVolumeDistortion::AlgorithmVolumeDistortion(ProgressObject* myProgObj, const WarpfieldFile& myWarp, VolumeFile* distortionOut, const Method myMethod, const bool dolog2) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     switch (myMethod)
@@ -111,7 +111,7 @@ void AlgorithmVolumeGradient::useParameters(OperationParameters* myParams, Progr
 }
 
 AlgorithmVolumeGradient::AlgorithmVolumeGradient(ProgressObject* myProgObj, const VolumeFile* volIn, VolumeFile* volOut, const float& presmooth,
-                                                       const VolumeFile* myRoi, VolumeFile* vectorsOut, const int& subvolNum) : AbstractAlgorithm(myProgObj)
+                                                       const VolumeFile* myRoi, VolumeFile* vectorsOut, const int& subvolNum) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     ProgressObject* smoothProgress = NULL;
     if (myProgObj != NULL && presmooth > 0.0f)
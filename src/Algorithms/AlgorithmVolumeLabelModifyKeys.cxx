@@ -96,7 +96,7 @@ void AlgorithmVolumeLabelModifyKeys::useParameters(OperationParameters* myParams
     AlgorithmVolumeLabelModifyKeys(myProgObj, volIn, remap, volOut, subvol);
 }
 
-AlgorithmVolumeLabelModifyKeys::AlgorithmVolumeLabelModifyKeys(ProgressObject* myProgObj, const VolumeFile* volIn, const map<int32_t, int32_t> remap, VolumeFile* volOut, const int subvol) : AbstractAlgorithm(myProgObj)
+AlgorithmVolumeLabelModifyKeys::AlgorithmVolumeLabelModifyKeys(ProgressObject* myProgObj, const VolumeFile* volIn, const map<int32_t, int32_t> remap, VolumeFile* volOut, const int subvol) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     if (volIn->getType() != SubvolumeAttributes::LABEL)
@@ -58,7 +58,7 @@ void AlgorithmVolumeRemoveIslands::useParameters(OperationParameters* myParams,
     AlgorithmVolumeRemoveIslands(myProgObj, myVolIn, myVolOut);
 }
 
-AlgorithmVolumeRemoveIslands::AlgorithmVolumeRemoveIslands(ProgressObject* myProgObj, const VolumeFile* myVolIn, VolumeFile* myVolOut) : AbstractAlgorithm(myProgObj)
+AlgorithmVolumeRemoveIslands::AlgorithmVolumeRemoveIslands(ProgressObject* myProgObj, const VolumeFile* myVolIn, VolumeFile* myVolOut) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     const int STENCIL_SIZE = 18;//the easy way, and prepare for different stencils if we ever need them
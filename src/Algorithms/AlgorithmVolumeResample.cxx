@@ -26,8 +26,14 @@
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "NiftiIO.h"
+#include "ResamplePlan.h"
+#include "VoxelWeightMatrix.h"
 #include "WarpfieldFile.h"
 
+#include <QCryptographicHash>
+
+#include <algorithm>
+
 using namespace caret;
 using namespace std;
 
@@ -69,11 +75,15 @@ OperationParameters* AlgorithmVolumeResample::getParameters()
     warpOpt->addStringParameter(1, "warpfield", "the warpfield file");
     OptionalParameter* fnirtOpt = warpOpt->createOptionalParameter(2, "-fnirt", "MUST be used if using a fnirt warpfield");
     fnirtOpt->addStringParameter(1, "source-volume", "the source volume used when generating the warpfield");
+    
+    OptionalParameter* planOpt = ret->createOptionalParameter(8, "-plan", "use precomputed weights instead of transforms");
+    planOpt->addStringParameter(1, "plan-file", "a resample plan from -resample-plan-create that has this input space, transforms, <volume-space>, and <method>");
 
     ret->setHelpText(
         AString("Resample a volume file with an arbitrary list of transformations.  ") +
         "You may specify -affine, -warp, and -affine-series multiple times each, and they will be used in the order specified.  "
         "For instance, for rigid motion correction followed by nonlinear atlas registration, specify -affine-series first, then -warp.  "
+        "When using -plan, specify the same -affine and -warp options that the plan was made with, they are only used to find the matching weights in the plan.  "
         "The recommended methods are CUBIC (cubic spline) for most data, and ENCLOSING_VOXEL for label data.  "
         "The parameter <method> must be one of:\n\n"
         "CUBIC\nENCLOSING_VOXEL\nTRILINEAR"
@@ -108,66 +118,85 @@ void AlgorithmVolumeResample::useParameters(OperationParameters* myParams, Progr
     } else {
         throw AlgorithmException("unrecognized interpolation method");
     }
+    OptionalParameter* planOpt = myParams->getOptionalParameter(8);
+    if (planOpt->m_present)
+    {
+        if (!affSeriesInstances.empty())
+        {
+            throw AlgorithmException("-plan can't be used with -affine-series");
+        }
+        XfmStack planStack;//only used to find the plan entry, the plan already contains the transformed weights
+        vector<WarpfieldFile> planWarpStorage;
+        buildXfmStack(myParams, 5, 6, 7, voldims[3], planStack, planWarpStorage);
+        ResamplePlan myPlan;
+        myPlan.readFile(planOpt->getString(1));
+        const VoxelWeightMatrix* planWeights = myPlan.getVolumeWeights(ResamplePlan::volumeKey(inVol->getVolumeSpace(), planStack, refSpace, myMethod));
+        if (planWeights == NULL) throw AlgorithmException("resample plan has no volume weights for this input space, transforms, volume space, and method");
+        AlgorithmVolumeResample(myProgObj, inVol, *planWeights, refSpace, myMethod, outVol);
+        return;
+    }
     XfmStack myStack;
+    vector<WarpfieldFile> warpStorage;//need to keep these in scope until after the algorithm completes
+    buildXfmStack(myParams, 5, 6, 7, voldims[3], myStack, warpStorage);
+    AlgorithmVolumeResample(myProgObj, inVol, myStack, refSpace, myMethod, outVol);
+}
+
+void AlgorithmVolumeResample::buildXfmStack(ParameterComponent* myParams, const int32_t affineKey, const int32_t affineSeriesKey, const int32_t warpKey, const int64_t numFrames,
+                                            XfmStack& myStack, vector<WarpfieldFile>& warpStorage)
+{
+    vector<ParameterComponent*> noInstances;
+    const vector<ParameterComponent*>& affInstances = myParams->getRepeatableParameterInstances(affineKey);
+    const vector<ParameterComponent*>& affSeriesInstances = (affineSeriesKey < 0 ? noInstances : myParams->getRepeatableParameterInstances(affineSeriesKey));
+    const vector<ParameterComponent*>& warpInstances = myParams->getRepeatableParameterInstances(warpKey);
+    warpStorage.clear();
+    warpStorage.resize(warpInstances.size());//the stack refers to these, so they can't be reallocated after this
     auto xfmOrder = myParams->getRepeatableOrder();//helper for some ugly code to resolve relative order of repeatable options
-    vector<WarpfieldFile> warpStorage(warpInstances.size());//need to keep these in scope until after the algorithm completes
     for (auto iter = xfmOrder.rbegin(); iter != xfmOrder.rend(); ++iter)//because this is volume resampling, we need to transform target coords into source coords
     {//so, reverse the transform order and invert affines (warpfields are harder to invert, so they work differently for surfaces)
-        switch (iter->key)
+        if (iter->key == affineKey)
         {
-            case 5:
+            OptionalParameter* flirtOpt = affInstances[iter->index]->getOptionalParameter(2);
+            AffineFile myAff;
+            if (flirtOpt->m_present)
             {
-                OptionalParameter* flirtOpt = affInstances[iter->index]->getOptionalParameter(2);
-                AffineFile myAff;
-                if (flirtOpt->m_present)
-                {
-                    myAff.readFlirt(affInstances[iter->index]->getString(1), flirtOpt->getString(1), flirtOpt->getString(2));
-                } else {
-                    myAff.readWorld(affInstances[iter->index]->getString(1));
-                }
-                myStack.push_back(CaretPointer<XfmBase>(new AffineXfm(myAff.getMatrix().inverse())));//invert it
-                break;
+                myAff.readFlirt(affInstances[iter->index]->getString(1), flirtOpt->getString(1), flirtOpt->getString(2));
+            } else {
+                myAff.readWorld(affInstances[iter->index]->getString(1));
             }
-            case 6:
+            myStack.push_back(CaretPointer<XfmBase>(new AffineXfm(myAff.getMatrix().inverse())));//invert it
+        } else if (affineSeriesKey >= 0 && iter->key == affineSeriesKey) {
+            OptionalParameter* flirtOpt = affSeriesInstances[iter->index]->getOptionalParameter(2);
+            AffineSeriesFile myAffSeries;
+            if (flirtOpt->m_present)
             {
-                OptionalParameter* flirtOpt = affSeriesInstances[iter->index]->getOptionalParameter(2);
-                AffineSeriesFile myAffSeries;
-                if (flirtOpt->m_present)
-                {
-                    myAffSeries.readFlirt(affSeriesInstances[iter->index]->getString(1), flirtOpt->getString(1), flirtOpt->getString(2));
-                } else {
-                    myAffSeries.readWorld(affSeriesInstances[iter->index]->getString(1));
-                }
-                if (myAffSeries.getMatrixList().size() != size_t(voldims[3]))
-                {
-                    throw AlgorithmException("affine series file '" + affSeriesInstances[iter->index]->getString(1) + "' has different number of frames than the input volume");
-                }
-                myStack.push_back(CaretPointer<XfmBase>(new AffineSeriesXfm(myAffSeries.getInverseMatrixList())));//invert it
-                break;
+                myAffSeries.readFlirt(affSeriesInstances[iter->index]->getString(1), flirtOpt->getString(1), flirtOpt->getString(2));
+            } else {
+                myAffSeries.readWorld(affSeriesInstances[iter->index]->getString(1));
             }
-            case 7:
+            if (myAffSeries.getMatrixList().size() != size_t(numFrames))
             {
-                OptionalParameter* fnirtOpt = warpInstances[iter->index]->getOptionalParameter(2);
-                WarpfieldFile& myWarp = warpStorage[iter->index];
-                if (fnirtOpt->m_present)
-                {
-                    myWarp.readFnirt(warpInstances[iter->index]->getString(1), fnirtOpt->getString(1));
-                } else {
-                    myWarp.readWorld(warpInstances[iter->index]->getString(1));
-                }
-                myStack.push_back(CaretPointer<XfmBase>(new WarpfieldXfm(myWarp.getWarpfield())));//DON'T invert, internal warpfield convention is already inverse
-                break;
+                throw AlgorithmException("affine series file '" + affSeriesInstances[iter->index]->getString(1) + "' has different number of frames than the input volume");
+            }
+            myStack.push_back(CaretPointer<XfmBase>(new AffineSeriesXfm(myAffSeries.getInverseMatrixList())));//invert it
+        } else if (iter->key == warpKey) {
+            OptionalParameter* fnirtOpt = warpInstances[iter->index]->getOptionalParameter(2);
+            WarpfieldFile& myWarp = warpStorage[iter->index];
+            if (fnirtOpt->m_present)
+            {
+                myWarp.readFnirt(warpInstances[iter->index]->getString(1), fnirtOpt->getString(1));
+            } else {
+                myWarp.readWorld(warpInstances[iter->index]->getString(1));
             }
-            default:
-                CaretAssert(false);
-                throw AlgorithmException("internal error, tell the developers what you just tried to do");
+            myStack.push_back(CaretPointer<XfmBase>(new WarpfieldXfm(myWarp.getWarpfield())));//DON'T invert, internal warpfield convention is already inverse
+        } else {
+            CaretAssert(false);
+            throw AlgorithmException("internal error, tell the developers what you just tried to do");
         }
     }
-    AlgorithmVolumeResample(myProgObj, inVol, myStack, refSpace, myMethod, outVol);
 }
 
 AlgorithmVolumeResample::AlgorithmVolumeResample(ProgressObject* myProgObj, const VolumeFile* inVol, const XfmStack& myStack, const VolumeSpace refSpace,
-                                                 const VolumeFile::InterpType& myMethod, VolumeFile* outVol) : AbstractAlgorithm(myProgObj)
+                                                 const VolumeFile::InterpType& myMethod, VolumeFile* outVol) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     vector<int64_t> outDims = inVol->getOriginalDimensions();
@@ -232,6 +261,68 @@ AlgorithmVolumeResample::AlgorithmVolumeResample(ProgressObject* myProgObj, cons
     }
 }
 
+AlgorithmVolumeResample::AlgorithmVolumeResample(ProgressObject* myProgObj, const VolumeFile* inVol, const VoxelWeightMatrix& planWeights, const VolumeSpace refSpace,
+                                                 const VolumeFile::InterpType& myMethod, VolumeFile* outVol) : AbstractAlgorithm(myProgObj, getCommandSwitch())
+{
+    LevelProgress myProgress(myProgObj);
+    vector<int64_t> outDims = inVol->getOriginalDimensions();
+    const int64_t* refDims = refSpace.getDims();
+    if (outDims.size() < 3) throw AlgorithmException("input must have 3 spatial dimensions");
+    outDims[0] = refDims[0];
+    outDims[1] = refDims[1];
+    outDims[2] = refDims[2];
+    const int64_t frameSize = refDims[0] * refDims[1] * refDims[2];
+    if (planWeights.getNumberOfVertices() != frameSize) throw AlgorithmException("resample plan weights don't match the output volume space");
+    if (!planWeights.matchesDimensions(inVol->getDimensionsPtr())) throw AlgorithmException("resample plan weights don't match the input volume dimensions");
+    int64_t numMaps = inVol->getNumberOfMaps(), numComponents = inVol->getNumberOfComponents();
+    outVol->reinitialize(outDims, refSpace.getSform(), numComponents, inVol->getType(), inVol->m_header);
+    bool labelMode = inVol->isMappedWithLabelTable();
+    if (labelMode)
+    {
+        if (myMethod != VolumeFile::ENCLOSING_VOXEL)
+        {
+            CaretLogWarning("using interpolation type other than ENCLOSING_VOXEL on a label volume");
+        }
+        for (int64_t i = 0; i < numMaps; ++i)
+        {
+            *(outVol->getMapLabelTable(i)) = *(inVol->getMapLabelTable(i));
+        }
+    }
+    for (int64_t i = 0; i < numMaps; ++i)
+    {
+        outVol->setMapName(i, inVol->getMapName(i));
+    }
+    const int64_t MAP_BLOCK = 16;//the weights gather a block of frames together, keep the output scratch bounded
+    vector<vector<float> > scratchFrames(min(MAP_BLOCK, numMaps), vector<float>(frameSize));
+    for (int64_t c = 0; c < numComponents; ++c)
+    {
+        for (int64_t blockStart = 0; blockStart < numMaps; blockStart += MAP_BLOCK)
+        {
+            int64_t blockSize = min(MAP_BLOCK, numMaps - blockStart);
+            vector<const float*> frames(blockSize);
+            vector<float*> outputs(blockSize);
+            for (int64_t b = 0; b < blockSize; ++b)
+            {
+                frames[b] = inVol->getFrame(blockStart + b, c);
+                outputs[b] = scratchFrames[b].data();
+            }
+            planWeights.apply(frames, outputs);
+            for (int64_t b = 0; b < blockSize; ++b)
+            {
+                if (labelMode)
+                {//outside the input gets the unassigned key, like interpolateValue
+                    int32_t unassigned = inVol->getMapLabelTable(blockStart + b)->getUnassignedLabelKey();
+                    for (int64_t v = 0; v < frameSize; ++v)
+                    {
+                        if (planWeights.hasNoWeights(v)) scratchFrames[b][v] = unassigned;
+                    }
+                }
+                outVol->setFrame(scratchFrames[b].data(), blockStart + b, c);
+            }
+        }
+    }
+}
+
 float AlgorithmVolumeResample::getAlgorithmInternalWeight()
 {
     return 1.0f;//override this if needed, if the progress bar isn't smooth
@@ -282,6 +373,27 @@ AffineSeriesXfm::AffineSeriesXfm(const vector<FloatMatrix>& xfmList)
     m_xfmList = xfmList;
 }
 
+namespace
+{
+    void hashAffine(QCryptographicHash& hasher, const FloatMatrix& xfm)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                const float value = xfm[i][j];
+                hasher.addData((const char*)&value, sizeof(value));
+            }
+        }
+    }
+}
+
+void AffineXfm::addToHash(QCryptographicHash& hasher) const
+{
+    hasher.addData("A", 1);
+    hashAffine(hasher, m_xfm);
+}
+
 Vector3D AffineSeriesXfm::xfmPoint(const Vector3D& coordIn, const int64_t frame, bool* validCoord) const
 {
     CaretAssertVectorIndex(m_xfmList, frame);
@@ -289,6 +401,17 @@ Vector3D AffineSeriesXfm::xfmPoint(const Vector3D& coordIn, const int64_t frame,
     return m_xfmList[frame].transformPoint(coordIn);
 }
 
+void AffineSeriesXfm::addToHash(QCryptographicHash& hasher) const
+{
+    const int64_t numXfms = (int64_t)m_xfmList.size();
+    hasher.addData("S", 1);
+    hasher.addData((const char*)&numXfms, sizeof(numXfms));
+    for (const FloatMatrix& xfm : m_xfmList)
+    {
+        hashAffine(hasher, xfm);
+    }
+}
+
 WarpfieldXfm::WarpfieldXfm(const VolumeFile* warp)
 {
     if ((warp->getDimensions())[3] != 3)
@@ -312,6 +435,41 @@ Vector3D WarpfieldXfm::xfmPoint(const Vector3D& coordIn, const int64_t /*frame*/
     return offset + coordIn;
 }
 
+void WarpfieldXfm::addToHash(QCryptographicHash& hasher) const
+{
+    const VolumeSpace& warpSpace = m_warp->getVolumeSpace();
+    const int64_t* warpDims = warpSpace.getDims();
+    const vector<vector<float> >& sform = warpSpace.getSform();
+    hasher.addData("W", 1);
+    hasher.addData((const char*)warpDims, 3 * sizeof(int64_t));
+    for (int i = 0; i < 3; ++i)
+    {
+        hasher.addData((const char*)sform[i].data(), 4 * sizeof(float));
+    }
+    const int64_t frameSize = warpDims[0] * warpDims[1] * warpDims[2];
+    const int64_t CHUNK = 1 << 28;//addData takes an int length
+    for (int64_t b = 0; b < 3; ++b)
+    {
+        const char* frame = (const char*)m_warp->getFrame(b);
+        const int64_t frameBytes = frameSize * sizeof(float);
+        for (int64_t start = 0; start < frameBytes; start += CHUNK)
+        {
+            hasher.addData(frame + start, (int)min(CHUNK, frameBytes - start));
+        }
+    }
+}
+
+void XfmStack::addToHash(QCryptographicHash& hasher) const
+{
+    const int64_t numXfms = (int64_t)m_xfmStack.size();
+    hasher.addData("K", 1);
+    hasher.addData((const char*)&numXfms, sizeof(numXfms));
+    for (auto& xfm : m_xfmStack)
+    {
+        xfm->addToHash(hasher);
+    }
+}
+
 void XfmStack::push_back(CaretPointer<const XfmBase> nextXfm)
 {
     m_xfmStack.push_back(nextXfm);
@@ -27,8 +27,14 @@
 #include "Vector3D.h"
 #include "VolumeFile.h"
 
+#include <vector>
+
+class QCryptographicHash;
+
 namespace caret {
 
+    class VoxelWeightMatrix;
+    class WarpfieldFile;
     class XfmStack;
 
     class AlgorithmVolumeResample : public AbstractAlgorithm
@@ -40,6 +46,13 @@ namespace caret {
     public:
         AlgorithmVolumeResample(ProgressObject* myProgObj, const VolumeFile* inVol, const XfmStack& myStack, const VolumeSpace refSpace,
                                 const VolumeFile::InterpType& myMethod, VolumeFile* outVol);
+        ///apply precomputed weights from a resample plan, they must have been made for the input volume space and refSpace
+        AlgorithmVolumeResample(ProgressObject* myProgObj, const VolumeFile* inVol, const VoxelWeightMatrix& planWeights, const VolumeSpace refSpace,
+                                const VolumeFile::InterpType& myMethod, VolumeFile* outVol);
+        ///build the inverse transform stack from -affine, -affine-series, and -warp style options, pass -1 for a key that the command doesn't have
+        ///warpStorage holds the warpfields the stack refers to, keep it in scope while using the stack
+        static void buildXfmStack(ParameterComponent* myParams, const int32_t affineKey, const int32_t affineSeriesKey, const int32_t warpKey, const int64_t numFrames,
+                                  XfmStack& stackOut, std::vector<WarpfieldFile>& warpStorage);
         static OperationParameters* getParameters();
         static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
         static AString getCommandSwitch();
@@ -52,6 +65,8 @@ namespace caret {
     struct XfmBase
     {
         virtual Vector3D xfmPoint(const Vector3D& coordIn, const int64_t frame, bool* validCoord = NULL) const = 0;
+        ///add everything the transform computes from to the hash, for resample plan keys
+        virtual void addToHash(QCryptographicHash& hasher) const = 0;
         virtual ~XfmBase() {};
     };
 
@@ -61,6 +76,7 @@ namespace caret {
     public:
         AffineXfm(const FloatMatrix& xfm);
         Vector3D xfmPoint(const Vector3D& coordIn, const int64_t frame, bool* validCoord = NULL) const;
+        void addToHash(QCryptographicHash& hasher) const;
     };
 
     class AffineSeriesXfm : public XfmBase
@@ -69,6 +85,7 @@ namespace caret {
     public:
         AffineSeriesXfm(const std::vector<FloatMatrix>& xfmList);
         Vector3D xfmPoint(const Vector3D& coordIn, const int64_t frame, bool* validCoord = NULL) const;
+        void addToHash(QCryptographicHash& hasher) const;
     };
 
     class WarpfieldXfm : public XfmBase
@@ -77,6 +94,7 @@ namespace caret {
     public:
         WarpfieldXfm(const VolumeFile* warp);
         Vector3D xfmPoint(const Vector3D& coordIn, const int64_t frame, bool* validCoord = NULL) const;
+        void addToHash(QCryptographicHash& hasher) const;
     };
 
     class XfmStack : public XfmBase //allow stacking of transform stacks, because why not
@@ -84,6 +102,7 @@ namespace caret {
         std::vector<CaretPointer<const XfmBase> > m_xfmStack;
     public:
         Vector3D xfmPoint(const Vector3D& coordIn, const int64_t frame, bool* validCoord = NULL) const;
+        void addToHash(QCryptographicHash& hasher) const;
         void push_back(CaretPointer<const XfmBase> nextXfm);
     };
 
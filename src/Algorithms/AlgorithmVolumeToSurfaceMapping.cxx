@@ -21,6 +21,7 @@
 #include "AlgorithmVolumeToSurfaceMapping.h"
 #include "AlgorithmException.h"
 
+#include "CacheFileHelper.h"
 #include "CaretAssert.h"
 #include "CaretOMP.h"
 #include "FloatMatrix.h"
@@ -35,12 +36,20 @@
 #include "AlgorithmSurfaceToSurface3dDistance.h"
 #include "AlgorithmCreateSignedDistanceVolume.h"
 
+#include <QCryptographicHash>
+
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    const int64_t COLUMN_BLOCK = 64;//output columns mapped together by voxel weights, bounds the scratch memory
+}
+
 AString AlgorithmVolumeToSurfaceMapping::getCommandSwitch()
 {
     return "-volume-to-surface-mapping";
@@ -96,6 +105,9 @@ OperationParameters* AlgorithmVolumeToSurfaceMapping::getParameters()
     OptionalParameter* subvolumeSelect = ret->createOptionalParameter(7, "-subvol-select", "select a single subvolume to map");
     subvolumeSelect->addStringParameter(1, "subvol", "the subvolume number or name");
     
+    OptionalParameter* weightsCacheOpt = ret->createOptionalParameter(10, "-weights-cache", "reuse voxel weights of -ribbon-constrained and -myelin-style across runs");
+    weightsCacheOpt->addStringParameter(1, "directory", "directory to store the voxel weights in, created if needed");
+    
     ret->setHelpText(
         AString("You must specify exactly one mapping method.  Enclosing voxel uses the value from the voxel the vertex lies inside, while trilinear does a 3D ") + 
         "linear interpolation based on the voxels immediately on each side of the vertex's position." +
@@ -117,7 +129,12 @@ OperationParameters* AlgorithmVolumeToSurfaceMapping::getParameters()
         "with radius and height equal to cortical thickness, centered on the vertex and aligned with the surface normal, and that are also within the ribbon ROI, " +
         "and apply a gaussian kernel with the specified sigma to them to get the weights to use.  " +
         "The -legacy-bug flag reverts to the unintended behavior present from the initial implementation up to and including v1.2.3, which had only the tangential cutoff " +
-        "and a bounding box intended to be larger than where the cylinder cutoff should have been."
+        "and a bounding box intended to be larger than where the cylinder cutoff should have been." +
+        "\n\n" +
+        "The voxel weights of the ribbon constrained (without -interpolate) and myelin style methods depend only on the surfaces, volume space, ROI and options, " +
+        "not on the data being mapped.  When -weights-cache is specified, they are stored in the given directory, named by a hash of everything they are computed from, " +
+        "and later mappings with the same inputs read them instead of recomputing them, which is useful when mapping many runs of the same subject.  " +
+        "Within one process (such as wb_command -batch), the most recently used weights are also kept in memory."
     );
     return ret;
 }
@@ -142,6 +159,13 @@ void AlgorithmVolumeToSurfaceMapping::useParameters(OperationParameters* myParam
             throw AlgorithmException("invalid column specified");
         }
     }
+    AString weightsCacheDir;
+    OptionalParameter* weightsCacheOpt = myParams->getOptionalParameter(10);
+    if (weightsCacheOpt->m_present)
+    {
+        weightsCacheDir = weightsCacheOpt->getString(1);
+        if (weightsCacheDir.isEmpty()) throw AlgorithmException("weights cache directory must not be empty");
+    }
     bool haveMethod = false;
     Method myMethod = CUBIC;//this tracks which constructor to call
     VolumeFile::InterpType volInterpMethod = VolumeFile::CUBIC;
@@ -272,26 +296,29 @@ void AlgorithmVolumeToSurfaceMapping::useParameters(OperationParameters* myParam
                                                 mySubVol, gaussScale, badVertices);
             } else {
                 AlgorithmVolumeToSurfaceMapping(myProgObj, myVolume, mySurface, myMetricOut, innerSurf, outerSurf, myRoiVol, weightedRoi, subdivisions, thinColumns,
-                                                mySubVol, gaussScale, badVertices, weightsOutVertex, weightsOut);
+                                                mySubVol, gaussScale, badVertices, weightsOutVertex, weightsOut, weightsCacheDir);
             }
             if (ribbonWeightsText->m_present)
             {//do this after the algorithm, to let it do the error condition checking
                 ofstream outFile(ribbonWeightsText->getString(1).toLocal8Bit().constData());
                 if (!outFile) throw AlgorithmException("failed to open output textfile '" + ribbonWeightsText->getString(1) + "'");
-                vector<vector<VoxelWeight> > myWeights;
                 const float* roiFrame = NULL;
                 if (myRoiVol != NULL) roiFrame = myRoiVol->getFrame();
-                AlgorithmVolumeToSurfaceMapping::precomputeWeightsRibbon(myWeights, myVolume->getVolumeSpace(), innerSurf, outerSurf, roiFrame, weightedRoi, subdivisions, thinColumns, mySurface, gaussScale);
-                for (int i = 0; i < (int)myWeights.size(); ++i)
+                //the mapping just computed or loaded these, so this is normally found in memory
+                CaretPointer<const VoxelWeightMatrix> myWeights = AlgorithmVolumeToSurfaceMapping::getWeightsRibbon(myVolume->getVolumeSpace(), innerSurf, outerSurf, roiFrame, weightedRoi,
+                                                                                                                   subdivisions, thinColumns, mySurface, gaussScale, weightsCacheDir);
+                vector<VoxelWeight> vertexWeights;
+                for (int i = 0; i < (int)myWeights->getNumberOfVertices(); ++i)
                 {
-                    outFile << i << ", " << myWeights[i].size();
-                    for (int j = 0; j < (int)myWeights[i].size(); ++j)
+                    myWeights->getVertexWeights(i, vertexWeights);
+                    outFile << i << ", " << vertexWeights.size();
+                    for (int j = 0; j < (int)vertexWeights.size(); ++j)
                     {
                         for (int v = 0; v < 3; ++v)
                         {
-                            outFile << ", " << myWeights[i][j].ijk[v];
+                            outFile << ", " << vertexWeights[j].ijk[v];
                         }
-                        outFile << ", " << myWeights[i][j].weight;
+                        outFile << ", " << vertexWeights[j].weight;
                     }
                     outFile << endl;
                 }
@@ -304,7 +331,7 @@ void AlgorithmVolumeToSurfaceMapping::useParameters(OperationParameters* myParam
             MetricFile* thickness = myelinStyleOpt->getMetric(2);
             float sigma = (float)myelinStyleOpt->getDouble(3);
             bool oldCutoffBug = myelinStyleOpt->getOptionalParameter(4)->m_present;
-            AlgorithmVolumeToSurfaceMapping(myProgObj, myVolume, mySurface, myMetricOut, roi, thickness, sigma, mySubVol, oldCutoffBug);
+            AlgorithmVolumeToSurfaceMapping(myProgObj, myVolume, mySurface, myMetricOut, roi, thickness, sigma, mySubVol, oldCutoffBug, weightsCacheDir);
             break;
         }
         default:
@@ -314,7 +341,7 @@ void AlgorithmVolumeToSurfaceMapping::useParameters(OperationParameters* myParam
 
 //interpolation mapping
 AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject* myProgObj, const VolumeFile* myVolume, const SurfaceFile* mySurface, MetricFile* myMetricOut,
-                                                                 const VolumeFile::InterpType& myMethod, const int64_t& mySubVol) : AbstractAlgorithm(myProgObj)
+                                                                 const VolumeFile::InterpType& myMethod, const int64_t& mySubVol) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     vector<int64_t> myVolDims;
@@ -410,7 +437,7 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
 AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject* myProgObj, const VolumeFile* myVolume, const SurfaceFile* mySurface, MetricFile* myMetricOut,
                                                                  const SurfaceFile* innerSurf, const SurfaceFile* outerSurf, const VolumeFile* roiVol, const bool roiWeights,
                                                                  const int32_t& subdivisions, const bool& thinColumns, const int64_t& mySubVol, const float& gaussScale, MetricFile* badVertices,
-                                                                 const int& weightsOutVertex, VolumeFile* weightsOut) : AbstractAlgorithm(myProgObj)
+                                                                 const int& weightsOutVertex, VolumeFile* weightsOut, const AString& weightsCacheDir) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     vector<int64_t> myVolDims;
@@ -451,101 +478,28 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
         weightDims.resize(3);
         weightsOut->reinitialize(weightDims, myVolume->getSform());
     }
-    vector<vector<VoxelWeight> > myWeights;
     const float* roiFrame = NULL;
     if (roiVol != NULL) roiFrame = roiVol->getFrame();
-    precomputeWeightsRibbon(myWeights, myVolume->getVolumeSpace(), innerSurf, outerSurf, roiFrame, roiWeights, subdivisions, thinColumns, mySurface, gaussScale);
+    CaretPointer<const VoxelWeightMatrix> myWeights = getWeightsRibbon(myVolume->getVolumeSpace(), innerSurf, outerSurf, roiFrame, roiWeights, subdivisions, thinColumns,
+                                                                       mySurface, gaussScale, weightsCacheDir);
     if (weightsOut != NULL)
     {
         weightsOut->setValueAllVoxels(0.0f);
-        const vector<VoxelWeight>& vertexWeights = myWeights[weightsOutVertex];
+        vector<VoxelWeight> vertexWeights;
+        myWeights->getVertexWeights(weightsOutVertex, vertexWeights);
         int numWeights = (int)vertexWeights.size();
         for (int i = 0; i < numWeights; ++i)
         {
             weightsOut->setValue(vertexWeights[i].weight, vertexWeights[i].ijk);
         }
     }
-    CaretArray<float> myScratchArray(numNodes);
-    float* myScratch = myScratchArray.getArray();
-    if (mySubVol == -1)
+    mapWithWeights(*myWeights, myVolume, myMetricOut, mySubVol, " ribbon constrained");
+    if (badVertices != NULL)
     {
-        for (int64_t i = 0; i < myVolDims[3]; ++i)
-        {
-            for (int64_t j = 0; j < myVolDims[4]; ++j)
-            {
-                int64_t thisCol = i * myVolDims[4] + j;
-                AString metricLabel = myVolume->getMapName(i);
-                if (myVolDims[4] != 1)
-                {
-                    metricLabel += " component " + AString::number(j);
-                }
-                metricLabel += " ribbon constrained";
-                myMetricOut->setColumnName(thisCol, metricLabel);
-#pragma omp CARET_PARFOR schedule(dynamic)
-                for (int64_t node = 0; node < numNodes; ++node)
-                {
-                    myScratch[node] = 0.0f;
-                    float totalWeight = 0.0f;
-                    int numVoxels = (int)myWeights[node].size();
-                    for (int voxel = 0; voxel < numVoxels; ++voxel)
-                    {
-                        float thisWeight = myWeights[node][voxel].weight;
-                        totalWeight += thisWeight;
-                        myScratch[node] += thisWeight * myVolume->getValue(myWeights[node][voxel].ijk, i, j);
-                    }
-                    if (totalWeight != 0.0f)
-                    {
-                        myScratch[node] /= totalWeight;
-                    } else {
-                        myScratch[node] = 0.0f;
-                        if (thisCol == 0 && badVertices != NULL)
-                        {
-                            badVertScratch[node] = 1.0f;
-                        }
-                    }
-                }
-                myMetricOut->setValuesForColumn(thisCol, myScratch);
-            }
-        }
-    } else {
-        for (int64_t j = 0; j < myVolDims[4]; ++j)
+        for (int64_t node = 0; node < numNodes; ++node)
         {
-            AString metricLabel = myVolume->getMapName(mySubVol);
-            if (myVolDims[4] != 1)
-            {
-                metricLabel += " component " + AString::number(j);
-            }
-            metricLabel += " ribbon constrained";
-            int64_t thisCol = j;
-            myMetricOut->setColumnName(thisCol, metricLabel);
-#pragma omp CARET_PARFOR schedule(dynamic)
-            for (int64_t node = 0; node < numNodes; ++node)
-            {
-                    myScratch[node] = 0.0f;
-                    float totalWeight = 0.0f;
-                    int numVoxels = (int)myWeights[node].size();
-                    for (int voxel = 0; voxel < numVoxels; ++voxel)
-                    {
-                        float thisWeight = myWeights[node][voxel].weight;
-                        totalWeight += thisWeight;
-                        myScratch[node] += thisWeight * myVolume->getValue(myWeights[node][voxel].ijk, mySubVol, j);
-                    }
-                    if (totalWeight != 0.0f)
-                    {
-                        myScratch[node] /= totalWeight;
-                    } else {
-                        myScratch[node] = 0.0f;
-                        if (badVertices != NULL)
-                        {
-                            badVertScratch[node] = 1.0f;
-                        }
-                    }
-            }
-            myMetricOut->setValuesForColumn(thisCol, myScratch);
+            if (myWeights->isVertexEmpty(node)) badVertScratch[node] = 1.0f;
         }
-    }
-    if (badVertices != NULL)
-    {
         badVertices->setValuesForColumn(0, badVertScratch.data());
     }
 }
@@ -553,7 +507,7 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
 //interpolation ribbon mapping
 AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject* myProgObj, const VolumeFile* myVolume, const SurfaceFile* mySurface, MetricFile* myMetricOut,
                                                                  const SurfaceFile* innerSurf, const SurfaceFile* outerSurf, const VolumeFile::InterpType interpType, const VolumeFile* roiVol, const bool roiWeights,
-                                                                 const int32_t& subdivisions, const bool& thinColumns, const int64_t& mySubVol, const float& gaussScale, MetricFile* badVertices) : AbstractAlgorithm(myProgObj)
+                                                                 const int32_t& subdivisions, const bool& thinColumns, const int64_t& mySubVol, const float& gaussScale, MetricFile* badVertices) : AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     vector<int64_t> myVolDims;
@@ -716,7 +670,8 @@ void AlgorithmVolumeToSurfaceMapping::precomputeWeightsRibbon(vector<vector<Voxe
 
 //myelin style mapping
 AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject* myProgObj, const VolumeFile* myVolume, const SurfaceFile* mySurface, MetricFile* myMetricOut,
-                                                                 const VolumeFile* roiVol, const MetricFile* thickness, const float& sigma, const int64_t& mySubVol, const bool& oldCutoffBug): AbstractAlgorithm(myProgObj)
+                                                                 const VolumeFile* roiVol, const MetricFile* thickness, const float& sigma, const int64_t& mySubVol, const bool& oldCutoffBug,
+                                                                 const AString& weightsCacheDir): AbstractAlgorithm(myProgObj, getCommandSwitch())
 {
     LevelProgress myProgress(myProgObj);
     vector<int64_t> myVolDims;
@@ -739,62 +694,8 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
     int64_t numNodes = mySurface->getNumberOfNodes();
     myMetricOut->setNumberOfNodesAndColumns(numNodes, numColumns);
     myMetricOut->setStructure(mySurface->getStructure());
-    vector<vector<VoxelWeight> > myWeights;
-    precomputeWeightsMyelin(myWeights, mySurface, roiVol, thickness, sigma, oldCutoffBug);
-    vector<float> myScratch(numNodes);
-    if (mySubVol == -1)
-    {
-        for (int64_t i = 0; i < myVolDims[3]; ++i)
-        {
-            for (int64_t j = 0; j < myVolDims[4]; ++j)
-            {
-                int64_t thisCol = i * myVolDims[4] + j;
-                AString metricLabel = myVolume->getMapName(i);
-                if (myVolDims[4] != 1)
-                {
-                    metricLabel += " component " + AString::number(j);
-                }
-                metricLabel += " myelin style";
-                myMetricOut->setColumnName(thisCol, metricLabel);
-#pragma omp CARET_PARFOR schedule(dynamic)
-                for (int64_t node = 0; node < numNodes; ++node)
-                {
-                    double accum = 0.0;
-                    int numVoxels = (int)myWeights[node].size();
-                    for (int voxel = 0; voxel < numVoxels; ++voxel)
-                    {
-                        accum += myWeights[node][voxel].weight * myVolume->getValue(myWeights[node][voxel].ijk, i, j);//weights have already been normalized in precompute, for this method
-                    }
-                    myScratch[node] = accum;
-                }
-                myMetricOut->setValuesForColumn(thisCol, myScratch.data());
-            }
-        }
-    } else {
-        for (int64_t j = 0; j < myVolDims[4]; ++j)
-        {
-            AString metricLabel = myVolume->getMapName(mySubVol);
-            if (myVolDims[4] != 1)
-            {
-                metricLabel += " component " + AString::number(j);
-            }
-            metricLabel += " myelin style";
-            int64_t thisCol = j;
-            myMetricOut->setColumnName(thisCol, metricLabel);
-#pragma omp CARET_PARFOR schedule(dynamic)
-            for (int64_t node = 0; node < numNodes; ++node)
-            {
-                double accum = 0.0;
-                int numVoxels = (int)myWeights[node].size();
-                for (int voxel = 0; voxel < numVoxels; ++voxel)
-                {
-                    accum += myWeights[node][voxel].weight * myVolume->getValue(myWeights[node][voxel].ijk, mySubVol, j);//weights have already been normalized in precompute, for this method
-                }
-                myScratch[node] = accum;
-            }
-            myMetricOut->setValuesForColumn(thisCol, myScratch.data());
-        }
-    }
+    CaretPointer<const VoxelWeightMatrix> myWeights = getWeightsMyelin(mySurface, roiVol, thickness, sigma, oldCutoffBug, weightsCacheDir);
+    mapWithWeights(*myWeights, myVolume, myMetricOut, mySubVol, " myelin style");
 }
 
 void AlgorithmVolumeToSurfaceMapping::precomputeWeightsMyelin(vector<vector<VoxelWeight> >& myWeights, const SurfaceFile* mySurface, const VolumeFile* roiVol,
@@ -867,6 +768,107 @@ void AlgorithmVolumeToSurfaceMapping::precomputeWeightsMyelin(vector<vector<Voxe
     }
 }
 
+CaretPointer<const VoxelWeightMatrix> AlgorithmVolumeToSurfaceMapping::getWeightsRibbon(const VolumeSpace& volSpace, const SurfaceFile* innerSurf, const SurfaceFile* outerSurf,
+                                                                                        const float* roiFrame, const bool roiWeights, const int& subdivisions, const bool& thinColumns,
+                                                                                        const SurfaceFile* gaussSurf, const float& gaussScale, const AString& weightsCacheDir)
+{//key is everything that precomputeWeightsRibbon uses, so a hit can never be stale
+    QCryptographicHash hasher(QCryptographicHash::Sha1);
+    const char methodTag[] = "ribbon constrained 1";
+    CacheFileHelper::hashBytes(hasher, methodTag, sizeof(methodTag));
+    CacheFileHelper::hashVolumeSpace(hasher, volSpace);
+    CacheFileHelper::hashSurface(hasher, innerSurf);
+    CacheFileHelper::hashSurface(hasher, outerSurf);
+    const char flags[3] = { roiFrame != NULL, roiWeights, thinColumns };
+    CacheFileHelper::hashBytes(hasher, flags, sizeof(flags));
+    if (roiFrame != NULL)
+    {
+        const int64_t* dims = volSpace.getDims();
+        CacheFileHelper::hashBytes(hasher, roiFrame, dims[0] * dims[1] * dims[2] * sizeof(float));
+    }
+    CacheFileHelper::hashBytes(hasher, &subdivisions, sizeof(subdivisions));
+    CacheFileHelper::hashBytes(hasher, &gaussScale, sizeof(gaussScale));
+    if (gaussScale > 0.0f)
+    {
+        CacheFileHelper::hashSurface(hasher, gaussSurf);
+    }
+    const QByteArray key = hasher.result();
+    CaretPointer<const VoxelWeightMatrix> ret = VoxelWeightMatrix::getCached(key, weightsCacheDir);
+    if (ret != NULL) return ret;
+    vector<vector<VoxelWeight> > myWeights;
+    precomputeWeightsRibbon(myWeights, volSpace, innerSurf, outerSurf, roiFrame, roiWeights, subdivisions, thinColumns, gaussSurf, gaussScale);
+    ret.grabNew(new VoxelWeightMatrix(myWeights, volSpace.getDims(), true));//ribbon divides by the total weight of each vertex
+    VoxelWeightMatrix::addToCache(key, weightsCacheDir, ret);
+    return ret;
+}
+
+CaretPointer<const VoxelWeightMatrix> AlgorithmVolumeToSurfaceMapping::getWeightsMyelin(const SurfaceFile* mySurface, const VolumeFile* roiVol, const MetricFile* thickness, const float& sigma,
+                                                                                        const bool& oldCutoffBug, const AString& weightsCacheDir)
+{
+    QCryptographicHash hasher(QCryptographicHash::Sha1);
+    const char methodTag[] = "myelin style 1";
+    CacheFileHelper::hashBytes(hasher, methodTag, sizeof(methodTag));
+    const VolumeSpace& volSpace = roiVol->getVolumeSpace();
+    CacheFileHelper::hashVolumeSpace(hasher, volSpace);
+    CacheFileHelper::hashSurface(hasher, mySurface);//normals are computed from coordinates and topology
+    const int64_t* dims = volSpace.getDims();
+    CacheFileHelper::hashBytes(hasher, roiVol->getFrame(), dims[0] * dims[1] * dims[2] * sizeof(float));
+    CacheFileHelper::hashBytes(hasher, thickness->getValuePointerForColumn(0), mySurface->getNumberOfNodes() * sizeof(float));
+    CacheFileHelper::hashBytes(hasher, &sigma, sizeof(sigma));
+    const char legacyFlag = oldCutoffBug;
+    CacheFileHelper::hashBytes(hasher, &legacyFlag, sizeof(legacyFlag));
+    const QByteArray key = hasher.result();
+    CaretPointer<const VoxelWeightMatrix> ret = VoxelWeightMatrix::getCached(key, weightsCacheDir);
+    if (ret != NULL) return ret;
+    vector<vector<VoxelWeight> > myWeights;
+    precomputeWeightsMyelin(myWeights, mySurface, roiVol, thickness, sigma, oldCutoffBug);
+    ret.grabNew(new VoxelWeightMatrix(myWeights, dims, false));//weights have already been normalized in precompute, for this method
+    VoxelWeightMatrix::addToCache(key, weightsCacheDir, ret);
+    return ret;
+}
+
+void AlgorithmVolumeToSurfaceMapping::mapWithWeights(const VoxelWeightMatrix& myWeights, const VolumeFile* myVolume, MetricFile* myMetricOut, const int64_t& mySubVol, const AString& labelSuffix)
+{
+    vector<int64_t> myVolDims;
+    myVolume->getDimensions(myVolDims);
+    if (!myWeights.matchesDimensions(myVolDims.data())) throw AlgorithmException("voxel weights were computed for a volume with different dimensions");
+    const int64_t numNodes = myWeights.getNumberOfVertices();
+    if (numNodes != myMetricOut->getNumberOfNodes()) throw AlgorithmException("voxel weights were computed for a surface with a different number of vertices");
+    vector<pair<int64_t, int64_t> > columnFrames;//brick and component of each output column
+    for (int64_t i = 0; i < myVolDims[3]; ++i)
+    {
+        if (mySubVol != -1 && i != mySubVol) continue;
+        for (int64_t j = 0; j < myVolDims[4]; ++j)
+        {
+            columnFrames.push_back(make_pair(i, j));
+        }
+    }
+    const int64_t numColumns = (int64_t)columnFrames.size();
+    vector<vector<float> > scratch(min(COLUMN_BLOCK, numColumns), vector<float>(numNodes));
+    for (int64_t blockStart = 0; blockStart < numColumns; blockStart += COLUMN_BLOCK)
+    {
+        const int64_t blockEnd = min(blockStart + COLUMN_BLOCK, numColumns);
+        vector<const float*> frames;
+        vector<float*> outputs;
+        for (int64_t thisCol = blockStart; thisCol < blockEnd; ++thisCol)
+        {
+            frames.push_back(myVolume->getFrame(columnFrames[thisCol].first, columnFrames[thisCol].second));
+            outputs.push_back(scratch[thisCol - blockStart].data());
+        }
+        myWeights.apply(frames, outputs);
+        for (int64_t thisCol = blockStart; thisCol < blockEnd; ++thisCol)
+        {
+            AString metricLabel = myVolume->getMapName(columnFrames[thisCol].first);
+            if (myVolDims[4] != 1)
+            {
+                metricLabel += " component " + AString::number(columnFrames[thisCol].second);
+            }
+            metricLabel += labelSuffix;
+            myMetricOut->setColumnName(thisCol, metricLabel);
+            myMetricOut->setValuesForColumn(thisCol, scratch[thisCol - blockStart].data());
+        }
+    }
+}
+
 float AlgorithmVolumeToSurfaceMapping::getAlgorithmInternalWeight()
 {
     return 1.0f;//override this if needed, if the progress bar isn't smooth
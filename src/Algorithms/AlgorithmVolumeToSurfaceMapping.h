@@ -23,9 +23,11 @@
 
 #include "AbstractAlgorithm.h"
 
+#include "CaretPointer.h"
 #include "RibbonMappingHelper.h"
 #include "Vector3D.h"
 #include "VolumeFile.h"
+#include "VoxelWeightMatrix.h"
 
 #include <vector>
 
@@ -38,6 +40,12 @@ namespace caret {
                                             const MetricFile* thickness, const float& sigma, const bool& oldCutoffBug);
         static void precomputeWeightsRibbon(std::vector<std::vector<VoxelWeight> >& myWeights, const VolumeSpace& volSpace, const SurfaceFile* innerSurf, const SurfaceFile* outerSurf,
                                             const float* roiFrame, const bool roiWeights, const int& subdivisions, const bool& thinColumns, const SurfaceFile* gaussSurf, const float& gaussScale);
+        static CaretPointer<const VoxelWeightMatrix> getWeightsMyelin(const SurfaceFile* mySurface, const VolumeFile* roiVol, const MetricFile* thickness, const float& sigma,
+                                                                      const bool& oldCutoffBug, const AString& weightsCacheDir);
+        static CaretPointer<const VoxelWeightMatrix> getWeightsRibbon(const VolumeSpace& volSpace, const SurfaceFile* innerSurf, const SurfaceFile* outerSurf,
+                                                                      const float* roiFrame, const bool roiWeights, const int& subdivisions, const bool& thinColumns,
+                                                                      const SurfaceFile* gaussSurf, const float& gaussScale, const AString& weightsCacheDir);
+        static void mapWithWeights(const VoxelWeightMatrix& myWeights, const VolumeFile* myVolume, MetricFile* myMetricOut, const int64_t& mySubVol, const AString& labelSuffix);
         enum Method
         {
             TRILINEAR,
@@ -56,13 +64,14 @@ namespace caret {
                                         const SurfaceFile* innerSurf, const SurfaceFile* outerSurf,
                                         const VolumeFile* roiVol = NULL, const bool roiWeights = false, const int32_t& subdivisions = 3, const bool& thinColumns = false,
                                         const int64_t& mySubVol = -1, const float& gaussScale = -1.0f, MetricFile* badVertices = NULL,
-                                        const int& weightsOutVertex = -1, VolumeFile* weightsOut = NULL);
+                                        const int& weightsOutVertex = -1, VolumeFile* weightsOut = NULL, const AString& weightsCacheDir = "");
         AlgorithmVolumeToSurfaceMapping(ProgressObject* myProgObj, const VolumeFile* myVolume, const SurfaceFile* mySurface, MetricFile* myMetricOut,
                                         const SurfaceFile* innerSurf, const SurfaceFile* outerSurf, const VolumeFile::InterpType interpType,
                                         const VolumeFile* roiVol = NULL, const bool roiWeights = false, const int32_t& subdivisions = 3, const bool& thinColumns = false,
                                         const int64_t& mySubVol = -1, const float& gaussScale = -1.0f, MetricFile* badVertices = NULL);
         AlgorithmVolumeToSurfaceMapping(ProgressObject* myProgObj, const VolumeFile* myVolume, const SurfaceFile* mySurface, MetricFile* myMetricOut,
-                                        const VolumeFile* roiVol, const MetricFile* thickness, const float& sigma, const int64_t& mySubVol = -1, const bool& oldCutoffBug = false);
+                                        const VolumeFile* roiVol, const MetricFile* thickness, const float& sigma, const int64_t& mySubVol = -1, const bool& oldCutoffBug = false,
+                                        const AString& weightsCacheDir = "");
         static OperationParameters* getParameters();
         static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
         static AString getCommandSwitch();
@@ -0,0 +1,256 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiParcellationMatrix.h"
+
+#include "AlgorithmException.h"
+#include "CaretAssert.h"
+#include "CaretOMP.h"
+#include "CiftiFile.h"
+
+#include <algorithm>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int64_t BLOCK_BYTES = 64 * 1024 * 1024;//memory for a block of input rows
+    const int64_t COLUMN_CHUNK = 512;//columns per parallel task when accumulating along column
+}
+
+CiftiParcellationMatrix::CiftiParcellationMatrix(const vector<int>& indexToParcel, const int64_t& numParcels, const vector<float>& denseWeights)
+{
+    m_numDense = (int64_t)indexToParcel.size();
+    bool weighted = !denseWeights.empty();
+    CaretAssert(!weighted || (int64_t)denseWeights.size() == m_numDense);
+    m_parcelStart.assign(numParcels + 1, 0);
+    for (int64_t i = 0; i < m_numDense; ++i)
+    {
+        int parcel = indexToParcel[i];
+        CaretAssert(parcel > -2 && parcel < numParcels);
+        if (parcel != -1)
+        {
+            ++m_parcelStart[parcel + 1];
+        }
+    }
+    for (int64_t p = 0; p < numParcels; ++p)
+    {
+        m_parcelStart[p + 1] += m_parcelStart[p];
+    }
+    int64_t numMembers = m_parcelStart[numParcels];
+    m_parcelMembers.resize(numMembers);
+    m_parcelMemberWeights.resize(numMembers);
+    m_denseStart.resize(m_numDense + 1);
+    m_denseParcels.reserve(numMembers);
+    m_denseParcelWeights.reserve(numMembers);
+    m_weightSums.assign(numParcels, 0.0);
+    vector<int64_t> nextMember(m_parcelStart.begin(), m_parcelStart.end() - 1);
+    for (int64_t i = 0; i < m_numDense; ++i)//members are in ascending order, to sum in the same order as ReductionOperation
+    {
+        m_denseStart[i] = (int64_t)m_denseParcels.size();
+        int parcel = indexToParcel[i];
+        if (parcel != -1)
+        {
+            float weight = (weighted ? denseWeights[i] : 1.0f);
+            m_parcelMembers[nextMember[parcel]] = i;
+            m_parcelMemberWeights[nextMember[parcel]] = weight;
+            ++nextMember[parcel];
+            m_denseParcels.push_back(parcel);
+            m_denseParcelWeights.push_back(weight);
+            m_weightSums[parcel] += weight;
+        }
+    }
+    m_denseStart[m_numDense] = (int64_t)m_denseParcels.size();
+}
+
+bool CiftiParcellationMatrix::isMethodSupported(const ReductionEnum::Enum& method)
+{
+    switch (method)
+    {
+        case ReductionEnum::MEAN:
+        case ReductionEnum::SUM:
+            return true;
+        default:
+            return false;
+    }
+}
+
+float CiftiParcellationMatrix::finishParcel(const double& accum, const int64_t& parcel, const ReductionEnum::Enum& method, const float& emptyFillVal) const
+{
+    if (getParcelMemberCount(parcel) == 0) return emptyFillVal;
+    if (method == ReductionEnum::SUM) return accum;
+    CaretAssert(method == ReductionEnum::MEAN);
+    return accum / m_weightSums[parcel];
+}
+
+void CiftiParcellationMatrix::reduceRow(const float* denseRow, float* parcelRowOut, const ReductionEnum::Enum& method, const float& emptyFillVal) const
+{
+    int64_t numParcels = getNumberOfParcels();
+    for (int64_t p = 0; p < numParcels; ++p)
+    {
+        double accum = 0.0;
+        for (int64_t k = m_parcelStart[p]; k < m_parcelStart[p + 1]; ++k)
+        {
+            accum += m_parcelMemberWeights[k] * denseRow[m_parcelMembers[k]];//float product, like ReductionOperation::reduceWeighted
+        }
+        parcelRowOut[p] = finishParcel(accum, p, method, emptyFillVal);
+    }
+}
+
+void CiftiParcellationMatrix::parcellate(const CiftiFile* ciftiIn, const int& direction, const vector<const CiftiParcellationMatrix*>& matrices, const vector<CiftiFile*>& ciftiOuts,
+                                         const ReductionEnum::Enum& method, const float& emptyFillVal)
+{
+    const CiftiXML& inXML = ciftiIn->getCiftiXML();
+    if (inXML.getNumberOfDimensions() != 2) throw AlgorithmException("parcellation matrices only support 2D cifti files");
+    if (!isMethodSupported(method)) throw AlgorithmException("parcellation matrices do not support reduction method " + ReductionEnum::toName(method));
+    CaretAssert(direction == CiftiXML::ALONG_ROW || direction == CiftiXML::ALONG_COLUMN);
+    CaretAssert(matrices.size() == ciftiOuts.size());
+    for (int m = 0; m < (int)matrices.size(); ++m)
+    {
+        CaretAssert(matrices[m]->getNumberOfDense() == inXML.getDimensionLength(direction));
+        CaretAssert(ciftiOuts[m]->getCiftiXML().getDimensionLength(direction) == matrices[m]->getNumberOfParcels());
+    }
+    if (direction == CiftiXML::ALONG_ROW)
+    {
+        parcellateAlongRow(ciftiIn, matrices, ciftiOuts, method, emptyFillVal);
+    } else {
+        parcellateAlongColumn(ciftiIn, matrices, ciftiOuts, method, emptyFillVal);
+    }
+}
+
+void CiftiParcellationMatrix::parcellateAlongRow(const CiftiFile* ciftiIn, const vector<const CiftiParcellationMatrix*>& matrices, const vector<CiftiFile*>& ciftiOuts,
+                                                 const ReductionEnum::Enum& method, const float& emptyFillVal)
+{//each row is reduced independently, so read a block of rows, reduce them in parallel, then write them
+    const CiftiXML& inXML = ciftiIn->getCiftiXML();
+    int64_t numRows = inXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
+    int64_t numCols = inXML.getDimensionLength(CiftiXML::ALONG_ROW);
+    int numMatrices = (int)matrices.size();
+    int64_t blockRows = max(int64_t(1), min(numRows, BLOCK_BYTES / (numCols * (int64_t)sizeof(float))));
+    vector<float> inBlock(blockRows * numCols);
+    vector<vector<float> > outBlocks(numMatrices);
+    for (int m = 0; m < numMatrices; ++m)
+    {
+        outBlocks[m].resize(blockRows * matrices[m]->getNumberOfParcels());
+    }
+    for (int64_t blockStart = 0; blockStart < numRows; blockStart += blockRows)
+    {
+        int64_t numBlockRows = min(blockRows, numRows - blockStart);
+        for (int64_t r = 0; r < numBlockRows; ++r)
+        {
+            ciftiIn->getRow(inBlock.data() + r * numCols, blockStart + r);
+        }
+        int64_t numTasks = numBlockRows * numMatrices;
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t task = 0; task < numTasks; ++task)
+        {
+            int64_t r = task / numMatrices;
+            int m = (int)(task % numMatrices);
+            matrices[m]->reduceRow(inBlock.data() + r * numCols, outBlocks[m].data() + r * matrices[m]->getNumberOfParcels(), method, emptyFillVal);
+        }
+        for (int m = 0; m < numMatrices; ++m)
+        {
+            for (int64_t r = 0; r < numBlockRows; ++r)
+            {
+                ciftiOuts[m]->setRow(outBlocks[m].data() + r * matrices[m]->getNumberOfParcels(), blockStart + r);
+            }
+        }
+    }
+}
+
+void CiftiParcellationMatrix::parcellateAlongColumn(const CiftiFile* ciftiIn, const vector<const CiftiParcellationMatrix*>& matrices, const vector<CiftiFile*>& ciftiOuts,
+                                                    const ReductionEnum::Enum& method, const float& emptyFillVal)
+{//each output row is a weighted sum of input rows, so accumulate every output row while reading each used input row once
+    const CiftiXML& inXML = ciftiIn->getCiftiXML();
+    int64_t numRows = inXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
+    int64_t numCols = inXML.getDimensionLength(CiftiXML::ALONG_ROW);
+    int numMatrices = (int)matrices.size();
+    vector<vector<double> > accum(numMatrices);
+    for (int m = 0; m < numMatrices; ++m)
+    {
+        accum[m].assign(matrices[m]->getNumberOfParcels() * numCols, 0.0);
+    }
+    int64_t blockRows = max(int64_t(1), min(numRows, BLOCK_BYTES / (numCols * (int64_t)sizeof(float))));
+    vector<float> inBlock(blockRows * numCols);
+    vector<int64_t> blockRowIndices;
+    blockRowIndices.reserve(blockRows);
+    int64_t numChunks = (numCols + COLUMN_CHUNK - 1) / COLUMN_CHUNK;
+    int64_t row = 0;
+    while (row < numRows)
+    {
+        blockRowIndices.clear();
+        while (row < numRows && (int64_t)blockRowIndices.size() < blockRows)
+        {
+            bool used = false;//rows that aren't in any parcel are never read
+            for (int m = 0; m < numMatrices; ++m)
+            {
+                if (matrices[m]->m_denseStart[row + 1] > matrices[m]->m_denseStart[row])
+                {
+                    used = true;
+                    break;
+                }
+            }
+            if (used)
+            {
+                ciftiIn->getRow(inBlock.data() + blockRowIndices.size() * numCols, row);
+                blockRowIndices.push_back(row);
+            }
+            ++row;
+        }
+        int64_t numBlockRows = (int64_t)blockRowIndices.size();
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t chunk = 0; chunk < numChunks; ++chunk)
+        {//each task owns a range of columns of every accumulator, rows are added in ascending order like ReductionOperation
+            int64_t colStart = chunk * COLUMN_CHUNK, colEnd = min(numCols, colStart + COLUMN_CHUNK);
+            for (int64_t r = 0; r < numBlockRows; ++r)
+            {
+                const float* inRow = inBlock.data() + r * numCols;
+                int64_t dense = blockRowIndices[r];
+                for (int m = 0; m < numMatrices; ++m)
+                {
+                    const CiftiParcellationMatrix& matrix = *(matrices[m]);
+                    for (int64_t k = matrix.m_denseStart[dense]; k < matrix.m_denseStart[dense + 1]; ++k)
+                    {
+                        float weight = matrix.m_denseParcelWeights[k];
+                        double* accumRow = accum[m].data() + matrix.m_denseParcels[k] * numCols;
+                        for (int64_t j = colStart; j < colEnd; ++j)
+                        {
+                            accumRow[j] += weight * inRow[j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+    vector<float> outRow(numCols);
+    for (int m = 0; m < numMatrices; ++m)
+    {
+        int64_t numParcels = matrices[m]->getNumberOfParcels();
+        for (int64_t p = 0; p < numParcels; ++p)
+        {
+            const double* accumRow = accum[m].data() + p * numCols;
+            for (int64_t j = 0; j < numCols; ++j)
+            {
+                outRow[j] = matrices[m]->finishParcel(accumRow[j], p, method, emptyFillVal);
+            }
+            ciftiOuts[m]->setRow(outRow.data(), p);
+        }
+    }
+}
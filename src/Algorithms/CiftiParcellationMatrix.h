@@ -0,0 +1,74 @@
+#ifndef __CIFTI_PARCELLATION_MATRIX_H__
+#define __CIFTI_PARCELLATION_MATRIX_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "ReductionEnum.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+
+    class CiftiFile;
+
+    ///sparse (CSR) matrix that reduces dense brainordinates to parcels by (weighted) sum or mean
+    class CiftiParcellationMatrix
+    {
+        int64_t m_numDense;
+
+        ///parcel-major (CSR): members of parcel p are [m_parcelStart[p], m_parcelStart[p + 1])
+        std::vector<int64_t> m_parcelStart, m_parcelMembers;
+        std::vector<float> m_parcelMemberWeights;
+
+        ///dense-major (CSC) copy of the same matrix, for accumulating one dense row at a time
+        std::vector<int64_t> m_denseStart, m_denseParcels;
+        std::vector<float> m_denseParcelWeights;
+
+        std::vector<double> m_weightSums;
+
+        static void parcellateAlongRow(const CiftiFile* ciftiIn, const std::vector<const CiftiParcellationMatrix*>& matrices, const std::vector<CiftiFile*>& ciftiOuts,
+                                       const ReductionEnum::Enum& method, const float& emptyFillVal);
+        static void parcellateAlongColumn(const CiftiFile* ciftiIn, const std::vector<const CiftiParcellationMatrix*>& matrices, const std::vector<CiftiFile*>& ciftiOuts,
+                                          const ReductionEnum::Enum& method, const float& emptyFillVal);
+        float finishParcel(const double& accum, const int64_t& parcel, const ReductionEnum::Enum& method, const float& emptyFillVal) const;
+    public:
+        ///indexToParcel has -1 for brainordinates not in a parcel, denseWeights may be empty for unweighted
+        CiftiParcellationMatrix(const std::vector<int>& indexToParcel, const int64_t& numParcels, const std::vector<float>& denseWeights = std::vector<float>());
+
+        int64_t getNumberOfParcels() const { return (int64_t)m_weightSums.size(); }
+        int64_t getNumberOfDense() const { return m_numDense; }
+        int64_t getParcelMemberCount(const int64_t& parcel) const { return m_parcelStart[parcel + 1] - m_parcelStart[parcel]; }
+
+        ///reductions that are a linear function of the data
+        static bool isMethodSupported(const ReductionEnum::Enum& method);
+
+        ///reduce one dense row to parcels, empty parcels get emptyFillVal
+        void reduceRow(const float* denseRow, float* parcelRowOut, const ReductionEnum::Enum& method, const float& emptyFillVal) const;
+
+        ///parcellate a 2D cifti file by several matrices while reading the input only once, output XML must already be set
+        static void parcellate(const CiftiFile* ciftiIn, const int& direction, const std::vector<const CiftiParcellationMatrix*>& matrices, const std::vector<CiftiFile*>& ciftiOuts,
+                               const ReductionEnum::Enum& method, const float& emptyFillVal);
+    };
+
+}
+
+#endif //__CIFTI_PARCELLATION_MATRIX_H__
@@ -0,0 +1,292 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiStructureView.h"
+
+#include "AlgorithmException.h"
+#include "CaretAssert.h"
+#include "CiftiFile.h"
+#include "Vector3D.h"
+
+#include <algorithm>
+
+using namespace caret;
+using namespace std;
+
+CiftiStructureView::CiftiStructureView(const CiftiBrainModelsMap& myMap, const StructureEnum::Enum& structure, const bool& volumeModel)
+{
+    if (volumeModel)
+    {
+        if (!myMap.hasVolumeData(structure)) throw AlgorithmException("cifti mapping does not contain volume structure " + StructureEnum::toName(structure));
+        setupVolume(myMap, false, structure);
+        return;
+    }
+    if (!myMap.hasSurfaceData(structure)) throw AlgorithmException("cifti mapping does not contain surface structure " + StructureEnum::toName(structure));
+    m_isVolume = false;
+    m_numElements = myMap.getSurfaceNumberOfNodes(structure);
+    vector<CiftiBrainModelsMap::SurfaceMap> surfMap = myMap.getSurfaceMap(structure);
+    m_elements.resize(surfMap.size());
+    m_ciftiIndices.resize(surfMap.size());
+    for (size_t i = 0; i < surfMap.size(); ++i)
+    {
+        m_elements[i] = surfMap[i].m_surfaceNode;
+        m_ciftiIndices[i] = surfMap[i].m_ciftiIndex;
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        m_volDims[i] = 0;
+        m_volOffset[i] = 0;
+    }
+}
+
+CiftiStructureView::CiftiStructureView(const CiftiBrainModelsMap& myMap)
+{
+    if (!myMap.hasVolumeData()) throw AlgorithmException("cifti mapping does not contain volume data");
+    setupVolume(myMap, true, StructureEnum::INVALID);
+}
+
+void CiftiStructureView::setupVolume(const CiftiBrainModelsMap& myMap, const bool& allStructures, const StructureEnum::Enum& structure)
+{
+    m_isVolume = true;
+    vector<CiftiBrainModelsMap::VolumeMap> volMap;
+    if (allStructures)
+    {
+        volMap = myMap.getFullVolumeMap();
+    } else {
+        volMap = myMap.getVolumeStructureMap(structure);
+    }
+    CaretAssert(!volMap.empty());
+    int64_t extrema[6] = { volMap[0].m_ijk[0], volMap[0].m_ijk[0], volMap[0].m_ijk[1], volMap[0].m_ijk[1], volMap[0].m_ijk[2], volMap[0].m_ijk[2] };
+    for (size_t i = 1; i < volMap.size(); ++i)
+    {//same bounding box as cifti-separate -crop
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            extrema[axis * 2] = min(extrema[axis * 2], volMap[i].m_ijk[axis]);
+            extrema[axis * 2 + 1] = max(extrema[axis * 2 + 1], volMap[i].m_ijk[axis]);
+        }
+    }
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        m_volOffset[axis] = extrema[axis * 2];
+        m_volDims[axis] = extrema[axis * 2 + 1] - extrema[axis * 2] + 1;
+    }
+    m_volSform = myMap.getVolumeSpace().getSform();
+    Vector3D ivec, jvec, kvec, shift;
+    ivec[0] = m_volSform[0][0]; ivec[1] = m_volSform[1][0]; ivec[2] = m_volSform[2][0];
+    jvec[0] = m_volSform[0][1]; jvec[1] = m_volSform[1][1]; jvec[2] = m_volSform[2][1];
+    kvec[0] = m_volSform[0][2]; kvec[1] = m_volSform[1][2]; kvec[2] = m_volSform[2][2];
+    shift = m_volOffset[0] * ivec + m_volOffset[1] * jvec + m_volOffset[2] * kvec;
+    m_volSform[0][3] += shift[0];
+    m_volSform[1][3] += shift[1];
+    m_volSform[2][3] += shift[2];
+    m_numElements = m_volDims[0] * m_volDims[1] * m_volDims[2];
+    m_elements.resize(volMap.size());
+    m_ciftiIndices.resize(volMap.size());
+    for (size_t i = 0; i < volMap.size(); ++i)
+    {
+        m_elements[i] = (volMap[i].m_ijk[0] - m_volOffset[0]) + m_volDims[0] * ((volMap[i].m_ijk[1] - m_volOffset[1]) + m_volDims[1] * (volMap[i].m_ijk[2] - m_volOffset[2]));
+        m_ciftiIndices[i] = volMap[i].m_ciftiIndex;
+    }
+}
+
+void CiftiStructureView::getRoi(float* roiOut) const
+{
+    fill(roiOut, roiOut + m_numElements, 0.0f);
+    int64_t numUsed = (int64_t)m_elements.size();
+    for (int64_t i = 0; i < numUsed; ++i)
+    {
+        roiOut[m_elements[i]] = 1.0f;
+    }
+}
+
+void CiftiStructureView::gather(const float* mapData, const int64_t& stride, float* elementsOut) const
+{
+    fill(elementsOut, elementsOut + m_numElements, 0.0f);
+    int64_t numUsed = (int64_t)m_elements.size();
+    for (int64_t i = 0; i < numUsed; ++i)
+    {
+        elementsOut[m_elements[i]] = mapData[m_ciftiIndices[i] * stride];
+    }
+}
+
+void CiftiStructureView::scatter(const float* elementsIn, float* mapData, const int64_t& stride) const
+{
+    int64_t numUsed = (int64_t)m_elements.size();
+    for (int64_t i = 0; i < numUsed; ++i)
+    {
+        mapData[m_ciftiIndices[i] * stride] = elementsIn[m_elements[i]];
+    }
+}
+
+CiftiMapBlockReader::CiftiMapBlockReader(const CiftiFile* file, const int& brainordinateDir, const int64_t& blockBytes)
+{
+    CaretAssert(file != NULL);
+    const vector<int64_t>& dims = file->getDimensions();
+    if (dims.size() != 2) throw AlgorithmException("cifti map blocks are only supported on 2D cifti");
+    if (brainordinateDir != CiftiXML::ALONG_ROW && brainordinateDir != CiftiXML::ALONG_COLUMN) throw AlgorithmException("invalid direction for cifti map blocks");
+    m_file = file;
+    m_brainDir = brainordinateDir;
+    m_mapLength = dims[brainordinateDir];
+    m_numMaps = dims[1 - brainordinateDir];
+    m_direct = file->getInMemoryData();
+    if (m_direct != NULL)
+    {
+        m_blockMaps = m_numMaps;//nothing to buffer
+    } else if (m_brainDir == CiftiXML::ALONG_COLUMN) {
+        m_blockMaps = m_numMaps;//every row has an element of every map, so smaller blocks would read the whole file once per block
+    } else {
+        m_blockMaps = max((int64_t)1, min(m_numMaps, blockBytes / (m_mapLength * (int64_t)sizeof(float))));
+    }
+    m_blockStart = 0;
+    m_blockCount = 0;
+}
+
+void CiftiMapBlockReader::loadBlock(const int64_t& firstMap, const int64_t& count)
+{
+    CaretAssert(firstMap >= 0 && count > 0 && firstMap + count <= m_numMaps && count <= m_blockMaps);
+    m_blockStart = firstMap;
+    m_blockCount = count;
+    if (m_direct != NULL) return;
+    m_buffer.resize(m_mapLength * m_blockCount);
+    if (m_brainDir == CiftiXML::ALONG_ROW)
+    {//maps are rows
+        for (int64_t i = 0; i < m_blockCount; ++i)
+        {
+            m_file->getRow(m_buffer.data() + i * m_mapLength, m_blockStart + i);
+        }
+    } else {//maps are columns, read each row once, the block is always all maps
+        CaretAssert(m_blockCount == m_numMaps);
+        for (int64_t row = 0; row < m_mapLength; ++row)
+        {
+            m_file->getRow(m_buffer.data() + row * m_blockCount, row);
+        }
+    }
+}
+
+const float* CiftiMapBlockReader::getMap(const int64_t& map, int64_t& strideOut) const
+{
+    CaretAssert(map >= m_blockStart && map < m_blockStart + m_blockCount);
+    if (m_brainDir == CiftiXML::ALONG_ROW)
+    {
+        strideOut = 1;
+        if (m_direct != NULL) return m_direct + map * m_mapLength;
+        return m_buffer.data() + (map - m_blockStart) * m_mapLength;
+    }
+    if (m_direct != NULL)
+    {
+        strideOut = m_numMaps;
+        return m_direct + map;
+    }
+    strideOut = m_blockCount;
+    return m_buffer.data() + (map - m_blockStart);
+}
+
+CiftiMapBlockWriter::CiftiMapBlockWriter(CiftiFile* file, const int& brainordinateDir, const int64_t& blockMaps)
+{
+    CaretAssert(file != NULL);
+    const vector<int64_t>& dims = file->getDimensions();
+    if (dims.size() != 2) throw AlgorithmException("cifti map blocks are only supported on 2D cifti");
+    if (brainordinateDir != CiftiXML::ALONG_ROW && brainordinateDir != CiftiXML::ALONG_COLUMN) throw AlgorithmException("invalid direction for cifti map blocks");
+    m_file = file;
+    m_brainDir = brainordinateDir;
+    m_mapLength = dims[brainordinateDir];
+    m_numMaps = dims[1 - brainordinateDir];
+    m_blockMaps = max((int64_t)1, min(m_numMaps, blockMaps));
+    m_direct = file->getInMemoryDataForWriting();
+    m_blockStart = 0;
+    m_blockCount = 0;
+}
+
+void CiftiMapBlockWriter::startBlock(const int64_t& firstMap, const int64_t& count)
+{
+    CaretAssert(firstMap >= 0 && count > 0 && firstMap + count <= m_numMaps);
+    m_blockStart = firstMap;
+    m_blockCount = count;
+    if (m_direct != NULL) return;
+    CaretAssert(count <= m_blockMaps);
+    m_buffer.resize(m_mapLength * m_blockCount);
+    if (m_brainDir == CiftiXML::ALONG_ROW)
+    {
+        for (int64_t i = 0; i < m_blockCount; ++i)
+        {
+            m_file->getRow(m_buffer.data() + i * m_mapLength, m_blockStart + i, true);//tolerate short reads, the file may be partly written
+        }
+    } else {
+        if (m_blockCount == m_numMaps)
+        {
+            for (int64_t row = 0; row < m_mapLength; ++row)
+            {
+                m_file->getRow(m_buffer.data() + row * m_blockCount, row, true);
+            }
+        } else {
+            m_rowScratch.resize(m_numMaps);
+            for (int64_t row = 0; row < m_mapLength; ++row)
+            {
+                m_file->getRow(m_rowScratch.data(), row, true);
+                copy(m_rowScratch.begin() + m_blockStart, m_rowScratch.begin() + m_blockStart + m_blockCount, m_buffer.begin() + row * m_blockCount);
+            }
+        }
+    }
+}
+
+float* CiftiMapBlockWriter::getMap(const int64_t& map, int64_t& strideOut)
+{
+    CaretAssert(map >= m_blockStart && map < m_blockStart + m_blockCount);
+    if (m_brainDir == CiftiXML::ALONG_ROW)
+    {
+        strideOut = 1;
+        if (m_direct != NULL) return m_direct + map * m_mapLength;
+        return m_buffer.data() + (map - m_blockStart) * m_mapLength;
+    }
+    if (m_direct != NULL)
+    {
+        strideOut = m_numMaps;
+        return m_direct + map;
+    }
+    strideOut = m_blockCount;
+    return m_buffer.data() + (map - m_blockStart);
+}
+
+void CiftiMapBlockWriter::flushBlock()
+{
+    if (m_direct != NULL) return;
+    if (m_brainDir == CiftiXML::ALONG_ROW)
+    {
+        for (int64_t i = 0; i < m_blockCount; ++i)
+        {
+            m_file->setRow(m_buffer.data() + i * m_mapLength, m_blockStart + i);
+        }
+    } else {
+        if (m_blockCount == m_numMaps)
+        {
+            for (int64_t row = 0; row < m_mapLength; ++row)
+            {
+                m_file->setRow(m_buffer.data() + row * m_blockCount, row);
+            }
+        } else {
+            for (int64_t row = 0; row < m_mapLength; ++row)
+            {
+                m_file->getRow(m_rowScratch.data(), row, true);
+                copy(m_buffer.begin() + row * m_blockCount, m_buffer.begin() + (row + 1) * m_blockCount, m_rowScratch.begin() + m_blockStart);
+                m_file->setRow(m_rowScratch.data(), row);
+            }
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef __CIFTI_STRUCTURE_VIEW_H__
+#define __CIFTI_STRUCTURE_VIEW_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "StructureEnum.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+
+    class CiftiBrainModelsMap;
+    class CiftiFile;
+
+    ///one structure of a cifti brain models dimension, as surface vertices or voxels of a cropped volume
+    ///a "map" is all brainordinates for one index along the other dimension, addressed with a stride, so views can read and write
+    ///directly into in-memory cifti data or a block buffer, instead of separating into a metric or volume file and replacing back
+    class CiftiStructureView
+    {
+        bool m_isVolume;
+        int64_t m_numElements;
+        std::vector<int64_t> m_elements, m_ciftiIndices;//parallel, element is vertex or linear voxel index in the cropped volume
+        int64_t m_volDims[3], m_volOffset[3];
+        std::vector<std::vector<float> > m_volSform;
+
+        void setupVolume(const CiftiBrainModelsMap& myMap, const bool& allStructures, const StructureEnum::Enum& structure);
+    public:
+        ///surface structure, or volume structure if volumeModel is true
+        CiftiStructureView(const CiftiBrainModelsMap& myMap, const StructureEnum::Enum& structure, const bool& volumeModel = false);
+        ///all volume structures together
+        explicit CiftiStructureView(const CiftiBrainModelsMap& myMap);
+
+        bool isVolume() const { return m_isVolume; }
+        ///number of vertices, or voxels in the cropped volume
+        int64_t getNumberOfElements() const { return m_numElements; }
+        ///number of brainordinates actually in the cifti file
+        int64_t getNumberOfBrainordinates() const { return (int64_t)m_ciftiIndices.size(); }
+
+        ///cropped volume space, like cifti-separate -crop
+        const int64_t* getVolumeDimensions() const { return m_volDims; }
+        const int64_t* getVolumeOffset() const { return m_volOffset; }
+        const std::vector<std::vector<float> >& getVolumeSform() const { return m_volSform; }
+
+        ///1 for elements in the cifti file, 0 otherwise
+        void getRoi(float* roiOut) const;
+        ///element values of a map, element e gets mapData[ciftiIndex * stride], elements not in the file get 0
+        void gather(const float* mapData, const int64_t& stride, float* elementsOut) const;
+        ///write element values into a map, only brainordinates of this structure are touched
+        void scatter(const float* elementsIn, float* mapData, const int64_t& stride) const;
+    };
+
+    ///read access to blocks of maps of a 2D cifti file, pointing into the file's own memory when it is in memory
+    class CiftiMapBlockReader
+    {
+        const CiftiFile* m_file;
+        int m_brainDir;
+        int64_t m_numMaps, m_mapLength, m_blockMaps, m_blockStart, m_blockCount;
+        const float* m_direct;
+        std::vector<float> m_buffer;
+    public:
+        ///brainordinateDir is the cifti direction that the structure views index, blockBytes bounds the buffer used for on-disk files with maps as rows
+        ///on-disk files with maps as columns are read in a single block of all maps, so that each row is only read once
+        CiftiMapBlockReader(const CiftiFile* file, const int& brainordinateDir, const int64_t& blockBytes = 128 * 1024 * 1024);
+        int64_t getNumberOfMaps() const { return m_numMaps; }
+        int64_t getMapLength() const { return m_mapLength; }
+        ///maximum maps per block
+        int64_t getBlockMaps() const { return m_blockMaps; }
+        ///load maps [firstMap, firstMap + count), count must be at most getBlockMaps()
+        void loadBlock(const int64_t& firstMap, const int64_t& count);
+        ///map in the current block, element i is at the returned pointer + i * strideOut
+        const float* getMap(const int64_t& map, int64_t& strideOut) const;
+    };
+
+    ///write access to blocks of maps of a 2D cifti file, writing in place when the file is in memory, output XML must already be set
+    class CiftiMapBlockWriter
+    {
+        CiftiFile* m_file;
+        int m_brainDir;
+        int64_t m_numMaps, m_mapLength, m_blockMaps, m_blockStart, m_blockCount;
+        float* m_direct;
+        std::vector<float> m_buffer, m_rowScratch;
+    public:
+        CiftiMapBlockWriter(CiftiFile* file, const int& brainordinateDir, const int64_t& blockMaps);
+        ///start maps [firstMap, firstMap + count), values not written before flushBlock are left as they were, or 0 for a new file
+        void startBlock(const int64_t& firstMap, const int64_t& count);
+        float* getMap(const int64_t& map, int64_t& strideOut);
+        void flushBlock();
+    };
+
+}
+
+#endif //__CIFTI_STRUCTURE_VIEW_H__
@@ -0,0 +1,104 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "DotProductTile.h"
+
+#include "CaretAssert.h"
+
+#include <algorithm>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int MICRO = 4;//rows of A and of B per register block
+    const int LANES = 4;//independent partial sums per dot product, so the lane loop vectorizes without reassociation (16 SSE accumulators)
+    const int64_t K_CHUNK = 256;//float partial sums are flushed to double this often, and this much of each row is kept hot in cache
+}
+
+void caret::dotProductTile(const float* A, const int64_t& aStride, const int64_t& numA,
+                           const float* B, const int64_t& bStride, const int64_t& numB,
+                           const int64_t& length, double* out)
+{
+    CaretAssert(numA > 0 && numB > 0 && length >= 0);
+    fill(out, out + numA * numB, 0.0);
+    for (int64_t kStart = 0; kStart < length; kStart += K_CHUNK)
+    {
+        int64_t kEnd = min(length, kStart + K_CHUNK);
+        int64_t kVecEnd = kStart + ((kEnd - kStart) / LANES) * LANES;
+        for (int64_t i0 = 0; i0 < numA; i0 += MICRO)
+        {
+            const float* arows[MICRO];
+            for (int ii = 0; ii < MICRO; ++ii)
+            {
+                arows[ii] = A + min(i0 + ii, numA - 1) * aStride;//repeat the last row for a ragged edge, results are not stored
+            }
+            for (int64_t j0 = 0; j0 < numB; j0 += MICRO)
+            {
+                const float* brows[MICRO];
+                for (int jj = 0; jj < MICRO; ++jj)
+                {
+                    brows[jj] = B + min(j0 + jj, numB - 1) * bStride;
+                }
+                float partial[MICRO][MICRO][LANES] = {};
+                for (int64_t k = kStart; k < kVecEnd; k += LANES)
+                {
+                    for (int ii = 0; ii < MICRO; ++ii)
+                    {
+                        const float* aptr = arows[ii] + k;
+                        for (int jj = 0; jj < MICRO; ++jj)
+                        {
+                            const float* bptr = brows[jj] + k;
+                            for (int l = 0; l < LANES; ++l)
+                            {
+                                partial[ii][jj][l] += aptr[l] * bptr[l];
+                            }
+                        }
+                    }
+                }
+                for (int64_t k = kVecEnd; k < kEnd; ++k)
+                {
+                    for (int ii = 0; ii < MICRO; ++ii)
+                    {
+                        for (int jj = 0; jj < MICRO; ++jj)
+                        {
+                            partial[ii][jj][0] += arows[ii][k] * brows[jj][k];
+                        }
+                    }
+                }
+                int iCount = (int)min((int64_t)MICRO, numA - i0), jCount = (int)min((int64_t)MICRO, numB - j0);
+                for (int ii = 0; ii < iCount; ++ii)
+                {
+                    double* outRow = out + (i0 + ii) * numB + j0;
+                    for (int jj = 0; jj < jCount; ++jj)
+                    {
+                        double sum = 0.0;
+                        for (int l = 0; l < LANES; ++l)
+                        {
+                            sum += partial[ii][jj][l];
+                        }
+                        outRow[jj] += sum;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef __DOT_PRODUCT_TILE_H__
+#define __DOT_PRODUCT_TILE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <stdint.h>
+
+namespace caret {
+
+    ///register-blocked tile of dot products between two sets of float rows: out[i * numB + j] = dot(A row i, B row j), accumulated in double
+    ///this is the inner kernel for correlation-like computations, callers split large problems into tiles and parallelize over tiles
+    void dotProductTile(const float* A, const int64_t& aStride, const int64_t& numA,
+                        const float* B, const int64_t& bStride, const int64_t& numB,
+                        const int64_t& length, double* out);
+
+}
+
+#endif //__DOT_PRODUCT_TILE_H__
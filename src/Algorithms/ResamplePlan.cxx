@@ -0,0 +1,247 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "ResamplePlan.h"
+
+#include "AlgorithmException.h"
+#include "AlgorithmVolumeResample.h"
+#include "CacheFileHelper.h"
+#include "CaretAssert.h"
+#include "CaretOMP.h"
+#include "SurfaceFile.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const char FILE_MAGIC[8] = { 'W', 'B', 'R', 'S', 'P', 'L', 'A', 'N' };
+    const int64_t FILE_VERSION = 2;//version 1 volume keys didn't include the transforms
+    const char SURFACE_KEY_TAG = 'S', VOLUME_KEY_TAG = 'V';//so a surface key can never equal a volume key
+
+    void writeKey(ostream& outFile, const QByteArray& key)
+    {
+        int64_t keySize = key.size();
+        outFile.write((const char*)&keySize, sizeof(keySize));
+        outFile.write(key.constData(), keySize);
+    }
+
+    bool readKey(istream& inFile, QByteArray& key)
+    {
+        int64_t keySize = -1;
+        inFile.read((char*)&keySize, sizeof(keySize));
+        if (!inFile || keySize < 0 || keySize > 1024) return false;
+        key.resize((int)keySize);
+        inFile.read(key.data(), keySize);
+        return (bool)inFile;
+    }
+
+    bool indexValid(const int64_t* dims, const int64_t& i, const int64_t& j, const int64_t& k)
+    {
+        return i >= 0 && i < dims[0] && j >= 0 && j < dims[1] && k >= 0 && k < dims[2];
+    }
+}
+
+QByteArray ResamplePlan::surfaceKey(const SurfaceResamplingMethodEnum::Enum& method, const SurfaceFile* currentSphere, const SurfaceFile* newSphere,
+                                    const float* currentAreas, const float* newAreas, const float* currentRoi)
+{
+    QCryptographicHash hasher(QCryptographicHash::Sha1);
+    const AString methodName = SurfaceResamplingMethodEnum::toName(method);
+    hasher.addData(&SURFACE_KEY_TAG, 1);
+    hasher.addData(methodName.toUtf8());
+    CacheFileHelper::hashSurface(hasher, currentSphere);
+    CacheFileHelper::hashSurface(hasher, newSphere);
+    if (method == SurfaceResamplingMethodEnum::ADAP_BARY_AREA)//barycentric ignores areas, don't make them part of the key
+    {
+        CaretAssert(currentAreas != NULL && newAreas != NULL);
+        CacheFileHelper::hashBytes(hasher, currentAreas, currentSphere->getNumberOfNodes() * sizeof(float));
+        CacheFileHelper::hashBytes(hasher, newAreas, newSphere->getNumberOfNodes() * sizeof(float));
+    }
+    const char hasRoi = (currentRoi != NULL ? 1 : 0);
+    hasher.addData(&hasRoi, 1);
+    if (currentRoi != NULL)
+    {//only whether a vertex is in the roi matters to the weights
+        const int32_t numNodes = currentSphere->getNumberOfNodes();
+        vector<char> roiMask(numNodes);
+        for (int32_t i = 0; i < numNodes; ++i)
+        {
+            roiMask[i] = (currentRoi[i] > 0.0f ? 1 : 0);
+        }
+        CacheFileHelper::hashBytes(hasher, roiMask.data(), numNodes);
+    }
+    return hasher.result();
+}
+
+QByteArray ResamplePlan::volumeKey(const VolumeSpace& inSpace, const XfmStack& myStack, const VolumeSpace& refSpace, const VolumeFile::InterpType& method)
+{
+    QCryptographicHash hasher(QCryptographicHash::Sha1);
+    const int32_t methodInt = (int32_t)method;
+    hasher.addData(&VOLUME_KEY_TAG, 1);
+    CacheFileHelper::hashBytes(hasher, &methodInt, sizeof(methodInt));
+    CacheFileHelper::hashVolumeSpace(hasher, inSpace);
+    CacheFileHelper::hashVolumeSpace(hasher, refSpace);
+    myStack.addToHash(hasher);
+    return hasher.result();
+}
+
+CaretPointer<const VoxelWeightMatrix> ResamplePlan::computeVolumeWeights(const VolumeSpace& inSpace, const XfmStack& myStack, const VolumeSpace& refSpace,
+                                                                         const VolumeFile::InterpType& method)
+{
+    const int64_t* inDims = inSpace.getDims(), *refDims = refSpace.getDims();
+    VolumeFile::InterpType useMethod = method;
+    if (inDims[0] == 1 || inDims[1] == 1 || inDims[2] == 1)
+    {
+        useMethod = VolumeFile::ENCLOSING_VOXEL;//same as VolumeFile::interpolateValue on single slice volumes
+    }
+    if (useMethod == VolumeFile::CUBIC) throw AlgorithmException("CUBIC resampling uses spline coefficients computed from the data, it can't be precomputed as voxel weights");
+    const int64_t numOutVoxels = refDims[0] * refDims[1] * refDims[2];
+    vector<vector<VoxelWeight> > weights(numOutVoxels);
+#pragma omp CARET_PARFOR schedule(guided, 10)
+    for (int64_t k = 0; k < refDims[2]; ++k)
+    {
+        for (int64_t j = 0; j < refDims[1]; ++j)
+        {
+            for (int64_t i = 0; i < refDims[0]; ++i)
+            {
+                vector<VoxelWeight>& myWeights = weights[i + refDims[0] * (j + refDims[1] * k)];
+                Vector3D outCoord = refSpace.indexToSpace(i, j, k);
+                bool validCoord = false;
+                Vector3D inCoord = myStack.xfmPoint(outCoord, 0, &validCoord);
+                if (!validCoord) continue;//no weights means invalid, output gets the invalid value
+                if (useMethod == VolumeFile::ENCLOSING_VOXEL)
+                {
+                    int64_t ijk[3];
+                    inSpace.enclosingVoxel(inCoord, ijk);
+                    if (indexValid(inDims, ijk[0], ijk[1], ijk[2])) myWeights.push_back(VoxelWeight(1.0f, ijk));
+                    continue;
+                }
+                float index[3];
+                inSpace.spaceToIndex(inCoord, index);
+                int64_t lowCheck[3], highCheck[3], low[3];
+                for (int d = 0; d < 3; ++d)
+                {
+                    lowCheck[d] = floor(index[d] + 0.01f);//same rounding allowance as VolumeFile::interpolateValue
+                    highCheck[d] = ceil(index[d] - 0.01f);
+                    low[d] = min(max(int64_t(floor(index[d])), int64_t(0)), inDims[d] - 2);
+                }
+                if (!indexValid(inDims, lowCheck[0], lowCheck[1], lowCheck[2]) || !indexValid(inDims, highCheck[0], highCheck[1], highCheck[2])) continue;
+                float highWeight[3];
+                for (int d = 0; d < 3; ++d)
+                {
+                    highWeight[d] = index[d] - low[d];
+                }
+                for (int corner = 0; corner < 8; ++corner)
+                {
+                    int64_t ijk[3];
+                    float weight = 1.0f;
+                    for (int d = 0; d < 3; ++d)
+                    {
+                        bool high = ((corner >> d) & 1) != 0;
+                        ijk[d] = low[d] + (high ? 1 : 0);
+                        weight *= (high ? highWeight[d] : 1.0f - highWeight[d]);
+                    }
+                    if (weight != 0.0f) myWeights.push_back(VoxelWeight(weight, ijk));
+                }
+            }
+        }
+    }
+    return CaretPointer<const VoxelWeightMatrix>(new VoxelWeightMatrix(weights, inDims, false));
+}
+
+const SurfaceResamplingHelper* ResamplePlan::getSurfaceWeights(const QByteArray& key) const
+{
+    map<QByteArray, SurfaceResamplingHelper>::const_iterator iter = m_surfaceWeights.find(key);
+    if (iter == m_surfaceWeights.end()) return NULL;
+    return &(iter->second);
+}
+
+const VoxelWeightMatrix* ResamplePlan::getVolumeWeights(const QByteArray& key) const
+{
+    map<QByteArray, CaretPointer<const VoxelWeightMatrix> >::const_iterator iter = m_volumeWeights.find(key);
+    if (iter == m_volumeWeights.end()) return NULL;
+    return iter->second;
+}
+
+void ResamplePlan::readFile(const AString& filename)
+{
+    ifstream inFile(filename.toLocal8Bit().constData(), ios::in | ios::binary);
+    if (!inFile) throw AlgorithmException("failed to open resample plan file '" + filename + "'");
+    char magic[8];
+    int64_t header[3];//version, surface entries, volume entries
+    inFile.read(magic, 8);
+    inFile.read((char*)header, sizeof(header));
+    if (!inFile || memcmp(magic, FILE_MAGIC, 8) != 0) throw AlgorithmException("file '" + filename + "' is not a resample plan");
+    if (header[0] == 1) throw AlgorithmException("resample plan file '" + filename + "' was made by an older version, recreate it with -resample-plan-create");
+    if (header[0] != FILE_VERSION) throw AlgorithmException("resample plan file '" + filename + "' has unsupported version " + AString::number(header[0]));
+    if (header[1] < 0 || header[2] < 0) throw AlgorithmException("resample plan file '" + filename + "' is corrupted");
+    m_surfaceWeights.clear();
+    m_volumeWeights.clear();
+    for (int64_t i = 0; i < header[1]; ++i)
+    {
+        QByteArray key;
+        SurfaceResamplingHelper weights;
+        if (!readKey(inFile, key) || !weights.readWeights(inFile)) throw AlgorithmException("resample plan file '" + filename + "' is corrupted");
+        m_surfaceWeights[key] = weights;
+    }
+    for (int64_t i = 0; i < header[2]; ++i)
+    {
+        QByteArray key;
+        CaretPointer<VoxelWeightMatrix> weights(new VoxelWeightMatrix());
+        if (!readKey(inFile, key) || !weights->readFromStream(inFile)) throw AlgorithmException("resample plan file '" + filename + "' is corrupted");
+        m_volumeWeights[key] = weights;
+    }
+}
+
+void ResamplePlan::writeFile(const AString& filename) const
+{
+    const AString tempName = filename + ".part";
+    {
+        ofstream outFile(tempName.toLocal8Bit().constData(), ios::out | ios::binary | ios::trunc);
+        if (!outFile) throw AlgorithmException("failed to open resample plan file '" + tempName + "' for writing");
+        int64_t header[3] = { FILE_VERSION, getNumberOfSurfaceEntries(), getNumberOfVolumeEntries() };
+        outFile.write(FILE_MAGIC, 8);
+        outFile.write((const char*)header, sizeof(header));
+        for (map<QByteArray, SurfaceResamplingHelper>::const_iterator iter = m_surfaceWeights.begin(); iter != m_surfaceWeights.end(); ++iter)
+        {
+            writeKey(outFile, iter->first);
+            iter->second.writeWeights(outFile);
+        }
+        for (map<QByteArray, CaretPointer<const VoxelWeightMatrix> >::const_iterator iter = m_volumeWeights.begin(); iter != m_volumeWeights.end(); ++iter)
+        {
+            writeKey(outFile, iter->first);
+            iter->second->writeToStream(outFile);
+        }
+        if (!outFile) throw AlgorithmException("error writing resample plan file '" + tempName + "'");
+    }
+    QFile::remove(filename);
+    if (!QFile::rename(tempName, filename))
+    {
+        QFile::remove(tempName);
+        throw AlgorithmException("failed to rename resample plan file '" + tempName + "' to '" + filename + "'");
+    }
+}
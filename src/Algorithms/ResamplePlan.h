@@ -0,0 +1,74 @@
+#ifndef __RESAMPLE_PLAN_H__
+#define __RESAMPLE_PLAN_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AString.h"
+#include "CaretPointer.h"
+#include "SurfaceResamplingHelper.h"
+#include "SurfaceResamplingMethodEnum.h"
+#include "VolumeFile.h"
+#include "VoxelWeightMatrix.h"
+
+#include <QByteArray>
+
+#include <map>
+
+namespace caret {
+
+    class SurfaceFile;
+    class XfmStack;
+
+    ///precomputed resampling weights, so that repeated resampling between the same spaces skips building them
+    ///entries are keyed by a hash of everything their weights are computed from, so a plan can't be applied to mismatched inputs
+    class ResamplePlan
+    {
+        std::map<QByteArray, SurfaceResamplingHelper> m_surfaceWeights;
+        std::map<QByteArray, CaretPointer<const VoxelWeightMatrix> > m_volumeWeights;
+    public:
+        ///areas are only used by ADAP_BARY_AREA, currentRoi may be NULL
+        static QByteArray surfaceKey(const SurfaceResamplingMethodEnum::Enum& method, const SurfaceFile* currentSphere, const SurfaceFile* newSphere,
+                                     const float* currentAreas, const float* newAreas, const float* currentRoi);
+
+        ///the transforms are hashed by their values (affine matrices and warpfield data), not their file names
+        static QByteArray volumeKey(const VolumeSpace& inSpace, const XfmStack& myStack, const VolumeSpace& refSpace, const VolumeFile::InterpType& method);
+
+        ///weights for output voxels with the same meaning as AlgorithmVolumeResample, only TRILINEAR and ENCLOSING_VOXEL can be precomputed
+        static CaretPointer<const VoxelWeightMatrix> computeVolumeWeights(const VolumeSpace& inSpace, const XfmStack& myStack, const VolumeSpace& refSpace,
+                                                                          const VolumeFile::InterpType& method);
+
+        void addSurfaceWeights(const QByteArray& key, const SurfaceResamplingHelper& weights) { m_surfaceWeights[key] = weights; }
+        void addVolumeWeights(const QByteArray& key, const CaretPointer<const VoxelWeightMatrix>& weights) { m_volumeWeights[key] = weights; }
+
+        ///NULL if the plan has no matching entry
+        const SurfaceResamplingHelper* getSurfaceWeights(const QByteArray& key) const;
+        const VoxelWeightMatrix* getVolumeWeights(const QByteArray& key) const;
+
+        int64_t getNumberOfSurfaceEntries() const { return (int64_t)m_surfaceWeights.size(); }
+        int64_t getNumberOfVolumeEntries() const { return (int64_t)m_volumeWeights.size(); }
+
+        void readFile(const AString& filename);
+        void writeFile(const AString& filename) const;
+    };
+
+}
+
+#endif //__RESAMPLE_PLAN_H__
@@ -0,0 +1,134 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "SeedCorrelationEngine.h"
+
+#include "AlgorithmException.h"
+#include "CaretAssert.h"
+#include "CaretOMP.h"
+#include "CiftiFile.h"
+#include "DotProductTile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int64_t ROW_TILE = 64;//rows per dotProductTile call, also the unit of parallel work
+    const int64_t SEED_TILE = 256;//seeds per call, so the scratch output stays in cache with many seeds
+    const int64_t READ_BLOCK = 1024;//rows read from the file before computing on them
+
+    float transformCorrelation(double r, const bool& fisherZ)
+    {//same clamping as -cifti-correlation and -cifti-cross-correlation
+        if (fisherZ)
+        {
+            if (r > 0.999999) r = 0.999999;//prevent inf
+            if (r < -0.999999) r = -0.999999;//prevent -inf
+            return 0.5 * log((1 + r) / (1 - r));
+        } else {
+            if (r > 1.0) r = 1.0;//don't output anything silly
+            if (r < -1.0) r = -1.0;
+            return r;
+        }
+    }
+}
+
+SeedCorrelationEngine::SeedCorrelationEngine(const float* seeds, const int64_t& numSeeds, const int64_t& length, const int64_t& seedStride)
+{
+    CaretAssert(numSeeds >= 0 && length >= 0);
+    m_seeds = seeds;
+    m_numSeeds = numSeeds;
+    m_length = length;
+    m_seedStride = (seedStride < 0 ? length : seedStride);
+}
+
+float SeedCorrelationEngine::normalize(float* row, const int64_t& length)
+{
+    double accum = 0.0;
+    for (int64_t i = 0; i < length; ++i)
+    {
+        accum += row[i];
+    }
+    const float mean = accum / length;
+    accum = 0.0;
+    for (int64_t i = 0; i < length; ++i)
+    {
+        row[i] -= mean;
+        accum += row[i] * row[i];
+    }
+    const float rrs = sqrt(accum);
+    const float scale = 1.0f / rrs;//inf for a constant row, making it NaN
+    for (int64_t i = 0; i < length; ++i)
+    {
+        row[i] *= scale;
+    }
+    return rrs;
+}
+
+void SeedCorrelationEngine::correlateRows(const float* rows, const int64_t& numRows, const int64_t& rowStride, float* out, const int64_t& outStride, const bool& fisherZ) const
+{
+    if (numRows < 1 || m_numSeeds < 1) return;
+    const int64_t numRowTiles = (numRows - 1) / ROW_TILE + 1, numSeedTiles = (m_numSeeds - 1) / SEED_TILE + 1;
+#pragma omp CARET_PAR
+    {
+        vector<double> scratch(ROW_TILE * SEED_TILE);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int64_t tile = 0; tile < numRowTiles * numSeedTiles; ++tile)
+        {
+            const int64_t rowStart = (tile / numSeedTiles) * ROW_TILE, seedStart = (tile % numSeedTiles) * SEED_TILE;
+            const int64_t rowCount = min(ROW_TILE, numRows - rowStart), seedCount = min(SEED_TILE, m_numSeeds - seedStart);
+            dotProductTile(rows + rowStart * rowStride, rowStride, rowCount, m_seeds + seedStart * m_seedStride, m_seedStride, seedCount, m_length, scratch.data());
+            for (int64_t i = 0; i < rowCount; ++i)
+            {
+                float* outRow = out + (rowStart + i) * outStride + seedStart;
+                const double* scratchRow = scratch.data() + i * seedCount;
+                for (int64_t j = 0; j < seedCount; ++j)
+                {
+                    outRow[j] = transformCorrelation(scratchRow[j], fisherZ);
+                }
+            }
+        }
+    }
+}
+
+void SeedCorrelationEngine::correlateCifti(const CiftiFile* input, float* out, const bool& fisherZ) const
+{
+    const int64_t numRows = input->getNumberOfRows();
+    if (input->getNumberOfColumns() != m_length) throw AlgorithmException("input row length doesn't match the seed length");
+    vector<float> block(min(READ_BLOCK, numRows) * m_length);
+    for (int64_t blockStart = 0; blockStart < numRows; blockStart += READ_BLOCK)
+    {
+        const int64_t blockCount = min(READ_BLOCK, numRows - blockStart);
+        for (int64_t i = 0; i < blockCount; ++i)
+        {
+            input->getRow(block.data() + i * m_length, blockStart + i);//never read multiple rows at once from the same file
+        }
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t i = 0; i < blockCount; ++i)
+        {
+            normalize(block.data() + i * m_length, m_length);
+        }
+        correlateRows(block.data(), blockCount, m_length, out + blockStart * m_numSeeds, m_numSeeds, fisherZ);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef __SEED_CORRELATION_ENGINE_H__
+#define __SEED_CORRELATION_ENGINE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <stdint.h>
+
+namespace caret {
+
+    class CiftiFile;
+
+    ///correlates any number of seed timeseries against many rows at once, as blocked matrix products
+    ///seeds and rows must be normalized (see normalize()), so that their dot product is the correlation
+    class SeedCorrelationEngine
+    {
+        const float* m_seeds;
+        int64_t m_numSeeds, m_length, m_seedStride;
+        SeedCorrelationEngine();
+    public:
+        ///seeds are not copied, they must stay valid while the engine is used
+        SeedCorrelationEngine(const float* seeds, const int64_t& numSeeds, const int64_t& length, const int64_t& seedStride = -1);
+
+        ///subtract the mean and scale to unit length, returns the original root of residual sum of squares
+        ///a constant row becomes NaN, so its correlations are NaN, the same as dividing by zero afterwards
+        static float normalize(float* row, const int64_t& length);
+
+        ///out[i * outStride + j] = correlation of row i with seed j, or its fisher small z transform
+        void correlateRows(const float* rows, const int64_t& numRows, const int64_t& rowStride, float* out, const int64_t& outStride, const bool& fisherZ) const;
+
+        ///read every row of the file in order, normalize it, and correlate it with all seeds
+        ///out must have room for (number of rows) * (number of seeds), in row-major order
+        void correlateCifti(const CiftiFile* input, float* out, const bool& fisherZ) const;
+
+        int64_t getNumberOfSeeds() const { return m_numSeeds; }
+    };
+
+}
+
+#endif //__SEED_CORRELATION_ENGINE_H__
@@ -0,0 +1,318 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "VoxelWeightMatrix.h"
+
+#include "AlgorithmException.h"
+#include "CacheFileHelper.h"
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "CaretMutex.h"
+#include "CaretOMP.h"
+
+#include <QDir>
+#include <QFile>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <list>
+#include <map>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int64_t FRAME_BLOCK = 16;//frames gathered together, each weight is applied to this many frames per read
+    const int MAX_CACHED_MATRICES = 8;//weights kept in memory, for repeated mappings in one process (such as -batch)
+    const char FILE_MAGIC[8] = { 'W', 'B', 'V', 'X', 'W', 'C', 'S', 'R' };
+    const int64_t FILE_VERSION = 1;
+
+    CaretMutex cacheMutex;
+    map<QByteArray, CaretPointer<const VoxelWeightMatrix> > cachedMatrices;
+    list<QByteArray> cacheOrder;//most recently used first
+
+    AString getCacheFileName(const QByteArray& key, const AString& cacheDirectory)
+    {
+        return QDir(cacheDirectory).filePath(AString(key.toHex()) + ".wb_voxel_weights");
+    }
+
+    template<typename T>
+    void writeVector(ostream& outFile, const vector<T>& data)
+    {
+        if (!data.empty()) outFile.write((const char*)data.data(), data.size() * sizeof(T));
+    }
+
+    template<typename T>
+    bool readVector(istream& inFile, vector<T>& data, const int64_t& size)
+    {
+        data.resize(size);
+        if (size == 0) return true;
+        inFile.read((char*)data.data(), size * sizeof(T));
+        return (bool)inFile;
+    }
+}
+
+VoxelWeightMatrix::VoxelWeightMatrix(const vector<vector<VoxelWeight> >& weights, const int64_t dims[3], const bool& normalize)
+{
+    for (int i = 0; i < 3; ++i) m_dims[i] = dims[i];
+    const int64_t numVertices = (int64_t)weights.size();
+    m_rowStart.resize(numVertices + 1);
+    m_rowScales.resize(numVertices);
+    m_rowStart[0] = 0;
+    for (int64_t v = 0; v < numVertices; ++v)
+    {
+        m_rowStart[v + 1] = m_rowStart[v] + (int64_t)weights[v].size();
+    }
+    const int64_t numWeights = m_rowStart[numVertices];
+    vector<int64_t> voxelIndices(numWeights);
+    m_weights.resize(numWeights);
+    for (int64_t v = 0; v < numVertices; ++v)
+    {
+        const vector<VoxelWeight>& vertexWeights = weights[v];
+        float totalWeight = 0.0f;//same summation as the previous per-vertex loops, so the empty test matches
+        for (int64_t k = 0; k < (int64_t)vertexWeights.size(); ++k)
+        {
+            const VoxelWeight& thisWeight = vertexWeights[k];
+            CaretAssert(thisWeight.ijk[0] >= 0 && thisWeight.ijk[0] < m_dims[0] && thisWeight.ijk[1] >= 0 && thisWeight.ijk[1] < m_dims[1] &&
+                        thisWeight.ijk[2] >= 0 && thisWeight.ijk[2] < m_dims[2]);
+            voxelIndices[m_rowStart[v] + k] = thisWeight.ijk[0] + m_dims[0] * (thisWeight.ijk[1] + m_dims[1] * thisWeight.ijk[2]);
+            m_weights[m_rowStart[v] + k] = thisWeight.weight;
+            totalWeight += thisWeight.weight;
+        }
+        if (normalize)
+        {
+            m_rowScales[v] = (totalWeight != 0.0f ? 1.0f / totalWeight : 0.0f);
+        } else {
+            m_rowScales[v] = 1.0f;
+        }
+    }
+    m_usedVoxels = voxelIndices;
+    sort(m_usedVoxels.begin(), m_usedVoxels.end());
+    m_usedVoxels.erase(unique(m_usedVoxels.begin(), m_usedVoxels.end()), m_usedVoxels.end());
+    m_columns.resize(numWeights);
+    for (int64_t k = 0; k < numWeights; ++k)
+    {
+        m_columns[k] = (int32_t)(lower_bound(m_usedVoxels.begin(), m_usedVoxels.end(), voxelIndices[k]) - m_usedVoxels.begin());
+    }
+}
+
+void VoxelWeightMatrix::getVertexWeights(const int64_t& vertex, vector<VoxelWeight>& weightsOut) const
+{
+    CaretAssert(vertex >= 0 && vertex < getNumberOfVertices());
+    weightsOut.clear();
+    for (int64_t k = m_rowStart[vertex]; k < m_rowStart[vertex + 1]; ++k)
+    {
+        int64_t voxel = m_usedVoxels[m_columns[k]];
+        int64_t ijk[3];
+        ijk[0] = voxel % m_dims[0];
+        voxel /= m_dims[0];
+        ijk[1] = voxel % m_dims[1];
+        ijk[2] = voxel / m_dims[1];
+        weightsOut.push_back(VoxelWeight(m_weights[k], ijk));
+    }
+}
+
+void VoxelWeightMatrix::apply(const vector<const float*>& frames, const vector<float*>& outputs) const
+{
+    CaretAssert(frames.size() == outputs.size());
+    const int64_t numFrames = (int64_t)frames.size();
+    const int64_t numUsed = (int64_t)m_usedVoxels.size();
+    const int64_t numVertices = getNumberOfVertices();
+    vector<float> gathered(numUsed * min(FRAME_BLOCK, numFrames));
+    for (int64_t blockStart = 0; blockStart < numFrames; blockStart += FRAME_BLOCK)
+    {
+        const int64_t blockSize = min(FRAME_BLOCK, numFrames - blockStart);
+        //interleave the block's frames per voxel, so each weight reads one contiguous run of values
+#pragma omp CARET_PARFOR schedule(static)
+        for (int64_t u = 0; u < numUsed; ++u)
+        {
+            const int64_t voxel = m_usedVoxels[u];
+            float* gatherOut = gathered.data() + u * blockSize;
+            for (int64_t f = 0; f < blockSize; ++f)
+            {
+                gatherOut[f] = frames[blockStart + f][voxel];
+            }
+        }
+#pragma omp CARET_PAR
+        {
+            vector<double> accum(blockSize);
+#pragma omp CARET_FOR schedule(dynamic, 256)
+            for (int64_t v = 0; v < numVertices; ++v)
+            {
+                fill(accum.begin(), accum.end(), 0.0);
+                for (int64_t k = m_rowStart[v]; k < m_rowStart[v + 1]; ++k)
+                {
+                    const float weight = m_weights[k];
+                    const float* values = gathered.data() + m_columns[k] * blockSize;
+                    for (int64_t f = 0; f < blockSize; ++f)
+                    {
+                        accum[f] += weight * values[f];
+                    }
+                }
+                const float scale = m_rowScales[v];
+                for (int64_t f = 0; f < blockSize; ++f)
+                {
+                    outputs[blockStart + f][v] = accum[f] * scale;
+                }
+            }
+        }
+    }
+}
+
+bool VoxelWeightMatrix::readFromStream(istream& inFile)
+{
+    char magic[8];
+    int64_t header[6];//version, dims, vertices, weights
+    int64_t numUsed = 0;
+    inFile.read(magic, 8);
+    inFile.read((char*)header, sizeof(header));
+    inFile.read((char*)&numUsed, sizeof(numUsed));
+    if (!inFile || memcmp(magic, FILE_MAGIC, 8) != 0 || header[0] != FILE_VERSION) return false;
+    for (int i = 0; i < 3; ++i)
+    {
+        m_dims[i] = header[i + 1];
+        if (m_dims[i] < 1 || m_dims[i] > (1LL << 20)) return false;//also keeps the voxel count from overflowing
+    }
+    const int64_t numVoxels = m_dims[0] * m_dims[1] * m_dims[2];
+    const int64_t numVertices = header[4], numWeights = header[5];
+    if (numVertices < 0 || numWeights < 0 || numUsed < 0 || numUsed > numVoxels || numUsed > (int64_t)numeric_limits<int32_t>::max()) return false;
+    //don't trust the header for allocation sizes, the file must actually contain the data
+    const int64_t maxElements = numeric_limits<int64_t>::max() / 32;
+    if (numVertices >= maxElements || numWeights >= maxElements) return false;
+    const int64_t bytesNeeded = (numVertices + 1) * (int64_t)sizeof(int64_t) + numWeights * (int64_t)(sizeof(int32_t) + sizeof(float)) +
+                                numUsed * (int64_t)sizeof(int64_t) + numVertices * (int64_t)sizeof(float);
+    const int64_t bytesRemaining = CacheFileHelper::getBytesRemaining(inFile);
+    if (bytesRemaining >= 0 && bytesNeeded > bytesRemaining) return false;
+    if (!readVector(inFile, m_rowStart, numVertices + 1) || !readVector(inFile, m_columns, numWeights) || !readVector(inFile, m_weights, numWeights) ||
+        !readVector(inFile, m_usedVoxels, numUsed) || !readVector(inFile, m_rowScales, numVertices))
+    {
+        return false;
+    }
+    if (m_rowStart[0] != 0 || m_rowStart[numVertices] != numWeights) return false;
+    for (int64_t v = 0; v < numVertices; ++v)
+    {
+        if (m_rowStart[v + 1] < m_rowStart[v]) return false;
+    }
+    for (int64_t k = 0; k < numWeights; ++k)
+    {
+        if (m_columns[k] < 0 || m_columns[k] >= numUsed) return false;
+    }
+    for (int64_t u = 0; u < numUsed; ++u)
+    {
+        if (m_usedVoxels[u] < 0 || m_usedVoxels[u] >= numVoxels) return false;
+        if (u > 0 && m_usedVoxels[u] <= m_usedVoxels[u - 1]) return false;
+    }
+    return true;
+}
+
+bool VoxelWeightMatrix::matchesDimensions(const int64_t dims[3]) const
+{
+    return (m_dims[0] == dims[0] && m_dims[1] == dims[1] && m_dims[2] == dims[2]);
+}
+
+void VoxelWeightMatrix::writeToStream(ostream& outFile) const
+{
+    int64_t header[6] = { FILE_VERSION, m_dims[0], m_dims[1], m_dims[2], getNumberOfVertices(), (int64_t)m_weights.size() };
+    int64_t numUsed = (int64_t)m_usedVoxels.size();
+    outFile.write(FILE_MAGIC, 8);
+    outFile.write((const char*)header, sizeof(header));
+    outFile.write((const char*)&numUsed, sizeof(numUsed));
+    writeVector(outFile, m_rowStart);
+    writeVector(outFile, m_columns);
+    writeVector(outFile, m_weights);
+    writeVector(outFile, m_usedVoxels);
+    writeVector(outFile, m_rowScales);
+}
+
+bool VoxelWeightMatrix::readFile(const AString& filename)
+{
+    ifstream inFile(filename.toLocal8Bit().constData(), ios::in | ios::binary);
+    if (!inFile) return false;
+    return readFromStream(inFile);
+}
+
+void VoxelWeightMatrix::writeFile(const AString& filename) const
+{
+    const AString tempName = filename + ".part";
+    {
+        ofstream outFile(tempName.toLocal8Bit().constData(), ios::out | ios::binary | ios::trunc);
+        if (!outFile) throw AlgorithmException("failed to open voxel weights cache file '" + tempName + "' for writing");
+        writeToStream(outFile);
+        if (!outFile) throw AlgorithmException("error writing voxel weights cache file '" + tempName + "'");
+    }
+    QFile::remove(filename);
+    if (!QFile::rename(tempName, filename))
+    {
+        QFile::remove(tempName);
+        throw AlgorithmException("failed to rename voxel weights cache file '" + tempName + "' to '" + filename + "'");
+    }
+}
+
+CaretPointer<const VoxelWeightMatrix> VoxelWeightMatrix::getCached(const QByteArray& key, const AString& cacheDirectory)
+{
+    {
+        CaretMutexLocker locked(&cacheMutex);
+        auto iter = cachedMatrices.find(key);
+        if (iter != cachedMatrices.end())
+        {
+            cacheOrder.remove(key);
+            cacheOrder.push_front(key);
+            return iter->second;
+        }
+    }
+    if (!cacheDirectory.isEmpty())
+    {
+        const AString filename = getCacheFileName(key, cacheDirectory);
+        if (QFile::exists(filename))
+        {
+            CaretPointer<VoxelWeightMatrix> ret(new VoxelWeightMatrix());
+            if (ret->readFile(filename))
+            {
+                addToCache(key, "", ret);
+                return ret;
+            }
+            CaretLogWarning("ignoring invalid voxel weights cache file '" + filename + "'");
+        }
+    }
+    return CaretPointer<const VoxelWeightMatrix>();
+}
+
+void VoxelWeightMatrix::addToCache(const QByteArray& key, const AString& cacheDirectory, const CaretPointer<const VoxelWeightMatrix>& matrix)
+{
+    {
+        CaretMutexLocker locked(&cacheMutex);
+        if (cachedMatrices.find(key) != cachedMatrices.end()) cacheOrder.remove(key);
+        cachedMatrices[key] = matrix;
+        cacheOrder.push_front(key);
+        while ((int)cacheOrder.size() > MAX_CACHED_MATRICES)
+        {
+            cachedMatrices.erase(cacheOrder.back());
+            cacheOrder.pop_back();
+        }
+    }
+    if (!cacheDirectory.isEmpty())
+    {
+        if (!QDir().mkpath(cacheDirectory)) throw AlgorithmException("failed to create voxel weights cache directory '" + cacheDirectory + "'");
+        matrix->writeFile(getCacheFileName(key, cacheDirectory));
+    }
+}
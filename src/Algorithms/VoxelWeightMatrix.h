@@ -0,0 +1,94 @@
+#ifndef __VOXEL_WEIGHT_MATRIX_H__
+#define __VOXEL_WEIGHT_MATRIX_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AString.h"
+#include "CaretPointer.h"
+#include "RibbonMappingHelper.h"
+
+#include <QByteArray>
+
+#include <iosfwd>
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+
+    ///sparse (CSR) matrix of voxel weights for each surface vertex, for volume to surface mapping methods that take a fixed weighted average of voxels
+    class VoxelWeightMatrix
+    {
+        int64_t m_dims[3];
+
+        ///vertex-major (CSR): weights of vertex v are [m_rowStart[v], m_rowStart[v + 1])
+        std::vector<int64_t> m_rowStart;
+
+        ///indexes into m_usedVoxels, so that frames can be gathered only for voxels that have a weight
+        std::vector<int32_t> m_columns;
+        std::vector<float> m_weights;
+
+        ///linear voxel indices (i fastest) of voxels that have any weight, sorted
+        std::vector<int64_t> m_usedVoxels;
+
+        ///multiplies each vertex's weighted sum, 0 for vertices whose weights sum to zero when normalizing
+        std::vector<float> m_rowScales;
+
+        bool readFile(const AString& filename);
+        void writeFile(const AString& filename) const;
+    public:
+        VoxelWeightMatrix() { }
+        
+        ///normalize divides each vertex's weighted sum by the sum of its weights
+        VoxelWeightMatrix(const std::vector<std::vector<VoxelWeight> >& weights, const int64_t dims[3], const bool& normalize);
+
+        int64_t getNumberOfVertices() const { return (int64_t)m_rowScales.size(); }
+
+        ///true when normalizing and the vertex has no nonzero weights, its output is 0
+        bool isVertexEmpty(const int64_t& vertex) const { return m_rowScales[vertex] == 0.0f; }
+
+        ///true if the vertex has no weights at all, regardless of normalizing
+        bool hasNoWeights(const int64_t& vertex) const { return m_rowStart[vertex] == m_rowStart[vertex + 1]; }
+
+        ///true if the voxel indices were computed for a volume with these spatial dimensions
+        bool matchesDimensions(const int64_t dims[3]) const;
+
+        ///the (unnormalized) weights of one vertex
+        void getVertexWeights(const int64_t& vertex, std::vector<VoxelWeight>& weightsOut) const;
+
+        ///map several frames at once, frames are gathered interleaved per voxel in blocks so each weight is read once per block
+        void apply(const std::vector<const float*>& frames, const std::vector<float*>& outputs) const;
+
+        ///binary form, also used inside other files (such as resample plans)
+        void writeToStream(std::ostream& outStream) const;
+        ///returns false if the data is not a valid matrix (truncated, or indices out of range of the stored dimensions)
+        bool readFromStream(std::istream& inStream);
+
+        ///get weights from memory or cacheDirectory (if not empty) by key, or NULL
+        ///key should be a hash of everything the weights are computed from
+        static CaretPointer<const VoxelWeightMatrix> getCached(const QByteArray& key, const AString& cacheDirectory);
+
+        ///keep weights in memory and, if cacheDirectory is not empty, write them to it
+        static void addToCache(const QByteArray& key, const AString& cacheDirectory, const CaretPointer<const VoxelWeightMatrix>& matrix);
+    };
+
+}
+
+#endif //__VOXEL_WEIGHT_MATRIX_H__
@@ -1428,8 +1428,61 @@ BrainOpenGLChartTwoDrawingFixedPipeline::drawMatrixChartContent(const ChartableT
                                                                 const bool blendingEnabled)
 {
     GraphicsPrimitive* matrixPrimitive(NULL);
+    const bool tiledFlag(matrixChart->isMatrixChartingTiled());
+    if (tiledFlag) {
+        /*
+         * Matrix is too large for one texture so draw only the
+         * visible region at the resolution of the viewport
+         */
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        EventOpenGLObjectToWindowTransform transformEvent(EventOpenGLObjectToWindowTransform::SpaceType::MODEL);
+        EventManager::get()->sendEvent(transformEvent.getPointer());
+        if (transformEvent.isValid()) {
+            const float windowBottomLeft[3] {
+                static_cast<float>(viewport[0]),
+                static_cast<float>(viewport[1]),
+                0.0f
+            };
+            const float windowTopRight[3] {
+                static_cast<float>(viewport[0] + viewport[2]),
+                static_cast<float>(viewport[1] + viewport[3]),
+                0.0f
+            };
+            float modelBottomLeft[3];
+            float modelTopRight[3];
+            transformEvent.inverseTransformPoint(windowBottomLeft,
+                                                 modelBottomLeft);
+            transformEvent.inverseTransformPoint(windowTopRight,
+                                                 modelTopRight);
+            const float visibleRegion[4] {
+                std::min(modelBottomLeft[0], modelTopRight[0]),
+                std::max(modelBottomLeft[0], modelTopRight[0]),
+                std::min(modelBottomLeft[1], modelTopRight[1]),
+                std::max(modelBottomLeft[1], modelTopRight[1])
+            };
+            matrixPrimitive = matrixChart->getMatrixChartingTiledGraphicsPrimitive(chartViewingType,
+                                                                                   opacity,
+                                                                                   visibleRegion,
+                                                                                   viewport[2],
+                                                                                   viewport[3]);
+        }
+        
+        /*
+         * No part of the matrix is visible (if tiling failed, it is no
+         * longer tiled and is drawn with triangles)
+         */
+        if ((matrixPrimitive == NULL)
+            && matrixChart->isMatrixChartingTiled()) {
+            return;
+        }
+    }
+    
     const bool useTextureFlag(true);
-    if (useTextureFlag) {
+    if (matrixPrimitive != NULL) {
+        /* tiled matrix */
+    }
+    else if (useTextureFlag) {
         matrixPrimitive = matrixChart->getMatrixChartingGraphicsPrimitive(chartViewingType,
                                                                           CiftiMappableDataFile::MatrixGridMode::FILLED_TEXTURE,
                                                                           opacity);
@@ -1497,7 +1550,12 @@ BrainOpenGLChartTwoDrawingFixedPipeline::drawMatrixChartContent(const ChartableT
         const ChartTwoMatrixDisplayProperties* matrixProperties = m_browserTabContent->getChartTwoMatrixDisplayProperties();
         CaretAssert(matrixProperties);
         
-        if (matrixProperties->isGridLinesDisplayed()) {
+        /*
+         * Grid lines are not drawn for a tiled matrix as there is
+         * a line for every cell and cells are often smaller than a pixel
+         */
+        if (matrixProperties->isGridLinesDisplayed()
+            && ( ! tiledFlag)) {
             GraphicsPrimitive* matrixGridPrimitive = matrixChart->getMatrixChartingGraphicsPrimitive(chartViewingType,
                                                                                                      CiftiMappableDataFile::MatrixGridMode::OUTLINE,
                                                                                                      opacity);
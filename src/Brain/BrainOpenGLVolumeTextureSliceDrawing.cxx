@@ -2624,30 +2624,53 @@ BrainOpenGLVolumeTextureSliceDrawing::drawObliqueSliceWithPrimitive(const Volume
                     }
                 }
                 
-                GraphicsPrimitiveV3fT3f* primitive(volumeInterface->getVolumeDrawingPrimitive(vdi.mapIndex,
-                                                                                        DisplayGroupEnum::DISPLAY_GROUP_TAB,
-                                                                                        m_tabIndex));
+                /*
+                 * Large volumes are drawn with bricks, each with its own
+                 * texture, that intersect the slice.  Otherwise one
+                 * primitive has the texture for the entire volume.
+                 */
+                std::vector<GraphicsPrimitiveV3fT3f*> primitives;
+                if (volumeInterface->isVolumeDrawingWithBricks()) {
+                    const std::array<std::array<float, 3>, 4> sliceCornersXYZ {
+                        bottomLeft,
+                        bottomRight,
+                        topRight,
+                        topLeft
+                    };
+                    primitives = volumeInterface->getVolumeDrawingBrickPrimitivesForSlice(vdi.mapIndex,
+                                                                                          DisplayGroupEnum::DISPLAY_GROUP_TAB,
+                                                                                          m_tabIndex,
+                                                                                          sliceCornersXYZ);
+                }
+                else {
+                    GraphicsPrimitiveV3fT3f* primitive(volumeInterface->getVolumeDrawingPrimitive(vdi.mapIndex,
+                                                                                                  DisplayGroupEnum::DISPLAY_GROUP_TAB,
+                                                                                                  m_tabIndex));
+                    if (primitive != NULL) {
+                        std::array<float, 3> maxStr = { 1.0, 1.0, 1.0 };
+                        std::array<float, 3> textureBottomLeft;
+                        getTextureCoordinates(volumeInterface, bottomLeft, maxStr, textureBottomLeft);
+                        std::array<float, 3> textureBottomRight;
+                        getTextureCoordinates(volumeInterface, bottomRight, maxStr, textureBottomRight);
+                        std::array<float, 3> textureTopLeft;
+                        getTextureCoordinates(volumeInterface, topLeft, maxStr, textureTopLeft);
+                        std::array<float, 3> textureTopRight;
+                        getTextureCoordinates(volumeInterface, topRight, maxStr, textureTopRight);
+                        
+                        primitive->replaceVertexFloatXYZ(0, bottomLeft.data());
+                        primitive->replaceVertexFloatXYZ(1, bottomRight.data());
+                        primitive->replaceVertexFloatXYZ(2, topLeft.data());
+                        primitive->replaceVertexFloatXYZ(3, topRight.data());
+                        primitive->replaceVertexTextureSTR(0, textureBottomLeft.data());
+                        primitive->replaceVertexTextureSTR(1, textureBottomRight.data());
+                        primitive->replaceVertexTextureSTR(2, textureTopLeft.data());
+                        primitive->replaceVertexTextureSTR(3, textureTopRight.data());
+                        
+                        primitives.push_back(primitive);
+                    }
+                }
                 
-                if (primitive != NULL) {
-                    std::array<float, 3> maxStr = { 1.0, 1.0, 1.0 };
-                    std::array<float, 3> textureBottomLeft;
-                    getTextureCoordinates(volumeInterface, bottomLeft, maxStr, textureBottomLeft);
-                    std::array<float, 3> textureBottomRight;
-                    getTextureCoordinates(volumeInterface, bottomRight, maxStr, textureBottomRight);
-                    std::array<float, 3> textureTopLeft;
-                    getTextureCoordinates(volumeInterface, topLeft, maxStr, textureTopLeft);
-                    std::array<float, 3> textureTopRight;
-                    getTextureCoordinates(volumeInterface, topRight, maxStr, textureTopRight);
-                    
-                    primitive->replaceVertexFloatXYZ(0, bottomLeft.data());
-                    primitive->replaceVertexFloatXYZ(1, bottomRight.data());
-                    primitive->replaceVertexFloatXYZ(2, topLeft.data());
-                    primitive->replaceVertexFloatXYZ(3, topRight.data());
-                    primitive->replaceVertexTextureSTR(0, textureBottomLeft.data());
-                    primitive->replaceVertexTextureSTR(1, textureBottomRight.data());
-                    primitive->replaceVertexTextureSTR(2, textureTopLeft.data());
-                    primitive->replaceVertexTextureSTR(3, textureTopRight.data());
-                    
+                if ( ! primitives.empty()) {
                     bool discreteFlag(false);
                     bool magNearestFlag(false);
                     bool magSmoothFlag(false);
@@ -2726,29 +2749,31 @@ BrainOpenGLVolumeTextureSliceDrawing::drawObliqueSliceWithPrimitive(const Volume
                             break;
                     }
                     
-                    if (discreteFlag) {
-                        primitive->setTextureMinificationFilter(GraphicsTextureMinificationFilterEnum::NEAREST);
-                        primitive->setTextureMagnificationFilter(GraphicsTextureMagnificationFilterEnum::NEAREST);
-                    }
-                    else if (magNearestFlag) {
-                        /* Use Linear for Minification, Nearest for Magnification */
-                        primitive->setTextureMinificationFilter(GraphicsTextureMinificationFilterEnum::LINEAR);
-                        primitive->setTextureMagnificationFilter(GraphicsTextureMagnificationFilterEnum::NEAREST);
-                    }
-                    else if (magSmoothFlag) {
-                        /* Use Linear for both Minification and Magnification */
-                        primitive->setTextureMinificationFilter(GraphicsTextureMinificationFilterEnum::LINEAR);
-                        primitive->setTextureMagnificationFilter(GraphicsTextureMagnificationFilterEnum::LINEAR);
-                    }
-                    else {
-                        CaretAssert(0);
+                    for (GraphicsPrimitiveV3fT3f* primitive : primitives) {
+                        if (discreteFlag) {
+                            primitive->setTextureMinificationFilter(GraphicsTextureMinificationFilterEnum::NEAREST);
+                            primitive->setTextureMagnificationFilter(GraphicsTextureMagnificationFilterEnum::NEAREST);
+                        }
+                        else if (magNearestFlag) {
+                            /* Use Linear for Minification, Nearest for Magnification */
+                            primitive->setTextureMinificationFilter(GraphicsTextureMinificationFilterEnum::LINEAR);
+                            primitive->setTextureMagnificationFilter(GraphicsTextureMagnificationFilterEnum::NEAREST);
+                        }
+                        else if (magSmoothFlag) {
+                            /* Use Linear for both Minification and Magnification */
+                            primitive->setTextureMinificationFilter(GraphicsTextureMinificationFilterEnum::LINEAR);
+                            primitive->setTextureMagnificationFilter(GraphicsTextureMagnificationFilterEnum::LINEAR);
+                        }
+                        else {
+                            CaretAssert(0);
+                        }
+                        
+                        GraphicsEngineDataOpenGL::draw(primitive);
                     }
-
-                    GraphicsEngineDataOpenGL::draw(primitive);
                     
                     if (m_identificationModeFlag) {
                         performIdentification(volumeInterface,
-                                              primitive,
+                                              primitives.front(),
                                               sliceViewPlane,
                                               bottomLeft,
                                               bottomRight,
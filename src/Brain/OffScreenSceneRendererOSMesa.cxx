@@ -127,16 +127,20 @@ OffScreenSceneRendererOSMesa::initialize(const int32_t imageWidth,
               0);
 
     /*
-     * Create the Mesa Context
+     * Create the Mesa Context.  When the renderer is used for more
+     * than one image, the existing context is kept and the new
+     * image buffer is bound to it by OSMesaMakeCurrent().
      */
-    const int depthBits = 16;
-    const int stencilBits = 0;
-    const int accumBits = 0;
-    m_mesaContext = OSMesaCreateContextExt(OSMESA_RGBA,
-                                           depthBits,
-                                           stencilBits,
-                                           accumBits,
-                                           NULL);
+    if (m_mesaContext == 0) {
+        const int depthBits = 16;
+        const int stencilBits = 0;
+        const int accumBits = 0;
+        m_mesaContext = OSMesaCreateContextExt(OSMESA_RGBA,
+                                               depthBits,
+                                               stencilBits,
+                                               accumBits,
+                                               NULL);
+    }
 
     if (m_mesaContext == 0) {
         setErrorMessage("Creating Mesa Context failed.");
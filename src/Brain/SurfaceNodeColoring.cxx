@@ -23,10 +23,14 @@
 #include "SurfaceNodeColoring.h"
 #undef __SURFACE_NODE_COLORING_DECLARE__
 
+#include <array>
+
 #include "Brain.h"
 #include "BrainordinateRegionOfInterest.h"
 #include "BrainStructure.h"
 #include "BrowserTabContent.h"
+#include "CaretOMP.h"
+#include "Event.h"
 #include "EventBrowserTabGet.h"
 #include "CaretAssert.h"
 #include "CaretLogger.h"
@@ -45,6 +49,7 @@
 #include "DisplayPropertiesSurface.h"
 #include "EventManager.h"
 #include "EventModelSurfaceGet.h"
+#include "FastStatistics.h"
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
 #include "GroupAndNameHierarchyGroup.h"
@@ -68,6 +73,95 @@
 
 using namespace caret;
 
+/**
+ * \class caret::SurfaceNodeColoring::OverlayLayerColoring
+ * \brief Coloring of one palette mapped overlay layer
+ *
+ * Contains the RGBV coloring of an overlay layer and everything that
+ * was used to produce it.  When all of the inputs match, the coloring
+ * is reused instead of mapping the data through the palette again.
+ */
+class SurfaceNodeColoring::OverlayLayerColoring {
+public:
+    /**
+     * @return A checksum of the data values.
+     * @param data
+     *    The data.
+     * @param numberOfValues
+     *    Number of values in data.
+     */
+    static uint64_t checksumData(const float* data,
+                                 const int64_t numberOfValues) {
+        if (data == NULL) {
+            return 0;
+        }
+        /*
+         * FNV-1a using 32-bit words
+         */
+        const uint32_t* words = reinterpret_cast<const uint32_t*>(data);
+        uint64_t hash = 14695981039346656037ULL;
+        for (int64_t i = 0; i < numberOfValues; i++) {
+            hash ^= words[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+    
+    /**
+     * @return True if the inputs for this and the given layer coloring
+     * are identical so that the coloring is also identical.
+     * @param rhs
+     *    The other layer coloring.
+     */
+    bool isSameInputs(const OverlayLayerColoring& rhs) const {
+        return ((m_mapFileIdentifier == rhs.m_mapFileIdentifier)
+                && (m_surfaceIdentifier == rhs.m_surfaceIdentifier)
+                && (m_mapIndex == rhs.m_mapIndex)
+                && (m_numberOfNodes == rhs.m_numberOfNodes)
+                && (m_numberOfTriangles == rhs.m_numberOfTriangles)
+                && (m_displayDataChecksum == rhs.m_displayDataChecksum)
+                && (m_thresholdDataChecksum == rhs.m_thresholdDataChecksum)
+                && (m_statisticsValues == rhs.m_statisticsValues)
+                && (m_percentileValues == rhs.m_percentileValues)
+                && (m_paletteValues == rhs.m_paletteValues)
+                && (m_paletteColorMapping == rhs.m_paletteColorMapping)
+                && (m_thresholdPaletteColorMapping == rhs.m_thresholdPaletteColorMapping));
+    }
+    
+    /** Instance identifiers, which unlike addresses are never reused by another file */
+    int64_t m_mapFileIdentifier = -1;
+    
+    int64_t m_surfaceIdentifier = -1;
+    
+    int32_t m_mapIndex = -1;
+    
+    int32_t m_numberOfNodes = 0;
+    
+    int32_t m_numberOfTriangles = 0;
+    
+    uint64_t m_displayDataChecksum = 0;
+    
+    uint64_t m_thresholdDataChecksum = 0;
+    
+    /** Statistics values used for palette scaling */
+    std::array<float, 8> m_statisticsValues;
+    
+    /** Percentiles at the percentages of the percentage scale modes */
+    std::array<float, 6> m_percentileValues;
+    
+    /** Scalar and RGBA of each point in the palette used for coloring */
+    std::vector<float> m_paletteValues;
+    
+    PaletteColorMapping m_paletteColorMapping;
+    
+    PaletteColorMapping m_thresholdPaletteColorMapping;
+    
+    /** Red, green, blue, valid for each node */
+    std::vector<float> m_rgbv;
+    
+    /** Value of the use counter when this coloring was last used */
+    uint64_t m_lastUsed = 0;
+};
 
 /**
  * Constructor.
@@ -75,7 +169,12 @@ using namespace caret;
 SurfaceNodeColoring::SurfaceNodeColoring()
 : CaretObject()
 {
-    
+    /*
+     * Kept layer colorings are discarded when files go away
+     */
+    EventManager::get()->addProcessedEventListener(this, EventTypeEnum::EVENT_DATA_FILE_DELETE);
+    EventManager::get()->addEventListener(this, EventTypeEnum::EVENT_BRAIN_RESET);
+    EventManager::get()->addEventListener(this, EventTypeEnum::EVENT_BROWSER_TAB_DELETE);
 }
 
 /**
@@ -83,7 +182,54 @@ SurfaceNodeColoring::SurfaceNodeColoring()
  */
 SurfaceNodeColoring::~SurfaceNodeColoring()
 {
-    
+    EventManager::get()->removeAllEventsFromListener(this);
+}
+
+/**
+ * Receive an event.
+ *
+ * @param event
+ *    An event for which this instance is listening.
+ */
+void
+SurfaceNodeColoring::receiveEvent(Event* event)
+{
+    switch (event->getEventType()) {
+        case EventTypeEnum::EVENT_BRAIN_RESET:
+        case EventTypeEnum::EVENT_BROWSER_TAB_DELETE:
+        case EventTypeEnum::EVENT_DATA_FILE_DELETE:
+            m_overlayLayerColoring.clear();
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Keep the coloring of an overlay layer for the next update.  If too many
+ * layer colorings are kept, the least recently used one is discarded.
+ *
+ * @param layerKey
+ *    Key for the layer.
+ * @param layerColoring
+ *    Coloring of the layer.
+ */
+void
+SurfaceNodeColoring::keepOverlayLayerColoring(const OverlayLayerKey& layerKey,
+                                              std::unique_ptr<OverlayLayerColoring> layerColoring)
+{
+    layerColoring->m_lastUsed = ++m_overlayLayerUseCounter;
+    m_overlayLayerColoring[layerKey] = std::move(layerColoring);
+    
+    if (m_overlayLayerColoring.size() > s_maximumNumberOfOverlayLayerColorings) {
+        auto oldestIter = m_overlayLayerColoring.begin();
+        for (auto iter = m_overlayLayerColoring.begin(); iter != m_overlayLayerColoring.end(); iter++) {
+            if (iter->second->m_lastUsed < oldestIter->second->m_lastUsed) {
+                oldestIter = iter;
+            }
+        }
+        m_overlayLayerColoring.erase(oldestIter);
+    }
 }
 
 /**
@@ -358,6 +504,41 @@ SurfaceNodeColoring::colorSurfaceNodes(const DisplayPropertiesLabels* displayPro
                 mapDataFileType = selectedMapFile->getDataFileType();
             }
             
+            /*
+             * Palette mapped metric layers are kept so that they are
+             * only recolored when their inputs change.
+             */
+            const OverlayLayerKey layerKey(surface->getInstanceIdentifier(), overlaySet, iOver);
+            std::unique_ptr<OverlayLayerColoring> newLayerColoring;
+            switch (mapDataFileType) {
+                case DataFileTypeEnum::METRIC:
+                case DataFileTypeEnum::METRIC_DYNAMIC:
+                    newLayerColoring = createMetricOverlayLayerColoring(brainStructure,
+                                                                        surface,
+                                                                        dynamic_cast<MetricFile*>(selectedMapFile),
+                                                                        selectedMapIndex);
+                    break;
+                default:
+                    break;
+            }
+            
+            const float* layerRGBV = overlayRGBV;
+            bool layerColoringReusedFlag = false;
+            if (newLayerColoring) {
+                auto layerIter = m_overlayLayerColoring.find(layerKey);
+                if (layerIter != m_overlayLayerColoring.end()) {
+                    if (layerIter->second->isSameInputs(*newLayerColoring)) {
+                        layerRGBV = &layerIter->second->m_rgbv[0];
+                        layerIter->second->m_lastUsed = ++m_overlayLayerUseCounter;
+                        layerColoringReusedFlag = true;
+                        newLayerColoring.reset();
+                    }
+                }
+            }
+            else {
+                m_overlayLayerColoring.erase(layerKey);
+            }
+            
             bool isColoringValid = false;
             switch (mapDataFileType) {
                 case DataFileTypeEnum::ANNOTATION:
@@ -491,11 +672,16 @@ SurfaceNodeColoring::colorSurfaceNodes(const DisplayPropertiesLabels* displayPro
                     break;
                 case DataFileTypeEnum::METRIC:
                 case DataFileTypeEnum::METRIC_DYNAMIC: // same as metric
-                    isColoringValid = this->assignMetricColoring(brainStructure,
-                                                                 dynamic_cast<MetricFile*>(selectedMapFile),
-                                                                 selectedMapIndex,
-                                                                 numNodes, 
-                                                                 overlayRGBV);
+                    if (layerColoringReusedFlag) {
+                        isColoringValid = true;
+                    }
+                    else {
+                        isColoringValid = this->assignMetricColoring(brainStructure,
+                                                                     dynamic_cast<MetricFile*>(selectedMapFile),
+                                                                     selectedMapIndex,
+                                                                     numNodes,
+                                                                     overlayRGBV);
+                    }
                     break;
                 case DataFileTypeEnum::PALETTE:
                     break;
@@ -520,7 +706,8 @@ SurfaceNodeColoring::colorSurfaceNodes(const DisplayPropertiesLabels* displayPro
                     break;
             }
             
-            if (isColoringValid) {
+            if (isColoringValid
+                && ( ! layerColoringReusedFlag)) {
                 if (selectedMapFile->isMappedWithPalette()) {
                     const PaletteColorMapping* pcm = selectedMapFile->getMapPaletteColorMapping(selectedMapIndex);
                     CaretAssert(pcm);
@@ -588,46 +775,22 @@ SurfaceNodeColoring::colorSurfaceNodes(const DisplayPropertiesLabels* displayPro
             }
             
             if (isColoringValid) {
-                const float opacity = overlay->getOpacity();
-                const float oneMinusOpacity = 1.0 - opacity;
-                
-                for (int32_t i = 0; i < numNodes; i++) {
-                    const int32_t i4 = i * 4;
-                    const float valid = overlayRGBV[i4 + 3];
-                    if (valid > 0.0 ) {
-                        if (opacity < 1.0) {
-                            if (firstOverlayFlag) {
-                                /*
-                                 * When first overlay, there is nothing to 
-                                 * blend with
-                                 */
-                                rgbaNodeColors[i4]   = (overlayRGBV[i4]   * opacity);
-                                rgbaNodeColors[i4+1] = (overlayRGBV[i4+1] * opacity);
-                                rgbaNodeColors[i4+2] = (overlayRGBV[i4+2] * opacity);
-                            }
-                            else {
-                                /*
-                                 * Blend with underlaying colors
-                                 */
-                                rgbaNodeColors[i4]   = (overlayRGBV[i4]   * opacity)
-                                + (rgbaNodeColors[i4] * oneMinusOpacity);
-                                rgbaNodeColors[i4+1] = (overlayRGBV[i4+1] * opacity)
-                                + (rgbaNodeColors[i4+1] * oneMinusOpacity);
-                                rgbaNodeColors[i4+2] = (overlayRGBV[i4+2] * opacity)
-                                + (rgbaNodeColors[i4+2] * oneMinusOpacity);
-                            }
-                        }
-                        else {
-                            /*
-                             * No opacity so simple replace coloring
-                             */
-                            rgbaNodeColors[i4] = overlayRGBV[i4];
-                            rgbaNodeColors[i4+1] = overlayRGBV[i4+1];
-                            rgbaNodeColors[i4+2] = overlayRGBV[i4+2];
-                        }
-                    }
+                if (newLayerColoring) {
+                    /*
+                     * Keep the layer's coloring for the next update
+                     */
+                    newLayerColoring->m_rgbv.assign(overlayRGBV,
+                                                    overlayRGBV + (numNodes * 4));
+                    keepOverlayLayerColoring(layerKey,
+                                             std::move(newLayerColoring));
                 }
                 
+                blendOverlayLayer(layerRGBV,
+                                  overlay->getOpacity(),
+                                  firstOverlayFlag,
+                                  numNodes,
+                                  rgbaNodeColors);
+                
                 firstOverlayFlag = false;
             }
         }
@@ -652,6 +815,53 @@ SurfaceNodeColoring::colorSurfaceNodes(const DisplayPropertiesLabels* displayPro
     delete[] overlayRGBV;
 }
 
+/**
+ * Blend the coloring of an overlay layer with the coloring of the
+ * layers beneath it.
+ *
+ * @param overlayRGBV
+ *    Red, green, blue, valid for each node in the overlay layer.
+ * @param opacity
+ *    Opacity of the overlay.
+ * @param firstOverlayFlag
+ *    True if this is the first (bottom) overlay that is colored
+ *    so there is nothing beneath it with which to blend.
+ * @param numberOfNodes
+ *    Number of nodes in surface.
+ * @param rgbaNodeColors
+ *    Node coloring that is updated with the overlay layer.
+ */
+void
+SurfaceNodeColoring::blendOverlayLayer(const float* overlayRGBV,
+                                       const float opacity,
+                                       const bool firstOverlayFlag,
+                                       const int32_t numberOfNodes,
+                                       float* rgbaNodeColors)
+{
+    CaretAssert(overlayRGBV);
+    CaretAssert(rgbaNodeColors);
+    
+    /*
+     * When opacity is one, the overlay replaces the coloring.  For the
+     * first overlay there is nothing to blend with so the underlying
+     * color's weight is zero.
+     */
+    const float overlayWeight  = ((opacity < 1.0f) ? opacity : 1.0f);
+    const float underlayWeight = (((opacity < 1.0f) && ( ! firstOverlayFlag))
+                                  ? (1.0f - opacity)
+                                  : 0.0f);
+    
+#pragma omp CARET_PARFOR schedule(static, 4096)
+    for (int32_t i = 0; i < numberOfNodes; i++) {
+        const int32_t i4 = i * 4;
+        if (overlayRGBV[i4 + 3] > 0.0f) {
+            rgbaNodeColors[i4]   = (overlayRGBV[i4]   * overlayWeight) + (rgbaNodeColors[i4]   * underlayWeight);
+            rgbaNodeColors[i4+1] = (overlayRGBV[i4+1] * overlayWeight) + (rgbaNodeColors[i4+1] * underlayWeight);
+            rgbaNodeColors[i4+2] = (overlayRGBV[i4+2] * overlayWeight) + (rgbaNodeColors[i4+2] * underlayWeight);
+        }
+    }
+}
+
 /**
  * Assign label coloring to nodes
  * @param brainStructure
@@ -906,6 +1116,59 @@ SurfaceNodeColoring::assignMetricColoring(const BrainStructure* brainStructure,
                                           const int32_t numberOfNodes,
                                           float* rgbv)
 {
+    MetricColoringInputs inputs;
+    if ( ! getMetricColoringInputs(brainStructure,
+                                   metricFile,
+                                   displayColumn,
+                                   inputs)) {
+        return false;
+    }
+    
+    /*
+     * Invalidate all coloring.
+     */
+    for (int32_t i = 0; i < numberOfNodes; i++) {
+        rgbv[i*4+3] = 0.0;
+    }
+    
+    CaretAssert(inputs.m_statistics);
+    
+    if (inputs.m_statistics != NULL) {
+        NodeAndVoxelColoring::colorScalarsWithPalette(inputs.m_statistics,
+                                                      inputs.m_paletteColorMapping,
+                                                      inputs.m_displayData,
+                                                      inputs.m_thresholdPaletteColorMapping,
+                                                      inputs.m_thresholdData,
+                                                      numberOfNodes, 
+                                                      rgbv);
+    }
+    
+    return true;
+}
+
+/**
+ * Get the data, palette mappings, and statistics used for coloring a metric map.
+ *
+ * @param brainStructure
+ *    The brain structure that contains the data files.
+ * @param metricFile
+ *    Metric file that is selected.
+ * @param displayColumn
+ *    Index of selected map.
+ * @param inputsOut
+ *    Output containing the inputs for coloring.
+ * @return
+ *    True if the metric map can be colored, else false.
+ */
+bool
+SurfaceNodeColoring::getMetricColoringInputs(const BrainStructure* brainStructure,
+                                             MetricFile* metricFile,
+                                             const int32_t displayColumn,
+                                             MetricColoringInputs& inputsOut) const
+{
+    if (metricFile == NULL) {
+        return false;
+    }
     if (displayColumn < 0) {
         return false;
     }
@@ -913,7 +1176,7 @@ SurfaceNodeColoring::assignMetricColoring(const BrainStructure* brainStructure,
         return false;
     }
     
-    PaletteColorMapping* paletteColorMapping = metricFile->getPaletteColorMapping(displayColumn);
+    const PaletteColorMapping* paletteColorMapping = metricFile->getPaletteColorMapping(displayColumn);
     
     bool useThreshMapFileFlag = false;
     switch (paletteColorMapping->getThresholdType()) {
@@ -931,8 +1194,8 @@ SurfaceNodeColoring::assignMetricColoring(const BrainStructure* brainStructure,
     }
     
     const float* metricDisplayData = metricFile->getValuePointerForColumn(displayColumn);
-    float* metricThresholdData = const_cast<float*>(metricDisplayData);
-    PaletteColorMapping* thresholdPaletteColorMapping = paletteColorMapping;
+    const float* metricThresholdData = metricDisplayData;
+    const PaletteColorMapping* thresholdPaletteColorMapping = paletteColorMapping;
     
     if (useThreshMapFileFlag) {
         const CaretMappableDataFileAndMapSelectionModel* threshFileModel = metricFile->getMapThresholdFileSelectionModel(displayColumn);
@@ -944,54 +1207,135 @@ SurfaceNodeColoring::assignMetricColoring(const BrainStructure* brainStructure,
                 const int32_t threshMapIndex = threshFileModel->getSelectedMapIndex();
                 if ((threshMapIndex >= 0)
                     && (threshMapIndex < threshMapFile->getNumberOfMaps())) {
-                    metricThresholdData = const_cast<float*>(threshMetricFile->getValuePointerForColumn(threshMapIndex));
-                    thresholdPaletteColorMapping = const_cast<PaletteColorMapping*>(threshMapFile->getMapPaletteColorMapping(threshMapIndex));
+                    metricThresholdData = threshMetricFile->getValuePointerForColumn(threshMapIndex);
+                    thresholdPaletteColorMapping = threshMapFile->getMapPaletteColorMapping(threshMapIndex);
                     CaretAssert(thresholdPaletteColorMapping);
                 }
             }
         }
     }
     
-    /*
-     * Invalidate all coloring.
-     */
-    for (int32_t i = 0; i < numberOfNodes; i++) {
-        rgbv[i*4+3] = 0.0;
-    }
-    
-    /*
-     * Get min/max ranges.
-     */
-    int thresholdColumn = metricFile->getColumnIndexFromColumnName(paletteColorMapping->getThresholdDataName());
-    if (thresholdColumn < 0) {
-        thresholdColumn = displayColumn;
-    }
-    
-    
-    FastStatistics* statistics = NULL;
+    const FastStatistics* statistics = NULL;
     switch (metricFile->getPaletteNormalizationMode()) {
         case PaletteNormalizationModeEnum::NORMALIZATION_ALL_MAP_DATA:
-            statistics = const_cast<FastStatistics*>(metricFile->getFileFastStatistics());
+            statistics = metricFile->getFileFastStatistics();
             break;
         case PaletteNormalizationModeEnum::NORMALIZATION_SELECTED_MAP_DATA:
-            statistics = const_cast<FastStatistics*>(metricFile->getMapFastStatistics(displayColumn));
+            statistics = metricFile->getMapFastStatistics(displayColumn);
             break;
     }
-    CaretAssert(statistics);
-    
-    if (statistics != NULL) {
-        NodeAndVoxelColoring::colorScalarsWithPalette(statistics, 
-                                                      paletteColorMapping, 
-                                                      metricDisplayData,
-                                                      thresholdPaletteColorMapping,
-                                                      metricThresholdData, 
-                                                      numberOfNodes, 
-                                                      rgbv);
-    }
+    
+    inputsOut.m_displayData                  = metricDisplayData;
+    inputsOut.m_thresholdData                = metricThresholdData;
+    inputsOut.m_paletteColorMapping          = paletteColorMapping;
+    inputsOut.m_thresholdPaletteColorMapping = thresholdPaletteColorMapping;
+    inputsOut.m_statistics                   = statistics;
     
     return true;
 }
 
+/**
+ * Create the layer coloring containing the inputs for coloring a metric map
+ * (without any coloring).  The inputs are compared to the inputs of the
+ * previous coloring of the layer to determine if the layer must be recolored.
+ *
+ * @param brainStructure
+ *    The brain structure that contains the data files.
+ * @param surface
+ *    Surface that has its nodes colored.
+ * @param metricFile
+ *    Metric file that is selected.
+ * @param displayColumn
+ *    Index of selected map.
+ * @return
+ *    The layer coloring or NULL if the map cannot be colored.
+ */
+std::unique_ptr<SurfaceNodeColoring::OverlayLayerColoring>
+SurfaceNodeColoring::createMetricOverlayLayerColoring(const BrainStructure* brainStructure,
+                                                      const Surface* surface,
+                                                      MetricFile* metricFile,
+                                                      const int32_t displayColumn) const
+{
+    std::unique_ptr<OverlayLayerColoring> layerColoring;
+    
+    MetricColoringInputs inputs;
+    if ( ! getMetricColoringInputs(brainStructure,
+                                   metricFile,
+                                   displayColumn,
+                                   inputs)) {
+        return layerColoring;
+    }
+    if (inputs.m_statistics == NULL) {
+        return layerColoring;
+    }
+    
+    const int32_t numberOfNodes = surface->getNumberOfNodes();
+    if (metricFile->getNumberOfNodes() != numberOfNodes) {
+        return layerColoring;
+    }
+    
+    layerColoring.reset(new OverlayLayerColoring());
+    layerColoring->m_mapFileIdentifier = metricFile->getInstanceIdentifier();
+    layerColoring->m_surfaceIdentifier = surface->getInstanceIdentifier();
+    layerColoring->m_mapIndex          = displayColumn;
+    layerColoring->m_numberOfNodes     = numberOfNodes;
+    layerColoring->m_numberOfTriangles = surface->getNumberOfTriangles();
+    layerColoring->m_displayDataChecksum = OverlayLayerColoring::checksumData(inputs.m_displayData,
+                                                                              numberOfNodes);
+    layerColoring->m_thresholdDataChecksum = ((inputs.m_thresholdData == inputs.m_displayData)
+                                              ? layerColoring->m_displayDataChecksum
+                                              : OverlayLayerColoring::checksumData(inputs.m_thresholdData,
+                                                                                   numberOfNodes));
+    
+    const FastStatistics* statistics = inputs.m_statistics;
+    float mostNegative(0.0f), leastNegative(0.0f), leastPositive(0.0f), mostPositive(0.0f);
+    statistics->getNonzeroRanges(mostNegative, leastNegative, leastPositive, mostPositive);
+    layerColoring->m_statisticsValues = { {
+        statistics->getMin(),
+        statistics->getMax(),
+        statistics->getMean(),
+        statistics->getSampleStdDev(),
+        mostNegative,
+        leastNegative,
+        leastPositive,
+        mostPositive
+    } };
+    
+    /*
+     * Statistics of all maps may change without the selected map's data
+     * changing so the percentiles used for percentage scaling must match
+     */
+    const PaletteColorMapping* paletteColorMapping = inputs.m_paletteColorMapping;
+    layerColoring->m_percentileValues = { {
+        statistics->getApproxAbsolutePercentile(paletteColorMapping->getAutoScaleAbsolutePercentageMinimum()),
+        statistics->getApproxAbsolutePercentile(paletteColorMapping->getAutoScaleAbsolutePercentageMaximum()),
+        statistics->getApproxNegativePercentile(paletteColorMapping->getAutoScalePercentageNegativeMinimum()),
+        statistics->getApproxNegativePercentile(paletteColorMapping->getAutoScalePercentageNegativeMaximum()),
+        statistics->getApproxPositivePercentile(paletteColorMapping->getAutoScalePercentagePositiveMinimum()),
+        statistics->getApproxPositivePercentile(paletteColorMapping->getAutoScalePercentagePositiveMaximum())
+    } };
+    
+    /*
+     * A palette with the same name may be edited or replaced
+     */
+    const Palette* palette = paletteColorMapping->getPalette();
+    CaretAssert(palette);
+    const int32_t numberOfPaletteScalars = palette->getNumberOfScalarsAndColors();
+    layerColoring->m_paletteValues.reserve(numberOfPaletteScalars * 5);
+    for (int32_t i = 0; i < numberOfPaletteScalars; i++) {
+        const PaletteScalarAndColor* scalarAndColor = palette->getScalarAndColor(i);
+        const float* rgba = scalarAndColor->getColor();
+        layerColoring->m_paletteValues.push_back(scalarAndColor->getScalar());
+        layerColoring->m_paletteValues.insert(layerColoring->m_paletteValues.end(),
+                                              rgba, rgba + 4);
+    }
+    
+    layerColoring->m_paletteColorMapping = *paletteColorMapping;
+    layerColoring->m_thresholdPaletteColorMapping = *inputs.m_thresholdPaletteColorMapping;
+    
+    return layerColoring;
+}
+
 /**
  * Assign cifti scalar coloring to nodes
  * @param brainStructure
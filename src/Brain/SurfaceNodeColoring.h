@@ -22,11 +22,15 @@
 /*LICENSE_END*/
 
 #include <array>
+#include <map>
+#include <memory>
+#include <tuple>
 
 #include "CaretColorEnum.h"
 #include "CaretObject.h"
 #include "CaretPointer.h"
 #include "DisplayGroupEnum.h"
+#include "EventListenerInterface.h"
 #include "LabelDrawingTypeEnum.h"
 
 namespace caret {
@@ -42,6 +46,7 @@ namespace caret {
     class CiftiParcelScalarFile;
     class CiftiParcelSeriesFile;
     class DisplayPropertiesLabels;
+    class FastStatistics;
     class GiftiLabelTable;
     class Model;
     class LabelFile;
@@ -54,13 +59,15 @@ namespace caret {
     class TopologyHelper;
     
     /// Performs coloring of surface nodes
-    class SurfaceNodeColoring : public CaretObject {
+    class SurfaceNodeColoring : public CaretObject, public EventListenerInterface {
         
     public:
         SurfaceNodeColoring();
         
         virtual ~SurfaceNodeColoring();
         
+        virtual void receiveEvent(Event* event);
+        
         float* colorSurfaceNodes(Model* model,
                                  Surface* surface,
                                  const int32_t browserTabIndex);
@@ -81,6 +88,50 @@ namespace caret {
             METRIC_COLOR_TYPE_DO_NOT_COLOR
         };        
         
+        /**
+         * Data and palette settings used for coloring a metric map
+         */
+        class MetricColoringInputs {
+        public:
+            const float* m_displayData = NULL;
+            
+            const float* m_thresholdData = NULL;
+            
+            const PaletteColorMapping* m_paletteColorMapping = NULL;
+            
+            const PaletteColorMapping* m_thresholdPaletteColorMapping = NULL;
+            
+            const FastStatistics* m_statistics = NULL;
+        };
+        
+        class OverlayLayerColoring;
+        
+        /**
+         * Key for an overlay layer is the surface's instance identifier, overlay set, and overlay index.
+         * The key only selects the slot, the inputs kept in the slot decide whether its coloring is used.
+         */
+        typedef std::tuple<int64_t, const OverlaySet*, int32_t> OverlayLayerKey;
+        
+        bool getMetricColoringInputs(const BrainStructure* brainStructure,
+                                     MetricFile* metricFile,
+                                     const int32_t displayColumn,
+                                     MetricColoringInputs& inputsOut) const;
+        
+        std::unique_ptr<OverlayLayerColoring> createMetricOverlayLayerColoring(const BrainStructure* brainStructure,
+                                                                               const Surface* surface,
+                                                                               MetricFile* metricFile,
+                                                                               const int32_t displayColumn) const;
+        
+        void keepOverlayLayerColoring(const OverlayLayerKey& layerKey,
+                                      std::unique_ptr<OverlayLayerColoring> layerColoring);
+        
+        static void blendOverlayLayer(const float* overlayRGBV,
+                                      const float opacity,
+                                      const bool firstOverlayFlag,
+                                      const int32_t numberOfNodes,
+                                      float* rgbaNodeColors);
+        
+
         void colorSurfaceNodes(const DisplayPropertiesLabels* dpl,
                                const int32_t browserTabIndex,
                                const Surface* surface,
@@ -170,6 +221,19 @@ namespace caret {
         void showBrainordinateHighlightRegionOfInterest(const Brain* brain,
                                                         const Surface* surface,
                                                         float* rgbaNodeColors);
+        
+        /**
+         * Coloring of palette mapped overlay layers from the previous update.  A layer
+         * is only recolored when its file, map, data, palette mapping, or thresholding
+         * has changed since the layer was last colored.  Cleared when files are removed,
+         * and limited to the most recently used layers.
+         */
+        std::map<OverlayLayerKey, std::unique_ptr<OverlayLayerColoring>> m_overlayLayerColoring;
+        
+        /** Incremented each time a layer coloring is used, for discarding the least recently used */
+        uint64_t m_overlayLayerUseCounter = 0;
+        
+        static const size_t s_maximumNumberOfOverlayLayerColorings = 64;
     };
     
 #ifdef __SURFACE_NODE_COLORING_DECLARE__
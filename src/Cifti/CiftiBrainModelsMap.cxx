@@ -20,11 +20,9 @@
 
 #include "CiftiBrainModelsMap.h"
 
+#include "CiftiIndexArrayText.h"
 #include "DataFileException.h"
 
-#include <QRegularExpression>
-#include <QStringList>
-
 #include <algorithm>
 
 using namespace std;
@@ -890,35 +888,9 @@ void CiftiBrainModelsMap::ParseHelperModel::parseBrainModel2(QXmlStreamReader& x
 
 vector<int64_t> CiftiBrainModelsMap::ParseHelperModel::readIndexArray(QXmlStreamReader& xml)
 {
-    vector<int64_t> ret;
     QString text = xml.readElementText();//raises error if it encounters a start element
-    if (xml.hasError()) return ret;
-#if QT_VERSION >= 0x060102
-    QStringView textView(text);
-    auto separated = textView.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
-#elif QT_VERSION >= 0x060000
-    auto separated = text.tokenize(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
-    //can't do an exact reserve, tokenize is one at a time, there is no splitRef in qt6
-#else
-    //in QT5, QRegExp is slightly faster
-    auto separated = text.splitRef(QRegExp("\\s+"), QString::SkipEmptyParts);
-    ret.reserve(separated.size());
-#endif
-    for (const auto& elem : separated)
-    {
-        bool ok = false;
-        ret.push_back(elem.toLongLong(&ok));
-        if (!ok)
-        {
-            throw DataFileException("found noninteger in index array: " + elem.toString());
-        }
-        if (ret.back() < 0)
-        {
-            throw DataFileException("found negative integer in index array: " + elem.toString());
-        }
-    }
-    ret.shrink_to_fit();//qt6 can't predict in advance without making QStrings, so try not to have a bunch of unused memory allocated
-    return ret;
+    if (xml.hasError()) return vector<int64_t>();
+    return CiftiIndexArrayText::parse(text, false);
 }
 
 void CiftiBrainModelsMap::writeXML1(QXmlStreamWriter& xml) const
@@ -938,26 +910,14 @@ void CiftiBrainModelsMap::writeXML1(QXmlStreamWriter& xml) const
             xml.writeAttribute("ModelType", "CIFTI_MODEL_TYPE_SURFACE");
             xml.writeAttribute("SurfaceNumberOfNodes", QString::number(myModel.m_surfaceNumberOfNodes));
             xml.writeStartElement("NodeIndices");
-            QString text = "";
-            int64_t numNodes = (int64_t)myModel.m_nodeIndices.size();
-            for (int64_t j = 0; j < numNodes; ++j)
-            {
-                if (j != 0) text += " ";
-                text += QString::number(myModel.m_nodeIndices[j]);
-            }
-            xml.writeCharacters(text);
+            xml.writeCharacters(CiftiIndexArrayText::format(myModel.m_nodeIndices.data(), (int64_t)myModel.m_nodeIndices.size()));
             xml.writeEndElement();
         } else {
             xml.writeAttribute("ModelType", "CIFTI_MODEL_TYPE_VOXELS");
             xml.writeStartElement("VoxelIndicesIJK");
-            QString text = "";
             int64_t listSize = (int64_t)myModel.m_voxelIndicesIJK.size();
             CaretAssert(listSize % 3 == 0);
-            for (int64_t j = 0; j < listSize; j += 3)
-            {
-                text += QString::number(myModel.m_voxelIndicesIJK[j]) + " " + QString::number(myModel.m_voxelIndicesIJK[j + 1]) + " " + QString::number(myModel.m_voxelIndicesIJK[j + 2]) + "\n";
-            }
-            xml.writeCharacters(text);
+            xml.writeCharacters(CiftiIndexArrayText::format(myModel.m_voxelIndicesIJK.data(), listSize, 3));
             xml.writeEndElement();
         }
         xml.writeEndElement();
@@ -985,26 +945,14 @@ void CiftiBrainModelsMap::writeXML2(QXmlStreamWriter& xml) const
             xml.writeAttribute("ModelType", "CIFTI_MODEL_TYPE_SURFACE");
             xml.writeAttribute("SurfaceNumberOfVertices", QString::number(myModel.m_surfaceNumberOfNodes));
             xml.writeStartElement("VertexIndices");
-            QString text = "";
-            int64_t numNodes = (int64_t)myModel.m_nodeIndices.size();
-            for (int64_t j = 0; j < numNodes; ++j)
-            {
-                if (j != 0) text += " ";
-                text += QString::number(myModel.m_nodeIndices[j]);
-            }
-            xml.writeCharacters(text);
+            xml.writeCharacters(CiftiIndexArrayText::format(myModel.m_nodeIndices.data(), (int64_t)myModel.m_nodeIndices.size()));
             xml.writeEndElement();
         } else {
             xml.writeAttribute("ModelType", "CIFTI_MODEL_TYPE_VOXELS");
             xml.writeStartElement("VoxelIndicesIJK");
-            QString text = "";
             int64_t listSize = (int64_t)myModel.m_voxelIndicesIJK.size();
             CaretAssert(listSize % 3 == 0);
-            for (int64_t j = 0; j < listSize; j += 3)
-            {
-                text += QString::number(myModel.m_voxelIndicesIJK[j]) + " " + QString::number(myModel.m_voxelIndicesIJK[j + 1]) + " " + QString::number(myModel.m_voxelIndicesIJK[j + 2]) + "\n";
-            }
-            xml.writeCharacters(text);
+            xml.writeCharacters(CiftiIndexArrayText::format(myModel.m_voxelIndicesIJK.data(), listSize, 3));
             xml.writeEndElement();
         }
         xml.writeEndElement();
@@ -65,6 +65,8 @@ namespace
         void getRow(float* dataOut, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead) const;
         void getColumn(float* dataOut, const int64_t& index) const;
         bool isInMemory() const { return true; }
+        const float* getDataPointer() const { return m_array.get(m_array.getDimensions().size(), std::vector<int64_t>()); }
+        float* getDataPointerForWriting() { return m_array.get(m_array.getDimensions().size(), std::vector<int64_t>()); }
         void setRow(const float* dataIn, const std::vector<int64_t>& indexSelect);
         void setColumn(const float* dataIn, const int64_t& index);
     };
@@ -267,6 +269,19 @@ void CiftiFile::getColumn(float* dataOut, const int64_t& index) const
     m_readingImpl->getColumn(dataOut, index);
 }
 
+const float* CiftiFile::getInMemoryData() const
+{
+    if (m_dims.empty()) throw DataFileException("getInMemoryData called on uninitialized CiftiFile");
+    if (m_readingImpl == NULL) return NULL;
+    return m_readingImpl->getDataPointer();
+}
+
+float* CiftiFile::getInMemoryDataForWriting()
+{
+    verifyWriteImpl();
+    return m_writingImpl->getDataPointerForWriting();
+}
+
 void CiftiFile::setCiftiXML(const CiftiXML& xml, const bool useOldMetadata)
 {
     if (xml.getNumberOfDimensions() == 0) throw DataFileException("setCiftiXML called with 0-dimensional CiftiXML");
@@ -71,6 +71,11 @@ namespace caret
         }
         void getColumn(float* dataOut, const int64_t& index) const;//for 2D only, will be slow if on disk!
         
+        ///direct access for per-structure views: NULL unless the data is in memory, otherwise rows are contiguous with length getDimensions()[0]
+        ///the pointer is invalidated by setCiftiXML, convertToInMemory, writeFile, and other calls that change the implementation
+        const float* getInMemoryData() const;
+        float* getInMemoryDataForWriting();//sets up writing like setRow does, NULL if writing to disk
+        
         void setCiftiXML(const CiftiXML& xml, const bool useOldMetadata = true);
         void setCiftiXML(const CiftiXMLOld &xml, const bool useOldMetadata = true);//set xml from old implementation
         void setRow(const float* dataIn, const std::vector<int64_t>& indexSelect);
@@ -95,6 +100,7 @@ namespace caret
             virtual void getRow(float* dataOut, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead) const = 0;
             virtual void getColumn(float* dataOut, const int64_t& index) const = 0;
             virtual bool isInMemory() const { return false; }
+            virtual const float* getDataPointer() const { return NULL; }
             virtual ~ReadImplInterface();
         };
         //assume if you can write to it, you can also read from it
@@ -104,6 +110,7 @@ namespace caret
             virtual void setRow(const float* dataIn, const std::vector<int64_t>& indexSelect) = 0;
             virtual void setColumn(const float* dataIn, const int64_t& index) = 0;
             virtual void close() {}
+            virtual float* getDataPointerForWriting() { return NULL; }
             virtual ~WriteImplInterface();
         };
     private:
@@ -0,0 +1,123 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiIndexArrayText.h"
+
+#include "DataFileException.h"
+
+#include <limits>
+#include <string>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    inline bool isIndexSpace(const ushort& c)
+    {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    int64_t findTokenEnd(const QChar* data, const int64_t& length, int64_t pos)
+    {
+        while (pos < length && !isIndexSpace(data[pos].unicode())) ++pos;
+        return pos;
+    }
+}
+
+vector<int64_t> CiftiIndexArrayText::parse(const QString& text, const bool& allowNegative)
+{
+    const QChar* data = text.constData();
+    const int64_t length = text.size();
+    int64_t numTokens = 0;//count first so that the result is allocated only once
+    bool inToken = false;
+    for (int64_t i = 0; i < length; ++i)
+    {
+        bool isSpace = isIndexSpace(data[i].unicode());
+        if (!isSpace && !inToken) ++numTokens;
+        inToken = !isSpace;
+    }
+    vector<int64_t> ret;
+    ret.reserve(numTokens);
+    const uint64_t maxValue = numeric_limits<int64_t>::max();
+    int64_t pos = 0;
+    while (true)
+    {
+        while (pos < length && isIndexSpace(data[pos].unicode())) ++pos;
+        if (pos == length) break;
+        int64_t tokenStart = pos;
+        bool negative = false;
+        if (data[pos].unicode() == '-' || data[pos].unicode() == '+')
+        {
+            negative = (data[pos].unicode() == '-');
+            ++pos;
+        }
+        int64_t digitStart = pos;
+        uint64_t value = 0;
+        bool overflow = false;
+        while (pos < length)
+        {
+            uint32_t digit = uint32_t(data[pos].unicode()) - '0';
+            if (digit > 9) break;
+            if (value > (maxValue - digit) / 10) overflow = true;
+            value = value * 10 + digit;
+            ++pos;
+        }
+        if (pos == digitStart || overflow || (pos < length && !isIndexSpace(data[pos].unicode())))
+        {
+            throw DataFileException("found noninteger in index array: " + text.mid(tokenStart, findTokenEnd(data, length, pos) - tokenStart));
+        }
+        if (negative && value != 0 && !allowNegative)
+        {
+            throw DataFileException("found negative integer in index array: " + text.mid(tokenStart, pos - tokenStart));
+        }
+        ret.push_back(negative ? -int64_t(value) : int64_t(value));
+    }
+    return ret;
+}
+
+QString CiftiIndexArrayText::format(const int64_t* values, const int64_t& count, const int& valuesPerLine)
+{
+    string buffer;//format as latin1 and convert once at the end, rather than building a QString per value
+    buffer.reserve(count * 7);
+    char digits[20];
+    for (int64_t i = 0; i < count; ++i)
+    {
+        bool lineStart = (valuesPerLine > 0 && i % valuesPerLine == 0);
+        if (i != 0 && !lineStart) buffer += ' ';
+        uint64_t magnitude;
+        if (values[i] < 0)
+        {
+            buffer += '-';
+            magnitude = uint64_t(0) - uint64_t(values[i]);
+        } else {
+            magnitude = uint64_t(values[i]);
+        }
+        int numDigits = 0;
+        do
+        {
+            digits[numDigits++] = char('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        while (numDigits > 0) buffer += digits[--numDigits];
+        if (valuesPerLine > 0 && (i + 1) % valuesPerLine == 0) buffer += '\n';
+    }
+    return QString::fromLatin1(buffer.data(), int(buffer.size()));
+}
@@ -0,0 +1,42 @@
+#ifndef __CIFTI_INDEX_ARRAY_TEXT_H__
+#define __CIFTI_INDEX_ARRAY_TEXT_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <QString>
+
+#include <stdint.h>
+#include <vector>
+
+namespace caret
+{
+    ///conversion between index arrays and the whitespace-separated text of VertexIndices/NodeIndices/VoxelIndicesIJK elements
+    class CiftiIndexArrayText
+    {
+    public:
+        ///parse directly from the element text, without splitting it into token strings, throws on anything that isn't an integer
+        static std::vector<int64_t> parse(const QString& text, const bool& allowNegative);
+        ///values separated by spaces, or if valuesPerLine is positive, by spaces within a line and a newline after each line
+        static QString format(const int64_t* values, const int64_t& count, const int& valuesPerLine = 0);
+    };
+}
+
+#endif //__CIFTI_INDEX_ARRAY_TEXT_H__
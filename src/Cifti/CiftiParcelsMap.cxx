@@ -20,11 +20,9 @@
 
 #include "CiftiParcelsMap.h"
 
-#include "DataFileException.h"
 #include "CaretLogger.h"
-
-#include <QStringList>
-#include <QRegularExpression>
+#include "CiftiIndexArrayText.h"
+#include "DataFileException.h"
 
 using namespace std;
 using namespace caret;
@@ -40,7 +38,6 @@ void CiftiParcelsMap::addParcel(const CiftiParcelsMap::Parcel& parcel)
         }
     }
     int64_t voxelListSize = (int64_t)parcel.m_voxelIndices.size();
-    CaretCompact3DLookup<int64_t> tempLookup = m_volLookup;//a copy of the lookup should be faster than other methods of checking for overlap and repeat
     if (voxelListSize != 0)
     {
         const int64_t* dims = NULL;
@@ -52,8 +49,8 @@ void CiftiParcelsMap::addParcel(const CiftiParcelsMap::Parcel& parcel)
             }
             dims = m_volSpace.getDims();
         }
-        for (set<VoxelIJK>::const_iterator iter = parcel.m_voxelIndices.begin(); iter != parcel.m_voxelIndices.end(); ++iter)//do all error checking before adding to lookup - might be unnecessary
-        {
+        for (CaretSortedVectorSet<VoxelIJK>::const_iterator iter = parcel.m_voxelIndices.begin(); iter != parcel.m_voxelIndices.end(); ++iter)//do all error checking before adding to lookup
+        {//the voxel set can't contain repeats, so only overlap with other parcels needs checking, without a copy of the lookup
             if (iter->m_ijk[0] < 0 || iter->m_ijk[1] < 0 || iter->m_ijk[2] < 0)
             {
                 throw DataFileException("found negative index triple in voxel list");
@@ -64,26 +61,25 @@ void CiftiParcelsMap::addParcel(const CiftiParcelsMap::Parcel& parcel)
             {
                 throw DataFileException("found invalid index triple in voxel list");
             }
-            if (tempLookup.find(iter->m_ijk) != NULL)
+            if (m_volLookup.find(iter->m_ijk) != NULL)
             {
                 throw DataFileException("parcels may not overlap in voxels");
             }
-            tempLookup.at(iter->m_ijk) = thisParcel;
         }
     }
-    for (map<StructureEnum::Enum, set<int64_t> >::const_iterator iter = parcel.m_surfaceNodes.begin(); iter != parcel.m_surfaceNodes.end(); ++iter)
+    for (map<StructureEnum::Enum, CaretSortedVectorSet<int64_t> >::const_iterator iter = parcel.m_surfaceNodes.begin(); iter != parcel.m_surfaceNodes.end(); ++iter)
     {
         map<StructureEnum::Enum, SurfaceInfo>::const_iterator info = m_surfInfo.find(iter->first);
         if (info == m_surfInfo.end())
         {
             throw DataFileException("you must set surfaces before adding parcels that use them");
         }
-        const set<int64_t>& nodeSet = iter->second;
+        const CaretSortedVectorSet<int64_t>& nodeSet = iter->second;
         if (nodeSet.size() == 0)
         {
             throw DataFileException("parcels may not include empty node lists");//NOTE: technically not required by Cifti, change if problematic, but probably never allow empty list in internal state
         }
-        for (set<int64_t>::const_iterator iter2 = nodeSet.begin(); iter2 != nodeSet.end(); ++iter2)
+        for (CaretSortedVectorSet<int64_t>::const_iterator iter2 = nodeSet.begin(); iter2 != nodeSet.end(); ++iter2)
         {
             if (*iter2 < 0)
             {
@@ -99,16 +95,16 @@ void CiftiParcelsMap::addParcel(const CiftiParcelsMap::Parcel& parcel)
             }
         }
     }
-    if (voxelListSize != 0)//all error checking done, modify
+    for (CaretSortedVectorSet<VoxelIJK>::const_iterator iter = parcel.m_voxelIndices.begin(); iter != parcel.m_voxelIndices.end(); ++iter)//all error checking done, modify
     {
-        m_volLookup = tempLookup;
+        m_volLookup.at(iter->m_ijk) = thisParcel;
     }
-    for (map<StructureEnum::Enum, set<int64_t> >::const_iterator iter = parcel.m_surfaceNodes.begin(); iter != parcel.m_surfaceNodes.end(); ++iter)
+    for (map<StructureEnum::Enum, CaretSortedVectorSet<int64_t> >::const_iterator iter = parcel.m_surfaceNodes.begin(); iter != parcel.m_surfaceNodes.end(); ++iter)
     {
         map<StructureEnum::Enum, SurfaceInfo>::iterator info = m_surfInfo.find(iter->first);
         CaretAssert(info != m_surfInfo.end());
-        const set<int64_t>& nodeSet = iter->second;
-        for (set<int64_t>::const_iterator iter2 = nodeSet.begin(); iter2 != nodeSet.end(); ++iter2)
+        const CaretSortedVectorSet<int64_t>& nodeSet = iter->second;
+        for (CaretSortedVectorSet<int64_t>::const_iterator iter2 = nodeSet.begin(); iter2 != nodeSet.end(); ++iter2)
         {
             CaretAssertVectorIndex(info->second.m_lookup, *iter2);
             info->second.m_lookup[*iter2] = thisParcel;
@@ -145,8 +141,8 @@ void CiftiParcelsMap::setVolumeSpace(const VolumeSpace& space)
     int64_t numParcels = (int64_t)m_parcels.size();
     for (int64_t i = 0; i < numParcels; ++i)
     {
-        const set<VoxelIJK>& voxelList = m_parcels[i].m_voxelIndices;
-        for (set<VoxelIJK>::const_iterator iter = voxelList.begin(); iter != voxelList.end(); ++iter)
+        const CaretSortedVectorSet<VoxelIJK>& voxelList = m_parcels[i].m_voxelIndices;
+        for (CaretSortedVectorSet<VoxelIJK>::const_iterator iter = voxelList.begin(); iter != voxelList.end(); ++iter)
         {
             if (iter->m_ijk[0] >= dims[0] ||
                 iter->m_ijk[1] >= dims[1] ||
@@ -246,7 +242,7 @@ bool CiftiParcelsMap::hasSurfaceData(const StructureEnum::Enum& structure) const
     int64_t numParcels = (int64_t)m_parcels.size();
     for (int64_t i = 0; i < numParcels; ++i)
     {
-        map<StructureEnum::Enum, set<int64_t> >::const_iterator iter = m_parcels[i].m_surfaceNodes.find(structure);
+        map<StructureEnum::Enum, CaretSortedVectorSet<int64_t> >::const_iterator iter = m_parcels[i].m_surfaceNodes.find(structure);
         if (iter != m_parcels[i].m_surfaceNodes.end() && iter->second.size() != 0) return true;
     }
     return false;
@@ -509,17 +505,12 @@ CiftiParcelsMap::Parcel CiftiParcelsMap::readParcel1(QXmlStreamReader& xml)
             {
                 throw DataFileException("Nodes elements may not reuse a BrainStructure within a Parcel");
             }
-            set<int64_t>& mySet = ret.m_surfaceNodes[myStructure];
+            CaretSortedVectorSet<int64_t>& mySet = ret.m_surfaceNodes[myStructure];
             vector<int64_t> array = readIndexArray(xml);
             if (xml.hasError()) return ret;
-            int64_t arraySize = (int64_t)array.size();
-            for (int64_t i = 0; i < arraySize; ++i)
+            if (mySet.assign(std::move(array)) != 0)//bulk construction, sorts only if needed
             {
-                if (mySet.find(array[i]) != mySet.end())
-                {
-                    throw DataFileException("Nodes elements may not reuse indices");
-                }
-                mySet.insert(array[i]);
+                throw DataFileException("Nodes elements may not reuse indices");
             }
         } else if (name == QLatin1String("VoxelIndicesIJK")) {
             if (haveVoxels)
@@ -533,14 +524,15 @@ CiftiParcelsMap::Parcel CiftiParcelsMap::readParcel1(QXmlStreamReader& xml)
             {
                 throw DataFileException("number of indices in VoxelIndicesIJK must be a multiple of 3");
             }
+            vector<VoxelIJK> voxels;
+            voxels.reserve(arraySize / 3);
             for (int64_t index3 = 0; index3 < arraySize; index3 += 3)
             {
-                VoxelIJK temp(array.data() + index3);
-                if (ret.m_voxelIndices.find(temp) != ret.m_voxelIndices.end())
-                {
-                    throw DataFileException("VoxelIndicesIJK elements may not reuse voxels");
-                }
-                ret.m_voxelIndices.insert(temp);
+                voxels.push_back(VoxelIJK(array.data() + index3));
+            }
+            if (ret.m_voxelIndices.assign(std::move(voxels)) != 0)
+            {
+                throw DataFileException("VoxelIndicesIJK elements may not reuse voxels");
             }
             haveVoxels = true;
         } else {
@@ -581,17 +573,12 @@ CiftiParcelsMap::Parcel CiftiParcelsMap::readParcel2(QXmlStreamReader& xml)
             {
                 throw DataFileException("Vertices elements may not reuse a BrainStructure within a Parcel");
             }
-            set<int64_t>& mySet = ret.m_surfaceNodes[myStructure];
+            CaretSortedVectorSet<int64_t>& mySet = ret.m_surfaceNodes[myStructure];
             vector<int64_t> array = readIndexArray(xml);
             if (xml.hasError()) return ret;
-            int64_t arraySize = (int64_t)array.size();
-            for (int64_t i = 0; i < arraySize; ++i)
+            if (mySet.assign(std::move(array)) != 0)//bulk construction, sorts only if needed
             {
-                if (mySet.find(array[i]) != mySet.end())
-                {
-                    throw DataFileException("Vertices elements may not reuse indices");
-                }
-                mySet.insert(array[i]);
+                throw DataFileException("Vertices elements may not reuse indices");
             }
         } else if (name == QLatin1String("VoxelIndicesIJK")) {
             if (haveVoxels)
@@ -605,14 +592,15 @@ CiftiParcelsMap::Parcel CiftiParcelsMap::readParcel2(QXmlStreamReader& xml)
             {
                 throw DataFileException("number of indices in VoxelIndicesIJK must be a multiple of 3");
             }
+            vector<VoxelIJK> voxels;
+            voxels.reserve(arraySize / 3);
             for (int64_t index3 = 0; index3 < arraySize; index3 += 3)
             {
-                VoxelIJK temp(array.data() + index3);
-                if (ret.m_voxelIndices.find(temp) != ret.m_voxelIndices.end())
-                {
-                    throw DataFileException("VoxelIndicesIJK elements may not reuse voxels");
-                }
-                ret.m_voxelIndices.insert(temp);
+                voxels.push_back(VoxelIJK(array.data() + index3));
+            }
+            if (ret.m_voxelIndices.assign(std::move(voxels)) != 0)
+            {
+                throw DataFileException("VoxelIndicesIJK elements may not reuse voxels");
             }
             haveVoxels = true;
         } else {
@@ -625,26 +613,9 @@ CiftiParcelsMap::Parcel CiftiParcelsMap::readParcel2(QXmlStreamReader& xml)
 
 vector<int64_t> CiftiParcelsMap::readIndexArray(QXmlStreamReader& xml)
 {
-    vector<int64_t> ret;
     QString text = xml.readElementText();//raises error if it encounters a start element
-    if (xml.hasError()) return ret;
-#if QT_VERSION >= 0x060000
-    QStringList separated = text.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
-#else
-    QStringList separated = text.split(QRegularExpression("\\s+"), QString::SkipEmptyParts);
-#endif
-    int64_t numElems = separated.size();
-    ret.reserve(numElems);
-    for (int64_t i = 0; i < numElems; ++i)
-    {
-        bool ok = false;
-        ret.push_back(separated[i].toLongLong(&ok));
-        if (!ok)
-        {
-            throw DataFileException("found noninteger in index array: " + separated[i]);
-        }
-    }
-    return ret;
+    if (xml.hasError()) return vector<int64_t>();
+    return CiftiIndexArrayText::parse(text, true);
 }
 
 void CiftiParcelsMap::writeXML1(QXmlStreamWriter& xml) const
@@ -668,25 +639,23 @@ void CiftiParcelsMap::writeXML1(QXmlStreamWriter& xml) const
         if (numVoxels != 0)
         {
             xml.writeStartElement("VoxelIndicesIJK");
-            for (set<VoxelIJK>::const_iterator iter = m_parcels[i].m_voxelIndices.begin(); iter != m_parcels[i].m_voxelIndices.end(); ++iter)
+            vector<int64_t> voxelList;
+            voxelList.reserve(numVoxels * 3);
+            for (CaretSortedVectorSet<VoxelIJK>::const_iterator iter = m_parcels[i].m_voxelIndices.begin(); iter != m_parcels[i].m_voxelIndices.end(); ++iter)
             {
-                xml.writeCharacters(QString::number(iter->m_ijk[0]) + " " + QString::number(iter->m_ijk[1]) + " " + QString::number(iter->m_ijk[2]) + "\n");
+                voxelList.insert(voxelList.end(), iter->m_ijk, iter->m_ijk + 3);
             }
+            xml.writeCharacters(CiftiIndexArrayText::format(voxelList.data(), (int64_t)voxelList.size(), 3));
             xml.writeEndElement();
         }
-        for (map<StructureEnum::Enum, set<int64_t> >::const_iterator iter = m_parcels[i].m_surfaceNodes.begin(); iter != m_parcels[i].m_surfaceNodes.end(); ++iter)
+        for (map<StructureEnum::Enum, CaretSortedVectorSet<int64_t> >::const_iterator iter = m_parcels[i].m_surfaceNodes.begin(); iter != m_parcels[i].m_surfaceNodes.end(); ++iter)
         {
             if (iter->second.size() != 0)//prevent writing empty elements, regardless
             {
                 xml.writeStartElement("Nodes");
                 xml.writeAttribute("BrainStructure", StructureEnum::toCiftiName(iter->first));
-                set<int64_t>::const_iterator iter2 = iter->second.begin();//which also allows us to write the first one outside the loop, to not add whitespace on the front or back
-                xml.writeCharacters(QString::number(*iter2));
-                ++iter2;
-                for (; iter2 != iter->second.end(); ++iter2)
-                {
-                    xml.writeCharacters(" " + QString::number(*iter2));
-                }
+                const vector<int64_t>& nodeList = iter->second.getSortedElements();
+                xml.writeCharacters(CiftiIndexArrayText::format(nodeList.data(), (int64_t)nodeList.size()));
                 xml.writeEndElement();
             }
         }
@@ -718,25 +687,23 @@ void CiftiParcelsMap::writeXML2(QXmlStreamWriter& xml) const
         if (numVoxels != 0)
         {
             xml.writeStartElement("VoxelIndicesIJK");
-            for (set<VoxelIJK>::const_iterator iter = m_parcels[i].m_voxelIndices.begin(); iter != m_parcels[i].m_voxelIndices.end(); ++iter)
+            vector<int64_t> voxelList;
+            voxelList.reserve(numVoxels * 3);
+            for (CaretSortedVectorSet<VoxelIJK>::const_iterator iter = m_parcels[i].m_voxelIndices.begin(); iter != m_parcels[i].m_voxelIndices.end(); ++iter)
             {
-                xml.writeCharacters(QString::number(iter->m_ijk[0]) + " " + QString::number(iter->m_ijk[1]) + " " + QString::number(iter->m_ijk[2]) + "\n");
+                voxelList.insert(voxelList.end(), iter->m_ijk, iter->m_ijk + 3);
             }
+            xml.writeCharacters(CiftiIndexArrayText::format(voxelList.data(), (int64_t)voxelList.size(), 3));
             xml.writeEndElement();
         }
-        for (map<StructureEnum::Enum, set<int64_t> >::const_iterator iter = m_parcels[i].m_surfaceNodes.begin(); iter != m_parcels[i].m_surfaceNodes.end(); ++iter)
+        for (map<StructureEnum::Enum, CaretSortedVectorSet<int64_t> >::const_iterator iter = m_parcels[i].m_surfaceNodes.begin(); iter != m_parcels[i].m_surfaceNodes.end(); ++iter)
         {
             if (iter->second.size() != 0)//prevent writing empty elements, regardless
             {
                 xml.writeStartElement("Vertices");
                 xml.writeAttribute("BrainStructure", StructureEnum::toCiftiName(iter->first));
-                set<int64_t>::const_iterator iter2 = iter->second.begin();//which also allows us to write the first one outside the loop, to not add whitespace on the front or back
-                xml.writeCharacters(QString::number(*iter2));
-                ++iter2;
-                for (; iter2 != iter->second.end(); ++iter2)
-                {
-                    xml.writeCharacters(" " + QString::number(*iter2));
-                }
+                const vector<int64_t>& nodeList = iter->second.getSortedElements();
+                xml.writeCharacters(CiftiIndexArrayText::format(nodeList.data(), (int64_t)nodeList.size()));
                 xml.writeEndElement();
             }
         }
@@ -24,12 +24,12 @@
 #include "CiftiMappingType.h"
 
 #include "CaretCompact3DLookup.h"
+#include "CaretSortedVectorSet.h"
 #include "StructureEnum.h"
 #include "VolumeSpace.h"
 #include "VoxelIJK.h"
 
 #include <map>
-#include <set>
 #include <vector>
 
 namespace caret
@@ -39,8 +39,8 @@ namespace caret
     public:
         struct Parcel
         {
-            std::map<StructureEnum::Enum, std::set<int64_t> > m_surfaceNodes;
-            std::set<VoxelIJK> m_voxelIndices;
+            std::map<StructureEnum::Enum, CaretSortedVectorSet<int64_t> > m_surfaceNodes;//sorted vectors use much less memory than std::set for large parcellations
+            CaretSortedVectorSet<VoxelIJK> m_voxelIndices;
             QString m_name;
             bool operator==(const Parcel& rhs) const;
             bool operator!=(const Parcel& rhs) const { return !((*this) == rhs); }
@@ -0,0 +1,267 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiRowPipeline.h"
+
+#include "CaretAssert.h"
+#include "CaretMutex.h"
+#include "CaretOMP.h"
+#include "CiftiFile.h"
+#include "DataFileException.h"
+
+#include <QSemaphore>
+#include <QThread>
+
+#include <algorithm>
+#include <exception>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int64_t DEFAULT_BLOCK_BYTES = 32 * 1024 * 1024;
+    const int DEFAULT_BLOCKS_IN_FLIGHT = 4;//one being read, one being computed, one being written, one spare to absorb jitter
+
+    struct PipelineSlot
+    {
+        int64_t m_firstRow, m_numRows;
+        vector<vector<float> > m_inputs;
+        vector<float> m_output;
+    };
+    
+    class PipelineStageThread : public QThread
+    {
+        function<void()> m_stage;
+    public:
+        PipelineStageThread(const function<void()>& stage) : m_stage(stage) { }
+        void run() override { m_stage(); }
+    };
+}
+
+CiftiRowPipeline::CiftiRowPipeline(const vector<const CiftiFile*>& inputs, CiftiFile* output)
+{
+    CaretAssert(output != NULL);
+    m_inputs = inputs;
+    m_output = output;
+    m_blockBytes = DEFAULT_BLOCK_BYTES;
+    m_numBlocks = DEFAULT_BLOCKS_IN_FLIGHT;
+    const vector<int64_t>& outDims = output->getDimensions();
+    if (outDims.empty()) throw DataFileException("row pipeline output must have its XML set before use");
+    m_outputRowLength = outDims[0];
+    m_rowDims = vector<int64_t>(outDims.begin() + 1, outDims.end());
+    for (int i = 0; i < (int)inputs.size(); ++i)
+    {
+        CaretAssert(inputs[i] != NULL);
+        const vector<int64_t>& inDims = inputs[i]->getDimensions();
+        if (inDims.size() != outDims.size() || !equal(m_rowDims.begin(), m_rowDims.end(), inDims.begin() + 1))
+        {
+            throw DataFileException("input file '" + inputs[i]->getFileName() + "' has different dimensions than the row pipeline output");
+        }
+        m_inputRowLengths.push_back(inDims[0]);
+    }
+    m_numRows = 1;
+    for (int i = 0; i < (int)m_rowDims.size(); ++i)
+    {
+        m_numRows *= m_rowDims[i];
+    }
+}
+
+void CiftiRowPipeline::setBlockBytes(const int64_t& bytes)
+{
+    CaretAssert(bytes > 0);
+    m_blockBytes = bytes;
+}
+
+void CiftiRowPipeline::setNumberOfBlocksInFlight(const int& numBlocks)
+{
+    m_numBlocks = max(3, numBlocks);
+}
+
+vector<int64_t> CiftiRowPipeline::getRowIndex(int64_t row) const
+{//same order as MultiDimIterator, first index fastest
+    CaretAssert(row >= 0 && row < m_numRows);
+    vector<int64_t> ret(m_rowDims.size());
+    for (int i = 0; i < (int)m_rowDims.size(); ++i)
+    {
+        ret[i] = row % m_rowDims[i];
+        row /= m_rowDims[i];
+    }
+    return ret;
+}
+
+void CiftiRowPipeline::readRows(const CiftiFile* file, float* dataOut, const int64_t& firstRow, const int64_t& numRows, const int64_t& rowLength) const
+{
+    for (int64_t r = 0; r < numRows; ++r)
+    {
+        if (m_rowDims.size() == 1)
+        {
+            file->getRow(dataOut + r * rowLength, firstRow + r);
+        } else {
+            file->getRow(dataOut + r * rowLength, getRowIndex(firstRow + r));
+        }
+    }
+}
+
+void CiftiRowPipeline::writeRows(const float* dataIn, const int64_t& firstRow, const int64_t& numRows) const
+{
+    for (int64_t r = 0; r < numRows; ++r)
+    {
+        if (m_rowDims.size() == 1)
+        {
+            m_output->setRow(dataIn + r * m_outputRowLength, firstRow + r);
+        } else {
+            m_output->setRow(dataIn + r * m_outputRowLength, getRowIndex(firstRow + r));
+        }
+    }
+}
+
+void CiftiRowPipeline::run(const Kernel& kernel)
+{
+    if (m_numRows == 0) return;
+    int64_t rowBytes = m_outputRowLength;
+    for (int i = 0; i < (int)m_inputRowLengths.size(); ++i)
+    {
+        rowBytes += m_inputRowLengths[i];
+    }
+    rowBytes = max(int64_t(1), rowBytes * (int64_t)sizeof(float));
+    int64_t blockRows = max(int64_t(1), min(m_numRows, m_blockBytes / rowBytes));
+    int64_t numBlocks = (m_numRows + blockRows - 1) / blockRows;
+    vector<PipelineSlot> slots(min((int64_t)m_numBlocks, numBlocks));
+    for (int s = 0; s < (int)slots.size(); ++s)
+    {
+        slots[s].m_inputs.resize(m_inputs.size());
+        for (int i = 0; i < (int)m_inputs.size(); ++i)
+        {
+            slots[s].m_inputs[i].resize(blockRows * m_inputRowLengths[i]);
+        }
+        slots[s].m_output.resize(blockRows * m_outputRowLength);
+    }
+    //every stage handles blocks in order, so block b always uses slot b % slots.size(), and the semaphores count the slots ready for each stage
+    QSemaphore freeSlots((int)slots.size()), readSlots, computedSlots;
+    CaretMutex errorMutex;
+    bool aborted = false;
+    exception_ptr firstError;
+    auto fail = [&](exception_ptr error)
+    {
+        {
+            CaretMutexLocker locker(&errorMutex);
+            if (!firstError) firstError = error;
+            aborted = true;
+        }
+        freeSlots.release();//each semaphore has one waiting stage, which checks for abort after waking
+        readSlots.release();
+        computedSlots.release();
+    };
+    //wait for the slot of a block, returns -1 if another stage failed
+    auto takeSlot = [&](QSemaphore& ready, const int64_t& block) -> int
+    {
+        ready.acquire();
+        CaretMutexLocker locker(&errorMutex);
+        if (aborted) return -1;
+        return (int)(block % (int64_t)slots.size());
+    };
+    PipelineStageThread reader([&]
+    {
+        try
+        {
+            for (int64_t b = 0; b < numBlocks; ++b)
+            {
+                int slot = takeSlot(freeSlots, b);
+                if (slot == -1) return;
+                PipelineSlot& mySlot = slots[slot];
+                mySlot.m_firstRow = b * blockRows;
+                mySlot.m_numRows = min(blockRows, m_numRows - mySlot.m_firstRow);
+                for (int i = 0; i < (int)m_inputs.size(); ++i)
+                {
+                    readRows(m_inputs[i], mySlot.m_inputs[i].data(), mySlot.m_firstRow, mySlot.m_numRows, m_inputRowLengths[i]);
+                }
+                readSlots.release();
+            }
+        } catch (...) {
+            fail(current_exception());
+        }
+    });
+    PipelineStageThread writer([&]
+    {
+        try
+        {
+            for (int64_t b = 0; b < numBlocks; ++b)
+            {
+                int slot = takeSlot(computedSlots, b);
+                if (slot == -1) return;
+                writeRows(slots[slot].m_output.data(), slots[slot].m_firstRow, slots[slot].m_numRows);
+                freeSlots.release();
+            }
+        } catch (...) {
+            fail(current_exception());
+        }
+    });
+    reader.start();
+    writer.start();
+    try
+    {//compute on the calling thread, so that the kernel uses the usual OpenMP thread team
+#ifdef CARET_OMP
+        const int64_t partsPerThread = 4;//for load balancing with dynamic scheduling
+        const int64_t maxParts = omp_get_max_threads() * partsPerThread;
+#else
+        const int64_t maxParts = 1;
+#endif
+        for (int64_t b = 0; b < numBlocks; ++b)
+        {
+            int slot = takeSlot(readSlots, b);
+            if (slot == -1) break;
+            const PipelineSlot& mySlot = slots[slot];
+            int64_t numParts = min(mySlot.m_numRows, maxParts);
+            exception_ptr kernelError;
+#pragma omp CARET_PARFOR schedule(dynamic)
+            for (int64_t part = 0; part < numParts; ++part)
+            {
+                int64_t partStart = mySlot.m_numRows * part / numParts, partEnd = mySlot.m_numRows * (part + 1) / numParts;
+                CiftiRowBlock myBlock;
+                myBlock.m_firstRow = mySlot.m_firstRow + partStart;
+                myBlock.m_numRows = partEnd - partStart;
+                myBlock.m_inputRowLengths = m_inputRowLengths;
+                for (int i = 0; i < (int)m_inputs.size(); ++i)
+                {
+                    myBlock.m_inputs.push_back(mySlot.m_inputs[i].data() + partStart * m_inputRowLengths[i]);
+                }
+                myBlock.m_output = const_cast<float*>(mySlot.m_output.data()) + partStart * m_outputRowLength;//parts don't overlap
+                myBlock.m_outputRowLength = m_outputRowLength;
+                try
+                {
+                    kernel(myBlock);
+                } catch (...) {//exceptions can't leave an OpenMP region
+#pragma omp critical
+                    {
+                        if (!kernelError) kernelError = current_exception();
+                    }
+                }
+            }
+            if (kernelError) rethrow_exception(kernelError);
+            computedSlots.release();
+        }
+    } catch (...) {
+        fail(current_exception());
+    }
+    reader.wait();
+    writer.wait();
+    if (firstError) rethrow_exception(firstError);
+}
@@ -0,0 +1,86 @@
+#ifndef __CIFTI_ROW_PIPELINE_H__
+#define __CIFTI_ROW_PIPELINE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <functional>
+#include <stdint.h>
+#include <vector>
+
+namespace caret
+{
+    class CiftiFile;
+
+    ///a block of consecutive rows handed to a pipeline kernel, rows are in getIteratorOverRows() order
+    class CiftiRowBlock
+    {
+        int64_t m_firstRow, m_numRows;
+        std::vector<const float*> m_inputs;
+        std::vector<int64_t> m_inputRowLengths;
+        float* m_output;
+        int64_t m_outputRowLength;
+        friend class CiftiRowPipeline;
+    public:
+        int64_t getFirstRow() const { return m_firstRow; }
+        int64_t getNumberOfRows() const { return m_numRows; }
+        ///row is relative to the start of the block
+        const float* getInputRow(const int& input, const int64_t& row) const { return m_inputs[input] + row * m_inputRowLengths[input]; }
+        float* getOutputRow(const int64_t& row) const { return m_output + row * m_outputRowLength; }
+        int64_t getInputRowLength(const int& input) const { return m_inputRowLengths[input]; }
+        int64_t getOutputRowLength() const { return m_outputRowLength; }
+    };
+
+    ///runs a row-wise computation with reading, computing and writing overlapped:
+    ///a reader thread fills blocks of input rows ahead of the computation, the kernel runs on parts of each block in parallel,
+    ///and a writer thread writes finished blocks in row order, with a bounded number of blocks in flight
+    class CiftiRowPipeline
+    {
+    public:
+        ///called concurrently on disjoint parts of a block, so it must not modify shared state
+        typedef std::function<void(const CiftiRowBlock& block)> Kernel;
+
+        ///inputs must have the same dimensions except along row, output XML must already be set, with the same dimensions as the inputs except along row
+        CiftiRowPipeline(const std::vector<const CiftiFile*>& inputs, CiftiFile* output);
+
+        ///approximate memory for the input and output rows of one block
+        void setBlockBytes(const int64_t& bytes);
+        ///number of blocks that may be in flight at once (reading, computing, or writing), minimum 3
+        void setNumberOfBlocksInFlight(const int& numBlocks);
+
+        ///rethrows the first exception from reading, the kernel, or writing, after all threads have stopped
+        void run(const Kernel& kernel);
+
+        int64_t getNumberOfRows() const { return m_numRows; }
+        ///convert a row number in iteration order to the index vector for getRow/setRow
+        std::vector<int64_t> getRowIndex(int64_t row) const;
+    private:
+        std::vector<const CiftiFile*> m_inputs;
+        CiftiFile* m_output;
+        std::vector<int64_t> m_rowDims, m_inputRowLengths;
+        int64_t m_outputRowLength, m_numRows, m_blockBytes;
+        int m_numBlocks;
+
+        void readRows(const CiftiFile* file, float* dataOut, const int64_t& firstRow, const int64_t& numRows, const int64_t& rowLength) const;
+        void writeRows(const float* dataIn, const int64_t& firstRow, const int64_t& numRows) const;
+    };
+}
+
+#endif //__CIFTI_ROW_PIPELINE_H__
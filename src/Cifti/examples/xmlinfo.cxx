@@ -94,7 +94,7 @@ int main(int argc, char** argv)
                     {
                         cout << "   Index " << i << ", name '" << myParcels[i].m_name << "': ";
                         int numVerts = 0;
-                        for (map<StructureEnum::Enum, set<int64_t> >::const_iterator iter = myParcels[i].m_surfaceNodes.begin(); iter != myParcels[i].m_surfaceNodes.end(); ++iter)
+                        for (map<StructureEnum::Enum, CaretSortedVectorSet<int64_t> >::const_iterator iter = myParcels[i].m_surfaceNodes.begin(); iter != myParcels[i].m_surfaceNodes.end(); ++iter)
                         {
                             numVerts += iter->second.size();
                         }
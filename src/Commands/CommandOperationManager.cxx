@@ -28,6 +28,7 @@
 #include "AlgorithmBorderResample.h"
 #include "AlgorithmBorderToVertices.h"
 #include "AlgorithmCiftiAllLabelsToROIs.h"
+#include "AlgorithmCiftiAverageDenseCorrelation.h"
 #include "AlgorithmCiftiAverageDenseROI.h"
 #include "AlgorithmCiftiAverageROICorrelation.h"
 #include "AlgorithmCiftiCorrelation.h"
@@ -198,12 +199,14 @@
 #include "OperationMetricWeightedStats.h"
 #include "OperationNiftiInformation.h"
 #include "OperationProbtrackXDotConvert.h"
+#include "OperationResamplePlanCreate.h"
 #include "OperationSceneFileMerge.h"
 #include "OperationSceneFileRelocate.h"
 #include "OperationSetMapName.h"
 #include "OperationSetMapNames.h"
 #include "OperationSetStructure.h"
 #include "OperationShowScene.h"
+#include "OperationShowSceneBatch.h"
 #include "OperationShowSceneTwo.h"
 #include "OperationSpecFileMerge.h"
 #include "OperationSpecFileRelocate.h"
@@ -252,6 +255,11 @@
 #include "CaretLogger.h"
 #include "dot_wrapper.h"
 #include "CaretCommandGlobalOptions.h"
+#include "CaretCommandLine.h"
+#include "CaretProfiler.h"
+#include "CommandFileCache.h"
+
+#include <QFile>
 
 #include <iostream>
 #include <map>
@@ -296,6 +304,7 @@ CommandOperationManager::CommandOperationManager()
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmBorderResample()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmBorderToVertices()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiAllLabelsToROIs()));
+    this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiAverageDenseCorrelation()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiAverageDenseROI()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiAverageROICorrelation()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiCorrelation()));
@@ -459,6 +468,7 @@ CommandOperationManager::CommandOperationManager()
     this->commandOperations.push_back(new CommandParser(new AutoOperationMetricWeightedStats()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationNiftiInformation()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationProbtrackXDotConvert()));
+    this->commandOperations.push_back(new CommandParser(new AutoOperationResamplePlanCreate()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationSceneFileMerge()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationSceneFileRelocate()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationSetMapNames()));
@@ -469,6 +479,9 @@ CommandOperationManager::CommandOperationManager()
     if (OperationShowSceneTwo::isShowSceneCommandAvailable()) {
         this->commandOperations.push_back(new CommandParser(new AutoOperationShowSceneTwo()));
     }
+    if (OperationShowSceneBatch::isShowSceneCommandAvailable()) {
+        this->commandOperations.push_back(new CommandParser(new AutoOperationShowSceneBatch()));
+    }
     this->commandOperations.push_back(new CommandParser(new AutoOperationSpecFileMerge()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationSpecFileRelocate()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationSurfaceClosestVertex()));
@@ -540,6 +553,48 @@ CommandOperationManager::~CommandOperationManager()
 
 namespace
 {
+    //split a batch script line into arguments like a shell would for simple quoting, without any expansion
+    vector<AString> splitBatchLine(const AString& line, const int64_t& lineNumber)
+    {
+        vector<AString> ret;
+        AString current;
+        bool inToken = false;
+        QChar quote;//null when not inside quotes
+        for (int i = 0; i < line.size(); ++i)
+        {
+            QChar c = line[i];
+            if (!quote.isNull())
+            {
+                if (c == quote)
+                {
+                    quote = QChar();
+                } else if (c == '\\' && quote == '"' && i + 1 < line.size() && (line[i + 1] == '"' || line[i + 1] == '\\')) {
+                    current += line[++i];
+                } else {
+                    current += c;
+                }
+            } else if (c == '\'' || c == '"') {
+                quote = c;
+                inToken = true;
+            } else if (c == '\\' && i + 1 < line.size()) {
+                current += line[++i];
+                inToken = true;
+            } else if (c.isSpace()) {
+                if (inToken) ret.push_back(current);
+                current = "";
+                inToken = false;
+            } else if (c == '#' && !inToken) {
+                break;//comment to end of line
+            } else {
+                current += c;
+                inToken = true;
+            }
+        }
+        if (!quote.isNull()) throw CommandException("unterminated quote on line " + AString::number(lineNumber) + " of batch script");
+        if (inToken) ret.push_back(current);
+        return ret;
+    }
+
     //quick hack to convert type argument to internal integer
     int16_t stringToNiftiType(const AString& input)
     {
@@ -562,6 +617,48 @@ namespace
         }
         return iter->second;
     }
+
+    ///starts profiling if requested, and writes the report when the command is done, even if it failed
+    ///lines of a batch script that is already being profiled are recorded in the batch report instead
+    class ProfileReport
+    {
+        AString m_fileName;
+        bool m_finished;
+    public:
+        ProfileReport(const AString& fileName)
+        {
+            m_finished = true;
+            if (fileName == "" || CaretProfiler::isEnabled()) return;
+            m_fileName = fileName;
+            m_finished = false;
+            CaretProfiler::start();
+        }
+
+        ///call after the command succeeds, so that failure to write the report is an error
+        void finish()
+        {
+            if (m_finished) return;
+            m_finished = true;
+            try
+            {
+                CaretProfiler::writeReport(m_fileName, caret_global_commandLine);
+            } catch (...) {
+                CaretProfiler::stop();
+                throw;
+            }
+            CaretProfiler::stop();
+        }
+
+        ~ProfileReport()
+        {
+            try
+            {
+                finish();
+            } catch (CaretException& e) {
+                CaretLogWarning(e.whatString());
+            }
+        }
+    };
 }
 
 /**
@@ -629,6 +726,12 @@ CommandOperationManager::runCommand(ProgramParameters& parameters)
     {
         caret_global_command_options.m_ciftiReadMemory = true;
     }
+    AString profileFileName;
+    if (getGlobalOption(parameters, "-profile", 1, globalOptionArgs))
+    {
+        profileFileName = globalOptionArgs[0];
+    }
+    ProfileReport myProfileReport(profileFileName);
 
     const uint64_t numberOfCommands = this->commandOperations.size();
     const uint64_t numberOfDeprecated = this->deprecatedOperations.size();
@@ -666,6 +769,13 @@ CommandOperationManager::runCommand(ProgramParameters& parameters)
         printDeprecatedCommands();
     } else if (commandSwitch == "-all-commands-help") {
         printAllCommandsHelpInfo(myProgramName);
+    } else if (commandSwitch == "-batch") {
+        if (parameters.hasNext())
+        {
+            runBatch(parameters);
+        } else {
+            printBatchHelp(myProgramName);
+        }
     } else {
         
         CommandOperation* operation = NULL;
@@ -702,10 +812,94 @@ CommandOperationManager::runCommand(ProgramParameters& parameters)
             {
                 cout << operation->getHelpInformation(myProgramName) << endl;
             } else {
+                CaretProfiler::Scope myScope(commandSwitch);
                 operation->execute(parameters, preventProvenance);
             }
         }
     }
+    myProfileReport.finish();
+}
+
+/**
+ * Run every command in a batch script in this process, keeping input files
+ * loaded between commands.
+ *
+ * @param parameters
+ *    Parameters after the -batch switch.
+ * @throws CommandException
+ *    If a line of the script failed, after stopping the script.
+ */
+void CommandOperationManager::runBatch(ProgramParameters& parameters)
+{
+    AString scriptName = parameters.nextString("batch script");
+    int64_t cacheMegabytes = 2048;
+    while (parameters.hasNext())
+    {
+        AString option = parameters.nextString("batch option");
+        if (option == "-cache-mb")
+        {
+            cacheMegabytes = parameters.nextLong("cache size in megabytes");
+            if (cacheMegabytes < 0) throw CommandException("cache size must not be negative");
+        } else {
+            throw CommandException("unrecognized option to -batch: '" + option + "'");
+        }
+    }
+    QFile scriptFile;
+    bool opened = false;
+    if (scriptName == "-")
+    {
+        opened = scriptFile.open(stdin, QIODevice::ReadOnly | QIODevice::Text);
+    } else {
+        scriptFile.setFileName(scriptName);
+        opened = scriptFile.open(QIODevice::ReadOnly | QIODevice::Text);
+    }
+    if (!opened) throw CommandException("failed to open batch script '" + scriptName + "'");
+    const CommandGlobalOptions savedOptions = caret_global_command_options;
+    const AString savedCommandLine = caret_global_commandLine;
+    CommandFileCache::setEnabled(true, cacheMegabytes * 1024 * 1024);
+    try
+    {
+        int64_t lineNumber = 0;
+        while (!scriptFile.atEnd())
+        {
+            ++lineNumber;
+            AString line = AString::fromLocal8Bit(scriptFile.readLine()).trimmed();
+            vector<AString> arguments = splitBatchLine(line, lineNumber);
+            if (!arguments.empty() && (arguments[0] == "wb_command" || arguments[0].endsWith("/wb_command")))
+            {
+                arguments.erase(arguments.begin());
+            }
+            if (arguments.empty()) continue;
+            if (arguments[0] == "-batch") throw CommandException("batch scripts can't run -batch, on line " + AString::number(lineNumber));
+            vector<QByteArray> argBytes(1, QByteArray("wb_command"));
+            for (size_t i = 0; i < arguments.size(); ++i)
+            {
+                argBytes.push_back(arguments[i].toLocal8Bit());
+            }
+            vector<const char*> argPointers;
+            for (size_t i = 0; i < argBytes.size(); ++i)
+            {
+                argPointers.push_back(argBytes[i].constData());
+            }
+            ProgramParameters lineParameters((int)argPointers.size(), argPointers.data());
+            caret_global_commandLine_init(lineParameters);//so that provenance shows the line, not the batch invocation
+            CaretLogInfo("batch line " + AString::number(lineNumber) + ": " + caret_global_commandLine);
+            try
+            {
+                runCommand(lineParameters);
+            } catch (CaretException& e) {
+                throw CommandException("batch script line " + AString::number(lineNumber) + " failed: " + e.whatString());
+            }
+            caret_global_command_options = savedOptions;//global options given on a line only apply to that line
+        }
+    } catch (...) {
+        CommandFileCache::setEnabled(false);
+        caret_global_command_options = savedOptions;
+        caret_global_commandLine = savedCommandLine;
+        throw;
+    }
+    CommandFileCache::setEnabled(false);
+    caret_global_commandLine = savedCommandLine;
 }
 
 AString CommandOperationManager::doCompletion(ProgramParameters& parameters, const bool& useExtGlob)
@@ -759,7 +953,12 @@ AString CommandOperationManager::doCompletion(ProgramParameters& parameters, con
         return "";
     }
     /*OptionInfo ciftiReadMemInfo = */parseGlobalOption(parameters, "-cifti-read-memory", 0, globalOptionArgs, true);
-    ret = "wordlist -disable-provenance\\ -logging\\ -simd\\ -cifti-output-datatype\\ -cifti-output-range\\ -nifti-output-datatype\\ -nifti-output-range\\ -cifti-read-memory";//we could prevent suggesting an already-provided global option, but that would be a bit surprising
+    OptionInfo profileInfo = parseGlobalOption(parameters, "-profile", 1, globalOptionArgs, true);
+    if (profileInfo.specified && !profileInfo.complete)
+    {
+        return "fileglob *.json";
+    }
+    ret = "wordlist -disable-provenance\\ -logging\\ -simd\\ -cifti-output-datatype\\ -cifti-output-range\\ -nifti-output-datatype\\ -nifti-output-range\\ -cifti-read-memory\\ -profile";//we could prevent suggesting an already-provided global option, but that would be a bit surprising
     const uint64_t numberOfCommands = this->commandOperations.size();
     const uint64_t numberOfDeprecated = this->deprecatedOperations.size();
     if (!parameters.hasNext())
@@ -1022,6 +1221,10 @@ void CommandOperationManager::printHelpInfo()
     cout << "   -all-commands-help          show all processing subcommands and their help" << endl;
     cout << "                                  info - VERY LONG" << endl;
     cout << endl;
+    cout << "Batch processing:" << endl;
+    cout << "   -batch                      run a script of commands in one process, reusing" << endl;
+    cout << "                                  loaded input files" << endl;
+    cout << endl;
     cout << "To get the help information of a processing subcommand, run it without any" << endl;
     cout << "   additional arguments." << endl;
     cout << endl;
@@ -1164,6 +1367,11 @@ void CommandOperationManager::printGlobalOptions()
     cout << "                                        avoid hitting limits on number of open" << endl;
     cout << "                                        files" << endl;
     cout << endl;
+    cout << "   -profile <file>                   write a JSON report of wall and cpu time," << endl;
+    cout << "                                        peak memory, and bytes read and written" << endl;
+    cout << "                                        for the command and each algorithm it" << endl;
+    cout << "                                        uses, to the given file" << endl;
+    cout << endl;
     cout << "   -cifti-output-datatype <type>     deprecated, only affects cifti outputs" << endl;
     cout << "   -cifti-output-range <min> <max>   deprecated, only affects cifti outputs" << endl;
     cout << endl;
@@ -1325,6 +1533,30 @@ void CommandOperationManager::printParallelHelp(const AString& programName)
     cout << endl;//guide for wrap, assuming 80 columns:                                     |
 }
 
+void CommandOperationManager::printBatchHelp(const AString& programName)
+{
+    //guide for wrap, assuming 80 columns:                                                  |
+    cout << "RUN MANY COMMANDS IN ONE PROCESS" << endl;
+    cout << "   " << programName << " -batch <script> [-cache-mb <size>]" << endl;
+    cout << endl;
+    cout << "   <script> - text file of commands, one per line, or - to read from stdin" << endl;
+    cout << "   -cache-mb - memory limit for cached input files, default 2048" << endl;
+    cout << endl;//guide for wrap, assuming 80 columns:                                     |
+    cout << "   Each line of the script is a " << programName << " command, with or without the" << endl;
+    cout << "   leading '" << programName << "'.  Arguments are split on whitespace, and single" << endl;
+    cout << "   quotes, double quotes, and backslashes work as in a shell, but there is no" << endl;
+    cout << "   variable or wildcard expansion.  Blank lines and text after a # are ignored." << endl;
+    cout << "   The script stops at the first command that fails." << endl;
+    cout << endl;//guide for wrap, assuming 80 columns:                                     |
+    cout << "   Surface, metric, volume, and cifti inputs stay loaded between commands, so" << endl;
+    cout << "   a file used by several commands is read only once, and things computed from" << endl;
+    cout << "   surfaces (topology, geodesic distance helpers) are also reused.  A cached" << endl;
+    cout << "   file is read again if its size or modification time changes, or when a" << endl;
+    cout << "   command writes an output with the same name.  Global options on a line" << endl;
+    cout << "   apply only to that line, except for -logging and -simd." << endl;
+    cout << endl;
+}
+
 void CommandOperationManager::printVersionInfo()
 {
     ApplicationInformation myInfo;
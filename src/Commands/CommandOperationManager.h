@@ -79,6 +79,10 @@ namespace caret {
         
         void printVersionInfo();
         
+        void printBatchHelp(const AString& programName);
+        
+        void runBatch(ProgramParameters& parameters);
+        
         bool getGlobalOption(ProgramParameters& parameters, const AString& optionString, const int& numArgs, std::vector<AString>& arguments);
         
         struct OptionInfo
@@ -29,7 +29,9 @@
 #include "CaretCommandGlobalOptions.h"
 #include "CaretDataFileHelper.h"
 #include "CaretLogger.h"
+#include "CaretProfiler.h"
 #include "CiftiFile.h"
+#include "CommandFileCache.h"
 #include "DataFileException.h"
 #include "FileInformation.h"
 #include "FociFile.h"
@@ -69,12 +71,16 @@ void CommandParser::executeOperation(ProgramParameters& parameters)
     vector<OutputAssoc> myOutAssoc;
     ProvenanceHelper myProvHelp;//set as much provenance in advance as we can, so on-disk outputs get it
     myProvHelp.m_provenance = caret_global_commandLine;
-    myProvHelp.m_doProvenance = m_doProvenance;
+    bool doProvenance = m_doProvenance;
+    m_doProvenance = true;//parser objects are reused by batch mode, so only apply -disable-provenance to this invocation
+    m_inputCiftiOnDiskMap.clear();
+    myProvHelp.m_doProvenance = doProvenance;
     myProvHelp.m_workingDir = QDir::currentPath();//get the current path, in case some stupid command changes the working directory
     //these get set on output files during provenanceAfterOperation (and for on-disk in OperationParameters)
     parseComponent(myAlgParams.getPointer(), parameters, myOutAssoc);//parsing block
     parameters.verifyAllParametersProcessed();
     checkOnDiskOutputCollision(myOutAssoc);//check for input on-disk files used as output on-disk files
+    invalidateCachedOutputs(myOutAssoc);//don't let batch mode read a stale cached file that this command is overwriting
     //code to show what arguments map to what parameters should go here
     vector<AString> versionInfo;
     ApplicationInformation myInfo;
@@ -89,6 +95,7 @@ void CommandParser::executeOperation(ProgramParameters& parameters)
     {
         myAlgParams->checkInputFilesExist();
     } else {
+        CaretProfiler::Scope myScope("(read inputs)");
         myAlgParams->openAllInputFiles();//this completes the provenance info when executed
     }
     m_autoOper->useParameters(myAlgParams.getPointer(), NULL);//TODO: progress status for caret_command? would probably get messed up by any command info output
@@ -99,7 +106,9 @@ void CommandParser::executeOperation(ProgramParameters& parameters)
     }
     //myOutAssoc (in fact, most of the parameter tree) is not smart pointers and won't keep the output files allocated
     myAlgParams->closeAllInputFiles();
-    if (m_doProvenance) provenanceAfterOperation(myOutAssoc, myProvHelp);
+    if (doProvenance) provenanceAfterOperation(myOutAssoc, myProvHelp);
+    invalidateCachedOutputs(myOutAssoc);//release cached inputs with the same name before overwriting them
+    CaretProfiler::Scope myScope("(write outputs)");
     writeOutput(myOutAssoc);
 }
 
@@ -790,6 +799,15 @@ void CommandParser::checkOnDiskOutputCollision(const vector<OutputAssoc>& outAss
     }
 }
 
+void CommandParser::invalidateCachedOutputs(const vector<OutputAssoc>& outAssociation)
+{
+    if (!CommandFileCache::isEnabled()) return;
+    for (uint32_t i = 0; i < outAssociation.size(); ++i)
+    {
+        CommandFileCache::invalidate(outAssociation[i].m_fileName);
+    }
+}
+
 void CommandParser::writeOutput(const vector<OutputAssoc>& outAssociation)
 {
     for (uint32_t i = 0; i < outAssociation.size(); ++i)
@@ -20,6 +20,8 @@
 
 #include "CaretPointLocator.h"
 #include "CaretHeap.h"
+#include "CaretOMP.h"
+#include <algorithm>
 #include <cmath>
 
 using namespace caret;
@@ -73,6 +75,7 @@ void CaretPointLocator::addPoint(Oct<LeafVector<Point> >* thisOct, const float p
 int32_t CaretPointLocator::addPointSet(const float* coordsIn, const int64_t numCoords)
 {
     CaretMutexLocker locked(&m_modifyMutex);
+    m_flatValid.store(false);
     int32_t setNum = newIndex();
     if (numCoords < 1) return setNum;
     if (m_tree == NULL)
@@ -104,6 +107,7 @@ CaretPointLocator::CaretPointLocator(const float* coordsIn, const int64_t numCoo
 {
     m_nextSetIndex = 1;//next set will be set #1
     m_tree = NULL;
+    m_flatValid.store(false);
     if (numCoords >= 1)
     {
         Vector3D minBox, maxBox;
@@ -131,6 +135,7 @@ CaretPointLocator::CaretPointLocator(const float minBounds[3], const float maxBo
 {
     m_nextSetIndex = 0;
     m_tree = new Oct<LeafVector<Point> >(minBounds, maxBounds);
+    m_flatValid.store(false);
 }
 
 int64_t CaretPointLocator::closestPoint(const float target[3], LocatorInfo* infoOut) const
@@ -365,6 +370,7 @@ int32_t CaretPointLocator::newIndex()
 void CaretPointLocator::removePointSet(int32_t whichSet)
 {
     CaretMutexLocker locked(&m_modifyMutex);
+    m_flatValid.store(false);
     m_unusedIndexes.push_back(whichSet);
     removeSetHelper(m_tree, whichSet);
 }
@@ -411,3 +417,185 @@ void CaretPointLocator::removeSetHelper(Oct<LeafVector<CaretPointLocator::Point>
         }
     }
 }
+
+float CaretPointLocator::FlatNode::distSquaredToPoint(const float point[3]) const
+{
+    float ret = 0.0f;
+    for (int i = 0; i < 3; ++i)
+    {
+        float tempf = 0.0f;
+        if (point[i] < m_minBounds[i])
+        {
+            tempf = m_minBounds[i] - point[i];
+        } else if (point[i] > m_maxBounds[i]) {
+            tempf = point[i] - m_maxBounds[i];
+        }
+        ret += tempf * tempf;
+    }
+    return ret;
+}
+
+void CaretPointLocator::ensureFlatTree() const
+{
+    if (m_flatValid.load(std::memory_order_acquire)) return;//try to avoid locking even once, acquire pairs with the release below
+    CaretMutexLocker locked(&m_flatMutex);
+    if (m_flatValid.load(std::memory_order_acquire)) return;//test again AFTER lock, another thread may have built it
+    m_flatNodes.clear();
+    m_flatPoints.clear();
+    if (m_tree != NULL)
+    {//breadth first, so that the 8 children of a node are consecutive
+        vector<const Oct<LeafVector<Point> >*> octs(1, m_tree);
+        m_flatNodes.resize(1);
+        for (size_t i = 0; i < octs.size(); ++i)
+        {
+            const Oct<LeafVector<Point> >* thisOct = octs[i];
+            FlatNode node;
+            for (int m = 0; m < 3; ++m)
+            {
+                node.m_minBounds[m] = thisOct->m_bounds[m][0];
+                node.m_maxBounds[m] = thisOct->m_bounds[m][2];
+            }
+            node.m_firstChild = -1;
+            node.m_pointStart = m_flatPoints.size();
+            if (thisOct->m_leaf)
+            {
+                const vector<Point>& myVecRef = *(thisOct->m_data.m_vector);
+                m_flatPoints.insert(m_flatPoints.end(), myVecRef.begin(), myVecRef.end());
+            } else {
+                node.m_firstChild = octs.size();
+                for (int ii = 0; ii < 2; ++ii)
+                {
+                    for (int ij = 0; ij < 2; ++ij)
+                    {
+                        for (int ik = 0; ik < 2; ++ik)
+                        {
+                            octs.push_back(thisOct->m_children[ii][ij][ik]);
+                        }
+                    }
+                }
+                m_flatNodes.resize(octs.size());
+            }
+            node.m_pointEnd = m_flatPoints.size();
+            m_flatNodes[i] = node;
+        }
+    }
+    m_flatValid.store(true, std::memory_order_release);//publish only after the flat tree is complete
+}
+
+void CaretPointLocator::kClosestFlat(const float target[3], const int32_t k, pair<float, int64_t>* bestScratch, LocatorInfo* resultsOut) const
+{//bestScratch holds the best points so far, sorted by distance squared, as (distance squared, index into m_flatPoints)
+    int32_t numBest = 0;
+    CaretSimpleMinHeap<int64_t, float> myHeap;
+    myHeap.push(0, m_flatNodes[0].distSquaredToPoint(target));
+    while (!myHeap.isEmpty())
+    {
+        float curDist2;
+        int64_t thisNode = myHeap.pop(&curDist2);
+        if (numBest == k && curDist2 > bestScratch[k - 1].first) break;//nothing left can be closer
+        const FlatNode& node = m_flatNodes[thisNode];
+        if (node.m_firstChild < 0)
+        {
+            for (int64_t i = node.m_pointStart; i < node.m_pointEnd; ++i)
+            {
+                float tempf = MathFunctions::distanceSquared3D(m_flatPoints[i].m_point, target);
+                if (numBest < k || tempf < bestScratch[numBest - 1].first)
+                {//insertion into sorted list, k is expected to be small
+                    int32_t insertAt = (numBest < k ? numBest : k - 1);
+                    while (insertAt > 0 && bestScratch[insertAt - 1].first > tempf)
+                    {
+                        bestScratch[insertAt] = bestScratch[insertAt - 1];
+                        --insertAt;
+                    }
+                    bestScratch[insertAt] = pair<float, int64_t>(tempf, i);
+                    if (numBest < k) ++numBest;
+                }
+            }
+        } else {
+            for (int64_t child = node.m_firstChild; child < node.m_firstChild + 8; ++child)
+            {
+                float tempf = m_flatNodes[child].distSquaredToPoint(target);
+                if (numBest < k || tempf <= bestScratch[k - 1].first)
+                {
+                    myHeap.push(child, tempf);
+                }
+            }
+        }
+    }
+    for (int32_t i = 0; i < k; ++i)
+    {
+        if (i < numBest)
+        {
+            const Point& thisPoint = m_flatPoints[bestScratch[i].second];
+            resultsOut[i] = LocatorInfo(thisPoint.m_index, thisPoint.m_mySet, thisPoint.m_point);
+        } else {
+            resultsOut[i] = LocatorInfo();
+        }
+    }
+}
+
+namespace
+{
+    ///interleave the low 10 bits of x with two zero bits between each bit
+    uint32_t spreadBits(uint32_t x)
+    {
+        x &= 0x3ff;
+        x = (x | (x << 16)) & 0x030000ff;
+        x = (x | (x << 8)) & 0x0300f00f;
+        x = (x | (x << 4)) & 0x030c30c3;
+        x = (x | (x << 2)) & 0x09249249;
+        return x;
+    }
+}
+
+vector<LocatorInfo> CaretPointLocator::kClosestPoints(const float* targets, const int64_t numTargets, const int32_t k) const
+{
+    vector<LocatorInfo> ret;
+    if (numTargets < 1 || k < 1) return ret;
+    ret.resize(numTargets * k);
+    ensureFlatTree();
+    if (m_flatNodes.empty()) return ret;//no points, results are already index -1
+    const FlatNode& root = m_flatNodes[0];
+    float scale[3];
+    for (int m = 0; m < 3; ++m)
+    {
+        float range = root.m_maxBounds[m] - root.m_minBounds[m];
+        scale[m] = (range > 0.0f ? 1023.0f / range : 0.0f);
+    }
+    vector<pair<uint32_t, int64_t> > order(numTargets);//morton code of each target, so nearby queries are answered together
+    for (int64_t i = 0; i < numTargets; ++i)
+    {
+        const float* target = targets + i * 3;
+        uint32_t code = 0;
+        for (int m = 0; m < 3; ++m)
+        {
+            float cell = (target[m] - root.m_minBounds[m]) * scale[m];
+            if (!(cell > 0.0f)) cell = 0.0f;//also catches NaN
+            if (cell > 1023.0f) cell = 1023.0f;
+            code |= spreadBits((uint32_t)cell) << m;
+        }
+        order[i] = pair<uint32_t, int64_t>(code, i);
+    }
+    sort(order.begin(), order.end());
+#pragma omp CARET_PAR
+    {
+        vector<pair<float, int64_t> > bestScratch(k);
+#pragma omp CARET_FOR schedule(dynamic, 64)
+        for (int64_t i = 0; i < numTargets; ++i)
+        {
+            const int64_t which = order[i].second;
+            kClosestFlat(targets + which * 3, k, bestScratch.data(), ret.data() + which * k);
+        }
+    }
+    return ret;
+}
+
+vector<int64_t> CaretPointLocator::closestPoints(const float* targets, const int64_t numTargets) const
+{
+    vector<LocatorInfo> closest = kClosestPoints(targets, numTargets, 1);
+    vector<int64_t> ret(closest.size());
+    for (size_t i = 0; i < closest.size(); ++i)
+    {
+        ret[i] = closest[i].index;
+    }
+    return ret;
+}
@@ -26,6 +26,7 @@
 #include "OctTree.h"
 #include "Vector3D.h"
 
+#include <atomic>
 #include <set>
 #include <vector>
 
@@ -64,8 +65,22 @@ namespace caret {
                 m_mySet = mySet;
             }
         };
+        ///octree flattened into arrays for batch queries, children of a node are consecutive
+        struct FlatNode
+        {
+            float m_minBounds[3], m_maxBounds[3];
+            int64_t m_firstChild;//-1 for leaf, otherwise index of first of 8 children
+            int64_t m_pointStart, m_pointEnd;//range in m_flatPoints, for leaves
+            float distSquaredToPoint(const float point[3]) const;
+        };
         CaretMutex m_modifyMutex;//thread safety, don't let multiple threads modify the point sets at once
         Oct<LeafVector<Point> >* m_tree;
+        mutable CaretMutex m_flatMutex;
+        mutable std::vector<FlatNode> m_flatNodes;
+        mutable std::vector<Point> m_flatPoints;//points in leaf order, so a leaf's points are contiguous
+        mutable std::atomic<bool> m_flatValid;//flat tree is rebuilt lazily after point sets change, set with release after building so readers see a complete tree
+        void ensureFlatTree() const;
+        void kClosestFlat(const float target[3], const int32_t k, std::pair<float, int64_t>* bestScratch, LocatorInfo* resultsOut) const;
         int32_t m_nextSetIndex;
         std::vector<int32_t> m_unusedIndexes;
         void addPoint(Oct<LeafVector<Point> >* thisOct, const float point[3], const int64_t index, const int32_t pointSet);
@@ -82,15 +97,23 @@ namespace caret {
         CaretPointLocator(const std::vector<float> coordsIn) : CaretPointLocator(coordsIn.data(), coordsIn.size() / 3) { }
         ~CaretPointLocator() { if (m_tree != NULL) { delete m_tree; } }
         ///add a point set, SAVE THE RETURN VALUE because it is how you identify which point set found points belong to
+        ///adding and removing point sets must not happen at the same time as queries from other threads
         int32_t addPointSet(const float* coordsIn, const int64_t numCoords);
         int32_t addPointSet(const std::vector<float> coordsIn) { return addPointSet(coordsIn.data(), coordsIn.size() / 3); }
         ///remove a point set by its set number
+        ///see addPointSet, must not be called while other threads are querying
         void removePointSet(const int32_t whichSet);
         ///returns the index of the closest point, and optionally which point set and the coords
         int64_t closestPoint(const float target[3], LocatorInfo* infoOut = NULL) const;
         int64_t closestPointLimited(const float target[3], const float& maxDist, LocatorInfo* infoOut = NULL) const;
         std::vector<LocatorInfo> pointsInRange(const float target[3], const float& maxDist) const;
         bool anyInRange(const float target[3], const float& maxDist) const;
+        ///batch query: the k closest points to each of many targets, answered in parallel in spatially sorted order
+        ///results for target i are [i * k, (i + 1) * k), closest first, with index -1 when there are fewer than k points
+        std::vector<LocatorInfo> kClosestPoints(const float* targets, const int64_t numTargets, const int32_t k) const;
+        std::vector<LocatorInfo> kClosestPoints(const std::vector<float>& targets, const int32_t k) const { return kClosestPoints(targets.data(), targets.size() / 3, k); }
+        ///batch query: the index of the closest point to each of many targets
+        std::vector<int64_t> closestPoints(const float* targets, const int64_t numTargets) const;
     };
 }
 
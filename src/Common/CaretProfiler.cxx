@@ -0,0 +1,230 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretProfiler.h"
+
+#include "CaretException.h"
+#include "CaretOMP.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+
+#include <map>
+#include <vector>
+
+#ifdef CARET_OS_WINDOWS
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace caret;
+using namespace std;
+
+bool CaretProfiler::s_enabled = false;
+int64_t CaretProfiler::s_bytesRead = 0;
+int64_t CaretProfiler::s_bytesWritten = 0;
+
+namespace
+{
+    struct FrameStats
+    {
+        AString m_path, m_name;
+        int m_depth;
+        int64_t m_calls, m_bytesRead, m_bytesWritten, m_peakRss;
+        double m_wall, m_cpu;
+        FrameStats() : m_depth(0), m_calls(0), m_bytesRead(0), m_bytesWritten(0), m_peakRss(-1), m_wall(0.0), m_cpu(0.0) { }
+    };
+
+    //only touched by the thread that called start(), outside of parallel regions, so no locking
+    QThread* g_profileThread = NULL;
+    vector<FrameStats> g_frames;//in order of first use
+    map<AString, size_t> g_frameIndex;
+    vector<AString> g_pathStack;
+    QElapsedTimer g_wallTimer;
+    double g_startCpu = 0.0;
+
+    ///cpu time is for the whole process, so it includes all threads, peak rss is -1 where not available
+    void getResourceUsage(double& cpuSecondsOut, int64_t& peakRssBytesOut)
+    {
+#ifdef CARET_OS_WINDOWS
+        cpuSecondsOut = 0.0;
+        FILETIME creationTime, exitTime, kernelTime, userTime;
+        if (GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+        {//100ns units
+            ULARGE_INTEGER kernel, user;
+            kernel.LowPart = kernelTime.dwLowDateTime;
+            kernel.HighPart = kernelTime.dwHighDateTime;
+            user.LowPart = userTime.dwLowDateTime;
+            user.HighPart = userTime.dwHighDateTime;
+            cpuSecondsOut = (kernel.QuadPart + user.QuadPart) * 1e-7;
+        }
+        peakRssBytesOut = -1;
+#else
+        struct rusage myUsage;
+        if (getrusage(RUSAGE_SELF, &myUsage) != 0)
+        {
+            cpuSecondsOut = 0.0;
+            peakRssBytesOut = -1;
+            return;
+        }
+        cpuSecondsOut = myUsage.ru_utime.tv_sec + myUsage.ru_utime.tv_usec * 1e-6 + myUsage.ru_stime.tv_sec + myUsage.ru_stime.tv_usec * 1e-6;
+#ifdef CARET_OS_MACOSX
+        peakRssBytesOut = myUsage.ru_maxrss;//bytes on mac
+#else
+        peakRssBytesOut = ((int64_t)myUsage.ru_maxrss) * 1024;//kilobytes on linux
+#endif
+#endif
+    }
+
+    double wallSeconds()
+    {
+        return g_wallTimer.nsecsElapsed() * 1e-9;
+    }
+
+    int getMaxThreads()
+    {
+#ifdef CARET_OMP
+        return omp_get_max_threads();
+#else
+        return 1;
+#endif
+    }
+
+    void addTiming(QJsonObject& object, const double& wall, const double& cpu)
+    {
+        object["wall_seconds"] = wall;
+        object["cpu_seconds"] = cpu;
+        const double busy = (wall > 0.0 ? cpu / wall : 0.0);
+        object["threads_busy"] = busy;//average number of cores in use
+        object["thread_utilization"] = busy / getMaxThreads();
+    }
+}
+
+CaretProfiler::Scope::Scope(const AString& name)
+{
+    m_active = s_enabled;
+#ifdef CARET_OMP
+    if (omp_in_parallel()) m_active = false;
+#endif
+    if (m_active && QThread::currentThread() != g_profileThread) m_active = false;//other threads (such as QThread workers) would race on the path stack
+    if (!m_active) return;
+    g_pathStack.push_back(g_pathStack.empty() ? name : g_pathStack.back() + "/" + name);
+    int64_t peakRss;
+    getResourceUsage(m_startCpu, peakRss);
+    m_startWall = wallSeconds();
+    m_startRead = s_bytesRead;
+    m_startWritten = s_bytesWritten;
+}
+
+CaretProfiler::Scope::~Scope()
+{
+    if (!m_active || !s_enabled || g_pathStack.empty()) return;//profiling was restarted or stopped while this scope was open
+    double endCpu;
+    int64_t peakRss;
+    getResourceUsage(endCpu, peakRss);
+    const double endWall = wallSeconds();
+    const AString path = g_pathStack.back();
+    g_pathStack.pop_back();
+    map<AString, size_t>::iterator iter = g_frameIndex.find(path);
+    size_t index;
+    if (iter == g_frameIndex.end())
+    {
+        index = g_frames.size();
+        g_frameIndex[path] = index;
+        g_frames.push_back(FrameStats());
+        g_frames[index].m_path = path;
+        g_frames[index].m_name = path.mid(path.lastIndexOf('/') + 1);
+        g_frames[index].m_depth = (int)g_pathStack.size();
+    } else {
+        index = iter->second;
+    }
+    FrameStats& myStats = g_frames[index];
+    ++myStats.m_calls;
+    myStats.m_wall += endWall - m_startWall;
+    myStats.m_cpu += endCpu - m_startCpu;
+    myStats.m_bytesRead += s_bytesRead - m_startRead;
+    myStats.m_bytesWritten += s_bytesWritten - m_startWritten;
+    if (peakRss > myStats.m_peakRss) myStats.m_peakRss = peakRss;
+}
+
+void CaretProfiler::start()
+{
+    g_frames.clear();
+    g_frameIndex.clear();
+    g_pathStack.clear();
+    g_profileThread = QThread::currentThread();
+    s_bytesRead = 0;
+    s_bytesWritten = 0;
+    int64_t peakRss;
+    getResourceUsage(g_startCpu, peakRss);
+    g_wallTimer.start();
+    s_enabled = true;
+}
+
+void CaretProfiler::stop()
+{
+    s_enabled = false;
+    g_pathStack.clear();
+}
+
+void CaretProfiler::writeReport(const AString& filename, const AString& commandLine)
+{
+    double cpu;
+    int64_t peakRss;
+    getResourceUsage(cpu, peakRss);
+    QJsonObject report;
+    report["command"] = commandLine;
+    addTiming(report, wallSeconds(), cpu - g_startCpu);
+    report["max_threads"] = getMaxThreads();
+    report["peak_rss_bytes"] = (double)peakRss;//QJsonValue doesn't take int64 in qt5
+    report["bytes_read"] = (double)s_bytesRead;
+    report["bytes_written"] = (double)s_bytesWritten;
+    QJsonArray frames;
+    for (size_t i = 0; i < g_frames.size(); ++i)
+    {
+        const FrameStats& myStats = g_frames[i];
+        QJsonObject frame;
+        frame["path"] = myStats.m_path;
+        frame["name"] = myStats.m_name;
+        frame["depth"] = myStats.m_depth;
+        frame["calls"] = (double)myStats.m_calls;
+        addTiming(frame, myStats.m_wall, myStats.m_cpu);
+        frame["peak_rss_bytes"] = (double)myStats.m_peakRss;//process peak as of the end of this scope, so the first scope where it jumps is what raised it
+        frame["bytes_read"] = (double)myStats.m_bytesRead;
+        frame["bytes_written"] = (double)myStats.m_bytesWritten;
+        frames.append(frame);
+    }
+    report["scopes"] = frames;
+    QFile outFile(filename);
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        throw CaretException("failed to open profile output file '" + filename + "'");
+    }
+    const QByteArray contents = QJsonDocument(report).toJson();
+    if (outFile.write(contents) != contents.size())
+    {
+        throw CaretException("failed to write profile output file '" + filename + "'");
+    }
+}
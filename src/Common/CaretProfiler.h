@@ -0,0 +1,78 @@
+#ifndef __CARET_PROFILER_H__
+#define __CARET_PROFILER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AString.h"
+
+#include <stdint.h>
+
+namespace caret {
+
+    ///wall time, cpu time, peak memory and file IO per nested scope, for wb_command -profile
+    ///everything is a cheap no-op unless start() has been called
+    class CaretProfiler
+    {
+        static bool s_enabled;
+        static int64_t s_bytesRead, s_bytesWritten;
+        CaretProfiler();
+    public:
+        ///times from construction to destruction, nested scopes are recorded under the enclosing scope
+        ///scopes started inside an openmp parallel region are not recorded separately, their time counts toward the enclosing scope
+        ///scopes on threads other than the one that called start() are ignored
+        class Scope
+        {
+            bool m_active;
+            double m_startWall, m_startCpu;
+            int64_t m_startRead, m_startWritten;
+            Scope(const Scope&);
+            Scope& operator=(const Scope&);
+        public:
+            Scope(const AString& name);
+            ~Scope();
+        };
+
+        ///clears any previous results and starts recording
+        static void start();
+        static void stop();
+        static bool isEnabled() { return s_enabled; }
+
+        ///called by CaretBinaryFile, so it includes compressed files as uncompressed bytes
+        static void addBytesRead(const int64_t& bytes)
+        {
+            if (!s_enabled) return;
+#pragma omp atomic
+            s_bytesRead += bytes;
+        }
+        static void addBytesWritten(const int64_t& bytes)
+        {
+            if (!s_enabled) return;
+#pragma omp atomic
+            s_bytesWritten += bytes;
+        }
+
+        ///write everything recorded since start() as JSON
+        static void writeReport(const AString& filename, const AString& commandLine);
+    };
+
+}
+
+#endif //__CARET_PROFILER_H__
@@ -0,0 +1,126 @@
+#ifndef __CARET_SORTED_VECTOR_SET_H__
+#define __CARET_SORTED_VECTOR_SET_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretAssert.h"
+
+#include <algorithm>
+#include "stdint.h"
+#include <utility>
+#include <vector>
+
+namespace caret
+{
+    
+    ///set stored as a sorted vector, much smaller than std::set for large sets of small elements
+    ///inserting in ascending order is fast, inserting out of order moves the later elements, so use the bulk constructor or assign() for unordered input
+    template <typename T>
+    class CaretSortedVectorSet
+    {
+        std::vector<T> m_elements;//sorted, no repeats
+    public:
+        typedef typename std::vector<T>::const_iterator const_iterator;
+        typedef const_iterator iterator;//like std::set, elements can't be modified in place
+        typedef T value_type;
+        
+        CaretSortedVectorSet() { }
+        
+        ///bulk construction, repeated elements are removed
+        template <typename I>
+        CaretSortedVectorSet(I first, I last) : m_elements(first, last) { sortAndRemoveRepeats(); }
+        
+        ///takes the elements in any order, returns the number of repeated elements that were removed
+        int64_t assign(std::vector<T> elements)
+        {
+            m_elements.swap(elements);
+            return sortAndRemoveRepeats();
+        }
+        
+        const_iterator begin() const { return m_elements.begin(); }
+        const_iterator end() const { return m_elements.end(); }
+        std::size_t size() const { return m_elements.size(); }
+        bool empty() const { return m_elements.empty(); }
+        void clear() { m_elements.clear(); }
+        void reserve(const std::size_t& capacity) { m_elements.reserve(capacity); }
+        const T& operator[](const int64_t& index) const
+        {
+            CaretAssertVectorIndex(m_elements, index);
+            return m_elements[index];
+        }
+        ///the sorted elements, for bulk access
+        const std::vector<T>& getSortedElements() const { return m_elements; }
+        
+        const_iterator find(const T& value) const
+        {
+            const_iterator iter = std::lower_bound(m_elements.begin(), m_elements.end(), value);
+            if (iter != m_elements.end() && !(value < *iter)) return iter;
+            return m_elements.end();
+        }
+        
+        std::size_t count(const T& value) const { return (find(value) != end()) ? 1 : 0; }
+        
+        std::pair<const_iterator, bool> insert(const T& value)
+        {
+            if (m_elements.empty() || m_elements.back() < value)
+            {//common case of ascending insertion, append
+                m_elements.push_back(value);
+                return std::make_pair(m_elements.end() - 1, true);
+            }
+            typename std::vector<T>::iterator iter = std::lower_bound(m_elements.begin(), m_elements.end(), value);
+            if (!(value < *iter)) return std::make_pair(const_iterator(iter), false);//already present
+            iter = m_elements.insert(iter, value);
+            return std::make_pair(const_iterator(iter), true);
+        }
+        
+        std::size_t erase(const T& value)
+        {
+            typename std::vector<T>::iterator iter = std::lower_bound(m_elements.begin(), m_elements.end(), value);
+            if (iter == m_elements.end() || value < *iter) return 0;
+            m_elements.erase(iter);
+            return 1;
+        }
+        
+        bool operator==(const CaretSortedVectorSet<T>& rhs) const { return m_elements == rhs.m_elements; }
+        bool operator!=(const CaretSortedVectorSet<T>& rhs) const { return !(*this == rhs); }
+    private:
+        int64_t sortAndRemoveRepeats()
+        {
+            std::size_t before = m_elements.size();
+            bool sorted = true;
+            for (std::size_t i = 1; i < before; ++i)
+            {
+                if (!(m_elements[i - 1] < m_elements[i]))
+                {
+                    sorted = false;
+                    break;
+                }
+            }
+            if (sorted) return 0;//already sorted input, such as indices read from a file written by us
+            std::sort(m_elements.begin(), m_elements.end());
+            m_elements.erase(std::unique(m_elements.begin(), m_elements.end()), m_elements.end());
+            return (int64_t)(before - m_elements.size());
+        }
+    };
+    
+}
+
+#endif //__CARET_SORTED_VECTOR_SET_H__
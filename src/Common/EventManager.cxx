@@ -21,6 +21,7 @@
 #include <QThread>
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <typeinfo>
 
@@ -65,6 +66,13 @@ using namespace caret;
  * event will create the new window.  Other receivers may
  * want to know AFTER the window has been created in which
  * case these receivers will use addProcessedEventListener().
+ *
+ * Events are sent to an immutable snapshot of the listeners that
+ * is replaced when a listener is added or removed, so sending an
+ * event does not copy the listeners or take a lock.  The number of
+ * times each event type is sent and the time spent sending it are
+ * recorded in atomic counters and available from
+ * getEventStatisticsReport().
  */
 
 /**
@@ -73,7 +81,9 @@ using namespace caret;
 EventManager::EventManager()
 {
     m_eventIssuedCounter = 0;
-    m_eventBlockingCounter.resize(EventTypeEnum::EVENT_COUNT, 0);
+    for (int32_t i = 0; i < EventTypeEnum::EVENT_COUNT; i++) {
+        m_eventBlockingCounter[i] = 0;
+    }
 }
 
 /**
@@ -167,6 +177,7 @@ void
 EventManager::addEventListener(EventListenerInterface* eventListener,
                                const EventTypeEnum::Enum listenForEventType)
 {
+    CaretMutexLocker locker(&m_listenersMutex);
 #ifdef CONTAINER_VECTOR
     m_eventListeners[listenForEventType].push_back(eventListener);
 #elif CONTAINER_HASH_SET
@@ -176,6 +187,7 @@ EventManager::addEventListener(EventListenerInterface* eventListener,
 #else
     INTENTIONAL_COMPILER_ERROR_MISSING_CONTAINER_TYPE
 #endif
+    updateListenerSnapshots(listenForEventType);
 }
 
 /**
@@ -191,6 +203,7 @@ void
 EventManager::addProcessedEventListener(EventListenerInterface* eventListener,
                                const EventTypeEnum::Enum listenForEventType)
 {
+    CaretMutexLocker locker(&m_listenersMutex);
 #ifdef CONTAINER_VECTOR
     m_eventProcessedListeners[listenForEventType].push_back(eventListener);
 #elif CONTAINER_HASH_SET
@@ -200,6 +213,7 @@ EventManager::addProcessedEventListener(EventListenerInterface* eventListener,
 #else
     INTENTIONAL_COMPILER_ERROR_MISSING_CONTAINER_TYPE
 #endif
+    updateListenerSnapshots(listenForEventType);
 }
 
 /**
@@ -214,6 +228,8 @@ void
 EventManager::removeEventFromListener(EventListenerInterface* eventListener,
                                   const EventTypeEnum::Enum listenForEventType)
 {
+    CaretMutexLocker locker(&m_listenersMutex);
+    bool removedFlag(false);
 #ifdef CONTAINER_VECTOR
     /*
      * Remove from NORMAL listeners
@@ -224,6 +240,7 @@ EventManager::removeEventFromListener(EventListenerInterface* eventListener,
                                                             eventListener);
     if (eventIter != listeners.end()) {
         listeners.erase(eventIter);
+        removedFlag = true;
     }
 
     /*
@@ -236,16 +253,63 @@ EventManager::removeEventFromListener(EventListenerInterface* eventListener,
                                                                      eventListener);
     if (processedEventIter != processedListeners.end()) {
         processedListeners.erase(processedEventIter);
+        removedFlag = true;
     }
 #elif CONTAINER_HASH_SET
-    m_eventListeners[listenForEventType].erase(eventListener);
-    m_eventProcessedListeners[listenForEventType].erase(eventListener);
+    if (m_eventListeners[listenForEventType].erase(eventListener) > 0) {
+        removedFlag = true;
+    }
+    if (m_eventProcessedListeners[listenForEventType].erase(eventListener) > 0) {
+        removedFlag = true;
+    }
 #elif CONTAINER_SET
-    m_eventListeners[listenForEventType].erase(eventListener);
-    m_eventProcessedListeners[listenForEventType].erase(eventListener);
+    if (m_eventListeners[listenForEventType].erase(eventListener) > 0) {
+        removedFlag = true;
+    }
+    if (m_eventProcessedListeners[listenForEventType].erase(eventListener) > 0) {
+        removedFlag = true;
+    }
 #else
     INTENTIONAL_COMPILER_ERROR_MISSING_CONTAINER_TYPE
 #endif
+    
+    /*
+     * Listeners are removed from all event types when an object is
+     * destroyed so only replace snapshots that have changed
+     */
+    if (removedFlag) {
+        updateListenerSnapshots(listenForEventType);
+    }
+}
+
+/**
+ * Replace the snapshots of the listeners for an event type after
+ * its listeners have changed.  An event that is being sent continues
+ * to use the previous snapshot.
+ *
+ * @param eventType
+ *     Type of event whose listeners have changed.
+ */
+void
+EventManager::updateListenerSnapshots(const EventTypeEnum::Enum eventType)
+{
+    const EVENT_LISTENER_CONTAINER& listeners = m_eventListeners[eventType];
+    std::shared_ptr<const EVENT_LISTENER_SNAPSHOT> snapshot;
+    if ( ! listeners.empty()) {
+        snapshot.reset(new EVENT_LISTENER_SNAPSHOT(listeners.begin(),
+                                                   listeners.end()));
+    }
+    std::atomic_store(&m_eventListenersSnapshot[eventType],
+                      snapshot);
+    
+    const EVENT_LISTENER_CONTAINER& processedListeners = m_eventProcessedListeners[eventType];
+    std::shared_ptr<const EVENT_LISTENER_SNAPSHOT> processedSnapshot;
+    if ( ! processedListeners.empty()) {
+        processedSnapshot.reset(new EVENT_LISTENER_SNAPSHOT(processedListeners.begin(),
+                                                            processedListeners.end()));
+    }
+    std::atomic_store(&m_eventProcessedListenersSnapshot[eventType],
+                      processedSnapshot);
 }
 
 /**
@@ -271,22 +335,21 @@ void
 EventManager::sendEvent(Event* event)
 {   
     EventTypeEnum::Enum eventType = event->getEventType();
-    const AString eventNumberString = AString::number(m_eventIssuedCounter);
-    const AString eventMessagePrefix = ("Event "
-                                        + eventNumberString
-                                        + ": "
-                                        + event->toString() 
-                                        + " from thread: " 
-                                        + AString::number((uint64_t)QThread::currentThread())
-                                        + " ");
     
     const int32_t eventTypeIndex = static_cast<int32_t>(eventType);
-    CaretAssertVectorIndex(m_eventBlockingCounter, eventTypeIndex);
+    CaretAssertArrayIndex(m_eventBlockingCounter, EventTypeEnum::EVENT_COUNT, eventTypeIndex);
+    CaretAssertArrayIndex(m_eventStatistics, EventTypeEnum::EVENT_COUNT, eventTypeIndex);
+    EventStatistics& statistics = m_eventStatistics[eventTypeIndex];
     if (m_eventBlockingCounter[eventTypeIndex] > 0) {
-        AString msg = (eventMessagePrefix
-                       + " is blocked.  Blocking counter="
-                       + AString::number(m_eventBlockingCounter[eventTypeIndex]));
-        CaretLogFiner(msg);
+        statistics.m_blockedCount++;
+        CaretLogFiner("Event "
+                      + AString::number(m_eventIssuedCounter.load())
+                      + ": "
+                      + event->toString()
+                      + " from thread: "
+                      + AString::number((uint64_t)QThread::currentThread())
+                      + "  is blocked.  Blocking counter="
+                      + AString::number(m_eventBlockingCounter[eventTypeIndex].load()));
     }
     else {
         if (eventType == EventTypeEnum::EVENT_ALERT_USER) {
@@ -303,26 +366,25 @@ EventManager::sendEvent(Event* event)
             }
         }
         
+        const auto startTime(std::chrono::steady_clock::now());
+        
         /*
-         * Get listeners for event.
+         * Get snapshot of listeners for event.  Holding the snapshot keeps
+         * it valid if a listener adds or removes listeners.
          */
-        EVENT_LISTENER_CONTAINER listeners = m_eventListeners[eventType];
-        
-        const AString eventNumberString = AString::number(m_eventIssuedCounter);
+        const std::shared_ptr<const EVENT_LISTENER_SNAPSHOT> listeners(std::atomic_load(&m_eventListenersSnapshot[eventType]));
         
         /*
          * Send event to each of the listeners.
          */
-        for (EVENT_LISTENER_CONTAINER_ITERATOR iter = listeners.begin();
-             iter != listeners.end();
-             iter++) {
-            EventListenerInterface* listener = *iter;
-
-            listener->receiveEvent(event);
-            
-            if (event->isError()) {
-                CaretLogWarning("Event " + eventNumberString + " had error: " + event->toString() + ": " + event->getErrorMessage());
-                break;
+        if (listeners) {
+            for (EventListenerInterface* listener : *listeners) {
+                listener->receiveEvent(event);
+                
+                if (event->isError()) {
+                    CaretLogWarning("Event " + AString::number(m_eventIssuedCounter.load()) + " had error: " + event->toString() + ": " + event->getErrorMessage());
+                    break;
+                }
             }
         }
         
@@ -333,22 +395,30 @@ EventManager::sendEvent(Event* event)
             /*
              * Send event to each of the PROCESSED listeners.
              */
-            EVENT_LISTENER_CONTAINER processedListeners = m_eventProcessedListeners[eventType];
-            for (EVENT_LISTENER_CONTAINER_ITERATOR iter = processedListeners.begin();
-                 iter != processedListeners.end();
-                 iter++) {
-                EventListenerInterface* listener = *iter;
-                listener->receiveEvent(event);
-                
-                if (event->isError()) {
-                    CaretLogWarning("Event " + eventNumberString + " had error: " + event->toString());
-                    break;
+            const std::shared_ptr<const EVENT_LISTENER_SNAPSHOT> processedListeners(std::atomic_load(&m_eventProcessedListenersSnapshot[eventType]));
+            if (processedListeners) {
+                for (EventListenerInterface* listener : *processedListeners) {
+                    listener->receiveEvent(event);
+                    
+                    if (event->isError()) {
+                        CaretLogWarning("Event " + AString::number(m_eventIssuedCounter.load()) + " had error: " + event->toString());
+                        break;
+                    }
                 }
             }
         }
-        else {
-        }
 
+        const int64_t nanoseconds(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()
+                                                                                        - startTime).count());
+        statistics.m_sentCount++;
+        statistics.m_totalNanoseconds += nanoseconds;
+        int64_t maximumNanoseconds(statistics.m_maximumNanoseconds.load());
+        while ((nanoseconds > maximumNanoseconds)
+               && ( ! statistics.m_maximumNanoseconds.compare_exchange_weak(maximumNanoseconds,
+                                                                             nanoseconds))) {
+            /* compare_exchange_weak() updated maximumNanoseconds, try again */
+        }
+        
         m_eventIssuedCounter++;
     }
 }
@@ -525,7 +595,7 @@ EventManager::blockEvent(const EventTypeEnum::Enum eventType,
                          const bool blockStatus)
 {
     const int32_t eventTypeIndex = static_cast<int32_t>(eventType);
-    CaretAssertVectorIndex(m_eventBlockingCounter, eventTypeIndex);
+    CaretAssertArrayIndex(m_eventBlockingCounter, EventTypeEnum::EVENT_COUNT, eventTypeIndex);
     
     const AString eventName = EventTypeEnum::toName(eventType);
     
@@ -534,7 +604,7 @@ EventManager::blockEvent(const EventTypeEnum::Enum eventType,
         CaretLogFiner("Blocking event "
                       + eventName
                       + " blocking counter is now "
-                      + AString::number(m_eventBlockingCounter[eventTypeIndex]));
+                      + AString::number(m_eventBlockingCounter[eventTypeIndex].load()));
     }
     else {
         if (m_eventBlockingCounter[eventTypeIndex] > 0) {
@@ -542,7 +612,7 @@ EventManager::blockEvent(const EventTypeEnum::Enum eventType,
             CaretLogFiner("Unblocking event "
                           + eventName
                           + " blocking counter is now "
-                          + AString::number(m_eventBlockingCounter[eventTypeIndex]));
+                          + AString::number(m_eventBlockingCounter[eventTypeIndex].load()));
         }
         else {
             const AString message("Trying to unblock event "
@@ -560,7 +630,67 @@ EventManager::blockEvent(const EventTypeEnum::Enum eventType,
 int64_t
 EventManager::getEventIssuedCounter() const
 {
-    return m_eventIssuedCounter;
+    return m_eventIssuedCounter.load();
+}
+
+/**
+ * @return A report listing, for each event type that has been sent or
+ * blocked since the statistics were reset, the number of times sent
+ * and blocked, the number of listeners, and the total, average, and
+ * maximum time in milliseconds.  Times include any events sent by the
+ * listeners.  Event types are sorted by total time.
+ */
+AString
+EventManager::getEventStatisticsReport() const
+{
+    CaretMutexLocker locker(&m_listenersMutex);
+    
+    std::vector<std::pair<int64_t, int32_t>> totalTimeAndEventTypeIndices;
+    for (int32_t i = 0; i < EventTypeEnum::EVENT_COUNT; i++) {
+        const EventStatistics& statistics = m_eventStatistics[i];
+        if ((statistics.m_sentCount > 0)
+            || (statistics.m_blockedCount > 0)) {
+            totalTimeAndEventTypeIndices.push_back(std::make_pair(statistics.m_totalNanoseconds,
+                                                                  i));
+        }
+    }
+    std::sort(totalTimeAndEventTypeIndices.rbegin(),
+              totalTimeAndEventTypeIndices.rend());
+    
+    const double nanosecondsToMilliseconds(1.0e-6);
+    AString report("Event, Sent, Blocked, Listeners, Total (ms), Average (ms), Maximum (ms)");
+    for (const auto& timeAndIndex : totalTimeAndEventTypeIndices) {
+        const int32_t i(timeAndIndex.second);
+        const EventStatistics& statistics = m_eventStatistics[i];
+        const EventTypeEnum::Enum eventType = static_cast<EventTypeEnum::Enum>(i);
+        const double averageNanoseconds((statistics.m_sentCount > 0)
+                                        ? (static_cast<double>(statistics.m_totalNanoseconds) / statistics.m_sentCount)
+                                        : 0.0);
+        report.appendWithNewLine(EventTypeEnum::toName(eventType)
+                                 + ", " + AString::number(statistics.m_sentCount.load())
+                                 + ", " + AString::number(statistics.m_blockedCount.load())
+                                 + ", " + AString::number(static_cast<int64_t>(m_eventListeners[i].size()
+                                                                               + m_eventProcessedListeners[i].size()))
+                                 + ", " + AString::number(statistics.m_totalNanoseconds.load() * nanosecondsToMilliseconds, 'f', 3)
+                                 + ", " + AString::number(averageNanoseconds * nanosecondsToMilliseconds, 'f', 6)
+                                 + ", " + AString::number(statistics.m_maximumNanoseconds.load() * nanosecondsToMilliseconds, 'f', 3));
+    }
+    
+    return report;
+}
+
+/**
+ * Reset the counts and times of all event types.
+ */
+void
+EventManager::resetEventStatistics()
+{
+    for (EventStatistics& statistics : m_eventStatistics) {
+        statistics.m_sentCount = 0;
+        statistics.m_blockedCount = 0;
+        statistics.m_totalNanoseconds = 0;
+        statistics.m_maximumNanoseconds = 0;
+    }
 }
 
 /**
@@ -574,6 +704,7 @@ EventManager::verifyAllListenersRemoved(EventListenerInterface* eventListener)
 {
     AString eventNames;
     
+    CaretMutexLocker locker(&m_listenersMutex);
     for (int32_t i = 0; i < EventTypeEnum::EVENT_COUNT; i++) {
         const EventTypeEnum::Enum eventType = static_cast<EventTypeEnum::Enum>(i);
         if ((m_eventListeners[eventType].find(eventListener) != m_eventListeners[eventType].end())
@@ -23,6 +23,11 @@
 
 #include <stdint.h>
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "CaretMutex.h"
 #include "CaretObject.h"
 
 #include "EventTypeEnum.h"
@@ -94,13 +99,47 @@ namespace caret {
         
         int64_t getEventIssuedCounter() const;
         
+        AString getEventStatisticsReport() const;
+        
+        void resetEventStatistics();
+        
     private:
+        /**
+         * Number of times and time spent sending an event type.  Events
+         * may be sent from any thread so the values are atomic.
+         */
+        class EventStatistics {
+        public:
+            /** Number of times the event was sent to listeners */
+            std::atomic<int64_t> m_sentCount { 0 };
+            
+            /** Number of times the event was blocked */
+            std::atomic<int64_t> m_blockedCount { 0 };
+            
+            /** Total time sending the event including any events sent by the listeners */
+            std::atomic<int64_t> m_totalNanoseconds { 0 };
+            
+            /** Longest time sending the event */
+            std::atomic<int64_t> m_maximumNanoseconds { 0 };
+        };
+        
+        /**
+         * Immutable copy of the listeners for an event type that is used
+         * for sending events.  It is replaced, not modified, when a listener
+         * is added or removed so that sending an event does not need to copy
+         * the listeners in case a listener is added or removed by a listener.
+         */
+        typedef std::vector<EventListenerInterface*> EVENT_LISTENER_SNAPSHOT;
+        
+
         EventManager();
         
         virtual ~EventManager();
         
         void verifyAllListenersRemoved(EventListenerInterface* eventListener);
         
+        void updateListenerSnapshots(const EventTypeEnum::Enum eventType);
+        
         /**
          * Define the container
          */
@@ -131,11 +170,33 @@ namespace caret {
          */
         EVENT_LISTENER_CONTAINER m_eventProcessedListeners[EventTypeEnum::EVENT_COUNT];
         
+        /**
+         * Snapshots of m_eventListeners used when sending events, NULL if no listeners.
+         * Always accessed with std::atomic_load() and std::atomic_store() so that
+         * sending an event does not lock m_listenersMutex.
+         */
+        std::shared_ptr<const EVENT_LISTENER_SNAPSHOT> m_eventListenersSnapshot[EventTypeEnum::EVENT_COUNT];
+        
+        /**
+         * Snapshots of m_eventProcessedListeners used when sending events, NULL if no listeners
+         */
+        std::shared_ptr<const EVENT_LISTENER_SNAPSHOT> m_eventProcessedListenersSnapshot[EventTypeEnum::EVENT_COUNT];
+        
+        /**
+         * Protects the listeners so that objects that add listeners, such
+         * as chart delegates of files, may be created on other threads.
+         * Only adding, removing, and reporting listeners lock it.
+         */
+        mutable CaretMutex m_listenersMutex;
+        
+        /** Statistics for each event type */
+        EventStatistics m_eventStatistics[EventTypeEnum::EVENT_COUNT];
+        
         /** Counter that is incremented each time an event is issued */
-        int64_t m_eventIssuedCounter;
+        std::atomic<int64_t> m_eventIssuedCounter;
         
         /** A counter for blocking events of each type */
-        std::vector<int64_t> m_eventBlockingCounter;
+        std::atomic<int64_t> m_eventBlockingCounter[EventTypeEnum::EVENT_COUNT];
         
         static EventManager* s_singletonEventManager;
         
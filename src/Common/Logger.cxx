@@ -153,6 +153,7 @@ Logger::log(const LogLevelEnum::Enum logLevel,
     /*
      * Send to all of the handlers.
      */
+    CaretMutexLocker locker(&this->handlersMutex);
     for (std::vector<LogHandler*>::iterator iter = this->logHandlers.begin();
          iter != this->logHandlers.end();
          iter++) {
@@ -334,6 +335,7 @@ Logger::setLevel(const LogLevelEnum::Enum level)
 void 
 Logger::addLogHandler(LogHandler* logHandler)
 {
+    CaretMutexLocker locker(&this->handlersMutex);
     this->logHandlers.push_back(logHandler);
 }
 
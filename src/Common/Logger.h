@@ -24,6 +24,7 @@
 
 #include "CaretObject.h"
 #include "CaretException.h"
+#include "CaretMutex.h"
 #include "LogLevelEnum.h"
 
 namespace caret {
@@ -123,6 +124,9 @@ namespace caret {
         
         std::vector<LogHandler*> logHandlers;
         
+        /** Serializes publishing so that records logged from OpenMP threads do not interleave */
+        CaretMutex handlersMutex;
+        
     public:
         virtual AString toString() const;
         
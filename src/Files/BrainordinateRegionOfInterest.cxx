@@ -678,15 +678,14 @@ BrainordinateRegionOfInterest::setWithCiftiParcelBrainordinates(const CiftiMappa
     
     const CiftiParcelsMap::Parcel& parcel = allParcels[parcelIndex];
     
-    for (std::map<StructureEnum::Enum, std::set<int64_t> >::const_iterator iter = parcel.m_surfaceNodes.begin();
+    for (std::map<StructureEnum::Enum, CaretSortedVectorSet<int64_t> >::const_iterator iter = parcel.m_surfaceNodes.begin();
          iter != parcel.m_surfaceNodes.end();
          iter++) {
         const StructureEnum::Enum structure = iter->first;
-        const std::set<int64_t>& nodeSet = iter->second;
+        const CaretSortedVectorSet<int64_t>& nodeSet = iter->second;
         
         int64_t surfaceNumberOfNodes = ciftiParcelsMap->getSurfaceNumberOfNodes(structure);
-        std::vector<int64_t> nodeVector(nodeSet.begin(),
-                                        nodeSet.end());
+        const std::vector<int64_t>& nodeVector = nodeSet.getSortedElements();
         
         setSurfaceNodes(structure,
                         surfaceNumberOfNodes,
@@ -696,8 +695,8 @@ BrainordinateRegionOfInterest::setWithCiftiParcelBrainordinates(const CiftiMappa
     if (ciftiParcelsMap->hasVolumeData()) {
         const VolumeSpace& volumeSpace = ciftiParcelsMap->getVolumeSpace();
         
-        const std::set<VoxelIJK>& voxelSetIJK = parcel.m_voxelIndices;
-        for (std::set<VoxelIJK>::iterator voxelIter = voxelSetIJK.begin();
+        const CaretSortedVectorSet<VoxelIJK>& voxelSetIJK = parcel.m_voxelIndices;
+        for (CaretSortedVectorSet<VoxelIJK>::const_iterator voxelIter = voxelSetIJK.begin();
              voxelIter != voxelSetIJK.end();
              voxelIter++) {
             const VoxelIJK& voxelIJK = *voxelIter;
@@ -0,0 +1,76 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CacheFileHelper.h"
+
+#include "SurfaceFile.h"
+#include "VolumeSpace.h"
+
+#include <algorithm>
+
+using namespace caret;
+using namespace std;
+
+void CacheFileHelper::hashBytes(QCryptographicHash& hasher, const void* data, const int64_t& bytes)
+{
+    const int64_t CHUNK = 1 << 30;//addData takes an int length
+    for (int64_t start = 0; start < bytes; start += CHUNK)
+    {
+        hasher.addData((const char*)data + start, (int)min(CHUNK, bytes - start));
+    }
+}
+
+void CacheFileHelper::hashSurface(QCryptographicHash& hasher, const SurfaceFile* mySurface)
+{
+    const int32_t numNodes = mySurface->getNumberOfNodes(), numTris = mySurface->getNumberOfTriangles();
+    hashBytes(hasher, &numNodes, sizeof(numNodes));
+    hashBytes(hasher, &numTris, sizeof(numTris));
+    hashBytes(hasher, mySurface->getCoordinateData(), numNodes * 3 * sizeof(float));
+    for (int32_t i = 0; i < numTris; ++i)
+    {
+        hashBytes(hasher, mySurface->getTriangle(i), 3 * sizeof(int32_t));
+    }
+}
+
+void CacheFileHelper::hashVolumeSpace(QCryptographicHash& hasher, const VolumeSpace& volSpace)
+{
+    hashBytes(hasher, volSpace.getDims(), 3 * sizeof(int64_t));
+    const vector<vector<float> >& sform = volSpace.getSform();
+    for (int i = 0; i < 3; ++i)
+    {
+        hashBytes(hasher, sform[i].data(), 4 * sizeof(float));
+    }
+}
+
+int64_t CacheFileHelper::getBytesRemaining(istream& inStream)
+{
+    const streampos current = inStream.tellg();
+    if (current < 0) return -1;
+    inStream.seekg(0, ios::end);
+    const streampos end = inStream.tellg();
+    inStream.seekg(current);
+    if (end < 0 || !inStream)
+    {
+        inStream.clear();
+        inStream.seekg(current);
+        return -1;
+    }
+    return (int64_t)(end - current);
+}
@@ -0,0 +1,51 @@
+#ifndef __CACHE_FILE_HELPER_H__
+#define __CACHE_FILE_HELPER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <QCryptographicHash>
+
+#include <istream>
+#include <stdint.h>
+
+namespace caret {
+
+    class SurfaceFile;
+    class VolumeSpace;
+
+    ///shared pieces of the on-disk caches of precomputed weights (resample plans, voxel weight matrices)
+    class CacheFileHelper
+    {
+        CacheFileHelper();
+    public:
+        ///add a buffer of any size to a cache key
+        static void hashBytes(QCryptographicHash& hasher, const void* data, const int64_t& bytes);
+        ///add surface coordinates and topology to a cache key
+        static void hashSurface(QCryptographicHash& hasher, const SurfaceFile* mySurface);
+        ///add volume dimensions and sform to a cache key
+        static void hashVolumeSpace(QCryptographicHash& hasher, const VolumeSpace& volSpace);
+        ///bytes left in a seekable stream, or -1 if the stream can't tell, for checking sizes read from a cache file before allocating
+        static int64_t getBytesRemaining(std::istream& inStream);
+    };
+
+}
+
+#endif //__CACHE_FILE_HELPER_H__
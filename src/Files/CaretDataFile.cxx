@@ -46,6 +46,7 @@ CaretDataFile::CaretDataFile(const DataFileTypeEnum::Enum dataFileType)
 SceneableInterface()
 {
     m_dataFileType = dataFileType;
+    m_instanceIdentifier = s_instanceIdentifierCounter++;
     
     AString name = ("untitled_"
                     + AString::number(s_defaultFileNameCounter)
@@ -64,6 +65,18 @@ CaretDataFile::~CaretDataFile()
     
 }
 
+/**
+ * @return Identifier that is unique to this instance for the life of the
+ * program.  Unlike the address of the file, it is not reused after the file
+ * is deleted, so it may be used to key cached data.  A copy of a file receives
+ * its own identifier.
+ */
+int64_t
+CaretDataFile::getInstanceIdentifier() const
+{
+    return m_instanceIdentifier;
+}
+
 /**
  * @return The type of this data file.
  */
@@ -108,6 +121,7 @@ CaretDataFile::CaretDataFile(const CaretDataFile& cdf)
 : DataFile(cdf),
 SceneableInterface(cdf)
 {
+    m_instanceIdentifier = s_instanceIdentifierCounter++;
     copyDataCaretDataFile(cdf);
 }
 
@@ -21,6 +21,7 @@
  */
 /*LICENSE_END*/
 
+#include <atomic>
 
 #include "DataFile.h"
 #include "DataFileTypeEnum.h"
@@ -57,6 +58,8 @@ namespace caret {
         
         DataFileTypeEnum::Enum getDataFileType() const;
         
+        int64_t getInstanceIdentifier() const;
+        
         /**
          * @return Get access to the file's metadata.
          */
@@ -117,15 +120,22 @@ namespace caret {
         
         DataFileTypeEnum::Enum m_dataFileType;
         
+        /** Unique for each instance, unlike the address of a deleted file, it is never reused */
+        int64_t m_instanceIdentifier;
+        
         /** A counter that is used when creating default file names */
         static int64_t s_defaultFileNameCounter;
         
+        /** Next instance identifier, atomic since files may be created while reading on other threads */
+        static std::atomic<int64_t> s_instanceIdentifierCounter;
+        
         static AString s_fileReadingUsername;
         static AString s_fileReadingPassword;
     };
     
 #ifdef __CARET_DATA_FILE_DECLARE__
     int64_t CaretDataFile::s_defaultFileNameCounter = 1;
+    std::atomic<int64_t> CaretDataFile::s_instanceIdentifierCounter(1);
     AString CaretDataFile::s_fileReadingUsername = "";
     AString CaretDataFile::s_fileReadingPassword = "";
 #endif // __CARET_DATA_FILE_DECLARE__
@@ -27,19 +27,30 @@
 #include "FileInformation.h"
 
 #include <QByteArray>
+#include <QFile>
+
+#include <cstring>
 
 using namespace caret;
 using namespace std;
 
 const char magic[] = "\0\0\0\0cst\0";
 
+CaretSparseFile::CaretSparseFile()
+{
+    m_mappedValues = NULL;
+}
+
 CaretSparseFile::CaretSparseFile(const AString& fileName)
 {
+    m_mappedValues = NULL;
     readFile(fileName);
 }
 
 void CaretSparseFile::readFile(const AString& filename)
 {
+    m_mappedValues = NULL;
+    m_mapFile.grabNew(NULL);//deleting the QFile also unmaps
     m_file.close();
     if (filename.endsWith(".gz"))
     {
@@ -94,28 +105,62 @@ void CaretSparseFile::readFile(const AString& filename)
     {
         throw DataFileException("cifti XML doesn't match dimensions of sparse file");
     }
+    int64_t valuesBytes = m_indexArray[m_dims[1]] * 2 * sizeof(int64_t);
+    if (valuesBytes > 0)
+    {//interactive use reads scattered rows, so let the OS page them in instead of seeking and copying
+        m_mapFile.grabNew(new QFile(filename));
+        if (m_mapFile->open(QIODevice::ReadOnly))
+        {
+            m_mappedValues = m_mapFile->map(m_valuesOffset, valuesBytes);
+        }
+        if (m_mappedValues == NULL)
+        {
+            CaretLogFine("unable to memory map sparse file '" + filename + "', using regular reads");
+            m_mapFile.grabNew(NULL);
+        }
+    }
 }
 
-CaretSparseFile::~CaretSparseFile()
-{
-}
-
-void CaretSparseFile::getRow(const int64_t& index, int64_t* rowOut)
+const int64_t* CaretSparseFile::getRowPairs(const int64_t& index, int64_t& numNonzeroOut)
 {
     CaretAssert(index >= 0 && index < m_dims[1]);
     int64_t start = m_indexArray[index], end = m_indexArray[index + 1];
     int64_t numToRead = (end - start) * 2;
-    m_scratchArray.resize(numToRead);
-    m_file.seek(m_valuesOffset + start * sizeof(int64_t) * 2);
-    m_file.read(m_scratchArray.data(), numToRead * sizeof(int64_t));
+    numNonzeroOut = end - start;
+    if (m_mappedValues != NULL)
+    {
+        const unsigned char* rowStart = m_mappedValues + start * sizeof(int64_t) * 2;
+        if (!ByteOrderEnum::isSystemBigEndian())
+        {
+            return (const int64_t*)rowStart;//values offset is a multiple of 8, so this is aligned
+        }
+        m_scratchArray.resize(numToRead);
+        memcpy(m_scratchArray.data(), rowStart, numToRead * sizeof(int64_t));
+    } else {
+        m_scratchArray.resize(numToRead);
+        m_file.seek(m_valuesOffset + start * sizeof(int64_t) * 2);
+        m_file.read(m_scratchArray.data(), numToRead * sizeof(int64_t));
+    }
     if (ByteOrderEnum::isSystemBigEndian())
     {
         ByteSwapping::swapBytes(m_scratchArray.data(), numToRead);
     }
+    return m_scratchArray.data();
+}
+
+CaretSparseFile::~CaretSparseFile()
+{
+}
+
+void CaretSparseFile::getRow(const int64_t& index, int64_t* rowOut)
+{
+    int64_t numNonzero;
+    const int64_t* pairs = getRowPairs(index, numNonzero);
+    int64_t numToRead = numNonzero * 2;
     int64_t curIndex = 0;
     for (int64_t i = 0; i < numToRead; i += 2)
     {
-        int64_t index = m_scratchArray[i];
+        int64_t index = pairs[i];
         if (index < curIndex || index >= m_dims[0]) throw DataFileException("impossible index value found in file");
         while (curIndex < index)
         {
@@ -123,7 +168,7 @@ void CaretSparseFile::getRow(const int64_t& index, int64_t* rowOut)
             ++curIndex;
         }
         ++curIndex;
-        rowOut[index] = m_scratchArray[i + 1];
+        rowOut[index] = pairs[i + 1];
     }
     while (curIndex < m_dims[0])
     {
@@ -134,23 +179,15 @@ void CaretSparseFile::getRow(const int64_t& index, int64_t* rowOut)
 
 void CaretSparseFile::getRowSparse(const int64_t& index, vector<int64_t>& indicesOut, vector<int64_t>& valuesOut)
 {
-    CaretAssert(index >= 0 && index < m_dims[1]);
-    int64_t start = m_indexArray[index], end = m_indexArray[index + 1];
-    int64_t numToRead = (end - start) * 2, numNonzero = end - start;
-    m_scratchArray.resize(numToRead);
-    m_file.seek(m_valuesOffset + start * sizeof(int64_t) * 2);
-    m_file.read(m_scratchArray.data(), numToRead * sizeof(int64_t));
-    if (ByteOrderEnum::isSystemBigEndian())
-    {
-        ByteSwapping::swapBytes(m_scratchArray.data(), numToRead);
-    }
+    int64_t numNonzero;
+    const int64_t* pairs = getRowPairs(index, numNonzero);
     indicesOut.resize(numNonzero);
     valuesOut.resize(numNonzero);
     int64_t lastIndex = -1;
     for (int64_t i = 0; i < numNonzero; ++i)
     {
-        indicesOut[i] = m_scratchArray[i * 2];
-        valuesOut[i] = m_scratchArray[i * 2 + 1];
+        indicesOut[i] = pairs[i * 2];
+        valuesOut[i] = pairs[i * 2 + 1];
         if (indicesOut[i] <= lastIndex || indicesOut[i] >= m_dims[0]) throw DataFileException("impossible index value found in file");
         lastIndex = indicesOut[i];
     }
@@ -199,6 +236,38 @@ void CaretSparseFile::decodeFibers(const uint64_t& coded, FiberFractions& decode
     if (decoded.fiberFractions[2] < 0.0f) decoded.fiberFractions[2] = 0.0f;
 }
 
+void CaretSparseFile::decodeFibersBlock(const uint64_t* coded, const int64_t& count, uint32_t* totalCountOut,
+                                        float* fraction0Out, float* fraction1Out, float* fraction2Out, float* distanceOut)
+{//no branches, float reductions, or per-element allocation, so gcc vectorizes this at -O3 (checked with -fopt-info-vec)
+    //with the baseline SSE2 on x86-64, this is not dispatched per cpu like kloewe/dot because it decodes one row
+    //of a memory mapped file at a time, so reading the row dominates over converting the values
+    const static uint32_t MASK = ((1<<10) - 1);
+    uint32_t allBits = 0, maxCodeSum = 0;
+    for (int64_t i = 0; i < count; ++i)
+    {
+        uint32_t temp = (uint32_t)coded[i];
+        uint32_t code1 = (temp>>10) & MASK, code0 = (temp>>20) & MASK;
+        totalCountOut[i] = (uint32_t)(coded[i]>>32);
+        distanceOut[i] = (float)(temp & MASK);
+        float fraction1 = code1 / 1000.0f;
+        float fraction0 = code0 / 1000.0f;
+        float fraction2 = 1.0f - fraction0 - fraction1;
+        allBits |= temp;
+        maxCodeSum = (code0 + code1 > maxCodeSum ? code0 + code1 : maxCodeSum);//integer max instead of a float min, which isn't vectorized without fast math
+        fraction0Out[i] = fraction0;
+        fraction1Out[i] = fraction1;
+        fraction2Out[i] = (fraction2 < 0.0f ? 0.0f : fraction2);
+    }
+    if (maxCodeSum > 1001 || (allBits & (3<<30)))
+    {//fraction 2 may be below -0.002, let the exact check decide
+        FiberFractions scratch;
+        for (int64_t i = 0; i < count; ++i)
+        {
+            decodeFibers(coded[i], scratch);//throws with the offending value
+        }
+    }
+}
+
 void FiberFractions::zero()
 {
     totalCount = 0;
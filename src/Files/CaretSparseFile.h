@@ -26,10 +26,13 @@
 
 #include "AString.h"
 #include "CaretBinaryFile.h"
+#include "CaretPointer.h"
 #include "CiftiXML.h"
 #include "DataFile.h"
 #include "DataFileException.h"
 
+class QFile;
+
 namespace caret {
     
     struct FiberFractions
@@ -44,15 +47,19 @@ namespace caret {
     {
         static void decodeFibers(const uint64_t& coded, FiberFractions& decoded);//takes a uint because right shift on signed is implementation dependent
         CaretBinaryFile m_file;
+        CaretPointer<QFile> m_mapFile;//owns the mapping of the values section, when the OS allows it
+        const unsigned char* m_mappedValues;
         int64_t m_dims[2], m_valuesOffset;
         std::vector<uint64_t> m_indexArray, m_scratchRow;
         std::vector<int64_t> m_scratchArray, m_scratchSparseRow;
         CaretSparseFile(const CaretSparseFile& rhs);
         CiftiXML m_xml;
+        ///returns interleaved index, value pairs, pointing into the mapping when possible, otherwise into m_scratchArray
+        const int64_t* getRowPairs(const int64_t& index, int64_t& numNonzeroOut);
     public:
         const int64_t* getDimensions() { return m_dims; }
 
-        CaretSparseFile() {};
+        CaretSparseFile();
         
         virtual void readFile(const AString& filename);
         
@@ -70,6 +77,13 @@ namespace caret {
         void getFibersRow(const int64_t& index, FiberFractions* rowOut);
         
         void getFibersRowSparse(const int64_t& index, std::vector<int64_t>& indicesOut, std::vector<FiberFractions>& valuesOut);
+        
+        ///decode fiber values into separate arrays, throws on the same values as getFibersRow
+        static void decodeFibersBlock(const uint64_t* coded, const int64_t& count, uint32_t* totalCountOut,
+                                      float* fraction0Out, float* fraction1Out, float* fraction2Out, float* distanceOut);
+        
+        ///whether rows are read from a memory mapping rather than seek and read
+        bool isMapped() const { return m_mappedValues != NULL; }
 
         virtual ~CaretSparseFile();
     };
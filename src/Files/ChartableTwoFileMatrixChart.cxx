@@ -488,6 +488,50 @@ ChartableTwoFileMatrixChart::getMatrixChartingGraphicsPrimitive(const ChartTwoMa
                                                             opacity);
 }
 
+/**
+ * @return True if the matrix is too large for one texture and is drawn
+ * with getMatrixChartingTiledGraphicsPrimitive().
+ */
+bool
+ChartableTwoFileMatrixChart::isMatrixChartingTiled() const
+{
+    const CiftiMappableDataFile* ciftiMapFile = getCiftiMappableDataFile();
+    CaretAssert(ciftiMapFile);
+    
+    return ciftiMapFile->isMatrixChartingTiled();
+}
+
+/**
+ * @return The graphics primitive containing the visible region of a tiled matrix.
+ *
+ * @param matrixViewMode
+ *     The matrix visualization mode (upper/lower).
+ * @param opacity
+ *     Opacity of the matrix
+ * @param visibleRegion
+ *     Visible region of the chart (min-x, max-x, min-y, max-y).
+ * @param viewportWidth
+ *     Width of the viewport in pixels.
+ * @param viewportHeight
+ *     Height of the viewport in pixels.
+ */
+GraphicsPrimitive*
+ChartableTwoFileMatrixChart::getMatrixChartingTiledGraphicsPrimitive(const ChartTwoMatrixTriangularViewingModeEnum::Enum matrixViewMode,
+                                                                     const float opacity,
+                                                                     const float visibleRegion[4],
+                                                                     const int32_t viewportWidth,
+                                                                     const int32_t viewportHeight) const
+{
+    const CiftiMappableDataFile* ciftiMapFile = getCiftiMappableDataFile();
+    CaretAssert(ciftiMapFile);
+    
+    return ciftiMapFile->getMatrixChartingTiledGraphicsPrimitive(matrixViewMode,
+                                                                 opacity,
+                                                                 visibleRegion,
+                                                                 viewportWidth,
+                                                                 viewportHeight);
+}
+
 /** 
  * @return Identifier for the matrix primitives alternative color used for the grid coloring 
  */
@@ -63,6 +63,14 @@ namespace caret {
                                                               const CiftiMappableDataFile::MatrixGridMode gridMode,
                                                               const float opacity) const;
         
+        bool isMatrixChartingTiled() const;
+        
+        GraphicsPrimitive* getMatrixChartingTiledGraphicsPrimitive(const ChartTwoMatrixTriangularViewingModeEnum::Enum matrixViewMode,
+                                                                   const float opacity,
+                                                                   const float visibleRegion[4],
+                                                                   const int32_t viewportWidth,
+                                                                   const int32_t viewportHeight) const;
+        
         int32_t getMatrixChartGraphicsPrimitiveGridColorIdentifier() const;
         
         bool isMatrixTriangularViewingModeSupported() const;
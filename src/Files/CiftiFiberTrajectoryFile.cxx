@@ -19,6 +19,8 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
+#include <iterator>
 #include <map>
 #include <set>
 
@@ -39,6 +41,7 @@
 #include "EventProgressUpdate.h"
 #include "FiberOrientationTrajectory.h"
 #include "FiberTrajectoryMapProperties.h"
+#include "FiberTrajectoryRowCache.h"
 #include "FileInformation.h"
 #include "GiftiMetaData.h"
 #include "PaletteColorMapping.h"
@@ -64,6 +67,8 @@ CiftiFiberTrajectoryFile::CiftiFiberTrajectoryFile()
     m_fiberTrajectoryMapProperties = new FiberTrajectoryMapProperties();
     m_metadata = new GiftiMetaData();
     m_sparseFile = NULL;
+    m_rowCache = NULL;
+    m_rowAverager = NULL;
     m_matchingFiberOrientationFile = NULL;
     m_matchingFiberOrientationFileName = "";
     m_dataLoadingEnabled = true;
@@ -119,6 +124,14 @@ CiftiFiberTrajectoryFile::clearPrivate()
         
     clearLoadedFiberOrientations();
     
+    if (m_rowCache != NULL) {
+        delete m_rowCache;
+        m_rowCache = NULL;
+    }
+    if (m_rowAverager != NULL) {
+        delete m_rowAverager;
+        m_rowAverager = NULL;
+    }
     if (m_sparseFile != NULL) {
         delete m_sparseFile;
         m_sparseFile = NULL;
@@ -789,6 +802,8 @@ CiftiFiberTrajectoryFile::readFile(const AString& filename)
     try {
         m_sparseFile = new CaretSparseFile();
         m_sparseFile->readFile(filename);
+        m_rowCache = new FiberTrajectoryRowCache(m_sparseFile);
+        m_rowAverager = new FiberTrajectoryRowAverager();
         setFileName(filename);
         
         m_fiberTrajectoryFileType = FIBER_TRAJECTORY_LOAD_BY_BRAINORDINATE;
@@ -1203,31 +1218,13 @@ CiftiFiberTrajectoryFile::loadDataForSurfaceNode(const StructureEnum::Enum struc
         return -1;
     }
     
-    std::vector<int64_t> fiberIndices;
-    std::vector<FiberFractions> fiberFractions;
+    /*
+     * Use the decoded arrays directly, so there is no
+     * FiberFractions allocated for each element of the row
+     */
+    const DecodedFiberRow& fiberRow = m_rowCache->getRow(rowIndex);
     
-    
-    bool rowTest = false;
-    if (rowTest) {
-        /*
-         * Test loading a full row instead of sparse.
-         */
-        const int numCols = trajXML.getDimensionLength(CiftiXML::ALONG_ROW);
-        fiberFractions.resize(numCols);
-        m_sparseFile->getFibersRow(rowIndex, &fiberFractions[0]);
-        
-        for (int64_t i = 0; i < numCols; i++) {
-            fiberIndices.push_back(i);
-        }
-    }
-    else {
-        m_sparseFile->getFibersRowSparse(rowIndex,
-                                         fiberIndices,
-                                         fiberFractions);
-    }
-    CaretAssert(fiberIndices.size() == fiberFractions.size());
-
-    const int64_t numFibers = static_cast<int64_t>(fiberIndices.size());
+    const int64_t numFibers = fiberRow.getNumberOfEntries();
     
     CaretLogFine("For node "
                    + AString::number(nodeIndex)
@@ -1239,12 +1236,19 @@ CiftiFiberTrajectoryFile::loadDataForSurfaceNode(const StructureEnum::Enum struc
         
         for (int64_t iFiber = 0; iFiber < numFibers; iFiber++) {
             const int64_t numFiberOrientations = m_matchingFiberOrientationFile->getNumberOfFiberOrientations();
-            const int64_t fiberIndex = fiberIndices[iFiber];
+            const int64_t fiberIndex = fiberRow.m_indices[iFiber];
             if (fiberIndex < numFiberOrientations) {
                 const FiberOrientation* fiberOrientation = m_matchingFiberOrientationFile->getFiberOrientations(fiberIndex);
                 FiberOrientationTrajectory* fot = new FiberOrientationTrajectory(fiberIndex,
                                                                                  fiberOrientation);
-                fot->setFiberFractions(fiberFractions[iFiber]);
+                const float fractions[3] = {
+                    fiberRow.m_fractions[0][iFiber],
+                    fiberRow.m_fractions[1][iFiber],
+                    fiberRow.m_fractions[2][iFiber]
+                };
+                fot->setFiberFractions(fiberRow.m_totalCount[iFiber],
+                                       fractions,
+                                       fiberRow.m_distance[iFiber]);
                 m_fiberOrientationTrajectories.push_back(fot);
             }
             else{
@@ -1388,58 +1392,85 @@ CiftiFiberTrajectoryFile::loadRowsForAveraging(const std::vector<int64_t>& rowIn
     const CiftiXML& trajXML = m_sparseFile->getCiftiXML();
     const int64_t numberOfColumns = trajXML.getDimensionLength(CiftiXML::ALONG_ROW);
     
-    std::vector<FiberFractions> fiberFractionsForRowVector(numberOfColumns);
-    FiberFractions* fiberFractionsForRow = &fiberFractionsForRowVector[0];
-    
     const int64_t numberOfRowsToLoad = static_cast<int64_t>(rowIndices.size());
     if (numberOfRowsToLoad <= 0) {
         return false;
     }
     
+    /*
+     * The averager keeps sums from the previous selection.  If the new
+     * selection only adds rows (such as when an ROI is enlarged), only the
+     * new rows need to be added, otherwise start over.
+     */
+    const std::multiset<int64_t> requestedRows(rowIndices.begin(),
+                                               rowIndices.end());
+    const std::multiset<int64_t>& averagedRows = m_rowAverager->getRows();
+    std::vector<int64_t> rowsToAdd;
+    if ((m_rowAverager->getNumberOfColumns() == numberOfColumns)
+        && std::includes(requestedRows.begin(), requestedRows.end(),
+                         averagedRows.begin(), averagedRows.end())) {
+        std::set_difference(requestedRows.begin(), requestedRows.end(),
+                            averagedRows.begin(), averagedRows.end(),
+                            std::back_inserter(rowsToAdd));
+    }
+    else {
+        m_rowAverager->reset(numberOfColumns);
+        rowsToAdd.assign(requestedRows.begin(),
+                         requestedRows.end());
+    }
+    const int64_t numberOfRowsToAdd = static_cast<int64_t>(rowsToAdd.size());
+    
     const int32_t progressUpdateInterval = 1;
     EventProgressUpdate progressEvent(0,
-                                      numberOfRowsToLoad,
+                                      numberOfRowsToAdd,
                                       0,
                                       ("Loading data for "
-                                       + QString::number(numberOfRowsToLoad)
+                                       + QString::number(numberOfRowsToAdd)
                                        + " brainordinates in file ")
                                       + getFileNameNoPath());
     
-    EventManager::get()->sendEvent(progressEvent.getPointer());
-    for (int64_t iCol = 0; iCol < numberOfColumns; iCol++) {
-        const FiberOrientation* fiberOrientation = m_matchingFiberOrientationFile->getFiberOrientations(iCol);
-        CaretAssert(fiberOrientation);
-        m_fiberOrientationTrajectories.push_back(new FiberOrientationTrajectory(iCol,
-                                                                                fiberOrientation));
+    if (numberOfRowsToAdd > 0) {
+        EventManager::get()->sendEvent(progressEvent.getPointer());
     }
     
-    bool userCancelled = false;
-    
-    for (int64_t iRow = 0; iRow < numberOfRowsToLoad; iRow++) {
-        const int64_t rowIndex = rowIndices[iRow];
+    for (int64_t iRow = 0; iRow < numberOfRowsToAdd; iRow++) {
+        const int64_t rowIndex = rowsToAdd[iRow];
         
         if ((iRow % progressUpdateInterval) == 0) {
             progressEvent.setProgress(iRow,
                                       "");
             EventManager::get()->sendEvent(progressEvent.getPointer());
             if (progressEvent.isCancelled()) {
-                userCancelled = true;
-                break;
+                /*
+                 * Sums still match the averager's rows, so a
+                 * repeated request continues from here
+                 */
+                return false;
             }
         }
         
-        m_sparseFile->getFibersRow(rowIndex,
-                                   fiberFractionsForRow);
-        
-        for (int64_t iCol = 0; iCol < numberOfColumns; iCol++) {
-            FiberOrientationTrajectory* fot = m_fiberOrientationTrajectories[iCol];
-            fot->addFiberFractionsForAveraging(fiberFractionsForRow[iCol]);
-        }
+        m_rowAverager->addRow(rowIndex,
+                              m_rowCache->getRow(rowIndex));
     }
     
-    if (userCancelled) {
-        clearLoadedFiberOrientations();
-        return false;
+    double totalCountSum = 0.0;
+    std::vector<double> fiberCountsSum;
+    double distanceSum = 0.0;
+    m_fiberOrientationTrajectories.reserve(numberOfColumns);
+    for (int64_t iCol = 0; iCol < numberOfColumns; iCol++) {
+        const FiberOrientation* fiberOrientation = m_matchingFiberOrientationFile->getFiberOrientations(iCol);
+        CaretAssert(fiberOrientation);
+        FiberOrientationTrajectory* fot = new FiberOrientationTrajectory(iCol,
+                                                                         fiberOrientation);
+        m_rowAverager->getSums(iCol,
+                               totalCountSum,
+                               fiberCountsSum,
+                               distanceSum);
+        fot->setSumsForAveraging(totalCountSum,
+                                 fiberCountsSum,
+                                 distanceSum,
+                                 numberOfRowsToLoad);
+        m_fiberOrientationTrajectories.push_back(fot);
     }
     
     finishFiberOrientationTrajectoriesAveraging();
@@ -1489,14 +1520,9 @@ CiftiFiberTrajectoryFile::loadMapDataForVoxelAtCoordinate(const float xyz[3])
         return -1;
     }
     
-    std::vector<int64_t> fiberIndices;
-    std::vector<FiberFractions> fiberFractions;
-    m_sparseFile->getFibersRowSparse(rowIndex,
-                                     fiberIndices,
-                                     fiberFractions);
-    CaretAssert(fiberIndices.size() == fiberFractions.size());
+    const DecodedFiberRow& fiberRow = m_rowCache->getRow(rowIndex);
     
-    const int64_t numFibers = static_cast<int64_t>(fiberIndices.size());
+    const int64_t numFibers = fiberRow.getNumberOfEntries();
     
     CaretLogFine("For voxel at coordinate "
                  + AString::fromNumbers(xyz, 3, ",")
@@ -1508,12 +1534,19 @@ CiftiFiberTrajectoryFile::loadMapDataForVoxelAtCoordinate(const float xyz[3])
         
         for (int64_t iFiber = 0; iFiber < numFibers; iFiber++) {
             const int64_t numFiberOrientations = m_matchingFiberOrientationFile->getNumberOfFiberOrientations();
-            const int64_t fiberIndex = fiberIndices[iFiber];
+            const int64_t fiberIndex = fiberRow.m_indices[iFiber];
             if (fiberIndex < numFiberOrientations) {
                 const FiberOrientation* fiberOrientation = m_matchingFiberOrientationFile->getFiberOrientations(fiberIndex);
                 FiberOrientationTrajectory* fot = new FiberOrientationTrajectory(fiberIndex,
                                                                                  fiberOrientation);
-                fot->setFiberFractions(fiberFractions[iFiber]);
+                const float fractions[3] = {
+                    fiberRow.m_fractions[0][iFiber],
+                    fiberRow.m_fractions[1][iFiber],
+                    fiberRow.m_fractions[2][iFiber]
+                };
+                fot->setFiberFractions(fiberRow.m_totalCount[iFiber],
+                                       fractions,
+                                       fiberRow.m_distance[iFiber]);
                 m_fiberOrientationTrajectories.push_back(fot);
             }
             else{
@@ -1616,26 +1649,28 @@ CiftiFiberTrajectoryFile::loadDataForRowIndex(const int64_t rowIndex)
     
     validateAssignedMatchingFiberOrientationFile();
     
-    std::vector<int64_t> fiberIndices;
-    std::vector<FiberFractions> fiberFractions;
-    m_sparseFile->getFibersRowSparse(rowIndex,
-                                     fiberIndices,
-                                     fiberFractions);
-    CaretAssert(fiberIndices.size() == fiberFractions.size());
+    const DecodedFiberRow& fiberRow = m_rowCache->getRow(rowIndex);
     
-    const int64_t numFibers = static_cast<int64_t>(fiberIndices.size());
+    const int64_t numFibers = fiberRow.getNumberOfEntries();
     
     if (numFibers > 0) {
         m_fiberOrientationTrajectories.reserve(numFibers);
         
         for (int64_t iFiber = 0; iFiber < numFibers; iFiber++) {
             const int64_t numFiberOrientations = m_matchingFiberOrientationFile->getNumberOfFiberOrientations();
-            const int64_t fiberIndex = fiberIndices[iFiber];
+            const int64_t fiberIndex = fiberRow.m_indices[iFiber];
             if (fiberIndex < numFiberOrientations) {
                 const FiberOrientation* fiberOrientation = m_matchingFiberOrientationFile->getFiberOrientations(fiberIndex);
                 FiberOrientationTrajectory* fot = new FiberOrientationTrajectory(fiberIndex,
                                                                                  fiberOrientation);
-                fot->setFiberFractions(fiberFractions[iFiber]);
+                const float fractions[3] = {
+                    fiberRow.m_fractions[0][iFiber],
+                    fiberRow.m_fractions[1][iFiber],
+                    fiberRow.m_fractions[2][iFiber]
+                };
+                fot->setFiberFractions(fiberRow.m_totalCount[iFiber],
+                                       fractions,
+                                       fiberRow.m_distance[iFiber]);
                 m_fiberOrientationTrajectories.push_back(fot);
             }
             else{
@@ -33,6 +33,8 @@ namespace caret {
     class CiftiFiberOrientationFile;
     class ConnectivityDataLoaded;
     class FiberOrientationTrajectory;
+    class FiberTrajectoryRowAverager;
+    class FiberTrajectoryRowCache;
     class FiberTrajectoryMapProperties;
     class GiftiMetaData;
     
@@ -221,6 +223,10 @@ namespace caret {
         
         CaretSparseFile* m_sparseFile;
         
+        FiberTrajectoryRowCache* m_rowCache;
+        
+        FiberTrajectoryRowAverager* m_rowAverager;
+        
         GiftiMetaData* m_metadata;
         
         CiftiFiberOrientationFile* m_matchingFiberOrientationFile;
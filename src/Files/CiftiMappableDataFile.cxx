@@ -18,6 +18,8 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <set>
 
@@ -37,6 +39,7 @@
 #include "CiftiFiberTrajectoryFile.h"
 #include "CiftiFile.h"
 #include "CiftiMappableConnectivityMatrixDataFile.h"
+#include "CiftiMatrixTilePyramid.h"
 #include "CaretMappableDataFileAndMapSelectionModel.h"
 #include "CiftiParcelLabelFile.h"
 #include "CiftiParcelReordering.h"
@@ -473,6 +476,10 @@ CiftiMappableDataFile::clearPrivate()
      * m_fileMapDataType
      */
     
+    m_matrixTilePyramid.reset();
+    m_matrixTilePyramidFailedFlag = false;
+    m_matrixTiledFastStatistics.grabNew(NULL);
+    m_matrixGraphicsTiledPrimitive.reset();
     m_ciftiFile.grabNew(NULL);
     
     resetDataLoadingMembers();
@@ -1498,6 +1505,7 @@ CiftiMappableDataFile::invalidateColoringInAllMaps()
     m_matrixGraphicsTrianglesPrimitive.reset();
     m_matrixGraphicsTexturePrimitive.reset();
     m_matrixGraphicsOutlinePrimitive.reset();
+    m_matrixGraphicsTiledPrimitive.reset();
     invalidateHistogramChartColoring();
     m_previousMatrixOpacity = -1.0;
     
@@ -1980,6 +1988,308 @@ CiftiMappableDataFile::getMatrixChartingGraphicsPrimitive(const ChartTwoMatrixTr
 }
 
 
+/**
+ * @return True if the matrix is too large for one texture and is drawn
+ * from tiles of a multi-resolution pyramid so that only the visible
+ * region, at the resolution of the viewport, is loaded and colored.
+ * Only matrix files colored with one palette and not reordered are tiled.
+ */
+bool
+CiftiMappableDataFile::isMatrixChartingTiled() const
+{
+    if (m_matrixTilePyramidFailedFlag
+        || (m_ciftiFile == NULL)) {
+        return false;
+    }
+    
+    const DataFileTypeEnum::Enum dataFileType = getDataFileType();
+    if ((dataFileType != DataFileTypeEnum::CONNECTIVITY_PARCEL)
+        && (dataFileType != DataFileTypeEnum::CONNECTIVITY_SCALAR_DATA_SERIES)) {
+        return false;
+    }
+    if ( ! isMappedWithPalette()) {
+        return false;
+    }
+    
+    const CiftiConnectivityMatrixParcelFile* parcelConnFile = dynamic_cast<const CiftiConnectivityMatrixParcelFile*>(this);
+    if (parcelConnFile != NULL) {
+        CiftiParcelLabelFile* parcelLabelReorderingFile = NULL;
+        int32_t parcelLabelFileMapIndex = -1;
+        bool reorderingEnabledFlag = false;
+        std::vector<CiftiParcelLabelFile*> parcelLabelFiles;
+        parcelConnFile->getSelectedParcelLabelFileAndMapForReordering(parcelLabelFiles,
+                                                                      parcelLabelReorderingFile,
+                                                                      parcelLabelFileMapIndex,
+                                                                      reorderingEnabledFlag);
+        if (reorderingEnabledFlag) {
+            return false;
+        }
+    }
+    
+    if ( ! GraphicsUtilitiesOpenGL::isVersionOrGreater(2, 0)) {
+        return false;
+    }
+    
+    int32_t numberOfRows(0), numberOfColumns(0);
+    helpMapFileGetMatrixDimensions(numberOfRows,
+                                   numberOfColumns);
+    const int32_t maximumWidthHeight = GraphicsUtilitiesOpenGL::getTextureWidthHeightMaximumDimension();
+    return ((numberOfRows > maximumWidthHeight)
+            || (numberOfColumns > maximumWidthHeight));
+}
+
+/**
+ * @return The graphics primitive containing the visible region of a tiled
+ * matrix (see isMatrixChartingTiled()) as one texture, or NULL if there is
+ * an error or no part of the matrix is visible.  Cells are sized as in
+ * getMatrixChartingGraphicsPrimitive() and the region is drawn from the
+ * coarsest level of the tile pyramid that has at least one cell per pixel.
+ * The tile pyramid is created the first time the matrix is drawn.
+ *
+ * @param matrixViewMode
+ *     The matrix visualization mode (upper/lower).
+ * @param opacityIn
+ *     Opacity of the matrix
+ * @param visibleRegion
+ *     Visible region of the chart (min-x, max-x, min-y, max-y).
+ * @param viewportWidth
+ *     Width of the viewport in pixels.
+ * @param viewportHeight
+ *     Height of the viewport in pixels.
+ */
+GraphicsPrimitive*
+CiftiMappableDataFile::getMatrixChartingTiledGraphicsPrimitive(const ChartTwoMatrixTriangularViewingModeEnum::Enum matrixViewMode,
+                                                               const float opacityIn,
+                                                               const float visibleRegion[4],
+                                                               const int32_t viewportWidth,
+                                                               const int32_t viewportHeight) const
+{
+    if ( ! isMatrixChartingTiled()) {
+        return NULL;
+    }
+    
+    float opacity(opacityIn);
+    if (opacity < 0.0) {
+        opacity = 0.0;
+    }
+    if (opacity > 1.0) {
+        opacity = 1.0;
+    }
+    if (opacity != m_previousMatrixOpacity) {
+        const_cast<CiftiMappableDataFile*>(this)->invalidateColoringInAllMaps();
+        m_previousMatrixOpacity = opacity;
+    }
+    
+    if (m_matrixTilePyramid == NULL) {
+        AString errorMessage;
+        m_matrixTilePyramid = CiftiMatrixTilePyramid::openOrBuild(m_ciftiFile,
+                                                                  getFileName(),
+                                                                  CiftiMatrixTilePyramid::PoolingMode::MEAN,
+                                                                  errorMessage);
+        if (m_matrixTilePyramid == NULL) {
+            m_matrixTilePyramidFailedFlag = true;
+            CaretLogSevere("Unable to create tiles for drawing matrix in "
+                           + getFileName()
+                           + ", matrix will be drawn with triangles: "
+                           + errorMessage);
+            return NULL;
+        }
+    }
+    
+    const int64_t numberOfRows = m_matrixTilePyramid->getNumberOfRows(0);
+    const int64_t numberOfColumns = m_matrixTilePyramid->getNumberOfColumns(0);
+    
+    CaretUnitsTypeEnum::Enum unusedUnits;
+    float xAxisStart(0.0), xAxisStep(0.0);
+    float yAxisStart(0.0), yAxisStep(0.0);
+    getDimensionUnits(CiftiXML::ALONG_ROW, unusedUnits, xAxisStart, xAxisStep);
+    getDimensionUnits(CiftiXML::ALONG_COLUMN, unusedUnits, yAxisStart, yAxisStep);
+    if (xAxisStep <= 0.0) {
+        xAxisStep = 1.0;
+    }
+    if (yAxisStep <= 0.0) {
+        yAxisStep = 1.0;
+    }
+    
+    /*
+     * Visible cells at full resolution.  Rows are numbered from the top
+     * of the chart, so the first row is at the maximum Y.
+     */
+    auto clampIndex = [](const double value, const int64_t maximumValue) {
+        return std::min(std::max(static_cast<int64_t>(value), static_cast<int64_t>(0)), maximumValue);
+    };
+    const int64_t firstColumn = clampIndex(std::floor((visibleRegion[0] - xAxisStart) / xAxisStep), numberOfColumns);
+    const int64_t endColumn   = clampIndex(std::ceil((visibleRegion[1] - xAxisStart) / xAxisStep), numberOfColumns);
+    const int64_t firstRow    = numberOfRows - clampIndex(std::ceil((visibleRegion[3] - yAxisStart) / yAxisStep), numberOfRows);
+    const int64_t endRow      = numberOfRows - clampIndex(std::floor((visibleRegion[2] - yAxisStart) / yAxisStep), numberOfRows);
+    if ((firstColumn >= endColumn)
+        || (firstRow >= endRow)) {
+        return NULL;
+    }
+    
+    const double cellsPerPixel = std::max(static_cast<double>(endColumn - firstColumn) / std::max(viewportWidth, 1),
+                                          static_cast<double>(endRow - firstRow) / std::max(viewportHeight, 1));
+    int32_t level = m_matrixTilePyramid->getLevelForCellsPerPixel(cellsPerPixel);
+    
+    /*
+     * Region of the level, use a coarser level if the region does not fit in a texture
+     */
+    const int64_t maximumWidthHeight = GraphicsUtilitiesOpenGL::getTextureWidthHeightMaximumDimension();
+    int64_t levelScale(1), levelFirstRow(0), levelEndRow(0), levelFirstColumn(0), levelEndColumn(0);
+    while (true) {
+        levelScale       = (static_cast<int64_t>(1) << level);
+        levelFirstRow    = firstRow / levelScale;
+        levelEndRow      = (endRow + levelScale - 1) / levelScale;
+        levelFirstColumn = firstColumn / levelScale;
+        levelEndColumn   = (endColumn + levelScale - 1) / levelScale;
+        if (((levelEndRow - levelFirstRow) <= maximumWidthHeight)
+            && ((levelEndColumn - levelFirstColumn) <= maximumWidthHeight)) {
+            break;
+        }
+        if (level >= (m_matrixTilePyramid->getNumberOfLevels() - 1)) {
+            break;
+        }
+        ++level;
+    }
+    const int64_t regionRows = levelEndRow - levelFirstRow;
+    const int64_t regionColumns = levelEndColumn - levelFirstColumn;
+    
+    const std::array<int64_t, 6> primitiveKey {
+        level,
+        levelFirstRow,
+        levelFirstColumn,
+        regionRows,
+        regionColumns,
+        static_cast<int64_t>(matrixViewMode)
+    };
+    if ((m_matrixGraphicsTiledPrimitive != NULL)
+        && (primitiveKey == m_matrixGraphicsTiledPrimitiveKey)) {
+        return m_matrixGraphicsTiledPrimitive.get();
+    }
+    m_matrixGraphicsTiledPrimitive.reset();
+    
+    std::vector<float> regionData;
+    AString errorMessage;
+    if ( ! m_matrixTilePyramid->getRegion(level,
+                                          levelFirstRow,
+                                          levelFirstColumn,
+                                          regionRows,
+                                          regionColumns,
+                                          regionData,
+                                          errorMessage)) {
+        CaretLogSevere(errorMessage);
+        return NULL;
+    }
+    
+    /*
+     * Statistics of all data would require reading the entire matrix,
+     * instead use the finest level that is of moderate size
+     */
+    if (m_matrixTiledFastStatistics == NULL) {
+        const int64_t maximumStatisticsCells = 16 * 1024 * 1024;
+        int32_t statisticsLevel = 0;
+        while ((statisticsLevel < (m_matrixTilePyramid->getNumberOfLevels() - 1))
+               && ((m_matrixTilePyramid->getNumberOfRows(statisticsLevel)
+                    * m_matrixTilePyramid->getNumberOfColumns(statisticsLevel)) > maximumStatisticsCells)) {
+            ++statisticsLevel;
+        }
+        std::vector<float> statisticsData;
+        if ( ! m_matrixTilePyramid->getRegion(statisticsLevel,
+                                              0,
+                                              0,
+                                              m_matrixTilePyramid->getNumberOfRows(statisticsLevel),
+                                              m_matrixTilePyramid->getNumberOfColumns(statisticsLevel),
+                                              statisticsData,
+                                              errorMessage)) {
+            CaretLogSevere(errorMessage);
+            return NULL;
+        }
+        m_matrixTiledFastStatistics.grabNew(new FastStatistics());
+        m_matrixTiledFastStatistics->update(&statisticsData[0],
+                                            statisticsData.size());
+    }
+    
+    const int64_t numberOfCells = regionRows * regionColumns;
+    std::vector<uint8_t> regionRGBA(numberOfCells * 4);
+    const PaletteColorMapping* pcm = m_ciftiFile->getCiftiXML().getFilePalette();
+    CaretAssert(pcm);
+    NodeAndVoxelColoring::colorScalarsWithPalette(m_matrixTiledFastStatistics,
+                                                  pcm,
+                                                  &regionData[0],
+                                                  pcm,
+                                                  &regionData[0],
+                                                  numberOfCells,
+                                                  &regionRGBA[0]);
+    
+    /*
+     * Texture rows start at the bottom of the chart.  Triangular viewing
+     * is applied to cells of the level, which is square when the matrix is square.
+     */
+    const bool squareFlag = (numberOfRows == numberOfColumns);
+    const uint8_t alpha = static_cast<uint8_t>(opacity * 255.0);
+    std::vector<uint8_t> textureRGBA(numberOfCells * 4, 0);
+    for (int64_t i = 0; i < regionRows; i++) {
+        const int64_t rowIndex = levelFirstRow + i;
+        const uint8_t* rgbaIn = &regionRGBA[i * regionColumns * 4];
+        uint8_t* rgbaOut = &textureRGBA[(regionRows - 1 - i) * regionColumns * 4];
+        for (int64_t j = 0; j < regionColumns; j++) {
+            const int64_t columnIndex = levelFirstColumn + j;
+            bool drawCellFlag = true;
+            if (squareFlag) {
+                switch (matrixViewMode) {
+                    case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_FULL:
+                        break;
+                    case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_FULL_NO_DIAGONAL:
+                        drawCellFlag = (rowIndex != columnIndex);
+                        break;
+                    case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_LOWER_NO_DIAGONAL:
+                        drawCellFlag = (rowIndex > columnIndex);
+                        break;
+                    case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_UPPER_NO_DIAGONAL:
+                        drawCellFlag = (rowIndex < columnIndex);
+                        break;
+                }
+            }
+            if (drawCellFlag) {
+                rgbaOut[j * 4]     = rgbaIn[j * 4];
+                rgbaOut[j * 4 + 1] = rgbaIn[j * 4 + 1];
+                rgbaOut[j * 4 + 2] = rgbaIn[j * 4 + 2];
+                rgbaOut[j * 4 + 3] = alpha;
+            }
+        }
+    }
+    
+    /*
+     * Cells in the last row and column of a coarse level may extend past
+     * the matrix, so they are clamped to the matrix's edge
+     */
+    const float matrixLeft(xAxisStart + (xAxisStep * (levelFirstColumn * levelScale)));
+    const float matrixRight(xAxisStart + (xAxisStep * std::min(levelEndColumn * levelScale, numberOfColumns)));
+    const float matrixTop(yAxisStart + (yAxisStep * (numberOfRows - (levelFirstRow * levelScale))));
+    const float matrixBottom(yAxisStart + (yAxisStep * (numberOfRows - std::min(levelEndRow * levelScale, numberOfRows))));
+    const std::array<float, 4> textureBorderColorRGBA { 0.0, 0.0, 0.0, 0.0 };
+    GraphicsPrimitiveV3fT2f* matrixTexturePrimitive = GraphicsPrimitive::newPrimitiveV3fT2f(GraphicsPrimitive::PrimitiveType::OPENGL_TRIANGLE_STRIP,
+                                                                                             &textureRGBA[0],
+                                                                                             regionColumns,
+                                                                                             regionRows,
+                                                                                             GraphicsPrimitive::TextureWrappingType::CLAMP,
+                                                                                             GraphicsPrimitive::TextureMipMappingType::DISABLED,
+                                                                                             GraphicsTextureMagnificationFilterEnum::NEAREST,
+                                                                                             GraphicsTextureMinificationFilterEnum::NEAREST,
+                                                                                             textureBorderColorRGBA);
+    matrixTexturePrimitive->addVertex(matrixLeft, matrixTop, 0, 1);  /* Top Left */
+    matrixTexturePrimitive->addVertex(matrixLeft, matrixBottom, 0, 0);  /* Bottom Left */
+    matrixTexturePrimitive->addVertex(matrixRight, matrixTop, 1, 1);  /* Top Right */
+    matrixTexturePrimitive->addVertex(matrixRight, matrixBottom, 1, 0);  /* Bottom Right */
+    matrixTexturePrimitive->setUsageTypeAll(GraphicsPrimitive::UsageType::MODIFIED_ONCE_DRAWN_MANY_TIMES);
+    matrixTexturePrimitive->setReleaseInstanceDataMode(GraphicsPrimitive::ReleaseInstanceDataMode::ENABLED);
+    
+    m_matrixGraphicsTiledPrimitive.reset(matrixTexturePrimitive);
+    m_matrixGraphicsTiledPrimitiveKey = primitiveKey;
+    
+    return matrixTexturePrimitive;
+}
+
 /**
  * Get the matrix RGBA coloring for this matrix data creator.
  *
@@ -2837,6 +3147,7 @@ CiftiMappableDataFile::updateScalarColoringForMap(const int32_t mapIndex)
     m_matrixGraphicsTrianglesPrimitive.reset();
     m_matrixGraphicsTexturePrimitive.reset();
     m_matrixGraphicsOutlinePrimitive.reset();
+    m_matrixGraphicsTiledPrimitive.reset();
     m_previousMatrixOpacity = -1.0;
     
     m_graphicsPrimitiveManager->invalidateColoringForMap(mapIndex);
@@ -2881,10 +3192,11 @@ CiftiMappableDataFile::getParcelNodesElementForSelectedParcel(std::set<int64_t>
     if(selectionIndex >= 0 && selectionIndex < (int64_t)parcels.size())
     {
         const CiftiParcelsMap::Parcel& parcelOut = parcels[selectionIndex];
-        std::map<StructureEnum::Enum, std::set<int64_t> >::const_iterator findStruct = parcelOut.m_surfaceNodes.find(structure);
+        std::map<StructureEnum::Enum, CaretSortedVectorSet<int64_t> >::const_iterator findStruct = parcelOut.m_surfaceNodes.find(structure);
         if (findStruct != parcelOut.m_surfaceNodes.end())
         {
-            parcelNodesOut = findStruct->second;
+            parcelNodesOut = std::set<int64_t>(findStruct->second.begin(),
+                                               findStruct->second.end());
             return true;
         }
     }
@@ -4173,6 +4485,41 @@ CiftiMappableDataFile::getVolumeDrawingPrimitive(const int32_t mapIndex,
                                                                        tabIndex);
 }
 
+/**
+ * @return True if this volume is drawn with bricks.
+ */
+bool
+CiftiMappableDataFile::isVolumeDrawingWithBricks() const
+{
+    return m_graphicsPrimitiveManager->isVolumeDrawingWithBricks();
+}
+
+/**
+ * Get the graphics primitives of the bricks that intersect a slice
+ *
+ * @param mapIndex
+ *    Index of the map.
+ * @param displayGroup
+ *    The selected display group.
+ * @param tabIndex
+ *    Index of selected tab.
+ * @param sliceCornersXYZ
+ *    Corners of the slice in order around the slice.
+ * @return
+ *    Graphics primitives for drawing the slice.
+ */
+std::vector<GraphicsPrimitiveV3fT3f*>
+CiftiMappableDataFile::getVolumeDrawingBrickPrimitivesForSlice(const int32_t mapIndex,
+                                                               const DisplayGroupEnum::Enum displayGroup,
+                                                               const int32_t tabIndex,
+                                                               const std::array<std::array<float, 3>, 4>& sliceCornersXYZ) const
+{
+    return m_graphicsPrimitiveManager->getVolumeDrawingBrickPrimitivesForSlice(mapIndex,
+                                                                               displayGroup,
+                                                                               tabIndex,
+                                                                               sliceCornersXYZ);
+}
+
 /**
  * Get the voxel coloring for the voxel at the given indices.
  * This method is for label data.  Accessing the actual voxel values is
@@ -7067,11 +7414,11 @@ CiftiMappableDataFile::addCiftiXmlToDataFileContentInformation(DataFileContentIn
                         const CiftiParcelsMap::Parcel parcel = *parcelIter;
                         dataFileInformation.addNameAndValue("    Parcel " + AString::number(parcelIter - parcels.begin() + 1), parcel.m_name);
                         
-                        for (std::map<StructureEnum::Enum, std::set<int64_t> >::const_iterator surfIter = parcel.m_surfaceNodes.begin();
+                        for (std::map<StructureEnum::Enum, CaretSortedVectorSet<int64_t> >::const_iterator surfIter = parcel.m_surfaceNodes.begin();
                              surfIter != parcel.m_surfaceNodes.end();
                              surfIter++) {
                             const StructureEnum::Enum structure  = surfIter->first;
-                            const std::set<int64_t>& nodeIndices = surfIter->second;
+                            const CaretSortedVectorSet<int64_t>& nodeIndices = surfIter->second;
                             dataFileInformation.addNameAndValue("        " +
                                                                 StructureEnum::toGuiName(structure),
                                                                 AString::number(nodeIndices.size()) + " vertices");
@@ -32,6 +32,7 @@
 #include "EventListenerInterface.h"
 #include "VolumeMappableInterface.h"
 
+#include <array>
 #include <memory>
 #include <set>
 
@@ -40,6 +41,7 @@ namespace caret {
     class ChartData;
     class ChartDataCartesian;
     class CiftiFile;
+    class CiftiMatrixTilePyramid;
     class CiftiParcelsMap;
     class CiftiScalarsMap;
     class CiftiXML;
@@ -373,6 +375,13 @@ namespace caret {
                                                                    const DisplayGroupEnum::Enum displayGroup,
                                                                    const int32_t tabIndex) const override;
         
+        virtual bool isVolumeDrawingWithBricks() const override;
+        
+        virtual std::vector<GraphicsPrimitiveV3fT3f*> getVolumeDrawingBrickPrimitivesForSlice(const int32_t mapIndex,
+                                                                                              const DisplayGroupEnum::Enum displayGroup,
+                                                                                              const int32_t tabIndex,
+                                                                                              const std::array<std::array<float, 3>, 4>& sliceCornersXYZ) const override;
+        
         virtual bool getMapVolumeVoxelValue(const int32_t mapIndex,
                                             const float xyz[3],
                                             int64_t ijkOut[3],
@@ -548,6 +557,14 @@ namespace caret {
                                                               const MatrixGridMode gridMode,
                                                               const float opacity) const;
         
+        bool isMatrixChartingTiled() const;
+        
+        GraphicsPrimitive* getMatrixChartingTiledGraphicsPrimitive(const ChartTwoMatrixTriangularViewingModeEnum::Enum matrixViewMode,
+                                                                   const float opacity,
+                                                                   const float visibleRegion[4],
+                                                                   const int32_t viewportWidth,
+                                                                   const int32_t viewportHeight) const;
+        
         /** Identifier for the matrix primitives alternative color used for the grid coloring */
         int32_t getMatrixChartGraphicsPrimitiveGridColorIdentifier() const { return 1; }
         
@@ -820,6 +837,21 @@ namespace caret {
         /** Primitive for grid outline around matrix cells */
         mutable std::unique_ptr<GraphicsPrimitiveV3fC4f> m_matrixGraphicsOutlinePrimitive;
         
+        /** Multi-resolution tiles of a matrix too large for one texture, created when first drawn */
+        mutable std::unique_ptr<CiftiMatrixTilePyramid> m_matrixTilePyramid;
+        
+        /** True if creating the tile pyramid failed, matrix is then drawn with triangles */
+        mutable bool m_matrixTilePyramidFailedFlag = false;
+        
+        /** Statistics for coloring a tiled matrix, from a coarse level of the tile pyramid */
+        mutable CaretPointer<FastStatistics> m_matrixTiledFastStatistics;
+        
+        /** Primitive with the visible region of a tiled matrix */
+        mutable std::unique_ptr<GraphicsPrimitiveV3fT2f> m_matrixGraphicsTiledPrimitive;
+        
+        /** Level, first row, first column, rows, columns, and view mode of the tiled matrix primitive */
+        mutable std::array<int64_t, 6> m_matrixGraphicsTiledPrimitiveKey;
+        
         mutable uint8_t m_previousMatrixGridRGBA[4] = { 0, 1, 2, 3 };
         
         mutable float m_previousMatrixOpacity = -1.0;
@@ -0,0 +1,858 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define __CIFTI_MATRIX_TILE_PYRAMID_DECLARE__
+#include "CiftiMatrixTilePyramid.h"
+#undef __CIFTI_MATRIX_TILE_PYRAMID_DECLARE__
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <QDir>
+#include <QHash>
+#include <QFileInfo>
+
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "CiftiFile.h"
+#include "DataFileException.h"
+#include "FileInformation.h"
+
+using namespace caret;
+
+namespace {
+    /**
+     * Header at the start of a sidecar file, all fields are 64-bit so that there is no padding
+     */
+    struct SidecarHeader {
+        char m_magic[8];
+        int64_t m_version;
+        int64_t m_byteOrderCheck;
+        int64_t m_poolingMode;
+        int64_t m_sourceFileSize;
+        int64_t m_sourceModifiedTime;
+        int64_t m_numberOfRows;
+        int64_t m_numberOfColumns;
+        int64_t m_tileDimension;
+        int64_t m_numberOfLevels;
+        int64_t m_indexOffset;
+    };
+
+    const char SIDECAR_MAGIC[8] = { 'W', 'B', 'M', 'T', 'P', 'Y', 'R', '\0' };
+    const int64_t SIDECAR_VERSION = 1;
+    const int64_t SIDECAR_BYTE_ORDER_CHECK = 0x0102030405060708LL;
+
+    int64_t divideRoundUp(const int64_t numerator,
+                          const int64_t denominator)
+    {
+        return (numerator + denominator - 1) / denominator;
+    }
+}
+
+/**
+ * Reduces rows of the next finer level into the rows of one level and
+ * writes the finished rows of the level as tiles.  Only the row being
+ * reduced and one row of tiles are kept in memory.
+ */
+class CiftiMatrixTilePyramid::LevelBuilder {
+public:
+    LevelBuilder(const int64_t numberOfRows,
+                 const int64_t numberOfColumns,
+                 const PoolingMode poolingMode)
+    : m_numberOfRows(numberOfRows),
+    m_numberOfColumns(numberOfColumns),
+    m_poolingMode(poolingMode)
+    {
+        m_values.assign(m_numberOfColumns, 0.0);
+        m_counts.assign(m_numberOfColumns, 0);
+        m_tileRowBuffer.resize(TILE_DIMENSION * m_numberOfColumns);
+    }
+
+    /**
+     * Add a row of the next finer level.
+     *
+     * @param values
+     *    Sums (mean pooling) or selected values (maximum magnitude pooling) of the finer row.
+     * @param counts
+     *    Number of finite values that went into each cell of the finer row.
+     * @param numberOfFinerColumns
+     *    Number of columns in the finer row.
+     */
+    void addFinerRow(const double* values,
+                     const int64_t* counts,
+                     const int64_t numberOfFinerColumns)
+    {
+        for (int64_t i = 0; i < numberOfFinerColumns; i++) {
+            if (counts[i] == 0) {
+                continue;
+            }
+            const int64_t j = i / 2;
+            switch (m_poolingMode) {
+                case PoolingMode::MEAN:
+                    m_values[j] += values[i];
+                    m_counts[j] += counts[i];
+                    break;
+                case PoolingMode::MAXIMUM_MAGNITUDE:
+                    /* ties go to the positive value so the result does not depend on order */
+                    if ((m_counts[j] == 0)
+                        || (std::fabs(values[i]) > std::fabs(m_values[j]))
+                        || ((std::fabs(values[i]) == std::fabs(m_values[j]))
+                            && (values[i] > m_values[j]))) {
+                        m_values[j] = values[i];
+                    }
+                    m_counts[j] += counts[i];
+                    break;
+            }
+        }
+    }
+
+    /**
+     * Finish the row being reduced, which is then available in
+     * m_values and m_counts until resetRow() is called.
+     *
+     * @return True if a full row of tiles is ready to be written.
+     */
+    bool finishRow()
+    {
+        float* rowOut = &m_tileRowBuffer[m_numberOfRowsInBuffer * m_numberOfColumns];
+        for (int64_t j = 0; j < m_numberOfColumns; j++) {
+            if (m_counts[j] == 0) {
+                rowOut[j] = std::numeric_limits<float>::quiet_NaN();
+            }
+            else if (m_poolingMode == PoolingMode::MEAN) {
+                rowOut[j] = m_values[j] / m_counts[j];
+            }
+            else {
+                rowOut[j] = m_values[j];
+            }
+        }
+        ++m_numberOfRowsInBuffer;
+        ++m_nextRowIndex;
+        return ((m_numberOfRowsInBuffer == TILE_DIMENSION)
+                || (m_nextRowIndex == m_numberOfRows));
+    }
+
+    void resetRow()
+    {
+        std::fill(m_values.begin(), m_values.end(), 0.0);
+        std::fill(m_counts.begin(), m_counts.end(), 0);
+    }
+
+    /**
+     * Write the buffered row of tiles.
+     *
+     * @param file
+     *    File that receives the tiles.
+     * @param tileOffsets
+     *    Receives the file offset of each tile.
+     * @return True if writing succeeded.
+     */
+    bool writeTileRow(QFile& file,
+                      std::vector<int64_t>& tileOffsets)
+    {
+        const int64_t tileRowIndex = (m_nextRowIndex - 1) / TILE_DIMENSION;
+        const int64_t numberOfTileColumns = divideRoundUp(m_numberOfColumns, TILE_DIMENSION);
+        std::vector<float> tileData;
+        for (int64_t tileColumn = 0; tileColumn < numberOfTileColumns; tileColumn++) {
+            const int64_t firstColumn = tileColumn * TILE_DIMENSION;
+            const int64_t tileWidth = std::min(static_cast<int64_t>(TILE_DIMENSION), m_numberOfColumns - firstColumn);
+            tileData.resize(m_numberOfRowsInBuffer * tileWidth);
+            for (int64_t i = 0; i < m_numberOfRowsInBuffer; i++) {
+                std::memcpy(&tileData[i * tileWidth],
+                            &m_tileRowBuffer[i * m_numberOfColumns + firstColumn],
+                            tileWidth * sizeof(float));
+            }
+            const int64_t tileIndex = tileRowIndex * numberOfTileColumns + tileColumn;
+            CaretAssertVectorIndex(tileOffsets, tileIndex);
+            tileOffsets[tileIndex] = file.pos();
+            const int64_t numberOfBytes = tileData.size() * sizeof(float);
+            if (file.write(reinterpret_cast<const char*>(tileData.data()), numberOfBytes) != numberOfBytes) {
+                return false;
+            }
+        }
+        m_numberOfRowsInBuffer = 0;
+        return true;
+    }
+
+    const int64_t m_numberOfRows;
+
+    const int64_t m_numberOfColumns;
+
+    const PoolingMode m_poolingMode;
+
+    std::vector<double> m_values;
+
+    std::vector<int64_t> m_counts;
+
+    std::vector<float> m_tileRowBuffer;
+
+    int64_t m_numberOfRowsInBuffer = 0;
+
+    int64_t m_nextRowIndex = 0;
+};
+
+/**
+ * \class caret::CiftiMatrixTilePyramid
+ * \brief Multi-resolution tiles of a large CIFTI matrix for matrix charts
+ * \ingroup Files
+ *
+ * Level zero is the full resolution matrix and each coarser level pools
+ * blocks of 2x2 cells of the next finer level, until a level fits in
+ * one tile.  The coarser levels are built by streaming the rows of the
+ * CIFTI file once, and are stored as tiles in a sidecar file next to the
+ * CIFTI file (or in the temporary directory if that is not writable) so
+ * that they are built only once.  The sidecar is rebuilt if the size or
+ * modification time of the CIFTI file changes.  Level zero tiles are read
+ * from the CIFTI file itself.
+ *
+ * A viewer requests only the tiles of the level matching its zoom, and
+ * the least recently used tiles are removed when the cache exceeds its
+ * size limit, so memory use does not depend on the size of the matrix.
+ */
+
+/**
+ * Constructor.
+ *
+ * @param ciftiFile
+ *    CIFTI file containing the matrix.
+ * @param sidecarFileName
+ *    Name of the file containing the coarser levels.
+ */
+CiftiMatrixTilePyramid::CiftiMatrixTilePyramid(const CiftiFile* ciftiFile,
+                                               const AString& sidecarFileName)
+: m_ciftiFile(ciftiFile),
+m_sidecarFileName(sidecarFileName)
+{
+    CaretAssert(m_ciftiFile);
+    const std::vector<int64_t>& dims = m_ciftiFile->getDimensions();
+    CaretAssert(dims.size() == 2);
+    m_numberOfRows    = dims[1];
+    m_numberOfColumns = dims[0];
+    computeLevelSizes();
+}
+
+/**
+ * Destructor.
+ */
+CiftiMatrixTilePyramid::~CiftiMatrixTilePyramid()
+{
+}
+
+/**
+ * Open the tile pyramid of a CIFTI matrix, building its sidecar file if it
+ * does not exist or is out of date.  Building reads every row of the CIFTI
+ * file once.
+ *
+ * @param ciftiFile
+ *    CIFTI file containing the matrix, must have two dimensions.
+ * @param ciftiFileName
+ *    Name of the CIFTI file.
+ * @param poolingMode
+ *    How cells are pooled in the coarser levels.
+ * @param errorMessageOut
+ *    Describes the error if opening and building failed.
+ * @return
+ *    The tile pyramid, or NULL if there is an error.
+ */
+std::unique_ptr<CiftiMatrixTilePyramid>
+CiftiMatrixTilePyramid::openOrBuild(const CiftiFile* ciftiFile,
+                                    const AString& ciftiFileName,
+                                    const PoolingMode poolingMode,
+                                    AString& errorMessageOut)
+{
+    errorMessageOut.clear();
+    CaretAssert(ciftiFile);
+    if (ciftiFile->getDimensions().size() != 2) {
+        errorMessageOut = "Tile pyramids require a CIFTI file with two dimensions";
+        return std::unique_ptr<CiftiMatrixTilePyramid>();
+    }
+    
+    FileInformation fileInfo(ciftiFileName);
+    const int64_t sourceFileSize = fileInfo.size();
+    const int64_t sourceModifiedTime = fileInfo.getLastModified().toMSecsSinceEpoch();
+    
+    /*
+     * Prefer a sidecar next to the CIFTI file but use the temporary
+     * directory if the CIFTI file's directory is not writable
+     */
+    std::vector<AString> sidecarNames;
+    sidecarNames.push_back(getSidecarFileName(ciftiFileName,
+                                              poolingMode));
+    const AString canonicalName = (fileInfo.getCanonicalFilePath().isEmpty()
+                                   ? ciftiFileName
+                                   : fileInfo.getCanonicalFilePath());
+    sidecarNames.push_back(QDir::temp().filePath(QFileInfo(sidecarNames[0]).fileName()
+                                                 + "."
+                                                 + AString::number(qHash(canonicalName), 16)));
+    
+    for (const auto& sidecarName : sidecarNames) {
+        std::unique_ptr<CiftiMatrixTilePyramid> pyramid(new CiftiMatrixTilePyramid(ciftiFile,
+                                                                                   sidecarName));
+        AString message;
+        if (pyramid->readHeader(sourceFileSize, sourceModifiedTime, poolingMode, message)) {
+            return pyramid;
+        }
+        CaretLogFine(message);
+        if (pyramid->build(sourceFileSize, sourceModifiedTime, poolingMode, message)) {
+            return pyramid;
+        }
+        if ( ! errorMessageOut.isEmpty()) {
+            errorMessageOut += "\n";
+        }
+        errorMessageOut += message;
+    }
+    
+    return std::unique_ptr<CiftiMatrixTilePyramid>();
+}
+
+/**
+ * @return Name of the sidecar file next to a CIFTI file.
+ *
+ * @param ciftiFileName
+ *    Name of the CIFTI file.
+ * @param poolingMode
+ *    How cells are pooled in the coarser levels.
+ */
+AString
+CiftiMatrixTilePyramid::getSidecarFileName(const AString& ciftiFileName,
+                                           const PoolingMode poolingMode)
+{
+    AString poolingName;
+    switch (poolingMode) {
+        case PoolingMode::MEAN:
+            poolingName = "mean";
+            break;
+        case PoolingMode::MAXIMUM_MAGNITUDE:
+            poolingName = "maxmag";
+            break;
+    }
+    return (ciftiFileName + "." + poolingName + ".wb_matrix_pyramid");
+}
+
+/**
+ * Compute the number of levels and the size of each level.
+ */
+void
+CiftiMatrixTilePyramid::computeLevelSizes()
+{
+    m_levelSizes.clear();
+    int64_t rows = m_numberOfRows;
+    int64_t columns = m_numberOfColumns;
+    m_levelSizes.push_back(std::make_pair(rows, columns));
+    while ((rows > TILE_DIMENSION)
+           || (columns > TILE_DIMENSION)) {
+        rows    = divideRoundUp(rows, 2);
+        columns = divideRoundUp(columns, 2);
+        m_levelSizes.push_back(std::make_pair(rows, columns));
+    }
+    
+    m_tileOffsets.clear();
+    m_tileOffsets.resize(m_levelSizes.size());
+    for (int32_t level = 1; level < getNumberOfLevels(); level++) {
+        m_tileOffsets[level].resize(divideRoundUp(m_levelSizes[level].first, TILE_DIMENSION)
+                                    * divideRoundUp(m_levelSizes[level].second, TILE_DIMENSION),
+                                    -1);
+    }
+}
+
+/**
+ * Open an existing sidecar file and read its tile index.
+ *
+ * @return True if the sidecar exists and matches the CIFTI file.
+ */
+bool
+CiftiMatrixTilePyramid::readHeader(const int64_t sourceFileSize,
+                                   const int64_t sourceModifiedTime,
+                                   const PoolingMode poolingMode,
+                                   AString& errorMessageOut)
+{
+    CaretMutexLocker locker(&m_mutex);
+    m_sidecarFile.setFileName(m_sidecarFileName);
+    if ( ! m_sidecarFile.exists()) {
+        errorMessageOut = ("Matrix tile pyramid " + m_sidecarFileName + " does not exist");
+        return false;
+    }
+    if ( ! m_sidecarFile.open(QIODevice::ReadOnly)) {
+        errorMessageOut = ("Unable to open matrix tile pyramid " + m_sidecarFileName);
+        return false;
+    }
+    
+    SidecarHeader header;
+    if ((m_sidecarFile.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header))
+        || (std::memcmp(header.m_magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC)) != 0)
+        || (header.m_version != SIDECAR_VERSION)
+        || (header.m_byteOrderCheck != SIDECAR_BYTE_ORDER_CHECK)
+        || (header.m_poolingMode != static_cast<int64_t>(poolingMode))
+        || (header.m_sourceFileSize != sourceFileSize)
+        || (header.m_sourceModifiedTime != sourceModifiedTime)
+        || (header.m_numberOfRows != m_numberOfRows)
+        || (header.m_numberOfColumns != m_numberOfColumns)
+        || (header.m_tileDimension != TILE_DIMENSION)
+        || (header.m_numberOfLevels != getNumberOfLevels())) {
+        m_sidecarFile.close();
+        errorMessageOut = ("Matrix tile pyramid " + m_sidecarFileName + " is out of date or invalid");
+        return false;
+    }
+    
+    if ( ! m_sidecarFile.seek(header.m_indexOffset)) {
+        m_sidecarFile.close();
+        errorMessageOut = ("Matrix tile pyramid " + m_sidecarFileName + " is truncated");
+        return false;
+    }
+    for (int32_t level = 1; level < getNumberOfLevels(); level++) {
+        std::vector<int64_t>& offsets = m_tileOffsets[level];
+        const int64_t numberOfBytes = offsets.size() * sizeof(int64_t);
+        if (m_sidecarFile.read(reinterpret_cast<char*>(offsets.data()), numberOfBytes) != numberOfBytes) {
+            m_sidecarFile.close();
+            errorMessageOut = ("Matrix tile pyramid " + m_sidecarFileName + " is truncated");
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/**
+ * Build the sidecar file by reading each row of the CIFTI file once,
+ * then open it for reading.
+ *
+ * @return True if the sidecar was built.
+ */
+bool
+CiftiMatrixTilePyramid::build(const int64_t sourceFileSize,
+                              const int64_t sourceModifiedTime,
+                              const PoolingMode poolingMode,
+                              AString& errorMessageOut)
+{
+    CaretMutexLocker locker(&m_mutex);
+    const AString temporaryName(m_sidecarFileName + ".part");
+    QFile outputFile(temporaryName);
+    if ( ! outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        errorMessageOut = ("Unable to create matrix tile pyramid " + temporaryName
+                           + ": " + outputFile.errorString());
+        return false;
+    }
+    
+    SidecarHeader header;
+    std::memcpy(header.m_magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC));
+    header.m_version            = SIDECAR_VERSION;
+    header.m_byteOrderCheck     = SIDECAR_BYTE_ORDER_CHECK;
+    header.m_poolingMode        = static_cast<int64_t>(poolingMode);
+    header.m_sourceFileSize     = sourceFileSize;
+    header.m_sourceModifiedTime = sourceModifiedTime;
+    header.m_numberOfRows       = m_numberOfRows;
+    header.m_numberOfColumns    = m_numberOfColumns;
+    header.m_tileDimension      = TILE_DIMENSION;
+    header.m_numberOfLevels     = getNumberOfLevels();
+    header.m_indexOffset        = -1;
+    bool writeOK = (outputFile.write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header));
+    
+    std::vector<std::unique_ptr<LevelBuilder>> builders(getNumberOfLevels());
+    for (int32_t level = 1; level < getNumberOfLevels(); level++) {
+        builders[level].reset(new LevelBuilder(m_levelSizes[level].first,
+                                               m_levelSizes[level].second,
+                                               poolingMode));
+    }
+    
+    CaretLogInfo("Building matrix tile pyramid " + m_sidecarFileName);
+    try {
+        std::vector<float> rowData(m_numberOfColumns);
+        std::vector<double> rowValues(m_numberOfColumns);
+        std::vector<int64_t> rowCounts(m_numberOfColumns);
+        for (int64_t iRow = 0; (iRow < m_numberOfRows) && writeOK; iRow++) {
+            m_ciftiFile->getRow(rowData.data(), iRow);
+            for (int64_t j = 0; j < m_numberOfColumns; j++) {
+                const bool finiteFlag = std::isfinite(rowData[j]);
+                rowValues[j] = (finiteFlag ? rowData[j] : 0.0);
+                rowCounts[j] = (finiteFlag ? 1 : 0);
+            }
+            
+            /*
+             * Pass the row to the next coarser level, and each row
+             * finished there on to the level after it
+             */
+            const double* values = rowValues.data();
+            const int64_t* counts = rowCounts.data();
+            int64_t finerNumberOfColumns = m_numberOfColumns;
+            int64_t finerRowIndex = iRow;
+            int64_t finerNumberOfRows = m_numberOfRows;
+            int32_t lastFinishedLevel = 0;
+            for (int32_t level = 1; (level < getNumberOfLevels()) && writeOK; level++) {
+                LevelBuilder* builder = builders[level].get();
+                builder->addFinerRow(values, counts, finerNumberOfColumns);
+                if (((finerRowIndex % 2) == 0)
+                    && (finerRowIndex != (finerNumberOfRows - 1))) {
+                    break;
+                }
+                if (builder->finishRow()) {
+                    writeOK = builder->writeTileRow(outputFile, m_tileOffsets[level]);
+                }
+                lastFinishedLevel = level;
+                values = builder->m_values.data();
+                counts = builder->m_counts.data();
+                finerNumberOfColumns = builder->m_numberOfColumns;
+                finerRowIndex = builder->m_nextRowIndex - 1;
+                finerNumberOfRows = builder->m_numberOfRows;
+            }
+            for (int32_t level = 1; level <= lastFinishedLevel; level++) {
+                builders[level]->resetRow();
+            }
+        }
+    }
+    catch (const DataFileException& dfe) {
+        outputFile.close();
+        QFile::remove(temporaryName);
+        errorMessageOut = dfe.whatString();
+        return false;
+    }
+    
+    if (writeOK) {
+        header.m_indexOffset = outputFile.pos();
+        for (int32_t level = 1; (level < getNumberOfLevels()) && writeOK; level++) {
+            const std::vector<int64_t>& offsets = m_tileOffsets[level];
+            const int64_t numberOfBytes = offsets.size() * sizeof(int64_t);
+            writeOK = (outputFile.write(reinterpret_cast<const char*>(offsets.data()), numberOfBytes) == numberOfBytes);
+        }
+    }
+    if (writeOK) {
+        writeOK = (outputFile.seek(0)
+                   && (outputFile.write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header)));
+    }
+    if (writeOK) {
+        writeOK = outputFile.flush();
+    }
+    outputFile.close();
+    if ( ! writeOK) {
+        errorMessageOut = ("Error writing matrix tile pyramid " + temporaryName + ": " + outputFile.errorString());
+        QFile::remove(temporaryName);
+        return false;
+    }
+    
+    QFile::remove(m_sidecarFileName);
+    if ( ! QFile::rename(temporaryName, m_sidecarFileName)) {
+        errorMessageOut = ("Unable to rename " + temporaryName + " to " + m_sidecarFileName);
+        QFile::remove(temporaryName);
+        return false;
+    }
+    
+    m_sidecarFile.setFileName(m_sidecarFileName);
+    if ( ! m_sidecarFile.open(QIODevice::ReadOnly)) {
+        errorMessageOut = ("Unable to open matrix tile pyramid " + m_sidecarFileName);
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * @return Number of levels, level zero is the full resolution matrix.
+ */
+int32_t
+CiftiMatrixTilePyramid::getNumberOfLevels() const
+{
+    return m_levelSizes.size();
+}
+
+/**
+ * @return Number of rows in a level.
+ *
+ * @param level
+ *    Index of the level.
+ */
+int64_t
+CiftiMatrixTilePyramid::getNumberOfRows(const int32_t level) const
+{
+    CaretAssertVectorIndex(m_levelSizes, level);
+    return m_levelSizes[level].first;
+}
+
+/**
+ * @return Number of columns in a level.
+ *
+ * @param level
+ *    Index of the level.
+ */
+int64_t
+CiftiMatrixTilePyramid::getNumberOfColumns(const int32_t level) const
+{
+    CaretAssertVectorIndex(m_levelSizes, level);
+    return m_levelSizes[level].second;
+}
+
+/**
+ * @return The coarsest level that still has at least one cell per pixel
+ * when full resolution cells are drawn at the given density.
+ *
+ * @param cellsPerPixel
+ *    Number of full resolution cells covered by one pixel.
+ */
+int32_t
+CiftiMatrixTilePyramid::getLevelForCellsPerPixel(const double cellsPerPixel) const
+{
+    if (cellsPerPixel <= 1.0) {
+        return 0;
+    }
+    const int32_t level = static_cast<int32_t>(std::floor(std::log2(cellsPerPixel)));
+    return std::min(level, getNumberOfLevels() - 1);
+}
+
+/**
+ * Get the data in a tile.
+ *
+ * @param level
+ *    Index of the level.
+ * @param tileRow
+ *    Row of the tile in the level.
+ * @param tileColumn
+ *    Column of the tile in the level.
+ * @param dataOut
+ *    Output with the tile's data, row-major.
+ * @param numberOfRowsOut
+ *    Output with the number of rows in the tile (tiles on the edge may be smaller).
+ * @param numberOfColumnsOut
+ *    Output with the number of columns in the tile.
+ * @param errorMessageOut
+ *    Describes the error if reading the tile failed.
+ * @return
+ *    True if the tile is valid.
+ */
+bool
+CiftiMatrixTilePyramid::getTile(const int32_t level,
+                                const int64_t tileRow,
+                                const int64_t tileColumn,
+                                std::vector<float>& dataOut,
+                                int64_t& numberOfRowsOut,
+                                int64_t& numberOfColumnsOut,
+                                AString& errorMessageOut)
+{
+    CaretMutexLocker locker(&m_mutex);
+    
+    const TileKey tileKey(level, tileRow, tileColumn);
+    auto iter = m_tiles.find(tileKey);
+    if (iter != m_tiles.end()) {
+        Tile& tile = iter->second;
+        m_lruTileKeys.splice(m_lruTileKeys.begin(), m_lruTileKeys, tile.m_lruIter);
+        dataOut = tile.m_data;
+        numberOfRowsOut = tile.m_numberOfRows;
+        numberOfColumnsOut = tile.m_numberOfColumns;
+        return true;
+    }
+    
+    Tile tile;
+    if ( ! readTileFromStorage(tileKey, tile, errorMessageOut)) {
+        return false;
+    }
+    dataOut = tile.m_data;
+    numberOfRowsOut = tile.m_numberOfRows;
+    numberOfColumnsOut = tile.m_numberOfColumns;
+    addTileToCache(tileKey, tile);
+    return true;
+}
+
+/**
+ * Get a rectangular region of a level assembled from its tiles.
+ * Cells outside of the matrix are NaN.
+ *
+ * @param level
+ *    Index of the level.
+ * @param firstRow
+ *    First row of the region in the level.
+ * @param firstColumn
+ *    First column of the region in the level.
+ * @param numberOfRows
+ *    Number of rows in the region.
+ * @param numberOfColumns
+ *    Number of columns in the region.
+ * @param dataOut
+ *    Output with the region's data, row-major.
+ * @param errorMessageOut
+ *    Describes the error if reading a tile failed.
+ * @return
+ *    True if the region is valid.
+ */
+bool
+CiftiMatrixTilePyramid::getRegion(const int32_t level,
+                                  const int64_t firstRow,
+                                  const int64_t firstColumn,
+                                  const int64_t numberOfRows,
+                                  const int64_t numberOfColumns,
+                                  std::vector<float>& dataOut,
+                                  AString& errorMessageOut)
+{
+    if ((level < 0)
+        || (level >= getNumberOfLevels())) {
+        errorMessageOut = ("Invalid matrix tile pyramid level " + AString::number(level));
+        return false;
+    }
+    dataOut.assign(numberOfRows * numberOfColumns,
+                   std::numeric_limits<float>::quiet_NaN());
+    
+    const int64_t levelRows = getNumberOfRows(level);
+    const int64_t levelColumns = getNumberOfColumns(level);
+    const int64_t rowStart = std::max(firstRow, static_cast<int64_t>(0));
+    const int64_t rowEnd   = std::min(firstRow + numberOfRows, levelRows);
+    const int64_t colStart = std::max(firstColumn, static_cast<int64_t>(0));
+    const int64_t colEnd   = std::min(firstColumn + numberOfColumns, levelColumns);
+    if ((rowStart >= rowEnd)
+        || (colStart >= colEnd)) {
+        return true;
+    }
+    
+    std::vector<float> tileData;
+    for (int64_t tileRow = rowStart / TILE_DIMENSION; tileRow <= (rowEnd - 1) / TILE_DIMENSION; tileRow++) {
+        for (int64_t tileColumn = colStart / TILE_DIMENSION; tileColumn <= (colEnd - 1) / TILE_DIMENSION; tileColumn++) {
+            int64_t tileRows(0), tileColumns(0);
+            if ( ! getTile(level, tileRow, tileColumn, tileData, tileRows, tileColumns, errorMessageOut)) {
+                return false;
+            }
+            const int64_t tileFirstRow = tileRow * TILE_DIMENSION;
+            const int64_t tileFirstColumn = tileColumn * TILE_DIMENSION;
+            const int64_t copyRowStart = std::max(rowStart, tileFirstRow);
+            const int64_t copyRowEnd   = std::min(rowEnd, tileFirstRow + tileRows);
+            const int64_t copyColStart = std::max(colStart, tileFirstColumn);
+            const int64_t copyColEnd   = std::min(colEnd, tileFirstColumn + tileColumns);
+            for (int64_t r = copyRowStart; r < copyRowEnd; r++) {
+                std::memcpy(&dataOut[(r - firstRow) * numberOfColumns + (copyColStart - firstColumn)],
+                            &tileData[(r - tileFirstRow) * tileColumns + (copyColStart - tileFirstColumn)],
+                            (copyColEnd - copyColStart) * sizeof(float));
+            }
+        }
+    }
+    
+    return true;
+}
+
+/**
+ * @return Number of bytes in the tiles kept in memory.
+ */
+int64_t
+CiftiMatrixTilePyramid::getNumberOfBytesInCache() const
+{
+    CaretMutexLocker locker(&m_mutex);
+    return m_numberOfBytesInCache;
+}
+
+/**
+ * Read a tile from the CIFTI file (level zero) or the sidecar file.
+ * Caller must hold the mutex.
+ *
+ * @param tileKey
+ *    Key of the tile.
+ * @param tileOut
+ *    Output with the tile's data and size.
+ * @param errorMessageOut
+ *    Describes the error if reading failed.
+ * @return
+ *    True if the tile was read.
+ */
+bool
+CiftiMatrixTilePyramid::readTileFromStorage(const TileKey& tileKey,
+                                            Tile& tileOut,
+                                            AString& errorMessageOut)
+{
+    const int32_t level = std::get<0>(tileKey);
+    const int64_t tileRow = std::get<1>(tileKey);
+    const int64_t tileColumn = std::get<2>(tileKey);
+    if ((level < 0)
+        || (level >= getNumberOfLevels())) {
+        errorMessageOut = ("Invalid matrix tile pyramid level " + AString::number(level));
+        return false;
+    }
+    const int64_t levelRows = getNumberOfRows(level);
+    const int64_t levelColumns = getNumberOfColumns(level);
+    const int64_t firstRow = tileRow * TILE_DIMENSION;
+    const int64_t firstColumn = tileColumn * TILE_DIMENSION;
+    if ((tileRow < 0)
+        || (tileColumn < 0)
+        || (firstRow >= levelRows)
+        || (firstColumn >= levelColumns)) {
+        errorMessageOut = ("Invalid matrix tile row="
+                           + AString::number(tileRow)
+                           + " column="
+                           + AString::number(tileColumn)
+                           + " at level "
+                           + AString::number(level));
+        return false;
+    }
+    tileOut.m_numberOfRows = std::min(static_cast<int64_t>(TILE_DIMENSION), levelRows - firstRow);
+    tileOut.m_numberOfColumns = std::min(static_cast<int64_t>(TILE_DIMENSION), levelColumns - firstColumn);
+    tileOut.m_data.resize(tileOut.m_numberOfRows * tileOut.m_numberOfColumns);
+    
+    if (level == 0) {
+        try {
+            std::vector<float> rowData(m_numberOfColumns);
+            for (int64_t i = 0; i < tileOut.m_numberOfRows; i++) {
+                m_ciftiFile->getRow(rowData.data(), firstRow + i);
+                std::memcpy(&tileOut.m_data[i * tileOut.m_numberOfColumns],
+                            &rowData[firstColumn],
+                            tileOut.m_numberOfColumns * sizeof(float));
+            }
+        }
+        catch (const DataFileException& dfe) {
+            errorMessageOut = dfe.whatString();
+            return false;
+        }
+        return true;
+    }
+    
+    const int64_t tileIndex = (tileRow * divideRoundUp(levelColumns, TILE_DIMENSION)) + tileColumn;
+    CaretAssertVectorIndex(m_tileOffsets[level], tileIndex);
+    const int64_t offset = m_tileOffsets[level][tileIndex];
+    const int64_t numberOfBytes = tileOut.m_data.size() * sizeof(float);
+    if ((offset < 0)
+        || ( ! m_sidecarFile.seek(offset))
+        || (m_sidecarFile.read(reinterpret_cast<char*>(tileOut.m_data.data()), numberOfBytes) != numberOfBytes)) {
+        errorMessageOut = ("Error reading tile from matrix tile pyramid " + m_sidecarFileName);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Add a tile to the cache, removing the least recently used tiles
+ * if the cache exceeds its size limit.  Caller must hold the mutex.
+ *
+ * @param tileKey
+ *    Key of the tile.
+ * @param tile
+ *    The tile, its data is moved into the cache.
+ */
+void
+CiftiMatrixTilePyramid::addTileToCache(const TileKey& tileKey,
+                                       Tile& tile)
+{
+    const int64_t tileBytes = tile.m_data.size() * sizeof(float);
+    while (( ! m_lruTileKeys.empty())
+           && ((m_numberOfBytesInCache + tileBytes) > MAXIMUM_CACHE_BYTES)) {
+        auto iter = m_tiles.find(m_lruTileKeys.back());
+        CaretAssert(iter != m_tiles.end());
+        m_numberOfBytesInCache -= iter->second.m_data.size() * sizeof(float);
+        m_tiles.erase(iter);
+        m_lruTileKeys.pop_back();
+    }
+    
+    m_lruTileKeys.push_front(tileKey);
+    tile.m_lruIter = m_lruTileKeys.begin();
+    m_tiles[tileKey] = std::move(tile);
+    m_numberOfBytesInCache += tileBytes;
+}
+
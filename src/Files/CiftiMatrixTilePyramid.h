@@ -0,0 +1,174 @@
+#ifndef __CIFTI_MATRIX_TILE_PYRAMID_H__
+#define __CIFTI_MATRIX_TILE_PYRAMID_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <list>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include <QFile>
+
+#include "AString.h"
+#include "CaretMutex.h"
+
+namespace caret {
+
+    class CiftiFile;
+
+    class CiftiMatrixTilePyramid {
+
+    public:
+        /** How a block of matrix cells is reduced to one cell of a coarser level */
+        enum class PoolingMode {
+            /** Mean of the finite values in the block */
+            MEAN,
+            /** Value with the largest magnitude in the block, keeping its sign */
+            MAXIMUM_MAGNITUDE
+        };
+
+        static std::unique_ptr<CiftiMatrixTilePyramid> openOrBuild(const CiftiFile* ciftiFile,
+                                                                   const AString& ciftiFileName,
+                                                                   const PoolingMode poolingMode,
+                                                                   AString& errorMessageOut);
+
+        ~CiftiMatrixTilePyramid();
+
+        CiftiMatrixTilePyramid(const CiftiMatrixTilePyramid&) = delete;
+
+        CiftiMatrixTilePyramid& operator=(const CiftiMatrixTilePyramid&) = delete;
+
+        static AString getSidecarFileName(const AString& ciftiFileName,
+                                          const PoolingMode poolingMode);
+
+        int32_t getNumberOfLevels() const;
+
+        int64_t getNumberOfRows(const int32_t level) const;
+
+        int64_t getNumberOfColumns(const int32_t level) const;
+
+        int32_t getLevelForCellsPerPixel(const double cellsPerPixel) const;
+
+        bool getTile(const int32_t level,
+                     const int64_t tileRow,
+                     const int64_t tileColumn,
+                     std::vector<float>& dataOut,
+                     int64_t& numberOfRowsOut,
+                     int64_t& numberOfColumnsOut,
+                     AString& errorMessageOut);
+
+        bool getRegion(const int32_t level,
+                       const int64_t firstRow,
+                       const int64_t firstColumn,
+                       const int64_t numberOfRows,
+                       const int64_t numberOfColumns,
+                       std::vector<float>& dataOut,
+                       AString& errorMessageOut);
+
+        int64_t getNumberOfBytesInCache() const;
+
+        /** Width and height of a tile in cells of its level */
+        static const int32_t TILE_DIMENSION;
+
+        /** Maximum size of the tiles kept in memory */
+        static const int64_t MAXIMUM_CACHE_BYTES;
+
+        // ADD_NEW_METHODS_HERE
+
+    private:
+        /** Key of a tile: level, tile row, tile column */
+        typedef std::tuple<int32_t, int64_t, int64_t> TileKey;
+
+        /** A tile and its position in the least recently used list */
+        class Tile {
+        public:
+            std::vector<float> m_data;
+
+            int64_t m_numberOfRows = 0;
+
+            int64_t m_numberOfColumns = 0;
+
+            std::list<TileKey>::iterator m_lruIter;
+        };
+
+        class LevelBuilder;
+
+        CiftiMatrixTilePyramid(const CiftiFile* ciftiFile,
+                               const AString& sidecarFileName);
+
+        bool readHeader(const int64_t sourceFileSize,
+                        const int64_t sourceModifiedTime,
+                        const PoolingMode poolingMode,
+                        AString& errorMessageOut);
+
+        bool build(const int64_t sourceFileSize,
+                   const int64_t sourceModifiedTime,
+                   const PoolingMode poolingMode,
+                   AString& errorMessageOut);
+
+        void computeLevelSizes();
+
+        bool readTileFromStorage(const TileKey& tileKey,
+                                 Tile& tileOut,
+                                 AString& errorMessageOut);
+
+        void addTileToCache(const TileKey& tileKey,
+                            Tile& tile);
+
+        const CiftiFile* m_ciftiFile;
+
+        const AString m_sidecarFileName;
+
+        int64_t m_numberOfRows = 0;
+
+        int64_t m_numberOfColumns = 0;
+
+        /** Rows and columns of each level, level zero is the full resolution matrix */
+        std::vector<std::pair<int64_t, int64_t>> m_levelSizes;
+
+        /** File offset of each stored tile, indexed by level then row-major tile index, level zero is read from the CIFTI file */
+        std::vector<std::vector<int64_t>> m_tileOffsets;
+
+        /** Protects all members below */
+        mutable CaretMutex m_mutex;
+
+        QFile m_sidecarFile;
+
+        std::map<TileKey, Tile> m_tiles;
+
+        /** Least recently used tile at back */
+        std::list<TileKey> m_lruTileKeys;
+
+        int64_t m_numberOfBytesInCache = 0;
+
+        // ADD_NEW_MEMBERS_HERE
+
+    };
+
+#ifdef __CIFTI_MATRIX_TILE_PYRAMID_DECLARE__
+    const int32_t CiftiMatrixTilePyramid::TILE_DIMENSION = 256;
+    const int64_t CiftiMatrixTilePyramid::MAXIMUM_CACHE_BYTES = 256 * 1024 * 1024;
+#endif // __CIFTI_MATRIX_TILE_PYRAMID_DECLARE__
+
+} // namespace
+#endif  //__CIFTI_MATRIX_TILE_PYRAMID_H__
@@ -34,6 +34,7 @@
 #include "CaretLogger.h"
 #include "CaretPreferences.h"
 #include "CziImage.h"
+#include "CziImageTileCache.h"
 #include "CziUtilities.h"
 #include "DataFileContentInformation.h"
 #include "DataFileException.h"
@@ -94,6 +95,11 @@ CziImageFile::CziImageFile()
 CziImageFile::~CziImageFile()
 {
     EventManager::get()->removeAllEventsFromListener(this);
+    
+    /*
+     * Tile cache's prefetch thread must finish before the reader is destroyed
+     */
+    m_tileCache.reset();
 }
 
 /**
@@ -225,6 +231,11 @@ CziImageFile::closeFile()
             break;
     }
     
+    /*
+     * Tile cache's prefetch thread uses the reader
+     */
+    m_tileCache.reset();
+    
     /*
      * Desctructors will close the files
      */
@@ -278,13 +289,18 @@ CziImageFile::readFile(const AString& filename)
         /*
          * If file does not exist, a std::exception is thrown
          */
-        m_stream = libCZI::CreateStreamFromFile(filename.toStdWString().c_str());
-        if ( ! m_stream) {
+        std::shared_ptr<libCZI::IStream> fileStream = libCZI::CreateStreamFromFile(filename.toStdWString().c_str());
+        if ( ! fileStream) {
             m_errorMessage = "Creating stream for reading CZI file failed.";
             m_status = Status::ERRORED;
             return;
         }
         
+        /*
+         * Tiles are read by several threads and the file stream is not thread safe
+         */
+        m_stream = CziImageTileCache::newSerializedStream(fileStream);
+        
         m_reader = libCZI::CreateCZIReader();
         if ( ! m_reader) {
             m_errorMessage = "Creating reader for reading CZI file failed.";
@@ -341,6 +357,8 @@ CziImageFile::readFile(const AString& filename)
             m_status = Status::ERRORED;
             return;
         }
+        m_tileCache.reset(new CziImageTileCache(m_pyramidLayerTileAccessor,
+                                                m_fullResolutionLogicalRect));
         
         
         m_scalingTileAccessor = m_reader->CreateSingleChannelScalingTileAccessor();
@@ -798,67 +816,61 @@ CziImageFile::readPyramidLayerFromCziImageFile(const int32_t pyramidLayer,
     CaretAssertVectorIndex(m_pyramidLayers, pyramidLayer);
     libCZI::ISingleChannelPyramidLayerTileAccessor::PyramidLayerInfo pyramidInfo = m_pyramidLayers[pyramidLayer].m_layerInfo;
     
-    libCZI::CDimCoordinate coordinate;
-    libCZI::IDimCoordinate* iDimCoord = &coordinate;
-    
-    libCZI::ISingleChannelPyramidLayerTileAccessor::Options scstaOptions;
-    scstaOptions.Clear();
-    scstaOptions.backGroundColor.r = 0.0;
-    scstaOptions.backGroundColor.g = 0.0;
-    scstaOptions.backGroundColor.b = 0.0;
-    
+    std::array<uint8_t, 3> backgroundRGB;
+    backgroundRGB.fill(0);
     EventCaretPreferencesGet prefsEvent;
     EventManager::get()->sendEvent(prefsEvent.getPointer());
     CaretPreferences* prefs = prefsEvent.getCaretPreferences();
     if (prefs != NULL) {
-        uint8_t backgroundColor[3];
-        prefs->getBackgroundAndForegroundColors()->getColorBackgroundMediaView(backgroundColor);
-        std::array<float, 3> rgb(BackgroundAndForegroundColors::toFloatRGB(backgroundColor));
-        scstaOptions.backGroundColor.r = rgb[0];
-        scstaOptions.backGroundColor.g = rgb[1];
-        scstaOptions.backGroundColor.b = rgb[2];
+        prefs->getBackgroundAndForegroundColors()->getColorBackgroundMediaView(backgroundRGB.data());
     }
     
     /*
-     * Read into 24 bit RGB to avoid conversion from other pixel formats
+     * Image is assembled from cached tiles and only tiles
+     * not in the cache are read from the file
      */
-    const libCZI::PixelType pixelType(libCZI::PixelType::Bgr24);
     const libCZI::IntRect intRectROI = CziUtilities::qRectToIntRect(logicalRectangleRegionRect);
-    CaretAssert(m_pyramidLayerTileAccessor);
+    CaretAssert(m_tileCache);
     const libCZI::IntRect rectToReadROI = CziUtilities::qRectToIntRect(rectangleForReadingRect);
-    std::shared_ptr<libCZI::IBitmapData> bitmapData;
-    try {
-        bitmapData = m_pyramidLayerTileAccessor->Get(pixelType,
-                                                     rectToReadROI,
-                                                     iDimCoord,
-                                                     pyramidInfo,
-                                                     &scstaOptions);
-    }
-    catch (std::out_of_range& e) {
-        errorMessageOut = ("Out of range exception: "
-                           + QString(e.exception::what())
-                           + " reading pyramid layer="
-                           + QString::number(pyramidInfo.pyramidLayerNo)
-                           + " for ROI="
-                           + CziUtilities::intRectToString(rectToReadROI));
-        return NULL;
-    }
-    
-    if ( ! bitmapData) {
-        errorMessageOut = "Failed to read data";
+    QImage* qImage = m_tileCache->readRegion(pyramidInfo,
+                                             rectToReadROI,
+                                             backgroundRGB,
+                                             errorMessageOut);
+    if (qImage == NULL) {
         return NULL;
     }
     
     CaretLogInfo("Request reading of :"
                  + CziUtilities::intRectToString(intRectROI)
                  + " and actually read width="
-                 + QString::number(bitmapData->GetWidth())
+                 + QString::number(qImage->width())
                  + ", height="
-                 + QString::number(bitmapData->GetHeight()));
-    QImage* qImage = createQImageFromBitmapData(bitmapData.get(),
-                                                errorMessageOut);
-    if (qImage == NULL) {
-        return NULL;
+                 + QString::number(qImage->height()));
+    
+    /*
+     * Prefetch tiles that are likely needed next: those around the region
+     * for panning and the center of the region in the next higher
+     * resolution layer for zooming.  For the highest resolution layer,
+     * the minification factor may still be zero (see readFile()) and
+     * reading it would cause the CZI library to loop forever.
+     */
+    m_tileCache->clearPrefetchRequests();
+    m_tileCache->prefetchRegion(pyramidInfo,
+                                rectToReadROI,
+                                1);
+    if ((pyramidLayer + 1) < numPyramidLayers) {
+        CaretAssertVectorIndex(m_pyramidLayers, pyramidLayer + 1);
+        const libCZI::ISingleChannelPyramidLayerTileAccessor::PyramidLayerInfo& higherResInfo = m_pyramidLayers[pyramidLayer + 1].m_layerInfo;
+        if (higherResInfo.minificationFactor > 0) {
+            libCZI::IntRect centerRect;
+            centerRect.x = rectToReadROI.x + (rectToReadROI.w / 4);
+            centerRect.y = rectToReadROI.y + (rectToReadROI.h / 4);
+            centerRect.w = rectToReadROI.w / 2;
+            centerRect.h = rectToReadROI.h / 2;
+            m_tileCache->prefetchRegion(higherResInfo,
+                                        centerRect,
+                                        0);
+        }
     }
     
     CziImage* cziImageOut = new CziImage(this,
@@ -49,6 +49,7 @@ class QImage;
 namespace caret {
 
     class CziImage;
+    class CziImageTileCache;
     class GraphicsObjectToWindowTransform;
     class Matrix4x4;
     class RectangleTransform;
@@ -310,6 +311,9 @@ namespace caret {
         
         std::shared_ptr<libCZI::ISingleChannelPyramidLayerTileAccessor> m_pyramidLayerTileAccessor;
         
+        /** Cache of decoded tiles read by m_pyramidLayerTileAccessor */
+        std::unique_ptr<CziImageTileCache> m_tileCache;
+        
         int32_t m_lowestResolutionPyramidLayerIndex = -1;
         
         int32_t m_highestResolutionPyramidLayerIndex = -1;
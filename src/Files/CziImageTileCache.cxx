@@ -0,0 +1,648 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#define __CZI_IMAGE_TILE_CACHE_DECLARE__
+#include "CziImageTileCache.h"
+#undef __CZI_IMAGE_TILE_CACHE_DECLARE__
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <QThread>
+
+#include "CaretAssert.h"
+#include "CaretOMP.h"
+#include "CziUtilities.h"
+
+using namespace caret;
+
+/**
+ * Runs the prefetching of tiles in a thread
+ */
+class CziImageTileCache::PrefetchThread : public QThread
+{
+public:
+    PrefetchThread(CziImageTileCache* tileCache)
+    : m_tileCache(tileCache) { }
+
+    void run() override {
+        m_tileCache->runPrefetchLoop();
+    }
+
+private:
+    CziImageTileCache* m_tileCache;
+};
+
+/**
+ * Stream that serializes reads of another stream.  The libCZI file stream
+ * performs a seek followed by a read so concurrent reads must not overlap.
+ */
+class CziImageTileCache::SerializedStream : public libCZI::IStream
+{
+public:
+    SerializedStream(std::shared_ptr<libCZI::IStream> stream)
+    : m_stream(stream) { }
+
+    void Read(std::uint64_t offset,
+              void* pv,
+              std::uint64_t size,
+              std::uint64_t* ptrBytesRead) override {
+        QMutexLocker locker(&m_readMutex);
+        m_stream->Read(offset, pv, size, ptrBytesRead);
+    }
+
+private:
+    std::shared_ptr<libCZI::IStream> m_stream;
+
+    QMutex m_readMutex;
+};
+
+/**
+ * \class caret::CziImageTileCache
+ * \brief Cache of decoded tiles from the pyramid layers of a CZI image file
+ * \ingroup Files
+ *
+ * Each pyramid layer is divided into square tiles that are aligned to the
+ * origin of the full resolution image.  A region is assembled from the
+ * tiles so that panning and zooming only decode tiles that are not in
+ * the cache, and missing tiles are decoded in parallel.  Tiles neighboring
+ * the last region and tiles in the next higher resolution layer may be
+ * decoded ahead of time by a prefetch thread.  The least recently used
+ * tiles are removed when the cache exceeds its size limit.
+ *
+ * Tiles are decoded by several threads at once and the libCZI file stream
+ * seeks and reads without locking, so the reader given to this cache must be
+ * opened on a stream from newSerializedStream().  The pyramid accessor
+ * otherwise only reads the sub-block directory after the file is opened.
+ */
+
+/**
+ * Constructor.
+ *
+ * @param pyramidLayerTileAccessor
+ *    Accessor for reading pyramid layers from the CZI file.
+ * @param fullResolutionLogicalRect
+ *    Logical rectangle of the full resolution image.
+ */
+CziImageTileCache::CziImageTileCache(std::shared_ptr<libCZI::ISingleChannelPyramidLayerTileAccessor> pyramidLayerTileAccessor,
+                                     const QRectF& fullResolutionLogicalRect)
+: m_pyramidLayerTileAccessor(pyramidLayerTileAccessor),
+m_fullResolutionLogicalRect(fullResolutionLogicalRect)
+{
+    CaretAssert(m_pyramidLayerTileAccessor);
+    m_backgroundRGB.fill(0);
+}
+
+/**
+ * Destructor.  Waits for the prefetch thread to finish since it
+ * uses the accessor that is closed with the CZI file.
+ */
+CziImageTileCache::~CziImageTileCache()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopPrefetchFlag = true;
+        m_prefetchRequests.clear();
+    }
+    m_prefetchWaitCondition.wakeAll();
+
+    if (m_prefetchThread) {
+        m_prefetchThread->wait();
+        m_prefetchThread.reset();
+    }
+}
+
+/**
+ * Read a region of a pyramid layer into an image.
+ *
+ * @param pyramidInfo
+ *    Info for the pyramid layer.
+ * @param logicalRect
+ *    Logical rectangle of the region.
+ * @param backgroundRGB
+ *    Color for regions outside of the image.
+ * @param errorMessageOut
+ *    Contains information about any errors.
+ * @return
+ *    Image containing the region (caller takes ownership) or NULL if error.
+ */
+QImage*
+CziImageTileCache::readRegion(const libCZI::ISingleChannelPyramidLayerTileAccessor::PyramidLayerInfo& pyramidInfo,
+                              const libCZI::IntRect& logicalRect,
+                              const std::array<uint8_t, 3>& backgroundRGB,
+                              AString& errorMessageOut)
+{
+    errorMessageOut.clear();
+
+    const int64_t pixelScale(getSizeOfPixelOnLayerZero(pyramidInfo));
+    if (pixelScale <= 0) {
+        errorMessageOut = ("Invalid minification factor for pyramid layer="
+                           + AString::number(pyramidInfo.pyramidLayerNo));
+        return NULL;
+    }
+    const int64_t width(logicalRect.w / pixelScale);
+    const int64_t height(logicalRect.h / pixelScale);
+    if ((width <= 0)
+        || (height <= 0)) {
+        errorMessageOut = ("Region has invalid width or height: "
+                           + CziUtilities::intRectToString(logicalRect));
+        return NULL;
+    }
+
+    {
+        /*
+         * Tiles are decoded with the background color so all
+         * tiles are invalid when the background color changes
+         */
+        QMutexLocker locker(&m_mutex);
+        if (backgroundRGB != m_backgroundRGB) {
+            m_tiles.clear();
+            m_lruTileKeys.clear();
+            m_numberOfBytesInCache = 0;
+            m_prefetchRequests.clear();
+            m_backgroundRGB = backgroundRGB;
+        }
+    }
+
+    /*
+     * Region in pixels of the pyramid layer with origin at
+     * the origin of the full resolution image
+     */
+    const int64_t firstPixelX(floorDivide(logicalRect.x - static_cast<int64_t>(m_fullResolutionLogicalRect.x()),
+                                          pixelScale));
+    const int64_t firstPixelY(floorDivide(logicalRect.y - static_cast<int64_t>(m_fullResolutionLogicalRect.y()),
+                                          pixelScale));
+    const int64_t firstTileX(floorDivide(firstPixelX, TILE_DIMENSION));
+    const int64_t lastTileX(floorDivide(firstPixelX + width - 1, TILE_DIMENSION));
+    const int64_t firstTileY(floorDivide(firstPixelY, TILE_DIMENSION));
+    const int64_t lastTileY(floorDivide(firstPixelY + height - 1, TILE_DIMENSION));
+
+    std::vector<TileKey> tileKeys;
+    for (int64_t tileY = firstTileY; tileY <= lastTileY; tileY++) {
+        for (int64_t tileX = firstTileX; tileX <= lastTileX; tileX++) {
+            const TileKey tileKey(pyramidInfo.pyramidLayerNo, tileX, tileY);
+            if (isTileInsideImage(tileKey, pixelScale)) {
+                tileKeys.push_back(tileKey);
+            }
+        }
+    }
+
+    const int64_t numTiles(tileKeys.size());
+    std::vector<QImage> tileImages(numTiles);
+    std::vector<int64_t> missingTileIndices;
+    for (int64_t i = 0; i < numTiles; i++) {
+        if ( ! getTileFromCache(tileKeys[i], tileImages[i])) {
+            missingTileIndices.push_back(i);
+        }
+    }
+
+    const int64_t numMissingTiles(missingTileIndices.size());
+    std::vector<AString> tileErrorMessages(numMissingTiles);
+#pragma omp CARET_PARFOR schedule(dynamic, 1)
+    for (int64_t m = 0; m < numMissingTiles; m++) {
+        const int64_t tileIndex(missingTileIndices[m]);
+        tileImages[tileIndex] = decodeTile(pyramidInfo,
+                                           tileKeys[tileIndex],
+                                           backgroundRGB,
+                                           tileErrorMessages[m]);
+    }
+
+    for (int64_t m = 0; m < numMissingTiles; m++) {
+        const int64_t tileIndex(missingTileIndices[m]);
+        if (tileImages[tileIndex].isNull()) {
+            errorMessageOut = tileErrorMessages[m];
+            return NULL;
+        }
+        addTileToCache(tileKeys[tileIndex],
+                       tileImages[tileIndex],
+                       backgroundRGB);
+    }
+
+    QImage* imageOut = new QImage(width,
+                                  height,
+                                  QImage::Format_ARGB32);
+    imageOut->fill(qRgb(backgroundRGB[0],
+                        backgroundRGB[1],
+                        backgroundRGB[2]));
+
+    /*
+     * Copy the part of each tile that overlaps the region
+     */
+    for (int64_t i = 0; i < numTiles; i++) {
+        const QImage& tileImage = tileImages[i];
+        const int64_t tilePixelX(std::get<1>(tileKeys[i]) * TILE_DIMENSION);
+        const int64_t tilePixelY(std::get<2>(tileKeys[i]) * TILE_DIMENSION);
+        const int64_t startX(std::max(firstPixelX, tilePixelX));
+        const int64_t endX(std::min(firstPixelX + width, tilePixelX + tileImage.width()));
+        const int64_t startY(std::max(firstPixelY, tilePixelY));
+        const int64_t endY(std::min(firstPixelY + height, tilePixelY + tileImage.height()));
+        if ((startX >= endX)
+            || (startY >= endY)) {
+            continue;
+        }
+
+        const int64_t numBytes((endX - startX) * 4);
+        for (int64_t y = startY; y < endY; y++) {
+            uchar* outputPtr = imageOut->scanLine(y - firstPixelY) + ((startX - firstPixelX) * 4);
+            const uchar* tilePtr = tileImage.constScanLine(y - tilePixelY) + ((startX - tilePixelX) * 4);
+            std::memcpy(outputPtr, tilePtr, numBytes);
+        }
+    }
+
+    return imageOut;
+}
+
+/**
+ * Request that tiles in and around a region of a pyramid layer are decoded
+ * by the prefetch thread.  Tiles closest to the center of the region are
+ * decoded first.
+ *
+ * @param pyramidInfo
+ *    Info for the pyramid layer.
+ * @param logicalRect
+ *    Logical rectangle of the region.
+ * @param numberOfRingTiles
+ *    Number of tiles added around the region.
+ */
+void
+CziImageTileCache::prefetchRegion(const libCZI::ISingleChannelPyramidLayerTileAccessor::PyramidLayerInfo& pyramidInfo,
+                                  const libCZI::IntRect& logicalRect,
+                                  const int32_t numberOfRingTiles)
+{
+    const int64_t pixelScale(getSizeOfPixelOnLayerZero(pyramidInfo));
+    if ((pixelScale <= 0)
+        || (logicalRect.w <= 0)
+        || (logicalRect.h <= 0)) {
+        return;
+    }
+
+    const int64_t firstPixelX(floorDivide(logicalRect.x - static_cast<int64_t>(m_fullResolutionLogicalRect.x()),
+                                          pixelScale));
+    const int64_t firstPixelY(floorDivide(logicalRect.y - static_cast<int64_t>(m_fullResolutionLogicalRect.y()),
+                                          pixelScale));
+    const int64_t lastPixelX(firstPixelX + std::max(logicalRect.w / pixelScale, static_cast<int64_t>(1)) - 1);
+    const int64_t lastPixelY(firstPixelY + std::max(logicalRect.h / pixelScale, static_cast<int64_t>(1)) - 1);
+    const int64_t firstTileX(floorDivide(firstPixelX, TILE_DIMENSION) - numberOfRingTiles);
+    const int64_t lastTileX(floorDivide(lastPixelX, TILE_DIMENSION) + numberOfRingTiles);
+    const int64_t firstTileY(floorDivide(firstPixelY, TILE_DIMENSION) - numberOfRingTiles);
+    const int64_t lastTileY(floorDivide(lastPixelY, TILE_DIMENSION) + numberOfRingTiles);
+    const float centerTileX((firstTileX + lastTileX) / 2.0f);
+    const float centerTileY((firstTileY + lastTileY) / 2.0f);
+
+    std::vector<std::pair<float, TileKey>> distanceAndTileKeys;
+    for (int64_t tileY = firstTileY; tileY <= lastTileY; tileY++) {
+        for (int64_t tileX = firstTileX; tileX <= lastTileX; tileX++) {
+            const TileKey tileKey(pyramidInfo.pyramidLayerNo, tileX, tileY);
+            if (isTileInsideImage(tileKey, pixelScale)) {
+                const float dx(tileX - centerTileX);
+                const float dy(tileY - centerTileY);
+                distanceAndTileKeys.push_back(std::make_pair((dx * dx) + (dy * dy),
+                                                             tileKey));
+            }
+        }
+    }
+    std::sort(distanceAndTileKeys.begin(),
+              distanceAndTileKeys.end());
+
+    QMutexLocker locker(&m_mutex);
+    if (m_stopPrefetchFlag) {
+        return;
+    }
+
+    for (const auto& dt : distanceAndTileKeys) {
+        if (static_cast<int32_t>(m_prefetchRequests.size()) >= MAXIMUM_PREFETCH_REQUESTS) {
+            break;
+        }
+        if (m_tiles.find(dt.second) != m_tiles.end()) {
+            continue;
+        }
+        PrefetchRequest request;
+        request.m_pyramidInfo = pyramidInfo;
+        request.m_tileKey     = dt.second;
+        m_prefetchRequests.push_back(request);
+    }
+
+    if (m_prefetchRequests.empty()) {
+        return;
+    }
+
+    if ( ! m_prefetchThread) {
+        m_prefetchThread.reset(new PrefetchThread(this));
+        m_prefetchThread->start(QThread::LowPriority);
+    }
+    m_prefetchWaitCondition.wakeAll();
+}
+
+/**
+ * Remove all prefetch requests that have not started.  Used when the
+ * user navigates so that tiles for old regions are not decoded.
+ */
+void
+CziImageTileCache::clearPrefetchRequests()
+{
+    QMutexLocker locker(&m_mutex);
+    m_prefetchRequests.clear();
+}
+
+/**
+ * @return Number of bytes used by the decoded tiles in the cache
+ */
+int64_t
+CziImageTileCache::getNumberOfBytesInCache() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_numberOfBytesInCache;
+}
+
+/**
+ * Create a stream that serializes reads so that the libCZI reader opened on it
+ * may be used by the tile decoding threads, the prefetch thread, and the
+ * main thread at the same time.
+ *
+ * @param stream
+ *    Stream for reading the CZI file.
+ * @return
+ *    Stream that reads from the given stream while holding a mutex.
+ */
+std::shared_ptr<libCZI::IStream>
+CziImageTileCache::newSerializedStream(std::shared_ptr<libCZI::IStream> stream)
+{
+    CaretAssert(stream);
+    return std::shared_ptr<libCZI::IStream>(new SerializedStream(stream));
+}
+
+/**
+ * Loop run by the prefetch thread that decodes requested tiles
+ * until the cache is destroyed.
+ */
+void
+CziImageTileCache::runPrefetchLoop()
+{
+    while (true) {
+        PrefetchRequest request;
+        std::array<uint8_t, 3> backgroundRGB;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_prefetchRequests.empty()
+                   && ( ! m_stopPrefetchFlag)) {
+                m_prefetchWaitCondition.wait(&m_mutex);
+            }
+            if (m_stopPrefetchFlag) {
+                return;
+            }
+
+            request = m_prefetchRequests.front();
+            m_prefetchRequests.pop_front();
+            if (m_tiles.find(request.m_tileKey) != m_tiles.end()) {
+                continue;
+            }
+            backgroundRGB = m_backgroundRGB;
+        }
+
+        AString errorMessage;
+        const QImage image(decodeTile(request.m_pyramidInfo,
+                                      request.m_tileKey,
+                                      backgroundRGB,
+                                      errorMessage));
+        if ( ! image.isNull()) {
+            addTileToCache(request.m_tileKey,
+                           image,
+                           backgroundRGB);
+        }
+    }
+}
+
+/**
+ * This function is the same as CziImageFile::CalcSizeOfPixelOnLayer0().
+ *
+ * @param pyramidInfo
+ *    Info for the pyramid layer.
+ * @return
+ *    Size of a pixel on the pyramid layer in pixels on the full resolution layer.
+ */
+int64_t
+CziImageTileCache::getSizeOfPixelOnLayerZero(const libCZI::ISingleChannelPyramidLayerTileAccessor::PyramidLayerInfo& pyramidInfo)
+{
+    int64_t f(1);
+    for (int32_t i = 0; i < pyramidInfo.pyramidLayerNo; i++) {
+        f *= pyramidInfo.minificationFactor;
+    }
+    return f;
+}
+
+/**
+ * @return Numerator divided by the positive denominator rounded toward negative infinity
+ * @param numerator
+ *    The numerator.
+ * @param denominator
+ *    The denominator.
+ */
+int64_t
+CziImageTileCache::floorDivide(const int64_t numerator,
+                               const int64_t denominator)
+{
+    CaretAssert(denominator > 0);
+    int64_t quotient(numerator / denominator);
+    if ((numerator % denominator) < 0) {
+        --quotient;
+    }
+    return quotient;
+}
+
+/**
+ * @return True if the tile overlaps the full resolution image.
+ * @param tileKey
+ *    Key of the tile.
+ * @param pixelScale
+ *    Size of a pixel on the tile's pyramid layer in full resolution pixels.
+ */
+bool
+CziImageTileCache::isTileInsideImage(const TileKey& tileKey,
+                                     const int64_t pixelScale) const
+{
+    const int64_t tileLogicalSize(TILE_DIMENSION * pixelScale);
+    const QRectF tileRect(m_fullResolutionLogicalRect.x() + (std::get<1>(tileKey) * tileLogicalSize),
+                          m_fullResolutionLogicalRect.y() + (std::get<2>(tileKey) * tileLogicalSize),
+                          tileLogicalSize,
+                          tileLogicalSize);
+    return m_fullResolutionLogicalRect.intersects(tileRect);
+}
+
+/**
+ * Read a tile from the CZI file.  May be called from any thread.
+ *
+ * @param pyramidInfo
+ *    Info for the pyramid layer.
+ * @param tileKey
+ *    Key of the tile.
+ * @param backgroundRGB
+ *    Color for regions outside of the image.
+ * @param errorMessageOut
+ *    Contains information about any errors.
+ * @return
+ *    Image containing the tile; null image if error.
+ */
+QImage
+CziImageTileCache::decodeTile(const libCZI::ISingleChannelPyramidLayerTileAccessor::PyramidLayerInfo& pyramidInfo,
+                              const TileKey& tileKey,
+                              const std::array<uint8_t, 3>& backgroundRGB,
+                              AString& errorMessageOut) const
+{
+    const int64_t tileLogicalSize(TILE_DIMENSION * getSizeOfPixelOnLayerZero(pyramidInfo));
+    libCZI::IntRect tileRect;
+    tileRect.x = static_cast<int32_t>(static_cast<int64_t>(m_fullResolutionLogicalRect.x())
+                                      + (std::get<1>(tileKey) * tileLogicalSize));
+    tileRect.y = static_cast<int32_t>(static_cast<int64_t>(m_fullResolutionLogicalRect.y())
+                                      + (std::get<2>(tileKey) * tileLogicalSize));
+    tileRect.w = static_cast<int32_t>(tileLogicalSize);
+    tileRect.h = static_cast<int32_t>(tileLogicalSize);
+
+    libCZI::CDimCoordinate coordinate;
+    libCZI::ISingleChannelPyramidLayerTileAccessor::Options options;
+    options.Clear();
+    options.backGroundColor.r = backgroundRGB[0] / 255.0f;
+    options.backGroundColor.g = backgroundRGB[1] / 255.0f;
+    options.backGroundColor.b = backgroundRGB[2] / 255.0f;
+
+    /*
+     * Read into 24 bit RGB to avoid conversion from other pixel formats
+     */
+    std::shared_ptr<libCZI::IBitmapData> bitmapData;
+    try {
+        bitmapData = m_pyramidLayerTileAccessor->Get(libCZI::PixelType::Bgr24,
+                                                     tileRect,
+                                                     &coordinate,
+                                                     pyramidInfo,
+                                                     &options);
+    }
+    catch (std::exception& e) {
+        errorMessageOut = ("Exception: "
+                           + QString(e.what())
+                           + " reading pyramid layer="
+                           + QString::number(pyramidInfo.pyramidLayerNo)
+                           + " for tile="
+                           + CziUtilities::intRectToString(tileRect));
+        return QImage();
+    }
+
+    if ( ! bitmapData) {
+        errorMessageOut = "Failed to read data";
+        return QImage();
+    }
+    if (bitmapData->GetPixelType() != libCZI::PixelType::Bgr24) {
+        errorMessageOut = "Only pixel type Bgr24 is supported";
+        return QImage();
+    }
+    const int32_t width(bitmapData->GetWidth());
+    const int32_t height(bitmapData->GetHeight());
+    if ((width <= 0)
+        || (height <= 0)) {
+        errorMessageOut = "data has invalid width or height";
+        return QImage();
+    }
+
+    QImage image(width,
+                 height,
+                 QImage::Format_ARGB32);
+    libCZI::BitmapLockInfo bitMapInfo = bitmapData->Lock();
+    const uint8_t* cziPtr8 = static_cast<const uint8_t*>(bitMapInfo.ptrDataRoi);
+    for (int32_t y = 0; y < height; y++) {
+        const uint8_t* cziRow = cziPtr8 + (y * bitMapInfo.stride);
+        QRgb* rgbScanLine = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int32_t x = 0; x < width; x++) {
+            const uint8_t* bgr = cziRow + (x * 3);
+            rgbScanLine[x] = qRgb(bgr[2], bgr[1], bgr[0]);
+        }
+    }
+    bitmapData->Unlock();
+
+    return image;
+}
+
+/**
+ * Get a tile from the cache and make it the most recently used tile.
+ *
+ * @param tileKey
+ *    Key of the tile.
+ * @param imageOut
+ *    Output with the tile's image.
+ * @return
+ *    True if the tile is in the cache.
+ */
+bool
+CziImageTileCache::getTileFromCache(const TileKey& tileKey,
+                                    QImage& imageOut)
+{
+    QMutexLocker locker(&m_mutex);
+    auto iter = m_tiles.find(tileKey);
+    if (iter == m_tiles.end()) {
+        return false;
+    }
+
+    m_lruTileKeys.splice(m_lruTileKeys.begin(),
+                         m_lruTileKeys,
+                         iter->second.m_lruIter);
+    imageOut = iter->second.m_image;
+    return true;
+}
+
+/**
+ * Add a tile to the cache and remove least recently used tiles
+ * if the cache exceeds its size limit.
+ *
+ * @param tileKey
+ *    Key of the tile.
+ * @param image
+ *    Image of the tile.
+ * @param backgroundRGB
+ *    Background color used when the tile was decoded.  The tile is
+ *    discarded if the background color has since changed.
+ */
+void
+CziImageTileCache::addTileToCache(const TileKey& tileKey,
+                                  const QImage& image,
+                                  const std::array<uint8_t, 3>& backgroundRGB)
+{
+    QMutexLocker locker(&m_mutex);
+    if (backgroundRGB != m_backgroundRGB) {
+        return;
+    }
+    if (m_tiles.find(tileKey) != m_tiles.end()) {
+        return;
+    }
+
+    m_lruTileKeys.push_front(tileKey);
+    Tile& tile = m_tiles[tileKey];
+    tile.m_image   = image;
+    tile.m_lruIter = m_lruTileKeys.begin();
+    m_numberOfBytesInCache += static_cast<int64_t>(image.bytesPerLine()) * image.height();
+
+    while ((m_numberOfBytesInCache > MAXIMUM_CACHE_BYTES)
+           && (m_lruTileKeys.size() > 1)) {
+        auto oldestIter = m_tiles.find(m_lruTileKeys.back());
+        CaretAssert(oldestIter != m_tiles.end());
+        const QImage& oldestImage = oldestIter->second.m_image;
+        m_numberOfBytesInCache -= static_cast<int64_t>(oldestImage.bytesPerLine()) * oldestImage.height();
+        m_tiles.erase(oldestIter);
+        m_lruTileKeys.pop_back();
+    }
+}
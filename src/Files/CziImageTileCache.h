@@ -0,0 +1,162 @@
+#ifndef __CZI_IMAGE_TILE_CACHE_H__
+#define __CZI_IMAGE_TILE_CACHE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <array>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <tuple>
+
+#include <QImage>
+#include <QMutex>
+#include <QRectF>
+#include <QWaitCondition>
+
+#include "AString.h"
+#include "SingleChannelPyramidLevelTileAccessor.h"
+
+namespace caret {
+
+    class CziImageTileCache {
+
+    public:
+        CziImageTileCache(std::shared_ptr<libCZI::ISingleChannelPyramidLayerTileAccessor> pyramidLayerTileAccessor,
+                          const QRectF& fullResolutionLogicalRect);
+
+        ~CziImageTileCache();
+
+        CziImageTileCache(const CziImageTileCache&) = delete;
+
+        CziImageTileCache& operator=(const CziImageTileCache&) = delete;
+
+        QImage* readRegion(const libCZI::ISingleChannelPyramidLayerTileAccessor::PyramidLayerInfo& pyramidInfo,
+                           const libCZI::IntRect& logicalRect,
+                           const std::array<uint8_t, 3>& backgroundRGB,
+                           AString& errorMessageOut);
+
+        void prefetchRegion(const libCZI::ISingleChannelPyramidLayerTileAccessor::PyramidLayerInfo& pyramidInfo,
+                            const libCZI::IntRect& logicalRect,
+                            const int32_t numberOfRingTiles);
+
+        void clearPrefetchRequests();
+
+        int64_t getNumberOfBytesInCache() const;
+
+        static std::shared_ptr<libCZI::IStream> newSerializedStream(std::shared_ptr<libCZI::IStream> stream);
+
+        /** Width and height of a tile in pixels of its pyramid layer */
+        static const int32_t TILE_DIMENSION;
+
+        /** Maximum size of the decoded tiles kept in the cache */
+        static const int64_t MAXIMUM_CACHE_BYTES;
+
+        /** Maximum number of tiles waiting to be prefetched */
+        static const int32_t MAXIMUM_PREFETCH_REQUESTS;
+
+        // ADD_NEW_METHODS_HERE
+
+    private:
+        class PrefetchThread;
+
+        class SerializedStream;
+
+        /** Key of a tile: pyramid layer number, tile column, tile row */
+        typedef std::tuple<int32_t, int64_t, int64_t> TileKey;
+
+        /** A tile waiting to be prefetched */
+        class PrefetchRequest {
+        public:
+            libCZI::ISingleChannelPyramidLayerTileAccessor::PyramidLayerInfo m_pyramidInfo;
+
+            TileKey m_tileKey;
+        };
+
+        /** A decoded tile and its position in the least recently used list */
+        class Tile {
+        public:
+            QImage m_image;
+
+            std::list<TileKey>::iterator m_lruIter;
+        };
+
+        static int64_t getSizeOfPixelOnLayerZero(const libCZI::ISingleChannelPyramidLayerTileAccessor::PyramidLayerInfo& pyramidInfo);
+
+        static int64_t floorDivide(const int64_t numerator,
+                                   const int64_t denominator);
+
+        bool isTileInsideImage(const TileKey& tileKey,
+                               const int64_t pixelScale) const;
+
+        QImage decodeTile(const libCZI::ISingleChannelPyramidLayerTileAccessor::PyramidLayerInfo& pyramidInfo,
+                          const TileKey& tileKey,
+                          const std::array<uint8_t, 3>& backgroundRGB,
+                          AString& errorMessageOut) const;
+
+        bool getTileFromCache(const TileKey& tileKey,
+                              QImage& imageOut);
+
+        void addTileToCache(const TileKey& tileKey,
+                            const QImage& image,
+                            const std::array<uint8_t, 3>& backgroundRGB);
+
+        void runPrefetchLoop();
+
+        std::shared_ptr<libCZI::ISingleChannelPyramidLayerTileAccessor> m_pyramidLayerTileAccessor;
+
+        const QRectF m_fullResolutionLogicalRect;
+
+        /** Protects all members below */
+        mutable QMutex m_mutex;
+
+        QWaitCondition m_prefetchWaitCondition;
+
+        std::map<TileKey, Tile> m_tiles;
+
+        /** Least recently used tile at back */
+        std::list<TileKey> m_lruTileKeys;
+
+        int64_t m_numberOfBytesInCache = 0;
+
+        /** Background color of the cached tiles */
+        std::array<uint8_t, 3> m_backgroundRGB;
+
+        /** Prefetch requests with the most important at front */
+        std::deque<PrefetchRequest> m_prefetchRequests;
+
+        bool m_stopPrefetchFlag = false;
+
+        std::unique_ptr<PrefetchThread> m_prefetchThread;
+
+        // ADD_NEW_MEMBERS_HERE
+
+    };
+
+#ifdef __CZI_IMAGE_TILE_CACHE_DECLARE__
+    const int32_t CziImageTileCache::TILE_DIMENSION = 512;
+    const int64_t CziImageTileCache::MAXIMUM_CACHE_BYTES = 512 * 1024 * 1024;
+    const int32_t CziImageTileCache::MAXIMUM_PREFETCH_REQUESTS = 128;
+#endif // __CZI_IMAGE_TILE_CACHE_DECLARE__
+
+} // namespace
+#endif  //__CZI_IMAGE_TILE_CACHE_H__
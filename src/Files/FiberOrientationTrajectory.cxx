@@ -130,6 +130,55 @@ FiberOrientationTrajectory::setFiberFractions(const FiberFractions& fiberFractio
     m_fiberFractionTotalCountFloat = m_fiberFraction->totalCount;
 }
 
+/**
+ * Set a fiber fraction from decoded values, without needing a
+ * FiberFractions for each element of a row.
+ *
+ * @param totalCount
+ *    Total number of streamlines.
+ * @param fiberFractions
+ *    Fraction of the total count for each of the three fibers.
+ * @param distance
+ *    Average distance from seed.
+ */
+void
+FiberOrientationTrajectory::setFiberFractions(const uint32_t totalCount,
+                                              const float fiberFractions[3],
+                                              const float distance)
+{
+    m_fiberFraction->totalCount = totalCount;
+    m_fiberFraction->fiberFractions.assign(fiberFractions,
+                                           fiberFractions + 3);
+    m_fiberFraction->distance = distance;
+    m_fiberFractionTotalCountFloat = totalCount;
+}
+
+/**
+ * Replace the sums used for averaging with sums that were accumulated
+ * elsewhere, call finishAveraging() afterwards.
+ *
+ * @param totalCountSum
+ *    Sum of the total counts.
+ * @param fiberCountsSum
+ *    Sum of each fiber fraction times its total count, empty if no
+ *    fiber fractions had a nonzero total count.
+ * @param distanceSum
+ *    Sum of the distances.
+ * @param countForAveraging
+ *    Number of fiber fractions in the sums, including those with zero total count.
+ */
+void
+FiberOrientationTrajectory::setSumsForAveraging(const double totalCountSum,
+                                                const std::vector<double>& fiberCountsSum,
+                                                const double distanceSum,
+                                                const int64_t countForAveraging)
+{
+    m_totalCountSum = totalCountSum;
+    m_fiberCountsSum = fiberCountsSum;
+    m_distanceSum = distanceSum;
+    m_countForAveraging = countForAveraging;
+}
+
 /**
  * Finish, which will update the fiber fraction using the average of all
  * of the fiber fractions that were added.
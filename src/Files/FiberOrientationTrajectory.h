@@ -43,6 +43,15 @@ namespace caret {
         
         void setFiberFractions(const FiberFractions& fiberFraction);
         
+        void setFiberFractions(const uint32_t totalCount,
+                               const float fiberFractions[3],
+                               const float distance);
+        
+        void setSumsForAveraging(const double totalCountSum,
+                                 const std::vector<double>& fiberCountsSum,
+                                 const double distanceSum,
+                                 const int64_t countForAveraging);
+        
         /**
          * @return the Fiber Orientation.
          */
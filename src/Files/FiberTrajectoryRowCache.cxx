@@ -0,0 +1,135 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "FiberTrajectoryRowCache.h"
+
+#include "CaretAssert.h"
+#include "CaretSparseFile.h"
+
+using namespace caret;
+using namespace std;
+
+int64_t DecodedFiberRow::getMemoryUsage() const
+{
+    return getNumberOfEntries() * (sizeof(int64_t) + sizeof(uint32_t) + 4 * sizeof(float)) + sizeof(DecodedFiberRow);
+}
+
+FiberTrajectoryRowCache::FiberTrajectoryRowCache(CaretSparseFile* sparseFile, const int64_t& maxBytes)
+{
+    CaretAssert(sparseFile != NULL);
+    m_sparseFile = sparseFile;
+    m_maxBytes = maxBytes;
+    m_currentBytes = 0;
+}
+
+const DecodedFiberRow& FiberTrajectoryRowCache::getRow(const int64_t& rowIndex)
+{
+    map<int64_t, CacheEntry>::iterator iter = m_rows.find(rowIndex);
+    if (iter != m_rows.end())
+    {
+        m_useOrder.splice(m_useOrder.begin(), m_useOrder, iter->second.m_useIter);
+        return *(iter->second.m_row);
+    }
+    m_sparseFile->getRowSparse(rowIndex, m_scratchIndices, m_scratchValues);
+    CaretPointer<DecodedFiberRow> newRow(new DecodedFiberRow());
+    int64_t numEntries = (int64_t)m_scratchIndices.size();
+    newRow->m_indices = m_scratchIndices;
+    newRow->m_totalCount.resize(numEntries);
+    for (int i = 0; i < 3; ++i)
+    {
+        newRow->m_fractions[i].resize(numEntries);
+    }
+    newRow->m_distance.resize(numEntries);
+    if (numEntries > 0)
+    {
+        CaretSparseFile::decodeFibersBlock((const uint64_t*)m_scratchValues.data(), numEntries, newRow->m_totalCount.data(),
+                                           newRow->m_fractions[0].data(), newRow->m_fractions[1].data(), newRow->m_fractions[2].data(), newRow->m_distance.data());
+    }
+    m_useOrder.push_front(rowIndex);
+    CacheEntry& newEntry = m_rows[rowIndex];
+    newEntry.m_row = newRow;
+    newEntry.m_useIter = m_useOrder.begin();
+    m_currentBytes += newRow->getMemoryUsage();
+    while (m_currentBytes > m_maxBytes && m_useOrder.size() > 1)
+    {
+        map<int64_t, CacheEntry>::iterator evict = m_rows.find(m_useOrder.back());
+        CaretAssert(evict != m_rows.end());
+        m_currentBytes -= evict->second.m_row->getMemoryUsage();
+        m_rows.erase(evict);
+        m_useOrder.pop_back();
+    }
+    return *newRow;
+}
+
+void FiberTrajectoryRowCache::clear()
+{
+    m_rows.clear();
+    m_useOrder.clear();
+    m_currentBytes = 0;
+}
+
+void FiberTrajectoryRowAverager::reset(const int64_t& numColumns)
+{
+    m_numColumns = numColumns;
+    m_rows.clear();
+    m_totalCountSum.assign(numColumns, 0.0);
+    for (int i = 0; i < 3; ++i)
+    {
+        m_fractionCountSum[i].assign(numColumns, 0.0);
+    }
+    m_distanceSum.assign(numColumns, 0.0);
+    m_hasCounts.assign(numColumns, 0);
+}
+
+void FiberTrajectoryRowAverager::addRow(const int64_t& rowIndex, const DecodedFiberRow& row)
+{
+    int64_t numEntries = row.getNumberOfEntries();
+    for (int64_t i = 0; i < numEntries; ++i)
+    {
+        uint32_t totalCount = row.m_totalCount[i];
+        if (totalCount == 0) continue;//zero rows only count toward the number of rows, like FiberOrientationTrajectory::addFiberFractionsForAveraging
+        int64_t column = row.m_indices[i];
+        CaretAssert(column >= 0 && column < m_numColumns);
+        m_totalCountSum[column] += totalCount;
+        for (int j = 0; j < 3; ++j)
+        {
+            m_fractionCountSum[j][column] += row.m_fractions[j][i] * totalCount;
+        }
+        m_distanceSum[column] += row.m_distance[i];
+        m_hasCounts[column] = 1;
+    }
+    m_rows.insert(rowIndex);
+}
+
+void FiberTrajectoryRowAverager::getSums(const int64_t& column, double& totalCountSumOut, vector<double>& fiberCountSumOut, double& distanceSumOut) const
+{
+    CaretAssert(column >= 0 && column < m_numColumns);
+    totalCountSumOut = m_totalCountSum[column];
+    distanceSumOut = m_distanceSum[column];
+    fiberCountSumOut.clear();
+    if (m_hasCounts[column])
+    {
+        fiberCountSumOut.resize(3);
+        for (int j = 0; j < 3; ++j)
+        {
+            fiberCountSumOut[j] = m_fractionCountSum[j][column];
+        }
+    }
+}
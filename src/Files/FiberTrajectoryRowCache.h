@@ -0,0 +1,95 @@
+#ifndef __FIBER_TRAJECTORY_ROW_CACHE_H__
+#define __FIBER_TRAJECTORY_ROW_CACHE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretPointer.h"
+
+#include <list>
+#include <map>
+#include <set>
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+
+    class CaretSparseFile;
+
+    ///sparse trajectory row decoded into separate arrays, without a vector allocation per element
+    struct DecodedFiberRow
+    {
+        std::vector<int64_t> m_indices;
+        std::vector<uint32_t> m_totalCount;
+        std::vector<float> m_fractions[3], m_distance;
+
+        int64_t getNumberOfEntries() const { return (int64_t)m_indices.size(); }
+        int64_t getMemoryUsage() const;
+    };
+
+    ///least recently used cache of decoded trajectory rows, so that clicking around in the viewer doesn't reread and redecode rows
+    class FiberTrajectoryRowCache
+    {
+        CaretSparseFile* m_sparseFile;//not owned
+        int64_t m_maxBytes, m_currentBytes;
+        std::list<int64_t> m_useOrder;//most recent first
+        struct CacheEntry
+        {
+            CaretPointer<DecodedFiberRow> m_row;
+            std::list<int64_t>::iterator m_useIter;
+        };
+        std::map<int64_t, CacheEntry> m_rows;
+        std::vector<int64_t> m_scratchIndices, m_scratchValues;
+        FiberTrajectoryRowCache(const FiberTrajectoryRowCache&);
+        FiberTrajectoryRowCache& operator=(const FiberTrajectoryRowCache&);
+    public:
+        FiberTrajectoryRowCache(CaretSparseFile* sparseFile, const int64_t& maxBytes = (int64_t)256 * 1024 * 1024);
+
+        ///the reference is valid until the next call to getRow, the most recently used row is never evicted
+        ///same entries as CaretSparseFile::getFibersRowSparse, callers use the arrays directly rather than a FiberFractions per entry
+        const DecodedFiberRow& getRow(const int64_t& rowIndex);
+
+        void clear();
+    };
+
+    ///running sums for averaging trajectory rows, with the same result as FiberOrientationTrajectory averaging of full rows
+    ///keeps which rows it has, so a grown selection (such as an enlarged ROI) only needs the new rows added
+    class FiberTrajectoryRowAverager
+    {
+        int64_t m_numColumns;
+        std::multiset<int64_t> m_rows;//the same row may be selected more than once
+        std::vector<double> m_totalCountSum, m_fractionCountSum[3], m_distanceSum;
+        std::vector<char> m_hasCounts;//whether any row had a nonzero total count for this column
+    public:
+        FiberTrajectoryRowAverager() { m_numColumns = 0; }
+
+        void reset(const int64_t& numColumns);
+        void addRow(const int64_t& rowIndex, const DecodedFiberRow& row);
+
+        int64_t getNumberOfColumns() const { return m_numColumns; }
+        const std::multiset<int64_t>& getRows() const { return m_rows; }
+
+        ///fiberCountSumOut is left empty for columns that no row had data for
+        void getSums(const int64_t& column, double& totalCountSumOut, std::vector<double>& fiberCountSumOut, double& distanceSumOut) const;
+    };
+
+}
+
+#endif //__FIBER_TRAJECTORY_ROW_CACHE_H__
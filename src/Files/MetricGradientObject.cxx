@@ -0,0 +1,220 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "MetricGradientObject.h"
+
+#include "CaretAssert.h"
+#include "CaretOMP.h"
+#include "FloatMatrix.h"
+#include "SurfaceFile.h"
+#include "TopologyHelper.h"
+#include "Vector3D.h"
+
+#include <cmath>
+
+using namespace std;
+using namespace caret;
+
+MetricGradientObject::RegressionAreas::RegressionAreas(const SurfaceFile* mySurf, const float* correctedAreas)
+{
+    if (correctedAreas != NULL)
+    {
+        int32_t numNodes = mySurf->getNumberOfNodes();
+        m_sqrtCorrAreas.resize(numNodes);
+        mySurf->computeNodeAreas(m_sqrtVertAreas);
+        for (int32_t i = 0; i < numNodes; ++i)
+        {
+            m_sqrtCorrAreas[i] = sqrt(correctedAreas[i]);
+            m_sqrtVertAreas[i] = sqrt(m_sqrtVertAreas[i]);
+        }
+        m_areas = correctedAreas;
+    } else {
+        mySurf->computeNodeAreas(m_areaData);
+        m_areas = m_areaData.data();
+    }
+}
+
+void MetricGradientObject::getTangentBasis(const Vector3D& normal, Vector3D& xhatOut, Vector3D& yhatOut)
+{
+    Vector3D somevec;
+    if (abs(normal[0]) > abs(normal[1]))
+    {//generate a vector not parallel to normal
+        somevec[1] = 1.0;
+    } else {
+        somevec[0] = 1.0;
+    }
+    xhatOut = normal.cross(somevec).normal();
+    yhatOut = normal.cross(xhatOut).normal();//xhat, yhat are orthogonal unit vectors describing a coord system with k = surface normal
+}
+
+void MetricGradientObject::projectNeighbor(const Vector3D& offset, const Vector3D& normal, const Vector3D& xhat, const Vector3D& yhat, const float& distScale,
+                                           float& xmagOut, float& ymagOut, float& unrollMagOut, float& mag2dOut)
+{
+    float origMag = offset.length();
+    unrollMagOut = origMag;
+    float opposite = offset.dot(normal);//check for division by close to zero
+    if (abs(opposite) > 0.035f * origMag)//do not do unrolling on very small angles - this is ~2 degrees
+    {
+        unrollMagOut = origMag * asin(opposite / origMag) * origMag / opposite;
+    }
+    unrollMagOut *= distScale;
+    xmagOut = xhat.dot(offset);//dot product to get the direction in 2d
+    ymagOut = yhat.dot(offset);
+    mag2dOut = sqrt(xmagOut * xmagOut + ymagOut * ymagOut);
+}
+
+MetricGradientObject::MetricGradientObject(SurfaceFile* mySurf, const float* roiValues, const float* correctedAreas)
+{
+    CaretAssert(mySurf != NULL);
+    int32_t numNodes = mySurf->getNumberOfNodes();
+    m_stencils.resize(numNodes);
+    mySurf->computeNormals();
+    const float* myNormals = mySurf->getNormalData();
+    const float* myCoords = mySurf->getCoordinateData();
+    const RegressionAreas myAreas(mySurf, correctedAreas);
+    const float* vertAreas = myAreas.getAreas();
+#pragma omp CARET_PAR
+    {
+        CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();
+        vector<float> xmags, ymags, unrollMags, mag2ds;
+        vector<int32_t> useNodes;
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int32_t i = 0; i < numNodes; ++i)
+        {
+            Stencil& myStencil = m_stencils[i];
+            if (roiValues != NULL && roiValues[i] <= 0.0f) continue;
+            int32_t numNeigh;
+            const int32_t* myNeighbors = myTopoHelp->getNodeNeighbors(i, numNeigh);
+            if (numNeigh < 2) continue;//AlgorithmMetricGradient outputs zero without trying either method
+            Vector3D myNormal = Vector3D(myNormals + i * 3).normal();
+            Vector3D myCoord = myCoords + i * 3;
+            Vector3D xhat, yhat;
+            getTangentBasis(myNormal, xhat, yhat);
+            useNodes.clear();
+            xmags.clear();
+            ymags.clear();
+            unrollMags.clear();
+            mag2ds.clear();
+            for (int32_t j = 0; j < numNeigh; ++j)
+            {
+                int32_t whichNode = myNeighbors[j];
+                if (roiValues != NULL && roiValues[whichNode] <= 0.0f) continue;
+                float xmag, ymag, unrollMag, mag2d;
+                projectNeighbor(Vector3D(myCoords + whichNode * 3) - myCoord, myNormal, xhat, yhat, myAreas.getDistanceScale(i, whichNode), xmag, ymag, unrollMag, mag2d);
+                useNodes.push_back(whichNode);
+                xmags.push_back(xmag);
+                ymags.push_back(ymag);
+                unrollMags.push_back(unrollMag);
+                mag2ds.push_back(mag2d);
+            }
+            int32_t neighCount = (int32_t)useNodes.size();
+            if (neighCount == 0) continue;
+            bool haveRegression = false;
+            if (neighCount >= 2)
+            {//the regression solution is inverse(A'A) * A'b, and A'b is linear in the value differences, so fold inverse(A'A) into per-neighbor coefficients
+                FloatMatrix myRegress = FloatMatrix::zeros(3, 6);
+                for (int32_t j = 0; j < neighCount; ++j)
+                {
+                    float xmag = xmags[j] * (unrollMags[j] / mag2ds[j]);
+                    float ymag = ymags[j] * (unrollMags[j] / mag2ds[j]);
+                    float weight = vertAreas[useNodes[j]];
+                    myRegress[0][0] += xmag * xmag * weight;
+                    myRegress[0][1] += xmag * ymag * weight;
+                    myRegress[0][2] += xmag * weight;
+                    myRegress[1][1] += ymag * ymag * weight;
+                    myRegress[1][2] += ymag * weight;
+                    myRegress[2][2] += weight;
+                }
+                myRegress[1][0] = myRegress[0][1];
+                myRegress[2][0] = myRegress[0][2];
+                myRegress[2][1] = myRegress[1][2];
+                myRegress[2][2] += vertAreas[i];
+                myRegress[0][3] = 1.0f;
+                myRegress[1][4] = 1.0f;
+                myRegress[2][5] = 1.0f;
+                FloatMatrix myRref = myRegress.reducedRowEchelon();
+                haveRegression = true;
+                myStencil.m_nodes = useNodes;
+                myStencil.m_xCoefs.resize(neighCount);
+                myStencil.m_yCoefs.resize(neighCount);
+                for (int32_t j = 0; j < neighCount && haveRegression; ++j)
+                {
+                    float xmag = xmags[j] * (unrollMags[j] / mag2ds[j]);
+                    float ymag = ymags[j] * (unrollMags[j] / mag2ds[j]);
+                    float weight = vertAreas[useNodes[j]];
+                    float xcoef = weight * (myRref[0][3] * xmag + myRref[0][4] * ymag + myRref[0][5]);
+                    float ycoef = weight * (myRref[1][3] * xmag + myRref[1][4] * ymag + myRref[1][5]);
+                    if (xcoef != xcoef || ycoef != ycoef || isinf(xcoef) || isinf(ycoef))
+                    {
+                        haveRegression = false;
+                    }
+                    myStencil.m_xCoefs[j] = xcoef;
+                    myStencil.m_yCoefs[j] = ycoef;
+                }
+            }
+            if (!haveRegression)
+            {//fallback: area-weighted average of per-neighbor point estimates
+                float totalWeight = 0.0f;
+                for (int32_t j = 0; j < neighCount; ++j)
+                {
+                    totalWeight += vertAreas[useNodes[j]];
+                }
+                myStencil.m_nodes = useNodes;
+                myStencil.m_xCoefs.resize(neighCount);
+                myStencil.m_yCoefs.resize(neighCount);
+                for (int32_t j = 0; j < neighCount; ++j)
+                {
+                    float scale = vertAreas[useNodes[j]] / (unrollMags[j] * mag2ds[j] * totalWeight);
+                    myStencil.m_xCoefs[j] = xmags[j] * scale;
+                    myStencil.m_yCoefs[j] = ymags[j] * scale;
+                }
+            }
+        }
+    }
+}
+
+void MetricGradientObject::gradientMagnitude(const float* valuesIn, float* magnitudeOut) const
+{
+    CaretAssert(valuesIn != NULL);
+    CaretAssert(magnitudeOut != NULL);
+    int32_t numNodes = (int32_t)m_stencils.size();
+#pragma omp CARET_PARFOR schedule(dynamic, 1024)
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        const Stencil& myStencil = m_stencils[i];
+        int32_t numUse = (int32_t)myStencil.m_nodes.size();
+        if (numUse == 0)
+        {
+            magnitudeOut[i] = 0.0f;
+            continue;
+        }
+        float center = valuesIn[i];
+        float xgrad = 0.0f, ygrad = 0.0f;
+        for (int32_t j = 0; j < numUse; ++j)
+        {
+            float diff = valuesIn[myStencil.m_nodes[j]] - center;
+            xgrad += myStencil.m_xCoefs[j] * diff;
+            ygrad += myStencil.m_yCoefs[j] * diff;
+        }
+        float mag = sqrt(xgrad * xgrad + ygrad * ygrad);
+        if (mag != mag) mag = 0.0f;//AlgorithmMetricGradient outputs zero when both methods give NaN
+        magnitudeOut[i] = mag;
+    }
+}
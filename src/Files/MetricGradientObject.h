@@ -0,0 +1,79 @@
+#ifndef __METRIC_GRADIENT_OBJECT_H__
+#define __METRIC_GRADIENT_OBJECT_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+//NOTE: this precomputes the regression that AlgorithmMetricGradient solves at each vertex, which only depends on the surface, the ROI and the vertex areas,
+//      so that the gradient magnitude of many columns on the same surface costs one sparse pass per column.  The results match AlgorithmMetricGradient
+//      (surface normals, ROI, corrected areas, no presmoothing) up to floating point rounding, the neighbor geometry helpers below are shared with it.
+//
+//NOTE: this object contains no mutable members, multiple threads can call gradientMagnitude on the same instance concurrently with different output arrays.
+
+#include "stdint.h"
+#include "Vector3D.h"
+#include <vector>
+
+namespace caret {
+    
+    class SurfaceFile;
+    
+    class MetricGradientObject
+    {
+    public:
+        ///roiValues and correctedAreas may be NULL, roi uses > 0 like AlgorithmMetricGradient
+        MetricGradientObject(SurfaceFile* mySurf, const float* roiValues = NULL, const float* correctedAreas = NULL);
+        int32_t getNumberOfNodes() const { return (int32_t)m_stencils.size(); }
+        ///gradient magnitude of a per-vertex array, vertices outside the ROI or without usable neighbors get 0
+        void gradientMagnitude(const float* valuesIn, float* magnitudeOut) const;
+        
+        ///vertex areas used as regression weights, and the distance scaling for corrected areas (same logic as GeodesicHelper)
+        class RegressionAreas
+        {
+            std::vector<float> m_sqrtCorrAreas, m_sqrtVertAreas, m_areaData;
+            const float* m_areas;
+        public:
+            ///correctedAreas may be NULL, in which case the surface vertex areas are used and distances are not scaled
+            RegressionAreas(const SurfaceFile* mySurf, const float* correctedAreas);
+            const float* getAreas() const { return m_areas; }
+            float getDistanceScale(const int32_t& node, const int32_t& neighbor) const
+            {
+                if (m_sqrtCorrAreas.empty()) return 1.0f;
+                return (m_sqrtCorrAreas[node] + m_sqrtCorrAreas[neighbor]) / (m_sqrtVertAreas[node] + m_sqrtVertAreas[neighbor]);
+            }
+        };
+        ///orthogonal unit vectors in the tangent plane of a unit normal
+        static void getTangentBasis(const Vector3D& normal, Vector3D& xhatOut, Vector3D& yhatOut);
+        ///project a neighbor offset into the tangent plane, unrollMagOut is the arc length (times distScale) that the 2d direction should be scaled to
+        static void projectNeighbor(const Vector3D& offset, const Vector3D& normal, const Vector3D& xhat, const Vector3D& yhat, const float& distScale,
+                                    float& xmagOut, float& ymagOut, float& unrollMagOut, float& mag2dOut);
+    private:
+        struct Stencil
+        {
+            std::vector<int32_t> m_nodes;
+            std::vector<float> m_xCoefs, m_yCoefs;//2D gradient is sum of coef * (neighbor value - center value)
+        };
+        std::vector<Stencil> m_stencils;
+        MetricGradientObject();
+    };
+    
+}
+
+#endif //__METRIC_GRADIENT_OBJECT_H__
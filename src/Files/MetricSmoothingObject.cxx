@@ -147,8 +147,39 @@ void MetricSmoothingObject::smoothColumnInternal(float* scratch, const MetricFil
     CaretAssert(scratch != NULL);
     CaretAssert(whichColumn >= 0 && whichColumn < metricIn->getNumberOfColumns());
     CaretAssert(whichOutColumn >= 0 && whichOutColumn < metricOut->getNumberOfColumns());
-    const float* myColumn = metricIn->getValuePointerForColumn(whichColumn);
-    int32_t numNodes = metricIn->getNumberOfNodes();
+    smoothValuesInternal(metricIn->getValuePointerForColumn(whichColumn), scratch, fixZeros);
+    metricOut->setValuesForColumn(whichOutColumn, scratch);
+}
+
+void MetricSmoothingObject::smoothColumnInternal(float* scratch, const MetricFile* metricIn, const int& whichColumn, MetricFile* metricOut, const int& whichOutColumn, const MetricFile* roi, const int& whichRoiColumn, const bool& fixZeros) const
+{
+    CaretAssert(metricIn != NULL);//asserts only, and only basic checks, these functions are private
+    CaretAssert(metricOut != NULL);
+    CaretAssert(scratch != NULL);
+    CaretAssert(roi != NULL);
+    CaretAssert(whichColumn >= 0 && whichColumn < metricIn->getNumberOfColumns());
+    CaretAssert(whichOutColumn >= 0 && whichOutColumn < metricOut->getNumberOfColumns());
+    CaretAssert(whichRoiColumn >= 0 && whichRoiColumn < roi->getNumberOfColumns());
+    smoothValuesInternal(metricIn->getValuePointerForColumn(whichColumn), scratch, roi->getValuePointerForColumn(whichRoiColumn), fixZeros);
+    metricOut->setValuesForColumn(whichOutColumn, scratch);
+}
+
+void MetricSmoothingObject::smoothValues(const float* valuesIn, float* valuesOut, const float* roiValues, const bool& fixZeros) const
+{
+    CaretAssert(valuesIn != NULL);
+    CaretAssert(valuesOut != NULL);
+    CaretAssert(valuesIn != valuesOut);
+    if (roiValues != NULL)
+    {
+        smoothValuesInternal(valuesIn, valuesOut, roiValues, fixZeros);
+    } else {
+        smoothValuesInternal(valuesIn, valuesOut, fixZeros);
+    }
+}
+
+void MetricSmoothingObject::smoothValuesInternal(const float* myColumn, float* scratch, const bool& fixZeros) const
+{
+    int32_t numNodes = (int32_t)m_weightLists.size();
     if (fixZeros)//special case early to keep branching down
     {
 #pragma omp CARET_PARFOR schedule(dynamic)
@@ -198,21 +229,11 @@ void MetricSmoothingObject::smoothColumnInternal(float* scratch, const MetricFil
             }
         }
     }
-    metricOut->setValuesForColumn(whichOutColumn, scratch);
 }
 
-void MetricSmoothingObject::smoothColumnInternal(float* scratch, const MetricFile* metricIn, const int& whichColumn, MetricFile* metricOut, const int& whichOutColumn, const MetricFile* roi, const int& whichRoiColumn, const bool& fixZeros) const
+void MetricSmoothingObject::smoothValuesInternal(const float* myColumn, float* scratch, const float* roiColumn, const bool& fixZeros) const
 {
-    CaretAssert(metricIn != NULL);//asserts only, and only basic checks, these functions are private
-    CaretAssert(metricOut != NULL);
-    CaretAssert(scratch != NULL);
-    CaretAssert(roi != NULL);
-    CaretAssert(whichColumn >= 0 && whichColumn < metricIn->getNumberOfColumns());
-    CaretAssert(whichOutColumn >= 0 && whichOutColumn < metricOut->getNumberOfColumns());
-    CaretAssert(whichRoiColumn >= 0 && whichRoiColumn < roi->getNumberOfColumns());
-    const float* myColumn = metricIn->getValuePointerForColumn(whichColumn);
-    const float* roiColumn = roi->getValuePointerForColumn(whichRoiColumn);
-    int32_t numNodes = metricIn->getNumberOfNodes();
+    int32_t numNodes = (int32_t)m_weightLists.size();
     if (fixZeros)//special case early to keep branching down
     {
 #pragma omp CARET_PARFOR schedule(dynamic)
@@ -274,7 +295,6 @@ void MetricSmoothingObject::smoothColumnInternal(float* scratch, const MetricFil
             }
         }
     }
-    metricOut->setValuesForColumn(whichOutColumn, scratch);
 }
 
 void MetricSmoothingObject::precomputeWeightsGeoGauss(const SurfaceFile* mySurf, float myKernel, const float* nodeAreas)
@@ -52,6 +52,9 @@ namespace caret {
         void smoothColumn(const MetricFile* metricIn, const int& whichColumn, MetricFile* columnOut, const MetricFile* roi = NULL, const bool& fixZeros = false) const;
         void smoothColumn(const MetricFile* metricIn, const int& whichColumn, MetricFile* metricOut, const int& whichOutColumn, const MetricFile* roi = NULL, const int& whichRoiColumn = 0, const bool& fixZeros = false) const;
         void smoothMetric(const MetricFile* metricIn, MetricFile* metricOut, const MetricFile* roi = NULL, const bool& fixZeros = false) const;
+        ///smooth a plain per-vertex array (for instance, one map of a cifti structure view), arrays must have getNumberOfNodes() elements, output must not overlap input
+        void smoothValues(const float* valuesIn, float* valuesOut, const float* roiValues = NULL, const bool& fixZeros = false) const;
+        int32_t getNumberOfNodes() const { return (int32_t)m_weightLists.size(); }
     private:
         struct WeightList
         {
@@ -62,6 +65,8 @@ namespace caret {
         std::vector<WeightList> m_weightLists;
         void smoothColumnInternal(float* scratch, const MetricFile* metricIn, const int& whichColumn, MetricFile* metricOut, const int& whichOutColumn, const bool& fixZeros) const;
         void smoothColumnInternal(float* scratch, const MetricFile* metricIn, const int& whichColumn, MetricFile* metricOut, const int& whichOutColumn, const MetricFile* roi, const int& whichRoiColumn, const bool& fixZeros) const;
+        void smoothValuesInternal(const float* myColumn, float* scratch, const bool& fixZeros) const;
+        void smoothValuesInternal(const float* myColumn, float* scratch, const float* roiColumn, const bool& fixZeros) const;
         void precomputeWeights(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, Method myMethod, const float* nodeAreas);
         void precomputeWeightsGeoGauss(const SurfaceFile* mySurf, float myKernel, const float* nodeAreas);
         void precomputeWeightsROIGeoGauss(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas);
@@ -21,6 +21,7 @@
 
 #include <cmath>
 #include <limits>
+#include <memory>
 
 //#include <QRunnable>
 //#include <QSemaphore>
@@ -38,6 +39,7 @@
 #include "GroupAndNameHierarchyItem.h"
 #include "Palette.h"
 #include "PaletteColorMapping.h"
+#include "PaletteLookupTable.h"
 #include "MathFunctions.h"
 
 using namespace caret;
@@ -197,6 +199,42 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
                              rgbaNegativeOne);
     const bool rgbaNegativeOneValid = (rgbaNegativeOne[3] > 0.0);
     
+    /*
+     * When there are many scalars, a lookup table avoids searching
+     * the palette for the color of each scalar
+     */
+    std::shared_ptr<const PaletteLookupTable> paletteLookupTable;
+    if (numberOfScalars >= (PaletteLookupTable::NUMBER_OF_BUCKETS * 4)) {
+        paletteLookupTable = PaletteLookupTable::getLookupTable(palette,
+                                                                interpolateFlag);
+    }
+    
+    /*
+     * Threshold test as a mask so that it is free of branches
+     * and is vectorized by the compiler.  Scalars failing the
+     * threshold test are still colored but their alpha is set
+     * invalid in the coloring loop.
+     */
+    std::vector<uint8_t> thresholdPassedMask;
+    if ( ! skipThresholdTesting) {
+        thresholdPassedMask.resize(numberOfScalars);
+        uint8_t* maskPointer = &thresholdPassedMask[0];
+        if (showOutsideFlag) {
+#pragma omp CARET_PARFOR schedule(static, 4096)
+            for (int64_t i = 0; i < numberOfScalars; i++) {
+                const float threshold = thresholdValues[i];
+                maskPointer[i] = ((threshold > thresholdMaximum) | (threshold < thresholdMinimum));
+            }
+        }
+        else {
+#pragma omp CARET_PARFOR schedule(static, 4096)
+            for (int64_t i = 0; i < numberOfScalars; i++) {
+                const float threshold = thresholdValues[i];
+                maskPointer[i] = ((threshold >= thresholdMinimum) & (threshold <= thresholdMaximum));
+            }
+        }
+    }
+    
     /*
      * Color all scalars.
      */
@@ -294,9 +332,15 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
              * Color scalar using palette
              */
             float rgba[4];
-            palette->getPaletteColor(normalValue,
-                                     interpolateFlag,
-                                     rgba);
+            if (paletteLookupTable) {
+                paletteLookupTable->getPaletteColor(normalValue,
+                                                    rgba);
+            }
+            else {
+                palette->getPaletteColor(normalValue,
+                                         interpolateFlag,
+                                         rgba);
+            }
             if (rgba[3] > 0.0f) {
                 rgbaOut[0] = rgba[0];
                 rgbaOut[1] = rgba[1];
@@ -310,24 +354,8 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
          * Threshold is done last so colors are still set
          * but if threshold test fails, alpha is set invalid.
          */
-        bool thresholdPassedFlag = false;
-        if (skipThresholdTesting) {
-            thresholdPassedFlag = true;
-        }
-        else if (showOutsideFlag) {
-            if (threshold > thresholdMaximum) {
-                thresholdPassedFlag = true;
-            }
-            else if (threshold < thresholdMinimum) {
-                thresholdPassedFlag = true;
-            }
-        }
-        else {
-            if ((threshold >= thresholdMinimum) &&
-                (threshold <= thresholdMaximum)) {
-                thresholdPassedFlag = true;
-            }
-        }
+        const bool thresholdPassedFlag = (skipThresholdTesting
+                                          || (thresholdPassedMask[i] != 0));
         if (thresholdPassedFlag == false) {
             rgbaOut[3] = 0.0;
             if (showMappedThresholdFailuresInGreen) {
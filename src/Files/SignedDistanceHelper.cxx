@@ -46,128 +46,57 @@ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
 #include "BoundingBox.h"
-#include "CaretHeap.h"
 #include "SignedDistanceHelper.h"
 #include "SurfaceFile.h"
 #include "TopologyHelper.h"
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 using namespace std;
 using namespace caret;
 
-float SignedDistanceHelper::dist(const float coord[3], WindingLogic myWinding)
+namespace
 {
-    CaretMutexLocker locked(&m_mutex);
-    CaretSimpleMinHeap<Oct<SignedDistanceHelperBase::TriVector>*, float> myHeap;
-    myHeap.push(m_base->m_indexRoot, m_base->m_indexRoot->distToPoint(coord));
-    ClosestPointInfo tempInfo, bestInfo;
-    float tempf = -1.0f, bestTriDist = -1.0f;
-    bool first = true;
-    int numChanged = 0;
-    while (!myHeap.isEmpty())
+    template<typename T>
+    float boxDistSqr(const T& node, const float coord[3])
     {
-        Oct<SignedDistanceHelperBase::TriVector>* curOct = myHeap.pop(&tempf);
-        if (first || tempf < bestTriDist)
+        float ret = 0.0f;
+        for (int i = 0; i < 3; ++i)
         {
-            if (curOct->m_leaf)
-            {
-                vector<int32_t>& myVecRef = *(curOct->m_data.m_triList);
-                int numTris = (int)myVecRef.size();
-                for (int i = 0; i < numTris; ++i)
-                {
-                    if (m_triMarked[myVecRef[i]] != 1)
-                    {
-                        m_triMarked[myVecRef[i]] = 1;
-                        m_triMarkChanged[numChanged++] = myVecRef[i];
-                        tempf = unsignedDistToTri(coord, myVecRef[i], tempInfo);
-                        if (first || tempf < bestTriDist)
-                        {
-                            bestInfo = tempInfo;
-                            bestTriDist = tempf;
-                            first = false;
-                        }
-                    }
-                }
-            } else {
-                for (int ci = 0; ci < 2; ++ci)
-                {
-                    for (int cj = 0; cj < 2; ++cj)
-                    {
-                        for (int ck = 0; ck < 2; ++ck)
-                        {
-                            tempf = curOct->m_children[ci][cj][ck]->distToPoint(coord);
-                            if (first || tempf < bestTriDist)
-                            {
-                                myHeap.push(curOct->m_children[ci][cj][ck], tempf);
-                            }
-                        }
-                    }
-                }
-            }
+            float diff = max(max(node.m_minCoord[i] - coord[i], coord[i] - node.m_maxCoord[i]), 0.0f);
+            ret += diff * diff;
         }
+        return ret;
     }
-    while (numChanged)
+    
+    struct CentroidLess
     {
-        m_triMarked[m_triMarkChanged[--numChanged]] = 0;//need to do this before computeSign
-    }
+        const float* m_centroids;
+        int m_axis;
+        CentroidLess(const float* centroids, const int axis) : m_centroids(centroids), m_axis(axis) { }
+        bool operator()(const int32_t& left, const int32_t& right) const
+        {
+            return m_centroids[left * 3 + m_axis] < m_centroids[right * 3 + m_axis];
+        }
+    };
+}
+
+float SignedDistanceHelper::dist(const float coord[3], WindingLogic myWinding)
+{
+    CaretMutexLocker locked(&m_mutex);
+    ClosestPointInfo bestInfo;
+    float bestTriDist = -1.0f;
+    findClosest(coord, numeric_limits<float>::infinity(), bestInfo, bestTriDist);
     return bestTriDist * computeSign(coord, bestInfo, myWinding);
 }
 
 float SignedDistanceHelper::distLimited(const float coord[3], const float limit, bool& validOut, SignedDistanceHelper::WindingLogic myWinding)
 {
     CaretMutexLocker locked(&m_mutex);
-    validOut = false;
-    CaretSimpleMinHeap<Oct<SignedDistanceHelperBase::TriVector>*, float> myHeap;
-    myHeap.push(m_base->m_indexRoot, m_base->m_indexRoot->distToPoint(coord));
-    ClosestPointInfo tempInfo, bestInfo;
-    float tempf = -1.0f, bestTriDist = limit;
-    int numChanged = 0;
-    while (!myHeap.isEmpty())
-    {
-        Oct<SignedDistanceHelperBase::TriVector>* curOct = myHeap.pop(&tempf);
-        if (tempf < bestTriDist)
-        {
-            if (curOct->m_leaf)
-            {
-                vector<int32_t>& myVecRef = *(curOct->m_data.m_triList);
-                int numTris = (int)myVecRef.size();
-                for (int i = 0; i < numTris; ++i)
-                {
-                    if (m_triMarked[myVecRef[i]] != 1)
-                    {
-                        m_triMarked[myVecRef[i]] = 1;
-                        m_triMarkChanged[numChanged++] = myVecRef[i];
-                        tempf = unsignedDistToTri(coord, myVecRef[i], tempInfo);
-                        if (tempf < bestTriDist)
-                        {
-                            bestInfo = tempInfo;
-                            bestTriDist = tempf;
-                            validOut = true;
-                        }
-                    }
-                }
-            } else {
-                for (int ci = 0; ci < 2; ++ci)
-                {
-                    for (int cj = 0; cj < 2; ++cj)
-                    {
-                        for (int ck = 0; ck < 2; ++ck)
-                        {
-                            tempf = curOct->m_children[ci][cj][ck]->distToPoint(coord);
-                            if (tempf < bestTriDist)
-                            {
-                                myHeap.push(curOct->m_children[ci][cj][ck], tempf);
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
-    while (numChanged)
-    {
-        m_triMarked[m_triMarkChanged[--numChanged]] = 0;//need to do this before computeSign
-    }
+    ClosestPointInfo bestInfo;
+    float bestTriDist = limit;
+    validOut = findClosest(coord, limit, bestInfo, bestTriDist);
     if (validOut)
     {
         return bestTriDist * computeSign(coord, bestInfo, myWinding);
@@ -176,61 +105,86 @@ float SignedDistanceHelper::distLimited(const float coord[3], const float limit,
     }
 }
 
-void SignedDistanceHelper::barycentricWeights(const float coord[3], BarycentricInfo& baryInfoOut)
+bool SignedDistanceHelper::findClosest(const float coord[3], const float limit, ClosestPointInfo& bestInfo, float& bestDistOut)
 {
-    CaretMutexLocker locked(&m_mutex);
-    CaretSimpleMinHeap<Oct<SignedDistanceHelperBase::TriVector>*, float> myHeap;
-    myHeap.push(m_base->m_indexRoot, m_base->m_indexRoot->distToPoint(coord));
-    ClosestPointInfo tempInfo, bestInfo;
-    float tempf = -1.0f, bestTriDist = -1.0f;
-    bool first = true;
-    int numChanged = 0;
-    while (!myHeap.isEmpty())
+    const SignedDistanceHelperBase& myBase = *m_base;
+    bestDistOut = limit;
+    if (myBase.m_bvhNodes.empty()) return false;
+    bool found = false;
+    float bestDist = limit, bestSqr = limit * limit;
+    int32_t nodeStack[SignedDistanceHelperBase::BVH_MAX_STACK];
+    float nodeStackDist[SignedDistanceHelperBase::BVH_MAX_STACK];
+    float lowerBounds[SignedDistanceHelperBase::BVH_LEAF_SIZE];
+    nodeStack[0] = 0;
+    nodeStackDist[0] = boxDistSqr(myBase.m_bvhNodes[0], coord);
+    int stackSize = 1;
+    ClosestPointInfo tempInfo;
+    while (stackSize > 0)
     {
-        Oct<SignedDistanceHelperBase::TriVector>* curOct = myHeap.pop(&tempf);
-        if (first || tempf < bestTriDist)
+        --stackSize;
+        if (!(nodeStackDist[stackSize] < bestSqr)) continue;//best may have improved since it was pushed
+        const SignedDistanceHelperBase::BvhNode& curNode = myBase.m_bvhNodes[nodeStack[stackSize]];
+        if (curNode.m_count > 0)
         {
-            if (curOct->m_leaf)
+            const int32_t start = curNode.m_start, count = curNode.m_count;
+            for (int32_t i = 0; i < count; ++i)
+            {//lower bound from triangle bounding box and plane, flat arrays so the compiler can vectorize it
+                const int32_t elem = start + i;
+                float dx = max(max(myBase.m_bvhTriMin[0][elem] - coord[0], coord[0] - myBase.m_bvhTriMax[0][elem]), 0.0f);
+                float dy = max(max(myBase.m_bvhTriMin[1][elem] - coord[1], coord[1] - myBase.m_bvhTriMax[1][elem]), 0.0f);
+                float dz = max(max(myBase.m_bvhTriMin[2][elem] - coord[2], coord[2] - myBase.m_bvhTriMax[2][elem]), 0.0f);
+                float planeDist = myBase.m_bvhTriPlane[0][elem] * coord[0] + myBase.m_bvhTriPlane[1][elem] * coord[1] +
+                                  myBase.m_bvhTriPlane[2][elem] * coord[2] - myBase.m_bvhTriPlane[3][elem];
+                float boxSqr = dx * dx + dy * dy + dz * dz, planeSqr = planeDist * planeDist;
+                lowerBounds[i] = (boxSqr > planeSqr ? boxSqr : planeSqr);
+            }
+            for (int32_t i = 0; i < count; ++i)
             {
-                vector<int32_t>& myVecRef = *(curOct->m_data.m_triList);
-                int numTris = (int)myVecRef.size();
-                for (int i = 0; i < numTris; ++i)
+                if (lowerBounds[i] < bestSqr)
                 {
-                    if (m_triMarked[myVecRef[i]] != 1)
+                    float tempf = unsignedDistToTri(coord, myBase.m_bvhTris[start + i], tempInfo);
+                    if (tempf < bestDist)
                     {
-                        m_triMarked[myVecRef[i]] = 1;
-                        m_triMarkChanged[numChanged++] = myVecRef[i];
-                        tempf = unsignedDistToTri(coord, myVecRef[i], tempInfo);
-                        if (first || tempf < bestTriDist)
-                        {
-                            bestInfo = tempInfo;
-                            bestTriDist = tempf;
-                            first = false;
-                        }
-                    }
-                }
-            } else {
-                for (int ci = 0; ci < 2; ++ci)
-                {
-                    for (int cj = 0; cj < 2; ++cj)
-                    {
-                        for (int ck = 0; ck < 2; ++ck)
-                        {
-                            tempf = curOct->m_children[ci][cj][ck]->distToPoint(coord);
-                            if (first || tempf < bestTriDist)
-                            {
-                                myHeap.push(curOct->m_children[ci][cj][ck], tempf);
-                            }
-                        }
+                        bestInfo = tempInfo;
+                        bestDist = tempf;
+                        bestSqr = tempf * tempf;
+                        found = true;
                     }
                 }
             }
+        } else {
+            int32_t nearChild = curNode.m_start, farChild = curNode.m_start + 1;
+            float nearDist = boxDistSqr(myBase.m_bvhNodes[nearChild], coord), farDist = boxDistSqr(myBase.m_bvhNodes[farChild], coord);
+            if (farDist < nearDist)
+            {
+                swap(nearChild, farChild);
+                swap(nearDist, farDist);
+            }
+            CaretAssert(stackSize + 2 <= SignedDistanceHelperBase::BVH_MAX_STACK);
+            if (farDist < bestSqr)
+            {
+                nodeStack[stackSize] = farChild;
+                nodeStackDist[stackSize] = farDist;
+                ++stackSize;
+            }
+            if (nearDist < bestSqr)
+            {//pushed last so it is searched first, which shrinks the search radius sooner
+                nodeStack[stackSize] = nearChild;
+                nodeStackDist[stackSize] = nearDist;
+                ++stackSize;
+            }
         }
     }
-    while (numChanged)
-    {
-        m_triMarked[m_triMarkChanged[--numChanged]] = 0;//clean up
-    }
+    bestDistOut = bestDist;
+    return found;
+}
+
+void SignedDistanceHelper::barycentricWeights(const float coord[3], BarycentricInfo& baryInfoOut)
+{
+    CaretMutexLocker locked(&m_mutex);
+    ClosestPointInfo bestInfo;
+    float bestTriDist = -1.0f;
+    findClosest(coord, numeric_limits<float>::infinity(), bestInfo, bestTriDist);
     baryInfoOut.triangle = bestInfo.triangle;
     baryInfoOut.point = bestInfo.tempPoint;
     baryInfoOut.absDistance = bestTriDist;
@@ -824,6 +778,111 @@ SignedDistanceHelperBase::SignedDistanceHelperBase(const SurfaceFile* mySurf)
         }
         addTriangle(m_indexRoot, i, minCoord, maxCoord);//use bounding box for now as an easy test to capture any chance of the triangle intersecting the Oct
     }
+    buildBvh();
+}
+
+void SignedDistanceHelperBase::buildBvh()
+{
+    m_bvhNodes.clear();
+    m_bvhTris.clear();
+    if (m_numTris < 1) return;
+    vector<float> centroids(m_numTris * 3);
+    vector<int32_t> triOrder(m_numTris);
+    for (int32_t i = 0; i < m_numTris; ++i)
+    {
+        const int32_t* thisTri = getTriangle(i);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            centroids[i * 3 + axis] = (getCoordinate(thisTri[0])[axis] + getCoordinate(thisTri[1])[axis] + getCoordinate(thisTri[2])[axis]) / 3.0f;
+        }
+        triOrder[i] = i;
+    }
+    m_bvhNodes.reserve(2 * (m_numTris / BVH_LEAF_SIZE + 1));
+    m_bvhNodes.push_back(BvhNode());
+    buildBvhNode(0, 0, m_numTris, triOrder, centroids);
+    m_bvhTris = triOrder;
+    for (int i = 0; i < 3; ++i)
+    {
+        m_bvhTriMin[i].resize(m_numTris);
+        m_bvhTriMax[i].resize(m_numTris);
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        m_bvhTriPlane[i].resize(m_numTris);
+    }
+    for (int32_t elem = 0; elem < m_numTris; ++elem)
+    {
+        const int32_t* thisTri = getTriangle(m_bvhTris[elem]);
+        Vector3D verts[3] = { getCoordinate(thisTri[0]), getCoordinate(thisTri[1]), getCoordinate(thisTri[2]) };
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            m_bvhTriMin[axis][elem] = min(min(verts[0][axis], verts[1][axis]), verts[2][axis]);
+            m_bvhTriMax[axis][elem] = max(max(verts[0][axis], verts[1][axis]), verts[2][axis]);
+        }
+        Vector3D triNormal;
+        if (!MathFunctions::normalVector(verts[0], verts[1], verts[2], triNormal))
+        {
+            triNormal = Vector3D();//degenerate triangles get no plane bound, only the box
+        }
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            m_bvhTriPlane[axis][elem] = triNormal[axis];
+        }
+        m_bvhTriPlane[3][elem] = triNormal.dot(verts[0]);
+    }
+}
+
+void SignedDistanceHelperBase::buildBvhNode(const int32_t nodeIndex, const int32_t start, const int32_t count, vector<int32_t>& triOrder, const vector<float>& centroids)
+{
+    BvhNode thisNode;
+    float centMin[3], centMax[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        thisNode.m_minCoord[axis] = numeric_limits<float>::infinity();
+        thisNode.m_maxCoord[axis] = -numeric_limits<float>::infinity();
+        centMin[axis] = numeric_limits<float>::infinity();
+        centMax[axis] = -numeric_limits<float>::infinity();
+    }
+    for (int32_t i = start; i < start + count; ++i)
+    {
+        const int32_t* thisTri = getTriangle(triOrder[i]);
+        for (int j = 0; j < 3; ++j)
+        {
+            const float* thisCoord = getCoordinate(thisTri[j]);
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                thisNode.m_minCoord[axis] = min(thisNode.m_minCoord[axis], thisCoord[axis]);
+                thisNode.m_maxCoord[axis] = max(thisNode.m_maxCoord[axis], thisCoord[axis]);
+            }
+        }
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            centMin[axis] = min(centMin[axis], centroids[triOrder[i] * 3 + axis]);
+            centMax[axis] = max(centMax[axis], centroids[triOrder[i] * 3 + axis]);
+        }
+    }
+    if (count <= BVH_LEAF_SIZE)
+    {
+        thisNode.m_start = start;
+        thisNode.m_count = count;
+        m_bvhNodes[nodeIndex] = thisNode;
+        return;
+    }
+    int splitAxis = 0;
+    for (int axis = 1; axis < 3; ++axis)
+    {
+        if (centMax[axis] - centMin[axis] > centMax[splitAxis] - centMin[splitAxis]) splitAxis = axis;
+    }
+    int32_t half = count / 2;//split at the median so the tree is balanced, which bounds the search stack
+    nth_element(triOrder.begin() + start, triOrder.begin() + start + half, triOrder.begin() + start + count, CentroidLess(centroids.data(), splitAxis));
+    int32_t firstChild = (int32_t)m_bvhNodes.size();
+    m_bvhNodes.push_back(BvhNode());
+    m_bvhNodes.push_back(BvhNode());
+    thisNode.m_start = firstChild;
+    thisNode.m_count = 0;
+    m_bvhNodes[nodeIndex] = thisNode;
+    buildBvhNode(firstChild, start, half, triOrder, centroids);
+    buildBvhNode(firstChild + 1, start + half, count - half, triOrder, centroids);
 }
 
 void SignedDistanceHelperBase::addTriangle(Oct<TriVector>* thisOct, int32_t triangle, float minCoord[3], float maxCoord[3])
@@ -50,7 +50,19 @@ namespace caret {
         };
         static const int NUM_TRIS_TO_TEST = 50;//test for whether to split leaf at this number
         static const int NUM_TRIS_TEST_INCR = 50;//and again at further multiples of this
-        CaretPointer<Oct<TriVector> > m_indexRoot;
+        static const int BVH_LEAF_SIZE = 8;//max triangles in a bvh leaf
+        static const int BVH_MAX_STACK = 128;//bvh is split at the median, so depth is at most log2 of the number of triangles
+        struct BvhNode
+        {
+            float m_minCoord[3], m_maxCoord[3];
+            int32_t m_start, m_count;//leaf: range in m_bvhTris, internal: m_count is 0, children are m_start and m_start + 1
+        };
+        CaretPointer<Oct<TriVector> > m_indexRoot;//used for ray tests, closest triangle searches use the bvh
+        std::vector<BvhNode> m_bvhNodes;
+        std::vector<int32_t> m_bvhTris;//each triangle exactly once, so searches don't need to mark visited triangles
+        std::vector<float> m_bvhTriMin[3], m_bvhTriMax[3], m_bvhTriPlane[4];//per element of m_bvhTris, bounding box and unit normal plus offset, for vectorizable lower bounds
+        void buildBvh();
+        void buildBvhNode(const int32_t nodeIndex, const int32_t start, const int32_t count, std::vector<int32_t>& triOrder, const std::vector<float>& centroids);
         int32_t m_numTris, m_numNodes;
         std::vector<float> m_coordList;//make a copy of what we need from SurfaceFile so that if the SurfaceFile gets destroyed, we don't crash
         std::vector<int32_t> m_triangleList;
@@ -104,6 +116,8 @@ namespace caret {
             Vector3D tempPoint;
         };
         float unsignedDistToTri(const float coord[3], int32_t triangle, ClosestPointInfo& myInfo);
+        ///bvh search for the closest triangle, only considers triangles closer than limit, returns false if none are
+        bool findClosest(const float coord[3], const float limit, ClosestPointInfo& bestInfo, float& bestDistOut);
         int computeSign(const float coord[3], ClosestPointInfo myInfo, WindingLogic myWinding);
         bool pointInTri(Vector3D verts[3], Vector3D inPlane, int majAxis, int midAxis);
     public:
@@ -178,7 +178,7 @@ SparseVolumeIndexer::SparseVolumeIndexer(const CiftiParcelsMap& ciftiParcelsMap)
 //            return;
 //        }
         
-        for (std::set<VoxelIJK>::const_iterator iter = parcel.m_voxelIndices.begin();
+        for (CaretSortedVectorSet<VoxelIJK>::const_iterator iter = parcel.m_voxelIndices.begin();
              iter != parcel.m_voxelIndices.end();
              iter++) {
             const VoxelIJK& vm = *iter;
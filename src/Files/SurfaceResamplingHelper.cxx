@@ -25,6 +25,7 @@
 
 #include "SurfaceResamplingHelper.h"
 
+#include "CacheFileHelper.h"
 #include "CaretAssert.h"
 #include "CaretException.h"
 #include "CaretOMP.h"
@@ -34,16 +35,26 @@
 #include "TopologyHelper.h"
 #include "Vector3D.h"
 
+#include <algorithm>
+#include <istream>
+#include <limits>
+#include <ostream>
 #include <set>
 #include <map>
 
 using namespace std;
 using namespace caret;
 
+namespace
+{
+    const int COLUMN_BLOCK = 16;//columns resampled together by the multi-column resampleNormal
+}
+
 SurfaceResamplingHelper::SurfaceResamplingHelper(const SurfaceResamplingMethodEnum::Enum& myMethod, const SurfaceFile* currentSphere, const SurfaceFile* newSphere,
                                                  const float* currentAreas, const float* newAreas, const float* currentRoi)
 {
     if (!checkSphere(currentSphere) || !checkSphere(newSphere)) throw CaretException("input surfaces to SurfaceResamplingHelper must be spheres");
+    m_numCurrentNodes = currentSphere->getNumberOfNodes();
     SurfaceFile currentSphereMod, newSphereMod;
     changeRadius(100.0f, currentSphere, &currentSphereMod);
     changeRadius(100.0f, newSphere, &newSphereMod);
@@ -81,6 +92,56 @@ void SurfaceResamplingHelper::resampleNormal(const float* input, float* output,
     }
 }
 
+void SurfaceResamplingHelper::resampleNormal(const vector<const float*>& inputs, const vector<float*>& outputs, const float& invalidVal) const
+{
+    CaretAssert(inputs.size() == outputs.size());
+    int numColumns = (int)inputs.size(), numNodes = (int)m_weights.size() - 1;
+    vector<float> gathered((int64_t)m_numCurrentNodes * min(COLUMN_BLOCK, numColumns));
+    for (int blockStart = 0; blockStart < numColumns; blockStart += COLUMN_BLOCK)
+    {
+        const int blockSize = min(COLUMN_BLOCK, numColumns - blockStart);
+#pragma omp CARET_PARFOR schedule(static)
+        for (int node = 0; node < m_numCurrentNodes; ++node)
+        {
+            float* gatherOut = gathered.data() + (int64_t)node * blockSize;
+            for (int c = 0; c < blockSize; ++c)
+            {
+                gatherOut[c] = inputs[blockStart + c][node];
+            }
+        }
+#pragma omp CARET_PAR
+        {
+            vector<double> accum(blockSize);
+#pragma omp CARET_FOR schedule(dynamic, 256)
+            for (int i = 0; i < numNodes; ++i)
+            {
+                WeightElem* end = m_weights[i + 1], *elem = m_weights[i];
+                if (elem != end)
+                {
+                    fill(accum.begin(), accum.end(), 0.0);
+                    for (; elem != end; ++elem)
+                    {
+                        const float* values = gathered.data() + (int64_t)elem->node * blockSize;
+                        for (int c = 0; c < blockSize; ++c)
+                        {
+                            accum[c] += values[c] * elem->weight;
+                        }
+                    }
+                    for (int c = 0; c < blockSize; ++c)
+                    {
+                        outputs[blockStart + c][i] = accum[c];
+                    }
+                } else {
+                    for (int c = 0; c < blockSize; ++c)
+                    {
+                        outputs[blockStart + c][i] = invalidVal;
+                    }
+                }
+            }
+        }
+    }
+}
+
 void SurfaceResamplingHelper::resample3DCoord(const float* input, float* output) const
 {
     int numNodes = (int)m_weights.size() - 1;
@@ -204,6 +265,74 @@ void SurfaceResamplingHelper::getResampleValidROI(float* output) const
     }
 }
 
+void SurfaceResamplingHelper::writeWeights(ostream& outStream) const
+{
+    int64_t header[3] = { m_numCurrentNodes, getNumberOfNewNodes(), 0 };
+    if (header[1] < 0) header[1] = 0;//default constructed
+    header[2] = (header[1] > 0 ? m_weights[header[1]] - m_weights[0] : 0);
+    outStream.write((const char*)header, sizeof(header));
+    vector<int64_t> rowStart(header[1] + 1, 0);
+    for (int64_t i = 1; i <= header[1]; ++i)
+    {
+        rowStart[i] = m_weights[i] - m_weights[0];
+    }
+    vector<int32_t> nodes(header[2]);
+    vector<float> weights(header[2]);
+    for (int64_t i = 0; i < header[2]; ++i)
+    {
+        nodes[i] = m_storagechunk[i].node;
+        weights[i] = m_storagechunk[i].weight;
+    }
+    outStream.write((const char*)rowStart.data(), rowStart.size() * sizeof(int64_t));
+    if (header[2] > 0)
+    {
+        outStream.write((const char*)nodes.data(), nodes.size() * sizeof(int32_t));
+        outStream.write((const char*)weights.data(), weights.size() * sizeof(float));
+    }
+}
+
+bool SurfaceResamplingHelper::readWeights(istream& inStream)
+{
+    int64_t header[3];
+    inStream.read((char*)header, sizeof(header));
+    if (!inStream || header[0] < 0 || header[1] < 0 || header[2] < 0) return false;
+    //node counts are stored as int, and the header must not drive allocations larger than the data in the stream
+    if (header[0] > numeric_limits<int>::max() || header[1] >= numeric_limits<int>::max() || header[2] > numeric_limits<int64_t>::max() / 16) return false;
+    const int64_t bytesNeeded = (header[1] + 1) * (int64_t)sizeof(int64_t) + header[2] * (int64_t)(sizeof(int32_t) + sizeof(float));
+    const int64_t bytesRemaining = CacheFileHelper::getBytesRemaining(inStream);
+    if (bytesRemaining >= 0 && bytesNeeded > bytesRemaining) return false;
+    vector<int64_t> rowStart(header[1] + 1);
+    vector<int32_t> nodes(header[2]);
+    vector<float> weights(header[2]);
+    inStream.read((char*)rowStart.data(), rowStart.size() * sizeof(int64_t));
+    if (header[2] > 0)
+    {
+        inStream.read((char*)nodes.data(), nodes.size() * sizeof(int32_t));
+        inStream.read((char*)weights.data(), weights.size() * sizeof(float));
+    }
+    if (!inStream || rowStart[0] != 0 || rowStart[header[1]] != header[2]) return false;
+    for (int64_t i = 0; i < header[1]; ++i)
+    {
+        if (rowStart[i + 1] < rowStart[i]) return false;
+    }
+    for (int64_t i = 0; i < header[2]; ++i)
+    {
+        if (nodes[i] < 0 || nodes[i] >= header[0]) return false;
+    }
+    m_numCurrentNodes = (int)header[0];
+    m_storagechunk = CaretArray<WeightElem>(header[2]);
+    m_weights = CaretArray<WeightElem*>(header[1] + 1);
+    for (int64_t i = 0; i < header[2]; ++i)
+    {
+        m_storagechunk[i] = WeightElem(nodes[i], weights[i]);
+    }
+    for (int64_t i = 0; i <= header[1]; ++i)
+    {
+        m_weights[i] = m_storagechunk + rowStart[i];
+    }
+    return true;
+}
+
 void SurfaceResamplingHelper::resampleCutSurface(const SurfaceFile* cutSurfaceIn, const SurfaceFile* currentSphere, const SurfaceFile* newSphere, SurfaceFile* surfaceOut)
 {
     if (cutSurfaceIn->getNumberOfNodes() != currentSphere->getNumberOfNodes()) throw CaretException("input surface has different number of nodes than input sphere");
@@ -24,6 +24,7 @@
 #include "CaretPointer.h"
 #include "SurfaceResamplingMethodEnum.h"
 
+#include <iosfwd>
 #include <map>
 #include <vector>
 
@@ -42,6 +43,7 @@ namespace caret {
         };
         CaretArray<WeightElem> m_storagechunk;
         CaretArray<WeightElem*> m_weights;
+        int m_numCurrentNodes;
         static bool checkSphere(const SurfaceFile* surface);
         static void changeRadius(const float& radius, const SurfaceFile* input, SurfaceFile* output);
         void computeWeightsAdapBaryArea(const SurfaceFile* currentSphere, const SurfaceFile* newSphere, const float* currentAreas, const float* newAreas, const float* currentRoi);
@@ -49,11 +51,13 @@ namespace caret {
         static void makeBarycentricWeights(const SurfaceFile* from, const SurfaceFile* to, std::vector<std::map<int, float> >& weights, const float* currentRoi);
         void compactWeights(const std::vector<std::map<int, float> >& weights);
     public:
-        SurfaceResamplingHelper() { }
+        SurfaceResamplingHelper() { m_numCurrentNodes = 0; }
         SurfaceResamplingHelper(const SurfaceResamplingMethodEnum::Enum& myMethod, const SurfaceFile* currentSphere, const SurfaceFile* newSphere,
                                 const float* currentAreas = NULL, const float* newAreas = NULL, const float* currentRoi = NULL);
         ///resample real-valued data by means of weights
         void resampleNormal(const float* input, float* output, const float& invalidVal = 0.0f) const;
+        ///resample several columns at once, inputs are interleaved in blocks so each weight is read once per block
+        void resampleNormal(const std::vector<const float*>& inputs, const std::vector<float*>& outputs, const float& invalidVal = 0.0f) const;
         ///resample 3D coordinate data by means of weights
         void resample3DCoord(const float* input, float* output) const;
         ///resample label-like data according to which value gets the largest weight sum
@@ -65,6 +69,14 @@ namespace caret {
         ///get the ROI of nodes that have data within the input ROI
         void getResampleValidROI(float* output) const;
         
+        int getNumberOfCurrentNodes() const { return m_numCurrentNodes; }
+        int getNumberOfNewNodes() const { return (int)m_weights.size() - 1; }
+        
+        ///binary form of the weights, for precomputed resampling plans
+        void writeWeights(std::ostream& outStream) const;
+        ///returns false if the data is not valid weights
+        bool readWeights(std::istream& inStream);
+        
         ///resample a cut surface - not something you will apply multiple times, so static method
         static void resampleCutSurface(const SurfaceFile* cutSurfaceIn, const SurfaceFile* curSphere, const SurfaceFile* newSphere, SurfaceFile* surfaceOut);
     };
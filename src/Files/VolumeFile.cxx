@@ -1772,6 +1772,41 @@ VolumeFile::getVolumeDrawingPrimitive(const int32_t mapIndex,
                                                                        tabIndex);
 }
 
+/**
+ * @return True if this volume is drawn with bricks.
+ */
+bool
+VolumeFile::isVolumeDrawingWithBricks() const
+{
+    return m_graphicsPrimitiveManager->isVolumeDrawingWithBricks();
+}
+
+/**
+ * Get the graphics primitives of the bricks that intersect a slice
+ *
+ * @param mapIndex
+ *    Index of the map.
+ * @param displayGroup
+ *    The selected display group.
+ * @param tabIndex
+ *    Index of selected tab.
+ * @param sliceCornersXYZ
+ *    Corners of the slice in order around the slice.
+ * @return
+ *    Graphics primitives for drawing the slice.
+ */
+std::vector<GraphicsPrimitiveV3fT3f*>
+VolumeFile::getVolumeDrawingBrickPrimitivesForSlice(const int32_t mapIndex,
+                                                    const DisplayGroupEnum::Enum displayGroup,
+                                                    const int32_t tabIndex,
+                                                    const std::array<std::array<float, 3>, 4>& sliceCornersXYZ) const
+{
+    return m_graphicsPrimitiveManager->getVolumeDrawingBrickPrimitivesForSlice(mapIndex,
+                                                                               displayGroup,
+                                                                               tabIndex,
+                                                                               sliceCornersXYZ);
+}
+
 /**
  * Get the voxel values for a slice in a map.
  *
@@ -352,6 +352,13 @@ namespace caret {
                                                                    const DisplayGroupEnum::Enum displayGroup,
                                                                    const int32_t tabIndex) const override;
         
+        virtual bool isVolumeDrawingWithBricks() const override;
+        
+        virtual std::vector<GraphicsPrimitiveV3fT3f*> getVolumeDrawingBrickPrimitivesForSlice(const int32_t mapIndex,
+                                                                                              const DisplayGroupEnum::Enum displayGroup,
+                                                                                              const int32_t tabIndex,
+                                                                                              const std::array<std::array<float, 3>, 4>& sliceCornersXYZ) const override;
+        
         void getVoxelValuesForSliceInMap(const int32_t mapIndex,
                                          const VolumeSliceViewPlaneEnum::Enum slicePlane,
                                          const int64_t sliceIndex,
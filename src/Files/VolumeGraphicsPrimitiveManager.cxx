@@ -23,12 +23,15 @@
 #include "VolumeGraphicsPrimitiveManager.h"
 #undef __VOLUME_GRAPHICS_PRIMITIVE_MANAGER_DECLARE__
 
+#include <algorithm>
+
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "CaretMappableDataFile.h"
 #include "GraphicsPrimitiveV3fT3f.h"
 #include "GraphicsUtilitiesOpenGL.h"
 #include "VolumeMappableInterface.h"
+#include "VolumeSpace.h"
 using namespace caret;
 
 
@@ -37,6 +40,12 @@ using namespace caret;
  * \class caret::VolumeGraphicsPrimitiveManager
  * \brief Generates graphics primitives for drawing volumes using textures
  * \ingroup Files
+ *
+ * Volumes with a small texture are drawn with one 3D texture containing
+ * the entire map.  Large volumes are divided into bricks that each have
+ * their own 3D texture.  Bricks are created (colored) only when they
+ * intersect a slice that is drawn and the least recently used bricks
+ * are removed when the bricks exceed a memory budget.
  */
 
 /**
@@ -70,6 +79,9 @@ void
 VolumeGraphicsPrimitiveManager::clear()
 {
     m_mapGraphicsPrimitives.clear();
+    m_brickLookup.clear();
+    m_bricks.clear();
+    m_brickBytes = 0;
 }
 
 /**
@@ -84,6 +96,32 @@ VolumeGraphicsPrimitiveManager::invalidateColoringForMap(const int32_t mapIndex)
         && (mapIndex < static_cast<int32_t>(m_mapGraphicsPrimitives.size()))) {
         m_mapGraphicsPrimitives[mapIndex].reset();
     }
+    
+    removeBricksForMap(mapIndex);
+}
+
+/**
+ * Remove all bricks for the given map.  The bricks are
+ * recreated when they are needed for drawing.
+ *
+ * @param mapIndex
+ *    Index of the map
+ */
+void
+VolumeGraphicsPrimitiveManager::removeBricksForMap(const int32_t mapIndex)
+{
+    for (auto iter = m_bricks.begin(); iter != m_bricks.end(); ) {
+        const Brick* brick = iter->get();
+        if (brick->m_mapIndex == mapIndex) {
+            m_brickLookup.erase(BrickKey(brick->m_mapIndex,
+                                         brick->m_brickIndex));
+            m_brickBytes -= brick->m_numberOfBytes;
+            iter = m_bricks.erase(iter);
+        }
+        else {
+            ++iter;
+        }
+    }
 }
 
 /**
@@ -129,6 +167,420 @@ VolumeGraphicsPrimitiveManager::getVolumeDrawingPrimitiveForMap(const int32_t ma
     return primitiveOut;
 }
 
+/**
+ * @return True if the volume is drawn with bricks.  Bricks are used when
+ * the texture for the entire volume would be large or when the volume's
+ * dimensions exceed the maximum dimension of a 3D texture.
+ */
+bool
+VolumeGraphicsPrimitiveManager::isVolumeDrawingWithBricks() const
+{
+    std::vector<int64_t> dims(5);
+    m_volumeInterface->getDimensions(dims);
+    
+    const int64_t textureBytes(dims[0] * dims[1] * dims[2] * 4);
+    if (textureBytes > MAXIMUM_FULL_TEXTURE_BYTES) {
+        return true;
+    }
+    
+    const int64_t maxTextureSize(GraphicsUtilitiesOpenGL::getTextureDepthMaximumDimension());
+    if ((dims[0] > maxTextureSize)
+        || (dims[1] > maxTextureSize)
+        || (dims[2] > maxTextureSize)) {
+        return true;
+    }
+    
+    return false;
+}
+
+/**
+ * Get the graphics primitives of the bricks that intersect a slice for
+ * drawing a volume's map.  Each primitive is a triangle fan of the
+ * slice polygon clipped to the brick with its vertices and texture
+ * coordinates set so that it is ready for drawing.
+ *
+ * @param mapIndex
+ *    Index of the map.
+ * @param displayGroup
+ *    The selected display group.
+ * @param tabIndex
+ *    Index of selected tab.
+ * @param sliceCornersXYZ
+ *    Corners of the slice (a planar quadrilateral) in order around the slice.
+ * @return
+ *    Graphics primitives for the bricks, empty if slice does not intersect volume.
+ */
+std::vector<GraphicsPrimitiveV3fT3f*>
+VolumeGraphicsPrimitiveManager::getVolumeDrawingBrickPrimitivesForSlice(const int32_t mapIndex,
+                                                                        const DisplayGroupEnum::Enum displayGroup,
+                                                                        const int32_t tabIndex,
+                                                                        const std::array<std::array<float, 3>, 4>& sliceCornersXYZ) const
+{
+    std::vector<GraphicsPrimitiveV3fT3f*> primitivesOut;
+    
+    std::vector<int64_t> dims(5);
+    m_volumeInterface->getDimensions(dims);
+    if ((dims[0] <= 0)
+        || (dims[1] <= 0)
+        || (dims[2] <= 0)) {
+        return primitivesOut;
+    }
+    
+    /*
+     * Texture coordinates use continuous voxel indices in which voxel 'i'
+     * covers [i, i+1), the same as when drawing with a single texture.
+     */
+    const VolumeSpace& volumeSpace = m_volumeInterface->getVolumeSpace();
+    std::vector<SliceVertex> slicePolygon(sliceCornersXYZ.size());
+    for (uint32_t i = 0; i < sliceCornersXYZ.size(); i++) {
+        slicePolygon[i].m_xyz = sliceCornersXYZ[i];
+        volumeSpace.spaceToIndex(slicePolygon[i].m_xyz.data(),
+                                 slicePolygon[i].m_ijk.data());
+    }
+    
+    const std::array<float, 3> volumeMinIJK { 0.0f, 0.0f, 0.0f };
+    const std::array<float, 3> volumeMaxIJK {
+        static_cast<float>(dims[0]),
+        static_cast<float>(dims[1]),
+        static_cast<float>(dims[2])
+    };
+    const std::vector<SliceVertex> volumePolygon(clipPolygon(slicePolygon,
+                                                             volumeMinIJK,
+                                                             volumeMaxIJK));
+    if (volumePolygon.size() < 3) {
+        return primitivesOut;
+    }
+    
+    /*
+     * Range of bricks containing the slice within the volume
+     */
+    std::array<float, 3> polygonMinIJK = volumePolygon[0].m_ijk;
+    std::array<float, 3> polygonMaxIJK = volumePolygon[0].m_ijk;
+    for (const auto& v : volumePolygon) {
+        for (int32_t m = 0; m < 3; m++) {
+            polygonMinIJK[m] = std::min(polygonMinIJK[m], v.m_ijk[m]);
+            polygonMaxIJK[m] = std::max(polygonMaxIJK[m], v.m_ijk[m]);
+        }
+    }
+    std::array<int64_t, 3> firstBrickIJK;
+    std::array<int64_t, 3> lastBrickIJK;
+    for (int32_t m = 0; m < 3; m++) {
+        const int64_t maxBrick((dims[m] - 1) / BRICK_DIMENSION);
+        firstBrickIJK[m] = std::max(static_cast<int64_t>(0),
+                                    std::min(maxBrick,
+                                             static_cast<int64_t>(polygonMinIJK[m]) / BRICK_DIMENSION));
+        lastBrickIJK[m]  = std::max(static_cast<int64_t>(0),
+                                    std::min(maxBrick,
+                                             static_cast<int64_t>(polygonMaxIJK[m]) / BRICK_DIMENSION));
+    }
+    
+    for (int64_t bk = firstBrickIJK[2]; bk <= lastBrickIJK[2]; bk++) {
+        for (int64_t bj = firstBrickIJK[1]; bj <= lastBrickIJK[1]; bj++) {
+            for (int64_t bi = firstBrickIJK[0]; bi <= lastBrickIJK[0]; bi++) {
+                const std::array<int64_t, 3> brickIJK { bi, bj, bk };
+                const std::array<float, 3> brickMinIJK {
+                    static_cast<float>(bi * BRICK_DIMENSION),
+                    static_cast<float>(bj * BRICK_DIMENSION),
+                    static_cast<float>(bk * BRICK_DIMENSION)
+                };
+                const std::array<float, 3> brickMaxIJK {
+                    static_cast<float>(std::min((bi + 1) * BRICK_DIMENSION, dims[0])),
+                    static_cast<float>(std::min((bj + 1) * BRICK_DIMENSION, dims[1])),
+                    static_cast<float>(std::min((bk + 1) * BRICK_DIMENSION, dims[2]))
+                };
+                const std::vector<SliceVertex> brickPolygon(clipPolygon(volumePolygon,
+                                                                        brickMinIJK,
+                                                                        brickMaxIJK));
+                if (brickPolygon.size() < 3) {
+                    continue;
+                }
+                
+                Brick* brick = getBrick(mapIndex,
+                                        brickIJK,
+                                        displayGroup,
+                                        tabIndex);
+                if (brick == NULL) {
+                    continue;
+                }
+                
+                /*
+                 * Primitive has a fixed number of vertices so unused
+                 * vertices duplicate the last vertex (zero area triangles)
+                 */
+                GraphicsPrimitiveV3fT3f* primitive = brick->m_primitive.get();
+                const int32_t numPolygonVertices = static_cast<int32_t>(brickPolygon.size());
+                CaretAssert(numPolygonVertices <= MAXIMUM_SLICE_POLYGON_VERTICES);
+                for (int32_t iVert = 0; iVert < MAXIMUM_SLICE_POLYGON_VERTICES; iVert++) {
+                    const SliceVertex& v = brickPolygon[std::min(iVert, numPolygonVertices - 1)];
+                    float str[3];
+                    for (int32_t m = 0; m < 3; m++) {
+                        str[m] = ((v.m_ijk[m] - brick->m_textureFirstIJK[m])
+                                  / brick->m_textureDimensions[m]);
+                    }
+                    primitive->replaceVertexFloatXYZ(iVert, v.m_xyz.data());
+                    primitive->replaceVertexTextureSTR(iVert, str);
+                }
+                
+                primitivesOut.push_back(primitive);
+            }
+        }
+    }
+    
+    evictBricks(primitivesOut.size());
+    
+    return primitivesOut;
+}
+
+/**
+ * @return Number of bytes in the textures of the bricks.
+ */
+int64_t
+VolumeGraphicsPrimitiveManager::getBrickResidencyBytes() const
+{
+    return m_brickBytes;
+}
+
+/**
+ * Get a brick, creating it if it does not exist.  The brick
+ * becomes the most recently used brick.
+ *
+ * @param mapIndex
+ *    Index of the map.
+ * @param brickIJK
+ *    Indices of the brick.
+ * @param displayGroup
+ *    The selected display group.
+ * @param tabIndex
+ *    Index of selected tab.
+ * @return
+ *    The brick or NULL if it could not be created.
+ */
+VolumeGraphicsPrimitiveManager::Brick*
+VolumeGraphicsPrimitiveManager::getBrick(const int32_t mapIndex,
+                                         const std::array<int64_t, 3>& brickIJK,
+                                         const DisplayGroupEnum::Enum displayGroup,
+                                         const int32_t tabIndex) const
+{
+    std::vector<int64_t> dims(5);
+    m_volumeInterface->getDimensions(dims);
+    const int64_t bricksI((dims[0] + BRICK_DIMENSION - 1) / BRICK_DIMENSION);
+    const int64_t bricksJ((dims[1] + BRICK_DIMENSION - 1) / BRICK_DIMENSION);
+    const int64_t brickIndex(brickIJK[0]
+                             + (brickIJK[1] * bricksI)
+                             + (brickIJK[2] * bricksI * bricksJ));
+    const BrickKey key(mapIndex, brickIndex);
+    
+    auto lookupIter = m_brickLookup.find(key);
+    if (lookupIter != m_brickLookup.end()) {
+        /*
+         * Move to front of list as most recently used
+         */
+        m_bricks.splice(m_bricks.begin(),
+                        m_bricks,
+                        lookupIter->second);
+        return m_bricks.front().get();
+    }
+    
+    std::unique_ptr<Brick> brick(createBrick(mapIndex,
+                                             brickIndex,
+                                             brickIJK,
+                                             displayGroup,
+                                             tabIndex));
+    if ( ! brick) {
+        return NULL;
+    }
+    
+    m_brickBytes += brick->m_numberOfBytes;
+    m_bricks.push_front(std::move(brick));
+    m_brickLookup[key] = m_bricks.begin();
+    
+    return m_bricks.front().get();
+}
+
+/**
+ * Create a brick and its texture containing the coloring of the brick's voxels.
+ *
+ * @param mapIndex
+ *    Index of the map.
+ * @param brickIndex
+ *    Index of the brick.
+ * @param brickIJK
+ *    Indices of the brick.
+ * @param displayGroup
+ *    The selected display group.
+ * @param tabIndex
+ *    Index of selected tab.
+ * @return
+ *    The brick.
+ */
+std::unique_ptr<VolumeGraphicsPrimitiveManager::Brick>
+VolumeGraphicsPrimitiveManager::createBrick(const int32_t mapIndex,
+                                            const int64_t brickIndex,
+                                            const std::array<int64_t, 3>& brickIJK,
+                                            const DisplayGroupEnum::Enum displayGroup,
+                                            const int32_t tabIndex) const
+{
+    std::vector<int64_t> dims(5);
+    m_volumeInterface->getDimensions(dims);
+    
+    std::unique_ptr<Brick> brick(new Brick());
+    brick->m_mapIndex   = mapIndex;
+    brick->m_brickIndex = brickIndex;
+    for (int32_t m = 0; m < 3; m++) {
+        brick->m_firstIJK[m] = brickIJK[m] * BRICK_DIMENSION;
+        brick->m_endIJK[m]   = std::min(brick->m_firstIJK[m] + BRICK_DIMENSION,
+                                        dims[m]);
+        brick->m_textureFirstIJK[m] = std::max(static_cast<int64_t>(0),
+                                               brick->m_firstIJK[m] - 1);
+        const int64_t textureEnd(std::min(brick->m_endIJK[m] + 1,
+                                          dims[m]));
+        brick->m_textureDimensions[m] = textureEnd - brick->m_textureFirstIJK[m];
+    }
+    
+    const int64_t numberOfColumns(brick->m_textureDimensions[0]);
+    const int64_t numberOfRows(brick->m_textureDimensions[1]);
+    const int64_t numberOfSlices(brick->m_textureDimensions[2]);
+    const int64_t numSliceBytes(numberOfColumns * numberOfRows * 4);
+    brick->m_numberOfBytes = numSliceBytes * numberOfSlices;
+    
+    std::vector<uint8_t> rgba(brick->m_numberOfBytes, 0);
+    for (int64_t k = 0; k < numberOfSlices; k++) {
+        const int64_t firstVoxelIJK[3] = {
+            brick->m_textureFirstIJK[0],
+            brick->m_textureFirstIJK[1],
+            brick->m_textureFirstIJK[2] + k
+        };
+        const int64_t rowStepIJK[3] = { 0, 1, 0 };
+        const int64_t columnStepIJK[3] = { 1, 0, 0 };
+        m_volumeInterface->getVoxelColorsForSliceInMap(mapIndex,
+                                                       firstVoxelIJK,
+                                                       rowStepIJK,
+                                                       columnStepIJK,
+                                                       numberOfRows,
+                                                       numberOfColumns,
+                                                       displayGroup,
+                                                       tabIndex,
+                                                       &rgba[k * numSliceBytes]);
+    }
+    
+    GraphicsTextureMagnificationFilterEnum::Enum magFilter(GraphicsTextureMagnificationFilterEnum::LINEAR);
+    GraphicsTextureMinificationFilterEnum::Enum minFilter(GraphicsTextureMinificationFilterEnum::LINEAR);
+    if (m_mapDataFile->isMappedWithRGBA()
+        || m_mapDataFile->isMappedWithLabelTable()) {
+        magFilter  = GraphicsTextureMagnificationFilterEnum::NEAREST;
+        minFilter  = GraphicsTextureMinificationFilterEnum::NEAREST;
+    }
+    std::array<float, 4> backgroundColor { 0.0, 0.0, 0.0, 0.0 };
+    brick->m_primitive.reset(GraphicsPrimitive::newPrimitiveV3fT3f(GraphicsPrimitive::PrimitiveType::OPENGL_TRIANGLE_FAN,
+                                                                   &rgba[0],
+                                                                   numberOfColumns,
+                                                                   numberOfRows,
+                                                                   numberOfSlices,
+                                                                   GraphicsPrimitive::TextureWrappingType::CLAMP_TO_BORDER,
+                                                                   GraphicsPrimitive::TextureMipMappingType::DISABLED,
+                                                                   magFilter,
+                                                                   minFilter,
+                                                                   backgroundColor));
+    CaretAssert(brick->m_primitive);
+    
+    /*
+     * Vertices are replaced when a slice is drawn
+     */
+    const float xyz[3] { 0.0, 0.0, 0.0 };
+    const float str[3] { 0.0, 0.0, 0.0 };
+    for (int32_t i = 0; i < MAXIMUM_SLICE_POLYGON_VERTICES; i++) {
+        brick->m_primitive->addVertex(xyz, str);
+    }
+    
+    return brick;
+}
+
+/**
+ * Remove least recently used bricks until the bricks are within
+ * the memory budget.  Bricks in use for the current slice are
+ * never removed.
+ *
+ * @param numberOfBricksInUse
+ *    Number of bricks at the front of the list used by the current slice.
+ */
+void
+VolumeGraphicsPrimitiveManager::evictBricks(const int64_t numberOfBricksInUse) const
+{
+    while ((m_brickBytes > BRICK_RESIDENCY_BUDGET_BYTES)
+           && (static_cast<int64_t>(m_bricks.size()) > numberOfBricksInUse)) {
+        const Brick* brick = m_bricks.back().get();
+        m_brickLookup.erase(BrickKey(brick->m_mapIndex,
+                                     brick->m_brickIndex));
+        m_brickBytes -= brick->m_numberOfBytes;
+        m_bricks.pop_back();
+    }
+}
+
+/**
+ * Clip a convex polygon to an axis aligned box in voxel index space
+ * (Sutherland-Hodgman).
+ *
+ * @param polygon
+ *    The convex polygon.
+ * @param minimumIJK
+ *    Minimum corner of box.
+ * @param maximumIJK
+ *    Maximum corner of box.
+ * @return
+ *    The clipped polygon, fewer than three vertices if polygon is outside box.
+ */
+std::vector<VolumeGraphicsPrimitiveManager::SliceVertex>
+VolumeGraphicsPrimitiveManager::clipPolygon(const std::vector<SliceVertex>& polygon,
+                                            const std::array<float, 3>& minimumIJK,
+                                            const std::array<float, 3>& maximumIJK)
+{
+    std::vector<SliceVertex> output(polygon);
+    
+    for (int32_t iPlane = 0; iPlane < 6; iPlane++) {
+        if (output.size() < 3) {
+            break;
+        }
+        const int32_t axis(iPlane / 2);
+        const bool minimumFlag((iPlane % 2) == 0);
+        const float limit(minimumFlag
+                          ? minimumIJK[axis]
+                          : maximumIJK[axis]);
+        
+        /* positive distance is inside */
+        auto distance = [=](const SliceVertex& v) {
+            return (minimumFlag
+                    ? (v.m_ijk[axis] - limit)
+                    : (limit - v.m_ijk[axis]));
+        };
+        
+        const std::vector<SliceVertex> input(output);
+        output.clear();
+        const int32_t numVertices = static_cast<int32_t>(input.size());
+        for (int32_t i = 0; i < numVertices; i++) {
+            const SliceVertex& current = input[i];
+            const SliceVertex& next    = input[(i + 1) % numVertices];
+            const float currentDistance(distance(current));
+            const float nextDistance(distance(next));
+            
+            if (currentDistance >= 0.0f) {
+                output.push_back(current);
+            }
+            if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+                const float t(currentDistance / (currentDistance - nextDistance));
+                SliceVertex v;
+                for (int32_t m = 0; m < 3; m++) {
+                    v.m_xyz[m] = current.m_xyz[m] + t * (next.m_xyz[m] - current.m_xyz[m]);
+                    v.m_ijk[m] = current.m_ijk[m] + t * (next.m_ijk[m] - current.m_ijk[m]);
+                }
+                v.m_ijk[axis] = limit;
+                output.push_back(v);
+            }
+        }
+    }
+    
+    return output;
+}
+
 /**
  * Get a description of this object's content.
  * @return String describing this object's content.
@@ -23,7 +23,11 @@
 
 
 
+#include <array>
+#include <list>
+#include <map>
 #include <memory>
+#include <vector>
 
 #include "CaretObject.h"
 #include "DisplayGroupEnum.h"
@@ -54,12 +58,80 @@ namespace caret {
                                                                  const DisplayGroupEnum::Enum displayGroup,
                                                                  const int32_t tabIndex) const;
 
+        bool isVolumeDrawingWithBricks() const;
+        
+        std::vector<GraphicsPrimitiveV3fT3f*> getVolumeDrawingBrickPrimitivesForSlice(const int32_t mapIndex,
+                                                                                      const DisplayGroupEnum::Enum displayGroup,
+                                                                                      const int32_t tabIndex,
+                                                                                      const std::array<std::array<float, 3>, 4>& sliceCornersXYZ) const;
+        
+        int64_t getBrickResidencyBytes() const;
+
 
         // ADD_NEW_METHODS_HERE
 
         virtual AString toString() const;
         
     private:
+        /**
+         * A brick is a block of voxels with its own texture.  The texture
+         * includes a one voxel apron around the brick so that linear
+         * interpolation is seamless across neighboring bricks.
+         */
+        class Brick {
+        public:
+            int32_t m_mapIndex = -1;
+            
+            int64_t m_brickIndex = -1;
+            
+            /** First voxel in brick */
+            std::array<int64_t, 3> m_firstIJK;
+            
+            /** One past last voxel in brick */
+            std::array<int64_t, 3> m_endIJK;
+            
+            /** First voxel in brick's texture (includes apron) */
+            std::array<int64_t, 3> m_textureFirstIJK;
+            
+            /** Dimensions of brick's texture (includes apron) */
+            std::array<int64_t, 3> m_textureDimensions;
+            
+            std::unique_ptr<GraphicsPrimitiveV3fT3f> m_primitive;
+            
+            int64_t m_numberOfBytes = 0;
+        };
+        
+        /** A vertex of the slice polygon in both coordinates and voxel indices */
+        class SliceVertex {
+        public:
+            std::array<float, 3> m_xyz;
+            
+            std::array<float, 3> m_ijk;
+        };
+        
+        typedef std::pair<int32_t, int64_t> BrickKey;
+        
+        typedef std::list<std::unique_ptr<Brick>> BrickList;
+        
+        Brick* getBrick(const int32_t mapIndex,
+                        const std::array<int64_t, 3>& brickIJK,
+                        const DisplayGroupEnum::Enum displayGroup,
+                        const int32_t tabIndex) const;
+        
+        std::unique_ptr<Brick> createBrick(const int32_t mapIndex,
+                                           const int64_t brickIndex,
+                                           const std::array<int64_t, 3>& brickIJK,
+                                           const DisplayGroupEnum::Enum displayGroup,
+                                           const int32_t tabIndex) const;
+        
+        void evictBricks(const int64_t numberOfBricksInUse) const;
+        
+        void removeBricksForMap(const int32_t mapIndex);
+        
+        static std::vector<SliceVertex> clipPolygon(const std::vector<SliceVertex>& polygon,
+                                                    const std::array<float, 3>& minimumIJK,
+                                                    const std::array<float, 3>& maximumIJK);
+        
         GraphicsPrimitiveV3fT3f* createPrimitive(const int32_t mapIndex,
                                                  const DisplayGroupEnum::Enum displayGroup,
                                                  const int32_t tabIndex,
@@ -71,12 +143,36 @@ namespace caret {
         
         mutable std::vector<std::unique_ptr<GraphicsPrimitiveV3fT3f>> m_mapGraphicsPrimitives;
 
+        /** Bricks ordered from most to least recently used */
+        mutable BrickList m_bricks;
+        
+        /** Find a brick in the brick list */
+        mutable std::map<BrickKey, BrickList::iterator> m_brickLookup;
+        
+        /** Bytes used by textures of all bricks */
+        mutable int64_t m_brickBytes = 0;
+        
+        /** Dimension of a brick (voxels along each axis) */
+        static const int64_t BRICK_DIMENSION;
+        
+        /** Maximum bytes in textures of bricks for one file */
+        static const int64_t BRICK_RESIDENCY_BUDGET_BYTES;
+        
+        /** Volumes with a full texture larger than this are drawn with bricks */
+        static const int64_t MAXIMUM_FULL_TEXTURE_BYTES;
+        
+        /** Maximum vertices in slice polygon clipped to a brick (quad clipped by six planes) */
+        static const int32_t MAXIMUM_SLICE_POLYGON_VERTICES;
+
         // ADD_NEW_MEMBERS_HERE
 
     };
     
 #ifdef __VOLUME_GRAPHICS_PRIMITIVE_MANAGER_DECLARE__
-    // <PLACE DECLARATIONS OF STATIC MEMBERS HERE>
+    const int64_t VolumeGraphicsPrimitiveManager::BRICK_DIMENSION = 64;
+    const int64_t VolumeGraphicsPrimitiveManager::BRICK_RESIDENCY_BUDGET_BYTES = 512 * 1024 * 1024;
+    const int64_t VolumeGraphicsPrimitiveManager::MAXIMUM_FULL_TEXTURE_BYTES = 64 * 1024 * 1024;
+    const int32_t VolumeGraphicsPrimitiveManager::MAXIMUM_SLICE_POLYGON_VERTICES = 10;
 #endif // __VOLUME_GRAPHICS_PRIMITIVE_MANAGER_DECLARE__
 
 } // namespace
@@ -21,6 +21,9 @@
  */
 /*LICENSE_END*/
 
+#include <array>
+#include <vector>
+
 #include "DisplayGroupEnum.h"
 #include "VolumeSliceViewPlaneEnum.h"
 #include "VolumeSpace.h"
@@ -383,6 +386,33 @@ namespace caret {
                                                                    const DisplayGroupEnum::Enum displayGroup,
                                                                    const int32_t tabIndex) const = 0;
         
+        /**
+         * @return True if the volume is drawn with bricks (large volumes),
+         * in which case getVolumeDrawingBrickPrimitivesForSlice() is used
+         * for drawing instead of getVolumeDrawingPrimitive().
+         */
+        virtual bool isVolumeDrawingWithBricks() const = 0;
+        
+        /**
+         * Get the primitives, with vertices and texture coordinates set,
+         * for the bricks that intersect a slice.
+         *
+         * @param mapIndex
+         *    Index of the map.
+         * @param displayGroup
+         *    The selected display group.
+         * @param tabIndex
+         *    Index of selected tab.
+         * @param sliceCornersXYZ
+         *    Corners of the slice in order around the slice.
+         * @return
+         *    Primitives for drawing the slice.
+         */
+        virtual std::vector<GraphicsPrimitiveV3fT3f*> getVolumeDrawingBrickPrimitivesForSlice(const int32_t mapIndex,
+                                                                                              const DisplayGroupEnum::Enum displayGroup,
+                                                                                              const int32_t tabIndex,
+                                                                                              const std::array<std::array<float, 3>, 4>& sliceCornersXYZ) const = 0;
+        
         /**
          * Get the volume space object, so we have access to all functions associated with volume spaces
          */
@@ -18,6 +18,7 @@
  */
 /*LICENSE_END*/
 
+#include <iostream>
 #include <utility>
 
 #include <QActionGroup>
@@ -1705,6 +1706,20 @@ BrainBrowserWindow::createActions()
                                 this,
                                 SLOT(processDevelopGraphicsTimingDuration()));
     
+    m_developerPrintEventStatisticsAction =
+    WuQtUtilities::createAction("Print Event Statistics",
+                                "Print the number of times each event was sent and the time spent sending it to the terminal",
+                                this,
+                                this,
+                                SLOT(processDevelopPrintEventStatistics()));
+    
+    m_developerResetEventStatisticsAction =
+    WuQtUtilities::createAction("Reset Event Statistics",
+                                "Reset the event counts and times",
+                                this,
+                                this,
+                                SLOT(processDevelopResetEventStatistics()));
+    
     m_developerExportVtkFileAction =
     WuQtUtilities::createAction("Export to VTK File",
                                 "Export model(s) to VTK File",
@@ -1803,6 +1818,9 @@ BrainBrowserWindow::createMenuDevelop()
     
     menu->addAction(m_developerGraphicsTimingAction);
     menu->addAction(m_developerGraphicsTimingDurationAction);
+    menu->addSeparator();
+    menu->addAction(m_developerPrintEventStatisticsAction);
+    menu->addAction(m_developerResetEventStatisticsAction);
     
     return menu;
 }
@@ -2876,6 +2894,24 @@ BrainBrowserWindow::processDevelopGraphicsTimingDuration()
     }
 }
 
+/**
+ * Print the event statistics to the terminal.
+ */
+void
+BrainBrowserWindow::processDevelopPrintEventStatistics()
+{
+    std::cout << EventManager::get()->getEventStatisticsReport() << std::endl;
+}
+
+/**
+ * Reset the event statistics.
+ */
+void
+BrainBrowserWindow::processDevelopResetEventStatistics()
+{
+    EventManager::get()->resetEventStatistics();
+}
+
 /**
  * Export to VTK file.
  */
@@ -243,6 +243,8 @@ namespace caret {
         
         void processDevelopGraphicsTiming();
         void processDevelopGraphicsTimingDuration();
+        void processDevelopPrintEventStatistics();
+        void processDevelopResetEventStatistics();
 
         void processDevelopExportVtkFile();
         void processDevelopCziFileTransformTesting();
@@ -436,6 +438,8 @@ namespace caret {
         QAction* m_developMenuAction;
         QAction* m_developerGraphicsTimingAction;
         QAction* m_developerGraphicsTimingDurationAction;
+        QAction* m_developerPrintEventStatisticsAction;
+        QAction* m_developerResetEventStatisticsAction;
         QAction* m_developerExportVtkFileAction;
         QAction* m_developerCziFileTransformTestingAction;
         
@@ -22,9 +22,37 @@
 
 #include "DataFileException.h"
 
+#include <limits>
+
 using namespace std;
 using namespace caret;
 
+namespace
+{
+    template<typename T>
+    void dequantizeToFloat(float* out, const T* in, const int64_t& count, const double& mult, const double& offset)
+    {
+        const float floatMult = (float)mult, floatOffset = (float)offset;//8 and 16 bit values are exact in float, so this only rounds the scaling itself
+        for (int64_t i = 0; i < count; ++i)
+        {
+            out[i] = floatOffset + floatMult * (float)in[i];
+        }
+    }
+    
+    template<typename T>
+    void quantizeFromFloat(T* out, const float* in, const int64_t& count, const double& mult, const double& offset)
+    {
+        const double lowest = numeric_limits<T>::min(), highest = numeric_limits<T>::max();//integer types only, so min is the most negative
+        for (int64_t i = 0; i < count; ++i)
+        {
+            double value = floor(0.5 + (in[i] - offset) / mult);
+            value = (value > highest ? highest : value);
+            value = (value < lowest ? lowest : value);
+            out[i] = (T)(value == value ? value : 0.0);//NaN has no integer representation, store 0, which reads back as the offset
+        }
+    }
+}
+
 void NiftiIO::openRead(const QString& filename)
 {
     m_file.open(filename);
@@ -108,3 +136,43 @@ int NiftiIO::numBytesPerElem()
             throw DataFileException("internal error, report what you did to the developers");
     }
 }
+
+void NiftiIO::scaleRead(float* out, const int8_t* in, const int64_t& count, const double& mult, const double& offset)
+{
+    dequantizeToFloat(out, in, count, mult, offset);
+}
+
+void NiftiIO::scaleRead(float* out, const uint8_t* in, const int64_t& count, const double& mult, const double& offset)
+{
+    dequantizeToFloat(out, in, count, mult, offset);
+}
+
+void NiftiIO::scaleRead(float* out, const int16_t* in, const int64_t& count, const double& mult, const double& offset)
+{
+    dequantizeToFloat(out, in, count, mult, offset);
+}
+
+void NiftiIO::scaleRead(float* out, const uint16_t* in, const int64_t& count, const double& mult, const double& offset)
+{
+    dequantizeToFloat(out, in, count, mult, offset);
+}
+
+void NiftiIO::scaleWrite(int8_t* out, const float* in, const int64_t& count, const double& mult, const double& offset)
+{
+    quantizeFromFloat(out, in, count, mult, offset);
+}
+
+void NiftiIO::scaleWrite(uint8_t* out, const float* in, const int64_t& count, const double& mult, const double& offset)
+{
+    quantizeFromFloat(out, in, count, mult, offset);
+}
+
+void NiftiIO::scaleWrite(int16_t* out, const float* in, const int64_t& count, const double& mult, const double& offset)
+{
+    quantizeFromFloat(out, in, count, mult, offset);
+}
+
+void NiftiIO::scaleWrite(uint16_t* out, const float* in, const int64_t& count, const double& mult, const double& offset)
+{
+    quantizeFromFloat(out, in, count, mult, offset);
+}
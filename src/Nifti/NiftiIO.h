@@ -51,6 +51,20 @@ namespace caret
         void convertWrite(TO* out, const FROM* in, const int64_t& count);//for writing to file
         template<typename TO, typename FROM>
         static TO clamp(const FROM& in);//deal with integer cast being undefined when converting from outside range
+        //scaled conversions, the templates are the general case, the overloads are the common dense connectome storage types, written so the compiler can vectorize them
+        //the scaleWrite overloads store NaN as the integer 0, so it reads back as the scaling offset
+        template<typename TO, typename FROM>
+        static void scaleRead(TO* out, const FROM* in, const int64_t& count, const double& mult, const double& offset);
+        static void scaleRead(float* out, const int8_t* in, const int64_t& count, const double& mult, const double& offset);
+        static void scaleRead(float* out, const uint8_t* in, const int64_t& count, const double& mult, const double& offset);
+        static void scaleRead(float* out, const int16_t* in, const int64_t& count, const double& mult, const double& offset);
+        static void scaleRead(float* out, const uint16_t* in, const int64_t& count, const double& mult, const double& offset);
+        template<typename TO, typename FROM>
+        static void scaleWrite(TO* out, const FROM* in, const int64_t& count, const double& mult, const double& offset);
+        static void scaleWrite(int8_t* out, const float* in, const int64_t& count, const double& mult, const double& offset);
+        static void scaleWrite(uint8_t* out, const float* in, const int64_t& count, const double& mult, const double& offset);
+        static void scaleWrite(int16_t* out, const float* in, const int64_t& count, const double& mult, const double& offset);
+        static void scaleWrite(uint16_t* out, const float* in, const int64_t& count, const double& mult, const double& offset);
     public:
         void openRead(const QString& filename);
         void writeNew(const QString& filename, const NiftiHeader& header, const int& version = 1, const bool& withRead = false, const bool& swapEndian = false);
@@ -220,32 +234,38 @@ namespace caret
         }
         double mult, offset;
         bool doScale = m_header.getDataScaling(mult, offset);
+        if (doScale)
+        {
+            scaleRead(out, in, count, mult, offset);
+            return;
+        }
+        if (std::numeric_limits<TO>::is_integer)//do round to nearest when integer output type
+        {
+            for (int64_t i = 0; i < count; ++i)
+            {
+                out[i] = clamp<TO, double>(floor(0.5 + in[i]));
+            }
+        } else {
+            for (int64_t i = 0; i < count; ++i)
+            {
+                out[i] = (TO)in[i];//explicit cast to make sure the compiler doesn't squawk
+            }
+        }
+    }
+    
+    template<typename TO, typename FROM>
+    void NiftiIO::scaleRead(TO* out, const FROM* in, const int64_t& count, const double& mult, const double& offset)
+    {
         if (std::numeric_limits<TO>::is_integer)//do round to nearest when integer output type
         {
-            if (doScale)
+            for (int64_t i = 0; i < count; ++i)
             {
-                for (int64_t i = 0; i < count; ++i)
-                {
-                    out[i] = clamp<TO, long double>(floor(0.5l + offset + mult * (long double)in[i]));//we don't always need that much precision, but it will still be faster than hard drives
-                }
-            } else {
-                for (int64_t i = 0; i < count; ++i)
-                {
-                    out[i] = clamp<TO, double>(floor(0.5 + in[i]));
-                }
+                out[i] = clamp<TO, long double>(floor(0.5l + offset + mult * (long double)in[i]));//we don't always need that much precision, but it will still be faster than hard drives
             }
         } else {
-            if (doScale)
+            for (int64_t i = 0; i < count; ++i)
             {
-                for (int64_t i = 0; i < count; ++i)
-                {
-                    out[i] = (TO)(offset + mult * (long double)in[i]);//we don't always need that much precision, but it will still be faster than hard drives
-                }
-            } else {
-                for (int64_t i = 0; i < count; ++i)
-                {
-                    out[i] = (TO)in[i];//explicit cast to make sure the compiler doesn't squawk
-                }
+                out[i] = (TO)(offset + mult * (long double)in[i]);
             }
         }
     }
@@ -255,35 +275,38 @@ namespace caret
     {
         double mult, offset;
         bool doScale = m_header.getDataScaling(mult, offset);
+        if (doScale)
+        {
+            scaleWrite(out, in, count, mult, offset);
+        } else if (std::numeric_limits<TO>::is_integer) {//do round to nearest when integer output type
+            for (int64_t i = 0; i < count; ++i)
+            {//TODO: what about NaN?
+                out[i] = clamp<TO, double>(floor(0.5 + in[i]));
+            }
+        } else {
+            for (int64_t i = 0; i < count; ++i)
+            {
+                out[i] = (TO)in[i];//explicit cast to make sure the compiler doesn't squawk
+            }
+        }
+        if (m_header.isSwapped()) ByteSwapping::swapArray(out, count);
+    }
+    
+    template<typename TO, typename FROM>
+    void NiftiIO::scaleWrite(TO* out, const FROM* in, const int64_t& count, const double& mult, const double& offset)
+    {
         if (std::numeric_limits<TO>::is_integer)//do round to nearest when integer output type
         {//TODO: what about NaN?
-            if (doScale)
+            for (int64_t i = 0; i < count; ++i)
             {
-                for (int64_t i = 0; i < count; ++i)
-                {
-                    out[i] = clamp<TO, long double>(floor(0.5l + ((long double)in[i] - offset) / mult));//we don't always need that much precision, but it will still be faster than hard drives
-                }
-            } else {
-                for (int64_t i = 0; i < count; ++i)
-                {
-                    out[i] = clamp<TO, double>(floor(0.5 + in[i]));
-                }
+                out[i] = clamp<TO, long double>(floor(0.5l + ((long double)in[i] - offset) / mult));//we don't always need that much precision, but it will still be faster than hard drives
             }
         } else {
-            if (doScale)
+            for (int64_t i = 0; i < count; ++i)
             {
-                for (int64_t i = 0; i < count; ++i)
-                {
-                    out[i] = (TO)(((long double)in[i] - offset) / mult);//we don't always need that much precision, but it will still be faster than hard drives
-                }
-            } else {
-                for (int64_t i = 0; i < count; ++i)
-                {
-                    out[i] = (TO)in[i];//explicit cast to make sure the compiler doesn't squawk
-                }
+                out[i] = (TO)(((long double)in[i] - offset) / mult);
             }
         }
-        if (m_header.isSwapped()) ByteSwapping::swapArray(out, count);
     }
     
     template<typename TO, typename FROM>
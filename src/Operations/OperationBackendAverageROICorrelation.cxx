@@ -21,12 +21,12 @@
 #include "AString.h"
 #include "ByteOrderEnum.h"
 #include "ByteSwapping.h"
-#include "CaretOMP.h"
 #include "CaretPointer.h"
 #include "CiftiFile.h"
 #include "FileInformation.h"
 #include "OperationBackendAverageROICorrelation.h"
 #include "OperationException.h"
+#include "SeedCorrelationEngine.h"
 
 #include <iostream>
 #include <fstream>
@@ -107,7 +107,7 @@ void OperationBackendAverageROICorrelation::useParameters(OperationParameters* m
     {
         baseXML = ciftiList[0]->getCiftiXML();
         if (baseXML.getNumberOfDimensions() != 2) throw OperationException("operation only supports 2D cifti files");
-        int rowSize = baseXML.getDimensionLength(CiftiXML::ALONG_ROW);
+        int rowSize = baseXML.getDimensionLength(CiftiXML::ALONG_COLUMN);//output has one value per row of the inputs, same as row length for dconn
         vector<double> accum(rowSize, 0.0);
         vector<float> rowScratch(rowSize);
         for (int i = 0; i < numCifti; ++i)
@@ -164,52 +164,11 @@ void OperationBackendAverageROICorrelation::processCifti(const CiftiFile* myCift
             accumarray[j] += average[j];
         }
     }
-    double accum = 0.0;
     for (int i = 0; i < rowSize; ++i)
     {
         average[i] = accumarray[i] / listSize;
-        accum += average[i];
-    }
-    float mean = accum / rowSize;
-    accum = 0.0;
-    for (int i = 0; i < rowSize; ++i)
-    {
-        average[i] -= mean;
-        accum += average[i] * average[i];
-    }
-    float rrs = sqrt(accum);
-    int curRow = 0;
-#pragma omp CARET_PAR
-    {
-        vector<float> rowscratch(rowSize);
-#pragma omp CARET_FOR schedule(dynamic)
-        for (int i = 0; i < colSize; ++i)
-        {
-            int myRow;
-#pragma omp critical
-            {
-                myRow = curRow;//force sequential reading
-                ++curRow;
-                myCifti->getRow(rowscratch.data(), myRow);//but never read multiple rows at once from the same file
-            }
-            double tempaccum = 0.0;//compute mean of new row
-            for (int j = 0; j < rowSize; ++j)
-            {
-                tempaccum += rowscratch[j];
-            }
-            float thismean = tempaccum / rowSize;
-            tempaccum = 0.0;
-            double corraccum = 0.0;//correlate
-            for (int j = 0; j < rowSize; ++j)
-            {
-                float tempf = rowscratch[j] - thismean;
-                tempaccum += tempf * tempf;//compute rrs on the fly
-                corraccum += tempf * average[j];//gather the correlation
-            }
-            corraccum /= rrs * sqrt(tempaccum);
-            if (corraccum > 0.999999) corraccum = 0.999999;
-            if (corraccum < -0.999999) corraccum = -0.999999;
-            output[i] = 0.5 * log((1 + corraccum) / (1 - corraccum));
-        }
     }
+    SeedCorrelationEngine::normalize(average.data(), rowSize);
+    output.resize(colSize);
+    SeedCorrelationEngine(average.data(), 1, rowSize).correlateCifti(myCifti, output.data(), true);
 }
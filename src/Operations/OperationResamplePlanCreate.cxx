@@ -0,0 +1,230 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "OperationResamplePlanCreate.h"
+#include "OperationException.h"
+
+#include "AlgorithmVolumeResample.h"
+#include "CaretLogger.h"
+#include "CiftiFile.h"
+#include "MetricFile.h"
+#include "NiftiIO.h"
+#include "ResamplePlan.h"
+#include "SurfaceFile.h"
+#include "SurfaceResamplingHelper.h"
+#include "WarpfieldFile.h"
+
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+AString OperationResamplePlanCreate::getCommandSwitch()
+{
+    return "-resample-plan-create";
+}
+
+AString OperationResamplePlanCreate::getShortDescription()
+{
+    return "PRECOMPUTE RESAMPLING WEIGHTS FOR REPEATED USE";
+}
+
+OperationParameters* OperationResamplePlanCreate::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+
+    ret->addStringParameter(1, "plan-out", "output - the resample plan file");
+
+    ParameterComponent* surfaceOpt = ret->createRepeatableParameter(2, "-surface", "add surface resampling weights");
+    surfaceOpt->addStringParameter(1, "structure", "the structure the weights are for, such as CORTEX_LEFT");
+    surfaceOpt->addSurfaceParameter(2, "current-sphere", "a sphere surface with the mesh that the data is currently on");
+    surfaceOpt->addSurfaceParameter(3, "new-sphere", "a sphere surface that is in register with <current-sphere> and has the desired output mesh");
+    surfaceOpt->addStringParameter(4, "method", "the surface resampling method name");
+    OptionalParameter* areaSurfsOpt = surfaceOpt->createOptionalParameter(5, "-area-surfs", "specify surfaces to do vertex area correction based on");
+    areaSurfsOpt->addSurfaceParameter(1, "current-area", "a relevant anatomical surface with <current-sphere> mesh");
+    areaSurfsOpt->addSurfaceParameter(2, "new-area", "a relevant anatomical surface with <new-sphere> mesh");
+    OptionalParameter* areaMetricsOpt = surfaceOpt->createOptionalParameter(6, "-area-metrics", "specify vertex area metrics to do area correction based on");
+    areaMetricsOpt->addMetricParameter(1, "current-area", "a metric file with vertex areas for <current-sphere> mesh");
+    areaMetricsOpt->addMetricParameter(2, "new-area", "a metric file with vertex areas for <new-sphere> mesh");
+    OptionalParameter* roiOpt = surfaceOpt->createOptionalParameter(7, "-current-roi", "use an input roi on the current mesh to exclude non-data vertices");
+    roiOpt->addMetricParameter(1, "roi-metric", "the roi, as a metric file");
+
+    OptionalParameter* ciftiRoiOpt = ret->createOptionalParameter(3, "-cifti-rois", "use the vertices of a cifti file as the current roi for -surface structures without -current-roi");
+    ciftiRoiOpt->addCiftiParameter(1, "cifti", "a cifti file with the brainordinates of the data to be resampled");
+    ciftiRoiOpt->addStringParameter(2, "direction", "which dimension has the brainordinates, ROW or COLUMN");
+
+    ParameterComponent* volumeOpt = ret->createRepeatableParameter(4, "-volume", "add volume resampling weights");
+    volumeOpt->addStringParameter(1, "volume-in-space", "a volume file in the volume space of the data to be resampled");
+    volumeOpt->addStringParameter(2, "volume-space", "a volume file in the volume space you want for the output");
+    volumeOpt->addStringParameter(3, "method", "the volume resampling method, TRILINEAR or ENCLOSING_VOXEL");
+    ParameterComponent* affineOpt = volumeOpt->createRepeatableParameter(4, "-affine", "add an affine transform");
+    affineOpt->addStringParameter(1, "affine", "the affine file to use");
+    OptionalParameter* flirtOpt = affineOpt->createOptionalParameter(2, "-flirt", "MUST be used if affine is a flirt affine");
+    flirtOpt->addStringParameter(1, "source-volume", "the source volume used when generating the affine");
+    flirtOpt->addStringParameter(2, "target-volume", "the target volume used when generating the affine");
+    ParameterComponent* warpOpt = volumeOpt->createRepeatableParameter(5, "-warp", "add a nonlinear warpfield transform");
+    warpOpt->addStringParameter(1, "warpfield", "the warpfield file");
+    OptionalParameter* fnirtOpt = warpOpt->createOptionalParameter(2, "-fnirt", "MUST be used if using a fnirt warpfield");
+    fnirtOpt->addStringParameter(1, "source-volume", "the source volume used when generating the warpfield");
+
+    AString myHelpText =
+        AString("Computes resampling weights once, so that resampling many files between the same spaces doesn't recompute them.  ") +
+        "Use the plan with the -plan option of -metric-resample, -label-resample, or -volume-resample, or the -surface-plan option of -cifti-resample.  " +
+        "Each set of weights is stored with a hash of everything that affects it (spheres, method, vertex areas, and roi, or the volume spaces, transforms, and method), " +
+        "and the resampling commands find the weights by computing the same hash from their own inputs, so a plan can't be applied to inputs it wasn't made for.  " +
+        "A plan may contain any number of surface and volume entries.\n\n" +
+        "The options of -surface have the same meaning as in -metric-resample.  " +
+        "For use with -cifti-resample, the current roi must be exactly the vertices used by the cifti file, specify -cifti-rois with a file that has the same brainordinates.\n\n" +
+        "The -affine and -warp options of -volume have the same meaning as in -volume-resample, and -volume-resample -plan must be given the same transforms to find the weights.  " +
+        "CUBIC resampling computes spline coefficients from the data, so it can't be precomputed, and -affine-series differs per frame, so it isn't supported.\n\n" +
+        "The surface <method> argument must be one of the following:\n\n";
+    vector<SurfaceResamplingMethodEnum::Enum> allEnums;
+    SurfaceResamplingMethodEnum::getAllEnums(allEnums);
+    for (int i = 0; i < (int)allEnums.size(); ++i)
+    {
+        myHelpText += SurfaceResamplingMethodEnum::toName(allEnums[i]) + "\n";
+    }
+    ret->setHelpText(myHelpText);
+    return ret;
+}
+
+void OperationResamplePlanCreate::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    AString planName = myParams->getString(1);
+    const vector<ParameterComponent*>& surfaceInstances = myParams->getRepeatableParameterInstances(2);
+    OptionalParameter* ciftiRoiOpt = myParams->getOptionalParameter(3);
+    const vector<ParameterComponent*>& volumeInstances = myParams->getRepeatableParameterInstances(4);
+    if (surfaceInstances.empty() && volumeInstances.empty()) throw OperationException("at least one -surface or -volume option must be specified");
+    const CiftiBrainModelsMap* ciftiModels = NULL;
+    if (ciftiRoiOpt->m_present)
+    {
+        AString dirString = ciftiRoiOpt->getString(2);
+        int direction = -1;
+        if (dirString == "ROW")
+        {
+            direction = CiftiXML::ALONG_ROW;
+        } else if (dirString == "COLUMN") {
+            direction = CiftiXML::ALONG_COLUMN;
+        } else {
+            throw OperationException("unrecognized direction string, use ROW or COLUMN");
+        }
+        const CiftiXML& myXML = ciftiRoiOpt->getCifti(1)->getCiftiXML();
+        if (myXML.getMappingType(direction) != CiftiMappingType::BRAIN_MODELS) throw OperationException("-cifti-rois file does not have brain models along the specified direction");
+        ciftiModels = &(myXML.getBrainModelsMap(direction));
+    }
+    ResamplePlan myPlan;
+    for (int i = 0; i < (int)surfaceInstances.size(); ++i)
+    {
+        ParameterComponent* thisSurface = surfaceInstances[i];
+        bool ok = false;
+        StructureEnum::Enum myStructure = StructureEnum::fromName(thisSurface->getString(1), &ok);
+        if (!ok) throw OperationException("unrecognized structure name: " + thisSurface->getString(1));
+        SurfaceFile* curSphere = thisSurface->getSurface(2);
+        SurfaceFile* newSphere = thisSurface->getSurface(3);
+        SurfaceResamplingMethodEnum::Enum myMethod = SurfaceResamplingMethodEnum::fromName(thisSurface->getString(4), &ok);
+        if (!ok) throw OperationException("invalid surface method name: " + thisSurface->getString(4));
+        vector<float> curAreas, newAreas;
+        OptionalParameter* areaSurfsOpt = thisSurface->getOptionalParameter(5);
+        OptionalParameter* areaMetricsOpt = thisSurface->getOptionalParameter(6);
+        if (areaSurfsOpt->m_present && areaMetricsOpt->m_present) throw OperationException("only one of -area-surfs and -area-metrics can be specified");
+        if (areaSurfsOpt->m_present)
+        {
+            SurfaceFile* curAreaSurf = areaSurfsOpt->getSurface(1);
+            SurfaceFile* newAreaSurf = areaSurfsOpt->getSurface(2);
+            curAreaSurf->computeNodeAreas(curAreas);
+            newAreaSurf->computeNodeAreas(newAreas);
+        }
+        if (areaMetricsOpt->m_present)
+        {
+            MetricFile* curAreaMetric = areaMetricsOpt->getMetric(1);
+            MetricFile* newAreaMetric = areaMetricsOpt->getMetric(2);
+            const float* curData = curAreaMetric->getValuePointerForColumn(0), *newData = newAreaMetric->getValuePointerForColumn(0);
+            curAreas.assign(curData, curData + curAreaMetric->getNumberOfNodes());
+            newAreas.assign(newData, newData + newAreaMetric->getNumberOfNodes());
+        }
+        const float* curAreaData = NULL, *newAreaData = NULL;
+        if (myMethod == SurfaceResamplingMethodEnum::ADAP_BARY_AREA)
+        {//same checks as -metric-resample
+            if (curAreas.empty() || newAreas.empty()) throw OperationException("specified method does area correction, but no vertex area data given for " + StructureEnum::toName(myStructure));
+            if ((int64_t)curAreas.size() != curSphere->getNumberOfNodes()) throw OperationException("current vertex area data has different number of nodes than current sphere");
+            if ((int64_t)newAreas.size() != newSphere->getNumberOfNodes()) throw OperationException("new vertex area data has different number of nodes than new sphere");
+            curAreaData = curAreas.data();
+            newAreaData = newAreas.data();
+        } else if (!curAreas.empty()) {
+            CaretLogInfo("This method does not use area correction, area options are not needed");
+        }
+        vector<float> roiData;
+        OptionalParameter* roiOpt = thisSurface->getOptionalParameter(7);
+        if (roiOpt->m_present)
+        {
+            MetricFile* roiMetric = roiOpt->getMetric(1);
+            if (roiMetric->getNumberOfNodes() != curSphere->getNumberOfNodes()) throw OperationException("roi metric has different number of nodes than input sphere");
+            const float* roiCol = roiMetric->getValuePointerForColumn(0);
+            roiData.assign(roiCol, roiCol + roiMetric->getNumberOfNodes());
+        } else if (ciftiModels != NULL) {
+            if (!ciftiModels->hasSurfaceData(myStructure)) throw OperationException("-cifti-rois file does not contain surface data for " + StructureEnum::toName(myStructure));
+            if (ciftiModels->getSurfaceNumberOfNodes(myStructure) != curSphere->getNumberOfNodes())
+            {
+                throw OperationException("-cifti-rois file has a different number of vertices than the current sphere for " + StructureEnum::toName(myStructure));
+            }
+            roiData.resize(curSphere->getNumberOfNodes(), 0.0f);//same as -cifti-resample makes
+            vector<CiftiBrainModelsMap::SurfaceMap> surfMap = ciftiModels->getSurfaceMap(myStructure);
+            for (int64_t j = 0; j < (int64_t)surfMap.size(); ++j)
+            {
+                roiData[surfMap[j].m_surfaceNode] = 1.0f;
+            }
+        }
+        const float* roiPtr = (roiData.empty() ? NULL : roiData.data());
+        myPlan.addSurfaceWeights(ResamplePlan::surfaceKey(myMethod, curSphere, newSphere, curAreaData, newAreaData, roiPtr),
+                                 SurfaceResamplingHelper(myMethod, curSphere, newSphere, curAreaData, newAreaData, roiPtr));
+    }
+    for (int i = 0; i < (int)volumeInstances.size(); ++i)
+    {
+        ParameterComponent* thisVolume = volumeInstances[i];
+        VolumeSpace inSpace, refSpace;
+        {
+            NiftiIO myIO;
+            myIO.openRead(thisVolume->getString(1));
+            inSpace = myIO.getHeader().getVolumeSpace();
+        }
+        {
+            NiftiIO myIO;
+            myIO.openRead(thisVolume->getString(2));
+            refSpace = myIO.getHeader().getVolumeSpace();
+        }
+        AString methodStr = thisVolume->getString(3);
+        VolumeFile::InterpType myMethod = VolumeFile::TRILINEAR;
+        if (methodStr == "TRILINEAR")
+        {
+            myMethod = VolumeFile::TRILINEAR;
+        } else if (methodStr == "ENCLOSING_VOXEL") {
+            myMethod = VolumeFile::ENCLOSING_VOXEL;
+        } else if (methodStr == "CUBIC") {
+            throw OperationException("CUBIC volume resampling can't be precomputed, use TRILINEAR or ENCLOSING_VOXEL");
+        } else {
+            throw OperationException("unrecognized interpolation method");
+        }
+        XfmStack myStack;
+        vector<WarpfieldFile> warpStorage;
+        AlgorithmVolumeResample::buildXfmStack(thisVolume, 4, -1, 5, 1, myStack, warpStorage);
+        myPlan.addVolumeWeights(ResamplePlan::volumeKey(inSpace, myStack, refSpace, myMethod), ResamplePlan::computeVolumeWeights(inSpace, myStack, refSpace, myMethod));
+    }
+    myPlan.writeFile(planName);
+}
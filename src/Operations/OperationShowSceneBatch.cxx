@@ -0,0 +1,614 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <fstream>
+#include <iostream>
+
+#include "OperationShowSceneBatch.h"
+
+#include "Brain.h"
+#include "BrowserWindowContent.h"
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "CaretPreferences.h"
+#include "DataFileException.h"
+#include "ElapsedTimer.h"
+#include "EventBrowserWindowContent.h"
+#include "EventGraphicsOpenGLDeleteTextureName.h"
+#include "EventImageCapture.h"
+#include "EventManager.h"
+#include "FileInformation.h"
+#include "OffScreenSceneRendererBase.h"
+#include "OperationException.h"
+#include "OperationShowSceneTwo.h"
+#include "Scene.h"
+#include "SceneAttributes.h"
+#include "SceneClass.h"
+#include "SceneFile.h"
+#include "SessionManager.h"
+#include "VolumeFile.h"
+
+using namespace caret;
+using namespace std;
+
+/**
+ * \class caret::OperationShowSceneBatch
+ * \brief Offscreen rendering of many scenes listed in a manifest file
+ *
+ * All scenes are rendered within one process so that the Brain and its
+ * data files, the scene files, and the offscreen rendering context are
+ * loaded once and reused by every job in the manifest.
+ */
+
+/**
+ * @return Command line switch
+ */
+AString
+OperationShowSceneBatch::getCommandSwitch()
+{
+    return "-show-scene-batch";
+}
+
+/**
+ * @return Short description of operation
+ */
+AString
+OperationShowSceneBatch::getShortDescription()
+{
+    return ("OFFSCREEN RENDERING OF MANY SCENES TO IMAGE FILES");
+}
+
+enum ParamKeys : int32_t {
+    PARAM_KEY_MANIFEST_FILE,
+    PARAM_KEY_OPTION_CONN_DB_LOGIN,
+    PARAM_KEY_OPTION_NO_SCENE_COLORS,
+    PARAM_KEY_OPTION_RENDERER,
+    PARAM_KEY_OPTION_CONTINUE_ON_ERROR
+};
+
+/**
+ * @return Parameters for operation
+ */
+OperationParameters*
+OperationShowSceneBatch::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+
+    ret->addStringParameter(PARAM_KEY_MANIFEST_FILE,
+                            "manifest-file",
+                            "text file listing the images to render, one per line");
+
+    ret->createOptionalParameter(PARAM_KEY_OPTION_NO_SCENE_COLORS,
+                                 "-no-scene-colors",
+                                 "Do not use background and foreground colors in scenes");
+
+    OptionalParameter* connDbOpt = ret->createOptionalParameter(PARAM_KEY_OPTION_CONN_DB_LOGIN,
+                                                                "-conn-db-login",
+                                                                "Login for scenes with files in Connectome Database.  If "
+                                                                "this option is not specified, the login and password stored "
+                                                                "in the user's preferences is used.");
+    connDbOpt->addStringParameter(1,
+                                  "username",
+                                  "Connectome DB Username");
+    connDbOpt->addStringParameter(2,
+                                  "password",
+                                  "Connectome DB Password");
+
+    std::vector<std::unique_ptr<OffScreenSceneRendererBase>> allOffScreenRenderers(OperationShowSceneTwo::getOffScreenRenderers());
+    AString renderersListText;
+    if ( ! allOffScreenRenderers.empty()) {
+        renderersListText += ("\n   Available renderers are (first is default):\n");
+        for (const auto& osr : allOffScreenRenderers) {
+            renderersListText += (  "   " + osr->getSwitchName() + " - "
+                                  + osr->getDescriptiveName() + "\n");
+        }
+    }
+    OptionalParameter* rendererOpt = ret->createOptionalParameter(PARAM_KEY_OPTION_RENDERER,
+                                                                  "-renderer",
+                                                                  "Select renderer for drawing images");
+    rendererOpt->addStringParameter(1, "Renderer",
+                                    ("Name of renderer to use for drawing images"
+                                     + renderersListText));
+
+    ret->createOptionalParameter(PARAM_KEY_OPTION_CONTINUE_ON_ERROR,
+                                 "-continue-on-error",
+                                 "If a job fails, print the error and continue with the remaining jobs");
+
+    ret->setHelpText("Render the scenes listed in a manifest file into image files.  "
+                     "Each non-empty line of the manifest file that does not start with '#' "
+                     "is one job with these whitespace separated fields:\n\n"
+                     "   <scene-file> <scene-name-or-number> <image-file> [<width> <height> [<window-number>]]\n\n"
+                     "Fields that contain spaces (such as scene names) must be enclosed in double quotes.  "
+                     "Relative file names are relative to the directory containing the manifest file.  "
+                     "If width and height are not given or are zero, the size of the window saved in the "
+                     "scene is used.  If the window number (starting at one) is not given or is zero, every "
+                     "window in the scene is rendered and, when there is more than one window, the window's "
+                     "number is inserted into the image file name immediately before its extension.\n\n"
+                     "All jobs are rendered in one process.  Scene files are read once, a scene is restored "
+                     "only when it differs from the scene of the previous job, and data files that are "
+                     "unmodified and still referenced by the next scene are kept in memory instead of "
+                     "being read again.  Ordering jobs so that scenes using the same data files are adjacent "
+                     "maximizes this reuse.  The offscreen rendering context is created once and resized "
+                     "for each image.");
+
+    return ret;
+}
+
+/**
+ * Use Parameters and perform operation
+ */
+void
+OperationShowSceneBatch::useParameters(OperationParameters* myParams,
+                                       ProgressObject* myProgObj)
+{
+    EventGraphicsOpenGLDeleteTextureName::setDisableFailureToDeleteWarningMessages(true);
+
+    LevelProgress myProgress(myProgObj);
+
+    const AString manifestFileName = FileInformation(myParams->getString(PARAM_KEY_MANIFEST_FILE)).getAbsoluteFilePath();
+    const bool doNotUseSceneColorsFlag = myParams->getOptionalParameter(PARAM_KEY_OPTION_NO_SCENE_COLORS)->m_present;
+    const bool continueOnErrorFlag = myParams->getOptionalParameter(PARAM_KEY_OPTION_CONTINUE_ON_ERROR)->m_present;
+
+    std::vector<std::unique_ptr<OffScreenSceneRendererBase>> allOffScreenRenderers(OperationShowSceneTwo::getOffScreenRenderers());
+    if (allOffScreenRenderers.empty()) {
+        throw OperationException("No offscreen renderers are available");
+    }
+    OffScreenSceneRendererBase* offscreenRenderer(allOffScreenRenderers[0].get());
+    OptionalParameter* rendererOpt = myParams->getOptionalParameter(PARAM_KEY_OPTION_RENDERER);
+    if (rendererOpt->m_present) {
+        const AString rendererName(rendererOpt->getString(1).toLower());
+
+        bool foundFlag(false);
+        for (auto& osr : allOffScreenRenderers) {
+            if (rendererName == osr->getSwitchName().toLower()) {
+                offscreenRenderer = osr.get();
+                foundFlag = true;
+            }
+        }
+        if ( ! foundFlag) {
+            throw OperationException("Selected renderer with name \""
+                                     + rendererName
+                                     + " is not the name of a valid renderer on this system.");
+        }
+    }
+    if ( ! offscreenRenderer->isAvailable()) {
+        throw OperationException(offscreenRenderer->getSwitchName() + " is not available on this system.");
+    }
+
+    AString username;
+    AString password;
+    OptionalParameter* connDbOpt = myParams->getOptionalParameter(PARAM_KEY_OPTION_CONN_DB_LOGIN);
+    if (connDbOpt->m_present) {
+        username = connDbOpt->getString(1);
+        password = connDbOpt->getString(2);
+    }
+    OperationShowSceneTwo::setRemoteLoginAndPassword(username,
+                                                     password);
+
+    const std::vector<Job> jobs = readManifestFile(manifestFileName);
+    if (jobs.empty()) {
+        throw OperationException("No jobs were found in manifest file " + manifestFileName);
+    }
+
+    /*
+     * Enable voxel coloring since it is defaulted off for commands
+     */
+    VolumeFile::setVoxelColoringEnabled(true);
+
+    std::map<AString, std::unique_ptr<SceneFile>> sceneFileCache;
+    AString restoredSceneFileName;
+    AString restoredSceneNameOrNumber;
+    AString sceneErrorMessage;
+    int32_t numberOfFailedJobs(0);
+
+    const int32_t numJobs = static_cast<int32_t>(jobs.size());
+    for (int32_t iJob = 0; iJob < numJobs; iJob++) {
+        CaretAssertVectorIndex(jobs, iJob);
+        const Job& job = jobs[iJob];
+
+        ElapsedTimer timer;
+        timer.start();
+
+        try {
+            /*
+             * Only restore the scene when it differs from the scene that
+             * was restored for the previous job.  Files that are not
+             * modified are kept by Brain when the next scene is restored.
+             */
+            if ((job.m_sceneFileName != restoredSceneFileName)
+                || (job.m_sceneNameOrNumber != restoredSceneNameOrNumber)) {
+                restoredSceneFileName.clear();
+                restoredSceneNameOrNumber.clear();
+
+                SceneFile* sceneFile = getSceneFile(sceneFileCache,
+                                                    job.m_sceneFileName);
+                restoreScene(sceneFile,
+                             job.m_sceneNameOrNumber,
+                             doNotUseSceneColorsFlag,
+                             sceneErrorMessage);
+                if ( ! sceneErrorMessage.isEmpty()) {
+                    std::cerr << "ERRORS loading scene " << job.m_sceneNameOrNumber
+                    << " from " << job.m_sceneFileName
+                    << ", output image may be incorrect." << std::endl;
+                    std::cerr << sceneErrorMessage << std::endl;
+                }
+
+                restoredSceneFileName     = job.m_sceneFileName;
+                restoredSceneNameOrNumber = job.m_sceneNameOrNumber;
+            }
+
+            renderJob(job,
+                      offscreenRenderer,
+                      doNotUseSceneColorsFlag);
+        }
+        catch (const CaretException& e) {
+            const AString msg("Manifest line "
+                              + AString::number(job.m_lineNumber)
+                              + " ("
+                              + job.m_imageFileName
+                              + ") failed: "
+                              + e.whatString());
+            if ( ! continueOnErrorFlag) {
+                throw OperationException(msg);
+            }
+            std::cerr << msg << std::endl;
+            ++numberOfFailedJobs;
+
+            /*
+             * Scene may be partially restored, force restoring for next job
+             */
+            restoredSceneFileName.clear();
+            restoredSceneNameOrNumber.clear();
+        }
+
+        CaretLogFine("Job " + AString::number(iJob + 1) + " of " + AString::number(numJobs)
+                     + " (" + job.m_imageFileName + ") took "
+                     + AString::number(timer.getElapsedTimeSeconds(), 'f', 3)
+                     + " seconds");
+
+        myProgress.reportProgress(static_cast<float>(iJob + 1) / static_cast<float>(numJobs));
+    }
+
+    if (numberOfFailedJobs > 0) {
+        throw OperationException(AString::number(numberOfFailedJobs)
+                                 + " of "
+                                 + AString::number(numJobs)
+                                 + " jobs failed");
+    }
+}
+
+/**
+ * Read the jobs from the manifest file.
+ *
+ * @param manifestFileName
+ *     Absolute path of the manifest file.
+ * @return
+ *     The jobs in the order they are listed in the file.
+ */
+std::vector<OperationShowSceneBatch::Job>
+OperationShowSceneBatch::readManifestFile(const AString& manifestFileName)
+{
+    fstream manifestFile(manifestFileName.toLocal8Bit().constData(), fstream::in);
+    if ( ! manifestFile.good()) {
+        throw OperationException("error opening manifest file " + manifestFileName);
+    }
+    const AString manifestDirectory = FileInformation(manifestFileName).getAbsolutePath();
+
+    auto makeAbsolute = [&](const AString& name) -> AString {
+        FileInformation fileInfo(name);
+        if (fileInfo.isAbsolute()) {
+            return name;
+        }
+        return FileInformation(manifestDirectory, name).getAbsoluteFilePath();
+    };
+
+    std::vector<Job> jobs;
+    string line;
+    int32_t lineNumber(0);
+    while (getline(manifestFile, line)) {
+        ++lineNumber;
+        const std::vector<AString> fields = splitManifestLine(line);
+        if (fields.empty()) {
+            continue;
+        }
+        if (fields[0].startsWith("#")) {
+            continue;
+        }
+        const int32_t numFields = static_cast<int32_t>(fields.size());
+        if ((numFields != 3)
+            && (numFields != 5)
+            && (numFields != 6)) {
+            throw OperationException("Manifest line "
+                                     + AString::number(lineNumber)
+                                     + " must contain 3, 5, or 6 fields but contains "
+                                     + AString::number(numFields));
+        }
+
+        Job job;
+        job.m_lineNumber        = lineNumber;
+        job.m_sceneFileName     = makeAbsolute(fields[0]);
+        job.m_sceneNameOrNumber = fields[1];
+        job.m_imageFileName     = makeAbsolute(fields[2]);
+        if (numFields >= 5) {
+            bool widthValid(false), heightValid(false);
+            job.m_imageWidth  = fields[3].toInt(&widthValid);
+            job.m_imageHeight = fields[4].toInt(&heightValid);
+            if (( ! widthValid)
+                || ( ! heightValid)
+                || (job.m_imageWidth < 0)
+                || (job.m_imageHeight < 0)
+                || ((job.m_imageWidth > 0) != (job.m_imageHeight > 0))) {
+                throw OperationException("Manifest line "
+                                         + AString::number(lineNumber)
+                                         + " has invalid image width and/or height");
+            }
+        }
+        if (numFields == 6) {
+            bool windowValid(false);
+            job.m_windowNumber = fields[5].toInt(&windowValid);
+            if (( ! windowValid)
+                || (job.m_windowNumber < 0)) {
+                throw OperationException("Manifest line "
+                                         + AString::number(lineNumber)
+                                         + " has invalid window number");
+            }
+        }
+        jobs.push_back(job);
+    }
+
+    return jobs;
+}
+
+/**
+ * Split a line from the manifest into fields separated by whitespace.
+ * Double quotes group characters, including whitespace, into one field.
+ *
+ * @param line
+ *     Line from the manifest file.
+ * @return
+ *     The fields.
+ */
+std::vector<AString>
+OperationShowSceneBatch::splitManifestLine(const std::string& line)
+{
+    std::vector<AString> fields;
+    std::string field;
+    bool inFieldFlag(false);
+    bool inQuotesFlag(false);
+    for (const char c : line) {
+        if (c == '"') {
+            inQuotesFlag = ( ! inQuotesFlag);
+            inFieldFlag = true;
+        }
+        else if (( ! inQuotesFlag)
+                 && ((c == ' ') || (c == '\t') || (c == '\r'))) {
+            if (inFieldFlag) {
+                fields.push_back(AString::fromLocal8Bit(field.c_str()));
+                field.clear();
+                inFieldFlag = false;
+            }
+        }
+        else {
+            field.push_back(c);
+            inFieldFlag = true;
+        }
+    }
+    if (inFieldFlag) {
+        fields.push_back(AString::fromLocal8Bit(field.c_str()));
+    }
+
+    return fields;
+}
+
+/**
+ * Get a scene file, reading it only the first time it is requested.
+ *
+ * @param sceneFileCache
+ *     Scene files that have been read, keyed by absolute file name.
+ * @param sceneFileName
+ *     Absolute name of the scene file.
+ * @return
+ *     The scene file.
+ */
+SceneFile*
+OperationShowSceneBatch::getSceneFile(std::map<AString, std::unique_ptr<SceneFile>>& sceneFileCache,
+                                      const AString& sceneFileName)
+{
+    auto iter = sceneFileCache.find(sceneFileName);
+    if (iter != sceneFileCache.end()) {
+        return iter->second.get();
+    }
+
+    std::unique_ptr<SceneFile> sceneFile(new SceneFile());
+    try {
+        sceneFile->readFile(sceneFileName);
+    }
+    catch (const DataFileException& dfe) {
+        throw OperationException(dfe);
+    }
+    SceneFile* sceneFilePointer = sceneFile.get();
+    sceneFileCache.insert(std::make_pair(sceneFileName,
+                                         std::move(sceneFile)));
+    return sceneFilePointer;
+}
+
+/**
+ * Restore a scene from a scene file.
+ *
+ * @param sceneFile
+ *     The scene file.
+ * @param sceneNameOrNumber
+ *     Either the scene number (starting at one) or name
+ * @param doNotUseSceneColorsFlag
+ *     Do not use background/foreground colors from the scene
+ * @param errorMessageOut
+ *     Output with error information
+ */
+void
+OperationShowSceneBatch::restoreScene(SceneFile* sceneFile,
+                                      const AString& sceneNameOrNumber,
+                                      const bool doNotUseSceneColorsFlag,
+                                      AString& errorMessageOut)
+{
+    CaretAssert(sceneFile);
+
+    Scene* scene = sceneFile->getSceneWithName(sceneNameOrNumber);
+    if (scene == NULL) {
+        bool valid = false;
+        const int32_t sceneIndexStartAtOne = sceneNameOrNumber.toInt(&valid);
+        if (valid) {
+            const int32_t sceneIndex = sceneIndexStartAtOne - 1;
+            if ((sceneIndex >= 0)
+                && (sceneIndex < sceneFile->getNumberOfScenes())) {
+                scene = sceneFile->getSceneAtIndex(sceneIndex);
+            }
+            else {
+                throw OperationException("Scene index is invalid");
+            }
+        }
+        else {
+            throw OperationException("Scene name is invalid");
+        }
+    }
+
+    SceneAttributes sceneAttributes(SceneTypeEnum::SCENE_TYPE_FULL,
+                                    scene);
+    sceneAttributes.setSceneFileName(sceneFile->getFileName());
+    if (doNotUseSceneColorsFlag) {
+        sceneAttributes.setUseSceneForegroundAndBackgroundColors(false);
+    }
+
+    const SceneClass* guiManagerClass = scene->getClassWithName("guiManager");
+    if (guiManagerClass->getName() != "guiManager") {
+        throw OperationException("Top level scene class should be guiManager but it is: "
+                                 + guiManagerClass->getName());
+    }
+
+    SessionManager* sessionManager = SessionManager::get();
+    sessionManager->restoreFromScene(&sceneAttributes,
+                                     guiManagerClass->getClass("m_sessionManager"));
+
+    errorMessageOut = sceneAttributes.getErrorMessage();
+
+    if (sessionManager->getNumberOfBrains() <= 0) {
+        throw OperationException("Scene loading failure, SessionManager contains no Brains");
+    }
+}
+
+/**
+ * Render the windows of the restored scene for a job.
+ *
+ * @param job
+ *     The job.
+ * @param offscreenRenderer
+ *     Renderer used for all jobs.
+ * @param doNotUseSceneColorsFlag
+ *     Do not use background/foreground colors from the scene
+ */
+void
+OperationShowSceneBatch::renderJob(const Job& job,
+                                   OffScreenSceneRendererBase* offscreenRenderer,
+                                   const bool doNotUseSceneColorsFlag)
+{
+    std::vector<BrowserWindowContent*> allBrowserWindowContent;
+    for (int32_t i = 0; i < BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_WINDOWS; i++) {
+        std::unique_ptr<EventBrowserWindowContent> browserContentEvent = EventBrowserWindowContent::getWindowContent(i);
+        EventManager::get()->sendEvent(browserContentEvent->getPointer());
+        BrowserWindowContent* bwc = browserContentEvent->getBrowserWindowContent();
+        CaretAssert(bwc);
+        if (bwc->isValid()) {
+            allBrowserWindowContent.push_back(bwc);
+        }
+    }
+    const int32_t numberOfWindows = static_cast<int32_t>(allBrowserWindowContent.size());
+    if (numberOfWindows <= 0) {
+        throw OperationException("No BrowserWindowContent was found for showing as scene.");
+    }
+    if (job.m_windowNumber > numberOfWindows) {
+        throw OperationException("Window number "
+                                 + AString::number(job.m_windowNumber)
+                                 + " is invalid, scene contains "
+                                 + AString::number(numberOfWindows)
+                                 + " window(s)");
+    }
+
+    uint8_t backgroundColor[4];
+    const CaretPreferences* prefs = SessionManager::get()->getCaretPreferences();
+    prefs->getBackgroundAndForegroundColors()->getColorBackgroundWindow(backgroundColor);
+
+    for (int32_t iWindow = 0; iWindow < numberOfWindows; iWindow++) {
+        if (job.m_windowNumber > 0) {
+            if (iWindow != (job.m_windowNumber - 1)) {
+                continue;
+            }
+        }
+
+        CaretAssertVectorIndex(allBrowserWindowContent, iWindow);
+        BrowserWindowContent* bwc = allBrowserWindowContent[iWindow];
+
+        int32_t imageWidth  = job.m_imageWidth;
+        int32_t imageHeight = job.m_imageHeight;
+        if ((imageWidth <= 0)
+            || (imageHeight <= 0)) {
+            imageWidth  = static_cast<int32_t>(bwc->getSceneGraphicsWidth());
+            imageHeight = static_cast<int32_t>(bwc->getSceneGraphicsHeight());
+            if ((imageWidth <= 0)
+                || (imageHeight <= 0)) {
+                throw OperationException("Width and/or height of window from scene is invalid or missing (old scene).  "
+                                         "Width and height must be specified in the manifest.");
+            }
+        }
+
+        EventImageCapture captureEvent(bwc->getWindowIndex(),
+                                       0,
+                                       0,
+                                       imageWidth,
+                                       imageHeight,
+                                       imageWidth,
+                                       imageHeight,
+                                       OperationShowSceneTwo::s_defaultImageWidthHeightUnits,
+                                       OperationShowSceneTwo::s_defaultResolutionUnits,
+                                       OperationShowSceneTwo::s_defaultResolutionNumberOfPixels);
+        captureEvent.setMargin(0);
+        captureEvent.setBackgroundColor(backgroundColor);
+
+        const int32_t outputImageIndex = (((numberOfWindows > 1)
+                                           && (job.m_windowNumber == 0))
+                                          ? iWindow
+                                          : -1);
+        OperationShowSceneTwo::Inputs inputs(offscreenRenderer,
+                                             bwc,
+                                             &captureEvent,
+                                             job.m_imageFileName,
+                                             outputImageIndex,
+                                             doNotUseSceneColorsFlag);
+        OperationShowSceneTwo::renderWindowToImage(inputs);
+    }
+}
+
+/**
+ * Is the show scene batch command available?
+ */
+bool
+OperationShowSceneBatch::isShowSceneCommandAvailable()
+{
+    return OperationShowSceneTwo::isShowSceneCommandAvailable();
+}
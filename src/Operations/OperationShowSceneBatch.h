@@ -0,0 +1,94 @@
+#ifndef __OPERATION_SHOW_SCENE_BATCH_H__
+#define __OPERATION_SHOW_SCENE_BATCH_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "AbstractOperation.h"
+
+namespace caret {
+
+    class OffScreenSceneRendererBase;
+    class SceneFile;
+
+    class OperationShowSceneBatch : public AbstractOperation {
+
+    public:
+        static OperationParameters* getParameters();
+
+        static void useParameters(OperationParameters* myParams,
+                                  ProgressObject* myProgObj);
+
+        static AString getCommandSwitch();
+
+        static AString getShortDescription();
+
+        static bool isShowSceneCommandAvailable();
+
+    private:
+        /**
+         * One line of the manifest: a scene rendered to an image
+         */
+        class Job {
+        public:
+            AString m_sceneFileName;
+
+            AString m_sceneNameOrNumber;
+
+            AString m_imageFileName;
+
+            /** Window number starting at one, or zero for all windows */
+            int32_t m_windowNumber = 0;
+
+            /** Image width, or zero for window width from scene */
+            int32_t m_imageWidth = 0;
+
+            /** Image height, or zero for window height from scene */
+            int32_t m_imageHeight = 0;
+
+            int32_t m_lineNumber = 0;
+        };
+
+        static std::vector<Job> readManifestFile(const AString& manifestFileName);
+
+        static std::vector<AString> splitManifestLine(const std::string& line);
+
+        static SceneFile* getSceneFile(std::map<AString, std::unique_ptr<SceneFile>>& sceneFileCache,
+                                       const AString& sceneFileName);
+
+        static void restoreScene(SceneFile* sceneFile,
+                                 const AString& sceneNameOrNumber,
+                                 const bool doNotUseSceneColorsFlag,
+                                 AString& errorMessageOut);
+
+        static void renderJob(const Job& job,
+                              OffScreenSceneRendererBase* offscreenRenderer,
+                              const bool doNotUseSceneColorsFlag);
+    };
+
+    typedef TemplateAutoOperation<OperationShowSceneBatch> AutoOperationShowSceneBatch;
+
+} // namespace
+
+#endif  //__OPERATION_SHOW_SCENE_BATCH_H__
@@ -979,17 +979,6 @@ OperationShowSceneTwo::renderWindowToImage(Inputs& inputs)
     CaretAssert(imageWidth > 0);
     CaretAssert(imageHeight > 0);
     
-    /*
-     * Allocate image buffer
-     */
-    const int32_t imageBufferSize = imageWidth * imageHeight * 4 * sizeof(unsigned char);
-    unsigned char* imageBuffer = new unsigned char[imageBufferSize];
-    if (imageBuffer == 0) {
-        throw OperationException("Allocating image buffer size="
-                                 + QString::number(imageBufferSize)
-                                 + " failed.");
-    }
-    
     std::unique_ptr<BrainOpenGL> brainOpenGL;
     
     if ( ! inputs.m_offscreenRenderer->initialize(imageWidth,
@@ -60,6 +60,11 @@ namespace caret {
         static bool isShowSceneCommandAvailable();
         
     private:
+        /*
+         * Batch rendering reuses the scene restoring and window rendering
+         */
+        friend class OperationShowSceneBatch;
+        
         class Inputs {
         public:
             Inputs(OffScreenSceneRendererBase* offscreenRenderer,
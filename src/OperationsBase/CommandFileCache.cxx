@@ -0,0 +1,189 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CommandFileCache.h"
+
+#include "CaretLogger.h"
+#include "CiftiFile.h"
+#include "FileInformation.h"
+#include "MetricFile.h"
+#include "SurfaceFile.h"
+#include "VolumeFile.h"
+
+using namespace caret;
+using namespace std;
+
+map<AString, CommandFileCache::Entry> CommandFileCache::s_entries;
+CaretMutex CommandFileCache::s_mutex;
+bool CommandFileCache::s_enabled = false;
+int64_t CommandFileCache::s_maxBytes = 0;
+int64_t CommandFileCache::s_totalCost = 0;
+int64_t CommandFileCache::s_useCounter = 0;
+
+namespace
+{
+    const int MAX_ENTRIES = 256;//on-disk cifti files hold a file descriptor each
+}
+
+void CommandFileCache::setEnabled(const bool& enabled, const int64_t& maxBytes)
+{
+    CaretMutexLocker locked(&s_mutex);
+    s_enabled = enabled;
+    s_maxBytes = maxBytes;
+    if (!enabled)
+    {
+        s_entries.clear();
+        s_totalCost = 0;
+    }
+}
+
+CommandFileCache::Entry& CommandFileCache::findEntry(const AString& filename, AString& keyOut)
+{//returns an empty entry if the file is new or changed on disk, caller must hold the mutex
+    FileInformation myInfo(filename);
+    keyOut = myInfo.getCanonicalFilePath();
+    if (keyOut.isEmpty()) keyOut = myInfo.getAbsoluteFilePath();//doesn't exist, let the file class throw the error
+    int64_t fileSize = myInfo.size();
+    int64_t modifiedTime = myInfo.getLastModified().toMSecsSinceEpoch();
+    map<AString, Entry>::iterator iter = s_entries.find(keyOut);
+    if (iter != s_entries.end() && (iter->second.m_fileSize != fileSize || iter->second.m_modifiedTime != modifiedTime))
+    {
+        CaretLogFine("reloading changed file '" + filename + "'");
+        s_totalCost -= iter->second.m_memoryCost;
+        s_entries.erase(iter);
+        iter = s_entries.end();
+    }
+    if (iter == s_entries.end())
+    {
+        iter = s_entries.insert(make_pair(keyOut, Entry())).first;
+        iter->second.m_fileSize = fileSize;
+        iter->second.m_modifiedTime = modifiedTime;
+    }
+    iter->second.m_lastUse = ++s_useCounter;
+    return iter->second;
+}
+
+void CommandFileCache::finishEntry(Entry& entry)
+{
+    s_totalCost -= entry.m_memoryCost;
+    entry.m_memoryCost = 0;
+    if (entry.m_surface != NULL || entry.m_metric != NULL || entry.m_volume != NULL) entry.m_memoryCost += entry.m_fileSize;//compressed volumes are larger in memory, but this is close enough to keep the cache bounded
+    if (entry.m_cifti != NULL && entry.m_ciftiInMemory) entry.m_memoryCost += entry.m_fileSize;
+    s_totalCost += entry.m_memoryCost;
+}
+
+void CommandFileCache::evict(const AString& keepKey)
+{//drop least recently used files until under the limits, but never the file just requested
+    while (s_totalCost > s_maxBytes || (int)s_entries.size() > MAX_ENTRIES)
+    {
+        map<AString, Entry>::iterator oldest = s_entries.end();
+        for (map<AString, Entry>::iterator iter = s_entries.begin(); iter != s_entries.end(); ++iter)
+        {
+            if (iter->first == keepKey) continue;
+            if (oldest == s_entries.end() || iter->second.m_lastUse < oldest->second.m_lastUse) oldest = iter;
+        }
+        if (oldest == s_entries.end()) return;
+        s_totalCost -= oldest->second.m_memoryCost;
+        s_entries.erase(oldest);
+    }
+}
+
+CaretPointer<SurfaceFile> CommandFileCache::getSurface(const AString& filename)
+{
+    CaretMutexLocker locked(&s_mutex);
+    AString key;
+    Entry& myEntry = findEntry(filename, key);
+    if (myEntry.m_surface == NULL)
+    {
+        CaretPointer<SurfaceFile> newFile(new SurfaceFile());
+        newFile->readFile(filename);
+        myEntry.m_surface = newFile;
+        finishEntry(myEntry);
+        evict(key);
+    }
+    return myEntry.m_surface;
+}
+
+CaretPointer<MetricFile> CommandFileCache::getMetric(const AString& filename)
+{
+    CaretMutexLocker locked(&s_mutex);
+    AString key;
+    Entry& myEntry = findEntry(filename, key);
+    if (myEntry.m_metric == NULL)
+    {
+        CaretPointer<MetricFile> newFile(new MetricFile());
+        newFile->readFile(filename);
+        myEntry.m_metric = newFile;
+        finishEntry(myEntry);
+        evict(key);
+    }
+    return myEntry.m_metric;
+}
+
+CaretPointer<VolumeFile> CommandFileCache::getVolume(const AString& filename)
+{
+    CaretMutexLocker locked(&s_mutex);
+    AString key;
+    Entry& myEntry = findEntry(filename, key);
+    if (myEntry.m_volume == NULL)
+    {
+        CaretPointer<VolumeFile> newFile(new VolumeFile());
+        newFile->readFile(filename);
+        myEntry.m_volume = newFile;
+        finishEntry(myEntry);
+        evict(key);
+    }
+    return myEntry.m_volume;
+}
+
+CaretPointer<CiftiFile> CommandFileCache::getCifti(const AString& filename, const bool& inMemory)
+{
+    CaretMutexLocker locked(&s_mutex);
+    AString key;
+    Entry& myEntry = findEntry(filename, key);
+    if (myEntry.m_cifti == NULL || (inMemory && !myEntry.m_ciftiInMemory))
+    {
+        CaretPointer<CiftiFile> newFile(new CiftiFile());
+        newFile->openFile(filename);
+        if (inMemory)
+        {
+            newFile->convertToInMemory();
+        }
+        myEntry.m_cifti = newFile;
+        myEntry.m_ciftiInMemory = inMemory;
+        finishEntry(myEntry);
+        evict(key);
+    }
+    return myEntry.m_cifti;
+}
+
+void CommandFileCache::invalidate(const AString& filename)
+{
+    CaretMutexLocker locked(&s_mutex);
+    if (s_entries.empty()) return;
+    FileInformation myInfo(filename);
+    AString key = myInfo.getCanonicalFilePath();
+    if (key.isEmpty()) key = myInfo.getAbsoluteFilePath();
+    map<AString, Entry>::iterator iter = s_entries.find(key);
+    if (iter != s_entries.end())
+    {
+        s_totalCost -= iter->second.m_memoryCost;
+        s_entries.erase(iter);
+    }
+}
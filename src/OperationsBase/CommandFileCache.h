@@ -0,0 +1,78 @@
+#ifndef __COMMAND_FILE_CACHE_H__
+#define __COMMAND_FILE_CACHE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AString.h"
+#include "CaretMutex.h"
+#include "CaretPointer.h"
+
+#include <map>
+#include <stdint.h>
+
+namespace caret {
+
+    class CiftiFile;
+    class MetricFile;
+    class SurfaceFile;
+    class VolumeFile;
+
+    ///keeps input files loaded between commands of a batch script, keyed by canonical path, and reloads them if their size or modification time changed
+    ///files from the cache are shared between commands, so they must be treated as read-only, which inputs already should be
+    class CommandFileCache
+    {
+        struct Entry
+        {
+            CaretPointer<SurfaceFile> m_surface;
+            CaretPointer<MetricFile> m_metric;
+            CaretPointer<VolumeFile> m_volume;
+            CaretPointer<CiftiFile> m_cifti;
+            bool m_ciftiInMemory;
+            int64_t m_fileSize, m_modifiedTime, m_memoryCost, m_lastUse;
+            Entry() { m_ciftiInMemory = false; m_fileSize = -1; m_modifiedTime = -1; m_memoryCost = 0; m_lastUse = 0; }
+        };
+        static std::map<AString, Entry> s_entries;
+        static CaretMutex s_mutex;
+        static bool s_enabled;
+        static int64_t s_maxBytes, s_totalCost, s_useCounter;
+
+        static Entry& findEntry(const AString& filename, AString& keyOut);
+        static void finishEntry(Entry& entry);
+        static void evict(const AString& keepKey);
+    public:
+        ///disabling also releases all cached files
+        static void setEnabled(const bool& enabled, const int64_t& maxBytes = 2048LL * 1024 * 1024);
+        static bool isEnabled() { return s_enabled; }
+
+        ///these read the file if it isn't cached or changed on disk, and throw on read errors like the file classes do
+        static CaretPointer<SurfaceFile> getSurface(const AString& filename);
+        static CaretPointer<MetricFile> getMetric(const AString& filename);
+        static CaretPointer<VolumeFile> getVolume(const AString& filename);
+        ///cifti files opened on disk hold the file open and use little memory, in-memory requests reload a file that was cached on disk
+        static CaretPointer<CiftiFile> getCifti(const AString& filename, const bool& inMemory);
+
+        ///forget a file that is about to be written
+        static void invalidate(const AString& filename);
+    };
+
+}
+
+#endif //__COMMAND_FILE_CACHE_H__
@@ -28,6 +28,7 @@
 #include "BorderFile.h"
 #include "CaretDataFileHelper.h"
 #include "CiftiFile.h"
+#include "CommandFileCache.h"
 #include "FociFile.h"
 #include "LabelFile.h"
 #include "MetricFile.h"
@@ -628,14 +629,16 @@ void OperationParameters::setHelpText(const AString& textIn)
     m_helpText = textIn;
 }
 
-void ParameterComponent::addCiftiOutputParameter(const int32_t key, const AString& name, const AString& description)
+void ParameterComponent::addCiftiOutputParameter(const int32_t key, const AString& name, const AString& description, const bool& onDiskWrite)
 {
     if (!checkUniqueOutput(key, OperationParametersEnum::CIFTI))
     {
         CaretAssert(false);
         throw ProgramParametersException("output cifti parameter created with previously used key");
     }
-    m_outputList.push_back(new CiftiParameter(key, name, description));
+    CiftiParameter* myParam = new CiftiParameter(key, name, description);
+    myParam->m_doOnDiskWrite = onDiskWrite;
+    m_outputList.push_back(myParam);
 }
 
 void ParameterComponent::addFociOutputParameter(const int32_t key, const AString& name, const AString& description)
@@ -776,10 +779,15 @@ CiftiFile* ParameterComponent::getCifti(const int32_t key)
     {
         try
         {
-            myParam->lazyGet()->openFile(myParam->m_filename);
-            if (caret_global_command_options.m_ciftiReadMemory)
+            if (CommandFileCache::isEnabled())
             {
-                myParam->m_parameter->convertToInMemory();
+                myParam->m_parameter = CommandFileCache::getCifti(myParam->m_filename, caret_global_command_options.m_ciftiReadMemory);
+            } else {
+                myParam->lazyGet()->openFile(myParam->m_filename);
+                if (caret_global_command_options.m_ciftiReadMemory)
+                {
+                    myParam->m_parameter->convertToInMemory();
+                }
             }
         } catch (const bad_alloc&) {
             throw DataFileException(myParam->m_filename, CaretDataFileHelper::createBadAllocExceptionMessage(myParam->m_filename));
@@ -828,7 +836,12 @@ MetricFile* ParameterComponent::getMetric(const int32_t key)
     {
         try
         {
-            myParam->lazyGet()->readFile(myParam->m_filename);
+            if (CommandFileCache::isEnabled())
+            {
+                myParam->m_parameter = CommandFileCache::getMetric(myParam->m_filename);
+            } else {
+                myParam->lazyGet()->readFile(myParam->m_filename);
+            }
             m_provHelper->addToProvenance(myParam->m_parameter->getFileMetaData(), myParam->m_filename);
         } catch (const bad_alloc&) {
             throw DataFileException(myParam->m_filename, CaretDataFileHelper::createBadAllocExceptionMessage(myParam->m_filename));
@@ -844,7 +857,12 @@ SurfaceFile* ParameterComponent::getSurface(const int32_t key)
     {
         try
         {
-            myParam->lazyGet()->readFile(myParam->m_filename);
+            if (CommandFileCache::isEnabled())
+            {
+                myParam->m_parameter = CommandFileCache::getSurface(myParam->m_filename);
+            } else {
+                myParam->lazyGet()->readFile(myParam->m_filename);
+            }
             m_provHelper->addToProvenance(myParam->m_parameter->getFileMetaData(), myParam->m_filename);
         } catch (const bad_alloc&) {
             throw DataFileException(myParam->m_filename, CaretDataFileHelper::createBadAllocExceptionMessage(myParam->m_filename));
@@ -860,7 +878,12 @@ VolumeFile* ParameterComponent::getVolume(const int32_t key)
     {
         try
         {
-            myParam->lazyGet()->readFile(myParam->m_filename);
+            if (CommandFileCache::isEnabled())
+            {
+                myParam->m_parameter = CommandFileCache::getVolume(myParam->m_filename);
+            } else {
+                myParam->lazyGet()->readFile(myParam->m_filename);
+            }
             m_provHelper->addToProvenance(myParam->m_parameter->getFileMetaData(), myParam->m_filename);
         } catch (const bad_alloc&) {
             throw DataFileException(myParam->m_filename, CaretDataFileHelper::createBadAllocExceptionMessage(myParam->m_filename));
@@ -887,7 +910,7 @@ CiftiFile* ParameterComponent::getOutputCifti(const int32_t key)
     if (myParam->m_parameter == NULL)
     {
         CiftiFile* thisCifti = myParam->lazyGet();
-        if (myParam->m_doOnDiskWrite)
+        if (myParam->m_doOnDiskWrite && myParam->m_filename != "")
         {
             thisCifti->setWritingFile(myParam->m_filename);
         }
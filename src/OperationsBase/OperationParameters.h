@@ -208,7 +208,8 @@ namespace caret {
         LabelFile* getOutputLabel(const int32_t key);
         
         ///add a parameter to get next item as a cifti file - TODO: make methods for different cifti types?
-        void addCiftiOutputParameter(const int32_t key, const AString& name, const AString& description);
+        ///onDiskWrite writes rows to the output file as they are set, unless the output collides with an on-disk input
+        void addCiftiOutputParameter(const int32_t key, const AString& name, const AString& description, const bool& onDiskWrite = false);
         
         ///get a cifti with a key
         CiftiFile* getOutputCifti(const int32_t key);
@@ -388,7 +389,8 @@ namespace caret {
         virtual OperationParametersEnum::Enum getType() { return TYPE; }
         virtual AbstractParameter* cloneAbstractParameter()
         {//clone is currently implemented to NOT copy pointer or value in other things of this type, so...
-            AbstractParameter* ret = new LazyFileParameter<T, TYPE>(m_key, m_shortName, m_description);
+            LazyFileParameter<T, TYPE>* ret = new LazyFileParameter<T, TYPE>(m_key, m_shortName, m_description);
+            ret->m_doOnDiskWrite = m_doOnDiskWrite;//but do copy how the file should be written
             return ret;
         }
         CaretPointer<T> m_parameter;//so the GUI parser and the commandline parser don't need to do different things to delete the parameter info
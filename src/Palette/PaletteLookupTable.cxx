@@ -0,0 +1,215 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#define __PALETTE_LOOKUP_TABLE_DECLARE__
+#include "PaletteLookupTable.h"
+#undef __PALETTE_LOOKUP_TABLE_DECLARE__
+
+#include "CaretAssert.h"
+#include "CaretMutex.h"
+#include "Palette.h"
+#include "PaletteScalarAndColor.h"
+
+using namespace caret;
+
+/**
+ * \class caret::PaletteLookupTable
+ * \brief Lookup table for fast coloring with a palette
+ * \ingroup Palette
+ *
+ * Divides the normalized range [-1, 1] into buckets and samples the
+ * palette at the bucket boundaries.  Within a bucket that does not contain
+ * any of the palette's scalars, the palette's color is either constant
+ * or linearly interpolated, so the color is found by interpolating the
+ * bucket's boundary colors with no searching of the palette.  Buckets that
+ * contain a palette scalar use the palette directly.  Colors match those
+ * from Palette::getPaletteColor() to within float rounding, they are not
+ * necessarily bit identical.
+ *
+ * The lookup table is only valid while the palette is not modified,
+ * getLookupTable() keeps recently used tables and rebuilds them when the
+ * palette changes.
+ */
+
+/**
+ * Constructor.
+ *
+ * @param palette
+ *    The palette.
+ * @param interpolateColorFlag
+ *    True if palette colors are interpolated.
+ */
+PaletteLookupTable::PaletteLookupTable(const Palette* palette,
+                                       const bool interpolateColorFlag)
+: m_palette(palette),
+m_interpolateColorFlag(interpolateColorFlag),
+m_bucketsPerUnit(NUMBER_OF_BUCKETS / 2.0f)
+{
+    CaretAssert(palette);
+
+    const int32_t numberOfPalettePoints = m_palette->getNumberOfScalarsAndColors();
+    m_paletteScalarsAndColors.reserve(numberOfPalettePoints * 5);
+    for (int32_t i = 0; i < numberOfPalettePoints; i++) {
+        const PaletteScalarAndColor* scalarAndColor = m_palette->getScalarAndColor(i);
+        m_paletteScalarsAndColors.push_back(scalarAndColor->getScalar());
+        const float* rgba = scalarAndColor->getColor();
+        m_paletteScalarsAndColors.insert(m_paletteScalarsAndColors.end(), rgba, rgba + 4);
+    }
+
+    m_rgba.resize((NUMBER_OF_BUCKETS + 1) * 4);
+    m_bucketInOneSegment.resize(NUMBER_OF_BUCKETS, 1);
+
+    const float bucketWidth = 2.0f / NUMBER_OF_BUCKETS;
+    for (int32_t i = 0; i <= NUMBER_OF_BUCKETS; i++) {
+        m_palette->getPaletteColor(-1.0f + (i * bucketWidth),
+                                   m_interpolateColorFlag,
+                                   &m_rgba[i * 4]);
+    }
+
+    /*
+     * The palette's color changes in a non-linear manner only at its
+     * scalars.  Any bucket containing (or very near) a scalar uses
+     * the palette.
+     */
+    const float tolerance = bucketWidth * 0.01f;
+    const int32_t numScalarColors = m_palette->getNumberOfScalarsAndColors();
+    for (int32_t i = 0; i < numScalarColors; i++) {
+        const float scalar = m_palette->getScalarAndColor(i)->getScalar();
+        const int32_t firstBucket = static_cast<int32_t>((scalar - tolerance + 1.0f) * m_bucketsPerUnit);
+        const int32_t lastBucket  = static_cast<int32_t>((scalar + tolerance + 1.0f) * m_bucketsPerUnit);
+        for (int32_t j = firstBucket - 1; j <= lastBucket + 1; j++) {
+            if ((j >= 0)
+                && (j < NUMBER_OF_BUCKETS)) {
+                m_bucketInOneSegment[j] = 0;
+            }
+        }
+    }
+}
+
+/**
+ * Destructor.
+ */
+PaletteLookupTable::~PaletteLookupTable()
+{
+}
+
+/**
+ * Get a lookup table for a palette, reusing a recently created one if the
+ * palette has not changed since it was created.
+ *
+ * @param palette
+ *    The palette.
+ * @param interpolateColorFlag
+ *    True if palette colors are interpolated.
+ * @return
+ *    The lookup table, shared with other callers.
+ */
+std::shared_ptr<const PaletteLookupTable>
+PaletteLookupTable::getLookupTable(const Palette* palette,
+                                   const bool interpolateColorFlag)
+{
+    CaretAssert(palette);
+    
+    static CaretMutex cacheMutex;
+    static std::vector<std::shared_ptr<const PaletteLookupTable>> cache;//most recently used last
+    const size_t maximumCacheSize = 16;
+    
+    CaretMutexLocker locker(&cacheMutex);
+    for (size_t i = 0; i < cache.size(); i++) {
+        if (cache[i]->isValidFor(palette,
+                                 interpolateColorFlag)) {
+            std::shared_ptr<const PaletteLookupTable> table = cache[i];
+            cache.erase(cache.begin() + i);
+            cache.push_back(table);
+            return table;
+        }
+        if (cache[i]->m_palette == palette) {
+            /*
+             * Palette was modified, or deleted and its address reused
+             */
+            if (cache[i]->m_interpolateColorFlag == interpolateColorFlag) {
+                cache.erase(cache.begin() + i);
+                i--;
+            }
+        }
+    }
+    
+    std::shared_ptr<const PaletteLookupTable> table(new PaletteLookupTable(palette,
+                                                                           interpolateColorFlag));
+    cache.push_back(table);
+    if (cache.size() > maximumCacheSize) {
+        cache.erase(cache.begin());
+    }
+    return table;
+}
+
+/**
+ * @return True if this table was created for the given palette and
+ * interpolation, and the palette's points have not changed since.
+ *
+ * @param palette
+ *    The palette.
+ * @param interpolateColorFlag
+ *    True if palette colors are interpolated.
+ */
+bool
+PaletteLookupTable::isValidFor(const Palette* palette,
+                               const bool interpolateColorFlag) const
+{
+    if ((palette != m_palette)
+        || (interpolateColorFlag != m_interpolateColorFlag)) {
+        return false;
+    }
+    
+    const int32_t numberOfPalettePoints = palette->getNumberOfScalarsAndColors();
+    if (static_cast<size_t>(numberOfPalettePoints * 5) != m_paletteScalarsAndColors.size()) {
+        return false;
+    }
+    for (int32_t i = 0; i < numberOfPalettePoints; i++) {
+        const PaletteScalarAndColor* scalarAndColor = palette->getScalarAndColor(i);
+        const float* saved = &m_paletteScalarsAndColors[i * 5];
+        const float* rgba = scalarAndColor->getColor();
+        if ((saved[0] != scalarAndColor->getScalar())
+            || (saved[1] != rgba[0])
+            || (saved[2] != rgba[1])
+            || (saved[3] != rgba[2])
+            || (saved[4] != rgba[3])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Get the color for a normalized value directly from the palette.
+ *
+ * @param normalizedValue
+ *    Normalized value.
+ * @param rgbaOut
+ *    Output color.
+ */
+void
+PaletteLookupTable::getPaletteColorFromPalette(const float normalizedValue,
+                                               float rgbaOut[4]) const
+{
+    m_palette->getPaletteColor(normalizedValue,
+                               m_interpolateColorFlag,
+                               rgbaOut);
+}
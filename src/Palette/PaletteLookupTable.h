@@ -0,0 +1,120 @@
+#ifndef __PALETTE_LOOKUP_TABLE_H__
+#define __PALETTE_LOOKUP_TABLE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+namespace caret {
+
+    class Palette;
+
+    class PaletteLookupTable {
+
+    public:
+        PaletteLookupTable(const Palette* palette,
+                           const bool interpolateColorFlag);
+
+        ~PaletteLookupTable();
+
+        PaletteLookupTable(const PaletteLookupTable&) = delete;
+
+        PaletteLookupTable& operator=(const PaletteLookupTable&) = delete;
+
+        static std::shared_ptr<const PaletteLookupTable> getLookupTable(const Palette* palette,
+                                                                        const bool interpolateColorFlag);
+
+        bool isValidFor(const Palette* palette,
+                        const bool interpolateColorFlag) const;
+
+        /**
+         * Get the color for a normalized palette value.  Matches the
+         * color from Palette::getPaletteColor() to within float rounding.
+         *
+         * @param normalizedValue
+         *    Normalized value, clamped to [-1, 1].
+         * @param rgbaOut
+         *    Output color.
+         */
+        inline void getPaletteColor(const float normalizedValue,
+                                    float rgbaOut[4]) const {
+            float value = normalizedValue;
+            if (value < -1.0f) value = -1.0f;
+            if (value >  1.0f) value =  1.0f;
+
+            const float position = (value + 1.0f) * m_bucketsPerUnit;
+            int32_t bucket = static_cast<int32_t>(position);
+            if (bucket >= NUMBER_OF_BUCKETS) {
+                bucket = NUMBER_OF_BUCKETS - 1;
+            }
+
+            if ( ! m_bucketInOneSegment[bucket]) {
+                getPaletteColorFromPalette(value,
+                                           rgbaOut);
+                return;
+            }
+
+            /*
+             * Palette color is constant or linear within the bucket
+             * so interpolating the bucket's end colors matches it,
+             * apart from float rounding
+             */
+            const float fraction = position - bucket;
+            const float* low  = &m_rgba[bucket * 4];
+            const float* high = low + 4;
+            rgbaOut[0] = low[0] + fraction * (high[0] - low[0]);
+            rgbaOut[1] = low[1] + fraction * (high[1] - low[1]);
+            rgbaOut[2] = low[2] + fraction * (high[2] - low[2]);
+            rgbaOut[3] = low[3];
+        }
+
+        /** Number of buckets spanning the normalized range [-1, 1] */
+        static const int32_t NUMBER_OF_BUCKETS;
+
+    private:
+        void getPaletteColorFromPalette(const float normalizedValue,
+                                        float rgbaOut[4]) const;
+
+        const Palette* m_palette;
+
+        const bool m_interpolateColorFlag;
+
+        const float m_bucketsPerUnit;
+
+        /** Scalar and RGBA of each of the palette's points when the table was created */
+        std::vector<float> m_paletteScalarsAndColors;
+
+        /** RGBA at the boundaries of the buckets, (NUMBER_OF_BUCKETS + 1) * 4 */
+        std::vector<float> m_rgba;
+
+        /** Non-zero if a bucket does not contain a palette scalar so its coloring is linear */
+        std::vector<uint8_t> m_bucketInOneSegment;
+
+    };
+
+#ifdef __PALETTE_LOOKUP_TABLE_DECLARE__
+    const int32_t PaletteLookupTable::NUMBER_OF_BUCKETS = 2048;
+#endif // __PALETTE_LOOKUP_TABLE_DECLARE__
+
+} // namespace
+#endif  //__PALETTE_LOOKUP_TABLE_H__
@@ -0,0 +1,107 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "AverageDenseCorrelationTest.h"
+
+#include "AlgorithmCiftiAverageDenseCorrelation.h"
+#include "AlgorithmCiftiCorrelation.h"
+#include "CaretPointer.h"
+#include "CiftiFile.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+AverageDenseCorrelationTest::AverageDenseCorrelationTest(const AString& identifier): TestInterface(identifier)
+{
+}
+
+void AverageDenseCorrelationTest::execute()
+{
+    const int64_t NUM_ROWS = 30;
+    const int NUM_SUBJECTS = 3;
+    CiftiBrainModelsMap denseMap;
+    denseMap.addSurfaceModel(NUM_ROWS, StructureEnum::CORTEX_LEFT);
+    vector<CaretPointer<CiftiFile> > subjects;
+    vector<const CiftiFile*> subjectList;
+    for (int whichSubj = 0; whichSubj < NUM_SUBJECTS; ++whichSubj)
+    {
+        const int64_t timepoints = 15 + 5 * whichSubj;//different lengths are allowed
+        CiftiXML myXML;
+        myXML.setNumberOfDimensions(2);
+        myXML.setMap(CiftiXML::ALONG_COLUMN, denseMap);
+        myXML.setMap(CiftiXML::ALONG_ROW, CiftiSeriesMap(timepoints));
+        CaretPointer<CiftiFile> thisCifti(new CiftiFile());
+        thisCifti->setCiftiXML(myXML);
+        vector<float> scratch(timepoints);
+        for (int64_t i = 0; i < NUM_ROWS; ++i)
+        {
+            for (int64_t t = 0; t < timepoints; ++t)
+            {
+                scratch[t] = ((float)rand()) / RAND_MAX;
+            }
+            thisCifti->setRow(scratch.data(), i);
+        }
+        subjects.push_back(thisCifti);
+        subjectList.push_back(thisCifti);
+    }
+    vector<double> expected(NUM_ROWS * NUM_ROWS, 0.0);//equivalent of -cifti-correlation -fisher-z on each subject, then -cifti-average, then tanh
+    vector<float> scratchRow(NUM_ROWS);
+    for (int whichSubj = 0; whichSubj < NUM_SUBJECTS; ++whichSubj)
+    {
+        CiftiFile corrOut;
+        AlgorithmCiftiCorrelation(NULL, subjectList[whichSubj], &corrOut, (const vector<float>*)NULL, true);
+        for (int64_t i = 0; i < NUM_ROWS; ++i)
+        {
+            corrOut.getRow(scratchRow.data(), i);
+            for (int64_t j = 0; j < NUM_ROWS; ++j)
+            {
+                expected[i * NUM_ROWS + j] += scratchRow[j] / NUM_SUBJECTS;
+            }
+        }
+    }
+    const float memLimits[] = { -1.0f, 0.0f };//default budget fits in one chunk, 0 computes one row per chunk
+    for (int whichLimit = 0; whichLimit < 2 && !failed(); ++whichLimit)
+    {
+        CiftiFile avgOut;
+        AlgorithmCiftiAverageDenseCorrelation(NULL, subjectList, &avgOut, false, memLimits[whichLimit]);
+        if (avgOut.getNumberOfRows() != NUM_ROWS || avgOut.getNumberOfColumns() != NUM_ROWS)
+        {
+            setFailed("output has wrong dimensions");
+            return;
+        }
+        for (int64_t i = 0; i < NUM_ROWS && !failed(); ++i)
+        {
+            avgOut.getRow(scratchRow.data(), i);
+            for (int64_t j = 0; j < NUM_ROWS; ++j)
+            {
+                float expectVal = tanh(expected[i * NUM_ROWS + j]);
+                if (!(abs(scratchRow[j] - expectVal) < 0.0001f))//use "not less than" in order to catch NaNs
+                {
+                    setFailed("mem limit " + AString::number(memLimits[whichLimit]) + ", row " + AString::number(i) + ", column " + AString::number(j) +
+                              ": average dense correlation " + AString::number(scratchRow[j]) + ", expected " + AString::number(expectVal));
+                    break;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,457 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "BenchmarkTest.h"
+
+#include "AlgorithmMetricResample.h"
+#include "AlgorithmMetricSmoothing.h"
+#include "AlgorithmMetricTFCE.h"
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "AlgorithmVolumeSmoothing.h"
+#include "ApplicationInformation.h"
+#include "CaretAssert.h"
+#include "CaretOMP.h"
+#include "CiftiFile.h"
+#include "DotProductTile.h"
+#include "dot_wrapper.h"
+#include "ElapsedTimer.h"
+#include "FastStatistics.h"
+#include "GeodesicHelper.h"
+#include "MetricFile.h"
+#include "NodeAndVoxelColoring.h"
+#include "PaletteColorMapping.h"
+#include "SurfaceFile.h"
+#include "VolumeFile.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <cmath>
+#include <iostream>
+
+using namespace caret;
+using namespace std;
+
+BenchmarkTest::BenchmarkTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+namespace
+{
+    ///xorshift64*, so the data is the same on every platform and run, unlike rand()
+    class BenchRandom
+    {
+        uint64_t m_state;
+    public:
+        BenchRandom(const uint64_t& seed) { m_state = seed; }
+        float uniform()
+        {
+            m_state ^= m_state >> 12;
+            m_state ^= m_state << 25;
+            m_state ^= m_state >> 27;
+            return ((m_state * 2685821657736338717ULL) >> 40) * (1.0f / 16777216.0f);//top 24 bits, [0, 1)
+        }
+        float normal()
+        {
+            float u1 = uniform(), u2 = uniform();
+            return sqrt(-2.0f * log(1.0f - u1)) * cos(6.2831853f * u2);
+        }
+    };
+
+    const int BENCH_NUM_COLUMNS = 4;
+    const int CIFTI_NUM_TIMEPOINTS = 200;
+
+    ///spatially smooth pattern plus noise, so smoothing and TFCE see clusters rather than only white noise
+    void makeSurfaceMetric(const SurfaceFile* sphere, const int& numColumns, MetricFile& metricOut)
+    {
+        const int numNodes = sphere->getNumberOfNodes();
+        metricOut.setNumberOfNodesAndColumns(numNodes, numColumns);
+        metricOut.setStructure(sphere->getStructure());
+        BenchRandom myRand(numNodes);
+        vector<float> scratch(numNodes);
+        for (int col = 0; col < numColumns; ++col)
+        {
+            for (int node = 0; node < numNodes; ++node)
+            {
+                const float* coord = sphere->getCoordinate(node);
+                scratch[node] = 3.0f * sin(coord[0] / (10.0f + col)) * cos(coord[1] / 15.0f) + myRand.normal();
+            }
+            metricOut.setValuesForColumn(col, scratch.data());
+        }
+    }
+
+    AString tempFileName(const AString& suffix)
+    {
+        return QDir::tempPath() + "/wb_benchmark_" + AString::number(QCoreApplication::applicationPid()) + suffix;
+    }
+}
+
+void BenchmarkTest::addResult(const AString& kernel, const AString& size, const AString& dispatch, const vector<double>& times, const double& work, const AString& workUnit)
+{
+    CaretAssert(!times.empty());
+    double minTime = times[0], sum = 0.0;
+    for (size_t i = 0; i < times.size(); ++i)
+    {
+        if (times[i] < minTime) minTime = times[i];
+        sum += times[i];
+    }
+    QJsonObject result;
+    result["kernel"] = kernel;
+    result["size"] = size;
+    result["dispatch"] = dispatch;
+    result["repetitions"] = (int)times.size();
+    result["seconds_min"] = minTime;
+    result["seconds_mean"] = sum / times.size();
+    result["work"] = work;
+    result["throughput"] = (minTime > 0.0 ? work / minTime : 0.0);
+    result["throughput_unit"] = workUnit + "/s";
+    m_results.append(result);
+    cerr << kernel << " " << size << " " << dispatch << ": " << minTime << " s" << endl;//progress on stderr, so stdout is only the JSON
+}
+
+void BenchmarkTest::benchDot()
+{
+    const int NUM_ROWS = 512, LENGTH = 1200, REPS = 3;//one run's worth of timepoints, all pairs of rows
+    BenchRandom myRand(1);
+    vector<float> data(NUM_ROWS * LENGTH);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = myRand.normal();
+    }
+    const double dotWork = 2.0 * LENGTH * NUM_ROWS * (NUM_ROWS + 1) / 2;
+    vector<DotSIMDEnum::Enum> allImpls = DotSIMDEnum::getAllEnums();
+    double checksum = 0.0;
+    for (size_t impl = 0; impl < allImpls.size(); ++impl)
+    {
+        if (allImpls[impl] == DOT_AUTO) continue;
+        if (dot_set_impl(allImpls[impl]) != allImpls[impl]) continue;//not supported by this cpu or build
+        vector<double> times;
+        for (int rep = 0; rep < REPS; ++rep)
+        {
+            ElapsedTimer myTimer;
+            myTimer.start();
+            for (int i = 0; i < NUM_ROWS; ++i)
+            {
+                for (int j = i; j < NUM_ROWS; ++j)
+                {
+                    checksum += dsdot(data.data() + i * LENGTH, data.data() + j * LENGTH, LENGTH);
+                }
+            }
+            times.push_back(myTimer.getElapsedTimeSeconds());
+        }
+        addResult("dot", AString::number(NUM_ROWS) + "x" + AString::number(LENGTH), DotSIMDEnum::toName(allImpls[impl]), times, dotWork, "flop");
+    }
+    dot_set_impl(DOT_AUTO);
+    const int TILE = 64;//same work as above, but through the tiled kernel correlation uses
+    vector<double> tileOut(TILE * TILE), times;
+    for (int rep = 0; rep < REPS; ++rep)
+    {
+        ElapsedTimer myTimer;
+        myTimer.start();
+        for (int i = 0; i < NUM_ROWS; i += TILE)
+        {
+            for (int j = i; j < NUM_ROWS; j += TILE)
+            {
+                dotProductTile(data.data() + i * LENGTH, LENGTH, TILE, data.data() + j * LENGTH, LENGTH, TILE, LENGTH, tileOut.data());
+                checksum += tileOut[0];
+            }
+        }
+        times.push_back(myTimer.getElapsedTimeSeconds());
+    }
+    const int numTiles = NUM_ROWS / TILE;
+    addResult("dot_tile", AString::number(NUM_ROWS) + "x" + AString::number(LENGTH), "COMPILED", times, 2.0 * LENGTH * TILE * TILE * numTiles * (numTiles + 1) / 2, "flop");
+    if (!(checksum == checksum)) setFailed("dot product benchmark produced NaN");//also keeps the loops from being optimized out
+}
+
+void BenchmarkTest::benchSurface(const AString& size, const SurfaceFile* sphere)
+{
+    const int numNodes = sphere->getNumberOfNodes();
+    MetricFile myMetric;
+    makeSurfaceMetric(sphere, BENCH_NUM_COLUMNS, myMetric);
+    {//geodesic dijkstra from spread-out sources
+        const int NUM_SOURCES = 10;
+        CaretPointer<GeodesicHelper> myGeoHelp = sphere->getGeodesicHelper();
+        vector<float> distances;
+        vector<double> times;
+        for (int i = 0; i < NUM_SOURCES; ++i)
+        {
+            ElapsedTimer myTimer;
+            myTimer.start();
+            myGeoHelp->getGeoFromNode((int32_t)((int64_t)i * numNodes / NUM_SOURCES), distances);
+            times.push_back(myTimer.getElapsedTimeSeconds());
+        }
+        addResult("geodesic_dijkstra", size, "", times, numNodes, "vertex");
+    }
+    {
+        const int REPS = 3;
+        MetricFile smoothOut;
+        vector<double> times;
+        for (int i = 0; i < REPS; ++i)
+        {
+            ElapsedTimer myTimer;
+            myTimer.start();
+            AlgorithmMetricSmoothing(NULL, sphere, &myMetric, 2.0, &smoothOut);
+            times.push_back(myTimer.getElapsedTimeSeconds());
+        }
+        addResult("metric_smoothing", size, "", times, (double)numNodes * BENCH_NUM_COLUMNS, "vertex");
+    }
+    {
+        const int REPS = 3;
+        MetricFile tfceOut;
+        vector<double> times;
+        for (int i = 0; i < REPS; ++i)
+        {
+            ElapsedTimer myTimer;
+            myTimer.start();
+            AlgorithmMetricTFCE(NULL, sphere, &myMetric, &tfceOut, 0.0f, NULL, 1.0f, 2.0f, 0);
+            times.push_back(myTimer.getElapsedTimeSeconds());
+        }
+        addResult("metric_tfce", size, "", times, numNodes, "vertex");
+    }
+    {
+        const int REPS = 20;
+        const float* data = myMetric.getValuePointerForColumn(0);
+        PaletteColorMapping myMapping;
+        FastStatistics myStats(data, numNodes);
+        vector<uint8_t> rgba(numNodes * 4);
+        vector<double> times;
+        for (int i = 0; i < REPS; ++i)
+        {
+            ElapsedTimer myTimer;
+            myTimer.start();
+            NodeAndVoxelColoring::colorScalarsWithPalette(&myStats, &myMapping, data, &myMapping, data, numNodes, rgba.data());
+            times.push_back(myTimer.getElapsedTimeSeconds());
+        }
+        addResult("palette_coloring", size, "", times, numNodes, "vertex");
+    }
+    {//default gifti encoding is gzipped base64, so reading exercises the full decode
+        const int REPS = 5;
+        const AString fileName = tempFileName("." + size + ".func.gii");
+        const double numBytes = (double)numNodes * BENCH_NUM_COLUMNS * sizeof(float);
+        vector<double> writeTimes, readTimes;
+        for (int i = 0; i < REPS; ++i)
+        {
+            ElapsedTimer myTimer;
+            myTimer.start();
+            myMetric.writeFile(fileName);
+            writeTimes.push_back(myTimer.getElapsedTimeSeconds());
+        }
+        for (int i = 0; i < REPS; ++i)
+        {
+            MetricFile readMetric;
+            ElapsedTimer myTimer;
+            myTimer.start();
+            readMetric.readFile(fileName);
+            readTimes.push_back(myTimer.getElapsedTimeSeconds());
+        }
+        QFile::remove(fileName);
+        addResult("gifti_write", size, "", writeTimes, numBytes, "byte");
+        addResult("gifti_read", size, "", readTimes, numBytes, "byte");
+    }
+}
+
+void BenchmarkTest::benchResample(const SurfaceFile* sphere32k, const SurfaceFile* sphere164k)
+{
+    const int REPS = 3;
+    const SurfaceFile* spheres[2] = { sphere32k, sphere164k };
+    const AString names[2] = { "32k", "164k" };
+    MetricFile metrics[2], areas[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        makeSurfaceMetric(spheres[i], BENCH_NUM_COLUMNS, metrics[i]);
+        vector<float> nodeAreas;
+        spheres[i]->computeNodeAreas(nodeAreas);
+        areas[i].setNumberOfNodesAndColumns(spheres[i]->getNumberOfNodes(), 1);
+        areas[i].setStructure(spheres[i]->getStructure());
+        areas[i].setValuesForColumn(0, nodeAreas.data());
+    }
+    SurfaceResamplingMethodEnum::Enum methods[2] = { SurfaceResamplingMethodEnum::BARYCENTRIC, SurfaceResamplingMethodEnum::ADAP_BARY_AREA };
+    for (int method = 0; method < 2; ++method)
+    {
+        for (int from = 0; from < 2; ++from)
+        {
+            const int to = 1 - from;
+            const bool useAreas = (methods[method] == SurfaceResamplingMethodEnum::ADAP_BARY_AREA);
+            MetricFile resampleOut;
+            vector<double> times;
+            for (int i = 0; i < REPS; ++i)
+            {
+                ElapsedTimer myTimer;
+                myTimer.start();
+                AlgorithmMetricResample(NULL, &(metrics[from]), spheres[from], spheres[to], methods[method], &resampleOut,
+                                        (useAreas ? &(areas[from]) : NULL), (useAreas ? &(areas[to]) : NULL));
+                times.push_back(myTimer.getElapsedTimeSeconds());
+            }
+            addResult("metric_resample", names[from] + "_to_" + names[to], SurfaceResamplingMethodEnum::toName(methods[method]), times,
+                      (double)spheres[to]->getNumberOfNodes() * BENCH_NUM_COLUMNS, "vertex");
+        }
+    }
+}
+
+void BenchmarkTest::benchVolume()
+{
+    const int REPS = 3, NUM_FRAMES = 4;
+    vector<int64_t> dims(3);
+    dims[0] = 91; dims[1] = 109; dims[2] = 91;//2mm MNI grid
+    vector<vector<float> > sform(3, vector<float>(4, 0.0f));
+    sform[0][0] = -2.0f; sform[0][3] = 90.0f;
+    sform[1][1] = 2.0f; sform[1][3] = -126.0f;
+    sform[2][2] = 2.0f; sform[2][3] = -72.0f;
+    dims.push_back(NUM_FRAMES);
+    VolumeFile myVol(dims, sform);
+    const int64_t frameSize = dims[0] * dims[1] * dims[2];
+    BenchRandom myRand(frameSize);
+    vector<float> frame(frameSize);
+    for (int f = 0; f < NUM_FRAMES; ++f)
+    {
+        int64_t index = 0;
+        for (int64_t k = 0; k < dims[2]; ++k)
+        {
+            for (int64_t j = 0; j < dims[1]; ++j)
+            {
+                for (int64_t i = 0; i < dims[0]; ++i)
+                {
+                    frame[index] = 3.0f * sin(i / (5.0f + f)) * cos(j / 7.0f) * sin(k / 6.0f) + myRand.normal();
+                    ++index;
+                }
+            }
+        }
+        myVol.setFrame(frame.data(), f);
+    }
+    VolumeFile smoothOut;
+    vector<double> times;
+    for (int i = 0; i < REPS; ++i)
+    {
+        ElapsedTimer myTimer;
+        myTimer.start();
+        AlgorithmVolumeSmoothing(NULL, &myVol, 2.0f, &smoothOut);
+        times.push_back(myTimer.getElapsedTimeSeconds());
+    }
+    addResult("volume_smoothing", "91x109x91x" + AString::number(NUM_FRAMES), "", times, (double)frameSize * NUM_FRAMES, "voxel");
+}
+
+void BenchmarkTest::benchCifti()
+{
+    const int REPS = 3;
+    const int64_t NODES_PER_HEMI = 32492;
+    CiftiXML myXML;
+    myXML.setNumberOfDimensions(2);
+    CiftiBrainModelsMap myModels;
+    myModels.addSurfaceModel(NODES_PER_HEMI, StructureEnum::CORTEX_LEFT);
+    myModels.addSurfaceModel(NODES_PER_HEMI, StructureEnum::CORTEX_RIGHT);
+    myXML.setMap(CiftiXML::ALONG_COLUMN, myModels);
+    myXML.setMap(CiftiXML::ALONG_ROW, CiftiSeriesMap(CIFTI_NUM_TIMEPOINTS, 0.0f, 0.72f));
+    const int64_t numRows = myXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
+    const AString size = "dtseries_" + AString::number(numRows) + "x" + AString::number(CIFTI_NUM_TIMEPOINTS);
+    const double numBytes = (double)numRows * CIFTI_NUM_TIMEPOINTS * sizeof(float);
+    CiftiFile myCifti;
+    myCifti.setCiftiXML(myXML);
+    BenchRandom myRand(numRows);
+    vector<float> row(CIFTI_NUM_TIMEPOINTS);
+    for (int64_t r = 0; r < numRows; ++r)
+    {
+        for (int t = 0; t < CIFTI_NUM_TIMEPOINTS; ++t)
+        {
+            row[t] = 100.0f + myRand.normal();
+        }
+        myCifti.setRow(row.data(), r);
+    }
+    const AString suffixes[2] = { ".dtseries.nii", ".dtseries.nii.gz" };
+    const AString dispatch[2] = { "nii", "nii.gz" };
+    for (int format = 0; format < 2; ++format)
+    {
+        const AString fileName = tempFileName(suffixes[format]);
+        vector<double> writeTimes, diskTimes, loadTimes, memoryTimes;
+        for (int i = 0; i < REPS; ++i)
+        {
+            ElapsedTimer myTimer;
+            myTimer.start();
+            myCifti.writeFile(fileName);
+            writeTimes.push_back(myTimer.getElapsedTimeSeconds());
+        }
+        for (int i = 0; i < REPS; ++i)
+        {//on-disk: every row is a separate read from the file
+            CiftiFile diskCifti;
+            ElapsedTimer myTimer;
+            myTimer.start();
+            diskCifti.openFile(fileName);
+            for (int64_t r = 0; r < numRows; ++r)
+            {
+                diskCifti.getRow(row.data(), r);
+            }
+            diskTimes.push_back(myTimer.getElapsedTimeSeconds());
+        }
+        for (int i = 0; i < REPS; ++i)
+        {
+            CiftiFile memCifti;
+            ElapsedTimer myTimer;
+            myTimer.start();
+            memCifti.openFile(fileName);
+            memCifti.convertToInMemory();
+            loadTimes.push_back(myTimer.getElapsedTimeSeconds());
+            if (format == 0)
+            {//in-memory row access doesn't depend on the file format
+                myTimer.start();
+                for (int64_t r = 0; r < numRows; ++r)
+                {
+                    memCifti.getRow(row.data(), r);
+                }
+                memoryTimes.push_back(myTimer.getElapsedTimeSeconds());
+            }
+        }
+        QFile::remove(fileName);
+        addResult("cifti_write", size, dispatch[format], writeTimes, numBytes, "byte");
+        addResult("cifti_rows_on_disk", size, dispatch[format], diskTimes, numBytes, "byte");
+        addResult("cifti_load_in_memory", size, dispatch[format], loadTimes, numBytes, "byte");
+        if (format == 0)
+        {
+            addResult("cifti_rows_in_memory", size, "", memoryTimes, numBytes, "byte");
+        }
+    }
+}
+
+void BenchmarkTest::execute()
+{
+    m_results = QJsonArray();
+    SurfaceFile sphere32k, sphere164k;
+    AlgorithmSurfaceCreateSphere(NULL, 32492, &sphere32k);
+    AlgorithmSurfaceCreateSphere(NULL, 163842, &sphere164k);
+    sphere32k.setStructure(StructureEnum::CORTEX_LEFT);
+    sphere164k.setStructure(StructureEnum::CORTEX_LEFT);
+    benchDot();
+    benchSurface("32k", &sphere32k);
+    benchSurface("164k", &sphere164k);
+    benchResample(&sphere32k, &sphere164k);
+    benchVolume();
+    benchCifti();
+    QJsonObject output;
+    output["benchmark_version"] = 1;//change when kernels or data change, so old numbers aren't compared to new ones
+    output["workbench_version"] = ApplicationInformation().getVersion();
+    output["dot_auto_dispatch"] = DotSIMDEnum::toName(dot_set_impl(DOT_AUTO));
+#ifdef CARET_OMP
+    output["threads"] = omp_get_max_threads();
+#else
+    output["threads"] = 1;
+#endif
+    output["results"] = m_results;
+    cout << QJsonDocument(output).toJson().constData() << endl;
+}
@@ -0,0 +1,50 @@
+#ifndef __BENCHMARK_TEST_H__
+#define __BENCHMARK_TEST_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "TestInterface.h"
+
+#include <QJsonArray>
+
+#include <vector>
+
+namespace caret {
+
+    class SurfaceFile;
+
+    ///times core kernels on deterministic synthetic data, prints the results as JSON
+    ///not part of "all" or ctest, as it takes minutes and only fails on exceptions
+    class BenchmarkTest : public TestInterface
+    {
+        QJsonArray m_results;
+        void addResult(const AString& kernel, const AString& size, const AString& dispatch, const std::vector<double>& times, const double& work, const AString& workUnit);
+        void benchDot();
+        void benchSurface(const AString& size, const SurfaceFile* sphere);
+        void benchResample(const SurfaceFile* sphere32k, const SurfaceFile* sphere164k);
+        void benchVolume();
+        void benchCifti();
+    public:
+        BenchmarkTest(const AString& identifier);
+        virtual void execute();
+    };
+
+}
+#endif //__BENCHMARK_TEST_H__
@@ -0,0 +1,125 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "CiftiIndexArrayTest.h"
+
+#include "CiftiIndexArrayText.h"
+#include "DataFileException.h"
+#include "ElapsedTimer.h"
+
+#include <QRegularExpression>
+#include <QStringList>
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //how index arrays were parsed before CiftiIndexArrayText, for comparison
+    vector<int64_t> splitParse(const QString& text)
+    {
+#if QT_VERSION >= 0x060000
+        QStringList separated = text.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+#else
+        QStringList separated = text.split(QRegularExpression("\\s+"), QString::SkipEmptyParts);
+#endif
+        vector<int64_t> ret;
+        ret.reserve(separated.size());
+        for (int i = 0; i < separated.size(); ++i)
+        {
+            ret.push_back(separated[i].toLongLong());
+        }
+        return ret;
+    }
+}
+
+CiftiIndexArrayTest::CiftiIndexArrayTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void CiftiIndexArrayTest::execute()
+{
+    vector<int64_t> parsed = CiftiIndexArrayText::parse(" 0 12\n345\t+6 -0 \r\n", false);
+    if (parsed != vector<int64_t>({ 0, 12, 345, 6, 0 })) setFailed("incorrect parsing of mixed whitespace");
+    const char* badArrays[] = { "1 2x 3", "1 - 2", "4 5.0", "99999999999999999999", "1 -5" };
+    for (int i = 0; i < 5; ++i)
+    {
+        bool threw = false;
+        try
+        {
+            CiftiIndexArrayText::parse(badArrays[i], false);
+        } catch (DataFileException&) {
+            threw = true;
+        }
+        if (!threw) setFailed("accepted invalid index array '" + AString(badArrays[i]) + "'");
+    }
+    if (CiftiIndexArrayText::parse("1 -5", true) != vector<int64_t>({ 1, -5 })) setFailed("incorrect parsing of negative integer");
+    const int64_t formatValues[] = { 0, 7, 10, 123456789012LL, 3, 9 };
+    if (CiftiIndexArrayText::format(formatValues, 6) != "0 7 10 123456789012 3 9") setFailed("incorrect formatting of vertex list");
+    if (CiftiIndexArrayText::format(formatValues, 6, 3) != "0 7 10\n123456789012 3 9\n") setFailed("incorrect formatting of voxel list");
+    if (CiftiIndexArrayText::format(formatValues, 0) != "") setFailed("incorrect formatting of empty list");
+    //benchmark on the sizes of the standard grayordinate spaces
+    const char* spaceNames[] = { "91k", "170k" };
+    const int64_t surfaceCounts[] = { 59412, 118584 }, voxelCounts[] = { 31870, 51910 };
+    const int64_t vertexRange[] = { 32492, 59292 }, voxelRange = 160;
+    for (int space = 0; space < 2; ++space)
+    {
+        vector<int64_t> vertices(surfaceCounts[space]), voxels(voxelCounts[space] * 3);
+        for (int64_t i = 0; i < (int64_t)vertices.size(); ++i)
+        {
+            vertices[i] = rand() % vertexRange[space];
+        }
+        for (int64_t i = 0; i < (int64_t)voxels.size(); ++i)
+        {
+            voxels[i] = rand() % voxelRange;
+        }
+        ElapsedTimer myTimer;
+        myTimer.start();
+        QString vertexText = CiftiIndexArrayText::format(vertices.data(), (int64_t)vertices.size());
+        QString voxelText = CiftiIndexArrayText::format(voxels.data(), (int64_t)voxels.size(), 3);
+        double formatTime = myTimer.getElapsedTimeMilliseconds();
+        myTimer.start();
+        vector<int64_t> vertexCheck = CiftiIndexArrayText::parse(vertexText, false);
+        vector<int64_t> voxelCheck = CiftiIndexArrayText::parse(voxelText, false);
+        double parseTime = myTimer.getElapsedTimeMilliseconds();
+        if (vertexCheck != vertices || voxelCheck != voxels) setFailed(AString(spaceNames[space]) + " index arrays did not survive a round trip");
+        myTimer.start();
+        QString oldVertexText, oldVoxelText;
+        for (int64_t i = 0; i < (int64_t)vertices.size(); ++i)
+        {
+            if (i != 0) oldVertexText += " ";
+            oldVertexText += QString::number(vertices[i]);
+        }
+        for (int64_t i = 0; i < (int64_t)voxels.size(); i += 3)
+        {
+            oldVoxelText += QString::number(voxels[i]) + " " + QString::number(voxels[i + 1]) + " " + QString::number(voxels[i + 2]) + "\n";
+        }
+        double oldFormatTime = myTimer.getElapsedTimeMilliseconds();
+        if (oldVertexText != vertexText || oldVoxelText != voxelText) setFailed(AString(spaceNames[space]) + " formatting differs from QString::number");
+        myTimer.start();
+        vector<int64_t> oldVertexCheck = splitParse(vertexText), oldVoxelCheck = splitParse(voxelText);
+        double oldParseTime = myTimer.getElapsedTimeMilliseconds();
+        if (oldVertexCheck != vertices || oldVoxelCheck != voxels) setFailed(AString(spaceNames[space]) + " parsing differs from QString splitting");
+        cout << spaceNames[space] << " grayordinates: format " << formatTime << " ms (QString::number " << oldFormatTime << " ms), parse "
+             << parseTime << " ms (QString split " << oldParseTime << " ms)" << endl;
+    }
+}
@@ -0,0 +1,154 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "CiftiRowPipelineTest.h"
+
+#include "CiftiFile.h"
+#include "CiftiRowPipeline.h"
+#include "DataFileException.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    CiftiXML makeXML(const int64_t& numRows, const int64_t& rowLength)
+    {
+        CiftiBrainModelsMap denseMap;
+        denseMap.addSurfaceModel(numRows, StructureEnum::CORTEX_LEFT);
+        CiftiXML ret;
+        ret.setNumberOfDimensions(2);
+        ret.setMap(CiftiXML::ALONG_COLUMN, denseMap);
+        ret.setMap(CiftiXML::ALONG_ROW, CiftiSeriesMap(rowLength));
+        return ret;
+    }
+    
+    float inputValue(const int& input, const int64_t& row, const int64_t& col)
+    {
+        return (input + 1) * 1000.0f + row + col * 0.25f;
+    }
+}
+
+CiftiRowPipelineTest::CiftiRowPipelineTest(const AString& identifier): TestInterface(identifier)
+{
+}
+
+void CiftiRowPipelineTest::execute()
+{
+    const int64_t NUM_ROWS = 37;//not a multiple of the block size, so the last block is partial
+    const int64_t inputLengths[2] = { 11, 5 };
+    const int64_t OUT_LENGTH = 3;
+    CiftiFile inputs[2];
+    vector<const CiftiFile*> inputList;
+    for (int input = 0; input < 2; ++input)
+    {
+        inputs[input].setCiftiXML(makeXML(NUM_ROWS, inputLengths[input]));
+        vector<float> scratch(inputLengths[input]);
+        for (int64_t row = 0; row < NUM_ROWS; ++row)
+        {
+            for (int64_t col = 0; col < inputLengths[input]; ++col)
+            {
+                scratch[col] = inputValue(input, row, col);
+            }
+            inputs[input].setRow(scratch.data(), row);
+        }
+        inputList.push_back(&inputs[input]);
+    }
+    //output is the sum of each input row, and the row number the block reported
+    CiftiRowPipeline::Kernel sumKernel = [](const CiftiRowBlock& block)
+    {
+        for (int64_t row = 0; row < block.getNumberOfRows(); ++row)
+        {
+            float* outRow = block.getOutputRow(row);
+            for (int input = 0; input < 2; ++input)
+            {
+                const float* inRow = block.getInputRow(input, row);
+                double accum = 0.0;
+                for (int64_t col = 0; col < block.getInputRowLength(input); ++col)
+                {
+                    accum += inRow[col];
+                }
+                outRow[input] = accum;
+            }
+            outRow[2] = block.getFirstRow() + row;
+        }
+    };
+    const int64_t rowBytes = (inputLengths[0] + inputLengths[1] + OUT_LENGTH) * sizeof(float);
+    const int64_t blockBytes[2] = { rowBytes * 4, 1 };//several rows per block, and the minimum of one row per block
+    for (int whichSize = 0; whichSize < 2 && !failed(); ++whichSize)
+    {
+        CiftiFile output;
+        output.setCiftiXML(makeXML(NUM_ROWS, OUT_LENGTH));
+        CiftiRowPipeline pipeline(inputList, &output);
+        pipeline.setBlockBytes(blockBytes[whichSize]);
+        pipeline.setNumberOfBlocksInFlight(3);
+        pipeline.run(sumKernel);
+        vector<float> outRow(OUT_LENGTH);
+        for (int64_t row = 0; row < NUM_ROWS && !failed(); ++row)
+        {
+            output.getRow(outRow.data(), row);
+            for (int input = 0; input < 2; ++input)
+            {
+                double expected = 0.0;
+                for (int64_t col = 0; col < inputLengths[input]; ++col)
+                {
+                    expected += inputValue(input, row, col);
+                }
+                if (!(abs(outRow[input] - expected) <= 0.001 * abs(expected)))//use "not less than" in order to catch NaNs
+                {
+                    setFailed("block bytes " + AString::number(blockBytes[whichSize]) + ", row " + AString::number(row) + ", input " + AString::number(input) +
+                              ": sum " + AString::number(outRow[input]) + ", expected " + AString::number(expected));
+                }
+            }
+            if (outRow[2] != row)
+            {
+                setFailed("block bytes " + AString::number(blockBytes[whichSize]) + ": row " + AString::number(row) + " was computed as row " + AString::number(outRow[2]));
+            }
+        }
+    }
+    //an exception from the kernel must stop the other stages and come back out of run()
+    CiftiFile output;
+    output.setCiftiXML(makeXML(NUM_ROWS, OUT_LENGTH));
+    CiftiRowPipeline pipeline(inputList, &output);
+    pipeline.setBlockBytes(rowBytes * 2);
+    bool caught = false;
+    try
+    {
+        pipeline.run([](const CiftiRowBlock& block)
+        {
+            if (block.getFirstRow() <= 20 && block.getFirstRow() + block.getNumberOfRows() > 20)
+            {
+                throw DataFileException("kernel failure at row 20");
+            }
+        });
+    } catch (DataFileException& e) {
+        caught = true;
+        if (e.whatString() != "kernel failure at row 20")
+        {
+            setFailed("pipeline rethrew the wrong exception: " + e.whatString());
+        }
+    }
+    if (!caught)
+    {
+        setFailed("exception from the kernel was not rethrown by the pipeline");
+    }
+}
@@ -0,0 +1,185 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "CiftiSmoothingTest.h"
+
+#include "AlgorithmCiftiSeparate.h"
+#include "AlgorithmCiftiSmoothing.h"
+#include "AlgorithmMetricSmoothing.h"
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "AlgorithmVolumeSmoothing.h"
+#include "CiftiFile.h"
+#include "MetricFile.h"
+#include "SurfaceFile.h"
+#include "VolumeFile.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+CiftiSmoothingTest::CiftiSmoothingTest(const AString& identifier): TestInterface(identifier)
+{
+}
+
+namespace
+{
+    const float SURF_KERNEL = 8.0f, VOL_KERNEL = 3.0f;
+
+    void compareValues(CiftiSmoothingTest* theTest, const AString& condition, const float* first, const float* second, const float* roi, const int64_t& count)
+    {
+        float maxVal = 0.0f, maxDiff = 0.0f;
+        for (int64_t i = 0; i < count; ++i)
+        {
+            if (!(roi[i] > 0.0f)) continue;
+            maxVal = max(maxVal, abs(first[i]));
+            float diff = abs(first[i] - second[i]);
+            if (!(diff <= maxDiff)) maxDiff = diff;//catch NaN
+        }
+        if (!(maxDiff <= 1e-4f * maxVal))
+        {
+            theTest->setFailed(condition + ", max difference " + AString::number(maxDiff) + " with max value " + AString::number(maxVal));
+        }
+    }
+
+    //the old implementation: separate each structure, smooth it on its own, compare to the same structure of the cifti-smoothing output
+    void compareToSeparate(CiftiSmoothingTest* theTest, const AString& condition, const CiftiFile& input, const CiftiFile& output, const int& myDir, const SurfaceFile& mySurf)
+    {
+        MetricFile inMetric, roiMetric, refMetric, outMetric;
+        AlgorithmCiftiSeparate(NULL, &input, myDir, StructureEnum::CORTEX_LEFT, &inMetric, &roiMetric);
+        AlgorithmMetricSmoothing(NULL, &mySurf, &inMetric, SURF_KERNEL, &refMetric, &roiMetric);
+        AlgorithmCiftiSeparate(NULL, &output, myDir, StructureEnum::CORTEX_LEFT, &outMetric);
+        for (int col = 0; col < refMetric.getNumberOfColumns(); ++col)
+        {
+            compareValues(theTest, condition + ", surface map " + AString::number(col), refMetric.getValuePointerForColumn(col), outMetric.getValuePointerForColumn(col),
+                          roiMetric.getValuePointerForColumn(0), refMetric.getNumberOfNodes());
+        }
+        VolumeFile inVol, roiVol, refVol, outVol;
+        int64_t offset[3];
+        AlgorithmCiftiSeparate(NULL, &input, myDir, StructureEnum::THALAMUS_LEFT, &inVol, offset, &roiVol);
+        AlgorithmVolumeSmoothing(NULL, &inVol, VOL_KERNEL, &refVol, &roiVol);
+        AlgorithmCiftiSeparate(NULL, &output, myDir, StructureEnum::THALAMUS_LEFT, &outVol, offset);
+        vector<int64_t> dims = refVol.getDimensions();
+        int64_t frameSize = dims[0] * dims[1] * dims[2];
+        for (int64_t map = 0; map < dims[3]; ++map)
+        {
+            compareValues(theTest, condition + ", volume map " + AString::number(map), refVol.getFrame(map), outVol.getFrame(map), roiVol.getFrame(), frameSize);
+        }
+    }
+}
+
+void CiftiSmoothingTest::execute()
+{
+    SurfaceFile mySurf;
+    AlgorithmSurfaceCreateSphere(NULL, 642, &mySurf);
+    mySurf.setStructure(StructureEnum::CORTEX_LEFT);
+    const int32_t numNodes = mySurf.getNumberOfNodes();
+    const int64_t NUM_MAPS = 7;
+    vector<int64_t> nodeList;//leave holes in the medial wall style roi
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        if (mySurf.getCoordinate(i)[0] < 60.0f) nodeList.push_back(i);
+    }
+    const int64_t volDims[3] = { 12, 12, 12 };
+    vector<vector<float> > sform(3, vector<float>(4, 0.0f));
+    for (int i = 0; i < 3; ++i)
+    {
+        sform[i][i] = 2.0f;
+        sform[i][3] = -12.0f;
+    }
+    vector<int64_t> ijkList;
+    for (int64_t k = 2; k < 10; ++k)
+    {
+        for (int64_t j = 2; j < 10; ++j)
+        {
+            for (int64_t i = 2; i < 10; ++i)
+            {
+                if ((i - 6) * (i - 6) + (j - 6) * (j - 6) + (k - 6) * (k - 6) > 12) continue;
+                ijkList.push_back(i);
+                ijkList.push_back(j);
+                ijkList.push_back(k);
+            }
+        }
+    }
+    CiftiBrainModelsMap denseMap;
+    denseMap.setVolumeSpace(VolumeSpace(volDims, sform));
+    denseMap.addSurfaceModel(numNodes, StructureEnum::CORTEX_LEFT, nodeList);
+    denseMap.addVolumeModel(StructureEnum::THALAMUS_LEFT, ijkList);
+    const int64_t numBrainordinates = denseMap.getLength();
+    vector<float> denseData(numBrainordinates * NUM_MAPS);//brainordinate-major, like a dtseries
+    for (int64_t b = 0; b < numBrainordinates; ++b)
+    {
+        for (int64_t t = 0; t < NUM_MAPS; ++t)
+        {
+            denseData[b * NUM_MAPS + t] = sin(0.37f * b + 1.3f * t) + 0.1f * ((b * 7 + t * 3) % 11);
+        }
+    }
+    //dtseries layout: smooth along columns, maps are columns
+    CiftiXML colXML;
+    colXML.setNumberOfDimensions(2);
+    colXML.setMap(CiftiXML::ALONG_COLUMN, denseMap);
+    colXML.setMap(CiftiXML::ALONG_ROW, CiftiSeriesMap(NUM_MAPS));
+    CiftiFile colCifti;
+    colCifti.setCiftiXML(colXML);
+    for (int64_t b = 0; b < numBrainordinates; ++b)
+    {
+        colCifti.setRow(denseData.data() + b * NUM_MAPS, b);
+    }
+    {
+        CiftiFile outCifti;
+        AlgorithmCiftiSmoothing(NULL, &colCifti, SURF_KERNEL, VOL_KERNEL, CiftiXML::ALONG_COLUMN, &outCifti, &mySurf);
+        compareToSeparate(this, "in-memory COLUMN", colCifti, outCifti, CiftiXML::ALONG_COLUMN, mySurf);
+    }
+    {//on-disk input takes the block reader path instead of pointing into memory
+        const AString fileName = QDir::tempPath() + "/wb_ciftismoothing_" + AString::number(QCoreApplication::applicationPid()) + ".dtseries.nii";
+        colCifti.writeFile(fileName);
+        CiftiFile diskCifti, outCifti;
+        diskCifti.openFile(fileName);
+        AlgorithmCiftiSmoothing(NULL, &diskCifti, SURF_KERNEL, VOL_KERNEL, CiftiXML::ALONG_COLUMN, &outCifti, &mySurf);
+        compareToSeparate(this, "on-disk COLUMN", colCifti, outCifti, CiftiXML::ALONG_COLUMN, mySurf);
+        QFile::remove(fileName);
+    }
+    //transposed: smooth along rows, maps are rows
+    CiftiXML rowXML;
+    rowXML.setNumberOfDimensions(2);
+    rowXML.setMap(CiftiXML::ALONG_ROW, denseMap);
+    rowXML.setMap(CiftiXML::ALONG_COLUMN, CiftiSeriesMap(NUM_MAPS));
+    CiftiFile rowCifti;
+    rowCifti.setCiftiXML(rowXML);
+    vector<float> rowScratch(numBrainordinates);
+    for (int64_t t = 0; t < NUM_MAPS; ++t)
+    {
+        for (int64_t b = 0; b < numBrainordinates; ++b)
+        {
+            rowScratch[b] = denseData[b * NUM_MAPS + t];
+        }
+        rowCifti.setRow(rowScratch.data(), t);
+    }
+    {
+        CiftiFile outCifti;
+        AlgorithmCiftiSmoothing(NULL, &rowCifti, SURF_KERNEL, VOL_KERNEL, CiftiXML::ALONG_ROW, &outCifti, &mySurf);
+        compareToSeparate(this, "in-memory ROW", rowCifti, outCifti, CiftiXML::ALONG_ROW, mySurf);
+    }
+}
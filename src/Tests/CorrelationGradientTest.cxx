@@ -0,0 +1,143 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "CorrelationGradientTest.h"
+
+#include "AlgorithmCiftiCorrelationGradient.h"
+#include "AlgorithmMetricGradient.h"
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "CiftiFile.h"
+#include "MetricFile.h"
+#include "MetricGradientObject.h"
+#include "SurfaceFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+CorrelationGradientTest::CorrelationGradientTest(const AString& identifier): TestInterface(identifier)
+{
+}
+
+namespace
+{
+    void compareCifti(CorrelationGradientTest* theTest, const AString& condition, const CiftiFile& first, const CiftiFile& second)
+    {
+        if (first.getNumberOfRows() != second.getNumberOfRows() || first.getNumberOfColumns() != second.getNumberOfColumns())
+        {
+            theTest->setFailed(condition + ", outputs have different dimensions");
+            return;
+        }
+        int64_t numRows = first.getNumberOfRows(), numCols = first.getNumberOfColumns();
+        vector<float> firstRow(numCols), secondRow(numCols);
+        float maxVal = 0.0f, maxDiff = 0.0f;
+        for (int64_t i = 0; i < numRows; ++i)
+        {
+            first.getRow(firstRow.data(), i);
+            second.getRow(secondRow.data(), i);
+            for (int64_t j = 0; j < numCols; ++j)
+            {
+                maxVal = max(maxVal, abs(firstRow[j]));
+                float diff = abs(firstRow[j] - secondRow[j]);
+                if (!(diff <= maxDiff)) maxDiff = diff;//catch NaN
+            }
+        }
+        if (!(maxDiff <= 1e-3f * maxVal))//the fused path sums in a different order
+        {
+            theTest->setFailed(condition + ", max difference " + AString::number(maxDiff) + " with max value " + AString::number(maxVal));
+        }
+    }
+}
+
+void CorrelationGradientTest::execute()
+{
+    SurfaceFile mySurf;
+    AlgorithmSurfaceCreateSphere(NULL, 162, &mySurf);
+    mySurf.setStructure(StructureEnum::CORTEX_LEFT);
+    const int32_t numNodes = mySurf.getNumberOfNodes();
+    const int64_t TIMEPOINTS = 20;
+    CiftiBrainModelsMap denseMap;
+    denseMap.addSurfaceModel(numNodes, StructureEnum::CORTEX_LEFT);
+    CiftiXML myXML;
+    myXML.setNumberOfDimensions(2);
+    myXML.setMap(CiftiXML::ALONG_COLUMN, denseMap);
+    myXML.setMap(CiftiXML::ALONG_ROW, CiftiSeriesMap(TIMEPOINTS));
+    CiftiFile myCifti;
+    myCifti.setCiftiXML(myXML);
+    vector<float> scratch(TIMEPOINTS);
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        for (int64_t t = 0; t < TIMEPOINTS; ++t)
+        {
+            scratch[t] = ((float)rand()) / RAND_MAX;
+        }
+        myCifti.setRow(scratch.data(), i);
+    }
+    for (int doubleCorr = 0; doubleCorr < 2 && !failed(); ++doubleCorr)
+    {
+        for (int smooth = 0; smooth < 2 && !failed(); ++smooth)
+        {
+            float surfKern = (smooth ? 10.0f : -1.0f);
+            AString condition = AString("comparing fused to cached gradient, double correlation ") + (doubleCorr ? "on" : "off") + ", smoothing " + (smooth ? "on" : "off");
+            CiftiFile fusedOut, cachedOut;
+            AlgorithmCiftiCorrelationGradient(NULL, &myCifti, &fusedOut, &mySurf, NULL, NULL, NULL, NULL, NULL, surfKern, -1.0f,
+                                              false, false, -1.0f, -1.0f, false, -1.0f, doubleCorr);//no memory limit uses the fused path
+            AlgorithmCiftiCorrelationGradient(NULL, &myCifti, &cachedOut, &mySurf, NULL, NULL, NULL, NULL, NULL, surfKern, -1.0f,
+                                              false, false, -1.0f, -1.0f, false, 0.000001f, doubleCorr);//a tiny memory limit forces the cached path through AlgorithmMetricGradient
+            compareCifti(this, condition, fusedOut, cachedOut);
+        }
+    }
+    if (failed()) return;
+    MetricFile myMetric, myRoi, myAreas, gradOut;
+    myMetric.setNumberOfNodesAndColumns(numNodes, 1);
+    myMetric.setStructure(StructureEnum::CORTEX_LEFT);
+    myRoi.setNumberOfNodesAndColumns(numNodes, 1);
+    myRoi.setStructure(StructureEnum::CORTEX_LEFT);
+    myAreas.setNumberOfNodesAndColumns(numNodes, 1);
+    myAreas.setStructure(StructureEnum::CORTEX_LEFT);
+    vector<float> values(numNodes), roiValues(numNodes), areaValues;
+    mySurf.computeNodeAreas(areaValues);
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        values[i] = ((float)rand()) / RAND_MAX;
+        roiValues[i] = (rand() % 8 != 0 ? 1.0f : 0.0f);//holes in the roi exercise the fallback method
+        areaValues[i] *= 0.5f + ((float)rand()) / RAND_MAX;
+    }
+    myMetric.setValuesForColumn(0, values.data());
+    myRoi.setValuesForColumn(0, roiValues.data());
+    myAreas.setValuesForColumn(0, areaValues.data());
+    AlgorithmMetricGradient(NULL, &mySurf, &myMetric, &gradOut, NULL, -1.0f, &myRoi, false, -1, &myAreas);
+    MetricGradientObject myGradObj(&mySurf, roiValues.data(), areaValues.data());
+    vector<float> objOut(numNodes);
+    myGradObj.gradientMagnitude(values.data(), objOut.data());
+    const float* algOut = gradOut.getValuePointerForColumn(0);
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        if (!(abs(algOut[i] - objOut[i]) <= 1e-4f * max(1.0f, abs(algOut[i]))))
+        {
+            setFailed("MetricGradientObject differs from AlgorithmMetricGradient at vertex " + AString::number(i) +
+                      ": " + AString::number(objOut[i]) + " vs " + AString::number(algOut[i]));
+            return;
+        }
+    }
+}
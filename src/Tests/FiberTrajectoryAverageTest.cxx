@@ -0,0 +1,144 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "FiberTrajectoryAverageTest.h"
+
+#include "CaretPointer.h"
+#include "CaretSparseFile.h"
+#include "FiberOrientation.h"
+#include "FiberOrientationTrajectory.h"
+#include "FiberTrajectoryRowCache.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+FiberTrajectoryAverageTest::FiberTrajectoryAverageTest(const AString& identifier): TestInterface(identifier)
+{
+}
+
+namespace
+{
+    bool sameTrajectory(const FiberOrientationTrajectory& first, const FiberOrientationTrajectory& second)
+    {
+        const float TOLERANCE = 1e-5f;
+        if (!(abs(first.getFiberFractionTotalCount() - second.getFiberFractionTotalCount()) <= TOLERANCE * abs(first.getFiberFractionTotalCount()))) return false;
+        if (!(abs(first.getFiberFractionDistance() - second.getFiberFractionDistance()) <= TOLERANCE * abs(first.getFiberFractionDistance()))) return false;
+        const vector<float>& firstFractions = first.getFiberFractions(), & secondFractions = second.getFiberFractions();
+        if (firstFractions.size() != secondFractions.size()) return false;
+        for (size_t i = 0; i < firstFractions.size(); ++i)
+        {
+            if (!(abs(firstFractions[i] - secondFractions[i]) <= TOLERANCE)) return false;
+        }
+        return true;
+    }
+}
+
+void FiberTrajectoryAverageTest::execute()
+{
+    const int64_t NUM_COLUMNS = 40;
+    const int NUM_ROWS = 7;
+    vector<float> orientationData(FiberOrientation::NUMBER_OF_ELEMENTS_IN_FILE, 0.0f);
+    FiberOrientation myOrientation(0, orientationData.data());//trajectories only keep the pointer
+    vector<CaretPointer<DecodedFiberRow> > rows(NUM_ROWS);
+    vector<int64_t> rowIndices(NUM_ROWS);
+    for (int row = 0; row < NUM_ROWS; ++row)
+    {//sparse rows in the same encoding as the trajectory file, some entries with zero total count
+        rowIndices[row] = (row == NUM_ROWS - 1 ? 2 : row);//a repeated row, as from overlapping selections
+        rows[row].grabNew(new DecodedFiberRow());
+        vector<uint64_t> coded;
+        for (int64_t col = row % 3; col < NUM_COLUMNS; col += 1 + (col + row) % 3)
+        {
+            uint64_t totalCount = ((col * 7 + row * 13) % 9 == 0 ? 0 : 1 + (col * 31 + row * 17) % 500);
+            uint64_t fraction0 = (col * 37 + row * 11) % 600, fraction1 = (col * 13 + row * 29) % (1001 - fraction0), distance = (col * 5 + row * 3) % 1000;
+            coded.push_back((totalCount << 32) | (fraction0 << 20) | (fraction1 << 10) | distance);
+            rows[row]->m_indices.push_back(col);
+        }
+        int64_t numEntries = (int64_t)coded.size();
+        rows[row]->m_totalCount.resize(numEntries);
+        for (int i = 0; i < 3; ++i)
+        {
+            rows[row]->m_fractions[i].resize(numEntries);
+        }
+        rows[row]->m_distance.resize(numEntries);
+        CaretSparseFile::decodeFibersBlock(coded.data(), numEntries, rows[row]->m_totalCount.data(),
+                                           rows[row]->m_fractions[0].data(), rows[row]->m_fractions[1].data(), rows[row]->m_fractions[2].data(), rows[row]->m_distance.data());
+    }
+    //single row loading: decoded arrays must give the same trajectory as a FiberFractions
+    int numBadSingle = 0;
+    for (int64_t entry = 0; entry < rows[0]->getNumberOfEntries(); ++entry)
+    {
+        const DecodedFiberRow& myRow = *(rows[0]);
+        FiberFractions myFractions;
+        myFractions.totalCount = myRow.m_totalCount[entry];
+        myFractions.fiberFractions.resize(3);
+        float fractionArray[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            myFractions.fiberFractions[i] = fractionArray[i] = myRow.m_fractions[i][entry];
+        }
+        myFractions.distance = myRow.m_distance[entry];
+        FiberOrientationTrajectory fromStruct(myRow.m_indices[entry], &myOrientation), fromArrays(myRow.m_indices[entry], &myOrientation);
+        fromStruct.setFiberFractions(myFractions);
+        fromArrays.setFiberFractions(myRow.m_totalCount[entry], fractionArray, myRow.m_distance[entry]);
+        if (!sameTrajectory(fromStruct, fromArrays)) ++numBadSingle;
+    }
+    if (numBadSingle != 0) setFailed(AString::number(numBadSingle) + " single row trajectories differed between decoded arrays and FiberFractions");
+    //averaging: reference adds every row's full (dense) fractions to each trajectory, zero where the sparse row has no entry
+    FiberTrajectoryRowAverager myAverager;
+    myAverager.reset(NUM_COLUMNS);
+    for (int row = 0; row < NUM_ROWS; ++row)
+    {
+        myAverager.addRow(rowIndices[row], *(rows[row]));
+    }
+    if ((int)myAverager.getRows().size() != NUM_ROWS) setFailed("averager did not keep repeated rows");
+    int numBadAverage = 0;
+    double totalCountSum, distanceSum;
+    vector<double> fiberCountSum;
+    for (int64_t col = 0; col < NUM_COLUMNS; ++col)
+    {
+        FiberOrientationTrajectory reference(col, &myOrientation), fromSums(col, &myOrientation);
+        for (int row = 0; row < NUM_ROWS; ++row)
+        {
+            const DecodedFiberRow& myRow = *(rows[row]);
+            FiberFractions myFractions;
+            myFractions.zero();
+            for (int64_t entry = 0; entry < myRow.getNumberOfEntries(); ++entry)
+            {
+                if (myRow.m_indices[entry] != col) continue;
+                myFractions.totalCount = myRow.m_totalCount[entry];
+                myFractions.fiberFractions.resize(3);
+                for (int i = 0; i < 3; ++i)
+                {
+                    myFractions.fiberFractions[i] = myRow.m_fractions[i][entry];
+                }
+                myFractions.distance = myRow.m_distance[entry];
+            }
+            reference.addFiberFractionsForAveraging(myFractions);
+        }
+        reference.finishAveraging();
+        myAverager.getSums(col, totalCountSum, fiberCountSum, distanceSum);
+        fromSums.setSumsForAveraging(totalCountSum, fiberCountSum, distanceSum, NUM_ROWS);
+        fromSums.finishAveraging();
+        if (!sameTrajectory(reference, fromSums)) ++numBadAverage;
+    }
+    if (numBadAverage != 0) setFailed(AString::number(numBadAverage) + " of " + AString::number(NUM_COLUMNS) + " averaged columns differed from FiberOrientationTrajectory averaging");
+}
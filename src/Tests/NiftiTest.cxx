@@ -23,6 +23,13 @@
 #include "MultiDimIterator.h"
 #include "NiftiIO.h"
 
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <vector>
 
 using namespace std;
@@ -159,3 +166,78 @@ void NiftiHeaderTest::writeNifti2Header(AString filename, NiftiHeader &header)
     myFile.open(filename, CaretBinaryFile::WRITE_TRUNCATE);
     header.write(myFile, 2);
 }
+
+//scaled 8 and 16 bit round trips, as written by -cifti-correlation -quantize
+
+NiftiScalingTest::NiftiScalingTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void NiftiScalingTest::execute()
+{
+    const int16_t types[2] = { NIFTI_TYPE_INT8, NIFTI_TYPE_INT16 };
+    const AString typeNames[2] = { "INT8", "INT16" };
+    const float RANGE = 1.0f;
+    vector<int64_t> dims(4);
+    dims[0] = 7; dims[1] = 5; dims[2] = 3; dims[3] = 2;//odd sizes, so vectorized loops have remainders
+    const int64_t frameLength = dims[0] * dims[1] * dims[2];
+    vector<vector<float> > frames(dims[3], vector<float>(frameLength));
+    for (int64_t f = 0; f < dims[3]; ++f)
+    {
+        for (int64_t i = 0; i < frameLength; ++i)
+        {//extend past the range, to check clamping
+            frames[f][i] = -1.2f * RANGE + 2.4f * RANGE * i / (frameLength - 1) + 0.001f * f;
+        }
+    }
+    frames[0][10] = numeric_limits<float>::quiet_NaN();
+    const AString fileName = QDir::tempPath() + "/wb_niftiscaling_" + AString::number(QCoreApplication::applicationPid()) + ".nii";
+    vector<float> readFrame(frameLength);
+    for (int type = 0; type < 2; ++type)
+    {
+        for (int swap = 0; swap < 2; ++swap)
+        {
+            const AString condition = typeNames[type] + (swap ? " byteswapped" : "");
+            NiftiHeader header;
+            header.setDimensions(dims);
+            header.setDataTypeAndScaleRange(types[type], -RANGE, RANGE);
+            NiftiIO writer;
+            writer.writeNew(fileName, header, 1, false, swap != 0);
+            for (int64_t f = 0; f < dims[3]; ++f)
+            {
+                writer.writeData(frames[f].data(), 3, vector<int64_t>(1, f));
+            }
+            writer.close();
+            NiftiIO reader;
+            reader.openRead(fileName);
+            double mult, offset;
+            if (reader.getHeader().getDataType() != types[type] || !reader.getHeader().getDataScaling(mult, offset))
+            {
+                setFailed(condition + ": datatype or scaling was not written");
+                continue;
+            }
+            float maxError = 0.0f;
+            for (int64_t f = 0; f < dims[3]; ++f)
+            {
+                reader.readData(readFrame.data(), 3, vector<int64_t>(1, f));
+                for (int64_t i = 0; i < frameLength; ++i)
+                {
+                    float expected;
+                    if (frames[f][i] != frames[f][i])
+                    {//NaN is stored as the integer 0, which reads as the offset
+                        expected = (float)offset;
+                    } else {
+                        expected = min(RANGE, max(-RANGE, frames[f][i]));
+                    }
+                    float error = abs(readFrame[i] - expected);
+                    if (!(error <= maxError)) maxError = error;//catch NaN
+                }
+            }
+            reader.close();
+            if (!(maxError <= 0.5 * mult + 1e-6))
+            {
+                setFailed(condition + ": max round trip error " + AString::number(maxError) + ", quantization step " + AString::number(mult));
+            }
+        }
+    }
+    QFile::remove(fileName);
+}
@@ -44,6 +44,13 @@ public:
     void writeNifti2Header(AString filename, NiftiHeader &header);
 };
 
+class NiftiScalingTest : public TestInterface
+{
+public:
+    NiftiScalingTest(const AString& identifier);
+    virtual void execute();
+};
+
 
 }
 
@@ -0,0 +1,210 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2021  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "SignedDistanceTest.h"
+
+#include "AlgorithmCreateSignedDistanceVolume.h"
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "SignedDistanceHelper.h"
+#include "SurfaceFile.h"
+#include "Vector3D.h"
+#include "VolumeFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+SignedDistanceTest::SignedDistanceTest(const AString& identifier): TestInterface(identifier)
+{
+}
+
+namespace
+{
+    //closest point on a triangle, by regions of the triangle (Ericson, Real-Time Collision Detection), in double so it can be the reference
+    void closestPointOnTri(const double p[3], const double a[3], const double b[3], const double c[3], double out[3])
+    {
+        double ab[3], ac[3], ap[3], bp[3], cp[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            ab[i] = b[i] - a[i];
+            ac[i] = c[i] - a[i];
+            ap[i] = p[i] - a[i];
+            bp[i] = p[i] - b[i];
+            cp[i] = p[i] - c[i];
+        }
+        double d1 = ab[0] * ap[0] + ab[1] * ap[1] + ab[2] * ap[2], d2 = ac[0] * ap[0] + ac[1] * ap[1] + ac[2] * ap[2];
+        double d3 = ab[0] * bp[0] + ab[1] * bp[1] + ab[2] * bp[2], d4 = ac[0] * bp[0] + ac[1] * bp[1] + ac[2] * bp[2];
+        double d5 = ab[0] * cp[0] + ab[1] * cp[1] + ab[2] * cp[2], d6 = ac[0] * cp[0] + ac[1] * cp[1] + ac[2] * cp[2];
+        double v = 0.0, w = 0.0;
+        if (d1 <= 0.0 && d2 <= 0.0)
+        {
+        } else if (d3 >= 0.0 && d4 <= d3) {
+            v = 1.0;
+        } else if (d6 >= 0.0 && d5 <= d6) {
+            w = 1.0;
+        } else {
+            double vc = d1 * d4 - d3 * d2, vb = d5 * d2 - d1 * d6, va = d3 * d6 - d5 * d4;
+            if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+            {
+                v = d1 / (d1 - d3);
+            } else if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) {
+                w = d2 / (d2 - d6);
+            } else if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0) {
+                w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+                v = 1.0 - w;
+            } else {
+                double denom = 1.0 / (va + vb + vc);
+                v = vb * denom;
+                w = vc * denom;
+            }
+        }
+        for (int i = 0; i < 3; ++i)
+        {
+            out[i] = a[i] + v * ab[i] + w * ac[i];
+        }
+    }
+
+    //brute force closest point over all triangles
+    double bruteClosest(const SurfaceFile& mySurf, const float coord[3], double pointOut[3])
+    {
+        double p[3] = { coord[0], coord[1], coord[2] }, best = -1.0;
+        int32_t numTris = mySurf.getNumberOfTriangles();
+        for (int32_t t = 0; t < numTris; ++t)
+        {
+            const int32_t* tri = mySurf.getTriangle(t);
+            double verts[3][3], closest[3];
+            for (int v = 0; v < 3; ++v)
+            {
+                const float* vertCoord = mySurf.getCoordinate(tri[v]);
+                for (int i = 0; i < 3; ++i) verts[v][i] = vertCoord[i];
+            }
+            closestPointOnTri(p, verts[0], verts[1], verts[2], closest);
+            double dist = sqrt((p[0] - closest[0]) * (p[0] - closest[0]) + (p[1] - closest[1]) * (p[1] - closest[1]) + (p[2] - closest[2]) * (p[2] - closest[2]));
+            if (best < 0.0 || dist < best)
+            {
+                best = dist;
+                for (int i = 0; i < 3; ++i) pointOut[i] = closest[i];
+            }
+        }
+        return best;
+    }
+}
+
+void SignedDistanceTest::execute()
+{
+    SurfaceFile mySurf;
+    AlgorithmSurfaceCreateSphere(NULL, 642, &mySurf);//radius 100
+    const float RADIUS = 100.0f;
+    CaretPointer<SignedDistanceHelper> myHelp = mySurf.getSignedDistanceHelper();
+    const int NUM_POINTS = 300;
+    const float TOLERANCE = 1e-3f;
+    int numBadDist = 0, numBadSign = 0, numBadBary = 0, numBadLimit = 0;
+    for (int i = 0; i < NUM_POINTS; ++i)
+    {//deterministic spread of directions, with radii inside, near and outside the surface
+        float theta = 2.399963f * i, z = 1.0f - 2.0f * (i + 0.5f) / NUM_POINTS;
+        float radius;
+        switch (i % 3)
+        {
+            case 0:
+                radius = 20.0f + 0.25f * (i % 300);
+                break;
+            case 1:
+                radius = RADIUS + 0.01f * ((i % 101) - 50);
+                break;
+            default:
+                radius = 110.0f + 0.3f * (i % 200);
+                break;
+        }
+        float xy = sqrt(1.0f - z * z);
+        float coord[3] = { radius * xy * cos(theta), radius * xy * sin(theta), radius * z };
+        double brutePoint[3];
+        double bruteDist = bruteClosest(mySurf, coord, brutePoint);
+        float signedDist = myHelp->dist(coord, SignedDistanceHelper::EVEN_ODD);
+        if (!(abs(abs(signedDist) - bruteDist) <= TOLERANCE)) ++numBadDist;
+        if (abs(radius - RADIUS) > 1.0f)
+        {//faces of the tessellated sphere are within 1mm of the radius
+            if ((signedDist < 0.0f) != (radius < RADIUS)) ++numBadSign;
+            if (myHelp->dist(coord, SignedDistanceHelper::NORMALS) * signedDist < 0.0f) ++numBadSign;
+        }
+        BarycentricInfo baryInfo;
+        myHelp->barycentricWeights(coord, baryInfo);
+        Vector3D reconstructed;
+        float weightSum = 0.0f;
+        for (int v = 0; v < 3; ++v)
+        {
+            if (baryInfo.baryWeights[v] < 0.0f) ++numBadBary;
+            weightSum += baryInfo.baryWeights[v];
+            reconstructed += baryInfo.baryWeights[v] * Vector3D(mySurf.getCoordinate(baryInfo.nodes[v]));
+        }
+        Vector3D bruteVec(brutePoint[0], brutePoint[1], brutePoint[2]);
+        if (!(abs(weightSum - 1.0f) <= 1e-5f) || !((reconstructed - bruteVec).length() <= TOLERANCE) || !(abs(baryInfo.absDistance - bruteDist) <= TOLERANCE)) ++numBadBary;
+        bool valid = true;
+        myHelp->distLimited(coord, 0.9f * bruteDist - TOLERANCE, valid, SignedDistanceHelper::EVEN_ODD);
+        if (valid && bruteDist > 0.01) ++numBadLimit;
+        float limited = myHelp->distLimited(coord, 1.1f * bruteDist + TOLERANCE, valid, SignedDistanceHelper::EVEN_ODD);
+        if (!valid || !(abs(limited - signedDist) <= TOLERANCE)) ++numBadLimit;
+    }
+    if (numBadDist != 0) setFailed(AString::number(numBadDist) + " points had bvh distance different from brute force");
+    if (numBadSign != 0) setFailed(AString::number(numBadSign) + " sign tests failed");
+    if (numBadBary != 0) setFailed(AString::number(numBadBary) + " barycentric results differed from brute force");
+    if (numBadLimit != 0) setFailed(AString::number(numBadLimit) + " limited distance tests failed");
+    //approximate regions: fast sweeping should agree with dijkstra, and both with the true distance to the sphere
+    const int64_t VOL_DIM = 64;
+    const float SPACING = 4.0f, EXACT_LIM = 5.0f, APPROX_LIM = 40.0f;
+    vector<int64_t> dims(3, VOL_DIM);
+    vector<vector<float> > sform(3, vector<float>(4, 0.0f));
+    for (int i = 0; i < 3; ++i)
+    {
+        sform[i][i] = SPACING;
+        sform[i][3] = -SPACING * (VOL_DIM / 2) + 1.0f;//don't line voxels up with the center
+    }
+    VolumeFile dijkstraVol, dijkstraRoi, sweepVol, sweepRoi;
+    dijkstraVol.reinitialize(dims, sform);
+    sweepVol.reinitialize(dims, sform);
+    AlgorithmCreateSignedDistanceVolume(NULL, &mySurf, &dijkstraVol, &dijkstraRoi, 0.0f, EXACT_LIM, APPROX_LIM, 2, SignedDistanceHelper::EVEN_ODD, AlgorithmCreateSignedDistanceVolume::DIJKSTRA);
+    AlgorithmCreateSignedDistanceVolume(NULL, &mySurf, &sweepVol, &sweepRoi, 0.0f, EXACT_LIM, APPROX_LIM, 2, SignedDistanceHelper::EVEN_ODD, AlgorithmCreateSignedDistanceVolume::FAST_SWEEP);
+    int64_t numCompared = 0, numBadSweep = 0, numBadTrue = 0;
+    float maxSweepDiff = 0.0f;
+    for (int64_t k = 0; k < VOL_DIM; ++k)
+    {
+        for (int64_t j = 0; j < VOL_DIM; ++j)
+        {
+            for (int64_t i = 0; i < VOL_DIM; ++i)
+            {
+                if (dijkstraRoi.getValue(i, j, k) == 0.0f || sweepRoi.getValue(i, j, k) == 0.0f) continue;
+                ++numCompared;
+                float dijkstraVal = dijkstraVol.getValue(i, j, k), sweepVal = sweepVol.getValue(i, j, k);
+                float diff = abs(sweepVal - dijkstraVal);
+                if (!(diff <= maxSweepDiff)) maxSweepDiff = diff;
+                if (!(diff <= 0.1f * abs(dijkstraVal) + SPACING)) ++numBadSweep;//both overestimate away from the exact region, but differently
+                const int64_t ijk[3] = { i, j, k };
+                float voxCoord[3];
+                sweepVol.indexToSpace(ijk, voxCoord);
+                float trueDist = Vector3D(voxCoord).length() - RADIUS;
+                if (!(abs(sweepVal - trueDist) <= 0.1f * abs(trueDist) + SPACING)) ++numBadTrue;
+            }
+        }
+    }
+    if (numCompared == 0) setFailed("no voxels had values from both DIJKSTRA and FAST_SWEEP");
+    if (numBadSweep != 0) setFailed(AString::number(numBadSweep) + " of " + AString::number(numCompared) + " voxels differed between FAST_SWEEP and DIJKSTRA, max difference " + AString::number(maxSweepDiff));
+    if (numBadTrue != 0) setFailed(AString::number(numBadTrue) + " of " + AString::number(numCompared) + " FAST_SWEEP voxels were far from the true distance");
+}
@@ -33,8 +33,15 @@
 #include "CaretException.h"
 
 //tests
+#include "AverageDenseCorrelationTest.h"
+#include "BenchmarkTest.h"
 #include "CiftiFileTest.h"
+#include "CiftiIndexArrayTest.h"
+#include "CiftiRowPipelineTest.h"
+#include "CiftiSmoothingTest.h"
+#include "CorrelationGradientTest.h"
 #include "DotTest.h"
+#include "FiberTrajectoryAverageTest.h"
 #include "GeodesicHelperTest.h"
 #include "HttpTest.h"
 #include "HeapTest.h"
@@ -44,6 +51,7 @@
 #include "PointerTest.h"
 #include "ProgressTest.h"
 #include "QuatTest.h"
+#include "SignedDistanceTest.h"
 #include "StatisticsTest.h"
 #include "TimerTest.h"
 #include "TopologyHelperTest.h"
@@ -69,8 +77,15 @@ int main(int argc, char** argv)
         caret_global_commandLine_init(argc, argv);
         SessionManager::createSessionManager(ApplicationTypeEnum::APPLICATION_TYPE_COMMAND_LINE);
         vector<TestInterface*> mytests;
+        mytests.push_back(new AverageDenseCorrelationTest("avgdensecorr"));
+        mytests.push_back(new BenchmarkTest("benchmark"));
         mytests.push_back(new CiftiFileTest("ciftifile"));
+        mytests.push_back(new CiftiIndexArrayTest("ciftiindexarray"));
+        mytests.push_back(new CiftiRowPipelineTest("ciftirowpipeline"));
+        mytests.push_back(new CiftiSmoothingTest("ciftismoothing"));
+        mytests.push_back(new CorrelationGradientTest("corrgradient"));
         mytests.push_back(new DotTest("dotsimd"));
+        mytests.push_back(new FiberTrajectoryAverageTest("fiberaverage"));
         mytests.push_back(new GeodesicHelperTest("geohelp"));
         mytests.push_back(new HeapTest("heap"));
         mytests.push_back(new HttpTest("http"));
@@ -78,9 +93,11 @@ int main(int argc, char** argv)
         mytests.push_back(new MathExpressionTest("mathexpression"));
         mytests.push_back(new NiftiFileTest("niftifile"));
         mytests.push_back(new NiftiHeaderTest("niftiheader"));
+        mytests.push_back(new NiftiScalingTest("niftiscaling"));
         mytests.push_back(new PointerTest("pointer"));
         mytests.push_back(new ProgressTest("progress"));
         mytests.push_back(new QuatTest("quaternion"));
+        mytests.push_back(new SignedDistanceTest("signeddistance"));
         mytests.push_back(new StatisticsTest("statistics"));
         mytests.push_back(new TimerTest("timer"));
         mytests.push_back(new TopologyHelperTest("topohelp"));
@@ -101,7 +118,8 @@ int main(int argc, char** argv)
         {
             for (int j = 0; j < (int)mytests.size(); ++j)
             {
-                if (mytests[j]->getIdentifier() == AString(argv[i]) || "all" == AString(argv[i]))
+                if (mytests[j]->getIdentifier() == AString(argv[i]) ||
+                    ("all" == AString(argv[i]) && mytests[j]->getIdentifier() != "benchmark"))//benchmark takes minutes and prints JSON, only run it when named
                 {
                     try
                     {